@@ -33,6 +33,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 
 #include <rdma/fi_errno.h>
 
@@ -53,6 +55,203 @@ static int inject_size_set;
  */
 static int offset_rma_start = 0;
 
+/* Per iteration latency samples, in ns, of the measured iterations */
+static uint64_t *lat_samples;
+static size_t lat_max;
+static uint64_t lat_last;
+static FILE *lat_hist_file;
+static int lat_hist_json;
+
+/* Histogram buckets keep LAT_HIST_BITS significant bits of each sample */
+#define LAT_HIST_BITS 5
+
+static int ft_lat_init(void)
+{
+	uint64_t *samples;
+
+	if (!opts.lat_stats || lat_max >= (size_t) opts.iterations)
+		return 0;
+
+	samples = realloc(lat_samples, sizeof(*lat_samples) * opts.iterations);
+	if (!samples)
+		return -FI_ENOMEM;
+
+	lat_samples = samples;
+	lat_max = opts.iterations;
+	return 0;
+}
+
+static inline void ft_lat_start(void)
+{
+	ft_start();
+	lat_last = ft_gettime_ns();
+}
+
+static inline void ft_lat_sample(int i)
+{
+	uint64_t now;
+
+	if (!opts.lat_stats || i < opts.warmup_iterations)
+		return;
+
+	now = ft_gettime_ns();
+	lat_samples[i - opts.warmup_iterations] = now - lat_last;
+	lat_last = now;
+}
+
+static int ft_lat_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static double ft_lat_usec(uint64_t ns, int xfers_per_iter)
+{
+	return ns / 1000.0 / xfers_per_iter;
+}
+
+/* Nearest-rank percentile of the sorted samples */
+static uint64_t ft_lat_pct(size_t cnt, double pct)
+{
+	double pos = pct * cnt / 100.0;
+	size_t rank = (size_t) pos;
+
+	if (rank < pos)
+		rank++;
+
+	return lat_samples[rank ? MIN(rank, cnt) - 1 : 0];
+}
+
+/* Upper bound of the log-linear histogram bucket holding ns */
+static uint64_t ft_lat_bucket(uint64_t ns)
+{
+	int shift = 0;
+
+	while ((ns >> shift) >= (1ULL << LAT_HIST_BITS))
+		shift++;
+
+	return (((ns >> shift) + 1) << shift) - 1;
+}
+
+static void ft_lat_hist_close(void)
+{
+	if (!lat_hist_file)
+		return;
+
+	if (lat_hist_json)
+		fprintf(lat_hist_file, "\n}\n");
+	fclose(lat_hist_file);
+	lat_hist_file = NULL;
+}
+
+static int ft_lat_hist_open(void)
+{
+	size_t len;
+	int ret;
+
+	if (lat_hist_file)
+		return 0;
+
+	lat_hist_file = fopen(opts.lat_hist, "w");
+	if (!lat_hist_file) {
+		ret = -errno;
+		FT_PRINTERR("fopen", ret);
+		return ret;
+	}
+
+	len = strlen(opts.lat_hist);
+	lat_hist_json = len > 5 && !strcmp(opts.lat_hist + len - 5, ".json");
+	if (lat_hist_json)
+		fprintf(lat_hist_file, "{");
+	else
+		fprintf(lat_hist_file, "bytes,usec,count,percentile\n");
+
+	atexit(ft_lat_hist_close);
+	return 0;
+}
+
+/* Write one row per non-empty bucket: upper bound, count, cumulative % */
+static int ft_lat_hist_write(size_t cnt, int xfers_per_iter)
+{
+	static int first = 1;
+	uint64_t bucket;
+	size_t i, n;
+	int ret;
+
+	ret = ft_lat_hist_open();
+	if (ret)
+		return ret;
+
+	if (lat_hist_json) {
+		fprintf(lat_hist_file, "%s\n  \"%zu\": {\"bytes\": %zu, "
+			"\"iters\": %zu, \"min\": %.3f, \"p50\": %.3f, "
+			"\"p90\": %.3f, \"p99\": %.3f, \"p99.9\": %.3f, "
+			"\"max\": %.3f, \"histogram\": [", first ? "" : ",",
+			opts.transfer_size, opts.transfer_size, cnt,
+			ft_lat_usec(lat_samples[0], xfers_per_iter),
+			ft_lat_usec(ft_lat_pct(cnt, 50), xfers_per_iter),
+			ft_lat_usec(ft_lat_pct(cnt, 90), xfers_per_iter),
+			ft_lat_usec(ft_lat_pct(cnt, 99), xfers_per_iter),
+			ft_lat_usec(ft_lat_pct(cnt, 99.9), xfers_per_iter),
+			ft_lat_usec(lat_samples[cnt - 1], xfers_per_iter));
+	}
+	first = 0;
+
+	for (i = 0; i < cnt; i += n) {
+		bucket = ft_lat_bucket(lat_samples[i]);
+		for (n = 1; i + n < cnt && lat_samples[i + n] <= bucket; n++)
+			;
+
+		if (lat_hist_json)
+			fprintf(lat_hist_file, "%s\n    {\"usec\": %.3f, "
+				"\"count\": %zu, \"percentile\": %.4f}",
+				i ? "," : "",
+				ft_lat_usec(bucket, xfers_per_iter), n,
+				100.0 * (i + n) / cnt);
+		else
+			fprintf(lat_hist_file, "%zu,%.3f,%zu,%.4f\n",
+				opts.transfer_size,
+				ft_lat_usec(bucket, xfers_per_iter), n,
+				100.0 * (i + n) / cnt);
+	}
+
+	if (lat_hist_json)
+		fprintf(lat_hist_file, "]}");
+	fflush(lat_hist_file);
+	return 0;
+}
+
+/* Report the per transfer latency distribution of the measured iterations */
+static int ft_show_lat(int xfers_per_iter)
+{
+	static int header = 1;
+	char str[FT_STR_LEN];
+	size_t cnt = opts.iterations;
+
+	if (!opts.lat_stats || !cnt)
+		return 0;
+
+	qsort(lat_samples, cnt, sizeof(*lat_samples), ft_lat_cmp);
+
+	if (header) {
+		printf("%-8s%10s%10s%10s%10s%10s%10s\n", "bytes", "min(us)",
+		       "p50", "p90", "p99", "p99.9", "max");
+		header = 0;
+	}
+
+	printf("%-8s%10.2f%10.2f%10.2f%10.2f%10.2f%10.2f\n",
+	       size_str(str, opts.transfer_size),
+	       ft_lat_usec(lat_samples[0], xfers_per_iter),
+	       ft_lat_usec(ft_lat_pct(cnt, 50), xfers_per_iter),
+	       ft_lat_usec(ft_lat_pct(cnt, 90), xfers_per_iter),
+	       ft_lat_usec(ft_lat_pct(cnt, 99), xfers_per_iter),
+	       ft_lat_usec(ft_lat_pct(cnt, 99.9), xfers_per_iter),
+	       ft_lat_usec(lat_samples[cnt - 1], xfers_per_iter));
+
+	return opts.lat_hist ? ft_lat_hist_write(cnt, xfers_per_iter) : 0;
+}
+
 void ft_parse_benchmark_opts(int op, char *optarg)
 {
 	switch (op) {
@@ -101,7 +300,7 @@ static int pingpong_pre_posted_rx(size_t inject_size)
 	if (opts.dst_addr) {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				ft_lat_start();
 
 			if (opts.transfer_size <= inject_size)
 				ret = ft_inject(ep, remote_fi_addr,
@@ -115,11 +314,13 @@ static int pingpong_pre_posted_rx(size_t inject_size)
 			ret = ft_rx(ep, opts.transfer_size);
 			if (ret)
 				return ret;
+
+			ft_lat_sample(i);
 		}
 	} else {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				ft_lat_start();
 
 			ret = ft_rx(ep, opts.transfer_size);
 			if (ret)
@@ -133,6 +334,8 @@ static int pingpong_pre_posted_rx(size_t inject_size)
 					    opts.transfer_size, &tx_ctx);
 			if (ret)
 				return ret;
+
+			ft_lat_sample(i);
 		}
 	}
 	ft_stop();
@@ -148,7 +351,7 @@ static int pingpong_no_pre_posted_rx(size_t inject_size)
 	if (opts.dst_addr) {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				ft_lat_start();
 
 			if (opts.transfer_size <= inject_size)
 				ret = ft_inject(ep, remote_fi_addr,
@@ -166,11 +369,13 @@ static int pingpong_no_pre_posted_rx(size_t inject_size)
 			ret = ft_get_rx_comp(rx_seq);
 			if (ret)
 				return ret;
+
+			ft_lat_sample(i);
 		}
 	} else {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				ft_lat_start();
 
 			ret = ft_post_rx(ep, opts.transfer_size, &rx_ctx);
 			if (ret)
@@ -195,6 +400,8 @@ static int pingpong_no_pre_posted_rx(size_t inject_size)
 					    opts.transfer_size, &tx_ctx);
 			if (ret)
 				return ret;
+
+			ft_lat_sample(i);
 		}
 	}
 	ft_stop();
@@ -220,6 +427,10 @@ int pingpong(void)
 	if (opts.options & FT_OPT_ENABLE_HMEM)
 		inject_size = 0;
 
+	ret = ft_lat_init();
+	if (ret)
+		return ret;
+
 	if (ft_check_opts(FT_OPT_NO_PRE_POSTED_RX)) {
 		if (ft_check_opts(FT_OPT_OOB_SYNC)) {
 			ret = ft_sync_oob();
@@ -255,7 +466,7 @@ int pingpong(void)
 	else
 		show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 2);
 
-	return 0;
+	return ft_show_lat(2);
 }
 
 int run_pingpong(void)
@@ -327,6 +538,10 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 	if (rma_op == FT_RMA_WRITE)
 		*(rx_buf + opts.transfer_size - 1) = (char)-1;
 
+	ret = ft_lat_init();
+	if (ret)
+		return ret;
+
 	ret = ft_sync();
 	if (ret)
 		return ret;
@@ -335,7 +550,7 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 
 			if (i == opts.warmup_iterations)
-				ft_start();
+				ft_lat_start();
 
 			if (rma_op == FT_RMA_WRITE)
 				*(tx_buf + opts.transfer_size - 1) = (char)i;
@@ -353,11 +568,13 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 			ret = ft_rx_rma(i, rma_op, ep, opts.transfer_size);
 			if (ret)
 				return ret;
+
+			ft_lat_sample(i);
 		}
 	} else {
 		for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
 			if (i == opts.warmup_iterations)
-				ft_start();
+				ft_lat_start();
 
 			ret = ft_rx_rma(i, rma_op, ep, opts.transfer_size);
 			if (ret)
@@ -375,6 +592,8 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 						opts.transfer_size, &tx_ctx);
 			if (ret)
 				return ret;
+
+			ft_lat_sample(i);
 		}
 	}
 	ft_stop();
@@ -385,7 +604,7 @@ int pingpong_rma(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
 	else
 		show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 2);
 
-	return 0;
+	return ft_show_lat(2);
 }
 
 int rma_tx_completion(enum ft_rma_opcodes rma_op, struct fi_rma_iov *remote)
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under the BSD license
+ * below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Times the first fi_getinfo() call of a process, which includes library
+ * initialization and the provider scan.  Every sample runs in a new child
+ * process, without FI_GETINFO_CACHE_DIR, against an empty cache (cold) and
+ * against the cache left behind by the cold run (warm).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <rdma/fi_errno.h>
+
+#include <shared.h>
+
+struct startup_sample {
+	uint64_t	ns;
+	int		ret;
+	int		cnt;
+};
+
+static int startup_run(const char *cache_dir, struct startup_sample *sample)
+{
+	struct fi_info *info, *cur;
+	uint64_t start;
+	int fd[2], status;
+	pid_t pid;
+
+	if (pipe(fd))
+		return -errno;
+
+	pid = fork();
+	if (pid < 0) {
+		close(fd[0]);
+		close(fd[1]);
+		return -errno;
+	}
+
+	if (!pid) {
+		close(fd[0]);
+		if (cache_dir)
+			setenv("FI_GETINFO_CACHE_DIR", cache_dir, 1);
+		else
+			unsetenv("FI_GETINFO_CACHE_DIR");
+
+		start = ft_gettime_ns();
+		sample->ret = fi_getinfo(FT_FIVERSION, NULL, NULL, 0, hints,
+					 &info);
+		sample->ns = ft_gettime_ns() - start;
+
+		sample->cnt = 0;
+		if (!sample->ret) {
+			for (cur = info; cur; cur = cur->next)
+				sample->cnt++;
+			fi_freeinfo(info);
+		}
+
+		_exit(write(fd[1], sample, sizeof(*sample)) !=
+		      sizeof(*sample));
+	}
+
+	close(fd[1]);
+	if (read(fd[0], sample, sizeof(*sample)) != sizeof(*sample))
+		sample->ret = -FI_EOTHER;
+	close(fd[0]);
+	waitpid(pid, &status, 0);
+	return 0;
+}
+
+static int startup_series(const char *name, const char *cache_dir,
+			  int iters, int *cnt)
+{
+	struct startup_sample sample;
+	uint64_t min = UINT64_MAX, max = 0, sum = 0;
+	int i, ret;
+
+	for (i = 0; i < iters; i++) {
+		ret = startup_run(cache_dir, &sample);
+		if (ret) {
+			FT_PRINTERR("fork", ret);
+			return ret;
+		}
+
+		if (sample.ret) {
+			FT_PRINTERR("fi_getinfo", sample.ret);
+			return sample.ret;
+		}
+
+		if (*cnt < 0) {
+			*cnt = sample.cnt;
+		} else if (sample.cnt != *cnt) {
+			FT_ERR("%s run returned %d fi_info's, expected %d",
+			       name, sample.cnt, *cnt);
+			return -FI_EOTHER;
+		}
+
+		min = MIN(min, sample.ns);
+		max = MAX(max, sample.ns);
+		sum += sample.ns;
+	}
+
+	printf("%-10s %8d %12.1f %12.1f %12.1f %8d\n", name, iters,
+	       min / 1000.0, (double) sum / iters / 1000.0, max / 1000.0,
+	       *cnt);
+	return 0;
+}
+
+static void startup_cleanup(const char *dir)
+{
+	struct dirent *entry;
+	char path[PATH_MAX];
+	DIR *d;
+
+	d = opendir(dir);
+	if (!d)
+		return;
+
+	while ((entry = readdir(d))) {
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+		unlink(path);
+	}
+	closedir(d);
+	rmdir(dir);
+}
+
+static void usage(char *name)
+{
+	fprintf(stderr, "Usage:\n");
+	fprintf(stderr, "  %s [OPTIONS]\n", name);
+	fprintf(stderr, "\nTimes the first fi_getinfo call of a process "
+		"with and without FI_GETINFO_CACHE_DIR.\n");
+	fprintf(stderr, "\nOptions:\n");
+	FT_PRINT_OPTS_USAGE("-f <fabric>", "fabric name");
+	FT_PRINT_OPTS_USAGE("-d <domain>", "domain name");
+	FT_PRINT_OPTS_USAGE("-p <provider>",
+			    "specific provider name eg sockets, verbs");
+	FT_PRINT_OPTS_USAGE("-e <ep_type>", "Endpoint type: msg|rdm|dgram");
+	FT_PRINT_OPTS_USAGE("-n <iterations>",
+			    "processes started per series (default: 10)");
+	FT_PRINT_OPTS_USAGE("-c <dir>",
+			    "cache directory (default: new temporary directory)");
+	FT_PRINT_OPTS_USAGE("-h", "display this help output");
+}
+
+int main(int argc, char **argv)
+{
+	char tmp_dir[] = "/tmp/fi_getinfo_startup.XXXXXX";
+	char *cache_dir = NULL;
+	int op, iters = 10, cnt = -1, ret;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt(argc, argv, FAB_OPTS "e:n:c:h")) != -1) {
+		switch (op) {
+		case 'n':
+			iters = atoi(optarg);
+			break;
+		case 'c':
+			cache_dir = optarg;
+			break;
+		default:
+			ft_parseinfo(op, optarg, hints, &opts);
+			break;
+		case '?':
+		case 'h':
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (iters < 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (!cache_dir) {
+		cache_dir = mkdtemp(tmp_dir);
+		if (!cache_dir) {
+			FT_PRINTERR("mkdtemp", -errno);
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("%-10s %8s %12s %12s %12s %8s\n", "cache", "runs",
+	       "min(us)", "avg(us)", "max(us)", "infos");
+
+	ret = startup_series("none", NULL, iters, &cnt);
+	if (!ret)
+		ret = startup_series("cold", cache_dir, 1, &cnt);
+	if (!ret)
+		ret = startup_series("warm", cache_dir, iters, &cnt);
+
+	if (cache_dir == tmp_dir)
+		startup_cleanup(tmp_dir);
+
+	fi_freeinfo(hints);
+	return ft_exit_code(ret);
+}
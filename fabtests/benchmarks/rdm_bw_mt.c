@@ -76,6 +76,7 @@ static char oob_buffer[BUFFER_SIZE];
 
 static size_t num_eps = 1;
 static bool bidir = false;
+static bool shared_domain = false;
 static ssize_t xfer_size = 1;
 pthread_barrier_t barrier;
 
@@ -124,7 +125,7 @@ static void cleanup_ofi(void)
 				printf("fi_close(av[%d]) failed: %d\n", i, ret);
 		}
 
-		if (targs[i].domain) {
+		if (targs[i].domain && !shared_domain) {
 			ret = fi_close(&targs[i].domain->fid);
 			if (ret)
 				printf("fi_close(domain[%d]) failed: %d\n", i,
@@ -132,6 +133,12 @@ static void cleanup_ofi(void)
 		}
 	}
 
+	if (shared_domain && targs && targs[0].domain) {
+		ret = fi_close(&targs[0].domain->fid);
+		if (ret)
+			printf("fi_close(domain) failed: %d\n", ret);
+	}
+
 	if (fabric) {
 		ret = fi_close(&fabric->fid);
 		if (ret)
@@ -207,10 +214,14 @@ static int init_ofi(void)
 		memset(&av_attr, 0, sizeof(av_attr));
 		memset(&cntr_attr, 0, sizeof(cntr_attr));
 
-		ret = fi_domain(fabric, fi, &targs[i].domain, NULL);
-		if (ret) {
-			printf("fi_domain failed ep[%d]: %d\n", i, ret);
-			return ret;
+		if (shared_domain && i) {
+			targs[i].domain = targs[0].domain;
+		} else {
+			ret = fi_domain(fabric, fi, &targs[i].domain, NULL);
+			if (ret) {
+				printf("fi_domain failed ep[%d]: %d\n", i, ret);
+				return ret;
+			}
 		}
 
 		ret = fi_endpoint(targs[i].domain, fi, &targs[i].ep, NULL);
@@ -607,6 +618,8 @@ static void usage(void)
 	FT_PRINT_OPTS_USAGE("-n <num endpoints>",
 			    "number of endpoints (threads) to use");
 	FT_PRINT_OPTS_USAGE("-U", "enable FI_DELIVERY_COMPLETE");
+	FT_PRINT_OPTS_USAGE("-x", "open all endpoints on a single "
+			    "FI_THREAD_SAFE domain");
 	fprintf(stderr, "Notice to user: Not all fabtests options are supported"
 		" by this test. If something isn't working check if the option"
 		" is supported before reporting a bug.\n");
@@ -623,7 +636,7 @@ int main(int argc, char **argv)
 	if (!hints)
 		return EXIT_FAILURE;
 
-	while ((op = getopt_long(argc, argv, "gn:Uh" CS_OPTS INFO_OPTS API_OPTS
+	while ((op = getopt_long(argc, argv, "gn:Uxh" CS_OPTS INFO_OPTS API_OPTS
 		BENCHMARK_OPTS, long_opts, &lopt_idx)) != -1) {
 		switch (op) {
 		default:
@@ -643,6 +656,9 @@ int main(int argc, char **argv)
 		case 'U':
 			hints->tx_attr->op_flags |= FI_DELIVERY_COMPLETE;
 			break;
+		case 'x':
+			shared_domain = true;
+			break;
 		case '?':
 		case 'h':
 			ft_csusage(argv[0], "Multi-Threaded Bandwidth test for "
@@ -659,7 +675,8 @@ int main(int argc, char **argv)
 
 	hints->ep_attr->type = FI_EP_RDM;
 	hints->domain_attr->resource_mgmt = FI_RM_ENABLED;
-	hints->domain_attr->threading = FI_THREAD_DOMAIN;
+	hints->domain_attr->threading = shared_domain ? FI_THREAD_SAFE :
+							FI_THREAD_DOMAIN;
 	hints->caps = FI_MSG;
 	hints->mode |= FI_CONTEXT | FI_CONTEXT2;
 	hints->domain_attr->mr_mode = opts.mr_mode;
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2026 Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under the BSD license
+ * below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Times how long it takes one RDM endpoint to deliver a first message to
+ * each of N peer endpoints, all opened in this process.  Connections are
+ * either created lazily by the sends, or set up first with
+ * fi_conn_warmup() using a bounded number of concurrent attempts.  Every
+ * series uses new endpoints, so no connection is reused.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <rdma/fi_cm.h>
+#include <rdma/fi_errno.h>
+#include <rdma/fi_ext.h>
+
+#include <shared.h>
+
+#define WARMUP_TIMEOUT_NS (30ULL * 1000000000ULL)
+
+struct warmup_ep {
+	struct fid_ep		*ep;
+	struct fid_cq		*cq;
+	char			buf[64];
+	struct fi_context2	recv_ctx;
+	struct fi_context2	send_ctx;
+};
+
+struct warmup_series {
+	struct fid_av		*av;
+	struct warmup_ep	origin;
+	struct warmup_ep	*peer;
+	fi_addr_t		*addr;
+	int			peer_cnt;
+	int			sends_done;
+	int			recvs_done;
+};
+
+static int warmup_open_ep(struct warmup_series *series, struct warmup_ep *wep,
+			  bool bind_eq)
+{
+	struct fi_cq_attr attr = {
+		.format = FI_CQ_FORMAT_CONTEXT,
+		.wait_obj = FI_WAIT_NONE,
+	};
+	int ret;
+
+	ret = fi_cq_open(domain, &attr, &wep->cq, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_cq_open", ret);
+		return ret;
+	}
+
+	ret = fi_endpoint(domain, fi, &wep->ep, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_endpoint", ret);
+		return ret;
+	}
+
+	ret = fi_ep_bind(wep->ep, &series->av->fid, 0);
+	if (ret) {
+		FT_PRINTERR("fi_ep_bind", ret);
+		return ret;
+	}
+
+	ret = fi_ep_bind(wep->ep, &wep->cq->fid, FI_TRANSMIT | FI_RECV);
+	if (ret) {
+		FT_PRINTERR("fi_ep_bind", ret);
+		return ret;
+	}
+
+	if (bind_eq) {
+		ret = fi_ep_bind(wep->ep, &eq->fid, 0);
+		if (ret) {
+			FT_PRINTERR("fi_ep_bind", ret);
+			return ret;
+		}
+	}
+
+	ret = fi_enable(wep->ep);
+	if (ret)
+		FT_PRINTERR("fi_enable", ret);
+	return ret;
+}
+
+static void warmup_close_ep(struct warmup_ep *wep)
+{
+	FT_CLOSE_FID(wep->ep);
+	FT_CLOSE_FID(wep->cq);
+}
+
+static void warmup_close(struct warmup_series *series)
+{
+	int i;
+
+	if (series->peer) {
+		for (i = 0; i < series->peer_cnt; i++)
+			warmup_close_ep(&series->peer[i]);
+	}
+	warmup_close_ep(&series->origin);
+	FT_CLOSE_FID(series->av);
+	free(series->peer);
+	free(series->addr);
+}
+
+static int warmup_open(struct warmup_series *series, int peer_cnt)
+{
+	struct fi_av_attr attr = {
+		.type = FI_AV_TABLE,
+		.count = peer_cnt,
+	};
+	char name[256];
+	size_t len;
+	int i, ret;
+
+	memset(series, 0, sizeof(*series));
+	series->peer_cnt = peer_cnt;
+	series->peer = calloc(peer_cnt, sizeof(*series->peer));
+	series->addr = calloc(peer_cnt, sizeof(*series->addr));
+	if (!series->peer || !series->addr)
+		return -FI_ENOMEM;
+
+	ret = fi_av_open(domain, &attr, &series->av, NULL);
+	if (ret) {
+		FT_PRINTERR("fi_av_open", ret);
+		return ret;
+	}
+
+	ret = warmup_open_ep(series, &series->origin, true);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < peer_cnt; i++) {
+		ret = warmup_open_ep(series, &series->peer[i], false);
+		if (ret)
+			return ret;
+
+		len = sizeof(name);
+		ret = fi_getname(&series->peer[i].ep->fid, name, &len);
+		if (ret) {
+			FT_PRINTERR("fi_getname", ret);
+			return ret;
+		}
+
+		ret = fi_av_insert(series->av, name, 1, &series->addr[i], 0,
+				   NULL);
+		if (ret != 1) {
+			FT_PRINTERR("fi_av_insert", ret);
+			return ret < 0 ? ret : -FI_EOTHER;
+		}
+
+		ret = fi_recv(series->peer[i].ep, series->peer[i].buf,
+			      sizeof(series->peer[i].buf), NULL,
+			      FI_ADDR_UNSPEC, &series->peer[i].recv_ctx);
+		if (ret) {
+			FT_PRINTERR("fi_recv", ret);
+			return ret;
+		}
+	}
+	return 0;
+}
+
+static int warmup_read_cq(struct fid_cq *cq, int *done)
+{
+	struct fi_cq_entry comp;
+	struct fi_cq_err_entry err_entry = {0};
+	ssize_t ret;
+
+	ret = fi_cq_read(cq, &comp, 1);
+	if (ret > 0) {
+		(*done)++;
+	} else if (ret == -FI_EAVAIL) {
+		fi_cq_readerr(cq, &err_entry, 0);
+		FT_CQ_ERR(cq, err_entry, NULL, 0);
+		return -err_entry.err;
+	} else if (ret != -FI_EAGAIN) {
+		FT_PRINTERR("fi_cq_read", ret);
+		return (int) ret;
+	}
+	return 0;
+}
+
+/* All endpoints live in this process, so they all need to be progressed */
+static int warmup_progress(struct warmup_series *series, uint64_t start)
+{
+	int i, ret;
+
+	ret = warmup_read_cq(series->origin.cq, &series->sends_done);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < series->peer_cnt; i++) {
+		ret = warmup_read_cq(series->peer[i].cq, &series->recvs_done);
+		if (ret)
+			return ret;
+	}
+
+	if (ft_gettime_ns() - start > WARMUP_TIMEOUT_NS) {
+		FT_ERR("timed out");
+		return -FI_ETIMEDOUT;
+	}
+	return 0;
+}
+
+static int warmup_wait_eq(struct warmup_series *series, uint64_t start)
+{
+	struct fi_eq_err_entry err_entry = {0};
+	struct fi_eq_entry entry;
+	uint32_t event;
+	ssize_t ret;
+
+	do {
+		ret = warmup_progress(series, start);
+		if (ret)
+			return (int) ret;
+
+		ret = fi_eq_read(eq, &event, &entry, sizeof(entry), 0);
+		if (ret == -FI_EAVAIL) {
+			fi_eq_readerr(eq, &err_entry, 0);
+			FT_ERR("warm-up failed: %s, %" PRIu64 " of %d connected",
+			       fi_strerror(err_entry.err), err_entry.data,
+			       series->peer_cnt);
+			return -err_entry.err;
+		} else if (ret < 0 && ret != -FI_EAGAIN) {
+			FT_PRINTERR("fi_eq_read", ret);
+			return (int) ret;
+		}
+	} while (ret < 0 || event != FI_NOTIFY ||
+		 entry.fid != &series->origin.ep->fid);
+
+	return 0;
+}
+
+static int warmup_run(int peer_cnt, size_t max_inflight, bool warmup)
+{
+	struct warmup_series series;
+	uint64_t start, connected = 0, end;
+	int i, ret;
+
+	ret = warmup_open(&series, peer_cnt);
+	if (ret)
+		goto out;
+
+	start = ft_gettime_ns();
+	if (warmup) {
+		ret = fi_conn_warmup(series.origin.ep, series.addr, peer_cnt,
+				     max_inflight, -1, NULL);
+		if (ret) {
+			FT_PRINTERR("fi_conn_warmup", ret);
+			goto out;
+		}
+
+		ret = warmup_wait_eq(&series, start);
+		if (ret)
+			goto out;
+		connected = ft_gettime_ns();
+	}
+
+	for (i = 0; i < peer_cnt; i++) {
+		while ((ret = fi_send(series.origin.ep, series.origin.buf,
+				      sizeof(series.origin.buf), NULL,
+				      series.addr[i],
+				      &series.peer[i].send_ctx)) == -FI_EAGAIN) {
+			ret = warmup_progress(&series, start);
+			if (ret)
+				goto out;
+		}
+
+		if (ret) {
+			FT_PRINTERR("fi_send", ret);
+			goto out;
+		}
+	}
+
+	while (series.sends_done < peer_cnt || series.recvs_done < peer_cnt) {
+		ret = warmup_progress(&series, start);
+		if (ret)
+			goto out;
+	}
+	end = ft_gettime_ns();
+
+	if (warmup)
+		printf("%-8s %8d %10zu %14.1f %14.1f %14.1f\n", "warmup",
+		       peer_cnt, max_inflight, (connected - start) / 1000.0,
+		       (end - connected) / 1000.0, (end - start) / 1000.0);
+	else
+		printf("%-8s %8d %10s %14s %14.1f %14.1f\n", "lazy",
+		       peer_cnt, "-", "-", (end - start) / 1000.0,
+		       (end - start) / 1000.0);
+out:
+	warmup_close(&series);
+	return ret;
+}
+
+static void usage(char *name)
+{
+	fprintf(stderr, "Usage:\n");
+	fprintf(stderr, "  %s [OPTIONS]\n", name);
+	fprintf(stderr, "\nTimes the delivery of a first message to N peers "
+		"with and without connection warm-up.\n");
+	fprintf(stderr, "\nOptions:\n");
+	FT_PRINT_OPTS_USAGE("-f <fabric>", "fabric name");
+	FT_PRINT_OPTS_USAGE("-d <domain>", "domain name");
+	FT_PRINT_OPTS_USAGE("-p <provider>",
+			    "specific provider name eg tcp, tcp;ofi_rxm");
+	FT_PRINT_OPTS_USAGE("-n <peers>", "number of peers (default: 16)");
+	FT_PRINT_OPTS_USAGE("-m <count>",
+			    "concurrent warm-up connections (default: 8)");
+	FT_PRINT_OPTS_USAGE("-h", "display this help output");
+}
+
+int main(int argc, char **argv)
+{
+	size_t max_inflight = 8;
+	int op, peer_cnt = 16, ret;
+
+	opts = INIT_OPTS;
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt(argc, argv, FAB_OPTS "n:m:h")) != -1) {
+		switch (op) {
+		case 'n':
+			peer_cnt = atoi(optarg);
+			break;
+		case 'm':
+			max_inflight = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			ft_parseinfo(op, optarg, hints, &opts);
+			break;
+		case '?':
+		case 'h':
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (peer_cnt < 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode & ~FI_MR_LOCAL;
+
+	ret = fi_getinfo(FT_FIVERSION, NULL, NULL, 0, hints, &fi);
+	if (ret) {
+		FT_PRINTERR("fi_getinfo", ret);
+		goto out;
+	}
+
+	ret = ft_open_fabric_res();
+	if (ret)
+		goto out;
+
+	printf("%-8s %8s %10s %14s %14s %14s\n", "connect", "peers",
+	       "inflight", "warmup(us)", "send(us)", "total(us)");
+
+	ret = warmup_run(peer_cnt, max_inflight, false);
+	if (!ret)
+		ret = warmup_run(peer_cnt, max_inflight, true);
+out:
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Intel Corporation.  All rights reserved.
+ *
+ * This software is available to you under the BSD license
+ * below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Tagged ping pong latency measured behind a growing number of posted
+ * receives that never match.  The receive depth doubles from 1 up to the
+ * maximum given with -n, which shows how the provider's tag matching cost
+ * scales with the length of its posted receive queue.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <rdma/fi_errno.h>
+#include <rdma/fi_tagged.h>
+
+#include <shared.h>
+#include "benchmark_shared.h"
+
+#define FT_MATCH_DECOY_TAG	(1ULL << 48)
+#define FT_MATCH_MAX_DEPTH	(64 * 1024)
+
+static size_t max_depth = FT_MATCH_MAX_DEPTH;
+static size_t decoy_cnt;
+static uint64_t decoy_ignore;
+static struct fi_context2 *decoy_ctx;
+
+static int post_decoys(size_t depth)
+{
+	ssize_t ret;
+
+	/* the pingpong receive itself counts towards the depth */
+	for (; decoy_cnt < depth - 1; decoy_cnt++) {
+		do {
+			ret = fi_trecv(ep, rx_buf, opts.transfer_size, mr_desc,
+				       FI_ADDR_UNSPEC,
+				       FT_MATCH_DECOY_TAG | (decoy_cnt << 1),
+				       decoy_ignore, &decoy_ctx[decoy_cnt]);
+			if (ret == -FI_EAGAIN)
+				ft_force_progress();
+		} while (ret == -FI_EAGAIN);
+
+		if (ret) {
+			FT_PRINTERR("fi_trecv", ret);
+			return (int) ret;
+		}
+	}
+	return 0;
+}
+
+static int match_pingpong(size_t depth)
+{
+	char name[FT_STR_LEN];
+	int ret, i;
+
+	ret = post_decoys(depth);
+	if (ret)
+		return ret;
+
+	ret = ft_sync();
+	if (ret)
+		return ret;
+
+	for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
+		if (i == opts.warmup_iterations)
+			ft_start();
+
+		if (opts.dst_addr) {
+			ret = ft_tx(ep, remote_fi_addr, opts.transfer_size,
+				    &tx_ctx);
+			if (ret)
+				return ret;
+
+			ret = ft_rx(ep, opts.transfer_size);
+		} else {
+			ret = ft_rx(ep, opts.transfer_size);
+			if (ret)
+				return ret;
+
+			ret = ft_tx(ep, remote_fi_addr, opts.transfer_size,
+				    &tx_ctx);
+		}
+		if (ret)
+			return ret;
+	}
+	ft_stop();
+
+	snprintf(name, sizeof(name), "depth_%zu", depth);
+	show_perf(name, opts.transfer_size, opts.iterations, &start, &end, 2);
+	return 0;
+}
+
+static int run(void)
+{
+	size_t depth;
+	int ret;
+
+	decoy_ctx = calloc(max_depth, sizeof(*decoy_ctx));
+	if (!decoy_ctx)
+		return -FI_ENOMEM;
+
+	ret = ft_init_fabric();
+	if (ret)
+		goto out;
+
+	if (!(opts.options & FT_OPT_SIZE))
+		opts.transfer_size = 64;
+	init_test(&opts, test_name, sizeof(test_name));
+
+	for (depth = 1; depth <= max_depth; depth <<= 1) {
+		ret = match_pingpong(depth);
+		if (ret)
+			goto out;
+	}
+
+	ret = ft_finalize();
+out:
+	/* outstanding decoy receives are flushed when the endpoint closes */
+	ft_free_res();
+	free(decoy_ctx);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt_long(argc, argv, "gn:h" CS_OPTS INFO_OPTS
+				 BENCHMARK_OPTS, long_opts, &lopt_idx)) != -1) {
+		switch (op) {
+		default:
+			if (!ft_parse_long_opts(op, optarg))
+				continue;
+			ft_parse_benchmark_opts(op, optarg);
+			ft_parseinfo(op, optarg, hints, &opts);
+			ft_parsecsopts(op, optarg, &opts);
+			break;
+		case 'g':
+			decoy_ignore = 1;
+			break;
+		case 'n':
+			max_depth = strtoul(optarg, NULL, 0);
+			if (!max_depth)
+				max_depth = 1;
+			break;
+		case '?':
+		case 'h':
+			ft_csusage(argv[0], "Tagged ping pong latency with a deep "
+				   "posted receive queue.");
+			ft_benchmark_usage();
+			FT_PRINT_OPTS_USAGE("-n <depth>", "maximum number of "
+				"posted receives (default: 65536)");
+			FT_PRINT_OPTS_USAGE("-g", "post wildcard (non-zero "
+				"ignore) receives instead of exact tags");
+			ft_longopts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_TAGGED;
+	hints->mode |= FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->addr_format = opts.address_format;
+
+	ret = run();
+	return ft_exit_code(ret);
+}
@@ -4532,6 +4532,11 @@ void ft_longopts_usage()
 		"threading model: safe|completion|domain (default:domain)");
 	FT_PRINT_OPTS_USAGE("--no-rx-cq-data",
 		"Do not request FI_RX_CQ_DATA in hints for writedata/sendata tests");
+	FT_PRINT_OPTS_USAGE("--lat-stats",
+		"Report min/p50/p90/p99/p99.9/max latency (pingpong tests)");
+	FT_PRINT_OPTS_USAGE("--lat-hist <file>",
+		"Write a latency histogram to file, in JSON if the name\n"
+		"ends in .json, CSV otherwise. Implies --lat-stats");
 }
 
 int debug_assert;
@@ -4547,6 +4552,8 @@ struct option long_opts[] = {
 	{"use-fi-more", no_argument, NULL, LONG_OPT_USE_FI_MORE},
 	{"threading", required_argument, NULL, LONG_OPT_THREADING},
 	{"no-rx-cq-data", no_argument, NULL, LONG_OPT_NO_RX_CQ_DATA},
+	{"lat-stats", no_argument, NULL, LONG_OPT_LAT_STATS},
+	{"lat-hist", required_argument, NULL, LONG_OPT_LAT_HIST},
 	{NULL, 0, NULL, 0},
 };
 
@@ -4610,6 +4617,12 @@ int ft_parse_long_opts(int op, char *optarg)
 	case LONG_OPT_NO_RX_CQ_DATA:
 		allow_rx_cq_data = false;
 		return 0;
+	case LONG_OPT_LAT_HIST:
+		opts.lat_hist = optarg;
+		/* fall through */
+	case LONG_OPT_LAT_STATS:
+		opts.lat_stats = 1;
+		return 0;
 	default:
 		return EXIT_FAILURE;
 	}
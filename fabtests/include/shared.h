@@ -222,6 +222,10 @@ struct ft_opts {
 	uint64_t device;
 	enum fi_threading threading;
 
+	/* per iteration latency percentiles and histogram output file */
+	int lat_stats;
+	char *lat_hist;
+
 	char **argv;
 };
 
@@ -679,6 +683,8 @@ enum {
 	LONG_OPT_USE_FI_MORE,
 	LONG_OPT_THREADING,
 	LONG_OPT_NO_RX_CQ_DATA,
+	LONG_OPT_LAT_STATS,
+	LONG_OPT_LAT_HIST,
 };
 
 extern int debug_assert;
@@ -333,14 +333,13 @@ out:
 	return ret;
 }
 
-static int scatter_test_run(enum fi_collective_op coll_op, enum fi_op op,
-		enum fi_datatype datatype)
+static int scatter_root_test_run(enum fi_collective_op coll_op,
+		enum fi_datatype datatype, fi_addr_t root)
 {
 	uint64_t done_flag;
 	uint64_t result;
 	uint64_t *data;
 	uint64_t i;
-	fi_addr_t root = 0;
 	size_t data_size = pm_job.num_ranks * sizeof(*data);
 	int err;
 
@@ -386,13 +385,25 @@ out:
 	return err;
 }
 
-static int broadcast_test_run(enum fi_collective_op coll_op, enum fi_op op,
+static int scatter_test_run(enum fi_collective_op coll_op, enum fi_op op,
 		enum fi_datatype datatype)
+{
+	return scatter_root_test_run(coll_op, datatype, 0);
+}
+
+/* with ranks spread over nodes, the last rank is not a node leader */
+static int scatter_last_root_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	return scatter_root_test_run(coll_op, datatype, pm_job.num_ranks - 1);
+}
+
+static int broadcast_root_test_run(enum fi_collective_op coll_op,
+		enum fi_datatype datatype, fi_addr_t root)
 {
 	uint64_t done_flag;
 	uint64_t *result, *data;
 	uint64_t i;
-	fi_addr_t root = 0;
 	size_t data_cnt = pm_job.num_ranks;
 	int err;
 
@@ -450,6 +461,265 @@ out:
 	return err;
 }
 
+static int broadcast_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	return broadcast_root_test_run(coll_op, datatype, 0);
+}
+
+static int broadcast_last_root_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	return broadcast_root_test_run(coll_op, datatype,
+				       pm_job.num_ranks - 1);
+}
+
+static int ring_all_reduce_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *result, *data;
+	uint64_t rank_sum = 0;
+	/* large enough for each rank's segment to select the ring */
+	size_t count = pm_job.num_ranks * 1024;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_ALLREDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	result = malloc(count * sizeof(*result));
+	if (!result)
+		return -FI_ENOMEM;
+
+	data = malloc(count * sizeof(*data));
+	if (!data) {
+		free(result);
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < count; i++)
+		data[i] = pm_job.my_rank + i;
+
+	for (i = 0; i < pm_job.num_ranks; i++)
+		rank_sum += i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_allreduce(ep, data, count, NULL, result, NULL, coll_addr,
+			   FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective allreduce failed - fi_allreduce", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < count; i++) {
+		if (result[i] != rank_sum + pm_job.num_ranks * i) {
+			FT_DEBUG("allreduce failed; expect[%ld]: %ld, "
+				 "actual[%ld]: %ld\n", i,
+				 rank_sum + pm_job.num_ranks * i, i, result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+	err = FI_SUCCESS;
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
+static int sum_reduce_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t result = 0;
+	uint64_t expect_result = 0;
+	uint64_t data;
+	const uint64_t base_data_value = 1234;
+	fi_addr_t root = 0;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_REDUCE);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	data = base_data_value + pm_job.my_rank;
+	for (i = 0; i < pm_job.num_ranks; i++)
+		expect_result += base_data_value + i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_reduce(ep, &data, 1, NULL, &result, NULL, coll_addr, root,
+			FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective reduce failed - fi_reduce", err);
+		return err;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		return err;
+
+	if (pm_job.my_rank != root || result == expect_result)
+		return FI_SUCCESS;
+
+	FT_DEBUG("reduce failed; expect: %ld, actual: %ld",
+		 expect_result, result);
+	return -FI_ENOEQ;
+}
+
+static int sum_reduce_scatter_test_run(enum fi_collective_op coll_op,
+		enum fi_op op, enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t result = 0;
+	uint64_t expect_result = 0;
+	uint64_t *data;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_REDUCE_SCATTER);
+	assert(op == FI_SUM);
+	assert(datatype == FI_UINT64);
+
+	data = malloc(pm_job.num_ranks * sizeof(*data));
+	if (!data)
+		return -FI_ENOMEM;
+
+	/* slice i of every rank's input is rank + i */
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		data[i] = pm_job.my_rank + i;
+		expect_result += i + pm_job.my_rank;
+	}
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_reduce_scatter(ep, data, 1, NULL, &result, NULL, coll_addr,
+				FI_UINT64, FI_SUM, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective reduce scatter failed - "
+			    "fi_reduce_scatter", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	if (result != expect_result) {
+		FT_DEBUG("reduce scatter failed; expect: %ld, actual: %ld",
+			 expect_result, result);
+		err = -FI_ENOEQ;
+	}
+
+out:
+	free(data);
+	return err;
+}
+
+static int alltoall_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *result, *data;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_ALLTOALL);
+	assert(datatype == FI_UINT64);
+
+	result = malloc(pm_job.num_ranks * sizeof(*result));
+	if (!result)
+		return -FI_ENOMEM;
+
+	data = malloc(pm_job.num_ranks * sizeof(*data));
+	if (!data) {
+		free(result);
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < pm_job.num_ranks; i++)
+		data[i] = pm_job.my_rank * pm_job.num_ranks + i;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_alltoall(ep, data, 1, NULL, result, NULL, coll_addr,
+			  FI_UINT64, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective alltoall failed - fi_alltoall", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		if (result[i] != i * pm_job.num_ranks + pm_job.my_rank) {
+			FT_DEBUG("alltoall failed; expect[%ld]: %ld, "
+				 "actual[%ld]: %ld\n", i,
+				 i * pm_job.num_ranks + pm_job.my_rank, i,
+				 result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+	err = FI_SUCCESS;
+
+out:
+	free(data);
+	free(result);
+	return err;
+}
+
+static int gather_test_run(enum fi_collective_op coll_op, enum fi_op op,
+		enum fi_datatype datatype)
+{
+	uint64_t done_flag;
+	uint64_t *result;
+	uint64_t data = pm_job.my_rank;
+	/* a non-zero root exercises the reordering at the root */
+	fi_addr_t root = pm_job.num_ranks - 1;
+	uint64_t i;
+	int err;
+
+	assert(coll_op == FI_GATHER);
+	assert(datatype == FI_UINT64);
+
+	result = calloc(pm_job.num_ranks, sizeof(*result));
+	if (!result)
+		return -FI_ENOMEM;
+
+	coll_addr = fi_mc_addr(coll_mc);
+	err = fi_gather(ep, &data, 1, NULL, result, NULL, coll_addr, root,
+			FI_UINT64, 0, &done_flag);
+	if (err) {
+		FT_PRINTERR("collective gather failed - fi_gather", err);
+		goto out;
+	}
+
+	err = wait_for_comp(&done_flag);
+	if (err || pm_job.my_rank != root)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		if (result[i] != i) {
+			FT_DEBUG("gather failed; expect[%ld]: %ld, "
+				 "actual[%ld]: %ld\n", i, i, i, result[i]);
+			err = -FI_ENOEQ;
+			goto out;
+		}
+	}
+
+out:
+	free(result);
+	return err;
+}
+
 struct coll_test tests[] = {
 	{
 		.name = "join_test",
@@ -514,6 +784,69 @@ struct coll_test tests[] = {
 		.op = FI_NOOP,
 		.datatype = FI_UINT64
 	},
+	{
+		.name = "scatter_last_root_test",
+		.setup = coll_setup,
+		.run = scatter_last_root_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_SCATTER,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64
+	},
+	{
+		.name = "broadcast_last_root_test",
+		.setup = coll_setup,
+		.run = broadcast_last_root_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_BROADCAST,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64
+	},
+	{
+		.name = "ring_all_reduce_test",
+		.setup = coll_setup,
+		.run = ring_all_reduce_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLREDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_reduce_test",
+		.setup = coll_setup,
+		.run = sum_reduce_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "sum_reduce_scatter_test",
+		.setup = coll_setup,
+		.run = sum_reduce_scatter_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_REDUCE_SCATTER,
+		.op = FI_SUM,
+		.datatype = FI_UINT64,
+	},
+	{
+		.name = "alltoall_test",
+		.setup = coll_setup,
+		.run = alltoall_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_ALLTOALL,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64
+	},
+	{
+		.name = "gather_test",
+		.setup = coll_setup,
+		.run = gather_test_run,
+		.teardown = coll_teardown,
+		.coll_op = FI_GATHER,
+		.op = FI_NOOP,
+		.datatype = FI_UINT64
+	},
 	{
 		.name = "empty_test_to_stop_the_sequence_of_execution",
 		.run = NULL,
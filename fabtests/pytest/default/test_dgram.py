@@ -22,3 +22,11 @@ def test_dgram_pingpong(cmdline_args, iteration_type, prefix_type):
     test.run()
 
 
+
+@pytest.mark.parametrize("iteration_type",
+                         [pytest.param("short", marks=pytest.mark.short),
+                          pytest.param("standard", marks=pytest.mark.standard)])
+def test_dgram_bw(cmdline_args, iteration_type):
+    from common import ClientServerTest
+    test = ClientServerTest(cmdline_args, "fi_dgram_bw", iteration_type)
+    test.run()
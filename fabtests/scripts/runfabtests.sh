@@ -146,6 +146,7 @@ functional_tests=(
 	"fi_recv_cancel -e rdm -V"
 	"fi_unexpected_msg -e msg -I 10 -v"
 	"fi_unexpected_msg -e rdm -I 10 -v"
+	"fi_unexpected_msg -e rdm -I 10 -v -S 1048576 -M 8"
 	"fi_inject_test -A inject -v"
 	"fi_inject_test -N -A inject -v"
 	"fi_inject_test -A inj_complete -v"
@@ -191,6 +192,7 @@ short_tests=(
 	"fi_rdm_tagged_bw -I 5 -v"
 	"fi_rdm_tagged_bw -I 5 -v -U"
 	"fi_dgram_pingpong -I 5"
+	"fi_dgram_bw -I 5"
 )
 
 standard_tests=(
@@ -234,6 +236,7 @@ standard_tests=(
 	"fi_rdm_tagged_bw -v -U"
 	"fi_dgram_pingpong"
 	"fi_dgram_pingpong -k"
+	"fi_dgram_bw"
 )
 
 unit_tests=(
@@ -11,8 +11,9 @@ except ImportError:
 	sys.exit(1)
 
 def main(argv=None):
-	"""Convert runfabtests.sh yaml output to CSV. If no argument is given
-	   stdin is read, otherwise read from file.
+	"""Convert runfabtests.sh yaml output, or a --lat-hist JSON latency
+	   histogram written by the pingpong benchmarks, to CSV. If no argument
+	   is given stdin is read, otherwise read from file.
 	"""
 
 	parser = OptionParser(description=main.__doc__, usage="usage: %prog [file]")
@@ -26,6 +27,15 @@ def main(argv=None):
 	yi = yaml.safe_load(fd.read())
 
 	csv_fd = csv.writer(sys.stdout, delimiter=",", quotechar='"', quoting=csv.QUOTE_NONNUMERIC)
+
+	if all(isinstance(v, dict) and "histogram" in v for v in yi.values()):
+		csv_fd.writerow(["bytes", "usec", "count", "percentile"])
+		for v in yi.values():
+			for b in v["histogram"]:
+				csv_fd.writerow([v["bytes"], b["usec"], b["count"],
+						 b["percentile"]])
+		return 0
+
 	csv_fd.writerow(["Test name", "Status"])
 	
 	for k,v in yi.items():
@@ -34,6 +34,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <getopt.h>
+#include <unistd.h>
 #include <string.h>
 #include <netdb.h>
 #include <sys/types.h>
@@ -49,6 +50,7 @@
 char *good_address;
 int num_good_addr;
 char *bad_address;
+static size_t num_bulk_addr;
 
 static enum fi_av_type av_type;
 static char err_buf[512];
@@ -711,12 +713,240 @@ fail:
 	return TEST_RET_VAL(ret, testret);
 }
 
+/* Resident set size in KB, 0 if it can't be read */
+static long av_rss_kb(void)
+{
+	FILE *f;
+	long size, rss;
+
+	f = fopen("/proc/self/statm", "r");
+	if (!f)
+		return 0;
+
+	if (fscanf(f, "%ld %ld", &size, &rss) != 2)
+		rss = 0;
+	fclose(f);
+	return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/*
+ * Tests:
+ * - insert of a large synthetic address vector in one call, reporting the
+ *   insert time and the growth in RSS, followed by sampled lookups
+ */
+static int
+av_bulk_insert(void)
+{
+	int testret;
+	int ret;
+	size_t i, step;
+	struct fid_av *av = NULL;
+	struct fi_av_attr attr;
+	struct sockaddr_in base, *sin, lookup_addr;
+	size_t lookup_len;
+	fi_addr_t *fi_addr = NULL;
+	uint64_t start, end;
+	long rss;
+
+	testret = FAIL;
+	sin = NULL;
+
+	if (!num_bulk_addr || (fi->addr_format != FI_SOCKADDR &&
+			       fi->addr_format != FI_SOCKADDR_IN)) {
+		ret = -FI_ENODATA;
+		goto fail;
+	}
+
+	ret = av_create_addr_sockaddr_in(good_address, 0, &base);
+	if (ret)
+		goto fail;
+
+	sin = calloc(num_bulk_addr, sizeof(*sin));
+	fi_addr = calloc(num_bulk_addr, sizeof(*fi_addr));
+	if (!sin || !fi_addr) {
+		sprintf(err_buf, "malloc failed");
+		ret = -FI_ENOMEM;
+		goto fail;
+	}
+
+	/* unique address per entry, varying the port before the IP */
+	for (i = 0; i < num_bulk_addr; i++) {
+		sin[i] = base;
+		sin[i].sin_port = htons(1024 + i % 60000);
+		sin[i].sin_addr.s_addr = htonl(ntohl(base.sin_addr.s_addr) +
+					       i / 60000);
+	}
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = av_type;
+	attr.count = num_bulk_addr;
+
+	rss = av_rss_kb();
+	start = ft_gettime_us();
+
+	ret = fi_av_open(domain, &attr, &av, NULL);
+	if (ret != 0) {
+		sprintf(err_buf, "fi_av_open(%s) = %d, %s",
+			fi_tostr(&av_type, FI_TYPE_AV_TYPE), ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	ret = fi_av_insert(av, sin, num_bulk_addr, fi_addr, 0, NULL);
+	if (ret != num_bulk_addr) {
+		sprintf(err_buf, "fi_av_insert ret=%d, %s", ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	end = ft_gettime_us();
+	printf("\n  %zu addresses: insert %.3f s, %.1f usec/addr, "
+	       "RSS +%ld KB ... ", num_bulk_addr, (end - start) / 1e6,
+	       (double) (end - start) / num_bulk_addr, av_rss_kb() - rss);
+
+	step = num_bulk_addr / 1024 ? num_bulk_addr / 1024 : 1;
+	for (i = 0; i < num_bulk_addr; i += step) {
+		lookup_len = sizeof(lookup_addr);
+		ret = fi_av_lookup(av, fi_addr[i], &lookup_addr, &lookup_len);
+		if (ret) {
+			sprintf(err_buf, "fi_av_lookup ret=%d, %s", ret,
+				fi_strerror(-ret));
+			goto fail;
+		}
+		if (lookup_addr.sin_port != sin[i].sin_port ||
+		    lookup_addr.sin_addr.s_addr != sin[i].sin_addr.s_addr) {
+			sprintf(err_buf, "fi_av_lookup returned incorrect "
+				"address for fi_addr[%zu] = %ld", i,
+				(long) fi_addr[i]);
+			goto fail;
+		}
+	}
+
+	testret = PASS;
+fail:
+	FT_CLOSE_FID(av);
+	free(fi_addr);
+	free(sin);
+	return TEST_RET_VAL(ret, testret);
+}
+
+/*
+ * Tests:
+ * - insert of a synthetic address vector holding a duplicate address,
+ *   removal of half of it, re-insert, then removal of everything.  Run
+ *   with FI_AV_COMPACT=1 to cover entries left out of the AV hash.
+ */
+static int
+av_insert_remove(void)
+{
+	int testret;
+	int ret;
+	size_t i, count = 64;
+	struct fid_av *av = NULL;
+	struct fi_av_attr attr;
+	struct sockaddr_in base, *sin, lookup_addr;
+	size_t lookup_len;
+	fi_addr_t *fi_addr = NULL;
+
+	testret = FAIL;
+	sin = NULL;
+
+	if (fi->addr_format != FI_SOCKADDR &&
+	    fi->addr_format != FI_SOCKADDR_IN) {
+		ret = -FI_ENODATA;
+		goto fail;
+	}
+
+	ret = av_create_addr_sockaddr_in(good_address, 0, &base);
+	if (ret)
+		goto fail;
+
+	sin = calloc(count, sizeof(*sin));
+	fi_addr = calloc(count, sizeof(*fi_addr));
+	if (!sin || !fi_addr) {
+		sprintf(err_buf, "malloc failed");
+		ret = -FI_ENOMEM;
+		goto fail;
+	}
+
+	/* the last address repeats the first */
+	for (i = 0; i < count; i++) {
+		sin[i] = base;
+		sin[i].sin_port = htons(1024 + i % (count - 1));
+	}
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = av_type;
+	attr.count = count;
+
+	ret = fi_av_open(domain, &attr, &av, NULL);
+	if (ret != 0) {
+		sprintf(err_buf, "fi_av_open(%s) = %d, %s",
+			fi_tostr(&av_type, FI_TYPE_AV_TYPE), ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	ret = fi_av_insert(av, sin, count, fi_addr, 0, NULL);
+	if (ret != count) {
+		sprintf(err_buf, "fi_av_insert ret=%d, %s", ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	ret = fi_av_remove(av, fi_addr, count / 2, 0);
+	if (ret) {
+		sprintf(err_buf, "fi_av_remove ret=%d, %s", ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	ret = fi_av_insert(av, sin, count / 2, fi_addr, 0, NULL);
+	if (ret != count / 2) {
+		sprintf(err_buf, "fi_av_insert after remove ret=%d, %s", ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	for (i = 0; i < count; i++) {
+		lookup_len = sizeof(lookup_addr);
+		ret = fi_av_lookup(av, fi_addr[i], &lookup_addr, &lookup_len);
+		if (ret) {
+			sprintf(err_buf, "fi_av_lookup ret=%d, %s", ret,
+				fi_strerror(-ret));
+			goto fail;
+		}
+		if (lookup_addr.sin_port != sin[i].sin_port) {
+			sprintf(err_buf, "fi_av_lookup returned incorrect "
+				"address for fi_addr[%zu] = %ld", i,
+				(long) fi_addr[i]);
+			goto fail;
+		}
+	}
+
+	ret = fi_av_remove(av, fi_addr, count, 0);
+	if (ret) {
+		sprintf(err_buf, "fi_av_remove of all ret=%d, %s", ret,
+			fi_strerror(-ret));
+		goto fail;
+	}
+
+	testret = PASS;
+fail:
+	FT_CLOSE_FID(av);
+	free(fi_addr);
+	free(sin);
+	return TEST_RET_VAL(ret, testret);
+}
+
 struct test_entry test_array_good[] = {
 	TEST_ENTRY(av_open_close, "Test open and close AVs of varying sizes"),
 	TEST_ENTRY(av_good, "Test AV insert with good address"),
 	TEST_ENTRY(av_null_fi_addr, "Test AV insert without specifying fi_addr"),
 	TEST_ENTRY(av_insert_stages, "Test AV insert at various stages"),
 	TEST_ENTRY(av_lookup_good, "Test AV lookup with good address"),
+	TEST_ENTRY(av_bulk_insert, "Test AV insert of a large address vector"),
+	TEST_ENTRY(av_insert_remove, "Test AV insert and remove of addresses"),
 	{ NULL, "" }
 };
 
@@ -756,6 +986,9 @@ static void usage(char *name)
 	FT_PRINT_OPTS_USAGE("-G <bad_address>", "");
 	fprintf(stderr, FT_OPTS_USAGE_FORMAT " (max=%d)\n", "-n <num_good_addr>",
 			"Number of good addresses", MAX_ADDR - 1);
+	FT_PRINT_OPTS_USAGE("-N <num_bulk_addr>",
+			    "Number of addresses for the bulk insert test, "
+			    "skipped if not given (e.g. 1000000)");
 	FT_PRINT_OPTS_USAGE("-s <source_address>", "");
 }
 
@@ -772,7 +1005,7 @@ int main(int argc, char **argv)
 		return EXIT_FAILURE;
 
 	hints->ep_attr->type = FI_EP_RDM;
-	while ((op = getopt(argc, argv, INFO_OPTS "g:G:n:s:h")) != -1) {
+	while ((op = getopt(argc, argv, INFO_OPTS "g:G:n:N:s:h")) != -1) {
 		switch (op) {
 		case 'g':
 			good_address = optarg;
@@ -783,6 +1016,9 @@ int main(int argc, char **argv)
 		case 'n':
 			num_good_addr = atoi(optarg);
 			break;
+		case 'N':
+			num_bulk_addr = strtoul(optarg, NULL, 0);
+			break;
 		case 's':
 			opts.src_addr = optarg;
 			break;
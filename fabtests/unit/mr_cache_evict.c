@@ -39,6 +39,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <pthread.h>
 
 #include "unit_common.h"
 #include "shared.h"
@@ -56,6 +57,18 @@ enum alloc_type {
 static void *reuse_addr = NULL;
 static char err_buf[512];
 static size_t mr_buf_size = 16384;
+static int mr_threads = 4;
+static int mr_iterations = 10000;
+
+/* Buffers registered in turn by each thread of the multi-threaded test. */
+#define MR_THREAD_BUFS 8
+
+struct mr_thread {
+	pthread_t thread;
+	char *buf;
+	uint64_t key;
+	int ret;
+};
 
 /* Given a time value, determine the expected cached time value. The assumption
  * is the cache value should at least have a CACHE_IMPROVEMENT_PERCENT time
@@ -742,12 +755,118 @@ static int mr_cache_rocr_test(void)
 	return ret;
 }
 
+/* Register and close MRs over the thread's buffers.  After the first pass
+ * every registration should be served from the provider's MR cache.
+ */
+static void *mr_reg_thread(void *arg)
+{
+	struct mr_thread *thread = arg;
+	struct fid_mr *mr;
+	int i;
+
+	for (i = 0; i < mr_iterations; i++) {
+		thread->ret = fi_mr_reg(domain, thread->buf +
+					(i % MR_THREAD_BUFS) * mr_buf_size,
+					mr_buf_size, ft_info_to_mr_access(fi),
+					0, thread->key, 0, &mr, NULL);
+		if (thread->ret)
+			break;
+
+		thread->ret = fi_close(&mr->fid);
+		if (thread->ret)
+			break;
+	}
+
+	return NULL;
+}
+
+/* Run cnt threads registering concurrently and return the average time,
+ * in nanoseconds, of one registration and close across all threads.
+ */
+static int mr_reg_threads(int cnt, int64_t *elapsed)
+{
+	struct mr_thread *threads;
+	int i, ret = 0;
+
+	threads = calloc(cnt, sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+
+	for (i = 0; i < cnt; i++) {
+		threads[i].key = FT_MR_KEY + 1 + i;
+		threads[i].buf = calloc(MR_THREAD_BUFS, mr_buf_size);
+		if (!threads[i].buf) {
+			ret = -ENOMEM;
+			goto free;
+		}
+	}
+
+	ft_start();
+	for (i = 0; i < cnt; i++) {
+		ret = pthread_create(&threads[i].thread, NULL, mr_reg_thread,
+				     &threads[i]);
+		if (ret) {
+			ret = -ret;
+			break;
+		}
+	}
+	cnt = i;
+	for (i = 0; i < cnt; i++) {
+		pthread_join(threads[i].thread, NULL);
+		if (threads[i].ret && !ret)
+			ret = threads[i].ret;
+	}
+	ft_stop();
+
+	*elapsed = get_elapsed(&start, &end, NANO) /
+		   ((int64_t) cnt * mr_iterations);
+free:
+	for (i = 0; i < cnt; i++)
+		free(threads[i].buf);
+	free(threads);
+	return ret;
+}
+
+/* Compare the registration rate of one thread against mr_threads threads
+ * sharing the domain, which exercises the locking of MR cache lookups.
+ */
+static int mr_cache_mt_test(void)
+{
+	int64_t single_time, mt_time;
+	int ret;
+
+	if (fi->domain_attr->threading != FI_THREAD_SAFE) {
+		sprintf(err_buf, "domain does not support FI_THREAD_SAFE");
+		return SKIPPED;
+	}
+
+	ret = mr_reg_threads(1, &single_time);
+	if (ret) {
+		FT_UNIT_STRERR(err_buf, "single threaded registration failed",
+			       ret);
+		return TEST_RET_VAL(ret, FAIL);
+	}
+
+	ret = mr_reg_threads(mr_threads, &mt_time);
+	if (ret) {
+		FT_UNIT_STRERR(err_buf, "multi-threaded registration failed",
+			       ret);
+		return TEST_RET_VAL(ret, FAIL);
+	}
+
+	printf("1 thread: %ld ns/reg, %d threads: %ld ns/reg (%.2fx)...",
+	       single_time, mr_threads, mt_time,
+	       mt_time ? (double) single_time / mt_time : 0.0);
+	return PASS;
+}
+
 struct test_entry test_array[] = {
 	TEST_ENTRY(mr_cache_mmap_test, "MR cache eviction test using MMAP"),
 	TEST_ENTRY(mr_cache_brk_test, "MR cache eviction test using BRK"),
 	TEST_ENTRY(mr_cache_sbrk_test, "MR cache eviction test using SBRK"),
 	TEST_ENTRY(mr_cache_cuda_test, "MR cache eviction test using CUDA"),
 	TEST_ENTRY(mr_cache_rocr_test, "MR cache eviction test using ROCR"),
+	TEST_ENTRY(mr_cache_mt_test, "MR cache multi-threaded registration"),
 	{ NULL, "" }
 };
 
@@ -763,8 +882,15 @@ static void usage(char *name)
 		"allocation is returned. This can be used to verify the \n"
 		"underlying physical memory changes between MMAP, BRK, and \n"
 		"SBRK allocations. When running as non-root, the reported \n"
-		"physical address is always zero.");
+		"physical address is always zero.\n\n"
+		"The multi-threaded test reports the average registration time\n"
+		"with one and with several threads registering cached buffers\n"
+		"on the same domain.");
 	FT_PRINT_OPTS_USAGE("-s <bytes>", "Memory region size to be tested.");
+	FT_PRINT_OPTS_USAGE("-T <threads>",
+			    "Threads of the multi-threaded test (default 4).");
+	FT_PRINT_OPTS_USAGE("-I <iterations>",
+			    "Registrations per thread (default 10000).");
 	FT_PRINT_OPTS_USAGE("-H", "Enable provider FI_HMEM support");
 }
 
@@ -790,7 +916,7 @@ int main(int argc, char **argv)
 	if (!hints)
 		return EXIT_FAILURE;
 
-	while ((op = getopt(argc, argv, FAB_OPTS "h" "s:")) != -1) {
+	while ((op = getopt(argc, argv, FAB_OPTS "h" "s:T:I:")) != -1) {
 		switch (op) {
 		default:
 			ft_parseinfo(op, optarg, hints, &opts);
@@ -810,6 +936,22 @@ int main(int argc, char **argv)
 				goto out;
 			}
 			break;
+		case 'T':
+			mr_threads = atoi(optarg);
+			if (mr_threads <= 0) {
+				ret = -EINVAL;
+				FT_PRINTERR("Invalid thread count", ret);
+				goto out;
+			}
+			break;
+		case 'I':
+			mr_iterations = atoi(optarg);
+			if (mr_iterations <= 0) {
+				ret = -EINVAL;
+				FT_PRINTERR("Invalid iteration count", ret);
+				goto out;
+			}
+			break;
 		case '?':
 		case 'h':
 			usage(argv[0]);
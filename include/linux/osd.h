@@ -38,6 +38,7 @@
 /*#define _GNU_SOURCE*/
 
 #include <byteswap.h>
+#include <errno.h>
 #include <endian.h>
 #include <sys/mman.h>
 #include <string.h>
@@ -140,6 +141,46 @@ static inline int ofi_pidfd_getfd(int pidfd, int targetfd, unsigned int flags)
 	return syscall(__NR_pidfd_getfd, pidfd, targetfd, flags);
 }
 
+#define OFI_MPOL_PREFERRED 1
+#define OFI_MPOL_BIND 2
+
+/*
+ * Apply a NUMA memory policy for a single node to the pages of a page
+ * aligned range.  Issued through syscall() to avoid a dependency on libnuma.
+ */
+static inline int ofi_mbind_node(void *addr, size_t len, int node, int mode)
+{
+#if defined(__NR_mbind)
+	unsigned long nodemask;
+
+	if (node < 0 || node >= (int) sizeof(nodemask) * 8)
+		return -FI_ENOSYS;
+
+	nodemask = 1UL << node;
+	if (syscall(__NR_mbind, addr, len, mode, &nodemask,
+		    sizeof(nodemask) * 8 + 1, 0))
+		return -errno;
+	return 0;
+#else
+	return -FI_ENOSYS;
+#endif
+}
+
+/* Prefer the NUMA node of the calling thread */
+static inline int ofi_mbind_local(void *addr, size_t len)
+{
+#if defined(__NR_getcpu)
+	unsigned int cpu, node;
+
+	if (syscall(__NR_getcpu, &cpu, &node, NULL))
+		return -errno;
+
+	return ofi_mbind_node(addr, len, node, OFI_MPOL_PREFERRED);
+#else
+	return -FI_ENOSYS;
+#endif
+}
+
 static inline ssize_t ofi_read_socket(SOCKET fd, void *buf, size_t count)
 {
 	return read(fd, buf, count);
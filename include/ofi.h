@@ -436,7 +436,9 @@ uint8_t ofi_lsb(uint64_t num);
 extern int ofi_fork_unsafe;
 extern size_t ofi_universe_size;
 extern int ofi_av_remove_cleanup;
+extern int ofi_av_compact;
 extern char *ofi_offload_coll_prov_name;
+extern char *ofi_getinfo_cache_dir;
 extern int ofi_prefer_sysconfig;
 
 bool ofi_send_allowed(uint64_t caps);
@@ -546,6 +548,25 @@ void ofi_tostr_log_subsys(char *buf, size_t len, enum fi_log_subsys subsys);
 
 int ofi_nic_close(struct fid *fid);
 int ofi_nic_control(struct fid *fid, int command, void *arg);
+extern struct fi_ops default_nic_ops;
+
+struct ofi_getinfo_cache;
+
+void ofi_getinfo_cache_init(void);
+void ofi_getinfo_cache_fini(void);
+const char *ofi_prov_cache_lookup(const char *lib);
+void ofi_prov_cache_update(const char *lib, const char *prov_name);
+void ofi_prov_cache_flush(void);
+struct ofi_getinfo_cache *
+ofi_getinfo_cache_open(uint32_t version, const char *node,
+		       const char *service, uint64_t flags,
+		       const struct fi_info *hints);
+int ofi_getinfo_cache_get(struct ofi_getinfo_cache *cache,
+			  const char *prov_name, struct fi_info **info);
+void ofi_getinfo_cache_put(struct ofi_getinfo_cache *cache,
+			   const char *prov_name, const struct fi_info *info,
+			   int ret);
+void ofi_getinfo_cache_close(struct ofi_getinfo_cache *cache);
 
 #ifdef __cplusplus
 }
@@ -86,6 +86,25 @@ extern void (*ofi_atomic_swap_handlers[OFI_SWAP_OP_CNT][OFI_DATATYPE_CNT])
 	ofi_atomic_swap_handlers[op - OFI_SWAP_OP_START][datatype](dst, src, \
 								cmp, res, cnt)
 
+/*
+ * The reduce handlers apply the same operations as the atomic write and
+ * readwrite handlers, but without per-element atomicity.  They may only be
+ * used on buffers that are not accessed concurrently, such as bounce buffers
+ * or collective scratch space, and use vector instructions where available.
+ */
+extern void (*ofi_reduce_write_handlers[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+			(void *dst, const void *src, size_t cnt);
+extern void (*ofi_reduce_readwrite_handlers[OFI_READWRITE_OP_CNT][OFI_DATATYPE_CNT])
+			(void *dst, const void *src, void *res, size_t cnt);
+extern const char *ofi_reduce_simd_isa;
+
+#define ofi_reduce_write_handler(op, datatype, dst, src, cnt) \
+	ofi_reduce_write_handlers[op][datatype](dst, src, cnt)
+#define ofi_reduce_readwrite_handler(op, datatype, dst, src, res, cnt) \
+	ofi_reduce_readwrite_handlers[op][datatype](dst, src, res, cnt)
+
+int ofi_reduce_select(const char *isa);
+
 int ofi_atomic_valid(const struct fi_provider *prov,
 		     enum fi_datatype datatype, enum fi_op op, uint64_t flags);
 
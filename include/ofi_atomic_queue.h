@@ -86,6 +86,7 @@
  *     . if the entry is a no-op it will be released and another entry
  *       will be fetched off the queue.
  *  . Call _release() after reader is done with the entry
+ *  . _isempty() checks whether an entry is ready without reading it
  */
 
 #ifdef __cplusplus
@@ -219,6 +220,16 @@ again:								\
 	}							\
 	return FI_SUCCESS;					\
 }								\
+static inline bool name ## _isempty(struct name *aq)		\
+{								\
+	struct name ## _entry *ce;				\
+	int64_t pos;						\
+	pos = ofi_atomic_load_explicit64(&aq->read_pos,		\
+			memory_order_relaxed);			\
+	ce = &aq->entry[pos & aq->size_mask];			\
+	return ofi_atomic_load_explicit64(&ce->seq,		\
+			memory_order_acquire) != pos + 1;	\
+}								\
 static inline void name ## _commit(entrytype *buf,		\
 				int64_t pos)			\
 {								\
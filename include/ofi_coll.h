@@ -50,6 +50,10 @@ enum util_coll_op_type {
 	UTIL_COLL_BROADCAST_OP,
 	UTIL_COLL_ALLGATHER_OP,
 	UTIL_COLL_SCATTER_OP,
+	UTIL_COLL_REDUCE_OP,
+	UTIL_COLL_REDUCE_SCATTER_OP,
+	UTIL_COLL_ALLTOALL_OP,
+	UTIL_COLL_GATHER_OP,
 };
 
 static const char * const log_util_coll_op_type[] = {
@@ -58,7 +62,11 @@ static const char * const log_util_coll_op_type[] = {
 	[UTIL_COLL_ALLREDUCE_OP] = "COLL_ALLREDUCE",
 	[UTIL_COLL_BROADCAST_OP] = "COLL_BROADCAST",
 	[UTIL_COLL_ALLGATHER_OP] = "COLL_ALLGATHER",
-	[UTIL_COLL_SCATTER_OP] = "COLL_SCATTER"
+	[UTIL_COLL_SCATTER_OP] = "COLL_SCATTER",
+	[UTIL_COLL_REDUCE_OP] = "COLL_REDUCE",
+	[UTIL_COLL_REDUCE_SCATTER_OP] = "COLL_REDUCE_SCATTER",
+	[UTIL_COLL_ALLTOALL_OP] = "COLL_ALLTOALL",
+	[UTIL_COLL_GATHER_OP] = "COLL_GATHER"
 };
 
 enum coll_work_type {
@@ -118,10 +126,26 @@ struct util_coll_reduce_item {
 	enum fi_op			op;
 };
 
+/*
+ * Placement of the ranks of a collective group on nodes.  The ranks of
+ * node n are ranks[node_start[n]] to ranks[node_start[n + 1] - 1], in
+ * ascending order; the first of them is the node leader.
+ */
+struct util_coll_node_map {
+	size_t		num_nodes;
+	size_t		node;		/* node of the local rank */
+	uint64_t	*ranks;
+	size_t		*node_start;
+	size_t		*rank_node;	/* node of each rank */
+	uint64_t	*leaders;
+};
+
 struct join_data {
 	struct util_coll_mc *new_mc;
 	struct ofi_bitmask data;
 	struct ofi_bitmask tmp;
+	uint64_t node_id;
+	uint64_t *node_ids;
 };
 
 struct barrier_data {
@@ -138,6 +162,7 @@ struct broadcast_data {
 	void	*chunk;
 	size_t	size;
 	void	*scatter;
+	uint64_t *leaders;
 };
 
 struct util_coll_operation;
@@ -157,6 +182,8 @@ struct util_coll_operation {
 		struct allreduce_data	allreduce;
 		void			*scatter;
 		struct broadcast_data	broadcast;
+		struct allreduce_data	reduce;
+		void			*gather;
 	} data;
 	util_coll_comp_fn_t		comp_fn;
 	uint64_t			flags;
@@ -328,9 +328,20 @@ enum {
 	OFI_BUFPOOL_HUGEPAGES		= 1 << 3,
 	OFI_BUFPOOL_NONSHARED		= 1 << 4,
 	OFI_BUFPOOL_NO_ZERO		= 1 << 5,
+	OFI_BUFPOOL_THREAD_CACHE	= 1 << 6,
+	OFI_BUFPOOL_NUMA_LOCAL		= 1 << 7,
 };
 
+/*
+ * OFI_BUFPOOL_NUMA_LOCAL implies OFI_BUFPOOL_NONSHARED once a region is at
+ * least a page: every region becomes its own page rounded mmap, bound to
+ * the growing thread's node before first touch.  Each grow then costs an
+ * mmap and an mbind call plus up to a page of slack.  Pools with smaller
+ * regions stay on the heap and are not bound.
+ */
+
 struct ofi_bufpool_region;
+struct ofi_bufpool_hdr;
 
 struct ofi_bufpool_attr {
 	size_t 		size;
@@ -342,6 +353,20 @@ struct ofi_bufpool_attr {
 	void		(*init_fn)(struct ofi_bufpool_region *region, void *buf);
 	void 		*context;
 	int		flags;
+	/* per thread cache depth for OFI_BUFPOOL_THREAD_CACHE, 0 for default */
+	size_t		cache_depth;
+};
+
+/*
+ * With OFI_BUFPOOL_THREAD_CACHE, each thread allocates from and frees to
+ * a magazine selected by a thread index.  Magazines are refilled from and
+ * flushed to the shared free list in batches of half their depth, so the
+ * pool lock is only taken once per batch.
+ */
+struct ofi_bufpool_mag {
+	ofi_spin_t			lock;
+	size_t				cnt;
+	struct ofi_bufpool_hdr		**bufs;
 };
 
 struct ofi_bufpool {
@@ -358,6 +383,10 @@ struct ofi_bufpool {
 	size_t				alloc_size;
 	size_t				region_size;
 	struct ofi_bufpool_attr		attr;
+
+	/* OFI_BUFPOOL_THREAD_CACHE only, protects the fields above */
+	ofi_spin_t			lock;
+	struct ofi_bufpool_mag		*mags;
 };
 
 struct ofi_bufpool_region {
@@ -409,6 +438,10 @@ ofi_bufpool_create(struct ofi_bufpool **buf_pool,
 void ofi_bufpool_destroy(struct ofi_bufpool *pool);
 
 int ofi_bufpool_grow(struct ofi_bufpool *pool);
+size_t ofi_bufpool_shrink(struct ofi_bufpool *pool);
+
+void *ofi_buf_alloc_cached(struct ofi_bufpool *pool);
+void ofi_buf_free_cached(struct ofi_bufpool *pool, void *buf);
 
 static inline struct ofi_bufpool_hdr *ofi_buf_hdr(void *buf)
 {
@@ -460,6 +493,11 @@ static inline void ofi_buf_free(void *buf)
 	assert(ofi_buf_hdr(buf)->ftr->magic == OFI_MAGIC_SIZE_T);
 	assert(ofi_buf_is_valid(buf));
 
+	if (ofi_buf_pool(buf)->attr.flags & OFI_BUFPOOL_THREAD_CACHE) {
+		ofi_buf_free_cached(ofi_buf_pool(buf), buf);
+		return;
+	}
+
 	slist_insert_head(&ofi_buf_hdr(buf)->entry.slist,
 			  &ofi_buf_pool(buf)->free_list.entries);
 }
@@ -522,6 +560,9 @@ static inline void *ofi_buf_alloc(struct ofi_bufpool *pool)
 	struct ofi_bufpool_hdr *buf_hdr;
 
 	assert(!(pool->attr.flags & OFI_BUFPOOL_INDEXED));
+	if (pool->attr.flags & OFI_BUFPOOL_THREAD_CACHE)
+		return ofi_buf_alloc_cached(pool);
+
 	if (ofi_bufpool_empty(pool)) {
 		if (ofi_bufpool_grow(pool))
 			return NULL;
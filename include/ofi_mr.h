@@ -408,6 +408,14 @@ struct ofi_mr_cache {
 	struct dlist_entry		dead_region_list;
 	pthread_mutex_t			lock;
 
+	/* Protects the tree, lists and statistics.  Taken after mm_lock when
+	 * both are needed.  The generation is bumped whenever an entry leaves
+	 * the tree and validates per-thread hits, which may take a reference
+	 * without the lock.
+	 */
+	pthread_mutex_t			tree_lock;
+	uint64_t			gen;
+
 	size_t				cached_cnt;
 	size_t				cached_size;
 	size_t				cached_max_cnt;
@@ -134,6 +134,67 @@ static inline int ofi_sendall_socket(SOCKET sock, const void *buf, size_t len)
 
 ssize_t ofi_discard_socket(SOCKET sock, size_t len);
 
+/*
+ * Batched datagram I/O.  Platforms without recvmmsg/sendmmsg fall back to
+ * one recvmsg/sendmsg call per message, with the same return semantics:
+ * the number of messages transferred, or -1 with errno set if the first
+ * message failed.
+ */
+#if HAVE_RECVMMSG && HAVE_SENDMMSG
+#define ofi_mmsghdr mmsghdr
+
+static inline int
+ofi_recvmmsg_udp(SOCKET fd, struct ofi_mmsghdr *msgvec, unsigned int vlen,
+		 int flags)
+{
+	return recvmmsg(fd, msgvec, vlen, flags, NULL);
+}
+
+static inline int
+ofi_sendmmsg_udp(SOCKET fd, struct ofi_mmsghdr *msgvec, unsigned int vlen,
+		 int flags)
+{
+	return sendmmsg(fd, msgvec, vlen, flags);
+}
+#else
+struct ofi_mmsghdr {
+	struct msghdr	msg_hdr;
+	unsigned int	msg_len;
+};
+
+static inline int
+ofi_recvmmsg_udp(SOCKET fd, struct ofi_mmsghdr *msgvec, unsigned int vlen,
+		 int flags)
+{
+	unsigned int i;
+	ssize_t ret;
+
+	for (i = 0; i < vlen; i++) {
+		ret = ofi_recvmsg_udp(fd, &msgvec[i].msg_hdr, flags);
+		if (ret < 0)
+			return i ? (int) i : -1;
+		msgvec[i].msg_len = (unsigned int) ret;
+	}
+	return (int) i;
+}
+
+static inline int
+ofi_sendmmsg_udp(SOCKET fd, struct ofi_mmsghdr *msgvec, unsigned int vlen,
+		 int flags)
+{
+	unsigned int i;
+	ssize_t ret;
+
+	for (i = 0; i < vlen; i++) {
+		ret = ofi_sendmsg_udp(fd, &msgvec[i].msg_hdr, flags);
+		if (ret < 0)
+			return i ? (int) i : -1;
+		msgvec[i].msg_len = (unsigned int) ret;
+	}
+	return (int) i;
+}
+#endif
+
 /*
  * Socket API
  */
@@ -154,9 +215,24 @@ struct ofi_sockctx {
 	bool uring_sqe_inuse;
 };
 
+/* Buffer group id and maximum number of provided receive buffers */
+#define OFI_URING_PBUF_GROUP	0
+#define OFI_URING_PBUF_CNT	64
+
 struct ofi_sockapi_uring {
 	ofi_io_uring_t *io_uring;
 	uint64_t credits;
+
+	/* Provided buffer ring consumed by multishot receives */
+	void *pbuf_ring;
+	uint8_t *pbuf_data;
+	size_t pbuf_size;
+	unsigned int pbuf_cnt;
+	bool mshot;
+
+	/* Free slots of the sparse registered (fixed) buffer table */
+	int *fixed_free;
+	int fixed_free_cnt;
 };
 
 struct ofi_sockapi {
@@ -180,6 +256,16 @@ struct ofi_sockapi {
 	ssize_t (*recvv)(struct ofi_sockapi *sockapi, SOCKET sock,
 			 struct iovec *iov, size_t cnt, int flags,
 			 struct ofi_sockctx *ctx);
+
+	/* io_uring only: registered buffers and provided buffer receives */
+	ssize_t (*send_fixed)(struct ofi_sockapi *sockapi, SOCKET sock,
+			      const void *buf, size_t len, int buf_index,
+			      struct ofi_sockctx *ctx);
+	ssize_t (*recv_fixed)(struct ofi_sockapi *sockapi, SOCKET sock,
+			      void *buf, size_t len, int buf_index,
+			      struct ofi_sockctx *ctx);
+	int (*recv_multishot)(struct ofi_sockapi *sockapi, SOCKET sock,
+			      struct ofi_sockctx *ctx);
 };
 
 static inline void
@@ -314,6 +400,15 @@ ssize_t ofi_sockapi_recvv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 				struct iovec *iov, size_t cnt, int flags,
 				struct ofi_sockctx *ctx);
 
+ssize_t ofi_sockapi_send_fixed_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     const void *buf, size_t len, int buf_index,
+				     struct ofi_sockctx *ctx);
+ssize_t ofi_sockapi_recv_fixed_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     void *buf, size_t len, int buf_index,
+				     struct ofi_sockctx *ctx);
+int ofi_sockapi_recv_multishot_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     struct ofi_sockctx *ctx);
+
 int ofi_sockctx_uring_cancel(struct ofi_sockapi_uring *uring,
 			     struct ofi_sockctx *canceled_ctx,
 			     struct ofi_sockctx *ctx);
@@ -325,6 +420,16 @@ int ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 int ofi_uring_init(ofi_io_uring_t *io_uring, size_t entries);
 int ofi_uring_destroy(ofi_io_uring_t *io_uring);
 
+int ofi_uring_pbuf_init(struct ofi_sockapi_uring *uring, unsigned int cnt,
+			size_t size);
+void ofi_uring_pbuf_cleanup(struct ofi_sockapi_uring *uring);
+void ofi_uring_pbuf_recycle(struct ofi_sockapi_uring *uring, uint16_t bid);
+
+int ofi_uring_fixed_init(struct ofi_sockapi_uring *uring, unsigned int cnt);
+void ofi_uring_fixed_cleanup(struct ofi_sockapi_uring *uring);
+int ofi_uring_fixed_add(struct ofi_sockapi_uring *uring, void *buf, size_t len);
+void ofi_uring_fixed_del(struct ofi_sockapi_uring *uring, int index);
+
 static inline int ofi_uring_get_fd(ofi_io_uring_t *io_uring)
 {
 	return io_uring->ring_fd;
@@ -362,7 +467,9 @@ static inline void ofi_uring_cq_advance(ofi_io_uring_t *io_uring, unsigned int c
 	io_uring_cq_advance(io_uring, count);
 }
 #else
+#define IORING_CQE_F_BUFFER	(1U << 0)
 #define IORING_CQE_F_MORE	(1U << 1)
+#define IORING_CQE_BUFFER_SHIFT	16
 
 static inline int
 ofi_sockapi_connect_uring(struct ofi_sockapi *sockapi, SOCKET sock,
@@ -410,6 +517,28 @@ ofi_sockapi_recvv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 	return -FI_ENOSYS;
 }
 
+static inline ssize_t
+ofi_sockapi_send_fixed_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+			     const void *buf, size_t len, int buf_index,
+			     struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
+
+static inline ssize_t
+ofi_sockapi_recv_fixed_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+			     void *buf, size_t len, int buf_index,
+			     struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
+
+static inline int
+ofi_sockapi_recv_multishot_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				 struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
 
 static inline int
 ofi_sockctx_uring_cancel(struct ofi_sockapi_uring *uring,
@@ -436,6 +565,43 @@ ofi_sockctx_uring_poll_add(struct ofi_sockapi_uring *uring,
 #define ofi_uring_submit(io_uring) -FI_ENOSYS
 #define ofi_uring_peek_batch_cqe(io_uring, cqes, count) 0
 #define ofi_uring_cq_advance(io_uring, count) do {} while(0)
+
+static inline int
+ofi_uring_pbuf_init(struct ofi_sockapi_uring *uring, unsigned int cnt,
+		    size_t size)
+{
+	return -FI_ENOSYS;
+}
+
+static inline void ofi_uring_pbuf_cleanup(struct ofi_sockapi_uring *uring)
+{
+}
+
+static inline void
+ofi_uring_pbuf_recycle(struct ofi_sockapi_uring *uring, uint16_t bid)
+{
+}
+
+static inline int
+ofi_uring_fixed_init(struct ofi_sockapi_uring *uring, unsigned int cnt)
+{
+	return -FI_ENOSYS;
+}
+
+static inline void ofi_uring_fixed_cleanup(struct ofi_sockapi_uring *uring)
+{
+}
+
+static inline int
+ofi_uring_fixed_add(struct ofi_sockapi_uring *uring, void *buf, size_t len)
+{
+	return -FI_ENOSYS;
+}
+
+static inline void
+ofi_uring_fixed_del(struct ofi_sockapi_uring *uring, int index)
+{
+}
 #endif
 
 /*
@@ -530,18 +696,38 @@ size_t ofi_byteq_readv(struct ofi_byteq *byteq, struct iovec *iov,
 /*
  * Buffered socket - socket with send/receive staging buffers.
  */
+/* Received data held in a provided buffer of the rx io_uring */
+struct ofi_bsock_pbuf {
+	uint16_t bid;
+	uint32_t off;
+	uint32_t len;
+};
+
 struct ofi_bsock {
 	SOCKET sock;
 	struct ofi_sockapi *sockapi;
 	struct ofi_sockctx tx_sockctx;
 	struct ofi_sockctx rx_sockctx;
 	struct ofi_sockctx pollin_sockctx;
+	struct ofi_sockctx mshot_sockctx;
+	struct ofi_sockctx cancel_sockctx;
 	struct ofi_byteq sq;
 	struct ofi_byteq rq;
 	size_t zerocopy_size;
 	uint32_t async_index;
 	uint32_t done_index;
 	bool async_prefetch;
+	bool mshot_nobufs;
+
+	/* Registered buffer index of sq and rq, -1 if not registered */
+	int sq_fixed;
+	int rq_fixed;
+
+	/* Multishot receive data, consumed after rq */
+	size_t pbuf_bytes;
+	unsigned int pbuf_head;
+	unsigned int pbuf_cnt;
+	struct ofi_bsock_pbuf pbufs[OFI_URING_PBUF_CNT];
 };
 
 static inline void
@@ -553,25 +739,37 @@ ofi_bsock_init(struct ofi_bsock *bsock, struct ofi_sockapi *sockapi,
 	ofi_sockctx_init(&bsock->tx_sockctx, context);
 	ofi_sockctx_init(&bsock->rx_sockctx, context);
 	ofi_sockctx_init(&bsock->pollin_sockctx, context);
+	ofi_sockctx_init(&bsock->mshot_sockctx, context);
+	ofi_sockctx_init(&bsock->cancel_sockctx, context);
 	ofi_byteq_init(&bsock->sq, sbuf_size);
 	ofi_byteq_init(&bsock->rq, rbuf_size);
 	bsock->zerocopy_size = SIZE_MAX;
 	bsock->async_prefetch = false;
+	bsock->mshot_nobufs = false;
+	bsock->sq_fixed = -1;
+	bsock->rq_fixed = -1;
+	bsock->pbuf_bytes = 0;
+	bsock->pbuf_head = 0;
+	bsock->pbuf_cnt = 0;
 
 	/* first async op will wrap back to 0 as the starting index */
 	bsock->async_index = UINT32_MAX;
 	bsock->done_index = UINT32_MAX;
 }
 
+void ofi_bsock_pbuf_release(struct ofi_bsock *bsock);
+
 static inline void ofi_bsock_discard(struct ofi_bsock *bsock)
 {
 	ofi_byteq_discard(&bsock->rq);
 	ofi_byteq_discard(&bsock->sq);
+	if (bsock->pbuf_cnt)
+		ofi_bsock_pbuf_release(bsock);
 }
 
 static inline size_t ofi_bsock_readable(struct ofi_bsock *bsock)
 {
-	return ofi_byteq_readable(&bsock->rq);
+	return ofi_byteq_readable(&bsock->rq) + bsock->pbuf_bytes;
 }
 
 static inline size_t ofi_bsock_tosend(struct ofi_bsock *bsock)
@@ -609,6 +807,9 @@ int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov,
 int ofi_bsock_async_done(const struct fi_provider *prov,
 			 struct ofi_bsock *bsock);
 void ofi_bsock_prefetch_done(struct ofi_bsock *bsock, size_t len);
+int ofi_bsock_mshot_done(struct ofi_bsock *bsock, int res, uint32_t flags);
+void ofi_bsock_reg_fixed(struct ofi_bsock *bsock);
+void ofi_bsock_dereg_fixed(struct ofi_bsock *bsock);
 
 
 /*
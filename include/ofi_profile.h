@@ -183,6 +183,9 @@ ofi_prof_read_u64(struct util_profile *prof, int idx,
 
 	if (prof->data_cached) {
 		*val64 = prof->data[idx].value.u64;
+	} else if (!prof->vars[idx]) {
+		/* described, but not backed by the provider */
+		*val64 = 0;
 	} else if (prof->varlist[idx].datatype_sel == fi_primitive_type) {
 		*val64 = ofi_var_data_u64(prof->vars[idx],
 					  prof->varlist[idx].datatype.primitive);
@@ -40,6 +40,7 @@
 #endif /* HAVE_CONFIG_H */
 
 #include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 
 #include <rdma/fabric.h>
@@ -321,6 +322,47 @@ int ofi_endpoint_init(struct fid_domain *domain, const struct util_prov *util_pr
 
 int ofi_endpoint_close(struct util_ep *util_ep);
 
+/*
+ * Background connection set-up for connectionless endpoints built over
+ * connections (see FI_CONN_WARMUP_OPS). The provider supplies a connect
+ * function that starts or checks a connection without driving progress,
+ * returning 0 once connected, -FI_EAGAIN while pending, or an error.
+ * ofi_conn_warmup_progress() is called from the provider's connection
+ * progress, under the lock protecting its connection state, and returns
+ * true once the completion event has been written.
+ */
+typedef ssize_t (*ofi_conn_warmup_func)(struct util_ep *ep, fi_addr_t addr);
+
+struct util_conn_warmup_slot {
+	fi_addr_t		addr;
+	uint64_t		endtime;
+};
+
+struct util_conn_warmup {
+	struct dlist_entry	entry;
+	struct util_ep		*ep;
+	ofi_conn_warmup_func	connect;
+	void			*context;
+	int			timeout;
+	int			err;
+
+	fi_addr_t		*addr;
+	size_t			count;
+	size_t			next;
+	size_t			done;
+	size_t			connected;
+
+	size_t			slot_cnt;
+	struct util_conn_warmup_slot slot[];
+};
+
+int ofi_conn_warmup_init(struct util_ep *ep, ofi_conn_warmup_func connect,
+			 const fi_addr_t *addr, size_t count,
+			 size_t max_inflight, int timeout, void *context,
+			 struct util_conn_warmup **warmup);
+bool ofi_conn_warmup_progress(struct util_conn_warmup *warmup);
+void ofi_conn_warmup_free(struct util_conn_warmup *warmup);
+
 static inline int
 ofi_ep_fid_bind(struct fid *ep_fid, struct fid *bfid, uint64_t flags)
 {
@@ -498,6 +540,46 @@ struct util_cq_aux_entry {
 
 OFI_DECLARE_CIRQUE(struct fi_cq_tagged_entry, util_comp_cirq);
 
+/* Lock-free completion ring placed in front of the cirq when completions
+ * are written by a different thread than the one reading them.  Writers
+ * reserve slots and publish them by advancing tail, the reader consumes
+ * under cq_lock and returns the slots by advancing head once per batch.
+ * Completions that do not fit, and errors, go to the cirq and aux_queue;
+ * writers then stay on the locked path until the reader has drained it,
+ * so completions are not reordered.
+ */
+enum util_cq_ring_type {
+	UTIL_CQ_RING_NONE,
+	UTIL_CQ_RING_SPSC,
+	UTIL_CQ_RING_MPSC,
+};
+
+#ifndef OFI_CACHE_LINE_SIZE
+#define OFI_CACHE_LINE_SIZE (64)
+#endif
+
+struct util_cq_ring_entry {
+	struct fi_cq_tagged_entry	comp;
+	fi_addr_t			src;
+};
+
+struct util_cq_ring {
+	/* MPSC only: next slot handed out to a writer */
+	ofi_atomic64_t		reserve;
+	uint8_t			pad0[OFI_CACHE_LINE_SIZE -
+				     sizeof(ofi_atomic64_t)];
+	ofi_atomic64_t		tail;
+	uint8_t			pad1[OFI_CACHE_LINE_SIZE -
+				     sizeof(ofi_atomic64_t)];
+	ofi_atomic64_t		head;
+	uint8_t			pad2[OFI_CACHE_LINE_SIZE -
+				     sizeof(ofi_atomic64_t)];
+	enum util_cq_ring_type	type;
+	int64_t			size;
+	int64_t			size_mask;
+	struct util_cq_ring_entry entry[];
+};
+
 typedef void (*ofi_cq_progress_func)(struct util_cq *cq);
 
 struct util_cq {
@@ -526,6 +608,10 @@ struct util_cq {
 	fi_addr_t		*src;
 	struct slist		aux_queue;
 	fi_cq_read_func		read_entry;
+
+	/* Optional, see struct util_cq_ring */
+	struct util_cq_ring	*ring;
+	ofi_atomic32_t		ring_spill;
 };
 
 int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
@@ -553,6 +639,112 @@ const char *ofi_cq_strerror(struct fid_cq *cq, int prov_errno,
 int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 			  size_t len, void *buf, uint64_t data, uint64_t tag,
 			  fi_addr_t src);
+/* Queue an error completion, caller must hold the cq_lock */
+int ofi_cq_insert_error(struct util_cq *cq,
+			const struct fi_cq_err_entry *err_entry);
+int ofi_cq_init_ring(struct util_cq *cq, enum util_cq_ring_type type);
+
+/* Reserve cnt consecutive slots.  The caller fills in util_cq_ring_entry()
+ * for each of them and makes them visible with a single publish call.
+ */
+static inline int
+util_cq_ring_reserve(struct util_cq_ring *ring, size_t cnt, int64_t *pos)
+{
+	int64_t head;
+
+	if (ring->type == UTIL_CQ_RING_SPSC) {
+		*pos = ofi_atomic_load_explicit64(&ring->tail,
+						  memory_order_relaxed);
+		head = ofi_atomic_load_explicit64(&ring->head,
+						  memory_order_acquire);
+		return *pos + (int64_t) cnt - head > ring->size ?
+		       -FI_EAGAIN : 0;
+	}
+
+	for (;;) {
+		*pos = ofi_atomic_load_explicit64(&ring->reserve,
+						  memory_order_relaxed);
+		head = ofi_atomic_load_explicit64(&ring->head,
+						  memory_order_acquire);
+		if (*pos + (int64_t) cnt - head > ring->size)
+			return -FI_EAGAIN;
+		if (ofi_atomic_cas_bool_weak64(&ring->reserve, *pos,
+					       *pos + cnt))
+			return 0;
+	}
+}
+
+static inline struct util_cq_ring_entry *
+util_cq_ring_entry(struct util_cq_ring *ring, int64_t pos)
+{
+	return &ring->entry[pos & ring->size_mask];
+}
+
+static inline void
+util_cq_ring_publish(struct util_cq_ring *ring, int64_t pos, size_t cnt)
+{
+	unsigned int spin = 0;
+
+	/* MPSC writers publish in reservation order.  Yield now and then in
+	 * case the writer ahead of us was preempted.
+	 */
+	if (ring->type == UTIL_CQ_RING_MPSC) {
+		while (ofi_atomic_load_explicit64(&ring->tail,
+						  memory_order_acquire) != pos) {
+			if (!(++spin % 64))
+				sched_yield();
+		}
+	}
+	ofi_atomic_store_explicit64(&ring->tail, pos + cnt,
+				    memory_order_release);
+}
+
+static inline bool util_cq_ring_isempty(struct util_cq_ring *ring)
+{
+	return ofi_atomic_load_explicit64(&ring->tail, memory_order_acquire) ==
+	       ofi_atomic_load_explicit64(&ring->head, memory_order_relaxed);
+}
+
+/* Called with cq_lock held */
+static inline ssize_t
+util_cq_ring_read(struct util_cq *cq, void **buf, size_t count,
+		  fi_addr_t *src_addr)
+{
+	struct util_cq_ring_entry *entry;
+	int64_t head, tail;
+	size_t i;
+
+	head = ofi_atomic_load_explicit64(&cq->ring->head, memory_order_relaxed);
+	tail = ofi_atomic_load_explicit64(&cq->ring->tail, memory_order_acquire);
+	if (count > (size_t) (tail - head))
+		count = (size_t) (tail - head);
+
+	for (i = 0; i < count; i++) {
+		entry = util_cq_ring_entry(cq->ring, head + i);
+		if (src_addr)
+			src_addr[i] = cq->src ? entry->src : FI_ADDR_NOTAVAIL;
+		cq->read_entry(buf, &entry->comp);
+	}
+
+	if (count)
+		ofi_atomic_store_explicit64(&cq->ring->head, head + count,
+					    memory_order_release);
+	return count;
+}
+
+/* Writers may return to the ring once the locked queue is empty */
+static inline void util_cq_ring_check_spill(struct util_cq *cq)
+{
+	if (cq->ring && ofi_cirque_isempty(cq->cirq))
+		ofi_atomic_store_explicit32(&cq->ring_spill, 0,
+					    memory_order_release);
+}
+
+static inline bool ofi_cq_isempty(struct util_cq *cq)
+{
+	return ofi_cirque_isempty(cq->cirq) &&
+	       (!cq->ring || util_cq_ring_isempty(cq->ring));
+}
 
 static inline
 ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
@@ -569,15 +761,21 @@ ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
 		cq->err_data = NULL;
 	}
 
+	/* Ring entries are older than anything in the cirq */
+	i = cq->ring ? util_cq_ring_read(cq, &buf, count, src_addr) : 0;
+	if (i == (ssize_t) count)
+		goto out;
+
 	if (ofi_cirque_isempty(cq->cirq)) {
-		i = -FI_EAGAIN;
+		if (!i)
+			i = -FI_EAGAIN;
 		goto out;
 	}
 
-	if (count > ofi_cirque_usedcnt(cq->cirq))
-		count = ofi_cirque_usedcnt(cq->cirq);
+	if (count - i > ofi_cirque_usedcnt(cq->cirq))
+		count = i + ofi_cirque_usedcnt(cq->cirq);
 
-	for (i = 0; i < (ssize_t) count; i++) {
+	for (; i < (ssize_t) count; i++) {
 		entry = ofi_cirque_head(cq->cirq);
 		if (!(entry->flags & UTIL_FLAG_AUX)) {
 			if (src_addr)
@@ -615,6 +813,7 @@ ssize_t ofi_cq_read_entries(struct util_cq *cq, void *buf, size_t count,
 			}
 		}
 	}
+	util_cq_ring_check_spill(cq);
 out:
 	ofi_genlock_unlock(&cq->cq_lock);
 	return i;
@@ -632,6 +831,9 @@ ofi_cq_write_entry(struct util_cq *cq, void *context, uint64_t flags,
 	comp->data = data;
 	comp->tag = tag;
 	ofi_cirque_commit(cq->cirq);
+	if (cq->ring)
+		ofi_atomic_store_explicit32(&cq->ring_spill, 1,
+					    memory_order_relaxed);
 }
 
 static inline void
@@ -643,12 +845,40 @@ ofi_cq_write_src_entry(struct util_cq *cq, void *context, uint64_t flags,
 	ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
 }
 
+static inline int
+ofi_cq_ring_write(struct util_cq *cq, void *context, uint64_t flags,
+		  size_t len, void *buf, uint64_t data, uint64_t tag,
+		  fi_addr_t src)
+{
+	struct util_cq_ring_entry *entry;
+	int64_t pos;
+
+	if (ofi_atomic_load_explicit32(&cq->ring_spill, memory_order_acquire) ||
+	    util_cq_ring_reserve(cq->ring, 1, &pos))
+		return -FI_EAGAIN;
+
+	entry = util_cq_ring_entry(cq->ring, pos);
+	entry->comp.op_context = context;
+	entry->comp.flags = flags;
+	entry->comp.len = len;
+	entry->comp.buf = buf;
+	entry->comp.data = data;
+	entry->comp.tag = tag;
+	entry->src = src;
+	util_cq_ring_publish(cq->ring, pos, 1);
+	return 0;
+}
+
 static inline int
 ofi_cq_write(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 	     void *buf, uint64_t data, uint64_t tag)
 {
 	int ret;
 
+	if (cq->ring && !ofi_cq_ring_write(cq, context, flags, len, buf,
+					   data, tag, FI_ADDR_NOTAVAIL))
+		return 0;
+
 	ofi_genlock_lock(&cq->cq_lock);
 	if (ofi_cirque_freecnt(cq->cirq) > 1) {
 		ofi_cq_write_entry(cq, context, flags, len, buf, data, tag);
@@ -667,6 +897,10 @@ ofi_cq_write_src(struct util_cq *cq, void *context, uint64_t flags, size_t len,
 {
 	int ret;
 
+	if (cq->ring && !ofi_cq_ring_write(cq, context, flags, len, buf,
+					   data, tag, src))
+		return 0;
+
 	ofi_genlock_lock(&cq->cq_lock);
 	if (ofi_cirque_freecnt(cq->cirq) > 1) {
 		ofi_cq_write_src_entry(cq, context, flags, len, buf, data,
@@ -845,6 +1079,7 @@ static inline void ofi_ep_peer_rx_cntr_incerr(struct util_ep *ep, uint8_t op)
 struct util_av;
 struct util_av_set;
 struct util_peer_addr;
+struct util_coll_node_map;
 
 struct util_coll_mc {
 	struct fid_mc		mc_fid;
@@ -853,6 +1088,7 @@ struct util_coll_mc {
 	uint16_t		group_id;
 	uint16_t		seq;
 	ofi_atomic32_t		ref;
+	struct util_coll_node_map *node_map;
 };
 
 struct util_av_set {
@@ -905,6 +1141,8 @@ struct util_av {
 };
 
 #define OFI_AV_DYN_ADDRLEN (1 << 0)
+/* reverse lookup hash not built yet, see ofi_av_lookup_fi_addr */
+#define OFI_AV_LAZY_HASH (1 << 1)
 
 struct util_av_attr {
 	/* Must be a multiple of 8 bytes */
@@ -1306,6 +1544,8 @@ struct util_rx_entry {
 		struct dlist_entry	d_entry;
 		struct slist_entry	s_entry;
 	};
+	/* links fully specified tags into a util_tag_hash bucket */
+	struct dlist_entry	h_entry;
 	struct fi_peer_rx_entry	peer_entry;
 	uint64_t		seq_no;
 	uint64_t		ignore;
@@ -1326,11 +1566,24 @@ typedef void(*ofi_update_func_t)(struct util_srx_ctx *srx,
 
 struct util_unexp_peer {
 	struct dlist_entry	entry;
-	struct slist		msg_queue;
-	struct slist		tag_queue;
+	struct dlist_entry	msg_queue;
+	struct dlist_entry	tag_queue;
 	int			cnt;
 };
 
+/* Hash of rx entries with fully specified tags (ignore == 0).  Entries
+ * that hash to the same bucket are kept in insertion order, so the first
+ * match in a bucket is also the oldest one.  Posted receives are keyed by
+ * tag and source address, unexpected messages by tag only so that their
+ * source may be resolved after they are queued.
+ */
+struct util_tag_hash {
+	struct dlist_entry	*buckets;
+	size_t			size;
+	size_t			cnt;
+	bool			by_src;
+};
+
 struct util_srx_ctx {
 	struct fid_peer_srx	peer_srx;
 	bool			dir_recv;
@@ -1344,12 +1597,16 @@ struct util_srx_ctx {
 
 	uint64_t		rx_seq_no;
 	struct slist		msg_queue;
+	/* tag_queue and src_trecv_queues only hold wildcard (ignore != 0)
+	 * tagged receives, all others are kept in tag_hash */
 	struct slist		tag_queue;
 	struct ofi_dyn_arr	src_recv_queues;
 	struct ofi_dyn_arr	src_trecv_queues;
+	struct util_tag_hash	tag_hash;
 
 	struct dlist_entry	unspec_unexp_msg_queue;
 	struct dlist_entry	unspec_unexp_tag_queue;
+	struct util_tag_hash	unexp_tag_hash;
 
 	struct dlist_entry	unexp_peers;
 	struct ofi_dyn_arr	src_unexp_peers;
@@ -94,6 +94,19 @@ static inline int ofi_alloc_hugepage_buf(void **memptr, size_t size)
 	return -FI_ENOSYS;
 }
 
+#define OFI_MPOL_PREFERRED 1
+#define OFI_MPOL_BIND 2
+
+static inline int ofi_mbind_node(void *addr, size_t len, int node, int mode)
+{
+	return -FI_ENOSYS;
+}
+
+static inline int ofi_mbind_local(void *addr, size_t len)
+{
+	return -FI_ENOSYS;
+}
+
 static inline size_t ofi_ifaddr_get_speed(struct ifaddrs *ifa)
 {
 	return 0;
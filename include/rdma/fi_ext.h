@@ -185,6 +185,45 @@ static inline int fi_import_log(uint32_t version, uint64_t flags,
 			 log_fid);
 }
 
+
+/*
+ * Connection warm-up extension:
+ * Connectionless endpoints implemented over connections normally connect
+ * to a peer on the first transfer. warmup() starts connecting to the given
+ * peers in the background instead, keeping at most max_inflight attempts
+ * outstanding. An attempt that has not completed after timeout
+ * milliseconds fails (-1 waits forever).
+ *
+ * Once every peer has been handled, an FI_NOTIFY event is written to the
+ * EQ bound to the endpoint: a struct fi_eq_entry with fid set to the
+ * endpoint, the given context, and data holding the number of peers
+ * connected. If any peer failed, an error entry is written instead, with
+ * err set to the last error seen and data holding the number connected.
+ */
+#define FI_CONN_WARMUP_OPS "fi_conn_warmup_ops"
+
+struct fi_ops_conn_warmup {
+	size_t	size;
+	int	(*warmup)(struct fid_ep *ep, const fi_addr_t *addr,
+			  size_t count, size_t max_inflight, int timeout,
+			  void *context);
+};
+
+static inline int
+fi_conn_warmup(struct fid_ep *ep, const fi_addr_t *addr, size_t count,
+	       size_t max_inflight, int timeout, void *context)
+{
+	struct fi_ops_conn_warmup *ops;
+	int ret;
+
+	ret = fi_open_ops(&ep->fid, FI_CONN_WARMUP_OPS, 0, (void **) &ops,
+			  NULL);
+	if (ret)
+		return ret;
+
+	return ops->warmup(ep, addr, count, max_inflight, timeout, context);
+}
+
 #ifdef __cplusplus
 }
 #endif
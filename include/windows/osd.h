@@ -982,6 +982,19 @@ static inline int ofi_alloc_hugepage_buf(void **memptr, size_t size)
 	return -FI_ENOSYS;
 }
 
+#define OFI_MPOL_PREFERRED 1
+#define OFI_MPOL_BIND 2
+
+static inline int ofi_mbind_node(void *addr, size_t len, int node, int mode)
+{
+	return -FI_ENOSYS;
+}
+
+static inline int ofi_mbind_local(void *addr, size_t len)
+{
+	return -FI_ENOSYS;
+}
+
 static inline int ofi_hugepage_enabled(void)
 {
 	return 0;
@@ -1097,6 +1110,14 @@ OFI_DEF_COMPLEX(long_double)
 typedef LONG ofi_atomic_int_32_t;
 typedef LONGLONG ofi_atomic_int_64_t;
 
+/* Interlocked operations are full barriers, the model is ignored */
+#define memory_order_relaxed 0
+#define memory_order_consume 1
+#define memory_order_acquire 2
+#define memory_order_release 3
+#define memory_order_acq_rel 4
+#define memory_order_seq_cst 5
+
 #define ofi_atomic_add_and_fetch(radix, ptr, val) InterlockedAdd##radix((ofi_atomic_int_##radix##_t volatile *)(ptr), (ofi_atomic_int_##radix##_t)(val))
 #define ofi_atomic_sub_and_fetch(radix, ptr, val) InterlockedAdd##radix((ofi_atomic_int_##radix##_t volatile *)(ptr), -(ofi_atomic_int_##radix##_t)(val))
 #define ofi_atomic_cas_bool(radix, ptr, expected, desired)					\
@@ -72,6 +72,20 @@ enum {
 	COLL_TX_SIZE = 16384,
 };
 
+/*
+ * Crossover points between the latency and the bandwidth oriented
+ * algorithms and locality settings, see coll_init.c for their meaning.
+ */
+struct coll_env {
+	size_t allreduce_ring_size;
+	size_t bcast_tree_size;
+	size_t bcast_seg_size;
+	int hierarchical;
+	uint64_t node_id;
+};
+
+extern struct coll_env coll_env;
+
 struct coll_domain {
 	struct util_domain util_domain;
 	struct fid_domain *peer_domain;
@@ -175,5 +189,28 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 			  void *desc, fi_addr_t coll_addr, fi_addr_t root_addr,
 			  enum fi_datatype datatype, uint64_t flags,
 			  void *context);
+
+ssize_t coll_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, enum fi_op op,
+		       uint64_t flags, void *context);
+
+ssize_t coll_ep_reduce_scatter(struct fid_ep *ep, const void *buf,
+			       size_t count, void *desc, void *result,
+			       void *result_desc, fi_addr_t coll_addr,
+			       enum fi_datatype datatype, enum fi_op op,
+			       uint64_t flags, void *context);
+
+ssize_t coll_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			 void *desc, void *result, void *result_desc,
+			 fi_addr_t coll_addr, enum fi_datatype datatype,
+			 uint64_t flags, void *context);
+
+ssize_t coll_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, uint64_t flags,
+		       void *context);
 #endif /* _COLL_H_ */
 
@@ -341,11 +341,51 @@ static int coll_sched_comp(struct util_coll_operation *coll_op)
 	return FI_SUCCESS;
 }
 
+/*
+ * The members taking part in one phase of an algorithm.  Algorithms
+ * address members by index; ranks maps an index to a rank of the mc, or
+ * is NULL when the group is the whole mc.
+ */
+struct coll_group {
+	const uint64_t	*ranks;
+	size_t		size;
+	uint64_t	index;	/* of the local rank */
+};
+
+static inline uint64_t coll_group_rank(const struct coll_group *group,
+				       uint64_t index)
+{
+	return group->ranks ? group->ranks[index] : index;
+}
+
+static void coll_mc_group(struct util_coll_mc *coll_mc,
+			  struct coll_group *group)
+{
+	group->ranks = NULL;
+	group->size = coll_mc->av_set->fi_addr_count;
+	group->index = coll_mc->local_rank;
+}
+
+/* The members of the local node, the leader at index 0 */
+static void coll_node_group(struct util_coll_mc *coll_mc,
+			    struct coll_group *group)
+{
+	struct util_coll_node_map *map = coll_mc->node_map;
+	size_t start = map->node_start[map->node];
+
+	group->ranks = &map->ranks[start];
+	group->size = map->node_start[map->node + 1] - start;
+	for (group->index = 0; group->ranks[group->index] !=
+	     coll_mc->local_rank; group->index++)
+		;
+}
+
 /*
  * TODO:
  * when this fails, clean up the already scheduled work in this function
  */
 static int coll_do_allreduce(struct util_coll_operation *coll_op,
+			     const struct coll_group *group,
 			     const void *send_buf, void *result,
 			     void* tmp_buf, uint64_t count,
 			     enum fi_datatype datatype, enum fi_op op)
@@ -355,23 +395,26 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 	int ret;
 	uint64_t mask = 1;
 
-	pof2 = rounddown_power_of_two(coll_op->mc->av_set->fi_addr_count);
-	rem = coll_op->mc->av_set->fi_addr_count - pof2;
-	local = coll_op->mc->local_rank;
+	pof2 = rounddown_power_of_two(group->size);
+	rem = group->size - pof2;
+	local = group->index;
 
 	/* copy initial send data to result */
-	memcpy(result, send_buf, count * ofi_datatype_size(datatype));
+	if (send_buf != result)
+		memcpy(result, send_buf, count * ofi_datatype_size(datatype));
 
 	if (local < 2 * rem) {
 		if (local % 2 == 0) {
-			ret = coll_sched_send(coll_op, local + 1, result,
-					      count, datatype, 1);
+			ret = coll_sched_send(coll_op,
+					      coll_group_rank(group, local + 1),
+					      result, count, datatype, 1);
 			if (ret)
 				return ret;
 
 			my_new_id = (uint64_t)-1;
 		} else {
-			ret = coll_sched_recv(coll_op, local - 1,
+			ret = coll_sched_recv(coll_op,
+					      coll_group_rank(group, local - 1),
 					      tmp_buf, count, datatype, 1);
 			if (ret)
 				return ret;
@@ -394,14 +437,16 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 				next_remote + rem;
 
 			/* receive remote data into tmp buf */
-			ret = coll_sched_recv(coll_op, remote, tmp_buf,
-					      count, datatype, 0);
+			ret = coll_sched_recv(coll_op,
+					      coll_group_rank(group, remote),
+					      tmp_buf, count, datatype, 0);
 			if (ret)
 				return ret;
 
 			/* send result buf, which has the current total */
-			ret = coll_sched_send(coll_op, remote, result,
-					      count, datatype, 1);
+			ret = coll_sched_send(coll_op,
+					      coll_group_rank(group, remote),
+					      result, count, datatype, 1);
 			if (ret)
 				return ret;
 
@@ -433,13 +478,15 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 
 	if (local < 2 * rem) {
 		if (local % 2) {
-			ret = coll_sched_send(coll_op, local - 1, result,
-					      count, datatype, 1);
+			ret = coll_sched_send(coll_op,
+					      coll_group_rank(group, local - 1),
+					      result, count, datatype, 1);
 			if (ret)
 				return ret;
 		} else {
-			ret = coll_sched_recv(coll_op, local + 1, result,
-					      count, datatype, 1);
+			ret = coll_sched_recv(coll_op,
+					      coll_group_rank(group, local + 1),
+					      result, count, datatype, 1);
 			if (ret)
 				return ret;
 		}
@@ -447,6 +494,133 @@ static int coll_do_allreduce(struct util_coll_operation *coll_op,
 	return FI_SUCCESS;
 }
 
+/* Element offset and count of segment seg when count is split numranks ways */
+static void coll_ring_seg(size_t count, size_t numranks, uint64_t seg,
+			  size_t *offset, size_t *seg_cnt)
+{
+	size_t base = count / numranks, extra = count % numranks;
+
+	*seg_cnt = base + (seg < extra);
+	*offset = seg * base + MIN(seg, extra);
+}
+
+/*
+ * Ring reduce-scatter over the numranks segments of data.  At step i we
+ * pass segment (first - i) to the right and fold the segment coming from
+ * the left into our copy, so after numranks - 1 steps this rank holds the
+ * fully reduced segment (first + 1).
+ */
+static int coll_sched_ring_reduce(struct util_coll_operation *coll_op,
+				  const struct coll_group *group,
+				  void *data, void *tmp_buf, size_t count,
+				  uint64_t first, enum fi_datatype datatype,
+				  enum fi_op op)
+{
+	uint64_t i, send_seg, recv_seg, left_rank, right_rank, numranks;
+	size_t send_off, send_cnt, recv_off, recv_cnt, dsize;
+	int ret;
+
+	numranks = group->size;
+	left_rank = coll_group_rank(group,
+				    (numranks + group->index - 1) % numranks);
+	right_rank = coll_group_rank(group, (group->index + 1) % numranks);
+	dsize = ofi_datatype_size(datatype);
+
+	for (i = 0; i < numranks - 1; i++) {
+		send_seg = (first + numranks - i) % numranks;
+		recv_seg = (send_seg + numranks - 1) % numranks;
+		coll_ring_seg(count, numranks, send_seg, &send_off, &send_cnt);
+		coll_ring_seg(count, numranks, recv_seg, &recv_off, &recv_cnt);
+
+		ret = coll_sched_send(coll_op, right_rank,
+				      (char *) data + send_off * dsize,
+				      send_cnt, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_recv(coll_op, left_rank, tmp_buf, recv_cnt,
+				      datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op, tmp_buf,
+					(char *) data + recv_off * dsize,
+					recv_cnt, datatype, op, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Allreduce implemented as a ring reduce-scatter followed by a ring
+ * allgather.  Each rank moves 2 * (numranks - 1) / numranks of the vector
+ * instead of log2(numranks) full vectors, which wins for large buffers.
+ * tmp_buf must hold one segment.
+ */
+static int coll_do_allreduce_ring(struct util_coll_operation *coll_op,
+				  const struct coll_group *group,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, size_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t i, local, send_seg, recv_seg, left_rank, right_rank, numranks;
+	size_t send_off, send_cnt, recv_off, recv_cnt, dsize;
+	int ret;
+
+	numranks = group->size;
+	local = group->index;
+	left_rank = coll_group_rank(group, (numranks + local - 1) % numranks);
+	right_rank = coll_group_rank(group, (local + 1) % numranks);
+	dsize = ofi_datatype_size(datatype);
+
+	/* copy initial send data to result */
+	if (send_buf != result)
+		memcpy(result, send_buf, count * dsize);
+
+	ret = coll_sched_ring_reduce(coll_op, group, result, tmp_buf, count,
+				     local, datatype, op);
+	if (ret)
+		return ret;
+
+	/* circulate the reduced segments, starting with our own */
+	for (i = 0; i < numranks - 1; i++) {
+		send_seg = (local + 1 + numranks - i) % numranks;
+		recv_seg = (send_seg + numranks - 1) % numranks;
+		coll_ring_seg(count, numranks, send_seg, &send_off, &send_cnt);
+		coll_ring_seg(count, numranks, recv_seg, &recv_off, &recv_cnt);
+
+		ret = coll_sched_send(coll_op, right_rank,
+				      (char *) result + send_off * dsize,
+				      send_cnt, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_recv(coll_op, left_rank,
+				      (char *) result + recv_off * dsize,
+				      recv_cnt, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * The ring moves less data per rank but needs 2 * (numranks - 1) steps,
+ * so only use it once every rank's segment is large enough to amortize
+ * the extra latency.
+ */
+static bool coll_use_allreduce_ring(size_t numranks, size_t count,
+				    enum fi_datatype datatype)
+{
+	return coll_env.allreduce_ring_size && numranks > 1 &&
+	       count >= numranks &&
+	       count / numranks * ofi_datatype_size(datatype) >=
+	       coll_env.allreduce_ring_size;
+}
+
 /* allgather implemented using ring algorithm */
 static int coll_do_allgather(struct util_coll_operation *coll_op,
 			     const void *send_buf, void *result, size_t count,
@@ -645,6 +819,633 @@ static int coll_do_scatter(struct util_coll_operation *coll_op,
 	return FI_SUCCESS;
 }
 
+/*
+ * Broadcast implemented with a pipelined binomial tree.  The buffer is cut
+ * into seg_cnt sized segments; each segment is forwarded to our children
+ * as soon as it arrives from our parent, so sends of one segment overlap
+ * the receive of the next.
+ */
+static int coll_do_bcast_tree(struct util_coll_operation *coll_op,
+			      const struct coll_group *group, void *buf,
+			      size_t count, uint64_t root, size_t seg_cnt,
+			      enum fi_datatype datatype)
+{
+	uint64_t local_rank, relative_rank, mask, top, parent = 0;
+	size_t offset, cur_cnt, numranks, dsize;
+	int ret, last;
+
+	local_rank = group->index;
+	numranks = group->size;
+	relative_rank = (local_rank >= root) ?
+			local_rank - root : local_rank - root + numranks;
+	dsize = ofi_datatype_size(datatype);
+
+	/* our parent clears the lowest set bit, children sit below it */
+	if (relative_rank) {
+		top = 0x1ULL << (ofi_lsb(relative_rank) - 1);
+		parent = coll_group_rank(group, (relative_rank - top + root) %
+					 numranks);
+	} else {
+		top = roundup_power_of_two(numranks);
+	}
+
+	for (offset = 0; offset < count; offset += cur_cnt) {
+		cur_cnt = MIN(seg_cnt, count - offset);
+		last = offset + cur_cnt == count;
+
+		if (relative_rank) {
+			ret = coll_sched_recv(coll_op, parent,
+					      (char *) buf + offset * dsize,
+					      cur_cnt, datatype, 1);
+			if (ret)
+				return ret;
+		}
+
+		/*
+		 * Serve the largest subtree first.  The sends of the final
+		 * segment are fenced so completion waits for them.
+		 */
+		for (mask = top >> 1; mask > 0; mask >>= 1) {
+			if (relative_rank + mask >= numranks)
+				continue;
+
+			ret = coll_sched_send(coll_op,
+					      coll_group_rank(group,
+							      (relative_rank +
+							       mask + root) %
+							      numranks),
+					      (char *) buf + offset * dsize,
+					      cur_cnt, datatype, last);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Reduce implemented with a binomial tree: fold in the partial results of
+ * each child subtree, then pass the total to our parent.  accum holds the
+ * running total and tmp_buf one incoming vector.
+ */
+static int coll_do_reduce(struct util_coll_operation *coll_op,
+			  const struct coll_group *group,
+			  const void *send_buf, void *accum, void *tmp_buf,
+			  size_t count, uint64_t root,
+			  enum fi_datatype datatype, enum fi_op op)
+{
+	uint64_t local_rank, relative_rank, mask;
+	size_t numranks;
+	int ret;
+
+	local_rank = group->index;
+	numranks = group->size;
+	relative_rank = (local_rank >= root) ?
+			local_rank - root : local_rank - root + numranks;
+
+	memcpy(accum, send_buf, count * ofi_datatype_size(datatype));
+
+	for (mask = 0x1; mask < numranks; mask <<= 1) {
+		if (relative_rank & mask) {
+			return coll_sched_send(coll_op,
+					       coll_group_rank(group,
+							(relative_rank - mask +
+							 root) % numranks),
+					       accum, count, datatype, 1);
+		}
+
+		if (relative_rank + mask >= numranks)
+			continue;
+
+		ret = coll_sched_recv(coll_op,
+				      coll_group_rank(group,
+						      (relative_rank + mask +
+						       root) % numranks),
+				      tmp_buf, count, datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_reduce(coll_op, tmp_buf, accum, count,
+					datatype, op, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Gather implemented with a binomial tree, the inverse of coll_do_scatter.
+ * Each node collects its subtree into a buffer ordered by relative rank
+ * and forwards it to its parent.  The root rotates that buffer back into
+ * rank order.
+ */
+static int coll_do_gather(struct util_coll_operation *coll_op,
+			  const void *data, void *result, void **temp,
+			  size_t count, uint64_t root,
+			  enum fi_datatype datatype)
+{
+	uint64_t local_rank, relative_rank, mask, top;
+	size_t nbytes, numranks, subtree, child_cnt;
+	void *gather_buf;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	relative_rank = (local_rank >= root) ?
+			local_rank - root : local_rank - root + numranks;
+	nbytes = count * ofi_datatype_size(datatype);
+
+	if (count == 0)
+		return FI_SUCCESS;
+
+	if (relative_rank) {
+		subtree = util_binomial_tree_values_to_recv(relative_rank,
+							    numranks);
+		top = 0x1ULL << (ofi_lsb(relative_rank) - 1);
+	} else {
+		subtree = numranks;
+		top = roundup_power_of_two(numranks);
+	}
+
+	/* leaves send their data straight from the user buffer */
+	if (relative_rank && subtree == 1) {
+		gather_buf = (void *) data;
+	} else if (!relative_rank && root == 0) {
+		gather_buf = result;
+	} else {
+		*temp = malloc(subtree * nbytes);
+		if (!*temp)
+			return -FI_ENOMEM;
+		gather_buf = *temp;
+	}
+
+	if (gather_buf != data) {
+		ret = coll_sched_copy(coll_op, (void *) data, gather_buf,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	for (mask = 0x1; mask < top && relative_rank + mask < numranks;
+	     mask <<= 1) {
+		child_cnt = util_binomial_tree_values_to_recv(relative_rank +
+							      mask, numranks);
+		ret = coll_sched_recv(coll_op,
+				      (relative_rank + mask + root) % numranks,
+				      (char *) gather_buf + mask * nbytes,
+				      child_cnt * count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	if (relative_rank)
+		return coll_sched_send(coll_op,
+				       (relative_rank - top + root) % numranks,
+				       gather_buf, subtree * count, datatype, 1);
+
+	if (root != 0) {
+		/* relative rank r holds the data of rank (r + root) */
+		ret = coll_sched_copy(coll_op, gather_buf,
+				      (char *) result + root * nbytes,
+				      (numranks - root) * count, datatype, 1);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_copy(coll_op,
+				      (char *) gather_buf +
+				      (numranks - root) * nbytes,
+				      result, root * count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/* Alltoall implemented with pairwise exchanges */
+static int coll_do_alltoall(struct util_coll_operation *coll_op,
+			    const void *data, void *result, size_t count,
+			    enum fi_datatype datatype)
+{
+	uint64_t i, local_rank, dest, src;
+	size_t nbytes, numranks;
+	int ret;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	nbytes = count * ofi_datatype_size(datatype);
+
+	ret = coll_sched_copy(coll_op, (char *) data + local_rank * nbytes,
+			      (char *) result + local_rank * nbytes,
+			      count, datatype, 1);
+	if (ret)
+		return ret;
+
+	for (i = 1; i < numranks; i++) {
+		dest = (local_rank + i) % numranks;
+		src = (local_rank + numranks - i) % numranks;
+
+		ret = coll_sched_send(coll_op, dest,
+				      (char *) data + dest * nbytes,
+				      count, datatype, 0);
+		if (ret)
+			return ret;
+
+		ret = coll_sched_recv(coll_op, src,
+				      (char *) result + src * nbytes,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * Node-aware allreduce: reduce onto each node leader, allreduce between
+ * the leaders only, then broadcast the total within each node.
+ */
+static int coll_do_allreduce_hier(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  void *tmp_buf, size_t count,
+				  enum fi_datatype datatype, enum fi_op op)
+{
+	struct util_coll_node_map *map = coll_op->mc->node_map;
+	struct coll_group node, leaders;
+	int ret;
+
+	coll_node_group(coll_op->mc, &node);
+	ret = coll_do_reduce(coll_op, &node, send_buf, result, tmp_buf, count,
+			     0, datatype, op);
+	if (ret)
+		return ret;
+
+	if (!node.index) {
+		leaders.ranks = map->leaders;
+		leaders.size = map->num_nodes;
+		leaders.index = map->node;
+
+		if (coll_use_allreduce_ring(leaders.size, count, datatype))
+			ret = coll_do_allreduce_ring(coll_op, &leaders, result,
+						     result, tmp_buf, count,
+						     datatype, op);
+		else
+			ret = coll_do_allreduce(coll_op, &leaders, result,
+						result, tmp_buf, count,
+						datatype, op);
+		if (ret)
+			return ret;
+	}
+
+	return coll_do_bcast_tree(coll_op, &node, result, count, 0,
+				  MAX(coll_env.bcast_seg_size /
+				      ofi_datatype_size(datatype), 1),
+				  datatype);
+}
+
+static int coll_sched_allreduce(struct util_coll_operation *coll_op,
+				const void *send_buf, void *result,
+				void *tmp_buf, size_t count,
+				enum fi_datatype datatype, enum fi_op op)
+{
+	struct coll_group group;
+
+	if (coll_op->mc->node_map)
+		return coll_do_allreduce_hier(coll_op, send_buf, result,
+					      tmp_buf, count, datatype, op);
+
+	coll_mc_group(coll_op->mc, &group);
+	if (coll_use_allreduce_ring(group.size, count, datatype))
+		return coll_do_allreduce_ring(coll_op, &group, send_buf,
+					      result, tmp_buf, count,
+					      datatype, op);
+
+	return coll_do_allreduce(coll_op, &group, send_buf, result, tmp_buf,
+				 count, datatype, op);
+}
+
+/*
+ * Node-aware allgather: each leader collects its node's values in place,
+ * the leaders pass node blocks around a ring, then each leader broadcasts
+ * the full result within its node.  A node's values are not contiguous
+ * in the result, so blocks move as one message per member.
+ */
+static int coll_do_allgather_hier(struct util_coll_operation *coll_op,
+				  const void *send_buf, void *result,
+				  size_t count, enum fi_datatype datatype)
+{
+	struct util_coll_node_map *map = coll_op->mc->node_map;
+	struct coll_group node;
+	uint64_t i, j, send_node, recv_node, left_rank, right_rank;
+	size_t nbytes, num_nodes;
+	int ret;
+
+	coll_node_group(coll_op->mc, &node);
+	nbytes = count * ofi_datatype_size(datatype);
+	num_nodes = map->num_nodes;
+
+	if (node.index) {
+		ret = coll_sched_send(coll_op, node.ranks[0], (void *) send_buf,
+				      count, datatype, 1);
+		if (ret)
+			return ret;
+		goto bcast;
+	}
+
+	ret = coll_sched_copy(coll_op, (void *) send_buf,
+			      (char *) result + coll_op->mc->local_rank * nbytes,
+			      count, datatype, 1);
+	if (ret)
+		return ret;
+
+	for (i = 1; i < node.size; i++) {
+		ret = coll_sched_recv(coll_op, node.ranks[i],
+				      (char *) result + node.ranks[i] * nbytes,
+				      count, datatype, i == node.size - 1);
+		if (ret)
+			return ret;
+	}
+
+	left_rank = map->leaders[(num_nodes + map->node - 1) % num_nodes];
+	right_rank = map->leaders[(map->node + 1) % num_nodes];
+
+	/* pass our node's block right first, then the ones from the left */
+	for (i = 0; i < num_nodes - 1; i++) {
+		send_node = (map->node + num_nodes - i) % num_nodes;
+		recv_node = (send_node + num_nodes - 1) % num_nodes;
+
+		for (j = map->node_start[send_node];
+		     j < map->node_start[send_node + 1]; j++) {
+			ret = coll_sched_send(coll_op, right_rank,
+					      (char *) result +
+					      map->ranks[j] * nbytes,
+					      count, datatype, 0);
+			if (ret)
+				return ret;
+		}
+
+		for (j = map->node_start[recv_node];
+		     j < map->node_start[recv_node + 1]; j++) {
+			ret = coll_sched_recv(coll_op, left_rank,
+					      (char *) result +
+					      map->ranks[j] * nbytes,
+					      count, datatype,
+					      j == map->node_start[recv_node + 1] - 1);
+			if (ret)
+				return ret;
+		}
+	}
+
+bcast:
+	return coll_do_bcast_tree(coll_op, &node, result,
+				  count * coll_op->mc->av_set->fi_addr_count, 0,
+				  MAX(coll_env.bcast_seg_size /
+				      ofi_datatype_size(datatype), 1),
+				  datatype);
+}
+
+/*
+ * Node-aware broadcast: a tree between one member per node, the root
+ * standing in for the leader of its own node, then a tree within each
+ * node.  leaders is set to the per-operation list of those members.
+ */
+static int coll_do_bcast_hier(struct util_coll_operation *coll_op,
+			      void *buf, size_t count, uint64_t root,
+			      uint64_t **leaders, enum fi_datatype datatype)
+{
+	struct util_coll_node_map *map = coll_op->mc->node_map;
+	struct coll_group node, reps;
+	size_t root_node, seg_cnt;
+	uint64_t node_root = 0;
+	int ret;
+
+	*leaders = malloc(map->num_nodes * sizeof(**leaders));
+	if (!*leaders)
+		return -FI_ENOMEM;
+
+	root_node = map->rank_node[root];
+	memcpy(*leaders, map->leaders, map->num_nodes * sizeof(**leaders));
+	(*leaders)[root_node] = root;
+
+	seg_cnt = MAX(coll_env.bcast_seg_size / ofi_datatype_size(datatype), 1);
+	coll_node_group(coll_op->mc, &node);
+
+	if (coll_op->mc->local_rank == (*leaders)[map->node]) {
+		reps.ranks = *leaders;
+		reps.size = map->num_nodes;
+		reps.index = map->node;
+
+		ret = coll_do_bcast_tree(coll_op, &reps, buf, count, root_node,
+					 seg_cnt, datatype);
+		if (ret)
+			return ret;
+	}
+
+	if (map->node == root_node) {
+		while (node.ranks[node_root] != root)
+			node_root++;
+	}
+
+	return coll_do_bcast_tree(coll_op, &node, buf, count, node_root,
+				  seg_cnt, datatype);
+}
+
+/*
+ * Node-aware scatter: the root packs the values of each node together
+ * and sends every other node its block through the node leader.  The
+ * root, or the leader of a remote node, then hands out the values of its
+ * node.
+ */
+static int coll_do_scatter_hier(struct util_coll_operation *coll_op,
+				const void *data, void *result, void **temp,
+				size_t count, uint64_t root,
+				enum fi_datatype datatype)
+{
+	struct util_coll_node_map *map = coll_op->mc->node_map;
+	struct coll_group node;
+	uint64_t i, n, local_rank;
+	size_t nbytes, numranks, root_node;
+	char *block;
+	int ret;
+
+	if (count == 0)
+		return FI_SUCCESS;
+
+	local_rank = coll_op->mc->local_rank;
+	numranks = coll_op->mc->av_set->fi_addr_count;
+	nbytes = count * ofi_datatype_size(datatype);
+	root_node = map->rank_node[root];
+	coll_node_group(coll_op->mc, &node);
+
+	if (local_rank == root) {
+		*temp = malloc(numranks * nbytes);
+		if (!*temp)
+			return -FI_ENOMEM;
+
+		/* map->ranks is ordered by node */
+		for (i = 0; i < numranks; i++) {
+			ret = coll_sched_copy(coll_op,
+					      (char *) data + map->ranks[i] * nbytes,
+					      (char *) *temp + i * nbytes, count,
+					      datatype, i == numranks - 1);
+			if (ret)
+				return ret;
+		}
+
+		for (n = 0; n < map->num_nodes; n++) {
+			if (n == root_node)
+				continue;
+
+			ret = coll_sched_send(coll_op, map->leaders[n],
+					      (char *) *temp +
+					      map->node_start[n] * nbytes,
+					      (map->node_start[n + 1] -
+					       map->node_start[n]) * count,
+					      datatype, 0);
+			if (ret)
+				return ret;
+		}
+		block = (char *) *temp + map->node_start[root_node] * nbytes;
+	} else if (map->node != root_node && !node.index) {
+		*temp = malloc(node.size * nbytes);
+		if (!*temp)
+			return -FI_ENOMEM;
+
+		ret = coll_sched_recv(coll_op, root, *temp, node.size * count,
+				      datatype, 1);
+		if (ret)
+			return ret;
+		block = *temp;
+	} else {
+		return coll_sched_recv(coll_op, map->node == root_node ?
+				       root : node.ranks[0], result, count,
+				       datatype, 1);
+	}
+
+	for (i = 0; i < node.size; i++) {
+		if (node.ranks[i] == local_rank)
+			ret = coll_sched_copy(coll_op, block + i * nbytes,
+					      result, count, datatype,
+					      i == node.size - 1);
+		else
+			ret = coll_sched_send(coll_op, node.ranks[i],
+					      block + i * nbytes, count,
+					      datatype, i == node.size - 1);
+		if (ret)
+			return ret;
+	}
+
+	return FI_SUCCESS;
+}
+
+static void coll_free_node_map(struct util_coll_node_map *map)
+{
+	if (!map)
+		return;
+
+	free(map->ranks);
+	free(map->node_start);
+	free(map->rank_node);
+	free(map->leaders);
+	free(map);
+}
+
+/*
+ * Group the ranks of coll_mc by node.  node_ids holds the node id of
+ * each rank of parent, which shares coll_mc's AV, or 0 for ranks with
+ * the hierarchical algorithms disabled.  The map is only built when
+ * every member has them enabled, the group spans several nodes and some
+ * node holds more than one of its members, otherwise the flat algorithms
+ * are used.  All members see the same ids, so they agree on the choice.
+ */
+static int coll_create_node_map(struct util_coll_mc *coll_mc,
+				struct util_coll_mc *parent,
+				const uint64_t *node_ids)
+{
+	struct util_coll_node_map *map;
+	struct util_av_set *av_set = coll_mc->av_set;
+	uint64_t *ids, *node_id;
+	size_t i, j, n, numranks;
+	int ret = -FI_ENOMEM;
+
+	numranks = av_set->fi_addr_count;
+	if (coll_mc->local_rank == FI_ADDR_NOTAVAIL || numranks < 3)
+		return FI_SUCCESS;
+
+	ids = calloc(numranks, sizeof(*ids));
+	node_id = calloc(numranks, sizeof(*node_id));
+	map = calloc(1, sizeof(*map));
+	if (!ids || !node_id || !map)
+		goto out;
+
+	map->ranks = calloc(numranks, sizeof(*map->ranks));
+	map->rank_node = calloc(numranks, sizeof(*map->rank_node));
+	map->node_start = calloc(numranks + 1, sizeof(*map->node_start));
+	if (!map->ranks || !map->rank_node || !map->node_start)
+		goto out;
+
+	for (i = 0; i < numranks; i++) {
+		for (j = 0; j < parent->av_set->fi_addr_count; j++) {
+			if (parent->av_set->fi_addr_array[j] ==
+			    av_set->fi_addr_array[i])
+				break;
+		}
+		if (j == parent->av_set->fi_addr_count || !node_ids[j]) {
+			ret = FI_SUCCESS;
+			goto out;
+		}
+		ids[i] = node_ids[j];
+	}
+
+	/* number the nodes in order of their lowest rank */
+	for (i = 0; i < numranks; i++) {
+		for (n = 0; n < map->num_nodes && node_id[n] != ids[i]; n++)
+			;
+		if (n == map->num_nodes)
+			node_id[map->num_nodes++] = ids[i];
+		map->rank_node[i] = n;
+		map->node_start[n + 1]++;
+	}
+
+	if (map->num_nodes == 1 || map->num_nodes == numranks) {
+		ret = FI_SUCCESS;
+		goto out;
+	}
+
+	map->leaders = calloc(map->num_nodes, sizeof(*map->leaders));
+	if (!map->leaders)
+		goto out;
+
+	for (n = 0; n < map->num_nodes; n++)
+		map->node_start[n + 1] += map->node_start[n];
+
+	/* node_id now counts the ranks placed on each node */
+	memset(node_id, 0, map->num_nodes * sizeof(*node_id));
+	for (i = 0; i < numranks; i++) {
+		n = map->rank_node[i];
+		if (!node_id[n])
+			map->leaders[n] = i;
+		map->ranks[map->node_start[n] + node_id[n]++] = i;
+	}
+	map->node = map->rank_node[coll_mc->local_rank];
+
+	FI_INFO(av_set->av->prov, FI_LOG_EP_CTRL,
+		"collective group of %zu members spans %zu nodes, "
+		"local node has %zu members\n", numranks, map->num_nodes,
+		map->node_start[map->node + 1] - map->node_start[map->node]);
+
+	coll_mc->node_map = map;
+	map = NULL;
+	ret = FI_SUCCESS;
+out:
+	coll_free_node_map(map);
+	free(node_id);
+	free(ids);
+	return ret;
+}
+
 static int coll_close(struct fid *fid)
 {
 	struct util_coll_mc *coll_mc;
@@ -652,6 +1453,7 @@ static int coll_close(struct fid *fid)
 	coll_mc = container_of(fid, struct util_coll_mc, mc_fid.fid);
 
 	ofi_atomic_dec32(&coll_mc->av_set->ref);
+	coll_free_node_map(coll_mc->node_map);
 	free(coll_mc);
 
 	return FI_SUCCESS;
@@ -704,6 +1506,13 @@ void coll_join_comp(struct util_coll_operation *coll_op)
 	ofi_bitmask_unset(ep->util_ep.coll_cid_mask,
 			  coll_op->data.join.new_mc->group_id);
 
+	if (coll_op->data.join.node_ids &&
+	    coll_create_node_map(coll_op->data.join.new_mc, coll_op->mc,
+				 coll_op->data.join.node_ids))
+		FI_WARN(ep->util_ep.domain->fabric->prov, FI_LOG_DOMAIN,
+			"join collective - unable to map group to nodes, "
+			"using flat algorithms\n");
+
 	/* write to the eq */
 	memset(&entry, 0, sizeof(entry));
 	entry.fid = &coll_op->mc->mc_fid.fid;
@@ -716,6 +1525,7 @@ void coll_join_comp(struct util_coll_operation *coll_op)
 
 	ofi_bitmask_free(&coll_op->data.join.data);
 	ofi_bitmask_free(&coll_op->data.join.tmp);
+	free(coll_op->data.join.node_ids);
 }
 
 void coll_collective_comp(struct util_coll_operation *coll_op)
@@ -736,6 +1546,15 @@ void coll_collective_comp(struct util_coll_operation *coll_op)
 		free(coll_op->data.allreduce.data);
 		break;
 
+	case UTIL_COLL_REDUCE_OP:
+	case UTIL_COLL_REDUCE_SCATTER_OP:
+		free(coll_op->data.reduce.data);
+		break;
+
+	case UTIL_COLL_GATHER_OP:
+		free(coll_op->data.gather);
+		break;
+
 	case UTIL_COLL_SCATTER_OP:
 		free(coll_op->data.scatter);
 		break;
@@ -743,11 +1562,13 @@ void coll_collective_comp(struct util_coll_operation *coll_op)
 	case UTIL_COLL_BROADCAST_OP:
 		free(coll_op->data.broadcast.chunk);
 		free(coll_op->data.broadcast.scatter);
+		free(coll_op->data.broadcast.leaders);
 		break;
 
 	case UTIL_COLL_JOIN_OP:
 	case UTIL_COLL_BARRIER_OP:
 	case UTIL_COLL_ALLGATHER_OP:
+	case UTIL_COLL_ALLTOALL_OP:
 	default:
 		/* nothing to clean up */
 		break;
@@ -759,7 +1580,7 @@ static ssize_t coll_process_reduce_item(struct util_coll_reduce_item *reduce_ite
 	if (reduce_item->op < FI_MIN || reduce_item->op > FI_BXOR)
 		return -FI_ENOSYS;
 
-	ofi_atomic_write_handler(reduce_item->op, reduce_item->datatype,
+	ofi_reduce_write_handler(reduce_item->op, reduce_item->datatype,
 				 reduce_item->inout_buf,
 				 reduce_item->in_buf,
 				 reduce_item->count);
@@ -828,22 +1649,21 @@ void coll_ep_progress(struct util_ep *util_ep)
 		coll_op = work_item->coll_op;
 		switch (work_item->type) {
 		case UTIL_COLL_SEND:
+		case UTIL_COLL_RECV:
 			xfer_item = container_of(work_item,
 						 struct util_coll_xfer_item,
 						 hdr);
 			ret = coll_process_xfer_item(xfer_item);
-			if (ret && ret == -FI_EAGAIN) {
-				slist_insert_tail(&work_item->ready_entry,
+			/*
+			 * Retry before anything queued behind: transfers
+			 * to one peer share a tag and match in the order
+			 * they are posted.
+			 */
+			if (ret == -FI_EAGAIN) {
+				slist_insert_head(&work_item->ready_entry,
 						  &util_ep->coll_ready_queue);
 				goto out;
 			}
-			break;
-
-		case UTIL_COLL_RECV:
-			xfer_item = container_of(work_item,
-						 struct util_coll_xfer_item,
-						 hdr);
-			ret = coll_process_xfer_item(xfer_item);
 			if (ret)
 				goto out;
 			break;
@@ -916,6 +1736,7 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 	struct util_coll_mc *coll_mc;
 	struct util_coll_operation *join_op;
 	struct util_ep *util_ep;
+	struct coll_group group;
 	struct fi_collective_addr *c_addr;
 	fi_addr_t coll_addr;
 	const struct fid_av_set *set;
@@ -965,7 +1786,8 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 		goto err3;
 
 	util_ep = container_of(ep, struct util_ep, ep_fid);
-	ret = coll_do_allreduce(join_op, util_ep->coll_cid_mask->bytes,
+	coll_mc_group(coll_mc, &group);
+	ret = coll_do_allreduce(join_op, &group, util_ep->coll_cid_mask->bytes,
 				join_op->data.join.data.bytes,
 				join_op->data.join.tmp.bytes,
 				(int) ofi_bitmask_bytesize(util_ep->coll_cid_mask),
@@ -973,6 +1795,24 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 	if (ret)
 		goto err4;
 
+	/* learn which members share a node for the hierarchical algorithms.
+	 * The ids are exchanged even when those are disabled locally, so
+	 * that all members agree on the algorithms whatever their setting.
+	 */
+	join_op->data.join.node_id = coll_env.hierarchical ?
+				     coll_env.node_id : 0;
+	join_op->data.join.node_ids =
+		calloc(group.size, sizeof(*join_op->data.join.node_ids));
+	if (!join_op->data.join.node_ids) {
+		ret = -FI_ENOMEM;
+		goto err4;
+	}
+
+	ret = coll_do_allgather(join_op, &join_op->data.join.node_id,
+				join_op->data.join.node_ids, 1, FI_UINT64);
+	if (ret)
+		goto err4;
+
 	ret = coll_sched_comp(join_op);
 	if (ret)
 		goto err4;
@@ -983,6 +1823,7 @@ int coll_join_collective(struct fid_ep *ep, const void *addr,
 	return FI_SUCCESS;
 
 err4:
+	free(join_op->data.join.node_ids);
 	ofi_bitmask_free(&join_op->data.join.tmp);
 err3:
 	ofi_bitmask_free(&join_op->data.join.data);
@@ -1011,7 +1852,7 @@ ssize_t coll_ep_barrier2(struct fid_ep *ep, fi_addr_t coll_addr, uint64_t flags,
 		return -FI_ENOMEM;
 
 	send = ~barrier_op->mc->local_rank;
-	ret = coll_do_allreduce(barrier_op, &send,
+	ret = coll_sched_allreduce(barrier_op, &send,
 				&barrier_op->data.barrier.data,
 				&barrier_op->data.barrier.tmp, 1, FI_UINT64,
 				FI_BAND);
@@ -1061,9 +1902,9 @@ ssize_t coll_ep_allreduce(struct fid_ep *ep, const void *buf, size_t count,
 		goto err1;
 	}
 
-	ret = coll_do_allreduce(allreduce_op, buf, result,
-				allreduce_op->data.allreduce.data, count,
-				datatype, op);
+	ret = coll_sched_allreduce(allreduce_op, buf, result,
+				   allreduce_op->data.allreduce.data,
+				   count, datatype, op);
 	if (ret)
 		goto err2;
 
@@ -1100,7 +1941,12 @@ ssize_t coll_ep_allgather(struct fid_ep *ep, const void *buf, size_t count,
 	if (!allgather_op)
 		return -FI_ENOMEM;
 
-	ret = coll_do_allgather(allgather_op, buf, result, count, datatype);
+	if (coll_mc->node_map)
+		ret = coll_do_allgather_hier(allgather_op, buf, result, count,
+					     datatype);
+	else
+		ret = coll_do_allgather(allgather_op, buf, result, count,
+					datatype);
 	if (ret)
 		goto err;
 
@@ -1135,9 +1981,14 @@ ssize_t coll_ep_scatter(struct fid_ep *ep, const void *buf, size_t count,
 	if (!scatter_op)
 		return -FI_ENOMEM;
 
-	ret = coll_do_scatter(scatter_op, buf, result,
-			      &scatter_op->data.scatter, count,
-			      root_addr, datatype);
+	if (coll_mc->node_map)
+		ret = coll_do_scatter_hier(scatter_op, buf, result,
+					   &scatter_op->data.scatter, count,
+					   root_addr, datatype);
+	else
+		ret = coll_do_scatter(scatter_op, buf, result,
+				      &scatter_op->data.scatter, count,
+				      root_addr, datatype);
 	if (ret)
 		goto err;
 
@@ -1150,6 +2001,7 @@ ssize_t coll_ep_scatter(struct fid_ep *ep, const void *buf, size_t count,
 
 	return FI_SUCCESS;
 err:
+	free(scatter_op->data.scatter);
 	free(scatter_op);
 	return ret;
 }
@@ -1162,6 +2014,7 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 	struct util_coll_mc *coll_mc;
 	struct util_coll_operation *broadcast_op;
 	struct util_ep *util_ep;
+	struct coll_group group;
 	uint64_t chunk_cnt, numranks, local;
 	int ret;
 
@@ -1174,6 +2027,34 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 
 	local = broadcast_op->mc->local_rank;
 	numranks = broadcast_op->mc->av_set->fi_addr_count;
+
+	if (coll_mc->node_map) {
+		ret = coll_do_bcast_hier(broadcast_op, buf, count, root_addr,
+					 &broadcast_op->data.broadcast.leaders,
+					 datatype);
+		if (ret)
+			goto err2;
+		goto comp;
+	}
+
+	/*
+	 * Scatter + allgather keeps the root from sending the whole buffer
+	 * log2(numranks) times, but costs numranks - 1 extra steps.  Small
+	 * broadcasts and small groups are better served by the tree.
+	 */
+	if (numranks <= 4 ||
+	    count * ofi_datatype_size(datatype) <= coll_env.bcast_tree_size) {
+		coll_mc_group(coll_mc, &group);
+		ret = coll_do_bcast_tree(broadcast_op, &group, buf, count,
+					 root_addr,
+					 MAX(coll_env.bcast_seg_size /
+					     ofi_datatype_size(datatype), 1),
+					 datatype);
+		if (ret)
+			goto err1;
+		goto comp;
+	}
+
 	chunk_cnt = (count + numranks - 1) / numranks;
 	if (chunk_cnt * local > count &&
 	    chunk_cnt * local - (int) count > chunk_cnt)
@@ -1199,6 +2080,7 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 	if (ret)
 		goto err2;
 
+comp:
 	ret = coll_sched_comp(broadcast_op);
 	if (ret)
 		goto err2;
@@ -1209,11 +2091,205 @@ ssize_t coll_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 	return FI_SUCCESS;
 err2:
 	free(broadcast_op->data.broadcast.chunk);
+	free(broadcast_op->data.broadcast.leaders);
 err1:
 	free(broadcast_op);
 	return ret;
 }
 
+ssize_t coll_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, enum fi_op op,
+		       uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *reduce_op;
+	struct util_ep *util_ep;
+	struct coll_group group;
+	size_t nbytes;
+	void *accum;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	reduce_op = coll_create_op(ep, coll_mc, UTIL_COLL_REDUCE_OP,
+				   flags, context,
+				   coll_collective_comp);
+	if (!reduce_op)
+		return -FI_ENOMEM;
+
+	/* non-root ranks accumulate their subtree in a private buffer */
+	nbytes = count * ofi_datatype_size(datatype);
+	reduce_op->data.reduce.size = nbytes;
+	reduce_op->data.reduce.data = malloc(nbytes * 2);
+	if (!reduce_op->data.reduce.data) {
+		ret = -FI_ENOMEM;
+		goto err1;
+	}
+
+	accum = reduce_op->mc->local_rank == root_addr ?
+		result : reduce_op->data.reduce.data;
+	coll_mc_group(coll_mc, &group);
+	ret = coll_do_reduce(reduce_op, &group, buf, accum,
+			     (char *) reduce_op->data.reduce.data + nbytes,
+			     count, root_addr, datatype, op);
+	if (ret)
+		goto err2;
+
+	ret = coll_sched_comp(reduce_op);
+	if (ret)
+		goto err2;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, reduce_op);
+
+	return FI_SUCCESS;
+
+err2:
+	free(reduce_op->data.reduce.data);
+err1:
+	free(reduce_op);
+	return ret;
+}
+
+ssize_t coll_ep_reduce_scatter(struct fid_ep *ep, const void *buf,
+			       size_t count, void *desc, void *result,
+			       void *result_desc, fi_addr_t coll_addr,
+			       enum fi_datatype datatype, enum fi_op op,
+			       uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *rs_op;
+	struct util_ep *util_ep;
+	struct coll_group group;
+	size_t nbytes, numranks;
+	uint64_t local;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	rs_op = coll_create_op(ep, coll_mc, UTIL_COLL_REDUCE_SCATTER_OP,
+			       flags, context,
+			       coll_collective_comp);
+	if (!rs_op)
+		return -FI_ENOMEM;
+
+	/*
+	 * buf holds count values for every rank.  Reduce a private copy of
+	 * it around the ring, plus room for one incoming segment.
+	 */
+	local = rs_op->mc->local_rank;
+	numranks = rs_op->mc->av_set->fi_addr_count;
+	nbytes = count * ofi_datatype_size(datatype);
+	rs_op->data.reduce.size = nbytes * numranks;
+	rs_op->data.reduce.data = malloc(nbytes * (numranks + 1));
+	if (!rs_op->data.reduce.data) {
+		ret = -FI_ENOMEM;
+		goto err1;
+	}
+	memcpy(rs_op->data.reduce.data, buf, nbytes * numranks);
+
+	coll_mc_group(coll_mc, &group);
+	ret = coll_sched_ring_reduce(rs_op, &group, rs_op->data.reduce.data,
+				     (char *) rs_op->data.reduce.data +
+				     nbytes * numranks, count * numranks,
+				     (local + numranks - 1) % numranks,
+				     datatype, op);
+	if (ret)
+		goto err2;
+
+	ret = coll_sched_copy(rs_op,
+			      (char *) rs_op->data.reduce.data + local * nbytes,
+			      result, count, datatype, 1);
+	if (ret)
+		goto err2;
+
+	ret = coll_sched_comp(rs_op);
+	if (ret)
+		goto err2;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, rs_op);
+
+	return FI_SUCCESS;
+
+err2:
+	free(rs_op->data.reduce.data);
+err1:
+	free(rs_op);
+	return ret;
+}
+
+ssize_t coll_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			 void *desc, void *result, void *result_desc,
+			 fi_addr_t coll_addr, enum fi_datatype datatype,
+			 uint64_t flags, void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *alltoall_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	alltoall_op = coll_create_op(ep, coll_mc, UTIL_COLL_ALLTOALL_OP,
+				     flags, context,
+				     coll_collective_comp);
+	if (!alltoall_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_alltoall(alltoall_op, buf, result, count, datatype);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(alltoall_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, alltoall_op);
+
+	return FI_SUCCESS;
+err:
+	free(alltoall_op);
+	return ret;
+}
+
+ssize_t coll_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		       void *desc, void *result, void *result_desc,
+		       fi_addr_t coll_addr, fi_addr_t root_addr,
+		       enum fi_datatype datatype, uint64_t flags,
+		       void *context)
+{
+	struct util_coll_mc *coll_mc;
+	struct util_coll_operation *gather_op;
+	struct util_ep *util_ep;
+	int ret;
+
+	coll_mc = (struct util_coll_mc *) ((uintptr_t) coll_addr);
+	gather_op = coll_create_op(ep, coll_mc, UTIL_COLL_GATHER_OP,
+				   flags, context,
+				   coll_collective_comp);
+	if (!gather_op)
+		return -FI_ENOMEM;
+
+	ret = coll_do_gather(gather_op, buf, result, &gather_op->data.gather,
+			     count, root_addr, datatype);
+	if (ret)
+		goto err;
+
+	ret = coll_sched_comp(gather_op);
+	if (ret)
+		goto err;
+
+	util_ep = container_of(ep, struct util_ep, ep_fid);
+	coll_progress_work(util_ep, gather_op);
+
+	return FI_SUCCESS;
+err:
+	free(gather_op->data.gather);
+	free(gather_op);
+	return ret;
+}
+
 ssize_t coll_peer_xfer_complete(struct fid_ep *ep,
 				struct fi_cq_tagged_entry *cqe,
 				fi_addr_t src_addr)
@@ -1280,9 +2356,13 @@ int coll_query_collective(struct fid_domain *dom_fid,
 	case FI_ALLGATHER:
 	case FI_SCATTER:
 	case FI_BROADCAST:
+	case FI_ALLTOALL:
+	case FI_GATHER:
 		ret = FI_SUCCESS;
 		break;
 	case FI_ALLREDUCE:
+	case FI_REDUCE_SCATTER:
+	case FI_REDUCE:
 		if (FI_MIN <= attr->op && FI_BXOR >= attr->op)
 			ret = fi_query_atomic(peer_domain, attr->datatype,
 					      attr->op, &attr->datatype_attr,
@@ -1290,10 +2370,6 @@ int coll_query_collective(struct fid_domain *dom_fid,
 		else
 			return -FI_ENOSYS;
 		break;
-	case FI_ALLTOALL:
-	case FI_REDUCE_SCATTER:
-	case FI_REDUCE:
-	case FI_GATHER:
 	default:
 		return -FI_ENOSYS;
 	}
@@ -32,6 +32,77 @@
 
 #include "coll.h"
 
+struct coll_env coll_env = {
+	.allreduce_ring_size = 8192,
+	.bcast_tree_size = 16384,
+	.bcast_seg_size = 65536,
+	.hierarchical = 1,
+};
+
+/* FNV-1a, the node id only needs to tell node names apart */
+static uint64_t coll_hash_name(const char *name)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (; *name; name++)
+		hash = (hash ^ (uint8_t) *name) * 0x100000001b3ULL;
+	return hash;
+}
+
+static void coll_init_env(void)
+{
+	char hostname[256] = "";
+	char *node_name = NULL;
+
+	fi_param_define(&coll_prov, "allreduce_ring_size", FI_PARAM_SIZE_T,
+			"Minimum number of bytes each member contributes per "
+			"segment before allreduce switches from recursive "
+			"doubling to the ring (reduce-scatter + allgather) "
+			"algorithm.  0 disables the ring algorithm. "
+			"(default: %zu)", coll_env.allreduce_ring_size);
+	fi_param_define(&coll_prov, "bcast_tree_size", FI_PARAM_SIZE_T,
+			"Largest broadcast, in bytes, sent over a pipelined "
+			"binomial tree in groups of more than 4 members. "
+			"Larger broadcasts use scatter + allgather. "
+			"(default: %zu)", coll_env.bcast_tree_size);
+	fi_param_define(&coll_prov, "bcast_seg_size", FI_PARAM_SIZE_T,
+			"Segment size, in bytes, used to pipeline a tree "
+			"broadcast. (default: %zu)", coll_env.bcast_seg_size);
+	fi_param_define(&coll_prov, "hierarchical", FI_PARAM_BOOL,
+			"Use node-aware algorithms for barrier, allreduce, "
+			"allgather, broadcast and scatter in groups whose "
+			"members span several nodes with more than one member "
+			"on some node.  Data is combined or distributed within "
+			"each node and only node leaders communicate across "
+			"nodes.  The node-aware algorithms are only used in "
+			"groups whose members all enable them. "
+			"(default: %d)", coll_env.hierarchical);
+	fi_param_define(&coll_prov, "node_name", FI_PARAM_STRING,
+			"Name of the node this process runs on.  Group "
+			"members with the same name are treated as co-located. "
+			"(default: host name)");
+
+	fi_param_get_size_t(&coll_prov, "allreduce_ring_size",
+			    &coll_env.allreduce_ring_size);
+	fi_param_get_size_t(&coll_prov, "bcast_tree_size",
+			    &coll_env.bcast_tree_size);
+	fi_param_get_size_t(&coll_prov, "bcast_seg_size",
+			    &coll_env.bcast_seg_size);
+	if (!coll_env.bcast_seg_size)
+		coll_env.bcast_seg_size = SIZE_MAX;
+	fi_param_get_bool(&coll_prov, "hierarchical", &coll_env.hierarchical);
+
+	if (fi_param_get_str(&coll_prov, "node_name", &node_name) ||
+	    !node_name) {
+		gethostname(hostname, sizeof(hostname) - 1);
+		node_name = hostname;
+	}
+	/* 0 tells the other members the node-aware algorithms are off */
+	coll_env.node_id = coll_hash_name(node_name);
+	if (!coll_env.node_id)
+		coll_env.node_id = 1;
+}
+
 static int coll_getinfo(uint32_t version, const char *node, const char *service,
 			uint64_t flags, const struct fi_info *hints,
 			struct fi_info **info)
@@ -60,5 +131,6 @@ struct fi_provider coll_prov = {
 
 COLL_INI
 {
+	coll_init_env();
 	return &coll_prov;
 }
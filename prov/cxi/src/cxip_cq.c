@@ -202,7 +202,7 @@ int cxip_cq_trywait(struct cxip_cq *cq)
 	}
 
 	ofi_genlock_lock(&cq->util_cq.cq_lock);
-	if (!ofi_cirque_isempty(cq->util_cq.cirq)) {
+	if (!ofi_cq_isempty(&cq->util_cq)) {
 		ofi_genlock_unlock(&cq->util_cq.cq_lock);
 		return -FI_EAGAIN;
 	}
@@ -902,8 +902,9 @@ int efa_av_open(struct fid_domain *domain_fid, struct fi_av_attr *attr,
 	if (efa_domain->info_type == EFA_INFO_RDM && efa_domain->fabric &&
 	    efa_domain->fabric->shm_fabric) {
 		/*
-		 * shm av supports maximum 256 entries
-		 * Reset the count to 128 to reduce memory footprint and satisfy
+		 * shm sizes its peer map from the av count, up to
+		 * EFA_SHM_MAX_AV_COUNT entries.  Reset the count to
+		 * shm_av_size to reduce memory footprint and satisfy
 		 * the need of the instances with more CPUs.
 		 */
 		av_attr = *attr;
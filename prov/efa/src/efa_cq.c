@@ -382,7 +382,7 @@ int efa_cq_trywait(struct efa_cq *cq)
 		return -FI_EINVAL;
 	}
 
-	if (!ofi_cirque_isempty(cq->util_cq.cirq)) {
+	if (!ofi_cq_isempty(&cq->util_cq)) {
 		EFA_INFO(FI_LOG_CQ, "efa_cq_trywait: completions available in "
 				 "util_cq, return -FI_EAGAIN\n");
 		return -FI_EAGAIN;
@@ -408,7 +408,7 @@ int efa_cq_trywait(struct efa_cq *cq)
 	/* Fetch any completions that we might have missed while rearming */
 	efa_cq_progress(&cq->util_cq);
 
-	return ofi_cirque_isempty(cq->util_cq.cirq) ? FI_SUCCESS : -FI_EAGAIN;
+	return ofi_cq_isempty(&cq->util_cq) ? FI_SUCCESS : -FI_EAGAIN;
 }
 #else
 int efa_cq_trywait(struct efa_cq *cq) {
@@ -682,7 +682,7 @@ ssize_t efa_cq_readfrom(struct fid_cq *cq_fid, void *buf, size_t count,
 	ofi_genlock_lock(&efa_cq->util_cq.ep_list_lock);
 
 	/* If there are cqes in the util cq (due to the cq flush in ep close or efa_trywait) */
-	if (!ofi_cirque_isempty(efa_cq->util_cq.cirq)) {
+	if (!ofi_cq_isempty(&efa_cq->util_cq)) {
 		err = ofi_cq_read_entries(&efa_cq->util_cq, buf, count, src_addr);
 		goto out;
 	}
@@ -179,7 +179,7 @@ int efa_rdm_write_atomic_hmem(struct efa_mr *efa_mr, struct iovec *dst, char *da
 	}
 
 	/* Step 2: Perform atomic operation on host buffer */
-	ofi_atomic_write_handlers[op][dt](host_data,
+	ofi_reduce_write_handlers[op][dt](host_data,
 	                                  data,
 	                                  dst->iov_len / dtsize);
 
@@ -349,7 +349,7 @@ int efa_rdm_fetch_atomic_hmem(struct efa_mr *efa_mr, struct iovec *dst, char *da
 	}
 
 	/* Step 2: Perform atomic operation on temporary host buffer */
-	ofi_atomic_readwrite_handlers[op][dt](host_data,
+	ofi_reduce_readwrite_handlers[op][dt](host_data,
 	                                      data,
 	                                      result,
 	                                      dst->iov_len / dtsize);
@@ -42,6 +42,15 @@
 #define MON_BASEPATH_DEFAULT "/dev/shm/ofi"
 #define MON_FILE_MODE_DEFAULT 0600
 #define MON_DIR_MODE_DEFAULT 01700
+#define MON_PROF_INTERVAL_DEFAULT 1000
+#define MON_PROF_DIR "prof"
+
+// Note: keep in-sync with util/top.c
+#define MON_PROF_VERSION 1
+#define MON_PROF_EP_MAX 64
+#define MON_PROF_VAR_MAX 16
+#define MON_PROF_EVENT_MAX 8
+#define MON_PROF_NAME_LEN 32
 
 // Note: keep in-sync with util/mon_sampler.c
 #define MONITOR_APIS(DECL)  \
@@ -122,6 +131,41 @@ struct monitor_mapped_data {
 	_Atomic uint8_t flags;
 };
 
+struct monitor_prof_entry {
+	char name[MON_PROF_NAME_LEN];
+	uint64_t value;
+};
+
+struct monitor_prof_ep {
+	uint32_t in_use;
+	uint32_t domain_id;
+	uint32_t ep_id;
+	uint32_t var_count;
+	uint32_t event_count;
+	uint32_t reserved;
+	struct monitor_prof_entry vars[MON_PROF_VAR_MAX];
+	// number of times each event fired since the endpoint was opened
+	struct monitor_prof_entry events[MON_PROF_EVENT_MAX];
+};
+
+struct monitor_prof_mapped_data {
+	uint32_t version;
+	uint32_t interval_ms;
+
+	/* Sequence counter
+	 * odd while the hook provider updates the endpoint table, readers
+	 * retry their copy if it is odd or changed while copying
+	 */
+	_Atomic uint32_t seq;
+
+	/* Termination flag, set if the fabric was closed with linger enabled */
+	uint32_t fin;
+
+	uint64_t timestamp_ms;
+	char prov_name[MON_PROF_NAME_LEN];
+	struct monitor_prof_ep ep[MON_PROF_EP_MAX];
+};
+
 struct monitor_context {
 	const struct fi_provider *hprov;
 
@@ -136,6 +180,15 @@ struct monitor_context {
 
 	// name of communication file
 	char shm_name[PATH_MAX];
+
+	// fid_profile export, only used if profile export is enabled
+	struct monitor_prof_mapped_data *prof_share;
+	char prof_shm_name[PATH_MAX];
+	struct dlist_entry prof_eps;
+	ofi_mutex_t prof_lock;
+	uint64_t prof_next_ms;
+	uint32_t prof_domain_cnt;
+	uint32_t prof_ep_cnt;
 };
 
 struct monitor_fabric {
@@ -148,6 +201,8 @@ struct monitor_environment {
 	unsigned int tick_max;
 	int file_mode;
 	int dir_mode;
+	int profile;
+	int prof_interval;
 	char basepath[PATH_MAX];
 };
 
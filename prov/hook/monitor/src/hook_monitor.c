@@ -37,6 +37,11 @@
 
 #include "hook_monitor.h"
 
+#ifdef HAVE_FABRIC_PROFILE
+#include <rdma/fi_profile.h>
+#include "ofi_profile.h"
+#endif
+
 #include <stdio.h>
 #include <limits.h>
 #include <sys/types.h>
@@ -58,6 +63,8 @@ struct monitor_environment mon_env = {
 	.tick_max = MON_TICK_MAX_DEFAULT,
 	.file_mode = MON_FILE_MODE_DEFAULT,
 	.dir_mode = MON_DIR_MODE_DEFAULT,
+	.profile = 0,
+	.prof_interval = MON_PROF_INTERVAL_DEFAULT,
 	.basepath = MON_BASEPATH_DEFAULT,
 };
 
@@ -187,17 +194,82 @@ mon_flush(struct monitor_context *ctx) {
 	}
 }
 
-static inline void
-mon_add_cntr(struct monitor_context *ctx, int cntr, int index, size_t size) {
-	ctx->data[cntr].count[index]++;
-	if (size != MON_IGNORE_SIZE) {
-		ctx->data[cntr].sum[index] += size;
+#ifdef HAVE_FABRIC_PROFILE
+
+struct monitor_prof_ep_ctx {
+	struct dlist_entry entry;
+	struct hook_ep *ep;
+	struct fid_profile *prof_fid;
+	int slot;
+	size_t var_count;
+	uint32_t var_ids[MON_PROF_VAR_MAX];
+	size_t event_count;
+	uint32_t event_ids[MON_PROF_EVENT_MAX];
+	uint64_t event_cnt[MON_PROF_EVENT_MAX];
+};
+
+/*
+ * Copy the current value of all exported variables and the event counts
+ * to the shared table, at most once per FI_OFI_HOOK_MONITOR_PROFILE_INTERVAL.
+ */
+static void
+mon_prof_sample(struct monitor_context *ctx)
+{
+	struct monitor_prof_ep_ctx *ep_ctx;
+	struct monitor_prof_ep *slot;
+	uint64_t now;
+	size_t i;
+
+	if (!ctx->prof_share)
+		return;
+
+	now = ofi_gettime_ms();
+	if (now < ctx->prof_next_ms)
+		return;
+	ctx->prof_next_ms = now + mon_env.prof_interval;
+
+	ofi_mutex_lock(&ctx->prof_lock);
+	ctx->prof_share->seq++;
+	dlist_foreach_container(&ctx->prof_eps, struct monitor_prof_ep_ctx,
+				ep_ctx, entry) {
+		slot = &ctx->prof_share->ep[ep_ctx->slot];
+		for (i = 0; i < ep_ctx->var_count; i++) {
+			if (fi_profile_read_u64(ep_ctx->prof_fid,
+						ep_ctx->var_ids[i],
+						&slot->vars[i].value))
+				slot->vars[i].value = 0;
+		}
+		for (i = 0; i < ep_ctx->event_count; i++)
+			slot->events[i].value = ep_ctx->event_cnt[i];
 	}
+	ctx->prof_share->timestamp_ms = now;
+	ctx->prof_share->seq++;
+	ofi_mutex_unlock(&ctx->prof_lock);
+}
+
+#else
+
+#define mon_prof_sample(ctx)	do {} while (0)
+
+#endif
+
+static inline void
+mon_tick(struct monitor_context *ctx) {
 	ctx->tick++;
 	if (ctx->tick >= mon_env.tick_max) {
 		ctx->tick = 0;
 		mon_flush(ctx);
+		mon_prof_sample(ctx);
+	}
+}
+
+static inline void
+mon_add_cntr(struct monitor_context *ctx, int cntr, int index, size_t size) {
+	ctx->data[cntr].count[index]++;
+	if (size != MON_IGNORE_SIZE) {
+		ctx->data[cntr].sum[index] += size;
 	}
+	mon_tick(ctx);
 }
 
 static inline void
@@ -716,6 +788,8 @@ static ssize_t monitor_cq_read(struct fid_cq *cq, void *buf, size_t count)
 	if (ret>0) {
 		mon_add_cq_cntr(monitor_ctx_cq(mycq), mon_cq_read,
 		                 mycq->format, buf, ret);
+	} else if (ret == -FI_EAGAIN) {
+		mon_tick(monitor_ctx_cq(mycq));
 	}
 	return ret;
 }
@@ -730,6 +804,8 @@ monitor_cq_readfrom(struct fid_cq *cq, void *buf, size_t count, fi_addr_t *src_a
 	if (ret>0) {
 		mon_add_cq_cntr(monitor_ctx_cq(mycq), mon_cq_readfrom,
 		                 mycq->format, buf, ret);
+	} else if (ret == -FI_EAGAIN) {
+		mon_tick(monitor_ctx_cq(mycq));
 	}
 
 	return ret;
@@ -870,6 +946,45 @@ static int64_t monitor_get_id()
 	return ofi_atomic_get64(&monitor_id);
 }
 
+static int
+monitor_shm_map(const struct fi_provider *hprov, const char *name,
+		size_t size, void **addr)
+{
+	int fd, ret;
+
+	fd = open(name, O_CREAT | O_RDWR, S_IRUSR|S_IWUSR);
+	if (fd < 0) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to create shm (%s)\n",
+			strerror(errno));
+		return -FI_ENOENT;
+	}
+
+	if (fchmod(fd, mon_env.file_mode) != 0) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to chmod %s: %s\n",
+			name, strerror(errno));
+		goto error;
+	}
+
+	if (ftruncate(fd, size) != 0) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to truncate %s: %s\n",
+			name, strerror(errno));
+		goto error;
+	}
+	*addr = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	if (*addr == MAP_FAILED) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to mmap: %s\n",
+			strerror(errno));
+		goto error;
+	}
+
+	close(fd);
+	return FI_SUCCESS;
+error:
+	ret = -errno;
+	close(fd);
+	return ret;
+}
+
 static int
 monitor_shm_init(struct monitor_context *mon_ctx)
 {
@@ -884,7 +999,7 @@ monitor_shm_init(struct monitor_context *mon_ctx)
 	const char* slurm_job_id_str;
 	unsigned int slurm_job_id;
 	char *endptr;
-	int fd;
+	int ret;
 
 	errno = 0;
 	old_umask = umask(0);
@@ -969,40 +1084,16 @@ monitor_shm_init(struct monitor_context *mon_ctx)
 	FI_TRACE(hprov, FI_LOG_FABRIC, "[%s] Using file: %s\n",
 		 hprov->name, mon_ctx->shm_name);
 
-	fd = open(mon_ctx->shm_name, O_CREAT | O_RDWR, S_IRUSR|S_IWUSR);
-	if (fd < 0) {
-		FI_WARN(hprov, FI_LOG_CORE, "Failed to create shm (%s)\n",
-			strerror(errno));
-		return -FI_ENOENT;
-	}
-
-	if (fchmod(fd, mon_env.file_mode) != 0) {
-		FI_WARN(hprov, FI_LOG_CORE, "Failed to chmod %s: %s\n",
-			mon_ctx->shm_name, strerror(errno));
-		goto error;
-	}
-
-	if (ftruncate(fd, sizeof (struct monitor_mapped_data)) != 0) {
-		FI_WARN(hprov, FI_LOG_CORE, "Failed to truncate %s: %s\n",
-			mon_ctx->shm_name, strerror(errno));
-		goto error;
-	}
-	mon_ctx->share = mmap(0, sizeof (struct monitor_mapped_data), PROT_READ|PROT_WRITE,
-			      MAP_SHARED, fd, 0);
-	if (mon_ctx->share == MAP_FAILED) {
-		FI_WARN(hprov, FI_LOG_CORE, "Failed to mmap: %s\n",
-			strerror(errno));
-		goto error;
-	}
+	ret = monitor_shm_map(hprov, mon_ctx->shm_name,
+			      sizeof (struct monitor_mapped_data),
+			      (void **) &mon_ctx->share);
+	if (ret)
+		return ret;
 
 	// flush data on init
 	mon_ctx->share->flags = 0b0;
 
-	close(fd);
 	return FI_SUCCESS;
-error:
-	close(fd);
-	return -errno;
 }
 
 static int
@@ -1050,12 +1141,288 @@ monitor_shm_close(struct monitor_context *mon_ctx)
 	return FI_SUCCESS;
 }
 
+#ifdef HAVE_FABRIC_PROFILE
+
+/*
+ * The profile table lives next to the communication file, in the MON_PROF_DIR
+ * sub-directory, so that fi_mon_sampler does not pick it up.
+ */
+static int
+monitor_prof_init(struct monitor_context *mon_ctx)
+{
+	const struct fi_provider *hprov = mon_ctx->hprov;
+	char dir[PATH_MAX];
+	char name[PATH_MAX];
+	char outpath[PATH_MAX];
+	int ret;
+
+	snprintf(dir, PATH_MAX, "%s", mon_ctx->shm_name);
+	snprintf(name, PATH_MAX, "%s", mon_ctx->shm_name);
+	if (snprintf(outpath, PATH_MAX, "%s/%s", dirname(dir),
+		     MON_PROF_DIR) >= PATH_MAX) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to format profile path!\n");
+		return -EOVERFLOW;
+	}
+	if (mkdir(outpath, mon_env.dir_mode) != 0) {
+		if (errno != EEXIST) {
+			FI_WARN(hprov, FI_LOG_FABRIC,
+				"Could not create folder at %s: %s\n",
+				outpath, strerror(errno));
+			return -errno;
+		}
+	}
+	if (snprintf(mon_ctx->prof_shm_name, PATH_MAX, "%s/%s", outpath,
+		     basename(name)) >= PATH_MAX) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to format profile name!\n");
+		return -EOVERFLOW;
+	}
+
+	FI_TRACE(hprov, FI_LOG_FABRIC, "[%s] Exporting profile data to: %s\n",
+		 hprov->name, mon_ctx->prof_shm_name);
+
+	ret = monitor_shm_map(hprov, mon_ctx->prof_shm_name,
+			      sizeof (struct monitor_prof_mapped_data),
+			      (void **) &mon_ctx->prof_share);
+	if (ret) {
+		mon_ctx->prof_share = NULL;
+		return ret;
+	}
+
+	memset(mon_ctx->prof_share, 0, sizeof (*mon_ctx->prof_share));
+	mon_ctx->prof_share->version = MON_PROF_VERSION;
+	mon_ctx->prof_share->interval_ms = mon_env.prof_interval;
+	snprintf(mon_ctx->prof_share->prov_name, MON_PROF_NAME_LEN, "%s",
+		 hprov->name);
+	return FI_SUCCESS;
+}
+
+static void
+monitor_prof_close(struct monitor_context *mon_ctx)
+{
+	const struct fi_provider *hprov = mon_ctx->hprov;
+
+	if (!mon_ctx->prof_share)
+		return;
+
+	if (mon_env.linger) {
+		mon_ctx->prof_next_ms = 0;
+		mon_prof_sample(mon_ctx);
+		mon_ctx->prof_share->fin = 1;
+	} else if (unlink(mon_ctx->prof_shm_name) != 0) {
+		FI_WARN(hprov, FI_LOG_CORE, "Failed to unlink! (%s)\n",
+			strerror(errno));
+	}
+
+	munmap(mon_ctx->prof_share, sizeof (struct monitor_prof_mapped_data));
+	mon_ctx->prof_share = NULL;
+}
+
+static int
+mon_prof_event_cb(struct fid_profile *prof_fid, struct fi_profile_desc *event,
+		  void *param, size_t size, void *context)
+{
+	struct monitor_prof_ep_ctx *ep_ctx = context;
+	size_t i;
+
+	for (i = 0; i < ep_ctx->event_count; i++) {
+		if (ep_ctx->event_ids[i] == event->id) {
+			ep_ctx->event_cnt[i]++;
+			break;
+		}
+	}
+	return 0;
+}
+
+static int
+mon_prof_event_noop(struct fid_profile *prof_fid, struct fi_profile_desc *event,
+		    void *param, size_t size, void *context)
+{
+	return 0;
+}
+
+static ssize_t
+mon_prof_query(struct fid_profile *prof_fid, bool events,
+	       struct fi_profile_desc **descs)
+{
+	size_t count = 0;
+
+	if (events)
+		fi_profile_query_events(prof_fid, NULL, &count);
+	else
+		fi_profile_query_vars(prof_fid, NULL, &count);
+	if (!count)
+		return 0;
+
+	*descs = calloc(count, sizeof (**descs));
+	if (!*descs)
+		return -FI_ENOMEM;
+
+	return events ? fi_profile_query_events(prof_fid, *descs, &count) :
+			fi_profile_query_vars(prof_fid, *descs, &count);
+}
+
+static void
+mon_prof_ep_open(struct monitor_context *ctx, struct hook_ep *ep)
+{
+	struct monitor_prof_ep_ctx *ep_ctx, *cur;
+	struct fi_profile_desc *descs = NULL;
+	struct monitor_prof_ep *slot;
+	uint32_t domain_id = 0;
+	ssize_t i, count;
+	int ret;
+
+	if (!ctx->prof_share)
+		return;
+
+	ep_ctx = calloc(1, sizeof (*ep_ctx));
+	if (!ep_ctx)
+		return;
+
+	ep_ctx->ep = ep;
+	ret = fi_profile_open(&ep->hep->fid, 0, &ep_ctx->prof_fid, ep_ctx);
+	if (ret) {
+		FI_INFO(ctx->hprov, FI_LOG_EP_CTRL,
+			"[%s] Endpoint does not support fi_profile: %d\n",
+			ctx->hprov->name, ret);
+		free(ep_ctx);
+		return;
+	}
+
+	ofi_mutex_lock(&ctx->prof_lock);
+	for (i = 0; i < MON_PROF_EP_MAX; i++) {
+		if (!ctx->prof_share->ep[i].in_use)
+			break;
+	}
+	if (i == MON_PROF_EP_MAX) {
+		FI_WARN(ctx->hprov, FI_LOG_EP_CTRL,
+			"[%s] Profile table full, endpoint not exported\n",
+			ctx->hprov->name);
+		ofi_mutex_unlock(&ctx->prof_lock);
+		free(ep_ctx);
+		return;
+	}
+	ep_ctx->slot = i;
+	slot = &ctx->prof_share->ep[i];
+
+	dlist_foreach_container(&ctx->prof_eps, struct monitor_prof_ep_ctx,
+				cur, entry) {
+		if (cur->ep->domain == ep->domain) {
+			domain_id = ctx->prof_share->ep[cur->slot].domain_id;
+			break;
+		}
+	}
+	if (!domain_id)
+		domain_id = ++ctx->prof_domain_cnt;
+
+	ctx->prof_share->seq++;
+	memset(slot, 0, sizeof (*slot));
+	slot->domain_id = domain_id;
+	slot->ep_id = ++ctx->prof_ep_cnt;
+
+	// only integer variables can be exported as a single value
+	count = mon_prof_query(ep_ctx->prof_fid, false, &descs);
+	for (i = 0; i < count && ep_ctx->var_count < MON_PROF_VAR_MAX; i++) {
+		if (!OFI_VAR_DATATYPE_U64(&descs[i]))
+			continue;
+		ep_ctx->var_ids[ep_ctx->var_count] = descs[i].id;
+		snprintf(slot->vars[ep_ctx->var_count].name,
+			 MON_PROF_NAME_LEN, "%s", descs[i].name);
+		ep_ctx->var_count++;
+	}
+	free(descs);
+	descs = NULL;
+
+	count = mon_prof_query(ep_ctx->prof_fid, true, &descs);
+	for (i = 0; i < count && ep_ctx->event_count < MON_PROF_EVENT_MAX; i++) {
+		if (fi_profile_register_callback(ep_ctx->prof_fid, descs[i].id,
+						 mon_prof_event_cb, ep_ctx))
+			continue;
+		ep_ctx->event_ids[ep_ctx->event_count] = descs[i].id;
+		snprintf(slot->events[ep_ctx->event_count].name,
+			 MON_PROF_NAME_LEN, "%s", descs[i].name);
+		ep_ctx->event_count++;
+	}
+	free(descs);
+
+	slot->var_count = ep_ctx->var_count;
+	slot->event_count = ep_ctx->event_count;
+	slot->in_use = 1;
+	ctx->prof_share->seq++;
+
+	dlist_insert_tail(&ep_ctx->entry, &ctx->prof_eps);
+	ofi_mutex_unlock(&ctx->prof_lock);
+
+	FI_TRACE(ctx->hprov, FI_LOG_EP_CTRL,
+		 "[%s] Exporting profile of ep %u: vars %zu, events %zu\n",
+		 ctx->hprov->name, slot->ep_id, ep_ctx->var_count,
+		 ep_ctx->event_count);
+}
+
+/*
+ * The profile object is owned by the provider endpoint and released with it,
+ * only detach the event callbacks here.
+ */
+static void
+mon_prof_ep_close(struct monitor_context *ctx, struct hook_ep *ep)
+{
+	struct monitor_prof_ep_ctx *ep_ctx;
+	size_t i;
+
+	ofi_mutex_lock(&ctx->prof_lock);
+	dlist_foreach_container(&ctx->prof_eps, struct monitor_prof_ep_ctx,
+				ep_ctx, entry) {
+		if (ep_ctx->ep == ep)
+			goto found;
+	}
+	ofi_mutex_unlock(&ctx->prof_lock);
+	return;
+
+found:
+	dlist_remove(&ep_ctx->entry);
+	if (ctx->prof_share) {
+		ctx->prof_share->seq++;
+		memset(&ctx->prof_share->ep[ep_ctx->slot], 0,
+		       sizeof (struct monitor_prof_ep));
+		ctx->prof_share->seq++;
+	}
+	ofi_mutex_unlock(&ctx->prof_lock);
+
+	for (i = 0; i < ep_ctx->event_count; i++)
+		fi_profile_register_callback(ep_ctx->prof_fid,
+					     ep_ctx->event_ids[i],
+					     mon_prof_event_noop, NULL);
+	free(ep_ctx);
+}
+
+#else
+
+#define monitor_prof_init(mon_ctx)	(FI_SUCCESS)
+#define monitor_prof_close(mon_ctx)	do {} while (0)
+
+static inline void
+mon_prof_ep_open(struct monitor_context *ctx, struct hook_ep *ep)
+{
+	OFI_UNUSED(ctx);
+	OFI_UNUSED(ep);
+}
+
+static inline void
+mon_prof_ep_close(struct monitor_context *ctx, struct hook_ep *ep)
+{
+	OFI_UNUSED(ctx);
+	OFI_UNUSED(ep);
+}
+
+#endif
+
 static int hook_monitor_close(struct fid *fid)
 {
 	struct monitor_context *ctx =
 		&(container_of(fid, struct monitor_fabric, fabric_hook)->mon_ctx);
 
+	monitor_prof_close(ctx);
 	monitor_shm_close(ctx);
+	ofi_mutex_destroy(&ctx->prof_lock);
 
 	hook_close(fid);
 	FI_TRACE(ctx->hprov, FI_LOG_CORE, "[%s] Closing monitor hook\n", ctx->hprov->name);
@@ -1090,6 +1457,9 @@ hook_monitor_fabric(struct fi_fabric_attr *attr,
 	fab->mon_ctx.hprov = hprov;
 	memset(&fab->mon_ctx.data, 0, sizeof (fab->mon_ctx.data));
 
+	dlist_init(&fab->mon_ctx.prof_eps);
+	ofi_mutex_init(&fab->mon_ctx.prof_lock);
+
 	ofi_atomic_initialize64(&monitor_id, 0);
 	ret = monitor_shm_init(&fab->mon_ctx);
 	if (ret != FI_SUCCESS) {
@@ -1098,6 +1468,10 @@ hook_monitor_fabric(struct fi_fabric_attr *attr,
 		return -FI_EACCES;
 	}
 
+	if (mon_env.profile && monitor_prof_init(&fab->mon_ctx) != FI_SUCCESS)
+		FI_WARN(hprov, FI_LOG_FABRIC,
+			"Could not initialise profile export, disabled\n");
+
 	hook_fabric_init(&fab->fabric_hook, HOOK_MONITOR, attr->fabric, hprov,
 	                 &monitor_fabric_fid_ops, &hook_monitor_ctx);
 	*fabric = &fab->fabric_hook.fabric;
@@ -1129,10 +1503,21 @@ static int monitor_cq_init(struct fid *fid)
 static int monitor_ep_init(struct fid *fid)
 {
 	struct fid_ep *ep = container_of(fid, struct fid_ep, fid);
+	struct hook_ep *myep = container_of(ep, struct hook_ep, ep);
+
 	ep->msg = &monitor_msg_ops;
 	ep->rma = &monitor_rma_ops;
 	ep->tagged = &monitor_tagged_ops;
 
+	mon_prof_ep_open(monitor_ctx(myep), myep);
+	return 0;
+}
+
+static int monitor_ep_fini(struct fid *fid)
+{
+	struct hook_ep *myep = container_of(fid, struct hook_ep, ep.fid);
+
+	mon_prof_ep_close(monitor_ctx(myep), myep);
 	return 0;
 }
 
@@ -1176,6 +1561,22 @@ static int monitor_env_init(void)
 	if (basepath != NULL && strlen(basepath) < PATH_MAX)
 		snprintf(mon_env.basepath, PATH_MAX, "%s", basepath);
 
+#ifdef HAVE_FABRIC_PROFILE
+	fi_param_define(prov, "profile", FI_PARAM_BOOL,
+			"Whether fi_profile variables and events of endpoints are exported for fi_top. (default: %d)",
+			mon_env.profile);
+	fi_param_get_bool(prov, "profile", &mon_env.profile);
+
+	fi_param_define(prov, "profile_interval", FI_PARAM_INT,
+			"Minimum time in milliseconds between two samples of the exported fi_profile variables. (default: %d)",
+			mon_env.prof_interval);
+	fi_param_get_int(prov, "profile_interval", &mon_env.prof_interval);
+	if (mon_env.prof_interval < 0) {
+		FI_WARN(prov, FI_LOG_CORE, "Profile interval is negative!\n");
+		return -EOVERFLOW;
+	}
+#endif
+
 	return 0;
 }
 
@@ -1187,6 +1588,7 @@ HOOK_MONITOR_INI
 	hook_monitor_ctx.ini_fid[FI_CLASS_DOMAIN] = monitor_domain_init;
 	hook_monitor_ctx.ini_fid[FI_CLASS_CQ] = monitor_cq_init;
 	hook_monitor_ctx.ini_fid[FI_CLASS_EP] = monitor_ep_init;
+	hook_monitor_ctx.fini_fid[FI_CLASS_EP] = monitor_ep_fini;
 
 	return &hook_monitor_ctx.prov;
 }
@@ -33,12 +33,29 @@
 #ifndef LNX_H
 #define LNX_H
 
+#include "ofi_mb.h"
+
 #define LNX_NUM_HISTORY		4096
 #define LNX_MAX_LOCAL_EPS 	16
 #define LNX_IOV_LIMIT 		4
 #define LNX_MAX_PRIMARY_ID	((1ULL << 56) - 1)
 #define LNX_MAX_SUB_ID 		((1ULL << 8) - 1)
 
+/* Tag bits reserved for striping when FI_LNX_STRIPE_THRESHOLD is set.
+ * A stripe head carries the application tag; the remaining segments
+ * carry the stripe sequence number, segment count and segment index.
+ */
+#define LNX_STRIPE_HEAD		(1ULL << 63)
+#define LNX_STRIPE_SEG		(1ULL << 62)
+#define LNX_STRIPE_TAG_MASK	(LNX_STRIPE_HEAD | LNX_STRIPE_SEG)
+#define LNX_STRIPE_SEQ_SHIFT	16
+#define LNX_STRIPE_NUM_SHIFT	8
+#define LNX_STRIPE_IDX_MASK	((1ULL << LNX_STRIPE_NUM_SHIFT) - 1)
+/* set on a zero-length segment sent in place of this and all later
+ * segments of a stripe which could not be sent
+ */
+#define LNX_STRIPE_ABORT	(1ULL << 48)
+
 #define lnx_ep_rx_flags(lnx_ep) ((lnx_ep)->le_ep.rx_op_flags)
 
 struct lnx_match_attr {
@@ -125,6 +142,8 @@ struct lnx_peer_map {
 struct lnx_peer_ep_map {
 	struct lnx_core_ep **pem_eps;
 	int pem_num_eps;
+	uint32_t pem_stripe_tx_seq;
+	uint32_t pem_stripe_rx_seq;
 };
 
 struct lnx_peer {
@@ -143,20 +162,32 @@ struct lnx_av {
 	struct lnx_core_av *lav_core_avs;
 };
 
+/* lm_core_mrs caches the core registration for each core domain,
+ * indexed the same as ld_core_domains. Entries are filled on first use
+ * under ld_mr_lock and read without it, see lnx_mr_core_load().
+ */
 struct lnx_mr {
 	struct ofi_mr lm_mr;
 	struct fi_mr_attr lm_attr;
-	struct fid_mr *lm_core_mr;
+	struct fid_mr *lm_core_mrs[LNX_MAX_LOCAL_EPS];
 	struct iovec lm_iov[LNX_IOV_LIMIT];
 };
 
 struct lnx_domain {
 	struct util_domain ld_domain;
 	struct ofi_bufpool *ld_mem_reg_bp;
+	ofi_mutex_t ld_mr_lock;
 	struct lnx_core_domain *ld_core_domains;
 	size_t ld_iov_limit;
 	int ld_num_doms;
 	int ld_ep_idx;
+	struct ofi_bufpool *ld_stripe_bp;
+	ofi_spin_t ld_stripe_lock;
+	ofi_mutex_t ld_stripe_tx_lock;
+	ofi_atomic32_t ld_stripe_cnt;
+	struct dlist_entry ld_stripe_rxq;
+	/* sends with segments left to post, protected by ld_stripe_tx_lock */
+	struct dlist_entry ld_stripe_txq;
 };
 
 struct lnx_ep {
@@ -175,6 +206,7 @@ struct lnx_cq {
 	struct util_cq lcq_util_cq;
 	struct lnx_core_cq *lcq_core_cqs;
 	struct lnx_domain *lcq_lnx_domain;
+	struct fi_ops_cq_owner *lcq_owner_ops;
 };
 
 struct lnx_fabric {
@@ -203,10 +235,47 @@ struct lnx_rx_entry {
 	void *rx_desc[LNX_IOV_LIMIT];
 	struct lnx_ep *rx_lep;
 	struct lnx_core_ep *rx_cep;
+	struct lnx_stripe *rx_stripe;
 	uint64_t rx_ignore;
 	bool rx_global;
 };
 
+/*
+ * A tagged send of at least lnx_stripe_threshold bytes to a peer reachable
+ * over more than one core endpoint is split into one segment per endpoint.
+ * The head segment carries the application tag and is matched like any
+ * other message; all heads to a peer travel over the same endpoint and
+ * peer address, so the receiver numbers them in arrival order and uses
+ * that number to find the rest of the segments. The transfer is
+ * reported to the application once every segment has completed.
+ */
+struct lnx_stripe {
+	struct dlist_entry ls_entry;
+	/* segments which arrived before the head was matched */
+	struct dlist_entry ls_segq;
+	struct lnx_ep *ls_lep;
+	fi_addr_t ls_addr;
+	uint32_t ls_seq;
+	bool ls_tx;
+	bool ls_matched;
+	bool ls_discard;
+	bool ls_abort;
+	int ls_num_segs;
+	int ls_next_seg;
+	struct lnx_peer *ls_peer;
+	int ls_done;
+	size_t ls_seg_len;
+	size_t ls_len;
+	void *ls_context;
+	uint64_t ls_flags;
+	uint64_t ls_tag;
+	uint64_t ls_data;
+	size_t ls_count;
+	struct iovec ls_iov[LNX_IOV_LIMIT];
+	void *ls_desc;
+	struct fi_cq_err_entry ls_err;
+};
+
 OFI_DECLARE_FREESTACK(struct lnx_rx_entry, lnx_recv_fs);
 
 
@@ -214,6 +283,7 @@ extern struct util_prov lnx_util_prov;
 extern struct fi_provider lnx_prov;
 extern struct ofi_bufpool *global_recv_bp;
 extern ofi_spin_t global_bplock;
+extern size_t lnx_stripe_threshold;
 
 int lnx_getinfo(uint32_t version, const char *node, const char *service,
 				uint64_t flags, const struct fi_info *hints,
@@ -259,6 +329,66 @@ int lnx_mr_regattr(struct fid *fid, const struct fi_mr_attr *attr,
 int lnx_mr_regattr_core(struct lnx_core_domain *cd, void *desc,
 			void **core_desc);
 
+int lnx_stripe_init(struct lnx_domain *domain);
+void lnx_stripe_fini(struct lnx_domain *domain);
+ssize_t lnx_stripe_send(struct lnx_ep *lep, struct lnx_peer *lp,
+			const void *buf, size_t len, void *desc,
+			uint64_t data, uint64_t tag, uint64_t flags,
+			void *context);
+int lnx_stripe_rx_head(struct lnx_ep *lep, fi_addr_t addr, uint64_t tag,
+		       size_t len, struct lnx_stripe **ls);
+int lnx_stripe_rx_seg(struct lnx_ep *lep, fi_addr_t addr, uint64_t tag,
+		      struct lnx_stripe **ls, bool *matched);
+void lnx_stripe_match(struct lnx_stripe *ls, struct lnx_rx_entry *rx_entry,
+		      void *desc);
+int lnx_stripe_setup_seg(struct lnx_stripe *ls,
+			 struct lnx_rx_entry *rx_entry);
+void lnx_stripe_queue_seg(struct lnx_rx_entry *rx_entry);
+void lnx_stripe_discard(struct lnx_stripe *ls);
+void lnx_stripe_progress(struct lnx_domain *domain);
+extern struct fi_ops_cq_owner lnx_stripe_cq_owner_ops;
+
+static inline struct fid_mr *lnx_mr_core_load(struct fid_mr **core_mr)
+{
+#ifdef HAVE_BUILTIN_MM_ATOMICS
+	return __atomic_load_n(core_mr, __ATOMIC_ACQUIRE);
+#else
+	struct fid_mr *mr = *(struct fid_mr * volatile *) core_mr;
+
+	ofi_mb();
+	return mr;
+#endif
+}
+
+static inline void lnx_mr_core_store(struct fid_mr **core_mr,
+				     struct fid_mr *mr)
+{
+#ifdef HAVE_BUILTIN_MM_ATOMICS
+	__atomic_store_n(core_mr, mr, __ATOMIC_RELEASE);
+#else
+	ofi_wmb();
+	*(struct fid_mr * volatile *) core_mr = mr;
+#endif
+}
+
+static inline int
+lnx_mr_core_desc(struct lnx_core_domain *cd, void *desc, void **core_desc)
+{
+	struct lnx_mr *lm = desc;
+	struct lnx_domain *domain;
+	struct fid_mr *core_mr;
+
+	domain = container_of(lm->lm_mr.domain, struct lnx_domain, ld_domain);
+	core_mr = lnx_mr_core_load(
+			&lm->lm_core_mrs[cd - domain->ld_core_domains]);
+	if (OFI_LIKELY(core_mr != NULL)) {
+		*core_desc = core_mr->mem_desc;
+		return FI_SUCCESS;
+	}
+
+	return lnx_mr_regattr_core(cd, desc, core_desc);
+}
+
 static inline fi_addr_t
 lnx_encode_fi_addr(uint64_t primary_id, uint8_t sub_id)
 {
@@ -329,4 +459,41 @@ lnx_select_send_endpoints(struct lnx_ep *lep, fi_addr_t lnx_addr,
 	return FI_SUCCESS;
 }
 
+/*
+ * The tag bits reserved for striping are cleared from mem_tag_format, and
+ * a tag using them would be taken for a stripe by the receiver.
+ */
+static inline int lnx_check_tag(uint64_t tag)
+{
+	if (lnx_stripe_threshold && (tag & LNX_STRIPE_TAG_MASK)) {
+		FI_WARN(&lnx_prov, FI_LOG_CORE,
+			"tag %" PRIx64 " uses bits reserved for striping\n",
+			tag);
+		return -FI_EINVAL;
+	}
+	return FI_SUCCESS;
+}
+
+/*
+ * Returns the peer if a tagged send of len bytes should be striped.
+ * Reassembly needs the source of every segment, so striping is only
+ * used when the endpoint reports source addresses.
+ */
+static inline struct lnx_peer *
+lnx_stripe_peer(struct lnx_ep *lep, fi_addr_t lnx_addr, size_t len,
+		uint64_t tag)
+{
+	struct lnx_peer *lp;
+
+	if (!lnx_stripe_threshold || len < lnx_stripe_threshold ||
+	    !(lep->le_ep.caps & (FI_SOURCE | FI_DIRECTED_RECV)))
+		return NULL;
+
+	lp = lnx_av_lookup_addr(lep->le_lav, lnx_addr);
+	if (!lp || lp->lp_src_eps[lep->le_idx].pem_num_eps < 2)
+		return NULL;
+
+	return lp;
+}
+
 #endif /* LNX_H */
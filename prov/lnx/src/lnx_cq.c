@@ -100,6 +100,7 @@ static void lnx_cq_progress(struct util_cq *cq)
 		core_cq = &lnx_cq->lcq_core_cqs[i];
 		fi_cq_read(core_cq->cc_cq, NULL, 0);
 	}
+	lnx_stripe_progress(lnx_cq->lcq_lnx_domain);
 	ofi_genlock_unlock(gen_lock);
 }
 
@@ -164,6 +165,12 @@ int lnx_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 
 	lnx_cq->lcq_lnx_domain = lnx_dom;
 	lnx_cq->lcq_util_cq.cq_fid.fid.ops = &lnx_cq_fi_ops;
+
+	/* the core providers write through these; striped transfers are
+	 * only reported once their last segment completes
+	 */
+	lnx_cq->lcq_owner_ops = lnx_cq->lcq_util_cq.peer_cq->owner_ops;
+	lnx_cq->lcq_util_cq.peer_cq->owner_ops = &lnx_stripe_cq_owner_ops;
 	(*cq_fid) = &lnx_cq->lcq_util_cq.cq_fid;
 
 	/* open core CQs and tell them to import my CQ */
@@ -82,6 +82,8 @@ static int lnx_domain_close(struct fid *fid)
 	}
 
 	ofi_bufpool_destroy(domain->ld_mem_reg_bp);
+	ofi_mutex_destroy(&domain->ld_mr_lock);
+	lnx_stripe_fini(domain);
 
 	rc = ofi_domain_close(&domain->ld_domain);
 	if (rc)
@@ -210,6 +212,11 @@ int lnx_domain_open(struct fid_fabric *fabric, struct fi_info *info,
 	bp_attrs.chunk_cnt = 256;
 	bp_attrs.flags = OFI_BUFPOOL_NO_TRACK;
 	rc = ofi_bufpool_create_attr(&bp_attrs, &lnx_domain->ld_mem_reg_bp);
+	if (rc)
+		goto out;
+	ofi_mutex_init(&lnx_domain->ld_mr_lock);
+
+	rc = lnx_stripe_init(lnx_domain);
 	if (rc)
 		goto out;
 
@@ -59,6 +59,7 @@
 
 ofi_spin_t global_bplock;
 struct ofi_bufpool *global_recv_bp = NULL;
+size_t lnx_stripe_threshold;
 
 struct util_fabric lnx_fabric_info;
 
@@ -418,6 +419,11 @@ static int lnx_generate_link_info(struct fi_info **info, const struct fi_info *h
 		next->tx_attr->inject_size = min_inject_size;
 		next->tx_attr->iov_limit = min_iov_limit;
 		next->ep_attr->max_msg_size = min_of_max_msg_size;
+		if (lnx_stripe_threshold &&
+		    ofi_max_tag(next->ep_attr->mem_tag_format) >
+		    ~LNX_STRIPE_TAG_MASK)
+			next->ep_attr->mem_tag_format =
+				ofi_tag_format(~LNX_STRIPE_TAG_MASK);
 		next->rx_attr->size = min_rx_size;
 		next->tx_attr->size = min_tx_size;
 
@@ -771,6 +777,17 @@ LNX_INI
 	fi_param_define(&lnx_prov, "dump_stats", FI_PARAM_BOOL,
 			"Dump LNX stats on shutdown. Defaults to 0");
 
+	fi_param_define(&lnx_prov, "stripe_threshold", FI_PARAM_SIZE_T,
+			"Stripe tagged sends of at least this many bytes "
+			"across all endpoints linked to the peer. Reserves "
+			"the two most significant tag bits. Must be set the "
+			"same on all processes. Defaults to 0 (disabled)");
+	fi_param_get_size_t(&lnx_prov, "stripe_threshold",
+			    &lnx_stripe_threshold);
+	if (lnx_stripe_threshold)
+		lnx_ep_attr.mem_tag_format =
+			ofi_tag_format(~LNX_STRIPE_TAG_MASK);
+
 	dlist_init(&lnx_links);
 
 	if (!global_recv_bp) {
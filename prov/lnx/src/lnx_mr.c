@@ -58,34 +58,51 @@
  * target core provider we can do memory registration at that point
  */
 
+/*
+ * Slow path of lnx_mr_core_desc(): register the memory with the core
+ * domain the first time it is used there. The registration is kept for
+ * the lifetime of the lnx MR so later operations only do a lookup.
+ */
 int lnx_mr_regattr_core(struct lnx_core_domain *cd, void *desc, void **core_desc)
 {
-	int rc;
+	int rc = FI_SUCCESS;
 	struct lnx_mr *lm;
+	struct lnx_domain *domain;
+	struct fid_mr **core_mr, *mr;
 
 	lm = (struct lnx_mr *)desc;
-	if (lm->lm_core_mr)
-		goto out;
+	domain = container_of(lm->lm_mr.domain, struct lnx_domain, ld_domain);
+	core_mr = &lm->lm_core_mrs[cd - domain->ld_core_domains];
+
+	ofi_mutex_lock(&domain->ld_mr_lock);
+	mr = *core_mr;
+	if (!mr) {
+		rc = fi_mr_regattr(cd->cd_domain, &lm->lm_attr,
+				   lm->lm_mr.flags, &mr);
+		if (rc)
+			goto unlock;
 
-	rc = fi_mr_regattr(cd->cd_domain, &lm->lm_attr, lm->lm_mr.flags,
-			   &lm->lm_core_mr);
-	if (rc)
-		return rc;
+		/* publish only once the registration is complete */
+		lnx_mr_core_store(core_mr, mr);
+	}
 
-out:
-	*core_desc = lm->lm_core_mr->mem_desc;
-	return FI_SUCCESS;
+	*core_desc = mr->mem_desc;
+unlock:
+	ofi_mutex_unlock(&domain->ld_mr_lock);
+	return rc;
 }
 
 static int lnx_mr_close(struct fid *fid)
 {
-	int rc, frc = FI_SUCCESS;
+	int i, rc, frc = FI_SUCCESS;
 	struct lnx_mr *lm;
 
 	lm = container_of(fid, struct lnx_mr, lm_mr.mr_fid.fid);
 
-	if (lm->lm_core_mr) {
-		rc = fi_close(&lm->lm_core_mr->fid);
+	for (i = 0; i < LNX_MAX_LOCAL_EPS; i++) {
+		if (!lm->lm_core_mrs[i])
+			continue;
+		rc = fi_close(&lm->lm_core_mrs[i]->fid);
 		if (rc)
 			frc = rc;
 	}
@@ -191,11 +191,50 @@ int lnx_queue_tag(struct fi_peer_rx_entry *entry)
 		"addr = %lx tag = %lx ignore = 0 found\n",
 		entry->addr, entry->tag);
 
+	if (rx_entry->rx_stripe && (entry->tag & LNX_STRIPE_SEG)) {
+		lnx_stripe_queue_seg(rx_entry);
+		return 0;
+	}
+
 	lnx_insert_rx_entry(&lnx_srq->lps_trecv.lqp_unexq, rx_entry);
 
 	return 0;
 }
 
+/* Stripe segments other than the head are never matched against posted
+ * receives; they go to the buffer their head was matched to.
+ */
+static int
+lnx_get_stripe_seg(struct lnx_core_ep *cep, struct fi_peer_match_attr *match,
+		   struct fi_peer_rx_entry **entry)
+{
+	struct lnx_ep *lep = cep->cep_parent;
+	struct lnx_rx_entry *rx_entry;
+	struct lnx_stripe *ls;
+	bool matched;
+	int rc;
+
+	rc = lnx_stripe_rx_seg(lep, match->addr, match->tag, &ls, &matched);
+	if (rc)
+		return rc;
+
+	rx_entry = get_rx_entry(lep, NULL, NULL, 0, match->addr, match->tag,
+				0, NULL, FI_TAGGED | FI_RECV);
+	if (!rx_entry)
+		return -FI_ENOMEM;
+
+	rx_entry->rx_entry.owner_context = &lep->le_srq;
+	rx_entry->rx_entry.msg_size = match->msg_size;
+	rx_entry->rx_cep = cep;
+	rx_entry->rx_stripe = ls;
+	*entry = &rx_entry->rx_entry;
+
+	if (!matched)
+		return -FI_ENOENT;
+
+	return lnx_stripe_setup_seg(ls, rx_entry);
+}
+
 int lnx_get_tag(struct fid_peer_srx *srx, struct fi_peer_match_attr *match,
 		struct fi_peer_rx_entry **entry)
 {
@@ -204,6 +243,7 @@ int lnx_get_tag(struct fid_peer_srx *srx, struct fi_peer_match_attr *match,
 	struct lnx_core_ep *cep;
 	struct lnx_ep *lep;
 	struct lnx_rx_entry *rx_entry;
+	struct lnx_stripe *ls = NULL;
 	fi_addr_t addr = match->addr;
 	uint64_t tag = match->tag;
 	int rc = 0;
@@ -212,6 +252,16 @@ int lnx_get_tag(struct fid_peer_srx *srx, struct fi_peer_match_attr *match,
 	lep = cep->cep_parent;
 	lnx_srq = &lep->le_srq;
 
+	if (lnx_stripe_threshold && (tag & LNX_STRIPE_TAG_MASK)) {
+		if (tag & LNX_STRIPE_SEG)
+			return lnx_get_stripe_seg(cep, match, entry);
+
+		rc = lnx_stripe_rx_head(lep, addr, tag, match->msg_size, &ls);
+		if (rc)
+			return rc;
+		tag &= ~LNX_STRIPE_TAG_MASK;
+	}
+
 	match_attr.lm_addr = addr;
 	match_attr.lm_tag = tag;
 
@@ -238,6 +288,7 @@ int lnx_get_tag(struct fid_peer_srx *srx, struct fi_peer_match_attr *match,
 
 	rx_entry->rx_entry.owner_context = lnx_srq;
 	rx_entry->rx_cep = cep;
+	rx_entry->rx_stripe = ls;
 
 	rc = -FI_ENOENT;
 
@@ -248,11 +299,14 @@ int lnx_get_tag(struct fid_peer_srx *srx, struct fi_peer_match_attr *match,
 assign:
 	cep->cep_t_stats.st_num_posted_recvs++;
 
+	if (ls)
+		lnx_stripe_match(ls, rx_entry, *rx_entry->rx_entry.desc);
+
 	rx_entry->rx_entry.addr = lnx_get_core_addr(cep, addr);
 	if (rx_entry->rx_entry.desc && *rx_entry->rx_entry.desc) {
-		rc = lnx_mr_regattr_core(cep->cep_domain,
-					 *rx_entry->rx_entry.desc,
-					 rx_entry->rx_entry.desc);
+		rc = lnx_mr_core_desc(cep->cep_domain,
+				      *rx_entry->rx_entry.desc,
+				      rx_entry->rx_entry.desc);
 		if (rc)
 			return rc;
 	}
@@ -277,6 +331,9 @@ lnx_discard(struct lnx_ep *lep, struct lnx_rx_entry *rx_entry, void *context)
 			cep->cep_domain->cd_info->fabric_attr->name);
 	}
 
+	if (rx_entry->rx_stripe)
+		lnx_stripe_discard(rx_entry->rx_stripe);
+
 	rc = ofi_cq_write(lep->le_ep.rx_cq, context,
 			  rx_entry->rx_entry.flags,
 			  rx_entry->rx_entry.msg_size, NULL,
@@ -353,6 +410,12 @@ static int lnx_process_recv(struct lnx_ep *lep, const struct iovec *iov, void *d
 	int rc = 0;
 	fi_addr_t sub_addr, encoded_addr = lnx_encode_fi_addr(addr, 0);
 
+	if (tagged) {
+		rc = lnx_check_tag(tag);
+		if (rc)
+			return rc;
+	}
+
 	/* Matching format should always be in the encoded form */
 	match_attr.lm_addr = (addr == FI_ADDR_UNSPEC) ||
 		!(lep->le_ep.caps & FI_DIRECTED_RECV) ? FI_ADDR_UNSPEC :
@@ -399,9 +462,12 @@ static int lnx_process_recv(struct lnx_ep *lep, const struct iovec *iov, void *d
 	rx_entry->rx_entry.msg_size = MIN(ofi_total_iov_len(iov, count),
 				          rx_entry->rx_entry.msg_size);
 
+	if (rx_entry->rx_stripe)
+		lnx_stripe_match(rx_entry->rx_stripe, rx_entry, desc);
+
 	if (desc) {
-		rc = lnx_mr_regattr_core(cep->cep_domain, desc,
-					 rx_entry->rx_entry.desc);
+		rc = lnx_mr_core_desc(cep->cep_domain, desc,
+				      rx_entry->rx_entry.desc);
 		if (rc)
 			return rc;
 	}
@@ -521,12 +587,22 @@ ssize_t lnx_tsend(struct fid_ep *ep, const void *buf, size_t len, void *desc,
 	struct lnx_ep *lep;
 	void *core_desc = NULL;
 	struct lnx_core_ep *cep;
+	struct lnx_peer *lp;
 	fi_addr_t core_addr;
 
 	lep = container_of(ep, struct lnx_ep, le_ep.ep_fid.fid);
 	if (!lep)
 		return -FI_ENOSYS;
 
+	rc = lnx_check_tag(tag);
+	if (rc)
+		return rc;
+
+	lp = lnx_stripe_peer(lep, dest_addr, len, tag);
+	if (lp)
+		return lnx_stripe_send(lep, lp, buf, len, desc, 0, tag,
+				       lep->le_ep.tx_op_flags, context);
+
 	rc = lnx_select_send_endpoints(lep, dest_addr, &cep, &core_addr);
 	if (rc)
 		return rc;
@@ -536,7 +612,7 @@ ssize_t lnx_tsend(struct fid_ep *ep, const void *buf, size_t len, void *desc,
 	       core_addr, tag, buf, len);
 
 	if (desc) {
-		rc = lnx_mr_regattr_core(cep->cep_domain, desc, &core_desc);
+		rc = lnx_mr_core_desc(cep->cep_domain, desc, &core_desc);
 		if (rc)
 			return rc;
 	}
@@ -556,12 +632,26 @@ ssize_t lnx_tsendv(struct fid_ep *ep, const struct iovec *iov, void **desc,
 	struct lnx_ep *lep;
 	void *core_desc = NULL;
 	struct lnx_core_ep *cep;
+	struct lnx_peer *lp;
 	fi_addr_t core_addr;
 
 	lep = container_of(ep, struct lnx_ep, le_ep.ep_fid.fid);
 	if (!lep)
 		return -FI_ENOSYS;
 
+	rc = lnx_check_tag(tag);
+	if (rc)
+		return rc;
+
+	if (count == 1) {
+		lp = lnx_stripe_peer(lep, dest_addr, iov->iov_len, tag);
+		if (lp)
+			return lnx_stripe_send(lep, lp, iov->iov_base,
+					       iov->iov_len,
+					       desc ? *desc : NULL, 0, tag,
+					       lep->le_ep.tx_op_flags, context);
+	}
+
 	rc = lnx_select_send_endpoints(lep, dest_addr, &cep, &core_addr);
 	if (rc)
 		return rc;
@@ -571,7 +661,7 @@ ssize_t lnx_tsendv(struct fid_ep *ep, const struct iovec *iov, void **desc,
 	       core_addr, tag, iov->iov_base, iov->iov_len);
 
 	if (desc && *desc) {
-		rc = lnx_mr_regattr_core(cep->cep_domain, *desc, &core_desc);
+		rc = lnx_mr_core_desc(cep->cep_domain, *desc, &core_desc);
 		if (rc)
 			return rc;
 	}
@@ -592,6 +682,7 @@ ssize_t lnx_tsendmsg(struct fid_ep *ep, const struct fi_msg_tagged *msg,
 	struct lnx_ep *lep;
 	void *core_desc = NULL;
 	struct lnx_core_ep *cep;
+	struct lnx_peer *lp;
 	struct fi_msg_tagged core_msg;
 
 	memcpy(&core_msg, msg, sizeof(*msg));
@@ -600,6 +691,22 @@ ssize_t lnx_tsendmsg(struct fid_ep *ep, const struct fi_msg_tagged *msg,
 	if (!lep)
 		return -FI_ENOSYS;
 
+	rc = lnx_check_tag(msg->tag);
+	if (rc)
+		return rc;
+
+	if (msg->iov_count == 1 && !(flags & FI_INJECT)) {
+		lp = lnx_stripe_peer(lep, msg->addr, msg->msg_iov->iov_len,
+				     msg->tag);
+		if (lp)
+			return lnx_stripe_send(lep, lp, msg->msg_iov->iov_base,
+					msg->msg_iov->iov_len,
+					msg->desc ? *msg->desc : NULL,
+					msg->data, msg->tag,
+					flags | lep->le_ep.tx_msg_flags,
+					msg->context);
+	}
+
 	rc = lnx_select_send_endpoints(lep, core_msg.addr, &cep, &core_msg.addr);
 	if (rc)
 		return rc;
@@ -609,7 +716,7 @@ ssize_t lnx_tsendmsg(struct fid_ep *ep, const struct fi_msg_tagged *msg,
 	       core_msg.addr, core_msg.tag);
 
 	if (core_msg.desc && *core_msg.desc) {
-		rc = lnx_mr_regattr_core(cep->cep_domain, *core_msg.desc, &core_desc);
+		rc = lnx_mr_core_desc(cep->cep_domain, *core_msg.desc, &core_desc);
 		if (rc)
 			return rc;
 		core_msg.desc = &core_desc;
@@ -635,6 +742,10 @@ ssize_t lnx_tinject(struct fid_ep *ep, const void *buf, size_t len,
 	if (!lep)
 		return -FI_ENOSYS;
 
+	rc = lnx_check_tag(tag);
+	if (rc)
+		return rc;
+
 	rc = lnx_select_send_endpoints(lep, dest_addr, &cep, &core_addr);
 	if (rc)
 		return rc;
@@ -657,6 +768,7 @@ ssize_t lnx_tsenddata(struct fid_ep *ep, const void *buf, size_t len, void *desc
 	int rc;
 	struct lnx_ep *lep;
 	struct lnx_core_ep *cep;
+	struct lnx_peer *lp;
 	fi_addr_t core_addr;
 	void *core_desc = desc;
 
@@ -664,6 +776,16 @@ ssize_t lnx_tsenddata(struct fid_ep *ep, const void *buf, size_t len, void *desc
 	if (!lep)
 		return -FI_ENOSYS;
 
+	rc = lnx_check_tag(tag);
+	if (rc)
+		return rc;
+
+	lp = lnx_stripe_peer(lep, dest_addr, len, tag);
+	if (lp)
+		return lnx_stripe_send(lep, lp, buf, len, desc, data, tag,
+				       lep->le_ep.tx_op_flags |
+				       FI_REMOTE_CQ_DATA, context);
+
 	rc = lnx_select_send_endpoints(lep, dest_addr, &cep, &core_addr);
 	if (rc)
 		return rc;
@@ -673,7 +795,7 @@ ssize_t lnx_tsenddata(struct fid_ep *ep, const void *buf, size_t len, void *desc
 	       core_addr, tag, buf, len);
 
 	if (desc) {
-		rc = lnx_mr_regattr_core(cep->cep_domain, desc, &core_desc);
+		rc = lnx_mr_core_desc(cep->cep_domain, desc, &core_desc);
 		if (rc)
 			return rc;
 	}
@@ -699,6 +821,10 @@ ssize_t lnx_tinjectdata(struct fid_ep *ep, const void *buf, size_t len,
 	if (!lep)
 		return -FI_ENOSYS;
 
+	rc = lnx_check_tag(tag);
+	if (rc)
+		return rc;
+
 	rc = lnx_select_send_endpoints(lep, dest_addr, &cep, &core_addr);
 	if (rc)
 		return rc;
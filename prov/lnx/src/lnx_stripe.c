@@ -0,0 +1,746 @@
+/*
+ * Copyright (c) 2025 ORNL. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rdma/fi_errno.h>
+#include "ofi_util.h"
+#include "ofi.h"
+#include "ofi_iov.h"
+#include "ofi_prov.h"
+#include "rdma/fi_ext.h"
+#include "lnx.h"
+
+/*
+ * Striping of large tagged sends across the core endpoints linked to a
+ * peer.
+ *
+ * Segment 0, the head, is sent with the application tag and
+ * LNX_STRIPE_HEAD set. It is matched against the posted receives like
+ * any other message and lands at offset 0 of the matched buffer. Segment
+ * i > 0 is sent with LNX_STRIPE_SEG, the stripe sequence number, the
+ * number of segments and i encoded in the tag, and lands at offset
+ * i * <head length>.
+ *
+ * The sender numbers stripes per peer and always sends heads over the
+ * same core endpoint and peer address, so heads arrive in order and the
+ * receiver can number them the same way. Segments which arrive before
+ * their head has been matched are queued on the stripe and started from
+ * the CQ progress function once the buffer is known.
+ *
+ * Segments which a core endpoint cannot accept yet are queued on the
+ * domain and posted from the CQ progress function. If a segment cannot
+ * be sent at all once the head is out, a zero-length segment flagged
+ * with LNX_STRIPE_ABORT is sent over the head's endpoint in its place.
+ * It stands in for that segment and every later one, and the receiver
+ * completes the transfer in error.
+ *
+ * Every segment is posted with the stripe as its context. The lnx CQ
+ * intercepts the core completions for those contexts and reports the
+ * transfer to the application once the last segment has completed.
+ */
+
+static struct lnx_stripe *lnx_stripe_alloc(struct lnx_domain *domain)
+{
+	struct lnx_stripe *ls;
+
+	ls = ofi_buf_alloc(domain->ld_stripe_bp);
+	if (!ls)
+		return NULL;
+
+	memset(ls, 0, sizeof(*ls));
+	dlist_init(&ls->ls_segq);
+	ofi_atomic_inc32(&domain->ld_stripe_cnt);
+
+	return ls;
+}
+
+static void lnx_stripe_free(struct lnx_domain *domain, struct lnx_stripe *ls)
+{
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	ofi_buf_free(ls);
+	ofi_atomic_dec32(&domain->ld_stripe_cnt);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+}
+
+int lnx_stripe_init(struct lnx_domain *domain)
+{
+	struct ofi_bufpool_attr bp_attrs = {0};
+	int rc;
+
+	bp_attrs.size = sizeof(struct lnx_stripe);
+	bp_attrs.alignment = 8;
+	bp_attrs.max_cnt = UINT16_MAX;
+	bp_attrs.chunk_cnt = 64;
+	bp_attrs.flags = OFI_BUFPOOL_NO_TRACK;
+	rc = ofi_bufpool_create_attr(&bp_attrs, &domain->ld_stripe_bp);
+	if (rc)
+		return rc;
+
+	ofi_spin_init(&domain->ld_stripe_lock);
+	ofi_mutex_init(&domain->ld_stripe_tx_lock);
+	ofi_atomic_initialize32(&domain->ld_stripe_cnt, 0);
+	dlist_init(&domain->ld_stripe_rxq);
+	dlist_init(&domain->ld_stripe_txq);
+
+	return 0;
+}
+
+void lnx_stripe_fini(struct lnx_domain *domain)
+{
+	if (!domain->ld_stripe_bp)
+		return;
+
+	ofi_bufpool_destroy(domain->ld_stripe_bp);
+	ofi_spin_destroy(&domain->ld_stripe_lock);
+	ofi_mutex_destroy(&domain->ld_stripe_tx_lock);
+}
+
+/* Stripes are the only contexts lnx hands to the core providers, and
+ * they all live in ld_stripe_bp.
+ */
+static bool lnx_stripe_owns(struct lnx_domain *domain, void *context)
+{
+	struct ofi_bufpool *bp = domain->ld_stripe_bp;
+	struct ofi_bufpool_region *region;
+	char *ctx = context;
+	bool ret = false;
+	size_t i;
+
+	if (OFI_LIKELY(!ofi_atomic_get32(&domain->ld_stripe_cnt)))
+		return false;
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	for (i = 0; i < bp->region_cnt; i++) {
+		region = bp->region_table[i];
+		if (ctx >= region->mem_region &&
+		    ctx < region->mem_region + bp->region_size) {
+			ret = true;
+			break;
+		}
+	}
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	return ret;
+}
+
+/* Called with ld_stripe_lock held. Returns true once every segment of
+ * the stripe has completed.
+ */
+static bool lnx_stripe_seg_done(struct lnx_stripe *ls)
+{
+	ls->ls_done++;
+	if (!ls->ls_num_segs || ls->ls_done < ls->ls_num_segs)
+		return false;
+
+	if (!ls->ls_tx)
+		dlist_remove(&ls->ls_entry);
+	return true;
+}
+
+static void lnx_stripe_report(struct lnx_stripe *ls, fi_addr_t src)
+{
+	struct util_cq *cq;
+	struct lnx_cq *lcq;
+
+	cq = ls->ls_tx ? ls->ls_lep->le_ep.tx_cq : ls->ls_lep->le_ep.rx_cq;
+	lcq = container_of(cq, struct lnx_cq, lcq_util_cq);
+
+	if (ls->ls_err.err) {
+		ls->ls_err.op_context = ls->ls_context;
+		ls->ls_err.flags = ls->ls_flags & ~FI_COMPLETION;
+		ls->ls_err.len = ls->ls_len;
+		ls->ls_err.data = ls->ls_data;
+		ls->ls_err.tag = ls->ls_tag;
+		ls->ls_err.err_data = NULL;
+		ls->ls_err.err_data_size = 0;
+		lcq->lcq_owner_ops->writeerr(cq->peer_cq, &ls->ls_err);
+	} else if (ls->ls_flags & FI_COMPLETION) {
+		lcq->lcq_owner_ops->write(cq->peer_cq, ls->ls_context,
+					  ls->ls_flags & ~FI_COMPLETION,
+					  ls->ls_len, NULL, ls->ls_data,
+					  ls->ls_tag, src);
+	}
+}
+
+static void lnx_stripe_seg_error(struct lnx_stripe *ls, int err, int count)
+{
+	struct lnx_domain *domain = ls->ls_lep->le_domain;
+	bool done = false;
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	if (!ls->ls_err.err)
+		ls->ls_err.err = err;
+	while (count-- && !done)
+		done = lnx_stripe_seg_done(ls);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	if (done) {
+		lnx_stripe_report(ls, FI_ADDR_NOTAVAIL);
+		lnx_stripe_free(domain, ls);
+	}
+}
+
+static ssize_t
+lnx_stripe_cq_write(struct fid_peer_cq *cq, void *context, uint64_t flags,
+		    size_t len, void *buf, uint64_t data, uint64_t tag,
+		    fi_addr_t src)
+{
+	struct util_cq *util_cq = cq->fid.context;
+	struct lnx_cq *lcq = container_of(util_cq, struct lnx_cq, lcq_util_cq);
+	struct lnx_domain *domain = lcq->lcq_lnx_domain;
+	struct lnx_stripe *ls = context;
+	bool done;
+
+	if (!lnx_stripe_owns(domain, context))
+		return lcq->lcq_owner_ops->write(cq, context, flags, len, buf,
+						 data, tag, src);
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	ls->ls_len += len;
+	if (flags & FI_REMOTE_CQ_DATA) {
+		ls->ls_flags |= FI_REMOTE_CQ_DATA;
+		ls->ls_data = data;
+	}
+	done = lnx_stripe_seg_done(ls);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	if (done) {
+		lnx_stripe_report(ls, src);
+		lnx_stripe_free(domain, ls);
+	}
+
+	return 0;
+}
+
+static ssize_t
+lnx_stripe_cq_writeerr(struct fid_peer_cq *cq,
+		       const struct fi_cq_err_entry *err_entry)
+{
+	struct util_cq *util_cq = cq->fid.context;
+	struct lnx_cq *lcq = container_of(util_cq, struct lnx_cq, lcq_util_cq);
+	struct lnx_domain *domain = lcq->lcq_lnx_domain;
+	struct lnx_stripe *ls = err_entry->op_context;
+	bool done;
+
+	if (!lnx_stripe_owns(domain, err_entry->op_context))
+		return lcq->lcq_owner_ops->writeerr(cq, err_entry);
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	if (!ls->ls_err.err)
+		ls->ls_err = *err_entry;
+	ls->ls_len += err_entry->len;
+	done = lnx_stripe_seg_done(ls);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	if (done) {
+		lnx_stripe_report(ls, FI_ADDR_NOTAVAIL);
+		lnx_stripe_free(domain, ls);
+	}
+
+	return 0;
+}
+
+struct fi_ops_cq_owner lnx_stripe_cq_owner_ops = {
+	.size = sizeof(struct fi_ops_cq_owner),
+	.write = lnx_stripe_cq_write,
+	.writeerr = lnx_stripe_cq_writeerr,
+};
+
+static fi_addr_t
+lnx_stripe_core_addr(struct lnx_core_ep *cep, struct lnx_peer *lp, bool head)
+{
+	struct lnx_peer_map *map_addr;
+	int rr;
+
+	map_addr = ofi_bufpool_get_ibuf(cep->cep_cav->cav_map, lp->lp_addr);
+
+	/* heads must stay ordered, so they always use the first address */
+	if (head)
+		return map_addr->map_addrs[0];
+
+	rr = ofi_atomic_get32(&map_addr->map_rr);
+	ofi_atomic_inc32(&map_addr->map_rr);
+	return map_addr->map_addrs[rr % map_addr->map_count];
+}
+
+static ssize_t
+lnx_stripe_post(struct lnx_core_ep *cep, fi_addr_t addr, const void *buf,
+		size_t len, void *desc, uint64_t data, uint64_t tag,
+		uint64_t flags, struct lnx_stripe *ls)
+{
+	struct fi_msg_tagged msg;
+	struct iovec iov;
+	void *core_desc = NULL;
+	int rc;
+
+	if (desc) {
+		rc = lnx_mr_core_desc(cep->cep_domain, desc, &core_desc);
+		if (rc)
+			return rc;
+	}
+
+	iov.iov_base = (void *) buf;
+	iov.iov_len = len;
+
+	msg.msg_iov = &iov;
+	msg.desc = core_desc ? &core_desc : NULL;
+	msg.iov_count = 1;
+	msg.addr = addr;
+	msg.tag = tag;
+	msg.ignore = 0;
+	msg.context = ls;
+	msg.data = data;
+
+	return fi_tsendmsg(cep->cep_ep, &msg, flags | FI_COMPLETION);
+}
+
+/* The segment could not be sent. Send an abort segment for it and the
+ * remaining segments instead, and expect its completion in their place.
+ */
+static void lnx_stripe_tx_abort(struct lnx_stripe *ls, int err)
+{
+	struct lnx_domain *domain = ls->ls_lep->le_domain;
+
+	FI_WARN(&lnx_prov, FI_LOG_CORE,
+		"failed to send stripe segment %d: %d, aborting stripe\n",
+		ls->ls_next_seg, err);
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	if (!ls->ls_err.err)
+		ls->ls_err.err = err;
+	ls->ls_num_segs = ls->ls_next_seg + 1;
+	ls->ls_abort = true;
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+}
+
+/*
+ * Post the segments of a send which follow the head, starting at
+ * ls_next_seg. Called with ld_stripe_tx_lock held. Returns -FI_EAGAIN
+ * if a core endpoint could not accept a segment; the stripe must then
+ * be queued and this called again from progress. The stripe may
+ * complete, and be freed, as soon as its last segment is posted.
+ */
+static ssize_t lnx_stripe_tx_segs(struct lnx_stripe *ls)
+{
+	struct lnx_peer *lp = ls->ls_peer;
+	struct lnx_peer_ep_map *ep_map = &lp->lp_src_eps[ls->ls_lep->le_idx];
+	const char *buf = ls->ls_iov[0].iov_base;
+	size_t len = ls->ls_iov[0].iov_len;
+	struct lnx_core_ep *cep;
+	uint64_t seg_tag;
+	size_t off;
+	bool last;
+	int i, num_segs;
+	ssize_t rc;
+
+	num_segs = (int) ofi_div_ceil(len, ls->ls_seg_len);
+	for (;;) {
+		i = ls->ls_next_seg;
+		last = ls->ls_abort || i == num_segs - 1;
+		seg_tag = LNX_STRIPE_SEG |
+			  ((uint64_t) ls->ls_seq << LNX_STRIPE_SEQ_SHIFT) |
+			  ((uint64_t) num_segs << LNX_STRIPE_NUM_SHIFT) | i;
+
+		if (ls->ls_abort) {
+			cep = ep_map->pem_eps[0];
+			rc = lnx_stripe_post(cep,
+					     lnx_stripe_core_addr(cep, lp, true),
+					     NULL, 0, NULL, 0,
+					     seg_tag | LNX_STRIPE_ABORT, 0, ls);
+		} else {
+			cep = ep_map->pem_eps[i];
+			off = i * ls->ls_seg_len;
+			rc = lnx_stripe_post(cep,
+					     lnx_stripe_core_addr(cep, lp, false),
+					     buf + off, MIN(ls->ls_seg_len, len - off),
+					     ls->ls_desc, 0, seg_tag, 0, ls);
+		}
+
+		if (rc == -FI_EAGAIN)
+			return rc;
+
+		if (!rc) {
+			if (last)
+				return 0;
+			ls->ls_next_seg++;
+		} else if (!ls->ls_abort) {
+			lnx_stripe_tx_abort(ls, (int) -rc);
+		} else {
+			FI_WARN(&lnx_prov, FI_LOG_CORE,
+				"failed to abort stripe: %zd, the receive "
+				"will not complete\n", rc);
+			lnx_stripe_seg_error(ls, (int) -rc, 1);
+			return 0;
+		}
+	}
+}
+
+/* Post the queued segments of striped sends */
+static void lnx_stripe_tx_progress(struct lnx_domain *domain)
+{
+	struct dlist_entry txq;
+	struct lnx_stripe *ls;
+
+	dlist_init(&txq);
+
+	ofi_mutex_lock(&domain->ld_stripe_tx_lock);
+	dlist_splice_tail(&txq, &domain->ld_stripe_txq);
+	while (!dlist_empty(&txq)) {
+		dlist_pop_front(&txq, struct lnx_stripe, ls, ls_entry);
+		if (lnx_stripe_tx_segs(ls) == -FI_EAGAIN)
+			dlist_insert_tail(&ls->ls_entry,
+					  &domain->ld_stripe_txq);
+	}
+	ofi_mutex_unlock(&domain->ld_stripe_tx_lock);
+}
+
+ssize_t lnx_stripe_send(struct lnx_ep *lep, struct lnx_peer *lp,
+			const void *buf, size_t len, void *desc,
+			uint64_t data, uint64_t tag, uint64_t flags,
+			void *context)
+{
+	struct lnx_domain *domain = lep->le_domain;
+	struct lnx_peer_ep_map *ep_map = &lp->lp_src_eps[lep->le_idx];
+	struct lnx_core_ep *cep;
+	struct lnx_stripe *ls;
+	size_t seg_len;
+	int num_segs;
+	ssize_t rc;
+
+	seg_len = ofi_div_ceil(len, (size_t) ep_map->pem_num_eps);
+	num_segs = (int) ofi_div_ceil(len, seg_len);
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	ls = lnx_stripe_alloc(domain);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+	if (!ls)
+		return -FI_EAGAIN;
+
+	ls->ls_tx = true;
+	ls->ls_lep = lep;
+	ls->ls_peer = lp;
+	ls->ls_context = context;
+	ls->ls_flags = FI_TAGGED | FI_SEND | (flags & FI_COMPLETION);
+	ls->ls_num_segs = num_segs;
+	ls->ls_next_seg = 1;
+	ls->ls_seg_len = seg_len;
+	ls->ls_iov[0].iov_base = (void *) buf;
+	ls->ls_iov[0].iov_len = len;
+	ls->ls_count = 1;
+	ls->ls_desc = desc;
+
+	/* the receiver numbers heads in arrival order, so taking the
+	 * sequence number and posting the head must not interleave with
+	 * another stripe
+	 */
+	ofi_mutex_lock(&domain->ld_stripe_tx_lock);
+	cep = ep_map->pem_eps[0];
+	rc = lnx_stripe_post(cep, lnx_stripe_core_addr(cep, lp, true), buf,
+			     seg_len, desc, data, tag | LNX_STRIPE_HEAD,
+			     flags & FI_REMOTE_CQ_DATA, ls);
+	if (rc) {
+		ofi_mutex_unlock(&domain->ld_stripe_tx_lock);
+		lnx_stripe_free(domain, ls);
+		return rc;
+	}
+
+	ls->ls_seq = ep_map->pem_stripe_tx_seq++;
+
+	FI_DBG(&lnx_prov, FI_LOG_CORE,
+	       "striping tag %lx len %ld over %d segments, seq %u\n",
+	       tag, len, num_segs, ls->ls_seq);
+
+	/* the head is on the wire, so the rest of the segments have to
+	 * follow; queue the ones the core endpoints cannot take yet
+	 */
+	if (num_segs > 1 && lnx_stripe_tx_segs(ls) == -FI_EAGAIN)
+		dlist_insert_tail(&ls->ls_entry, &domain->ld_stripe_txq);
+	ofi_mutex_unlock(&domain->ld_stripe_tx_lock);
+
+	return 0;
+}
+
+static int lnx_stripe_peer_addr(struct lnx_ep *lep, fi_addr_t addr,
+				fi_addr_t *primary)
+{
+	if (addr == FI_ADDR_UNSPEC) {
+		FI_WARN(&lnx_prov, FI_LOG_CORE,
+			"striped message from unknown source\n");
+		*primary = FI_ADDR_NOTAVAIL;
+		return -FI_EINVAL;
+	}
+
+	*primary = lnx_decode_primary_id(addr);
+	return FI_SUCCESS;
+}
+
+/* Called with ld_stripe_lock held */
+static struct lnx_stripe *
+lnx_stripe_rx_find(struct lnx_ep *lep, fi_addr_t addr, uint32_t seq)
+{
+	struct lnx_domain *domain = lep->le_domain;
+	struct lnx_stripe *ls;
+
+	dlist_foreach_container(&domain->ld_stripe_rxq, struct lnx_stripe,
+				ls, ls_entry) {
+		if (ls->ls_lep == lep && ls->ls_addr == addr &&
+		    ls->ls_seq == seq)
+			return ls;
+	}
+
+	ls = lnx_stripe_alloc(domain);
+	if (!ls)
+		return NULL;
+
+	ls->ls_lep = lep;
+	ls->ls_addr = addr;
+	ls->ls_seq = seq;
+	dlist_insert_tail(&ls->ls_entry, &domain->ld_stripe_rxq);
+
+	return ls;
+}
+
+int lnx_stripe_rx_head(struct lnx_ep *lep, fi_addr_t addr, uint64_t tag,
+		       size_t len, struct lnx_stripe **ls)
+{
+	struct lnx_domain *domain = lep->le_domain;
+	struct lnx_peer_ep_map *ep_map;
+	struct lnx_peer *lp;
+	fi_addr_t primary;
+	int rc;
+
+	rc = lnx_stripe_peer_addr(lep, addr, &primary);
+	if (rc)
+		return rc;
+
+	lp = lnx_av_lookup_addr(lep->le_lav, primary);
+	if (!lp)
+		return -FI_EINVAL;
+	ep_map = &lp->lp_src_eps[lep->le_idx];
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	*ls = lnx_stripe_rx_find(lep, primary, ep_map->pem_stripe_rx_seq);
+	if (*ls) {
+		ep_map->pem_stripe_rx_seq++;
+		(*ls)->ls_tag = tag & ~LNX_STRIPE_TAG_MASK;
+		(*ls)->ls_seg_len = len;
+	}
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	return *ls ? FI_SUCCESS : -FI_ENOMEM;
+}
+
+int lnx_stripe_rx_seg(struct lnx_ep *lep, fi_addr_t addr, uint64_t tag,
+		      struct lnx_stripe **ls, bool *matched)
+{
+	struct lnx_domain *domain = lep->le_domain;
+	fi_addr_t primary;
+	uint32_t seq = (uint32_t) (tag >> LNX_STRIPE_SEQ_SHIFT);
+	int rc, num_segs;
+
+	rc = lnx_stripe_peer_addr(lep, addr, &primary);
+	if (rc)
+		return rc;
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	*ls = lnx_stripe_rx_find(lep, primary, seq);
+	if (*ls) {
+		num_segs = (int) ((tag >> LNX_STRIPE_NUM_SHIFT) &
+				  LNX_STRIPE_IDX_MASK);
+		(*ls)->ls_num_segs = num_segs;
+		if (tag & LNX_STRIPE_ABORT) {
+			/* counts for the segments it replaces once it
+			 * completes itself
+			 */
+			if (!(*ls)->ls_err.err)
+				(*ls)->ls_err.err = FI_EIO;
+			(*ls)->ls_done += num_segs -
+					  (int) (tag & LNX_STRIPE_IDX_MASK) - 1;
+		}
+		*matched = (*ls)->ls_matched && !(*ls)->ls_discard;
+	}
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	return *ls ? FI_SUCCESS : -FI_ENOMEM;
+}
+
+/* The head has been matched to rx_entry, which holds the application
+ * buffer. Remember the buffer for the rest of the segments and limit the
+ * head to its own part of it.
+ */
+void lnx_stripe_match(struct lnx_stripe *ls, struct lnx_rx_entry *rx_entry,
+		      void *desc)
+{
+	struct lnx_domain *domain = ls->ls_lep->le_domain;
+	size_t count = rx_entry->rx_entry.count;
+
+	memcpy(ls->ls_iov, rx_entry->rx_iov, sizeof(*ls->ls_iov) * count);
+	ls->ls_count = count;
+	ls->ls_desc = count == 1 ? desc : NULL;
+	ls->ls_context = rx_entry->rx_entry.context;
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	ls->ls_flags |= FI_TAGGED | FI_RECV |
+			(rx_entry->rx_entry.flags & FI_COMPLETION);
+	ls->ls_matched = true;
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	(void) ofi_truncate_iov(rx_entry->rx_iov, &count, ls->ls_seg_len);
+	rx_entry->rx_entry.count = count;
+	rx_entry->rx_entry.context = ls;
+	rx_entry->rx_entry.flags |= FI_COMPLETION;
+}
+
+/* Point a segment's rx_entry at its part of the application buffer */
+int lnx_stripe_setup_seg(struct lnx_stripe *ls,
+			 struct lnx_rx_entry *rx_entry)
+{
+	struct lnx_core_ep *cep = rx_entry->rx_cep;
+	size_t count = ls->ls_count;
+	size_t idx, offset;
+	int rc;
+
+	idx = rx_entry->rx_entry.tag & LNX_STRIPE_IDX_MASK;
+	offset = idx * ls->ls_seg_len;
+
+	memcpy(rx_entry->rx_iov, ls->ls_iov, sizeof(*ls->ls_iov) * count);
+	if (offset < ofi_total_iov_len(ls->ls_iov, count)) {
+		ofi_consume_iov(rx_entry->rx_iov, &count, offset);
+		(void) ofi_truncate_iov(rx_entry->rx_iov, &count,
+					rx_entry->rx_entry.msg_size);
+	} else {
+		count = 0;
+	}
+
+	rx_entry->rx_desc[0] = NULL;
+	if (count && ls->ls_desc) {
+		rc = lnx_mr_core_desc(cep->cep_domain, ls->ls_desc,
+				      &rx_entry->rx_desc[0]);
+		if (rc)
+			return rc;
+	}
+
+	rx_entry->rx_entry.iov = rx_entry->rx_iov;
+	rx_entry->rx_entry.desc = rx_entry->rx_desc;
+	rx_entry->rx_entry.count = count;
+	rx_entry->rx_entry.context = ls;
+	rx_entry->rx_entry.flags = FI_TAGGED | FI_RECV | FI_COMPLETION;
+	rx_entry->rx_entry.addr = lnx_get_core_addr(cep,
+						    rx_entry->rx_entry.addr);
+
+	return FI_SUCCESS;
+}
+
+void lnx_stripe_queue_seg(struct lnx_rx_entry *rx_entry)
+{
+	struct lnx_domain *domain = rx_entry->rx_lep->le_domain;
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	dlist_insert_tail(&rx_entry->entry, &rx_entry->rx_stripe->ls_segq);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+}
+
+/* One segment of a discarded stripe has been dropped */
+void lnx_stripe_discard(struct lnx_stripe *ls)
+{
+	struct lnx_domain *domain = ls->ls_lep->le_domain;
+	bool done;
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	ls->ls_discard = true;
+	ls->ls_matched = true;
+	done = lnx_stripe_seg_done(ls);
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	if (done)
+		lnx_stripe_free(domain, ls);
+}
+
+/* Post queued send segments and start the queued receive segments of
+ * every stripe whose head has been matched
+ */
+void lnx_stripe_progress(struct lnx_domain *domain)
+{
+	struct dlist_entry ready;
+	struct lnx_rx_entry *rx_entry;
+	struct lnx_core_ep *cep;
+	struct lnx_stripe *ls;
+	int rc;
+
+	if (OFI_LIKELY(!ofi_atomic_get32(&domain->ld_stripe_cnt)))
+		return;
+
+	lnx_stripe_tx_progress(domain);
+	dlist_init(&ready);
+
+	ofi_spin_lock(&domain->ld_stripe_lock);
+	dlist_foreach_container(&domain->ld_stripe_rxq, struct lnx_stripe,
+				ls, ls_entry) {
+		if (ls->ls_matched)
+			dlist_splice_tail(&ready, &ls->ls_segq);
+	}
+	ofi_spin_unlock(&domain->ld_stripe_lock);
+
+	while (!dlist_empty(&ready)) {
+		dlist_pop_front(&ready, struct lnx_rx_entry, rx_entry, entry);
+		ls = rx_entry->rx_stripe;
+		cep = rx_entry->rx_cep;
+
+		if (ls->ls_discard) {
+			rc = cep->cep_srx.peer_ops->discard_tag(
+							&rx_entry->rx_entry);
+			if (rc)
+				FI_WARN(&lnx_prov, FI_LOG_CORE,
+					"Error discarding stripe segment\n");
+			lnx_free_entry(&rx_entry->rx_entry);
+			lnx_stripe_discard(ls);
+			continue;
+		}
+
+		rc = lnx_stripe_setup_seg(ls, rx_entry);
+		if (!rc)
+			rc = cep->cep_srx.peer_ops->start_tag(
+							&rx_entry->rx_entry);
+		if (rc) {
+			FI_WARN(&lnx_prov, FI_LOG_CORE,
+				"failed to start stripe segment: %d\n", rc);
+			lnx_stripe_seg_error(ls, -rc, 1);
+		}
+	}
+}
@@ -79,7 +79,9 @@ extern size_t mrail_num_info;
 enum {
 	MRAIL_POLICY_FIXED,
 	MRAIL_POLICY_ROUND_ROBIN,
-	MRAIL_POLICY_STRIPING
+	MRAIL_POLICY_STRIPING,
+	MRAIL_POLICY_ADAPTIVE,
+	MRAIL_POLICY_ADAPTIVE_STRIPING
 };
 
 #define MRAIL_MAX_CONFIG		8
@@ -178,6 +180,9 @@ struct mrail_tx_buf {
 	struct mrail_rndv_hdr	rndv_hdr;
 	struct mrail_rndv_req	*rndv_req;
 	fid_t			rndv_mr_fid;
+	uint32_t		rail;
+	size_t			len;
+	uint64_t		post_time;
 };
 
 struct mrail_pkt {
@@ -264,12 +269,30 @@ struct mrail_cq {
 	mrail_cq_process_comp_func_t	process_comp;
 };
 
+/*
+ * Per-rail load and performance estimates used by the adaptive policies.
+ * lat and bw are smoothed over completions of transfers posted on the
+ * rail; they are updated without locking, so concurrent updates may lose
+ * a sample but never leave an invalid value.
+ */
+struct mrail_rail_stats {
+	ofi_atomic64_t		inflight;	/* bytes posted, not completed */
+	ofi_atomic64_t		ops;
+	ofi_atomic64_t		bytes;
+	uint64_t		lat;		/* ns */
+	uint64_t		bw;		/* bytes per ms */
+};
+
+/* Transfers smaller than this are latency bound and don't sample bw */
+#define MRAIL_BW_SAMPLE_MIN	(64 * 1024)
+
 struct mrail_ep {
 	struct util_ep		util_ep;
 	struct fi_info		*info;
 	struct {
 		struct fid_ep 		*ep;
 		struct fi_info		*info;
+		struct mrail_rail_stats	stats;
 	}			*rails;
 	size_t			num_eps;
 	ofi_atomic32_t		tx_rail;
@@ -286,6 +309,11 @@ struct mrail_ep {
 	struct slist		deferred_reqs;
 };
 
+/*
+ * base_addr is the start of the region on rails that address RMA by offset
+ * (no FI_MR_VIRT_ADDR) and 0 otherwise; it is subtracted from the virtual
+ * address to form the rail's RMA address.
+ */
 struct mrail_addr_key {
 	uint64_t base_addr;
 	uint64_t key;
@@ -377,17 +405,98 @@ static inline int mrail_get_policy(size_t size)
 	return mrail_config[i].policy;
 }
 
-static inline size_t mrail_get_tx_rail(struct mrail_ep *mrail_ep, int policy)
+static inline bool mrail_rails_have_bw(struct mrail_ep *mrail_ep)
+{
+	size_t i;
+
+	for (i = 0; i < mrail_ep->num_eps; i++) {
+		if (!mrail_ep->rails[i].stats.bw)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Pick the rail expected to finish len more bytes first: the rail's
+ * queued bytes plus len at its measured bandwidth, plus its latency.
+ * Until every rail has a bandwidth estimate the queued bytes are weighted
+ * by latency instead, so rails without samples are tried first. Ties are
+ * broken round-robin.
+ */
+static inline size_t mrail_get_tx_rail_adaptive(struct mrail_ep *mrail_ep,
+						size_t len)
+{
+	struct mrail_rail_stats *stats;
+	uint64_t cost, min_cost = UINT64_MAX;
+	size_t i, rail, start, best;
+	bool use_bw = mrail_rails_have_bw(mrail_ep);
+
+	start = best = mrail_get_tx_rail_rr(mrail_ep);
+	for (i = 0; i < mrail_ep->num_eps; i++) {
+		rail = (start + i) % mrail_ep->num_eps;
+		stats = &mrail_ep->rails[rail].stats;
+		cost = ofi_atomic_get64(&stats->inflight) + len;
+		cost = use_bw ? stats->lat + cost * 1000000 / stats->bw :
+				cost * stats->lat;
+		if (cost < min_cost) {
+			min_cost = cost;
+			best = rail;
+		}
+	}
+	return best;
+}
+
+static inline size_t mrail_get_tx_rail(struct mrail_ep *mrail_ep, int policy,
+				       size_t len)
 {
-	return policy == MRAIL_POLICY_FIXED ?
-				mrail_ep->default_tx_rail :
-				mrail_get_tx_rail_rr(mrail_ep);
+	switch (policy) {
+	case MRAIL_POLICY_FIXED:
+		return mrail_ep->default_tx_rail;
+	case MRAIL_POLICY_ADAPTIVE:
+	case MRAIL_POLICY_ADAPTIVE_STRIPING:
+		return mrail_get_tx_rail_adaptive(mrail_ep, len);
+	default:
+		return mrail_get_tx_rail_rr(mrail_ep);
+	}
+}
+
+static inline void mrail_rail_post(struct mrail_ep *mrail_ep, size_t rail,
+				   size_t len)
+{
+	struct mrail_rail_stats *stats = &mrail_ep->rails[rail].stats;
+
+	ofi_atomic_inc64(&stats->ops);
+	ofi_atomic_add64(&stats->bytes, len);
+	ofi_atomic_add64(&stats->inflight, len);
+}
+
+/* Smoothing weight of 1/8 for each new sample */
+static inline uint64_t mrail_rail_avg(uint64_t avg, uint64_t sample)
+{
+	return avg ? avg - (avg >> 3) + (sample >> 3) : sample;
+}
+
+static inline void mrail_rail_complete(struct mrail_ep *mrail_ep, size_t rail,
+				       size_t len, uint64_t post_time)
+{
+	struct mrail_rail_stats *stats = &mrail_ep->rails[rail].stats;
+	uint64_t lat = ofi_gettime_ns() - post_time;
+
+	ofi_atomic_sub64(&stats->inflight, len);
+	if (len < MRAIL_BW_SAMPLE_MIN) {
+		stats->lat = mrail_rail_avg(stats->lat, lat);
+		return;
+	}
 
+	stats->bw = mrail_rail_avg(stats->bw, len * 1000000 / (lat ? lat : 1));
 }
 
 struct mrail_subreq {
 	struct fi_context context;
 	struct mrail_req *parent;
+	uint32_t rail;
+	size_t len;
+	uint64_t post_time;
 	void *descs[MRAIL_IOV_LIMIT];
 	struct iovec iov[MRAIL_IOV_LIMIT];
 	struct fi_rma_iov rma_iov[MRAIL_IOV_LIMIT];
@@ -404,6 +513,7 @@ struct mrail_req {
 	struct fi_cq_tagged_entry comp;
 	ofi_atomic32_t expected_subcomps;
 	int op_type;
+	int policy;
 	int pending_subreq;
 	struct mrail_subreq subreqs[];
 };
@@ -196,7 +196,7 @@ static int mrail_mr_reg(struct fid *domain_fid, const void *buf, size_t len,
 		}
 		mrail_mr->rails[rail].base_addr =
 			(fi->domain_attr->mr_mode & FI_MR_VIRT_ADDR) ?
-			(uint64_t)buf : 0;
+			0 : (uint64_t)buf;
 	}
 
 	mrail_mr->mr_fid.fid.fclass = FI_CLASS_MR;
@@ -247,7 +247,7 @@ static int mrail_mr_regv(struct fid *domain_fid, const struct iovec *iov,
 		}
 		mrail_mr->rails[rail].base_addr =
 			(fi->domain_attr->mr_mode & FI_MR_VIRT_ADDR) ?
-			(uint64_t)iov[0].iov_base : 0;
+			0 : (uint64_t)iov[0].iov_base;
 	}
 
 	mrail_mr->mr_fid.fid.fclass = FI_CLASS_MR;
@@ -295,7 +295,7 @@ static int mrail_mr_regattr(struct fid *domain_fid, const struct fi_mr_attr *att
 		}
 		mrail_mr->rails[rail].base_addr =
 			(fi->domain_attr->mr_mode & FI_MR_VIRT_ADDR) ?
-			(uint64_t)attr->mr_iov[0].iov_base : 0;
+			0 : (uint64_t)attr->mr_iov[0].iov_base;
 	}
 
 	mrail_mr->mr_fid.fid.fclass = FI_CLASS_MR;
@@ -350,7 +350,7 @@ int mrail_send_rndv_ack_blocking(struct mrail_ep *mrail_ep,
 	struct mrail_tx_buf *tx_buf;
 	size_t rndv_pkt_size = sizeof(tx_buf->hdr) + sizeof(tx_buf->rndv_hdr);
 	int policy = mrail_get_policy(rndv_pkt_size);
-	uint32_t i = mrail_get_tx_rail(mrail_ep, policy);
+	uint32_t i = mrail_get_tx_rail(mrail_ep, policy, rndv_pkt_size);
 	struct fi_msg msg;
 	ssize_t ret;
 	uint64_t flags = FI_COMPLETION;
@@ -377,6 +377,10 @@ int mrail_send_rndv_ack_blocking(struct mrail_ep *mrail_ep,
 	if (iov_dest.iov_len < mrail_ep->rails[i].info->tx_attr->inject_size)
 		flags |= FI_INJECT;
 
+	tx_buf->rail = i;
+	tx_buf->len = rndv_pkt_size;
+	tx_buf->post_time = ofi_gettime_ns();
+
 	FI_DBG(&mrail_prov, FI_LOG_EP_DATA, "Posting rdnv ack "
 	       " dest_addr: 0x%" PRIx64 " on rail: %d\n", dest_addr, i);
 
@@ -394,6 +398,8 @@ int mrail_send_rndv_ack_blocking(struct mrail_ep *mrail_ep,
 		FI_WARN(&mrail_prov, FI_LOG_EP_DATA,
 			"Unable to fi_sendmsg on rail: %" PRIu32 "\n", i);
 		ofi_buf_free(tx_buf);
+	} else {
+		mrail_rail_post(mrail_ep, i, rndv_pkt_size);
 	}
 
 	ofi_genlock_unlock(&mrail_ep->util_ep.lock);
@@ -419,8 +425,11 @@ mrail_prepare_rndv_req(struct mrail_ep *mrail_ep, struct mrail_tx_buf *tx_buf,
 	tx_buf->rndv_req = NULL;
 
 	if (!desc || !desc[0]) {
+		/* The tx_buf address keeps the key unique among outstanding
+		 * requests when a rail doesn't use provider keys */
 		ret = fi_mr_regv(&mrail_ep->util_ep.domain->domain_fid,
-				 iov, count, FI_REMOTE_READ, 0, 0, 0, &mr, 0);
+				 iov, count, FI_REMOTE_READ, 0,
+				 (uint64_t) (uintptr_t) tx_buf, 0, &mr, 0);
 		if (ret)
 			return ret;
 		total_key_size = 0;
@@ -488,7 +497,7 @@ mrail_send_common(struct fid_ep *ep_fid, const struct iovec *iov, void **desc,
 	struct iovec *iov_dest = alloca(sizeof(*iov_dest) * (count + 1));
 	struct mrail_tx_buf *tx_buf;
 	int policy = mrail_get_policy(len);
-	uint32_t rail = mrail_get_tx_rail(mrail_ep, policy);
+	uint32_t rail = mrail_get_tx_rail(mrail_ep, policy, len);
 	struct fi_msg msg;
 	ssize_t ret;
 	size_t total_len;
@@ -498,14 +507,16 @@ mrail_send_common(struct fid_ep *ep_fid, const struct iovec *iov, void **desc,
 	ofi_genlock_lock(&mrail_ep->util_ep.lock);
 
 	tx_buf = mrail_get_tx_buf(mrail_ep, context, peer_info->seq_no++,
-				  ofi_op_tagged, flags | op);
+				  op == FI_TAGGED ? ofi_op_tagged : ofi_op_msg,
+				  flags | op);
 	if (OFI_UNLIKELY(!tx_buf)) {
 		ret = -FI_ENOMEM;
 		goto err1;
 	}
 	tx_buf->hdr.tag = tag;
 
-	if (policy == MRAIL_POLICY_STRIPING) {
+	if (policy == MRAIL_POLICY_STRIPING ||
+	    policy == MRAIL_POLICY_ADAPTIVE_STRIPING) {
 		ret = mrail_prepare_rndv_req(mrail_ep, tx_buf, iov, desc,
 					     count, len, iov_dest);
 		if (ret)
@@ -534,6 +545,10 @@ mrail_send_common(struct fid_ep *ep_fid, const struct iovec *iov, void **desc,
 	if (total_len < mrail_ep->rails[rail].info->tx_attr->inject_size)
 		flags |= FI_INJECT;
 
+	tx_buf->rail = rail;
+	tx_buf->len = total_len;
+	tx_buf->post_time = ofi_gettime_ns();
+
 	FI_DBG(&mrail_prov, FI_LOG_EP_DATA, "Posting send of length: %zu"
 	       " dest_addr: 0x%" PRIx64 " tag: 0x%" PRIx64 " seq: %d"
 	       " on rail: %d\n", len, dest_addr, tag, peer_info->seq_no - 1, rail);
@@ -546,6 +561,7 @@ mrail_send_common(struct fid_ep *ep_fid, const struct iovec *iov, void **desc,
 	} else if (!(flags & FI_COMPLETION)) {
 		ofi_ep_cntr_inc(&mrail_ep->util_ep, CNTR_TX);
 	}
+	mrail_rail_post(mrail_ep, rail, total_len);
 	ofi_genlock_unlock(&mrail_ep->util_ep.lock);
 	return ret;
 err2:
@@ -772,6 +788,16 @@ err:
 	return ret;
 }
 
+static void mrail_ep_log_rail_stats(struct mrail_ep *mrail_ep, size_t rail)
+{
+	struct mrail_rail_stats *stats = &mrail_ep->rails[rail].stats;
+
+	FI_INFO(&mrail_prov, FI_LOG_EP_CTRL, "rail %zu: %" PRId64 " transfers, "
+		"%" PRId64 " bytes, latency %" PRIu64 " ns, bandwidth %"
+		PRIu64 " MB/s\n", rail, ofi_atomic_get64(&stats->ops),
+		ofi_atomic_get64(&stats->bytes), stats->lat, stats->bw / 1000);
+}
+
 static int mrail_ep_close(fid_t fid)
 {
 	struct mrail_ep *mrail_ep =
@@ -781,7 +807,8 @@ static int mrail_ep_close(fid_t fid)
 
 	mrail_ep_free_bufs(mrail_ep);
 
-	for (i = 0; i < mrail_ep->num_eps; i++) {
+	for (i = 0; mrail_ep->rails && i < mrail_ep->num_eps; i++) {
+		mrail_ep_log_rail_stats(mrail_ep, i);
 		ret = fi_close(&mrail_ep->rails[i].ep->fid);
 		if (ret)
 			retv = ret;
@@ -911,10 +938,22 @@ static int mrail_ep_setopt(fid_t fid, int level, int optname,
 	return ret;
 }
 
+/* Options are set identically on all rails, so rail 0 is representative */
+static int mrail_ep_getopt(fid_t fid, int level, int optname,
+		void *optval, size_t *optlen)
+{
+	struct mrail_ep *mrail_ep;
+
+	mrail_ep = container_of(fid, struct mrail_ep, util_ep.ep_fid.fid);
+
+	return fi_getopt(&mrail_ep->rails[0].ep->fid, level, optname,
+			 optval, optlen);
+}
+
 static struct fi_ops_ep mrail_ops_ep = {
 	.size = sizeof(struct fi_ops_ep),
 	.cancel = fi_no_cancel,
-	.getopt = fi_no_getopt,
+	.getopt = mrail_ep_getopt,
 	.setopt = mrail_ep_setopt,
 	.tx_ctx = fi_no_tx_ctx,
 	.rx_ctx = fi_no_rx_ctx,
@@ -966,6 +1005,15 @@ void mrail_ep_progress(struct util_ep *ep)
 	struct mrail_ep *mrail_ep;
 	mrail_ep = container_of(ep, struct mrail_ep, util_ep);
 	mrail_progress_deferred_reqs(mrail_ep);
+
+	/* Rendezvous transfers complete through both CQs: the receiver's
+	 * RMA reads finish on its TX CQ and the sender's send finishes when
+	 * the ACK arrives on its RX CQ. Poll both in case the application
+	 * only reads one of them while waiting. */
+	if (ep->tx_cq && ep->rx_cq && ep->tx_cq != ep->rx_cq) {
+		mrail_poll_cq(ep->tx_cq);
+		mrail_poll_cq(ep->rx_cq);
+	}
 }
 
 int mrail_ep_open(struct fid_domain *domain_fid, struct fi_info *info,
@@ -1009,6 +1057,12 @@ int mrail_ep_open(struct fid_domain *domain_fid, struct fi_info *info,
 		goto err;
 	}
 
+	for (i = 0; i < mrail_ep->num_eps; i++) {
+		ofi_atomic_initialize64(&mrail_ep->rails[i].stats.inflight, 0);
+		ofi_atomic_initialize64(&mrail_ep->rails[i].stats.ops, 0);
+		ofi_atomic_initialize64(&mrail_ep->rails[i].stats.bytes, 0);
+	}
+
 	for (i = 0, fi = mrail_ep->info->next; fi; fi = fi->next, i++) {
 		fi->tx_attr->op_flags &= ~FI_COMPLETION;
 		ret = fi_endpoint(mrail_domain->domains[i], fi,
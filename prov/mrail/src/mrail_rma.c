@@ -53,8 +53,8 @@ static void mrail_subreq_to_rail(struct mrail_subreq *subreq, uint32_t rail,
 
 	for (i = 0; i < subreq->rma_iov_count; ++i) {
 		mr_map = (struct mrail_addr_key *)subreq->rma_iov[i].key;
-		//TODO: add base address from mrail_addr_key
-		out_rma_iovs[i].addr 	= subreq->rma_iov[i].addr;
+		out_rma_iovs[i].addr 	= subreq->rma_iov[i].addr -
+					  mr_map[rail].base_addr;
 		out_rma_iovs[i].len	= subreq->rma_iov[i].len;
 		out_rma_iovs[i].key	= mr_map[rail].key;
 	}
@@ -84,6 +84,9 @@ static ssize_t mrail_post_subreq(uint32_t rail,
 	msg.rma_iov_count	= subreq->rma_iov_count;
 	msg.context		= &subreq->context;
 
+	subreq->rail		= rail;
+	subreq->post_time	= ofi_gettime_ns();
+
 	if (req->op_type == FI_READ) {
 		ret = fi_readmsg(mrail_ep->rails[rail].ep, &msg, flags);
 	} else {
@@ -98,22 +101,29 @@ static ssize_t mrail_post_subreq(uint32_t rail,
 		ret = fi_writemsg(mrail_ep->rails[rail].ep, &msg, flags);
 	}
 
+	if (!ret)
+		mrail_rail_post(mrail_ep, rail, subreq->len);
 	return ret;
 }
 
 static ssize_t mrail_post_req(struct mrail_req *req)
 {
+	struct mrail_subreq *subreq;
 	size_t i;
 	uint32_t rail;
 	ssize_t ret = 0;
 
 	while (req->pending_subreq >= 0) {
-		/* Try all rails before giving up */
+		subreq = &req->subreqs[req->pending_subreq];
+
+		/* Try all rails before giving up. Adaptive stripes are sized
+		 * for their rail, so those only retry the same rail. */
 		for (i = 0; i < req->mrail_ep->num_eps; ++i) {
-			rail = mrail_get_tx_rail_rr(req->mrail_ep);
+			rail = req->policy == MRAIL_POLICY_ADAPTIVE_STRIPING ?
+			       subreq->rail :
+			       mrail_get_tx_rail_rr(req->mrail_ep);
 
-			ret = mrail_post_subreq(rail,
-					&req->subreqs[req->pending_subreq]);
+			ret = mrail_post_subreq(rail, subreq);
 			if (ret != -FI_EAGAIN) {
 				break;
 			} else {
@@ -180,31 +190,81 @@ void mrail_progress_deferred_reqs(struct mrail_ep *mrail_ep)
 	}
 }
 
+/*
+ * Size the stripes of an adaptive request in proportion to the measured
+ * bandwidth of each rail, stripe i going to rail i. Every rail keeps a
+ * minimum share so its bandwidth estimate stays current.
+ */
+static void mrail_get_adaptive_stripes(struct mrail_ep *mrail_ep,
+		size_t total_len, size_t *stripe_len)
+{
+	uint64_t bw_sum = 0, bw_max = 0;
+	size_t i, rem, min_len, fastest = 0;
+
+	min_len = MIN(MRAIL_BW_SAMPLE_MIN, total_len / mrail_ep->num_eps);
+	rem = total_len - min_len * mrail_ep->num_eps;
+
+	if (!mrail_rails_have_bw(mrail_ep)) {
+		for (i = 0; i < mrail_ep->num_eps; i++)
+			stripe_len[i] = total_len / mrail_ep->num_eps;
+		stripe_len[0] += total_len % mrail_ep->num_eps;
+		return;
+	}
+
+	for (i = 0; i < mrail_ep->num_eps; i++) {
+		bw_sum += mrail_ep->rails[i].stats.bw;
+		if (mrail_ep->rails[i].stats.bw > bw_max) {
+			bw_max = mrail_ep->rails[i].stats.bw;
+			fastest = i;
+		}
+	}
+
+	for (i = 0; i < mrail_ep->num_eps; i++) {
+		stripe_len[i] = min_len + (size_t) ((uint64_t) rem *
+				mrail_ep->rails[i].stats.bw / bw_sum);
+		total_len -= stripe_len[i];
+	}
+	/* Rounding leftovers go to the fastest rail */
+	stripe_len[fastest] += total_len;
+}
+
 static ssize_t mrail_prepare_rma_subreqs(struct mrail_ep *mrail_ep,
 		const struct fi_msg_rma *msg, struct mrail_req *req)
 {
 	ssize_t ret;
 	struct mrail_subreq *subreq;
+	size_t *stripe_len;
 	size_t subreq_count;
 	size_t total_len;
 	size_t chunk_len;
-	size_t subreq_len;
 	size_t iov_index;
 	size_t iov_offset;
 	size_t rma_iov_index;
 	size_t rma_iov_offset;
 	int i;
 
-	/* For now, stripe across all rails.
-	 * This could be determined by a dynamic scheduler instead.
-	 */
 	subreq_count = mrail_ep->num_eps;
+	stripe_len = alloca(sizeof(*stripe_len) * subreq_count);
 
-	total_len = ofi_total_iov_len(msg->msg_iov, msg->iov_count); 
-	chunk_len = total_len / subreq_count;
+	/* The local buffer may be larger than the remote one, e.g. when
+	 * reading a rendezvous message into a larger receive buffer */
+	total_len = MIN(ofi_total_iov_len(msg->msg_iov, msg->iov_count),
+			ofi_total_rma_iov_len(msg->rma_iov,
+					      msg->rma_iov_count));
+	req->policy = mrail_get_policy(total_len);
+
+	if (req->policy == MRAIL_POLICY_ADAPTIVE_STRIPING) {
+		mrail_get_adaptive_stripes(mrail_ep, total_len, stripe_len);
+	} else {
+		/* Stripe evenly across all rails. The remainder goes to the
+		 * last entry, which holds the first chunk of the buffer since
+		 * the subreq array is filled in reverse order below. */
+		chunk_len = total_len / subreq_count;
+		for (i = 0; i < subreq_count; i++)
+			stripe_len[i] = chunk_len;
+		stripe_len[subreq_count - 1] += total_len % subreq_count;
+	}
 
-	/* The first chunk is the longest */
-	subreq_len =  chunk_len + (total_len % subreq_count);
 	iov_index = 0;
 	iov_offset = 0;
 	rma_iov_index = 0;
@@ -222,12 +282,14 @@ static ssize_t mrail_prepare_rma_subreqs(struct mrail_ep *mrail_ep,
 		subreq = &req->subreqs[i];
 
 		subreq->parent = req;
+		subreq->rail = i;
+		subreq->len = stripe_len[i];
 
 		ret = ofi_copy_iov_desc(subreq->iov, subreq->descs,
 				&subreq->iov_count,
 				(struct iovec *)msg->msg_iov, msg->desc,
 				msg->iov_count, &iov_index, &iov_offset,
-				subreq_len);
+				subreq->len);
 		if (ret) {
 			goto out;
 		}
@@ -235,13 +297,10 @@ static ssize_t mrail_prepare_rma_subreqs(struct mrail_ep *mrail_ep,
 		ret = ofi_copy_rma_iov(subreq->rma_iov, &subreq->rma_iov_count,
 				(struct fi_rma_iov *)msg->rma_iov,
 				msg->rma_iov_count, &rma_iov_index,
-				&rma_iov_offset, subreq_len);
+				&rma_iov_offset, subreq->len);
 		if (ret) {
 			goto out;
 		}
-
-		/* All the other chunks have the same length */
-		subreq_len = chunk_len;
 	}
 
 	ofi_atomic_initialize32(&req->expected_subcomps, subreq_count);
@@ -273,7 +273,7 @@ void opx_tid_cache_delete_region(struct ofi_mr_cache *cache, struct ofi_mr_entry
 	struct fi_opx_ep *const	      opx_ep	      = opx_mr->opx_ep;
 	const void *const	      iov_base	      = entry->info.iov.iov_base;
 	const size_t		      iov_len	      = entry->info.iov.iov_len;
-	assert(entry->use_cnt == 0);
+	assert(entry->use_cnt <= 0);
 	/* Is this region current?  deregister it */
 	if ((tid_reuse_cache->tid_length == iov_len) && (tid_reuse_cache->tid_vaddr == (uint64_t) iov_base)) {
 		FI_DBG(cache->domain->prov, FI_LOG_MR, "ENTRY cache %p, entry %p, data %p, iov_base %p, iov_len %zu\n",
@@ -371,6 +371,8 @@ int opx_tid_cache_init(struct util_domain *domain, struct ofi_mem_monitor **moni
 	}
 
 	pthread_mutex_init(&cache->lock, NULL);
+	pthread_mutex_init(&cache->tree_lock, NULL);
+	cache->gen = 0;
 	dlist_init(&cache->lru_list);
 	dlist_init(&cache->dead_region_list);
 	cache->cached_cnt    = 0;
@@ -406,6 +408,7 @@ del:
 destroy:
 	ofi_rbmap_cleanup(&cache->tree);
 	ofi_atomic_dec32(&cache->domain->ref);
+	pthread_mutex_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	cache->domain = NULL;
 	return ret;
@@ -1776,6 +1779,7 @@ void opx_tid_cache_cleanup(struct ofi_mr_cache *cache)
 	/* Try forcing it (fini abnormal exit) for all eps (NULL) */
 	opx_tid_cache_purge_ep(cache, NULL);
 
+	pthread_mutex_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	ofi_monitors_del_cache(cache);
 	ofi_rbmap_cleanup(&cache->tree);
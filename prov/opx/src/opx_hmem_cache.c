@@ -209,6 +209,8 @@ int opx_hmem_cache_init(struct util_domain *domain, struct ofi_mem_monitor **mon
 	}
 
 	pthread_mutex_init(&cache->lock, NULL);
+	pthread_mutex_init(&cache->tree_lock, NULL);
+	cache->gen = 0;
 	dlist_init(&cache->lru_list);
 	dlist_init(&cache->dead_region_list);
 	cache->cached_cnt      = 0;
@@ -248,6 +250,7 @@ destroy:
 	OPX_TRACER_TRACE(OPX_TRACER_END_ERROR, "GDRCOPY-CACHE-INIT");
 	ofi_rbmap_cleanup(&cache->tree);
 	ofi_atomic_dec32(&cache->domain->ref);
+	pthread_mutex_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	cache->domain = NULL;
 	cache->prov   = NULL;
@@ -504,7 +507,7 @@ void opx_hmem_cache_delete_region(struct ofi_mr_cache *cache, struct ofi_mr_entr
 	const void *const iov_base = entry->info.iov.iov_base;
 	const size_t	  iov_len  = entry->info.iov.iov_len;
 #endif
-	assert(entry->use_cnt == 0);
+	assert(entry->use_cnt <= 0);
 
 	/* Is this region current?  deregister it */
 	assert((opx_mr->iov.iov_len == iov_len) && (opx_mr->iov.iov_base == iov_base));
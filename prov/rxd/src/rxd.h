@@ -60,7 +60,7 @@
 #ifndef _RXD_H_
 #define _RXD_H_
 
-#define RXD_PROTOCOL_VERSION 	(2)
+#define RXD_PROTOCOL_VERSION 	(3)
 
 #define RXD_MAX_MTU_SIZE	4096
 
@@ -74,8 +74,19 @@
 #define RXD_MAX_PKT_RETRY	50
 #define RXD_ADDR_INVALID	0
 
+/* Retransmission timeout bounds, in usec */
+#define RXD_INIT_RTO		1000
+#define RXD_MIN_RTO		1000
+#define RXD_MAX_RTO		4000000
+
+/* Congestion window, in packets */
+#define RXD_INIT_CWND		16
+#define RXD_MIN_CWND		2
+
 #define RXD_PKT_IN_USE		(1 << 0)
 #define RXD_PKT_ACKED		(1 << 1)
+#define RXD_PKT_SACKED		(1 << 2)
+#define RXD_PKT_RETX		(1 << 3)
 
 #define RXD_REMOTE_CQ_DATA	(1 << 0)
 #define RXD_NO_TX_COMP		(1 << 1)
@@ -84,6 +95,7 @@
 #define RXD_TAG_HDR		(1 << 4)
 #define RXD_INLINE		(1 << 5)
 #define RXD_MULTI_RECV		(1 << 6)
+#define RXD_ACK_REQ		(1 << 7)
 
 #define RXD_IDX_OFFSET(x)	(x + 1)
 
@@ -93,6 +105,7 @@ struct rxd_env {
 	int max_peers;
 	int max_unacked;
 	int rescan;
+	int drop_rate;
 };
 
 extern struct rxd_env rxd_env;
@@ -134,8 +147,20 @@ struct rxd_peer {
 	int retry_cnt;
 
 	uint16_t unacked_cnt;
+	uint16_t sacked_cnt;
 	uint8_t active;
 
+	/* RTT estimate and retransmission timeout, in usec */
+	uint64_t srtt;
+	uint64_t rttvar;
+	uint64_t rto;
+
+	/* AIMD congestion window, in packets */
+	uint32_t cwnd;
+	uint32_t cwnd_cnt;
+	uint32_t ssthresh;
+	uint64_t recover_seq;
+
 	uint16_t curr_rx_id;
 	uint16_t curr_tx_id;
 
@@ -196,6 +221,7 @@ struct rxd_ep {
 	int do_local_mr;
 	int next_retry;
 	int dg_cq_fd;
+	uint32_t drop_seed;
 	uint32_t tx_flags;
 	uint32_t rx_flags;
 
@@ -227,6 +253,24 @@ static inline struct rxd_peer *rxd_peer(struct rxd_ep *ep, fi_addr_t rxd_addr)
 	return ofi_idm_lookup(&ep->peers_idm, (int) rxd_addr);
 
 }
+
+/* Current retransmission timeout in usec, backed off by the retry count */
+static inline uint64_t rxd_peer_rto(struct rxd_peer *peer)
+{
+	return MIN(peer->rto << MIN(peer->retry_cnt, 12), RXD_MAX_RTO);
+}
+
+/*
+ * The receive window bounds all unacked packets, since the receiver only
+ * buffers that many, while the congestion window bounds the packets still
+ * in flight, which excludes those the receiver selectively acked.
+ */
+static inline int rxd_peer_tx_full(struct rxd_peer *peer)
+{
+	return peer->unacked_cnt >= peer->tx_window ||
+	       (uint32_t) (peer->unacked_cnt - peer->sacked_cnt) >= peer->cwnd;
+}
+
 static inline struct rxd_domain *rxd_ep_domain(struct rxd_ep *ep)
 {
 	return container_of(ep->util_ep.domain, struct rxd_domain, util_domain);
@@ -381,6 +425,15 @@ static inline void rxd_remove_free_pkt_entry(struct rxd_pkt_entry *pkt_entry)
 	ofi_buf_free(pkt_entry);
 }
 
+static inline void rxd_free_unacked(struct rxd_peer *peer,
+				    struct rxd_pkt_entry *pkt_entry)
+{
+	if (pkt_entry->flags & RXD_PKT_SACKED)
+		peer->sacked_cnt--;
+	peer->unacked_cnt--;
+	rxd_remove_free_pkt_entry(pkt_entry);
+}
+
 static inline void rxd_free_unexp_msg(struct rxd_unexp_msg *unexp_msg)
 {
 	ofi_buf_free(unexp_msg->pkt_entry);
@@ -436,6 +489,7 @@ struct rxd_pkt_entry *rxd_get_tx_pkt(struct rxd_ep *ep);
 struct rxd_x_entry *rxd_get_tx_entry(struct rxd_ep *ep, uint32_t op);
 struct rxd_x_entry *rxd_get_rx_entry(struct rxd_ep *ep, uint32_t op);
 ssize_t rxd_ep_send_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry);
+ssize_t rxd_ep_resend_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry);
 ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry);
 void rxd_insert_unacked(struct rxd_ep *ep, fi_addr_t peer,
 			struct rxd_pkt_entry *pkt_entry);
@@ -475,8 +529,9 @@ struct rxd_x_entry *rxd_rx_entry_init(struct rxd_ep *ep,
 			uint32_t op, uint32_t flags);
 void rxd_tx_entry_free(struct rxd_ep *ep, struct rxd_x_entry *tx_entry);
 void rxd_rx_entry_free(struct rxd_ep *ep, struct rxd_x_entry *rx_entry);
-int rxd_get_timeout(int retry_cnt);
-uint64_t rxd_get_retry_time(uint64_t start, int retry_cnt);
+void rxd_peer_rtt_sample(struct rxd_peer *peer, uint64_t rtt);
+void rxd_peer_cwnd_inc(struct rxd_peer *peer, uint32_t acked);
+void rxd_peer_cwnd_dec(struct rxd_peer *peer, int timeout);
 
 /* Generic message functions */
 ssize_t rxd_ep_generic_recvmsg(struct rxd_ep *rxd_ep, const struct iovec *iov,
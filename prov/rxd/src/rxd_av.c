@@ -361,7 +361,7 @@ static int rxd_av_close(struct fid *fid)
 				"failed to remove dg addr: %d (%s)\n",
 				-ret, fi_strerror(-ret));
 
-		ofi_idx_remove_ordered(&(av->rxdaddr_dg_idx), (int) rxd_addr);
+		ofi_idx_remove(&(av->rxdaddr_dg_idx), (int) rxd_addr);
 		ofi_rbmap_delete(&av->rbmap, node);
 	}
 	ofi_rbmap_cleanup(&av->rbmap);
@@ -162,7 +162,7 @@ static int rxd_comp_pkt_seq_no(struct dlist_entry *item, const void *arg)
 	new_hdr = rxd_get_base_hdr(container_of((struct dlist_entry *) arg,
 				  struct rxd_pkt_entry, d_entry));
 
-	return new_hdr->seq_no > list_hdr->seq_no;
+	return ofi_before(new_hdr->seq_no, list_hdr->seq_no);
 }
 
 void rxd_ep_recv_data(struct rxd_ep *ep, struct rxd_x_entry *x_entry,
@@ -190,7 +190,8 @@ void rxd_ep_recv_data(struct rxd_ep *ep, struct rxd_x_entry *x_entry,
 	x_entry->next_seg_no++;
 
 	if (x_entry->next_seg_no < x_entry->num_segs) {
-		if (!(rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no %
+		if (pkt->base_hdr.flags & RXD_ACK_REQ ||
+		    !(rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no %
 		    rxd_peer(ep, pkt->base_hdr.peer)->rx_window))
 			rxd_ep_send_ack(ep, pkt->base_hdr.peer);
 		return;
@@ -241,8 +242,7 @@ int rxd_start_xfer(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 {
 	struct rxd_base_hdr *hdr = rxd_get_base_hdr(tx_entry->pkt);
 
-	if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-	    rxd_peer(ep, tx_entry->peer)->tx_window)
+	if (rxd_peer_tx_full(rxd_peer(ep, tx_entry->peer)))
 		return 0;
 
 	tx_entry->start_seq = rxd_set_pkt_seq(rxd_peer(ep, tx_entry->peer),
@@ -263,8 +263,7 @@ int rxd_start_xfer(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 				  &(rxd_peer(ep, tx_entry->peer)->rma_rx_list));
 	}
 
-	return rxd_peer(ep, tx_entry->peer)->unacked_cnt <
-	       rxd_peer(ep,tx_entry->peer)->tx_window;
+	return !rxd_peer_tx_full(rxd_peer(ep, tx_entry->peer));
 }
 
 void rxd_progress_tx_list(struct rxd_ep *ep, struct rxd_peer *peer)
@@ -306,10 +305,8 @@ void rxd_progress_tx_list(struct rxd_ep *ep, struct rxd_peer *peer)
 		}
 
 		if (tx_entry->op == RXD_DATA_READ && !tx_entry->bytes_done) {
-			if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-		    	    rxd_peer(ep, tx_entry->peer)->tx_window) {
+			if (rxd_peer_tx_full(rxd_peer(ep, tx_entry->peer)))
 				break;
-			}
 			tx_entry->start_seq = rxd_peer(ep,tx_entry->peer)->tx_seq_no;
 			rxd_peer(ep, tx_entry->peer)->tx_seq_no = tx_entry->start_seq +
 							      tx_entry->num_segs;
@@ -897,6 +894,45 @@ static struct rxd_x_entry *rxd_get_data_x_entry(struct rxd_ep *ep,
 	return ofi_bufpool_get_ibuf(ep->tx_entry_pool.pool, data_pkt->ext_hdr.tx_id);
 }
 
+static void rxd_add_unexp_data(struct rxd_ep *ep, fi_addr_t peer,
+			       struct rxd_pkt_entry *pkt_entry)
+{
+	struct rxd_data_pkt *pkt = (struct rxd_data_pkt *) (pkt_entry->pkt);
+	struct rxd_unexp_msg *unexp_msg = rxd_peer(ep, peer)->curr_unexp;
+
+	dlist_insert_tail(&pkt_entry->d_entry, &unexp_msg->pkt_list);
+	if (pkt->ext_hdr.seg_no + 1 == unexp_msg->sar_hdr->num_segs - 1) {
+		rxd_peer(ep, peer)->curr_unexp = NULL;
+		rxd_ep_send_ack(ep, peer);
+	}
+}
+
+/*
+ * Hold an out of order data packet until the gap before it is filled, so
+ * that the sender only has to resend the missing packets.  Only packets
+ * that fit in the selective ack bitmap are kept.
+ */
+static int rxd_buf_data_pkt(struct rxd_ep *ep, struct rxd_peer *peer,
+			    struct rxd_pkt_entry *pkt_entry)
+{
+	struct rxd_pkt_entry *buf_entry;
+	uint64_t seq_no = rxd_get_base_hdr(pkt_entry)->seq_no;
+
+	if (!ofi_before(peer->rx_seq_no, seq_no) ||
+	    seq_no - peer->rx_seq_no > RXD_SACK_BITS)
+		return -FI_EINVAL;
+
+	dlist_foreach_container(&peer->buf_pkts, struct rxd_pkt_entry,
+				buf_entry, d_entry) {
+		if (rxd_get_base_hdr(buf_entry)->seq_no == seq_no)
+			return -FI_EALREADY;
+	}
+
+	dlist_insert_order(&peer->buf_pkts, &rxd_comp_pkt_seq_no,
+			   &pkt_entry->d_entry);
+	return 0;
+}
+
 static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
 {
 	struct fi_cq_err_entry err_entry;
@@ -921,6 +957,12 @@ static void rxd_progress_buf_pkts(struct rxd_ep *ep, fi_addr_t peer)
 		base_hdr = rxd_get_base_hdr(pkt_entry);
 		if (base_hdr->seq_no != rxd_peer(ep, peer)->rx_seq_no)
 			return;
+		if (base_hdr->type == RXD_DATA && rxd_peer(ep, peer)->curr_unexp) {
+			dlist_remove(&pkt_entry->d_entry);
+			rxd_peer(ep, peer)->rx_seq_no++;
+			rxd_add_unexp_data(ep, peer, pkt_entry);
+			continue;
+		}
 		if (base_hdr->type == RXD_DATA || base_hdr->type == RXD_DATA_READ) {
 			data_pkt = (struct rxd_data_pkt *) pkt_entry->pkt;
 			rx_entry = rxd_get_data_x_entry(ep, data_pkt);
@@ -965,7 +1007,7 @@ static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 {
 	struct rxd_data_pkt *pkt = (struct rxd_data_pkt *) (pkt_entry->pkt);
 	struct rxd_x_entry *x_entry;
-	struct rxd_unexp_msg *unexp_msg;
+	int ret;
 
 	if (pkt_entry->pkt_size < sizeof(*pkt) + ep->rx_prefix_size) {
 		FI_WARN(&rxd_prov, FI_LOG_CQ,
@@ -978,19 +1020,20 @@ static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 		rxd_peer(ep, pkt->base_hdr.peer)->rx_seq_no++;
 		if (pkt->base_hdr.type == RXD_DATA &&
 		    rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp) {
-			unexp_msg = rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp;
-			dlist_insert_tail(&pkt_entry->d_entry, &unexp_msg->pkt_list);
-			if (pkt->ext_hdr.seg_no + 1 == unexp_msg->sar_hdr->num_segs - 1) {
-				rxd_peer(ep, pkt->base_hdr.peer)->curr_unexp = NULL;
-				rxd_ep_send_ack(ep, pkt->base_hdr.peer);
-			}
-			return;
+			rxd_add_unexp_data(ep, pkt->base_hdr.peer, pkt_entry);
+			pkt_entry = NULL;
+		} else {
+			x_entry = rxd_get_data_x_entry(ep, pkt);
+			rxd_ep_recv_data(ep, x_entry, pkt, pkt_entry->pkt_size);
 		}
-		x_entry = rxd_get_data_x_entry(ep, pkt);
-		rxd_ep_recv_data(ep, x_entry, pkt, pkt_entry->pkt_size);
 		if (!dlist_empty(&(rxd_peer(ep,
-				   pkt->base_hdr.peer)->buf_pkts)))
+				   pkt->base_hdr.peer)->buf_pkts))) {
 			rxd_progress_buf_pkts(ep, pkt->base_hdr.peer);
+			if (rxd_env.retry)
+				rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+		}
+		if (!pkt_entry)
+			return;
 	} else if (!rxd_env.retry) {
 		dlist_insert_order(&(rxd_peer(ep,
 				     pkt->base_hdr.peer)->buf_pkts),
@@ -998,7 +1041,11 @@ static void rxd_handle_data(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 		return;
 	} else if (rxd_peer(ep, pkt->base_hdr.peer)->peer_addr !=
 		   RXD_ADDR_INVALID) {
+		ret = rxd_buf_data_pkt(ep, rxd_peer(ep, pkt->base_hdr.peer),
+				       pkt_entry);
 		rxd_ep_send_ack(ep, pkt->base_hdr.peer);
+		if (!ret)
+			return;
 	}
 free:
 	ofi_buf_free(pkt_entry);
@@ -1048,6 +1095,9 @@ static void rxd_handle_op(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 			if (!sar_hdr)
 				rxd_peer(ep, base_hdr->peer)->curr_unexp = NULL;
 
+			if (!dlist_empty(&(rxd_peer(ep, base_hdr->peer)->buf_pkts)))
+				rxd_progress_buf_pkts(ep, base_hdr->peer);
+
 			rxd_ep_send_ack(ep, base_hdr->peer);
 			return;
 		}
@@ -1082,48 +1132,92 @@ static void rxd_handle_cts(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	rxd_update_peer(ep, cts->rts_addr, cts->cts_addr);
 }
 
+static int rxd_sack_isset(struct rxd_ack_pkt *ack, uint64_t seq_no)
+{
+	uint64_t off = seq_no - ack->base_hdr.seq_no - 1;
+
+	return off < RXD_SACK_BITS && ack->sack[off / 64] & (1ULL << (off % 64));
+}
+
+/*
+ * Release the packets covered by the cumulative ack, mark the ones reported
+ * in the selective ack bitmap, and resend the holes below the highest
+ * selectively acked packet once they have been outstanding for an RTT.
+ */
 static void rxd_handle_ack(struct rxd_ep *ep, struct rxd_pkt_entry *ack_entry)
 {
 	struct rxd_ack_pkt *ack = (struct rxd_ack_pkt *) (ack_entry->pkt);
 	struct rxd_pkt_entry *pkt_entry;
-	fi_addr_t peer = ack->base_hdr.peer;
+	struct rxd_peer *peer = rxd_peer(ep, ack->base_hdr.peer);
+	struct dlist_entry *tmp;
 	struct rxd_base_hdr *hdr;
+	uint64_t now, sent = 0, sack_end = ack->base_hdr.seq_no;
+	uint32_t acked = 0;
+	int loss = 0;
 
-	rxd_peer(ep, peer)->tx_window = (uint16_t) ack->ext_hdr.rx_id;
+	peer->tx_window = (uint16_t) ack->ext_hdr.rx_id;
+	peer->last_rx_ack = ack->base_hdr.seq_no;
 
-	if (rxd_peer(ep, peer)->last_rx_ack == ack->base_hdr.seq_no)
-		return;
+	if (dlist_empty(&peer->unacked))
+		goto out;
 
-	rxd_peer(ep, peer)->last_rx_ack = ack->base_hdr.seq_no;
+	now = ofi_gettime_us();
+	dlist_foreach_container_safe(&peer->unacked, struct rxd_pkt_entry,
+				     pkt_entry, d_entry, tmp) {
+		hdr = rxd_get_base_hdr(pkt_entry);
+		if (ofi_before(hdr->seq_no, ack->base_hdr.seq_no)) {
+			if (pkt_entry->flags & RXD_PKT_ACKED)
+				continue;
+		} else if (pkt_entry->flags & RXD_PKT_SACKED ||
+			   !rxd_sack_isset(ack, hdr->seq_no)) {
+			continue;
+		}
 
-	if (dlist_empty(&(rxd_peer(ep, peer)->unacked)))
-		return;
+		if (!(pkt_entry->flags & (RXD_PKT_SACKED | RXD_PKT_RETX)) &&
+		    pkt_entry->timestamp > sent)
+			sent = pkt_entry->timestamp;
+		if (!(pkt_entry->flags & RXD_PKT_SACKED))
+			acked++;
+		peer->retry_cnt = 0;
+
+		if (!ofi_before(hdr->seq_no, ack->base_hdr.seq_no)) {
+			pkt_entry->flags |= RXD_PKT_SACKED;
+			peer->sacked_cnt++;
+			if (ofi_before(sack_end, hdr->seq_no))
+				sack_end = hdr->seq_no;
+		} else if (pkt_entry->flags & RXD_PKT_IN_USE) {
+			pkt_entry->flags |= RXD_PKT_ACKED;
+		} else {
+			rxd_free_unacked(peer, pkt_entry);
+		}
+	}
 
-	pkt_entry = container_of((&(rxd_peer(ep,
-				    peer)->unacked))->next,
-				 struct rxd_pkt_entry, d_entry);
+	if (sent)
+		rxd_peer_rtt_sample(peer, now - sent);
+	rxd_peer_cwnd_inc(peer, acked);
 
-	while (&pkt_entry->d_entry != &(rxd_peer(ep,
-				        peer)->unacked)) {
-		hdr = rxd_get_base_hdr(pkt_entry);
-		if (ofi_after_eq(hdr->seq_no, ack->base_hdr.seq_no))
-			break;
+	if (sack_end == ack->base_hdr.seq_no)
+		goto out;
 
-		if (pkt_entry->flags & RXD_PKT_IN_USE) {
-			pkt_entry->flags |= RXD_PKT_ACKED;
-			pkt_entry = container_of((&pkt_entry->d_entry)->next,
-						 struct rxd_pkt_entry, d_entry);
+	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
+				pkt_entry, d_entry) {
+		hdr = rxd_get_base_hdr(pkt_entry);
+		if (!ofi_before(hdr->seq_no, sack_end) ||
+		    pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED |
+					RXD_PKT_SACKED) ||
+		    now - pkt_entry->timestamp < peer->srtt)
 			continue;
-		}
-		rxd_remove_free_pkt_entry(pkt_entry);
-		rxd_peer(ep, peer)->unacked_cnt--;
-		rxd_peer(ep, peer)->retry_cnt = 0;
 
-		pkt_entry = container_of((&(rxd_peer(ep, peer)->unacked))->next,
-					struct rxd_pkt_entry, d_entry);
+		if (!loss && !ofi_before(hdr->seq_no, peer->recover_seq)) {
+			rxd_peer_cwnd_dec(peer, 0);
+			loss = 1;
+		}
+		if (rxd_ep_resend_pkt(ep, pkt_entry))
+			break;
 	}
 
-	rxd_progress_tx_list(ep, rxd_peer(ep, ack->base_hdr.peer));
+out:
+	rxd_progress_tx_list(ep, peer);
 }
 
 void rxd_handle_send_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp)
@@ -1144,8 +1238,7 @@ void rxd_handle_send_comp(struct rxd_ep *ep, struct fi_cq_msg_entry *comp)
 	default:
 		if (pkt_entry->flags & RXD_PKT_ACKED) {
 			peer = pkt_entry->peer;
-			rxd_remove_free_pkt_entry(pkt_entry);
-			rxd_peer(ep, peer)->unacked_cnt--;
+			rxd_free_unacked(rxd_peer(ep, peer), pkt_entry);
 			rxd_progress_tx_list(ep, rxd_peer(ep, peer));
 		} else {
 			pkt_entry->flags &= ~RXD_PKT_IN_USE;
@@ -1270,7 +1363,7 @@ ssize_t rxd_cq_sreadfrom(struct fid_cq *cq_fid, void *buf, size_t count,
 		ofi_genlock_unlock(&cq->ep_list_lock);
 
 		ret = ofi_wait(&cq->wait->wait_fid, ep_retry == -1 ?
-			       timeout : rxd_get_timeout(ep_retry));
+			       timeout : ep_retry);
 
 		if (ep_retry != -1 && ret == -FI_ETIMEDOUT)
 			ret = 0;
@@ -272,17 +272,50 @@ static int rxd_ep_enable(struct rxd_ep *ep)
 	return 0;
 }
 
-/*
- * Exponential back-off starting at 1ms, max 4s.
- */
-int rxd_get_timeout(int retry_cnt)
+/* RTT estimator and retransmission timeout from RFC 6298, in usec */
+void rxd_peer_rtt_sample(struct rxd_peer *peer, uint64_t rtt)
 {
-	return MIN(1 << retry_cnt, 4000);
+	uint64_t delta;
+
+	if (!peer->srtt) {
+		peer->srtt = rtt ? rtt : 1;
+		peer->rttvar = rtt / 2;
+	} else {
+		delta = peer->srtt > rtt ? peer->srtt - rtt : rtt - peer->srtt;
+		peer->rttvar = (3 * peer->rttvar + delta) / 4;
+		peer->srtt = (7 * peer->srtt + rtt) / 8;
+	}
+
+	peer->rto = MIN(MAX(peer->srtt + 4 * peer->rttvar, RXD_MIN_RTO),
+			RXD_MAX_RTO);
 }
 
-uint64_t rxd_get_retry_time(uint64_t start, int retry_cnt)
+/* Slow start below ssthresh, additive increase of one packet per window above */
+void rxd_peer_cwnd_inc(struct rxd_peer *peer, uint32_t acked)
+{
+	while (acked--) {
+		if (peer->cwnd < peer->ssthresh) {
+			peer->cwnd++;
+		} else if (++peer->cwnd_cnt >= peer->cwnd) {
+			peer->cwnd++;
+			peer->cwnd_cnt = 0;
+		}
+	}
+	peer->cwnd = MIN(peer->cwnd, (uint32_t) rxd_env.max_unacked);
+}
+
+/*
+ * Multiplicative decrease: halve the window on a loss detected through
+ * selective acks, restart from the minimum window after a timeout.  Losses
+ * from the same window only reduce it once.
+ */
+void rxd_peer_cwnd_dec(struct rxd_peer *peer, int timeout)
 {
-	return start + rxd_get_timeout(retry_cnt);
+	peer->ssthresh = MAX((uint32_t) (peer->unacked_cnt - peer->sacked_cnt) / 2,
+			     RXD_MIN_CWND);
+	peer->cwnd = timeout ? RXD_MIN_CWND : peer->ssthresh;
+	peer->cwnd_cnt = 0;
+	peer->recover_seq = peer->tx_seq_no;
 }
 
 void rxd_init_data_pkt(struct rxd_ep *ep, struct rxd_x_entry *tx_entry,
@@ -385,8 +418,7 @@ ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 	struct rxd_data_pkt *data;
 
 	while (tx_entry->bytes_done != tx_entry->cq_entry.len) {
-		if (rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-		    rxd_peer(ep, tx_entry->peer)->tx_window)
+		if (rxd_peer_tx_full(rxd_peer(ep, tx_entry->peer)))
 			return 0;
 
 		pkt_entry = rxd_get_tx_pkt(ep);
@@ -401,19 +433,49 @@ ssize_t rxd_ep_post_data_pkts(struct rxd_ep *ep, struct rxd_x_entry *tx_entry)
 		if (data->base_hdr.type != RXD_DATA_READ)
 			data->base_hdr.seq_no++;
 
-		rxd_ep_send_pkt(ep, pkt_entry);
 		rxd_insert_unacked(ep, tx_entry->peer, pkt_entry);
+
+		/* Ask for an ack once the window is full to keep it moving */
+		if (rxd_peer_tx_full(rxd_peer(ep, tx_entry->peer)))
+			data->base_hdr.flags |= RXD_ACK_REQ;
+		rxd_ep_send_pkt(ep, pkt_entry);
 	}
 
-	return rxd_peer(ep, tx_entry->peer)->unacked_cnt >=
-	       rxd_peer(ep, tx_entry->peer)->tx_window;
+	return rxd_peer_tx_full(rxd_peer(ep, tx_entry->peer));
+}
+
+/*
+ * Loss injection for testing: drop drop_rate percent of the data, op and ack
+ * packets.  Connection setup is left alone.  Dropped acks report an error so
+ * that the caller releases them.
+ */
+static int rxd_ep_drop_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
+{
+	int type = rxd_pkt_type(pkt_entry);
+
+	if (type == RXD_RTS || type == RXD_CTS)
+		return 0;
+
+	ep->drop_seed = ep->drop_seed * 1103515245 + 12345;
+	if ((ep->drop_seed >> 16) % 100 >= (uint32_t) rxd_env.drop_rate)
+		return 0;
+
+	FI_DBG(&rxd_prov, FI_LOG_EP_DATA, "dropping %s packet\n",
+	       rxd_pkt_type_str[type]);
+	return type == RXD_ACK ? -FI_EAGAIN : 1;
 }
 
 ssize_t rxd_ep_send_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 {
 	ssize_t ret;
 	fi_addr_t dg_addr;
-	pkt_entry->timestamp = ofi_gettime_ms();
+	pkt_entry->timestamp = ofi_gettime_us();
+
+	if (rxd_env.drop_rate) {
+		ret = rxd_ep_drop_pkt(ep, pkt_entry);
+		if (ret)
+			return ret < 0 ? ret : 0;
+	}
 
 	dg_addr = (intptr_t) ofi_idx_lookup(&(rxd_ep_av(ep)->rxdaddr_dg_idx),
 					    (int)pkt_entry->peer);
@@ -430,6 +492,18 @@ ssize_t rxd_ep_send_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
 	return 0;
 }
 
+/* Retransmitted packets are excluded from RTT samples and request an ack */
+ssize_t rxd_ep_resend_pkt(struct rxd_ep *ep, struct rxd_pkt_entry *pkt_entry)
+{
+	int type = rxd_pkt_type(pkt_entry);
+
+	pkt_entry->flags |= RXD_PKT_RETX;
+	if (type == RXD_DATA || type == RXD_DATA_READ)
+		rxd_get_base_hdr(pkt_entry)->flags |= RXD_ACK_REQ;
+
+	return rxd_ep_send_pkt(ep, pkt_entry);
+}
+
 static ssize_t rxd_ep_send_rts(struct rxd_ep *rxd_ep, fi_addr_t rxd_addr)
 {
 	struct rxd_pkt_entry *pkt_entry;
@@ -559,8 +633,9 @@ size_t rxd_init_msg(void **ptr, const struct iovec *iov, size_t iov_count,
 
 void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
 {
-	struct rxd_pkt_entry *pkt_entry;
+	struct rxd_pkt_entry *pkt_entry, *buf_entry;
 	struct rxd_ack_pkt *ack;
+	uint64_t off;
 
 	pkt_entry = rxd_get_tx_pkt(rxd_ep);
 	if (!pkt_entry) {
@@ -579,6 +654,17 @@ void rxd_ep_send_ack(struct rxd_ep *rxd_ep, fi_addr_t peer)
 	ack->ext_hdr.rx_id = rxd_peer(rxd_ep, peer)->rx_window;
 	rxd_peer(rxd_ep, peer)->last_tx_ack = ack->base_hdr.seq_no;
 
+	/* buf_pkts is sorted by sequence number */
+	memset(ack->sack, 0, sizeof(ack->sack));
+	dlist_foreach_container(&rxd_peer(rxd_ep, peer)->buf_pkts,
+				struct rxd_pkt_entry, buf_entry, d_entry) {
+		off = rxd_get_base_hdr(buf_entry)->seq_no -
+		      ack->base_hdr.seq_no - 1;
+		if (off >= RXD_SACK_BITS)
+			break;
+		ack->sack[off / 64] |= 1ULL << (off % 64);
+	}
+
 	dlist_insert_tail(&pkt_entry->d_entry, &rxd_ep->ctrl_pkts);
 	if (rxd_ep_send_pkt(rxd_ep, pkt_entry))
 		rxd_remove_free_pkt_entry(pkt_entry);
@@ -610,6 +696,7 @@ static void rxd_close_peer(struct rxd_ep *ep, struct rxd_peer *peer)
 		ofi_buf_free(pkt_entry);
 		peer->unacked_cnt--;
 	}
+	peer->sacked_cnt = 0;
 
 	while (!dlist_empty(&peer->tx_list)) {
 		dlist_pop_front(&peer->tx_list, struct rxd_x_entry,
@@ -910,40 +997,54 @@ static void rxd_peer_timeout(struct rxd_ep *rxd_ep, struct rxd_peer *peer)
 		ofi_buf_free(pkt_entry);
 	     	peer->unacked_cnt--;
 	}
+	peer->sacked_cnt = 0;
 
 	dlist_remove(&peer->entry);
 }
 
+/*
+ * Resend the packets whose retransmission timer expired.  Packets the
+ * receiver selectively acked are skipped, as it already holds them, except
+ * for the head of the list: a selectively acked head means the cumulative
+ * ack that covered it was lost, and resending it gets a new one.
+ */
 static void rxd_progress_pkt_list(struct rxd_ep *ep, struct rxd_peer *peer)
 {
 	struct rxd_pkt_entry *pkt_entry;
-	uint64_t current;
+	uint64_t current, rto;
 	ssize_t ret;
 	int retry = 0;
 
-	current = ofi_gettime_ms();
+	current = ofi_gettime_us();
 	if (peer->retry_cnt > RXD_MAX_PKT_RETRY) {
 		rxd_peer_timeout(ep, peer);
 		return;
 	}
 
+	rto = rxd_peer_rto(peer);
 	dlist_foreach_container(&peer->unacked, struct rxd_pkt_entry,
 				pkt_entry, d_entry) {
 		if (pkt_entry->flags & (RXD_PKT_IN_USE | RXD_PKT_ACKED) ||
-		    current < rxd_get_retry_time(pkt_entry->timestamp,
-						 (uint8_t) peer->retry_cnt))
-			break;
+		    (pkt_entry->flags & RXD_PKT_SACKED &&
+		     pkt_entry->d_entry.prev != &peer->unacked) ||
+		    current < pkt_entry->timestamp + rto)
+			continue;
 		retry = 1;
-		ret = rxd_ep_send_pkt(ep, pkt_entry);
+		ret = rxd_ep_resend_pkt(ep, pkt_entry);
 		if (ret)
 			break;
 	}
-	if (retry)
+	if (retry) {
+		rxd_peer_cwnd_dec(peer, 1);
 		peer->retry_cnt++;
+		rto = rxd_peer_rto(peer);
+	}
 
-	if (!dlist_empty(&peer->unacked))
-		ep->next_retry = ep->next_retry == -1 ? peer->retry_cnt :
-				 MIN(ep->next_retry, peer->retry_cnt);
+	if (!dlist_empty(&peer->unacked)) {
+		rto = MAX(rto / 1000, 1);
+		ep->next_retry = ep->next_retry == -1 ? (int) rto :
+				 MIN(ep->next_retry, (int) rto);
+	}
 }
 
 void rxd_ep_progress(struct util_ep *util_ep)
@@ -1079,7 +1180,7 @@ static int rxd_pkt_pool_create(struct rxd_ep *ep,
 		.free_fn	= rxd_buf_region_free_fn,
 		.init_fn	= rxd_pkt_init_fn,
 		.context	= pool,
-		.flags		= OFI_BUFPOOL_HUGEPAGES,
+		.flags		= OFI_BUFPOOL_HUGEPAGES | OFI_BUFPOOL_NUMA_LOCAL,
 	};
 
 	return rxd_pool_create_attrs(ep, pool, attr, type);
@@ -1100,7 +1201,7 @@ static int rxd_entry_pool_create(struct rxd_ep *ep,
 		.init_fn	= rxd_entry_init_fn,
 		.context	= pool,
 		.flags		= OFI_BUFPOOL_INDEXED | OFI_BUFPOOL_NO_TRACK |
-				  OFI_BUFPOOL_HUGEPAGES,
+				  OFI_BUFPOOL_HUGEPAGES | OFI_BUFPOOL_NUMA_LOCAL,
 	};
 
 	return rxd_pool_create_attrs(ep, pool, attr, type);
@@ -1163,8 +1264,12 @@ int rxd_create_peer(struct rxd_ep *ep, uint64_t rxd_addr)
 	peer->rx_window = (uint16_t) rxd_env.max_unacked;
 	peer->tx_window = (uint16_t) rxd_env.max_unacked;
 	peer->unacked_cnt = 0;
+	peer->sacked_cnt = 0;
 	peer->retry_cnt = 0;
 	peer->active = 0;
+	peer->rto = RXD_INIT_RTO;
+	peer->cwnd = MIN(RXD_INIT_CWND, rxd_env.max_unacked);
+	peer->ssthresh = (uint32_t) rxd_env.max_unacked;
 	dlist_init(&(peer->unacked));
 	dlist_init(&(peer->tx_list));
 	dlist_init(&(peer->rx_list));
@@ -1226,6 +1331,7 @@ int rxd_endpoint(struct fid_domain *domain, struct fi_info *info,
 	fi_freeinfo(dg_info);
 
 	rxd_ep->next_retry = -1;
+	rxd_ep->drop_seed = (uint32_t) ofi_gettime_ns();
 	ret = rxd_ep_init_res(rxd_ep, info);
 	if (ret)
 		goto err3;
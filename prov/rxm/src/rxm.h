@@ -273,7 +273,6 @@ struct rxm_domain {
 	bool passthru;
 	struct ofi_ops_flow_ctrl *flow_ctrl_ops;
 	struct ofi_bufpool *amo_bufpool;
-	ofi_mutex_t amo_bufpool_lock;
 	struct fid_domain *util_coll_domain;
 	struct fid_domain *offload_coll_domain;
 	uint64_t offload_coll_mask;
@@ -644,6 +643,7 @@ struct rxm_ep {
 	int			connecting_cnt;
 	struct index_map	conn_idx_map;
 	struct dlist_entry	loopback_list;
+	struct dlist_entry	warmup_list;
 	union ofi_sock_ip	addr;
 
 	pthread_t		cm_thread;
@@ -697,6 +697,8 @@ struct rxm_ep {
 int rxm_start_listen(struct rxm_ep *ep);
 void rxm_stop_listen(struct rxm_ep *ep);
 void rxm_conn_progress(struct rxm_ep *ep);
+int rxm_ep_ops_open(struct fid *fid, const char *name, uint64_t flags,
+		    void **ops, void *context);
 
 
 extern struct fi_provider rxm_prov;
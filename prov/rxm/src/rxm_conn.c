@@ -347,6 +347,7 @@ static void rxm_free_conn(struct rxm_conn *conn)
 
 void rxm_freeall_conns(struct rxm_ep *ep)
 {
+	struct util_conn_warmup *warmup;
 	struct rxm_conn *conn;
 	struct dlist_entry *tmp;
 	struct rxm_av *av;
@@ -358,6 +359,12 @@ void rxm_freeall_conns(struct rxm_ep *ep)
 	av = container_of(ep->util_ep.av, struct rxm_av, util_av);
 	ofi_genlock_lock(&ep->util_ep.lock);
 
+	dlist_foreach_container_safe(&ep->warmup_list, struct util_conn_warmup,
+				     warmup, entry, tmp) {
+		dlist_remove(&warmup->entry);
+		ofi_conn_warmup_free(warmup);
+	}
+
 	/* We can't have more connections than the current number of
 	 * possible peers.
 	 */
@@ -835,6 +842,20 @@ rxm_handle_event(struct rxm_ep *ep, uint32_t event,
 	}
 }
 
+static void rxm_progress_warmup(struct rxm_ep *ep)
+{
+	struct util_conn_warmup *warmup;
+	struct dlist_entry *tmp;
+
+	dlist_foreach_container_safe(&ep->warmup_list, struct util_conn_warmup,
+				     warmup, entry, tmp) {
+		if (ofi_conn_warmup_progress(warmup)) {
+			dlist_remove(&warmup->entry);
+			ofi_conn_warmup_free(warmup);
+		}
+	}
+}
+
 void rxm_conn_progress(struct rxm_ep *ep)
 {
 	struct rxm_eq_cm_entry cm_entry;
@@ -852,6 +873,71 @@ void rxm_conn_progress(struct rxm_ep *ep)
 			ret = 1;
 		}
 	} while (ret > 0);
+
+	if (!dlist_empty(&ep->warmup_list))
+		rxm_progress_warmup(ep);
+}
+
+/* Unlike rxm_get_conn(), this must not drive progress, as it is called
+ * from rxm_conn_progress().
+ */
+static ssize_t rxm_warmup_conn(struct util_ep *util_ep, fi_addr_t addr)
+{
+	struct rxm_ep *ep = container_of(util_ep, struct rxm_ep, util_ep);
+	struct util_peer_addr **peer;
+	struct rxm_conn *conn;
+
+	peer = ofi_av_addr_context(ep->util_ep.av, addr);
+	conn = rxm_add_conn(ep, *peer);
+	if (!conn)
+		return -FI_ENOMEM;
+
+	if (conn->state == RXM_CM_CONNECTED)
+		return 0;
+
+	if ((*peer)->firewall_addr)
+		return -FI_EFIREWALLADDR;
+
+	return rxm_connect(conn);
+}
+
+static int rxm_ep_warmup(struct fid_ep *ep_fid, const fi_addr_t *addr,
+			 size_t count, size_t max_inflight, int timeout,
+			 void *context)
+{
+	struct util_conn_warmup *warmup;
+	struct rxm_ep *ep;
+	int ret;
+
+	ep = container_of(ep_fid, struct rxm_ep, util_ep.ep_fid);
+	ret = ofi_conn_warmup_init(&ep->util_ep, rxm_warmup_conn, addr, count,
+				   max_inflight, timeout, context, &warmup);
+	if (ret)
+		return ret;
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	if (ofi_conn_warmup_progress(warmup))
+		ofi_conn_warmup_free(warmup);
+	else
+		dlist_insert_tail(&warmup->entry, &ep->warmup_list);
+	ofi_genlock_unlock(&ep->util_ep.lock);
+	return 0;
+}
+
+static struct fi_ops_conn_warmup rxm_conn_warmup_ops = {
+	.size = sizeof(struct fi_ops_conn_warmup),
+	.warmup = rxm_ep_warmup,
+};
+
+int rxm_ep_ops_open(struct fid *fid, const char *name, uint64_t flags,
+		    void **ops, void *context)
+{
+	if (!strcmp(name, FI_CONN_WARMUP_OPS)) {
+		*ops = &rxm_conn_warmup_ops;
+		return 0;
+	}
+
+	return -FI_ENOSYS;
 }
 
 void rxm_stop_listen(struct rxm_ep *ep)
@@ -218,6 +218,26 @@ rxm_cq_write_tx_comp(struct rxm_ep *rxm_ep, uint64_t comp_flags,
 	}
 }
 
+/*
+ * Sends issued by the collective provider on our behalf complete back to
+ * it rather than to the application CQ, whatever protocol carried them.
+ */
+static bool rxm_finish_peer_xfer_send(struct rxm_ep *rxm_ep, uint64_t tag,
+				      void *app_context)
+{
+	struct fi_cq_tagged_entry cqe = {
+		.tag = tag,
+		.op_context = app_context,
+	};
+
+	if (!rxm_ep->util_coll_ep || !(tag & RXM_PEER_XFER_TAG_FLAG))
+		return false;
+
+	rxm_ep->util_coll_peer_xfer_ops->complete(rxm_ep->util_coll_ep,
+						  &cqe, 0);
+	return true;
+}
+
 static void rxm_finish_rma(struct rxm_ep *rxm_ep, struct rxm_tx_buf *rma_buf,
 			  uint64_t comp_flags)
 {
@@ -276,15 +296,19 @@ static void rxm_handle_sar_comp(struct rxm_ep *rxm_ep,
 				struct rxm_tx_buf *tx_buf)
 {
 	void *app_context;
-	uint64_t comp_flags, tx_flags;
+	uint64_t comp_flags, tx_flags, tag;
 
 	app_context = tx_buf->app_context;
 	comp_flags = ofi_tx_cq_flags(tx_buf->pkt.hdr.op);
 	tx_flags = tx_buf->flags;
+	tag = tx_buf->pkt.hdr.tag;
 
 	if (!rxm_complete_sar(rxm_ep, tx_buf))
 		return;
 
+	if (rxm_finish_peer_xfer_send(rxm_ep, tag, app_context))
+		return;
+
 	rxm_cq_write_tx_comp(rxm_ep, comp_flags, app_context, tx_flags);
 	ofi_ep_peer_tx_cntr_inc(&rxm_ep->util_ep, ofi_op_msg);
 }
@@ -316,8 +340,11 @@ static void rxm_rndv_tx_finish(struct rxm_ep *rxm_ep,
 	if (!rxm_ep->rdm_mr_local)
 		rxm_msg_mr_closev(tx_buf->rma.mr, tx_buf->rma.count);
 
-	rxm_cq_write_tx_comp(rxm_ep, ofi_tx_cq_flags(tx_buf->pkt.hdr.op),
-			     tx_buf->app_context, tx_buf->flags);
+	if (!rxm_finish_peer_xfer_send(rxm_ep, tx_buf->pkt.hdr.tag,
+				       tx_buf->app_context))
+		rxm_cq_write_tx_comp(rxm_ep,
+				     ofi_tx_cq_flags(tx_buf->pkt.hdr.op),
+				     tx_buf->app_context, tx_buf->flags);
 
 	if (rxm_ep->rndv_ops == &rxm_rndv_ops_write &&
 	    tx_buf->write_rndv.done_buf) {
@@ -1190,9 +1217,7 @@ static int rxm_do_device_mem_atomic(struct rxm_mr *dev_mr, uint8_t op,
 		.iov_len = amo_op_size,
 	};
 
-	ofi_mutex_lock(&dom->amo_bufpool_lock);
 	tx_buf = ofi_buf_alloc(dom->amo_bufpool);
-	ofi_mutex_unlock(&dom->amo_bufpool_lock);
 
 	if (!tx_buf)
 		return -FI_ENOMEM;
@@ -1211,9 +1236,7 @@ static int rxm_do_device_mem_atomic(struct rxm_mr *dev_mr, uint8_t op,
 
 	ofi_mutex_unlock(&dev_mr->amo_lock);
 
-	ofi_mutex_lock(&dom->amo_bufpool_lock);
 	ofi_buf_free(tx_buf);
-	ofi_mutex_unlock(&dom->amo_bufpool_lock);
 
 	return FI_SUCCESS;
 }
@@ -1395,17 +1418,9 @@ static ssize_t rxm_handle_credit(struct rxm_ep *rxm_ep, struct rxm_rx_buf *rx_bu
 void rxm_finish_coll_eager_send(struct rxm_ep *rxm_ep,
 			        struct rxm_tx_buf *tx_eager_buf)
 {
-	if (rxm_ep->util_coll_ep &&
-	    (tx_eager_buf->pkt.hdr.tag & RXM_PEER_XFER_TAG_FLAG)) {
-		struct fi_cq_tagged_entry cqe = {
-			.tag = tx_eager_buf->pkt.hdr.tag,
-			.op_context = tx_eager_buf->app_context,
-		};
-		rxm_ep->util_coll_peer_xfer_ops->
-			complete(rxm_ep->util_coll_ep, &cqe, 0);
-	} else {
+	if (!rxm_finish_peer_xfer_send(rxm_ep, tx_eager_buf->pkt.hdr.tag,
+				       tx_eager_buf->app_context))
 		rxm_finish_eager_send(rxm_ep, tx_eager_buf);
-	}
 }
 
 ssize_t rxm_handle_comp(struct rxm_ep *rxm_ep, struct fi_cq_data_entry *comp)
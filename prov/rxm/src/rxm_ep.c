@@ -126,7 +126,7 @@ static int rxm_ep_create_pools(struct rxm_ep *rxm_ep)
 	attr.free_fn = rxm_buf_close;
 	attr.init_fn = rxm_init_rx_buf;
 	attr.context = rxm_ep;
-	attr.flags = OFI_BUFPOOL_NO_TRACK;
+	attr.flags = OFI_BUFPOOL_NO_TRACK | OFI_BUFPOOL_NUMA_LOCAL;
 
 	ret = ofi_bufpool_create_attr(&attr, &rxm_ep->rx_pool);
 	if (ret) {
@@ -828,18 +828,128 @@ ssize_t rxm_ep_broadcast(struct fid_ep *ep, void *buf, size_t count,
 	return ret;
 }
 
+ssize_t rxm_ep_alltoall(struct fid_ep *ep, const void *buf, size_t count,
+			void *desc, void *result, void *result_desc,
+			fi_addr_t coll_addr, enum fi_datatype datatype,
+			uint64_t flags, void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+	rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_ALLTOALL, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_alltoall(coll_ep, buf, count, desc, result, result_desc,
+			  coll_addr, datatype, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
+ssize_t rxm_ep_reduce_scatter(struct fid_ep *ep, const void *buf, size_t count,
+			      void *desc, void *result, void *result_desc,
+			      fi_addr_t coll_addr, enum fi_datatype datatype,
+			      enum fi_op op, uint64_t flags, void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+	rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_REDUCE_SCATTER, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_reduce_scatter(coll_ep, buf, count, desc, result, result_desc,
+				coll_addr, datatype, op, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
+ssize_t rxm_ep_reduce(struct fid_ep *ep, const void *buf, size_t count,
+		      void *desc, void *result, void *result_desc,
+		      fi_addr_t coll_addr, fi_addr_t root_addr,
+		      enum fi_datatype datatype, enum fi_op op, uint64_t flags,
+		      void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+	rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_REDUCE, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_reduce(coll_ep, buf, count, desc, result, result_desc,
+			coll_addr, root_addr, datatype, op, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
+ssize_t rxm_ep_gather(struct fid_ep *ep, const void *buf, size_t count,
+		      void *desc, void *result, void *result_desc,
+		      fi_addr_t coll_addr, fi_addr_t root_addr,
+		      enum fi_datatype datatype, uint64_t flags,
+		      void *context)
+{
+	struct rxm_ep *rxm_ep;
+	struct fid_ep *coll_ep;
+	struct rxm_coll_buf *req;
+	ssize_t ret;
+
+	rxm_ep = container_of(ep, struct rxm_ep, util_ep.ep_fid.fid);
+
+	ret = rxm_ep_init_coll_req(rxm_ep, FI_GATHER, flags, context,
+				   &req, &coll_ep);
+	if (ret)
+		return ret;
+
+	flags &= ~FI_PEER_TRANSFER;
+
+	ret = fi_gather(coll_ep, buf, count, desc, result, result_desc,
+			coll_addr, root_addr, datatype, flags, req);
+	if (ret)
+		rxm_ep_free_coll_req(rxm_ep, req);
+
+	return ret;
+}
+
 static struct fi_ops_collective rxm_ops_collective = {
 	.size = sizeof(struct fi_ops_collective),
 	.barrier = rxm_ep_barrier,
 	.barrier2 = rxm_ep_barrier2,
 	.broadcast = rxm_ep_broadcast,
-	.alltoall = fi_coll_no_alltoall,
+	.alltoall = rxm_ep_alltoall,
 	.allreduce = rxm_ep_allreduce,
 	.allgather = rxm_ep_allgather,
-	.reduce_scatter = fi_coll_no_reduce_scatter,
-	.reduce = fi_coll_no_reduce,
+	.reduce_scatter = rxm_ep_reduce_scatter,
+	.reduce = rxm_ep_reduce,
 	.scatter = rxm_ep_scatter,
-	.gather = fi_coll_no_gather,
+	.gather = rxm_ep_gather,
 	.msg = fi_coll_no_msg,
 };
 
@@ -1496,7 +1606,7 @@ static struct fi_ops rxm_ep_fi_ops = {
 	.close = rxm_ep_close,
 	.bind = rxm_ep_bind,
 	.control = rxm_ep_ctrl,
-	.ops_open = fi_no_ops_open,
+	.ops_open = rxm_ep_ops_open,
 };
 
 static int rxm_listener_open(struct rxm_ep *rxm_ep)
@@ -1773,6 +1883,7 @@ int rxm_endpoint(struct fid_domain *domain, struct fi_info *info,
 		(*ep_fid)->atomic = &rxm_ops_atomic;
 
 	dlist_init(&rxm_ep->loopback_list);
+	dlist_init(&rxm_ep->warmup_list);
 
 	return 0;
 err2:
@@ -76,8 +76,18 @@ struct smr_env {
 	size_t sar_threshold;
 	int disable_cma;
 	int use_dsa_sar;
+	size_t sar_copy_threads;
+	char *sar_copy_affinity;
 	size_t max_gdrcopy_size;
 	int use_xpmem;
+	size_t max_peers;
+	size_t cma_threshold;
+	size_t xpmem_threshold;
+	size_t cma_threshold_remote;
+	size_t xpmem_threshold_remote;
+	int numa_policy;
+	int calibrate;
+	char *calibrate_file;
 };
 
 extern struct smr_env smr_env;
@@ -206,7 +216,8 @@ struct smr_sock_info {
 	pthread_t		listener_thread;
 	int			*my_fds;
 	int			nfds;
-	struct smr_cmap_entry	peers[SMR_MAX_PEERS];
+	/* sized by the number of entries in the peer map */
+	struct smr_cmap_entry	peers[];
 };
 
 struct smr_unexp_buf {
@@ -235,7 +246,10 @@ struct smr_ep {
 	bool			user_setname;
 	enum ofi_shm_p2p_type	p2p_type;
 	struct smr_sock_info	*sock_info;
+	int			wake_fd;
+	struct smr_sock_name	*wake_name;
 	void			*dsa_context;
+	void			*cpu_copy_context;
 	void 			(*smr_progress_ipc_list)(struct smr_ep *ep);
 };
 
@@ -252,6 +266,7 @@ static inline int smr_mmap_name(char *shm_name, const char *ep_name,
 int smr_endpoint(struct fid_domain *domain, struct fi_info *info,
 		  struct fid_ep **ep, void *context);
 void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id);
+void smr_ep_wake_drain(struct smr_ep *ep);
 
 int smr_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		struct fid_cq **cq_fid, void *context);
@@ -260,6 +275,7 @@ int smr_cntr_open(struct fid_domain *domain, struct fi_cntr_attr *attr,
 
 int64_t smr_verify_peer(struct smr_ep *ep, fi_addr_t fi_addr);
 
+void smr_calibrate(void);
 void smr_format_pend_resp(struct smr_tx_entry *pend, struct smr_cmd *cmd,
 			  void *context, struct ofi_mr **mr,
 			  const struct iovec *iov, uint32_t iov_count,
@@ -274,9 +290,9 @@ size_t smr_copy_from_sar(struct smr_freestack *sar_pool, struct smr_resp *resp,
 			 struct smr_cmd *cmd, struct ofi_mr **mr,
 			 const struct iovec *iov, size_t count,
 			 size_t *bytes_done);
-int smr_select_proto(void **desc, size_t iov_count, bool cma_avail,
-		     bool ipc_valid, uint32_t op, uint64_t total_len,
-		     uint64_t op_flags);
+int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
+		     size_t vma_threshold, bool ipc_valid, uint32_t op,
+		     uint64_t total_len, uint64_t op_flags);
 typedef ssize_t (*smr_proto_func)(struct smr_ep *ep, struct smr_region *peer_smr,
 		int64_t id, int64_t peer_id, uint32_t op, uint64_t tag,
 		uint64_t data, uint64_t op_flags, struct ofi_mr **desc,
@@ -312,6 +328,17 @@ static inline bool smr_vma_enabled(struct smr_ep *ep,
 			peer_smr->xpmem_cap_self == SMR_VMA_CAP_ON);
 }
 
+/* Smallest transfer to a peer that uses CMA or XPMEM instead of SAR */
+static inline size_t smr_vma_threshold(struct smr_ep *ep, int64_t id)
+{
+	bool remote = smr_peer_data(ep->region)[id].locality == SMR_LOC_REMOTE;
+
+	if (ep->p2p_type == FI_SHM_P2P_XPMEM)
+		return remote ? smr_env.xpmem_threshold_remote :
+				smr_env.xpmem_threshold;
+	return remote ? smr_env.cma_threshold_remote : smr_env.cma_threshold;
+}
+
 static inline void smr_set_ipc_valid(struct smr_region *region, uint64_t id)
 {
 	if (ofi_hmem_is_initialized(FI_HMEM_ZE) &&
@@ -53,10 +53,15 @@ static int smr_map_init(const struct fi_provider *prov, struct smr_map *map,
 {
 	int i;
 
+	map->peers = calloc(peer_count, sizeof(*map->peers));
+	if (!map->peers)
+		return -FI_ENOMEM;
+
 	for (i = 0; i < peer_count; i++) {
 		smr_peer_addr_init(&map->peers[i].peer);
 		map->peers[i].fiaddr = FI_ADDR_NOTAVAIL;
 	}
+	map->size = peer_count;
 	map->flags = flags;
 
 	ofi_rbmap_init(&map->rbmap, smr_name_compare);
@@ -69,13 +74,14 @@ static void smr_map_cleanup(struct smr_map *map)
 {
 	int64_t i;
 
-	for (i = 0; i < SMR_MAX_PEERS; i++) {
+	for (i = 0; i < map->size; i++) {
 		if (map->peers[i].peer.id < 0)
 			continue;
 
 		smr_map_del(map, i);
 	}
 	ofi_rbmap_cleanup(&map->rbmap);
+	free(map->peers);
 }
 
 static int smr_av_close(struct fid *fid)
@@ -129,7 +135,7 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 		FI_INFO(&smr_prov, FI_LOG_AV, "%s\n", (const char *) addr);
 
 		util_addr = FI_ADDR_NOTAVAIL;
-		if (smr_av->used < SMR_MAX_PEERS) {
+		if (smr_av->used < smr_av->smr_map.size) {
 			ret = smr_map_add(&smr_prov, &smr_av->smr_map,
 					  addr, &shm_id);
 			if (!ret) {
@@ -155,7 +161,7 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 			continue;
 		}
 
-		assert(shm_id >= 0 && shm_id < SMR_MAX_PEERS);
+		assert(shm_id >= 0 && shm_id < smr_av->smr_map.size);
 		if (flags & FI_AV_USER_ID) {
 			assert(fi_addr);
 			smr_av->smr_map.peers[shm_id].fiaddr = fi_addr[i];
@@ -173,8 +179,7 @@ static int smr_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
         		util_ep = container_of(av_entry, struct util_ep,
 					       av_entry);
         		smr_ep = container_of(util_ep, struct smr_ep, util_ep);
-			smr_ep->region->max_sar_buf_per_peer =
-				SMR_MAX_PEERS / smr_av->smr_map.num_peers;
+			smr_update_sar_buf_per_peer(smr_ep->region);
 			ofi_genlock_lock(&util_ep->lock);
 			smr_ep->srx->owner_ops->foreach_unspec_addr(smr_ep->srx,
 								&smr_get_addr);
@@ -214,13 +219,7 @@ static int smr_av_remove(struct fid_av *av_fid, fi_addr_t *fi_addr, size_t count
 		dlist_foreach(&util_av->ep_list, av_entry) {
 			util_ep = container_of(av_entry, struct util_ep, av_entry);
 			smr_ep = container_of(util_ep, struct smr_ep, util_ep);
-			if (smr_av->smr_map.num_peers > 0)
-				smr_ep->region->max_sar_buf_per_peer =
-					SMR_MAX_PEERS /
-					smr_av->smr_map.num_peers;
-			else
-				smr_ep->region->max_sar_buf_per_peer =
-					SMR_BUF_BATCH_MAX;
+			smr_update_sar_buf_per_peer(smr_ep->region);
 		}
 		smr_av->used--;
 	}
@@ -285,6 +284,7 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	struct util_domain *util_domain;
 	struct util_av_attr util_attr;
 	struct smr_av *smr_av;
+	size_t peer_count;
 	int ret;
 
 	if (!attr) {
@@ -309,9 +309,11 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	util_attr.addrlen = sizeof(int64_t);
 	util_attr.context_len = 0;
 	util_attr.flags = 0;
-	if (attr->count > SMR_MAX_PEERS) {
+	/* the count is a hint, only use it to grow the peer map */
+	peer_count = MAX(smr_env.max_peers, attr->count);
+	if (peer_count > SMR_MAX_PEERS) {
 		FI_INFO(&smr_prov, FI_LOG_AV,
-			"count %d exceeds max peers\n", (int) attr->count);
+			"count %zu exceeds max peers\n", peer_count);
 		ret = -FI_ENOSYS;
 		goto out;
 	}
@@ -325,7 +327,7 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	(*av)->fid.ops = &smr_av_fi_ops;
 	(*av)->ops = &smr_av_ops;
 
-	ret = smr_map_init(&smr_prov, &smr_av->smr_map, SMR_MAX_PEERS,
+	ret = smr_map_init(&smr_prov, &smr_av->smr_map, (int) peer_count,
 			   util_domain->info_domain_caps & FI_HMEM ?
 			   SMR_FLAG_HMEM_ENABLED : 0);
 	if (ret)
@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+#include <ofi_cma.h>
+#include <ofi_xpmem.h>
+#include "smr.h"
+
+/* Sizes are probed from just above the inject size up to
+ * SMR_CAL_MAX_SIZE, moving about SMR_CAL_BYTES per sample and keeping
+ * the best of SMR_CAL_SAMPLES samples.
+ */
+#define SMR_CAL_MIN_SIZE	(SMR_INJECT_SIZE * 2)
+#define SMR_CAL_MAX_SIZE	(4 * 1024 * 1024)
+#define SMR_CAL_SIZE_CNT	10
+#define SMR_CAL_BYTES		(8 * 1024 * 1024)
+#define SMR_CAL_SAMPLES		3
+#define SMR_CAL_SAR_BUFS	8
+#define SMR_CAL_MARGIN		10	/* percent */
+
+enum {
+	SMR_CAL_SAR,
+	SMR_CAL_CMA,
+	SMR_CAL_XPMEM,
+	SMR_CAL_MAX,
+};
+
+/* Locality classes: the source buffer is on the local node, or on another
+ * node standing in for a peer on a remote socket.
+ */
+enum {
+	SMR_CAL_LOCAL,
+	SMR_CAL_REMOTE,
+	SMR_CAL_CLASS_MAX,
+};
+
+static const char *smr_cal_class[SMR_CAL_CLASS_MAX] = {
+	[SMR_CAL_LOCAL] = "local",
+	[SMR_CAL_REMOTE] = "remote",
+};
+
+static const char *smr_cal_name[SMR_CAL_MAX] = {
+	[SMR_CAL_SAR] = "sar",
+	[SMR_CAL_CMA] = "cma",
+	[SMR_CAL_XPMEM] = "xpmem",
+};
+
+struct smr_cal_block {
+	size_t			off;
+	size_t			len;
+};
+
+struct smr_cal_bufs {
+	char			*src;
+	char			*dst;
+	char			*sar;
+	struct smr_cal_block	block[SMR_CAL_SAR_BUFS];
+	ofi_atomic64_t		posted;
+	ofi_atomic64_t		copied;
+	struct ofi_xpmem_client	xpmem;
+};
+
+static pthread_once_t smr_cal_once = PTHREAD_ONCE_INIT;
+
+/* Stands in for the receiving peer of a SAR transfer, copying each block
+ * out of the bounce buffers as soon as it is posted.  A zero length block
+ * stops the thread.
+ */
+static void *smr_cal_sar_recv(void *arg)
+{
+	struct smr_cal_bufs *bufs = arg;
+	struct smr_cal_block *block;
+	int64_t seq;
+
+	for (seq = 0; ; seq++) {
+		while (ofi_atomic_get64(&bufs->posted) == seq)
+			sched_yield();
+		block = &bufs->block[seq % SMR_CAL_SAR_BUFS];
+		if (!block->len)
+			break;
+		memcpy(bufs->dst + block->off,
+		       bufs->sar + (seq % SMR_CAL_SAR_BUFS) * SMR_SAR_SIZE,
+		       block->len);
+		ofi_atomic_set64(&bufs->copied, seq + 1);
+	}
+	return NULL;
+}
+
+static void smr_cal_sar_post(struct smr_cal_bufs *bufs, size_t off,
+			     size_t len)
+{
+	int64_t seq = ofi_atomic_get64(&bufs->posted);
+	int slot = seq % SMR_CAL_SAR_BUFS;
+
+	while (seq - ofi_atomic_get64(&bufs->copied) >= SMR_CAL_SAR_BUFS)
+		sched_yield();
+	bufs->block[slot].off = off;
+	bufs->block[slot].len = len;
+	if (len)
+		memcpy(bufs->sar + slot * SMR_SAR_SIZE, bufs->src + off, len);
+	ofi_atomic_set64(&bufs->posted, seq + 1);
+}
+
+/* Mimics the SAR protocol: the sender copies each SMR_SAR_SIZE block into
+ * a set of bounce buffers and the receiver thread copies it out.
+ */
+static int smr_cal_copy_sar(struct smr_cal_bufs *bufs, size_t size)
+{
+	size_t off, len;
+
+	for (off = 0; off < size; off += len) {
+		len = MIN(size - off, SMR_SAR_SIZE);
+		smr_cal_sar_post(bufs, off, len);
+	}
+	while (ofi_atomic_get64(&bufs->copied) !=
+	       ofi_atomic_get64(&bufs->posted))
+		sched_yield();
+	return 0;
+}
+
+static int smr_cal_copy_cma(struct smr_cal_bufs *bufs, size_t size)
+{
+	struct iovec local = { .iov_base = bufs->dst, .iov_len = size };
+	struct iovec remote = { .iov_base = bufs->src, .iov_len = size };
+
+	return ofi_process_vm_readv(getpid(), &local, 1, &remote, 1, 0) ==
+	       (ssize_t) size ? 0 : -FI_EIO;
+}
+
+static int smr_cal_copy_xpmem(struct smr_cal_bufs *bufs, size_t size)
+{
+	struct iovec local = { .iov_base = bufs->dst, .iov_len = size };
+	struct iovec remote = { .iov_base = bufs->src, .iov_len = size };
+
+	return ofi_xpmem_copy(&local, 1, &remote, 1, size, getpid(), false,
+			      &bufs->xpmem);
+}
+
+static int (*smr_cal_copy[SMR_CAL_MAX])(struct smr_cal_bufs *, size_t) = {
+	[SMR_CAL_SAR] = smr_cal_copy_sar,
+	[SMR_CAL_CMA] = smr_cal_copy_cma,
+	[SMR_CAL_XPMEM] = smr_cal_copy_xpmem,
+};
+
+/* Returns the best time in ns to move SMR_CAL_BYTES in size sized copies,
+ * or 0 if the copy method failed.
+ */
+static uint64_t smr_cal_measure(struct smr_cal_bufs *bufs, int type,
+				size_t size)
+{
+	uint64_t start, elapsed, best = UINT64_MAX;
+	size_t i, iters;
+	int s;
+
+	iters = MAX(SMR_CAL_BYTES / size, 4);
+	if (smr_cal_copy[type](bufs, size))
+		return 0;
+
+	for (s = 0; s < SMR_CAL_SAMPLES; s++) {
+		start = ofi_gettime_ns();
+		for (i = 0; i < iters; i++) {
+			if (smr_cal_copy[type](bufs, size))
+				return 0;
+		}
+		elapsed = ofi_gettime_ns() - start;
+		best = MIN(best, elapsed / iters);
+	}
+	return best ? best : 1;
+}
+
+/* A direct copy within SMR_CAL_MARGIN of SAR counts as no slower, since
+ * both are bound by memory bandwidth at the larger sizes.
+ */
+static bool smr_cal_slower(uint64_t vma, uint64_t sar)
+{
+	return vma * 100 > sar * (100 + SMR_CAL_MARGIN);
+}
+
+/* The threshold is the smallest probed size at which the direct copy is
+ * no slower than SAR at that size and the next one, so that a single noisy
+ * sample does not move it.  0 keeps the direct copy for everything above
+ * the inject size, SIZE_MAX disables it in favor of SAR.
+ */
+static size_t smr_cal_threshold(uint64_t *sar, uint64_t *vma)
+{
+	int i;
+
+	for (i = 0; i < SMR_CAL_SIZE_CNT; i++) {
+		if (smr_cal_slower(vma[i], sar[i]))
+			continue;
+		if (i == SMR_CAL_SIZE_CNT - 1 ||
+		    !smr_cal_slower(vma[i + 1], sar[i + 1]))
+			return i ? (size_t) SMR_CAL_MIN_SIZE << i : 0;
+	}
+	return SIZE_MAX;
+}
+
+/* Returns a NUMA node other than the one of the calling thread, or -1 */
+static int smr_cal_remote_node(void)
+{
+	char path[64];
+	unsigned int cpu, node;
+	int i;
+
+	if (syscall(__NR_getcpu, &cpu, &node, NULL))
+		return -1;
+
+	for (i = 0; i < 64; i++) {
+		snprintf(path, sizeof(path), "/sys/devices/system/node/node%d",
+			 i);
+		if ((unsigned int) i != node && !access(path, F_OK))
+			return i;
+	}
+	return -1;
+}
+
+/* node selects where the source buffer is placed, -1 for first touch */
+static void smr_cal_run(int class, int node, size_t *threshold)
+{
+	uint64_t time[SMR_CAL_MAX][SMR_CAL_SIZE_CNT];
+	struct smr_cal_bufs bufs = { 0 };
+	bool avail[SMR_CAL_MAX] = { 0 };
+	pthread_t thread;
+	size_t size;
+	int type, i;
+
+	avail[SMR_CAL_SAR] = true;
+	avail[SMR_CAL_CMA] = !smr_env.disable_cma;
+	avail[SMR_CAL_XPMEM] = xpmem && smr_env.use_xpmem &&
+			       !ofi_xpmem_enable(&xpmem->pinfo, &bufs.xpmem);
+
+	bufs.src = mmap(NULL, SMR_CAL_MAX_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (bufs.src == MAP_FAILED)
+		bufs.src = NULL;
+	else if (node >= 0)
+		(void) ofi_mbind_node(bufs.src, SMR_CAL_MAX_SIZE, node,
+				      OFI_MPOL_PREFERRED);
+	bufs.dst = malloc(SMR_CAL_MAX_SIZE);
+	bufs.sar = malloc(SMR_SAR_SIZE * SMR_CAL_SAR_BUFS);
+	if (!bufs.src || !bufs.dst || !bufs.sar) {
+		FI_WARN(&smr_prov, FI_LOG_CORE,
+			"unable to allocate calibration buffers\n");
+		goto out;
+	}
+	memset(bufs.src, 0xa5, SMR_CAL_MAX_SIZE);
+	memset(bufs.dst, 0, SMR_CAL_MAX_SIZE);
+	memset(bufs.sar, 0, SMR_SAR_SIZE * SMR_CAL_SAR_BUFS);
+
+	ofi_atomic_initialize64(&bufs.posted, 0);
+	ofi_atomic_initialize64(&bufs.copied, 0);
+	if (pthread_create(&thread, NULL, smr_cal_sar_recv, &bufs)) {
+		FI_WARN(&smr_prov, FI_LOG_CORE,
+			"unable to start calibration thread\n");
+		goto out;
+	}
+
+	for (type = 0; type < SMR_CAL_MAX; type++) {
+		if (!avail[type])
+			continue;
+
+		for (i = 0, size = SMR_CAL_MIN_SIZE; i < SMR_CAL_SIZE_CNT;
+		     i++, size <<= 1) {
+			time[type][i] = smr_cal_measure(&bufs, type, size);
+			if (!time[type][i]) {
+				FI_INFO(&smr_prov, FI_LOG_CORE,
+					"%s copy failed, not calibrated\n",
+					smr_cal_name[type]);
+				avail[type] = false;
+				break;
+			}
+			FI_INFO(&smr_prov, FI_LOG_CORE,
+				"%s %s copy of %zu bytes: %" PRIu64 " ns\n",
+				smr_cal_class[class], smr_cal_name[type], size,
+				time[type][i]);
+		}
+	}
+
+	smr_cal_sar_post(&bufs, 0, 0);
+	pthread_join(thread, NULL);
+
+	if (!avail[SMR_CAL_SAR])
+		goto out;
+
+	for (type = SMR_CAL_CMA; type < SMR_CAL_MAX; type++) {
+		if (avail[type])
+			threshold[type] = smr_cal_threshold(time[SMR_CAL_SAR],
+							    time[type]);
+	}
+out:
+	if (avail[SMR_CAL_XPMEM])
+		ofi_xpmem_release(&bufs.xpmem);
+	if (bufs.src)
+		munmap(bufs.src, SMR_CAL_MAX_SIZE);
+	free(bufs.dst);
+	free(bufs.sar);
+}
+
+/* Results only carry over to runs on the same host with the same kernel,
+ * library version and copy mechanisms.
+ */
+static void smr_cal_key(char *key, size_t len)
+{
+	struct utsname name;
+
+	if (uname(&name))
+		memset(&name, 0, sizeof(name));
+
+	snprintf(key, len, "%s %s %s %s cma=%d xpmem=%d", PACKAGE_VERSION,
+		 name.nodename, name.release, name.machine,
+		 !smr_env.disable_cma, xpmem && smr_env.use_xpmem);
+}
+
+static int smr_cal_read(const char *key,
+			size_t threshold[][SMR_CAL_MAX])
+{
+	char line[512];
+	size_t val[SMR_CAL_CLASS_MAX][SMR_CAL_MAX] = { 0 };
+	int ret = -FI_ENODATA;
+	FILE *file;
+
+	file = fopen(smr_env.calibrate_file, "r");
+	if (!file)
+		return -FI_ENOENT;
+
+	if (!fgets(line, sizeof(line), file) ||
+	    strncmp(line, "key ", 4) || strlen(line) < 5)
+		goto out;
+
+	line[strcspn(line, "\n")] = '\0';
+	if (strcmp(line + 4, key))
+		goto out;
+
+	if (fscanf(file, "cma_threshold %zu %zu\nxpmem_threshold %zu %zu\n",
+		   &val[SMR_CAL_LOCAL][SMR_CAL_CMA],
+		   &val[SMR_CAL_REMOTE][SMR_CAL_CMA],
+		   &val[SMR_CAL_LOCAL][SMR_CAL_XPMEM],
+		   &val[SMR_CAL_REMOTE][SMR_CAL_XPMEM]) != 4)
+		goto out;
+
+	memcpy(threshold, val, sizeof(val));
+	ret = 0;
+out:
+	fclose(file);
+	return ret;
+}
+
+/* Written to a temporary file and renamed so that concurrent processes
+ * never see a partial file.
+ */
+static void smr_cal_write(const char *key, size_t threshold[][SMR_CAL_MAX])
+{
+	char *tmp;
+	FILE *file;
+
+	if (asprintf(&tmp, "%s.%d", smr_env.calibrate_file, getpid()) < 0)
+		return;
+
+	file = fopen(tmp, "w");
+	if (!file)
+		goto warn;
+
+	fprintf(file, "key %s\ncma_threshold %zu %zu\n"
+		"xpmem_threshold %zu %zu\n", key,
+		threshold[SMR_CAL_LOCAL][SMR_CAL_CMA],
+		threshold[SMR_CAL_REMOTE][SMR_CAL_CMA],
+		threshold[SMR_CAL_LOCAL][SMR_CAL_XPMEM],
+		threshold[SMR_CAL_REMOTE][SMR_CAL_XPMEM]);
+	if (fclose(file) || rename(tmp, smr_env.calibrate_file)) {
+		unlink(tmp);
+		goto warn;
+	}
+	free(tmp);
+	return;
+warn:
+	FI_WARN(&smr_prov, FI_LOG_CORE,
+		"unable to write calibration file %s: %s\n",
+		smr_env.calibrate_file, strerror(errno));
+	free(tmp);
+}
+
+static void smr_cal_set(const char *name, size_t *env, size_t threshold)
+{
+	size_t val;
+
+	if (fi_param_get_size_t(&smr_prov, name, &val))
+		*env = threshold;
+}
+
+/* Thresholds set explicitly through the environment are kept.  The remote
+ * class is only measured on systems with more than one NUMA node.
+ */
+static void smr_cal_init(void)
+{
+	size_t threshold[SMR_CAL_CLASS_MAX][SMR_CAL_MAX];
+	const char *src = "measured";
+	char key[512];
+	int node;
+
+	threshold[SMR_CAL_LOCAL][SMR_CAL_CMA] = smr_env.cma_threshold;
+	threshold[SMR_CAL_LOCAL][SMR_CAL_XPMEM] = smr_env.xpmem_threshold;
+	threshold[SMR_CAL_REMOTE][SMR_CAL_CMA] = smr_env.cma_threshold_remote;
+	threshold[SMR_CAL_REMOTE][SMR_CAL_XPMEM] =
+		smr_env.xpmem_threshold_remote;
+
+	smr_cal_key(key, sizeof(key));
+	if (smr_env.calibrate_file && *smr_env.calibrate_file &&
+	    !smr_cal_read(key, threshold)) {
+		src = "cached";
+	} else {
+		smr_cal_run(SMR_CAL_LOCAL, -1, threshold[SMR_CAL_LOCAL]);
+		node = smr_cal_remote_node();
+		if (node >= 0)
+			smr_cal_run(SMR_CAL_REMOTE, node,
+				    threshold[SMR_CAL_REMOTE]);
+		if (smr_env.calibrate_file && *smr_env.calibrate_file)
+			smr_cal_write(key, threshold);
+	}
+
+	smr_cal_set("cma_threshold", &smr_env.cma_threshold,
+		    threshold[SMR_CAL_LOCAL][SMR_CAL_CMA]);
+	smr_cal_set("xpmem_threshold", &smr_env.xpmem_threshold,
+		    threshold[SMR_CAL_LOCAL][SMR_CAL_XPMEM]);
+	smr_cal_set("cma_threshold_remote", &smr_env.cma_threshold_remote,
+		    threshold[SMR_CAL_REMOTE][SMR_CAL_CMA]);
+	smr_cal_set("xpmem_threshold_remote", &smr_env.xpmem_threshold_remote,
+		    threshold[SMR_CAL_REMOTE][SMR_CAL_XPMEM]);
+
+	FI_INFO(&smr_prov, FI_LOG_CORE,
+		"protocol thresholds (%s): cma %zu, xpmem %zu, "
+		"remote cma %zu, remote xpmem %zu, sar %zu\n",
+		src, smr_env.cma_threshold, smr_env.xpmem_threshold,
+		smr_env.cma_threshold_remote, smr_env.xpmem_threshold_remote,
+		smr_env.sar_threshold);
+}
+
+void smr_calibrate(void)
+{
+	if (smr_env.calibrate)
+		pthread_once(&smr_cal_once, smr_cal_init);
+}
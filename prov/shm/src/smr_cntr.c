@@ -44,6 +44,7 @@ int smr_cntr_open(struct fid_domain *domain, struct fi_cntr_attr *attr,
 		/* fall through */
 	case FI_WAIT_NONE:
 	case FI_WAIT_YIELD:
+	case FI_WAIT_FD:
 		break;
 	default:
 		FI_INFO(&smr_prov, FI_LOG_CQ, "cntr wait not yet supported\n");
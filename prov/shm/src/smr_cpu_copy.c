@@ -0,0 +1,514 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "ofi_mb.h"
+#include "smr.h"
+#include "smr_cpu_copy.h"
+
+#define SMR_CPU_COPY_MAX_SEGS	(SMR_BUF_BATCH_MAX + SMR_IOV_LIMIT)
+
+struct smr_cpu_copy_seg {
+	void			*dst;
+	const void		*src;
+	size_t			len;
+};
+
+struct smr_cpu_copy_cmd;
+
+/* Contiguous range of segments of a command handed to one helper thread */
+struct smr_cpu_copy_chunk {
+	struct dlist_entry	entry;
+	struct smr_cpu_copy_cmd	*cmd;
+	size_t			first;
+	size_t			last;
+};
+
+struct smr_cpu_copy_cmd {
+	struct dlist_entry	entry;
+	void			*entry_ptr;
+	uint32_t		op;
+	int			dir;
+	size_t			bytes_in_progress;
+	ofi_atomic32_t		chunks_left;
+	size_t			seg_cnt;
+	struct smr_cpu_copy_seg	seg[SMR_CPU_COPY_MAX_SEGS];
+	struct smr_cpu_copy_chunk chunk[SMR_CPU_COPY_MAX_THREADS];
+};
+
+struct smr_cpu_copy_context {
+	struct ofi_bufpool	*cmd_pool;
+	struct dlist_entry	cmd_list;
+	unsigned long		copy_type_stats[2];
+};
+
+/* Helper threads are shared by all endpoints of the process and started
+ * by the first endpoint that is enabled.
+ */
+static struct {
+	pthread_mutex_t		lock;
+	pthread_cond_t		cond;
+	struct dlist_entry	queue;
+	pthread_t		*threads;
+	size_t			thread_cnt;
+	bool			started;
+	bool			stop;
+} smr_cpu_copy_engine = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+/* FI_SHM_SAR_COPY_AFFINITY is a comma separated list of cpu sets in the
+ * format accepted by ofi_set_thread_affinity().  The n-th entry is
+ * assigned to the n-th helper thread, wrapping around as needed.
+ */
+static char *smr_cpu_copy_affinity(size_t index)
+{
+	const char *entry, *end;
+	size_t cnt = 0;
+
+	if (!smr_env.sar_copy_affinity || !*smr_env.sar_copy_affinity)
+		return NULL;
+
+	for (entry = smr_env.sar_copy_affinity; entry; ) {
+		cnt++;
+		entry = strchr(entry, ',');
+		if (entry)
+			entry++;
+	}
+
+	entry = smr_env.sar_copy_affinity;
+	for (index %= cnt; index; index--)
+		entry = strchr(entry, ',') + 1;
+
+	end = strchr(entry, ',');
+	return end ? strndup(entry, end - entry) : strdup(entry);
+}
+
+static void *smr_cpu_copy_thread(void *arg)
+{
+	struct smr_cpu_copy_chunk *chunk;
+	struct smr_cpu_copy_seg *seg;
+	char *affinity;
+	size_t i;
+
+	affinity = smr_cpu_copy_affinity((uintptr_t) arg);
+	if (affinity) {
+		if (ofi_set_thread_affinity(affinity))
+			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+				"unable to set SAR copy thread affinity %s\n",
+				affinity);
+		free(affinity);
+	}
+
+	pthread_mutex_lock(&smr_cpu_copy_engine.lock);
+	while (1) {
+		while (!smr_cpu_copy_engine.stop &&
+		       dlist_empty(&smr_cpu_copy_engine.queue))
+			pthread_cond_wait(&smr_cpu_copy_engine.cond,
+					  &smr_cpu_copy_engine.lock);
+
+		if (dlist_empty(&smr_cpu_copy_engine.queue))
+			break;
+
+		dlist_pop_front(&smr_cpu_copy_engine.queue,
+				struct smr_cpu_copy_chunk, chunk, entry);
+		pthread_mutex_unlock(&smr_cpu_copy_engine.lock);
+
+		for (i = chunk->first; i < chunk->last; i++) {
+			seg = &chunk->cmd->seg[i];
+			memcpy(seg->dst, seg->src, seg->len);
+		}
+		/* last access to the chunk, the owner may free it after this */
+		ofi_atomic_sub32(&chunk->cmd->chunks_left, 1);
+
+		pthread_mutex_lock(&smr_cpu_copy_engine.lock);
+	}
+	pthread_mutex_unlock(&smr_cpu_copy_engine.lock);
+	return NULL;
+}
+
+static int smr_cpu_copy_start(void)
+{
+	size_t i;
+	int ret = 0;
+
+	pthread_mutex_lock(&smr_cpu_copy_engine.lock);
+	if (smr_cpu_copy_engine.started)
+		goto unlock;
+
+	smr_cpu_copy_engine.threads = calloc(smr_env.sar_copy_threads,
+					sizeof(*smr_cpu_copy_engine.threads));
+	if (!smr_cpu_copy_engine.threads) {
+		ret = -FI_ENOMEM;
+		goto unlock;
+	}
+
+	dlist_init(&smr_cpu_copy_engine.queue);
+	smr_cpu_copy_engine.stop = false;
+	for (i = 0; i < smr_env.sar_copy_threads; i++) {
+		ret = pthread_create(&smr_cpu_copy_engine.threads[i], NULL,
+				     smr_cpu_copy_thread, (void *) i);
+		if (ret) {
+			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+				"unable to start SAR copy thread: %s\n",
+				strerror(ret));
+			ret = -FI_EOTHER;
+			break;
+		}
+	}
+	smr_cpu_copy_engine.thread_cnt = i;
+
+	/* Run with whatever threads could be started */
+	if (smr_cpu_copy_engine.thread_cnt) {
+		smr_cpu_copy_engine.started = true;
+		ret = 0;
+	} else {
+		free(smr_cpu_copy_engine.threads);
+		smr_cpu_copy_engine.threads = NULL;
+	}
+unlock:
+	pthread_mutex_unlock(&smr_cpu_copy_engine.lock);
+	return ret;
+}
+
+void smr_cpu_copy_init(void)
+{
+	if (smr_env.sar_copy_threads > SMR_CPU_COPY_MAX_THREADS) {
+		FI_WARN(&smr_prov, FI_LOG_CORE,
+			"sar_copy_threads %zu exceeds limit, using %d\n",
+			smr_env.sar_copy_threads, SMR_CPU_COPY_MAX_THREADS);
+		smr_env.sar_copy_threads = SMR_CPU_COPY_MAX_THREADS;
+	}
+
+	if (smr_env.sar_copy_threads && smr_env.use_dsa_sar) {
+		FI_INFO(&smr_prov, FI_LOG_CORE,
+			"DSA requested, disabling SAR copy threads\n");
+		smr_env.sar_copy_threads = 0;
+	}
+}
+
+void smr_cpu_copy_cleanup(void)
+{
+	size_t i;
+
+	pthread_mutex_lock(&smr_cpu_copy_engine.lock);
+	if (!smr_cpu_copy_engine.started) {
+		pthread_mutex_unlock(&smr_cpu_copy_engine.lock);
+		return;
+	}
+	smr_cpu_copy_engine.stop = true;
+	pthread_cond_broadcast(&smr_cpu_copy_engine.cond);
+	pthread_mutex_unlock(&smr_cpu_copy_engine.lock);
+
+	for (i = 0; i < smr_cpu_copy_engine.thread_cnt; i++)
+		pthread_join(smr_cpu_copy_engine.threads[i], NULL);
+
+	free(smr_cpu_copy_engine.threads);
+	smr_cpu_copy_engine.threads = NULL;
+	smr_cpu_copy_engine.thread_cnt = 0;
+	smr_cpu_copy_engine.started = false;
+}
+
+void smr_cpu_copy_context_init(struct smr_ep *ep)
+{
+	struct smr_cpu_copy_context *ctx;
+	int ret;
+
+	if (smr_cpu_copy_start())
+		goto disable;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx)
+		goto disable;
+
+	ret = ofi_bufpool_create(&ctx->cmd_pool, sizeof(struct smr_cpu_copy_cmd),
+				 16, 0, 16, 0);
+	if (ret) {
+		free(ctx);
+		goto disable;
+	}
+
+	dlist_init(&ctx->cmd_list);
+	ep->cpu_copy_context = ctx;
+	return;
+
+disable:
+	FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+		"SAR copy engine unavailable, copying inline\n");
+	ep->cpu_copy_context = NULL;
+}
+
+void smr_cpu_copy_context_cleanup(struct smr_ep *ep)
+{
+	struct smr_cpu_copy_context *ctx = ep->cpu_copy_context;
+	struct smr_cpu_copy_cmd *cmd;
+
+	if (!ctx)
+		return;
+
+	/* Helper threads may still be writing into user and SAR buffers */
+	while (!dlist_empty(&ctx->cmd_list)) {
+		dlist_pop_front(&ctx->cmd_list, struct smr_cpu_copy_cmd,
+				cmd, entry);
+		while (ofi_atomic_get32(&cmd->chunks_left))
+			sched_yield();
+		ofi_buf_free(cmd);
+	}
+
+	FI_INFO(&smr_prov, FI_LOG_EP_CTRL,
+		"SAR copy engine: %lu iov to buf, %lu buf to iov\n",
+		ctx->copy_type_stats[OFI_COPY_IOV_TO_BUF],
+		ctx->copy_type_stats[OFI_COPY_BUF_TO_IOV]);
+
+	ofi_bufpool_destroy(ctx->cmd_pool);
+	free(ctx);
+	ep->cpu_copy_context = NULL;
+}
+
+/* Break the current SAR batch into buffer sized segments, mirroring the
+ * descriptors built by smr_dsa_copy_sar(), and queue them in up to
+ * thread_cnt contiguous chunks.
+ */
+static void smr_cpu_copy_sar(struct smr_freestack *sar_pool,
+			     struct smr_cpu_copy_cmd *copy_cmd,
+			     struct smr_resp *resp, struct smr_cmd *cmd,
+			     const struct iovec *iov, size_t count,
+			     size_t *bytes_done)
+{
+	struct smr_sar_buf *smr_sar_buf;
+	struct smr_cpu_copy_seg *seg;
+	size_t remaining_sar_size, remaining_iov_size;
+	size_t iov_len, iov_index, chunk_cnt, per_chunk, i;
+	size_t iov_offset = *bytes_done;
+	size_t sar_offset = 0;
+	size_t copy_size;
+	int sar_index = 0;
+	char *iov_buf, *sar_buf;
+
+	for (iov_index = 0; iov_index < count; iov_index++) {
+		iov_len = iov[iov_index].iov_len;
+
+		if (iov_offset < iov_len)
+			break;
+		iov_offset -= iov_len;
+	}
+
+	copy_cmd->seg_cnt = 0;
+	copy_cmd->bytes_in_progress = 0;
+	while ((iov_index < count) &&
+	       (sar_index < cmd->msg.data.buf_batch_size) &&
+	       (copy_cmd->seg_cnt < SMR_CPU_COPY_MAX_SEGS)) {
+		smr_sar_buf = smr_freestack_get_entry_from_index(
+		    sar_pool, cmd->msg.data.sar[sar_index]);
+		iov_len = iov[iov_index].iov_len;
+
+		iov_buf = (char *) iov[iov_index].iov_base + iov_offset;
+		sar_buf = (char *) smr_sar_buf->buf + sar_offset;
+
+		remaining_sar_size = SMR_SAR_SIZE - sar_offset;
+		remaining_iov_size = iov_len - iov_offset;
+		copy_size = MIN(remaining_iov_size, remaining_sar_size);
+		assert(copy_size > 0);
+
+		seg = &copy_cmd->seg[copy_cmd->seg_cnt++];
+		seg->len = copy_size;
+		if (copy_cmd->dir == OFI_COPY_BUF_TO_IOV) {
+			seg->dst = iov_buf;
+			seg->src = sar_buf;
+		} else {
+			seg->dst = sar_buf;
+			seg->src = iov_buf;
+		}
+		copy_cmd->bytes_in_progress += copy_size;
+
+		if (remaining_sar_size > remaining_iov_size) {
+			iov_index++;
+			iov_offset = 0;
+			sar_offset += copy_size;
+		} else if (remaining_sar_size < remaining_iov_size) {
+			sar_index++;
+			sar_offset = 0;
+			iov_offset += copy_size;
+		} else {
+			iov_index++;
+			iov_offset = 0;
+			sar_index++;
+			sar_offset = 0;
+		}
+	}
+	assert(copy_cmd->bytes_in_progress > 0);
+
+	resp->status = SMR_STATUS_BUSY;
+	copy_cmd->op = cmd->msg.hdr.op;
+
+	chunk_cnt = MIN(copy_cmd->seg_cnt, smr_cpu_copy_engine.thread_cnt);
+	per_chunk = (copy_cmd->seg_cnt + chunk_cnt - 1) / chunk_cnt;
+	chunk_cnt = (copy_cmd->seg_cnt + per_chunk - 1) / per_chunk;
+	ofi_atomic_initialize32(&copy_cmd->chunks_left, (int) chunk_cnt);
+
+	pthread_mutex_lock(&smr_cpu_copy_engine.lock);
+	for (i = 0; i < chunk_cnt; i++) {
+		copy_cmd->chunk[i].cmd = copy_cmd;
+		copy_cmd->chunk[i].first = i * per_chunk;
+		copy_cmd->chunk[i].last = MIN((i + 1) * per_chunk,
+					      copy_cmd->seg_cnt);
+		dlist_insert_tail(&copy_cmd->chunk[i].entry,
+				  &smr_cpu_copy_engine.queue);
+	}
+	if (chunk_cnt > 1)
+		pthread_cond_broadcast(&smr_cpu_copy_engine.cond);
+	else
+		pthread_cond_signal(&smr_cpu_copy_engine.cond);
+	pthread_mutex_unlock(&smr_cpu_copy_engine.lock);
+}
+
+static ssize_t smr_cpu_copy_submit(struct smr_ep *ep, int dir,
+		struct smr_freestack *sar_pool, struct smr_resp *resp,
+		struct smr_cmd *cmd, const struct iovec *iov, size_t count,
+		size_t *bytes_done, void *entry_ptr)
+{
+	struct smr_cpu_copy_context *ctx = ep->cpu_copy_context;
+	struct smr_cpu_copy_cmd *copy_cmd;
+
+	copy_cmd = ofi_buf_alloc(ctx->cmd_pool);
+	if (!copy_cmd)
+		return -FI_ENOMEM;
+
+	copy_cmd->dir = dir;
+	copy_cmd->entry_ptr = entry_ptr;
+	smr_cpu_copy_sar(sar_pool, copy_cmd, resp, cmd, iov, count,
+			 bytes_done);
+	dlist_insert_tail(&copy_cmd->entry, &ctx->cmd_list);
+	ctx->copy_type_stats[dir]++;
+
+	return FI_SUCCESS;
+}
+
+ssize_t smr_cpu_copy_to_sar(struct smr_ep *ep,
+		struct smr_freestack *sar_pool, struct smr_resp *resp,
+		struct smr_cmd *cmd, const struct iovec *iov, size_t count,
+		size_t *bytes_done, void *entry_ptr)
+{
+	assert(ep->cpu_copy_context);
+
+	if (resp->status != SMR_STATUS_SAR_EMPTY)
+		return -FI_EAGAIN;
+
+	return smr_cpu_copy_submit(ep, OFI_COPY_IOV_TO_BUF, sar_pool, resp,
+				   cmd, iov, count, bytes_done, entry_ptr);
+}
+
+ssize_t smr_cpu_copy_from_sar(struct smr_ep *ep,
+		struct smr_freestack *sar_pool, struct smr_resp *resp,
+		struct smr_cmd *cmd, const struct iovec *iov, size_t count,
+		size_t *bytes_done, void *entry_ptr)
+{
+	assert(ep->cpu_copy_context);
+
+	if (resp->status != SMR_STATUS_SAR_FULL)
+		return -FI_EAGAIN;
+
+	return smr_cpu_copy_submit(ep, OFI_COPY_BUF_TO_IOV, sar_pool, resp,
+				   cmd, iov, count, bytes_done, entry_ptr);
+}
+
+static void smr_cpu_copy_update_tx_entry(struct smr_region *smr,
+					 struct smr_cpu_copy_cmd *copy_cmd)
+{
+	struct smr_tx_entry *tx_entry = copy_cmd->entry_ptr;
+	struct smr_resp *resp;
+
+	tx_entry->bytes_done += copy_cmd->bytes_in_progress;
+	resp = smr_get_ptr(smr, tx_entry->cmd.msg.hdr.src_data);
+
+	assert(resp->status == SMR_STATUS_BUSY);
+	ofi_wmb();
+	resp->status = (copy_cmd->dir == OFI_COPY_IOV_TO_BUF ?
+			SMR_STATUS_SAR_FULL : SMR_STATUS_SAR_EMPTY);
+}
+
+static void smr_cpu_copy_update_sar_entry(struct smr_region *smr,
+					  struct smr_cpu_copy_cmd *copy_cmd)
+{
+	struct smr_pend_entry *sar_entry = copy_cmd->entry_ptr;
+	struct smr_region *peer_smr;
+	struct smr_resp *resp;
+
+	sar_entry->bytes_done += copy_cmd->bytes_in_progress;
+	peer_smr = smr_peer_region(smr, sar_entry->cmd.msg.hdr.id);
+	resp = smr_get_ptr(peer_smr, sar_entry->cmd.msg.hdr.src_data);
+
+	assert(resp->status == SMR_STATUS_BUSY);
+	ofi_wmb();
+	resp->status = (copy_cmd->dir == OFI_COPY_IOV_TO_BUF ?
+			SMR_STATUS_SAR_FULL : SMR_STATUS_SAR_EMPTY);
+}
+
+void smr_cpu_copy_progress(struct smr_ep *ep)
+{
+	struct smr_cpu_copy_context *ctx = ep->cpu_copy_context;
+	struct smr_cpu_copy_cmd *copy_cmd;
+	struct dlist_entry *tmp;
+	bool tx_side;
+
+	if (!ctx || dlist_empty(&ctx->cmd_list))
+		return;
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	dlist_foreach_container_safe(&ctx->cmd_list, struct smr_cpu_copy_cmd,
+				     copy_cmd, entry, tmp) {
+		if (ofi_atomic_get32(&copy_cmd->chunks_left))
+			continue;
+
+		/* see dsa_process_complete_work() */
+		if (copy_cmd->op == ofi_op_read_req)
+			tx_side = copy_cmd->dir == OFI_COPY_BUF_TO_IOV;
+		else
+			tx_side = copy_cmd->dir == OFI_COPY_IOV_TO_BUF;
+
+		if (tx_side)
+			smr_cpu_copy_update_tx_entry(ep->region, copy_cmd);
+		else
+			smr_cpu_copy_update_sar_entry(ep->region, copy_cmd);
+
+		dlist_remove(&copy_cmd->entry);
+		ofi_buf_free(copy_cmd);
+	}
+	ofi_genlock_unlock(&ep->util_ep.lock);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _SMR_CPU_COPY_H_
+#define _SMR_CPU_COPY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "smr.h"
+
+/* Software fallback for the DSA SAR offload: a pool of helper threads
+ * performs the SAR copies while the progress thread continues.  Batches
+ * with less than SMR_CPU_COPY_MIN_SIZE left to move are copied inline
+ * since the hand-off costs more than the copy itself.
+ */
+#define SMR_CPU_COPY_MAX_THREADS	16
+#define SMR_CPU_COPY_MIN_SIZE		(2 * SMR_SAR_SIZE)
+
+static inline bool smr_cpu_copy_offload(struct smr_ep *ep,
+					struct smr_cmd *cmd,
+					struct ofi_mr **mr, size_t count,
+					size_t bytes_done)
+{
+	return ep->cpu_copy_context && ofi_mr_all_host(mr, count) &&
+	       cmd->msg.hdr.size - bytes_done >= SMR_CPU_COPY_MIN_SIZE;
+}
+
+/* SMR FUNCTIONS FOR CPU COPY ENGINE SUPPORT */
+void smr_cpu_copy_init(void);
+void smr_cpu_copy_cleanup(void);
+ssize_t smr_cpu_copy_to_sar(struct smr_ep *ep,
+		struct smr_freestack *sar_pool, struct smr_resp *resp,
+		struct smr_cmd *cmd, const struct iovec *iov, size_t count,
+		size_t *bytes_done, void *entry_ptr);
+ssize_t smr_cpu_copy_from_sar(struct smr_ep *ep,
+		struct smr_freestack *sar_pool, struct smr_resp *resp,
+		struct smr_cmd *cmd, const struct iovec *iov, size_t count,
+		size_t *bytes_done, void *entry_ptr);
+void smr_cpu_copy_context_init(struct smr_ep *ep);
+void smr_cpu_copy_context_cleanup(struct smr_ep *ep);
+void smr_cpu_copy_progress(struct smr_ep *ep);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _SMR_CPU_COPY_H_ */
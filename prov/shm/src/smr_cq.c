@@ -47,6 +47,7 @@ int smr_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		/* fall through */
 	case FI_WAIT_NONE:
 	case FI_WAIT_YIELD:
+	case FI_WAIT_FD:
 		break;
 	default:
 		FI_INFO(&smr_prov, FI_LOG_CQ, "CQ wait not yet supported\n");
@@ -59,8 +60,10 @@ int smr_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 
 	ret = ofi_cq_init(&smr_prov, domain, attr, cq, &ofi_cq_progress,
 			  context);
-	if (ret)
+	if (ret) {
+		free(cq);
 		return ret;
+	}
 
 	(*cq_fid) = &cq->cq_fid;
 
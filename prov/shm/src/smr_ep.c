@@ -42,6 +42,7 @@
 #include "smr_signal.h"
 #include "smr.h"
 #include "smr_dsa.h"
+#include "smr_cpu_copy.h"
 #include "ofi_xpmem.h"
 
 extern struct fi_ops_msg smr_msg_ops, smr_no_recv_msg_ops;
@@ -213,6 +214,7 @@ static void smr_send_name(struct smr_ep *ep, int64_t id)
 
 	smr_peer_data(ep->region)[id].name_sent = 1;
 	smr_cmd_queue_commit(ce, pos);
+	smr_signal(peer_smr);
 }
 
 int64_t smr_verify_peer(struct smr_ep *ep, fi_addr_t fi_addr)
@@ -221,7 +223,7 @@ int64_t smr_verify_peer(struct smr_ep *ep, fi_addr_t fi_addr)
 	int ret;
 
 	id = smr_addr_lookup(ep->util_ep.av, fi_addr);
-	assert(id < SMR_MAX_PEERS);
+	assert(id < ep->region->map->size);
 	if (id < 0)
 		return -1;
 
@@ -540,6 +542,20 @@ static int smr_format_sar(struct smr_ep *ep, struct smr_cmd *cmd,
 				}
 				return -FI_EAGAIN;
 			}
+		} else if (smr_cpu_copy_offload(ep, cmd, mr, count,
+						pending->bytes_done)) {
+			ret = smr_cpu_copy_to_sar(ep, smr_sar_pool(peer_smr),
+					resp, cmd, iov, count,
+					&pending->bytes_done, pending);
+			if (ret != FI_SUCCESS) {
+				for (i = cmd->msg.data.buf_batch_size - 1;
+				     i >= 0; i--) {
+					smr_freestack_push_by_index(
+					    smr_sar_pool(peer_smr),
+					    cmd->msg.data.sar[i]);
+				}
+				return -FI_EAGAIN;
+			}
 		} else {
 			smr_copy_to_sar(smr_sar_pool(peer_smr), resp, cmd,
 					mr, iov, count, &pending->bytes_done);
@@ -551,8 +567,8 @@ out:
 }
 
 int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
-		     bool ipc_valid, uint32_t op, uint64_t total_len,
-		     uint64_t op_flags)
+		     size_t vma_threshold, bool ipc_valid, uint32_t op,
+		     uint64_t total_len, uint64_t op_flags)
 {
 	struct ofi_mr *smr_desc;
 	enum fi_hmem_iface iface = FI_HMEM_SYSTEM;
@@ -576,7 +592,8 @@ int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
 	if (op == ofi_op_read_req) {
 		if (use_ipc)
 			return smr_src_ipc;
-		if (vma_avail && FI_HMEM_SYSTEM == iface)
+		if (vma_avail && FI_HMEM_SYSTEM == iface &&
+		    total_len >= vma_threshold)
 			return smr_src_iov;
 		return smr_src_sar;
 	}
@@ -595,7 +612,8 @@ int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
 	if (use_ipc)
 		return smr_src_ipc;
 
-	if (total_len > SMR_INJECT_SIZE && vma_avail)
+	if (total_len > SMR_INJECT_SIZE && total_len >= vma_threshold &&
+	    vma_avail)
 		return smr_src_iov;
 
 	if (op_flags & FI_DELIVERY_COMPLETE)
@@ -774,6 +792,235 @@ smr_proto_func smr_proto_ops[smr_src_max] = {
 	[smr_src_ipc] = &smr_do_ipc,
 };
 
+static bool smr_ep_idle(struct smr_ep *ep)
+{
+	bool idle;
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	idle = smr_cmd_queue_isempty(smr_cmd_queue(ep->region)) &&
+	       ofi_cirque_isempty(smr_resp_queue(ep->region)) &&
+	       dlist_empty(&ep->sar_list) &&
+	       dlist_empty(&ep->ipc_cpy_pend_list);
+	ofi_genlock_unlock(&ep->util_ep.lock);
+
+	return idle;
+}
+
+static ssize_t smr_ep_wake_flush(struct smr_ep *ep)
+{
+	ssize_t ret, cnt = 0;
+	char buf[64];
+
+	while ((ret = recv(ep->wake_fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+		cnt += ret;
+
+	return cnt;
+}
+
+/*
+ * Called from progress while the sleeping flag is set.  The flag is only
+ * cleared once a peer has actually woken us, since progress also runs from
+ * inside the wait itself before it blocks.
+ */
+void smr_ep_wake_drain(struct smr_ep *ep)
+{
+	if (!smr_ep_wake_flush(ep))
+		return;
+
+	ofi_atomic_store_explicit32(&ep->region->sleeping, 0,
+				    memory_order_relaxed);
+}
+
+/*
+ * Only an endpoint with nothing in flight may sleep.  Responses and SAR or
+ * IPC transfers are driven by peer writes that do not go through the command
+ * queue, so while any are outstanding we keep polling instead.
+ */
+static int smr_ep_trywait(void *arg)
+{
+	struct smr_ep *ep;
+
+	ep = container_of(arg, struct smr_ep, util_ep.ep_fid.fid);
+
+	smr_ep_progress(&ep->util_ep);
+
+	if (ep->wake_fd < 0 || !ep->region)
+		return FI_SUCCESS;
+
+	/* Anything left on the socket predates the flag and would let the
+	 * progress call made by the poll below clear it */
+	smr_ep_wake_flush(ep);
+	ofi_atomic_store_explicit32(&ep->region->sleeping, 1,
+				    memory_order_relaxed);
+	ofi_mb();
+	if (!smr_ep_idle(ep)) {
+		ofi_atomic_store_explicit32(&ep->region->sleeping, 0,
+					    memory_order_relaxed);
+		return -FI_EAGAIN;
+	}
+
+	return FI_SUCCESS;
+}
+
+/* The socket is bound to its region specific name once the ep is enabled */
+static int smr_ep_wake_open(struct smr_ep *ep, struct util_wait *wait)
+{
+	if (ep->wake_fd >= 0 || (wait->wait_obj != FI_WAIT_FD &&
+				 wait->wait_obj != FI_WAIT_POLLFD))
+		return FI_SUCCESS;
+
+	if (ep->region) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"fd wait objects must be bound before enabling ep\n");
+		return -FI_EOPBADSTATE;
+	}
+
+	ep->wake_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (ep->wake_fd < 0) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"unable to create wake socket: %s\n", strerror(errno));
+		return -ofi_syserr();
+	}
+
+	return FI_SUCCESS;
+}
+
+/*
+ * A socket left with our name can only belong to a dead process that had
+ * our pid.  The name is unlinked on close, or by the signal handlers.
+ */
+static int smr_ep_wake_bind(struct smr_ep *ep)
+{
+	struct sockaddr_un addr;
+	socklen_t len;
+
+	ep->wake_name = calloc(1, sizeof(*ep->wake_name));
+	if (!ep->wake_name)
+		return -FI_ENOMEM;
+
+	len = smr_wake_addr(ep->region, &addr);
+	(void) unlink(addr.sun_path);
+	if (bind(ep->wake_fd, (struct sockaddr *) &addr, len)) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"unable to bind wake socket %s: %s\n", addr.sun_path,
+			strerror(errno));
+		free(ep->wake_name);
+		ep->wake_name = NULL;
+		return -ofi_syserr();
+	}
+
+	strncpy(ep->wake_name->name, addr.sun_path, SMR_SOCK_NAME_MAX - 1);
+	pthread_mutex_lock(&sock_list_lock);
+	dlist_insert_tail(&ep->wake_name->entry, &sock_name_list);
+	pthread_mutex_unlock(&sock_list_lock);
+	return FI_SUCCESS;
+}
+
+static void smr_ep_wake_close(struct smr_ep *ep)
+{
+	if (ep->wake_name) {
+		pthread_mutex_lock(&sock_list_lock);
+		dlist_remove(&ep->wake_name->entry);
+		pthread_mutex_unlock(&sock_list_lock);
+		unlink(ep->wake_name->name);
+		free(ep->wake_name);
+	}
+
+	if (ep->wake_fd >= 0)
+		close(ep->wake_fd);
+}
+
+/* Each wait object gets the ep added once, however many times it is bound */
+static bool smr_ep_has_wait(struct smr_ep *ep, struct util_wait *wait)
+{
+	int i;
+
+	if ((ep->util_ep.tx_cq && ep->util_ep.tx_cq->wait == wait) ||
+	    (ep->util_ep.rx_cq && ep->util_ep.rx_cq->wait == wait))
+		return true;
+
+	for (i = 0; i < CNTR_CNT; i++) {
+		if (ep->util_ep.cntrs[i] && ep->util_ep.cntrs[i]->wait == wait)
+			return true;
+	}
+	return false;
+}
+
+static void smr_ep_del_waits(struct smr_ep *ep)
+{
+	struct util_wait *waits[CNTR_CNT + 2];
+	int i, j, cnt = 0;
+
+	if (ep->util_ep.tx_cq)
+		waits[cnt++] = ep->util_ep.tx_cq->wait;
+	if (ep->util_ep.rx_cq)
+		waits[cnt++] = ep->util_ep.rx_cq->wait;
+	for (i = 0; i < CNTR_CNT; i++) {
+		if (ep->util_ep.cntrs[i])
+			waits[cnt++] = ep->util_ep.cntrs[i]->wait;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (!waits[i])
+			continue;
+		for (j = 0; j < i && waits[j] != waits[i]; j++)
+			;
+		if (j == i)
+			(void) ofi_wait_del_fid(waits[i],
+						&ep->util_ep.ep_fid.fid);
+	}
+}
+
+static int smr_ep_add_wait(struct smr_ep *ep, struct util_wait *wait)
+{
+	int ret;
+
+	ret = smr_ep_wake_open(ep, wait);
+	if (ret)
+		return ret;
+
+	return ofi_wait_add_fid(wait, &ep->util_ep.ep_fid.fid, POLLIN,
+				smr_ep_trywait);
+}
+
+static int smr_ep_bind_cq(struct smr_ep *ep, struct util_cq *cq, uint64_t flags)
+{
+	bool added;
+	int ret;
+
+	added = cq->wait && smr_ep_has_wait(ep, cq->wait);
+	if (cq->wait && !added) {
+		ret = smr_ep_add_wait(ep, cq->wait);
+		if (ret)
+			return ret;
+	}
+
+	ret = ofi_ep_bind_cq(&ep->util_ep, cq, flags);
+	if (ret && cq->wait && !added)
+		(void) ofi_wait_del_fid(cq->wait, &ep->util_ep.ep_fid.fid);
+
+	return ret;
+}
+
+static int smr_ep_bind_cntr(struct smr_ep *ep, struct util_cntr *cntr, uint64_t flags)
+{
+	bool added;
+	int ret;
+
+	added = cntr->wait && smr_ep_has_wait(ep, cntr->wait);
+	if (cntr->wait && !added) {
+		ret = smr_ep_add_wait(ep, cntr->wait);
+		if (ret)
+			return ret;
+	}
+
+	ret = ofi_ep_bind_cntr(&ep->util_ep, cntr, flags);
+	if (ret && cntr->wait && !added)
+		(void) ofi_wait_del_fid(cntr->wait, &ep->util_ep.ep_fid.fid);
+
+	return ret;
+}
+
 static void smr_cleanup_epoll(struct smr_sock_info *sock_info)
 {
 	fd_signal_free(&sock_info->signal);
@@ -784,7 +1031,7 @@ static void smr_free_sock_info(struct smr_ep *ep)
 {
 	int i, j;
 
-	for (i = 0; i < SMR_MAX_PEERS; i++) {
+	for (i = 0; i < ep->region->map->size; i++) {
 		if (!ep->sock_info->peers[i].device_fds)
 			continue;
 		for (j = 0; j < ep->sock_info->nfds; j++)
@@ -804,6 +1051,7 @@ static int smr_ep_close(struct fid *fid)
 
 	if (smr_env.use_dsa_sar)
 		smr_dsa_context_cleanup(ep);
+	smr_cpu_copy_context_cleanup(ep);
 
 	if (ep->sock_info) {
 		fd_signal_set(&ep->sock_info->signal);
@@ -830,7 +1078,9 @@ static int smr_ep_close(struct fid *fid)
 			(void) util_srx_close(&ep->srx->ep_fid.fid);
 	}
 
+	smr_ep_del_waits(ep);
 	ofi_endpoint_close(&ep->util_ep);
+	smr_ep_wake_close(ep);
 
 	if (ep->region)
 		smr_free(ep->region);
@@ -851,53 +1101,6 @@ static int smr_ep_close(struct fid *fid)
 	return 0;
 }
 
-static int smr_ep_trywait(void *arg)
-{
-	struct smr_ep *ep;
-
-	ep = container_of(arg, struct smr_ep, util_ep.ep_fid.fid);
-
-	smr_ep_progress(&ep->util_ep);
-
-	return FI_SUCCESS;
-}
-
-static int smr_ep_bind_cq(struct smr_ep *ep, struct util_cq *cq, uint64_t flags)
-{
-	int ret;
-
-	ret = ofi_ep_bind_cq(&ep->util_ep, cq, flags);
-	if (ret)
-		return ret;
-
-	if (cq->wait) {
-		ret = ofi_wait_add_fid(cq->wait, &ep->util_ep.ep_fid.fid, 0,
-				       smr_ep_trywait);
-		if (ret)
-			return ret;
-	}
-
-	return ret;
-}
-
-static int smr_ep_bind_cntr(struct smr_ep *ep, struct util_cntr *cntr, uint64_t flags)
-{
-	int ret;
-
-	ret = ofi_ep_bind_cntr(&ep->util_ep, cntr, flags);
-	if (ret)
-		return ret;
-
-	if (cntr->wait) {
-		ret = ofi_wait_add_fid(cntr->wait, &ep->util_ep.ep_fid.fid, 0,
-				       smr_ep_trywait);
-		if (ret)
-			return ret;
-	}
-
-	return FI_SUCCESS;
-}
-
 static int smr_sendmsg_fd(int sock, int64_t id, int64_t peer_id,
 			  int *fds, int nfds)
 {
@@ -1125,7 +1328,7 @@ static int smr_ep_ctrl(struct fid *fid, int command, void *arg)
 	struct smr_av *av;
 	struct fid_ep *srx;
 	char tmp_name[SMR_NAME_MAX];
-	int ret;
+	int ret = 0;
 
 	ep = container_of(fid, struct smr_ep, util_ep.ep_fid.fid);
 	av = container_of(ep->util_ep.av, struct smr_av, util_av);
@@ -1158,6 +1361,12 @@ create_shm:
 				goto create_shm;
 		}
 
+		if (ep->wake_fd >= 0) {
+			ret = smr_ep_wake_bind(ep);
+			if (ret)
+				return ret;
+		}
+
 		if (ep->util_ep.caps & FI_HMEM || smr_env.disable_cma) {
 			ep->region->cma_cap_peer = SMR_VMA_CAP_OFF;
 			ep->region->cma_cap_self = SMR_VMA_CAP_OFF;
@@ -1196,6 +1405,8 @@ create_shm:
 
 		if (smr_env.use_dsa_sar)
 			smr_dsa_context_init(ep);
+		else if (smr_env.sar_copy_threads)
+			smr_cpu_copy_context_init(ep);
 
 		/* if XPMEM is on after exchanging peer info, then set the
 		 * endpoint p2p to XPMEM so it can be used on the fast
@@ -1204,6 +1415,16 @@ create_shm:
 		if (ep->region->xpmem_cap_self == SMR_VMA_CAP_ON)
 			ep->p2p_type = FI_SHM_P2P_XPMEM;
 
+		break;
+	case FI_GETWAITOBJ:
+		if (ep->wake_fd < 0)
+			return -FI_ENODATA;
+		*(enum fi_wait_obj *) arg = FI_WAIT_FD;
+		break;
+	case FI_GETWAIT:
+		if (ep->wake_fd < 0)
+			return -FI_ENODATA;
+		*(int *) arg = ep->wake_fd;
 		break;
 	default:
 		return -FI_ENOSYS;
@@ -1305,6 +1526,7 @@ int smr_endpoint(struct fid_domain *domain, struct fi_info *info,
 	char name[SMR_NAME_MAX];
 
 	smr_init_sig_handlers();
+	smr_calibrate();
 
 	ep = calloc(1, sizeof(*ep));
 	if (!ep)
@@ -1338,6 +1560,7 @@ int smr_endpoint(struct fid_domain *domain, struct fi_info *info,
 	dlist_init(&ep->ipc_cpy_pend_list);
 
 	ep->min_multi_recv_size = SMR_INJECT_SIZE;
+	ep->wake_fd = -1;
 
 	ep->util_ep.ep_fid.fid.ops = &smr_ep_fi_ops;
 	ep->util_ep.ep_fid.ops = &smr_ep_ops;
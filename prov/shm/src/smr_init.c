@@ -36,6 +36,7 @@
 #include "smr.h"
 #include "smr_signal.h"
 #include "smr_dsa.h"
+#include "smr_cpu_copy.h"
 #include <ofi_hmem.h>
 
 struct sigaction *old_action = NULL;
@@ -46,8 +47,31 @@ struct smr_env smr_env = {
 	.use_dsa_sar = false,
 	.max_gdrcopy_size = 3072,
 	.use_xpmem = false,
+	.max_peers = SMR_DEFAULT_PEERS,
+	.cma_threshold = 0,
+	.xpmem_threshold = 0,
+	.cma_threshold_remote = 0,
+	.xpmem_threshold_remote = 0,
+	.numa_policy = OFI_MPOL_PREFERRED,
+	.calibrate = false,
 };
 
+static void smr_init_numa_policy(void)
+{
+	char *policy = NULL;
+
+	fi_param_get_str(&smr_prov, "numa_policy", &policy);
+	if (!policy || !strcasecmp(policy, "preferred"))
+		smr_env.numa_policy = OFI_MPOL_PREFERRED;
+	else if (!strcasecmp(policy, "bind"))
+		smr_env.numa_policy = OFI_MPOL_BIND;
+	else if (!strcasecmp(policy, "none"))
+		smr_env.numa_policy = 0;
+	else
+		FI_WARN(&smr_prov, FI_LOG_CORE,
+			"Invalid numa_policy %s, using preferred\n", policy);
+}
+
 static void smr_init_env(void)
 {
 	fi_param_get_size_t(&smr_prov, "sar_threshold", &smr_env.sar_threshold);
@@ -55,7 +79,28 @@ static void smr_init_env(void)
 	fi_param_get_size_t(&smr_prov, "rx_size", &smr_info.rx_attr->size);
 	fi_param_get_bool(&smr_prov, "disable_cma", &smr_env.disable_cma);
 	fi_param_get_bool(&smr_prov, "use_dsa_sar", &smr_env.use_dsa_sar);
+	fi_param_get_size_t(&smr_prov, "sar_copy_threads",
+			    &smr_env.sar_copy_threads);
+	fi_param_get_str(&smr_prov, "sar_copy_affinity",
+			 &smr_env.sar_copy_affinity);
 	fi_param_get_bool(&smr_prov, "use_xpmem", &smr_env.use_xpmem);
+	fi_param_get_size_t(&smr_prov, "cma_threshold", &smr_env.cma_threshold);
+	fi_param_get_size_t(&smr_prov, "xpmem_threshold",
+			    &smr_env.xpmem_threshold);
+	fi_param_get_size_t(&smr_prov, "cma_threshold_remote",
+			    &smr_env.cma_threshold_remote);
+	fi_param_get_size_t(&smr_prov, "xpmem_threshold_remote",
+			    &smr_env.xpmem_threshold_remote);
+	smr_init_numa_policy();
+	fi_param_get_bool(&smr_prov, "calibrate", &smr_env.calibrate);
+	fi_param_get_str(&smr_prov, "calibrate_file", &smr_env.calibrate_file);
+	fi_param_get_size_t(&smr_prov, "max_peers", &smr_env.max_peers);
+	if (!smr_env.max_peers || smr_env.max_peers > SMR_MAX_PEERS) {
+		FI_WARN(&smr_prov, FI_LOG_CORE,
+			"Invalid max_peers %zu, using %d\n",
+			smr_env.max_peers, SMR_DEFAULT_PEERS);
+		smr_env.max_peers = SMR_DEFAULT_PEERS;
+	}
 }
 
 static void smr_resolve_addr(const char *node, const char *service,
@@ -87,9 +132,9 @@ static void smr_resolve_addr(const char *node, const char *service,
 /*
  * The smr_shm_space_check is to check if there's enough shm space we
  * need under /dev/shm.
- * Here we use #core instead of SMR_MAX_PEERS, as it is the most likely
- * value and has less possibility of failing fi_getinfo calls that are
- * currently passing, and breaking currently working app
+ * Here we use #core instead of the number of peers, as it is the most
+ * likely value and has less possibility of failing fi_getinfo calls that
+ * are currently passing, and breaking currently working app
  */
 static int smr_shm_space_check(size_t tx_count, size_t rx_count)
 {
@@ -107,6 +152,7 @@ static int smr_shm_space_check(size_t tx_count, size_t rx_count)
 	}
 	shm_size_needed = num_of_core *
 			  smr_calculate_size_offsets(tx_count, rx_count,
+						     smr_env.max_peers,
 						     NULL, NULL, NULL,
 						     NULL, NULL, NULL,
 						     NULL);
@@ -181,6 +227,7 @@ static void smr_fini(void)
 	ofi_hmem_cleanup();
 #endif
 	smr_dsa_cleanup();
+	smr_cpu_copy_cleanup();
 	smr_cleanup();
 	free(old_action);
 }
@@ -220,14 +267,53 @@ SHM_INI
 			"Manually disables CMA. Default: false");
 	fi_param_define(&smr_prov, "use_dsa_sar", FI_PARAM_BOOL,
 			"Enable use of DSA in SAR protocol. Default: false");
+	fi_param_define(&smr_prov, "sar_copy_threads", FI_PARAM_SIZE_T,
+			"Number of helper threads used to copy SAR buffers "
+			"asynchronously when DSA is not in use. 0 copies from "
+			"the progress thread (default: 0, max: 16)");
+	fi_param_define(&smr_prov, "sar_copy_affinity", FI_PARAM_STRING,
+			"Comma separated list of cpus the SAR copy threads "
+			"are pinned to, the n-th entry is used for the n-th "
+			"thread (default: none)");
 	fi_param_define(&smr_prov, "use_xpmem", FI_PARAM_BOOL,
 			"Enable XPMEM over CMA when possible "
 			"(default: false)");
+	fi_param_define(&smr_prov, "cma_threshold", FI_PARAM_SIZE_T,
+			"Min size to use CMA instead of SAR for transfers "
+			"larger than the inject size (default: 0)");
+	fi_param_define(&smr_prov, "xpmem_threshold", FI_PARAM_SIZE_T,
+			"Min size to use XPMEM instead of SAR for transfers "
+			"larger than the inject size (default: 0)");
+	fi_param_define(&smr_prov, "cma_threshold_remote", FI_PARAM_SIZE_T,
+			"cma_threshold for peers on another socket "
+			"(default: 0)");
+	fi_param_define(&smr_prov, "xpmem_threshold_remote", FI_PARAM_SIZE_T,
+			"xpmem_threshold for peers on another socket "
+			"(default: 0)");
+	fi_param_define(&smr_prov, "numa_policy", FI_PARAM_STRING,
+			"NUMA policy placing the shared memory region of an "
+			"endpoint on the node of its owner, if all cpus the "
+			"owner may run on belong to one node: none, preferred "
+			"or bind (default: preferred)");
+	fi_param_define(&smr_prov, "calibrate", FI_PARAM_BOOL,
+			"Measure SAR, CMA and XPMEM copy times when the first "
+			"endpoint is created and set the CMA and XPMEM "
+			"thresholds from them, unless set explicitly. The "
+			"result is logged at info level (default: false)");
+	fi_param_define(&smr_prov, "calibrate_file", FI_PARAM_STRING,
+			"File in which calibration results are kept for later "
+			"runs on the same host (default: none)");
+	fi_param_define(&smr_prov, "max_peers", FI_PARAM_SIZE_T,
+			"Number of peers each endpoint and AV is sized for. "
+			"Larger AV counts grow the peer map as needed. "
+			"Lower to reduce the /dev/shm footprint of small jobs "
+			"(default: 256, max: 16384)");
 
 	smr_init_env();
 
 	if (smr_env.use_dsa_sar)
 		smr_dsa_init();
+	smr_cpu_copy_init();
 
 	old_action = calloc(SIGRTMIN, sizeof(*old_action));
 	if (!old_action)
@@ -112,6 +112,7 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 	assert(!(op_flags & FI_INJECT) || total_len <= SMR_INJECT_SIZE);
 
 	proto = smr_select_proto(desc, iov_count, smr_vma_enabled(ep, peer_smr),
+				 smr_vma_threshold(ep, id),
 	                         smr_ipc_valid(ep, peer_smr, id, peer_id), op,
 				 total_len, op_flags);
 
@@ -123,6 +124,7 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 		goto unlock;
 	}
 	smr_cmd_queue_commit(ce, pos);
+	smr_signal(peer_smr);
 
 	if (proto != smr_src_inline && proto != smr_src_inject)
 		goto unlock;
@@ -219,6 +221,7 @@ static ssize_t smr_generic_inject(struct fid_ep *ep_fid, const void *buf,
 		return -FI_EAGAIN;
 	}
 	smr_cmd_queue_commit(ce, pos);
+	smr_signal(peer_smr);
 	ofi_ep_peer_tx_cntr_inc(&ep->util_ep, op);
 
 	return FI_SUCCESS;
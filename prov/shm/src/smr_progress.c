@@ -42,6 +42,7 @@
 #include "ofi_shm_p2p.h"
 #include "smr.h"
 #include "smr_dsa.h"
+#include "smr_cpu_copy.h"
 
 static inline void
 smr_try_progress_to_sar(struct smr_ep *ep, struct smr_region *smr,
@@ -55,6 +56,10 @@ smr_try_progress_to_sar(struct smr_ep *ep, struct smr_region *smr,
 			(void) smr_dsa_copy_to_sar(ep, sar_pool, resp, cmd, iov,
 					    iov_count, bytes_done, entry_ptr);
 			return;
+		} else if (smr_cpu_copy_offload(ep, cmd, mr, iov_count,
+						*bytes_done)) {
+			(void) smr_cpu_copy_to_sar(ep, sar_pool, resp, cmd,
+					iov, iov_count, bytes_done, entry_ptr);
 		} else {
 			smr_copy_to_sar(sar_pool, resp, cmd, mr, iov, iov_count,
 					bytes_done);
@@ -74,6 +79,10 @@ smr_try_progress_from_sar(struct smr_ep *ep, struct smr_region *smr,
 			(void) smr_dsa_copy_from_sar(ep, sar_pool, resp, cmd,
 					iov, iov_count, bytes_done, entry_ptr);
 			return;
+		} else if (smr_cpu_copy_offload(ep, cmd, mr, iov_count,
+						*bytes_done)) {
+			(void) smr_cpu_copy_from_sar(ep, sar_pool, resp, cmd,
+					iov, iov_count, bytes_done, entry_ptr);
 		} else {
 			smr_copy_from_sar(sar_pool, resp, cmd, mr,
 					  iov, iov_count, bytes_done);
@@ -620,10 +629,18 @@ static void smr_do_atomic(void *src, struct ofi_mr *dst_mr, void *dst,
 		ofi_atomic_swap_handler(op, datatype, cpy_dst, src, cmp,
 					tmp_result, cnt);
 	} else if (flags & SMR_RMA_REQ && ofi_atomic_isreadwrite_op(op)) {
-		ofi_atomic_readwrite_handler(op, datatype, cpy_dst, src,
-					     tmp_result, cnt);
+		/* The host bounce buffer is private and needs no atomicity */
+		if (cpy_dst != dst)
+			ofi_reduce_readwrite_handler(op, datatype, cpy_dst, src,
+						     tmp_result, cnt);
+		else
+			ofi_atomic_readwrite_handler(op, datatype, cpy_dst, src,
+						     tmp_result, cnt);
 	} else if (ofi_atomic_iswrite_op(op)) {
-		ofi_atomic_write_handler(op, datatype, cpy_dst, src, cnt);
+		if (cpy_dst != dst)
+			ofi_reduce_write_handler(op, datatype, cpy_dst, src, cnt);
+		else
+			ofi_atomic_write_handler(op, datatype, cpy_dst, src, cnt);
 	} else {
 		FI_WARN(&smr_prov, FI_LOG_EP_DATA,
 			"invalid atomic operation\n");
@@ -901,14 +918,20 @@ static void smr_progress_connreq(struct smr_ep *ep, struct smr_cmd *cmd)
 		peer_smr = smr_peer_region(ep->region, idx);
 	}
 
+	if (cmd->msg.hdr.id >= peer_smr->max_peers) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"Peer id %" PRId64 " out of range\n", cmd->msg.hdr.id);
+		smr_release_txbuf(ep->region, tx_buf);
+		return;
+	}
+
 	smr_set_ipc_valid(ep->region, idx);
 	smr_peer_data(peer_smr)[cmd->msg.hdr.id].addr.id = idx;
 	smr_peer_data(ep->region)[idx].addr.id = cmd->msg.hdr.id;
 
 	smr_release_txbuf(ep->region, tx_buf);
 	assert(ep->region->map->num_peers > 0);
-	ep->region->max_sar_buf_per_peer = SMR_MAX_PEERS /
-		ep->region->map->num_peers;
+	smr_update_sar_buf_per_peer(ep->region);
 }
 
 static int smr_alloc_cmd_ctx(struct smr_ep *ep,
@@ -1458,8 +1481,14 @@ void smr_ep_progress(struct util_ep *util_ep)
 	if (!ep->region)
 		return;
 
+	if (ep->wake_fd >= 0 &&
+	    ofi_atomic_load_explicit32(&ep->region->sleeping,
+				       memory_order_relaxed))
+		smr_ep_wake_drain(ep);
+
 	if (smr_env.use_dsa_sar)
 		smr_dsa_progress(ep);
+	smr_cpu_copy_progress(ep);
 	smr_progress_resp(ep);
 	smr_progress_sar_list(ep);
 	smr_progress_cmd(ep);
@@ -38,8 +38,11 @@
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <stdio.h>
+#include <dirent.h>
 #include <ofi_xpmem.h>
 
 #include "smr_util.h"
@@ -49,6 +52,9 @@ struct dlist_entry ep_name_list;
 DEFINE_LIST(ep_name_list);
 pthread_mutex_t ep_list_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/* unbound datagram socket used to wake sleeping peers, see smr_signal() */
+static int smr_wake_sock = -1;
+
 void smr_cleanup(void)
 {
 	struct smr_ep_name *ep_name;
@@ -58,9 +64,47 @@ void smr_cleanup(void)
 	dlist_foreach_container_safe(&ep_name_list, struct smr_ep_name,
 				     ep_name, entry, tmp)
 		free(ep_name);
+
+	if (smr_wake_sock >= 0) {
+		close(smr_wake_sock);
+		smr_wake_sock = -1;
+	}
 	pthread_mutex_unlock(&ep_list_lock);
 }
 
+/*
+ * The wake socket is bound next to the shm regions rather than in the
+ * abstract namespace, which is private to a network namespace.  Peers that
+ * can map the region can then always reach the socket.  The owner's pid and
+ * base address make the name unique per region without storing anything
+ * else in shared memory.
+ */
+socklen_t smr_wake_addr(struct smr_region *smr, struct sockaddr_un *addr)
+{
+	int len;
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	len = snprintf(addr->sun_path, sizeof(addr->sun_path),
+		       "%sfi_shm_wake_%d_%p", SMR_DIR, smr->pid,
+		       smr->base_addr);
+
+	return (socklen_t) (offsetof(struct sockaddr_un, sun_path) + len + 1);
+}
+
+void smr_wake(struct smr_region *smr)
+{
+	struct sockaddr_un addr;
+	socklen_t len;
+	char byte = 0;
+
+	assert(smr_wake_sock >= 0);
+	/* A full socket buffer already means the owner has a wakeup pending */
+	len = smr_wake_addr(smr, &addr);
+	(void) sendto(smr_wake_sock, &byte, sizeof(byte), MSG_DONTWAIT,
+		      (struct sockaddr *) &addr, len);
+}
+
 void smr_cma_check(struct smr_region *smr, struct smr_region *peer_smr)
 {
 	struct iovec local_iov, remote_iov;
@@ -90,17 +134,18 @@ void smr_cma_check(struct smr_region *smr, struct smr_region *peer_smr)
 }
 
 size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
-				  size_t *cmd_offset, size_t *resp_offset,
+				  size_t peer_count, size_t *cmd_offset, size_t *resp_offset,
 				  size_t *inject_offset, size_t *sar_offset,
 				  size_t *peer_offset, size_t *name_offset,
 				  size_t *sock_offset)
 {
 	size_t cmd_queue_offset, resp_queue_offset, inject_pool_offset;
 	size_t sar_pool_offset, peer_data_offset, ep_name_offset;
-	size_t tx_size, rx_size, total_size, sock_name_offset;
+	size_t tx_size, rx_size, sar_size, total_size, sock_name_offset;
 
 	tx_size = roundup_power_of_two(tx_count);
 	rx_size = roundup_power_of_two(rx_count);
+	sar_size = roundup_power_of_two(peer_count);
 
 	/* Align cmd_queue offset to cache line */
 	cmd_queue_offset = ofi_get_aligned_size(sizeof(struct smr_region), 64);
@@ -111,9 +156,9 @@ size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
 	sar_pool_offset = inject_pool_offset +
 		freestack_size(sizeof(struct smr_inject_buf), rx_size);
 	peer_data_offset = sar_pool_offset +
-		freestack_size(sizeof(struct smr_sar_buf), SMR_MAX_PEERS);
+		freestack_size(sizeof(struct smr_sar_buf), sar_size);
 	ep_name_offset = peer_data_offset + sizeof(struct smr_peer_data) *
-		SMR_MAX_PEERS;
+		peer_count;
 
 	sock_name_offset = ep_name_offset + SMR_NAME_MAX;
 
@@ -182,6 +227,113 @@ err:
 	return -FI_EBUSY;
 }
 
+static int smr_read_topo(int cpu, const char *file)
+{
+	char path[PATH_MAX];
+	FILE *fp;
+	int val;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s",
+		 cpu, file);
+	fp = fopen(path, "r");
+	if (!fp)
+		return -1;
+
+	if (fscanf(fp, "%d", &val) != 1)
+		val = -1;
+	fclose(fp);
+	return val;
+}
+
+static int smr_cpu_node(int cpu)
+{
+	char path[PATH_MAX];
+	struct dirent *entry;
+	int node = -1;
+	DIR *dir;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+	dir = opendir(path);
+	if (!dir)
+		return -1;
+
+	while ((entry = readdir(dir))) {
+		if (sscanf(entry->d_name, "node%d", &node) == 1)
+			break;
+	}
+	closedir(dir);
+	return node;
+}
+
+/* The id of the highest level cache is unique within a package */
+static int smr_cpu_llc(int cpu)
+{
+	char file[64];
+	int i, level, max_level = 0, llc = -1;
+
+	for (i = 0; ; i++) {
+		snprintf(file, sizeof(file), "cache/index%d/level", i);
+		level = smr_read_topo(cpu, file);
+		if (level < 0)
+			break;
+		if (level > max_level) {
+			max_level = level;
+			snprintf(file, sizeof(file), "cache/index%d/id", i);
+			llc = smr_read_topo(cpu, file);
+		}
+	}
+	return llc;
+}
+
+static void smr_topo_merge(int32_t *topo, int val, bool first)
+{
+	if (first)
+		*topo = val;
+	else if (*topo != val)
+		*topo = -1;
+}
+
+/* Finds the topology shared by all cpus in the affinity mask of the
+ * calling thread.
+ */
+static void smr_topo_get(int32_t *node, int32_t *package, int32_t *llc)
+{
+	cpu_set_t set;
+	bool first = true;
+	int cpu;
+
+	*node = *package = *llc = -1;
+	if (sched_getaffinity(0, sizeof(set), &set))
+		return;
+
+	for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+		if (!CPU_ISSET(cpu, &set))
+			continue;
+
+		smr_topo_merge(node, smr_cpu_node(cpu), first);
+		smr_topo_merge(package,
+			       smr_read_topo(cpu, "topology/physical_package_id"),
+			       first);
+		smr_topo_merge(llc, smr_cpu_llc(cpu), first);
+		first = false;
+
+		if (*node < 0 && *package < 0)
+			break;
+	}
+}
+
+static enum smr_locality smr_peer_locality(struct smr_region *region,
+					   struct smr_region *peer_smr)
+{
+	if (region->package < 0 || peer_smr->package < 0)
+		return SMR_LOC_UNKNOWN;
+	if (region->package != peer_smr->package)
+		return SMR_LOC_REMOTE;
+	if (region->llc >= 0 && region->llc == peer_smr->llc)
+		return SMR_LOC_LLC;
+	return SMR_LOC_SOCKET;
+}
+
 static void smr_lock_init(pthread_spinlock_t *lock)
 {
 	pthread_spin_init(lock, PTHREAD_PROCESS_SHARED);
@@ -195,13 +347,15 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	size_t total_size, cmd_queue_offset, peer_data_offset;
 	size_t resp_queue_offset, inject_pool_offset, name_offset;
 	size_t sar_pool_offset, sock_name_offset;
+	int32_t node, package, llc;
 	int fd, ret, i;
 	void *mapped_addr;
 	size_t tx_size, rx_size;
 
 	tx_size = roundup_power_of_two(attr->tx_count);
 	rx_size = roundup_power_of_two(attr->rx_count);
-	total_size = smr_calculate_size_offsets(tx_size, rx_size, &cmd_queue_offset,
+	total_size = smr_calculate_size_offsets(tx_size, rx_size, map->size,
+					&cmd_queue_offset,
 					&resp_queue_offset, &inject_pool_offset,
 					&sar_pool_offset, &peer_data_offset,
 					&name_offset, &sock_name_offset);
@@ -225,6 +379,8 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 			"Overwriting shm from dead process (%s)\n", attr->name);
 	}
 
+	smr_topo_get(&node, &package, &llc);
+
 	ep_name = calloc(1, sizeof(*ep_name));
 	if (!ep_name) {
 		FI_WARN(prov, FI_LOG_EP_CTRL, "calloc error\n");
@@ -237,6 +393,18 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	pthread_mutex_lock(&ep_list_lock);
 	dlist_insert_tail(&ep_name->entry, &ep_name_list);
 
+	/* Without it this process could never wake a sleeping peer */
+	if (smr_wake_sock < 0) {
+		smr_wake_sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (smr_wake_sock < 0) {
+			FI_WARN(prov, FI_LOG_EP_CTRL,
+				"unable to create wake socket: %s\n",
+				strerror(errno));
+			ret = -ofi_syserr();
+			goto remove;
+		}
+	}
+
 	ret = ftruncate(fd, total_size);
 	if (ret < 0) {
 		FI_WARN(prov, FI_LOG_EP_CTRL, "ftruncate error\n");
@@ -254,6 +422,18 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 
 	close(fd);
 
+	/* Peers write commands, inject data and SAR data into the region
+	 * for the owner to consume, so keep its pages on the owner's node.
+	 * Must precede the first touch of the pages.
+	 */
+	if (smr_env.numa_policy && node >= 0) {
+		ret = ofi_mbind_node(mapped_addr, total_size, node,
+				     smr_env.numa_policy);
+		if (ret)
+			FI_DBG(prov, FI_LOG_EP_CTRL, "mbind failed: %s\n",
+			       fi_strerror(-ret));
+	}
+
 	if (attr->flags & SMR_FLAG_HMEM_ENABLED) {
 		ret = ofi_hmem_host_register(mapped_addr, total_size);
 		if (ret)
@@ -299,14 +479,19 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	(*smr)->name_offset = name_offset;
 	(*smr)->sock_name_offset = sock_name_offset;
 	(*smr)->max_sar_buf_per_peer = SMR_BUF_BATCH_MAX;
+	(*smr)->max_peers = map->size;
+	ofi_atomic_initialize32(&(*smr)->sleeping, 0);
+	(*smr)->node = node;
+	(*smr)->package = package;
+	(*smr)->llc = llc;
 
 	smr_cmd_queue_init(smr_cmd_queue(*smr), rx_size);
 	smr_resp_queue_init(smr_resp_queue(*smr), tx_size);
 	smr_freestack_init(smr_inject_pool(*smr), rx_size,
 			sizeof(struct smr_inject_buf));
-	smr_freestack_init(smr_sar_pool(*smr), SMR_MAX_PEERS,
+	smr_freestack_init(smr_sar_pool(*smr), roundup_power_of_two(map->size),
 			sizeof(struct smr_sar_buf));
-	for (i = 0; i < SMR_MAX_PEERS; i++) {
+	for (i = 0; i < map->size; i++) {
 		smr_peer_data(*smr)[i].addr.id = -1;
 		smr_peer_data(*smr)[i].sar_status = 0;
 		smr_peer_data(*smr)[i].name_sent = 0;
@@ -457,6 +642,10 @@ void smr_map_to_endpoint(struct smr_region *region, int64_t id)
 	    (region == peer_smr && region->cma_cap_self == SMR_VMA_CAP_NA))
 		smr_cma_check(region, peer_smr);
 
+	local_peers[id].locality = smr_peer_locality(region, peer_smr);
+	FI_DBG(&smr_prov, FI_LOG_EP_CTRL, "peer %s locality %d\n",
+	       region->map->peers[id].peer.name, local_peers[id].locality);
+
 	/* enable xpmem locally if the peer also has it enabled */
 	if (peer_smr->xpmem_cap_self == SMR_VMA_CAP_ON &&
 	    region->xpmem_cap_self == SMR_VMA_CAP_ON) {
@@ -549,7 +738,7 @@ void smr_exchange_all_peers(struct smr_region *region)
 	int64_t i;
 
 	ofi_spin_lock(&region->map->lock);
-	for (i = 0; i < SMR_MAX_PEERS; i++)
+	for (i = 0; i < region->map->size; i++)
 		smr_map_to_endpoint(region, i);
 
 	ofi_spin_unlock(&region->map->lock);
@@ -568,18 +757,27 @@ int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 	if (ret) {
 		assert(ret == -FI_EALREADY);
 		*id = (intptr_t) node->data;
+		ret = 0;
 		goto out;
 	}
 
-	while (map->peers[map->cur_id].peer.id != -1 && tries < SMR_MAX_PEERS) {
-		if (++map->cur_id == SMR_MAX_PEERS)
+	while (map->peers[map->cur_id].peer.id != -1 && tries < map->size) {
+		if (++map->cur_id == map->size)
 			map->cur_id = 0;
 		tries++;
 	}
 
-	assert(map->cur_id < SMR_MAX_PEERS && tries < SMR_MAX_PEERS);
+	if (tries == map->size) {
+		FI_WARN(prov, FI_LOG_AV, "peer map full (%d entries)\n",
+			map->size);
+		ofi_rbmap_delete(&map->rbmap, node);
+		*id = -1;
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
 	*id = map->cur_id;
-	if (++map->cur_id == SMR_MAX_PEERS)
+	if (++map->cur_id == map->size)
 		map->cur_id = 0;
 	node->data = (void *) (intptr_t) *id;
 	strncpy(map->peers[*id].peer.name, shm_name, SMR_NAME_MAX);
@@ -590,7 +788,7 @@ int smr_map_add(const struct fi_provider *prov, struct smr_map *map,
 
 out:
 	ofi_spin_unlock(&map->lock);
-	return FI_SUCCESS;
+	return ret;
 }
 
 void smr_map_del(struct smr_map *map, int64_t id)
@@ -598,7 +796,7 @@ void smr_map_del(struct smr_map *map, int64_t id)
 	struct smr_ep_name *name;
 	bool local = false;
 
-	assert(id >= 0 && id < SMR_MAX_PEERS);
+	assert(id >= 0 && id < map->size);
 	pthread_mutex_lock(&ep_list_lock);
 	dlist_foreach_container(&ep_name_list, struct smr_ep_name, name, entry) {
 		if (!strcmp(name->name, map->peers[id].peer.name)) {
@@ -618,7 +816,7 @@ void smr_map_del(struct smr_map *map, int64_t id)
 
 struct smr_region *smr_map_get(struct smr_map *map, int64_t id)
 {
-	if (id < 0 || id >= SMR_MAX_PEERS)
+	if (id < 0 || id >= map->size)
 		return NULL;
 
 	return map->peers[id].region;
@@ -47,6 +47,7 @@
 #include <ofi_tree.h>
 #include <ofi_hmem.h>
 #include <ofi_atomic_queue.h>
+#include <ofi_mb.h>
 
 #include <rdma/providers/fi_prov.h>
 
@@ -54,7 +55,7 @@
 extern "C" {
 #endif
 
-#define SMR_VERSION	8
+#define SMR_VERSION	11
 
 #define SMR_FLAG_ATOMIC	(1 << 0)
 #define SMR_FLAG_DEBUG	(1 << 1)
@@ -92,6 +93,18 @@ enum {
 	SMR_VMA_CAP_OFF,
 };
 
+/* Placement of a peer relative to the local endpoint, derived from the
+ * cpus each region owner may run on.  SMR_LOC_LLC: same last level cache
+ * (core complex), SMR_LOC_SOCKET: same package, SMR_LOC_REMOTE: another
+ * package.
+ */
+enum smr_locality {
+	SMR_LOC_UNKNOWN,
+	SMR_LOC_LLC,
+	SMR_LOC_SOCKET,
+	SMR_LOC_REMOTE,
+};
+
 /*
  * Unique smr_op_hdr for smr message protocol:
  * 	addr - local shm_id of peer sending msg (for shm lookup)
@@ -182,6 +195,7 @@ struct smr_peer_data {
 	uint32_t		sar_status;
 	uint16_t		name_sent;
 	uint16_t		ipc_valid;
+	uint32_t		locality;
 	struct ofi_xpmem_client xpmem;
 };
 
@@ -212,15 +226,22 @@ struct smr_peer {
 	int			pid_fd;
 };
 
-#define SMR_MAX_PEERS	256
+/*
+ * The peer map, peer data and SAR pool of a region are sized for the number
+ * of peers selected when the AV is opened.  SMR_MAX_PEERS bounds that value
+ * so the SAR pool can still be indexed by the 16-bit freestack entries.
+ */
+#define SMR_DEFAULT_PEERS	256
+#define SMR_MAX_PEERS		(1 << 14)
 
 struct smr_map {
 	ofi_spin_t		lock;
 	int64_t			cur_id;
 	int 			num_peers;
+	int			size;
 	uint16_t		flags;
 	struct ofi_rbmap	rbmap;
-	struct smr_peer		peers[SMR_MAX_PEERS];
+	struct smr_peer		*peers;
 };
 
 struct smr_region {
@@ -236,6 +257,7 @@ struct smr_region {
 	uint8_t		resv2;
 
 	uint32_t	max_sar_buf_per_peer;
+	uint32_t	max_peers;
 	struct ofi_xpmem_pinfo	xpmem_self;
 	struct ofi_xpmem_pinfo	xpmem_peer;
 	void		*base_addr;
@@ -256,6 +278,16 @@ struct smr_region {
 	size_t		peer_data_offset;
 	size_t		name_offset;
 	size_t		sock_name_offset;
+
+	/* set by an idle owner blocked on its wake socket, see smr_signal() */
+	ofi_atomic32_t	sleeping;
+
+	/* NUMA node, package and last level cache of the cpus the owner may
+	 * run on, -1 if they span more than one
+	 */
+	int32_t		node;
+	int32_t		package;
+	int32_t		llc;
 };
 
 struct smr_resp {
@@ -341,6 +373,29 @@ static inline void smr_set_map(struct smr_region *smr, struct smr_map *map)
 	smr->map = map;
 }
 
+static inline void smr_update_sar_buf_per_peer(struct smr_region *smr)
+{
+	smr->max_sar_buf_per_peer = smr->map->num_peers ?
+		smr_sar_pool(smr)->size / smr->map->num_peers :
+		SMR_BUF_BATCH_MAX;
+}
+
+/*
+ * Peers only poke the owner's wake socket when it has advertised that it is
+ * about to block, so busy polling endpoints never see a syscall.  The fence
+ * orders the command queue commit against the load of the sleeping flag and
+ * pairs with the one in the owner's trywait.
+ */
+void	smr_wake(struct smr_region *smr);
+socklen_t smr_wake_addr(struct smr_region *smr, struct sockaddr_un *addr);
+
+static inline void smr_signal(struct smr_region *smr)
+{
+	ofi_mb();
+	if (ofi_atomic_load_explicit32(&smr->sleeping, memory_order_relaxed))
+		smr_wake(smr);
+}
+
 struct smr_attr {
 	const char	*name;
 	size_t		rx_count;
@@ -349,7 +404,7 @@ struct smr_attr {
 };
 
 size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
-				  size_t *cmd_offset, size_t *resp_offset,
+				  size_t peer_count, size_t *cmd_offset, size_t *resp_offset,
 				  size_t *inject_offset, size_t *sar_offset,
 				  size_t *peer_offset, size_t *name_offset,
 				  size_t *sock_offset);
@@ -75,13 +75,18 @@
 #define SM2_IOV_LIMIT		4
 #define SM2_PREFIX		"fi_sm2://"
 #define SM2_PREFIX_NS		"fi_ns://"
-#define SM2_VERSION		1
+#define SM2_VERSION		3
 #define SM2_IOV_LIMIT		4
 #define SM2_INJECT_SIZE		(SM2_XFER_ENTRY_SIZE - sizeof(struct sm2_xfer_hdr))
 
 #define SM2_ATOMIC_INJECT_SIZE	    (SM2_INJECT_SIZE - sizeof(struct sm2_atomic_hdr))
 #define SM2_ATOMIC_COMP_INJECT_SIZE (SM2_ATOMIC_INJECT_SIZE / 2)
 
+struct sm2_env {
+	size_t universe_size;
+};
+
+extern struct sm2_env sm2_env;
 extern struct fi_provider sm2_prov;
 extern struct fi_info sm2_info;
 extern struct util_prov sm2_util_prov;
@@ -217,7 +222,7 @@ int sm2_fabric(struct fi_fabric_attr *attr, struct fid_fabric **fabric,
 
 struct sm2_av {
 	struct util_av util_av;
-	fi_addr_t reverse_lookup[SM2_MAX_UNIVERSE_SIZE];
+	fi_addr_t *reverse_lookup;
 	struct sm2_mmap mmap;
 };
 
@@ -268,6 +273,8 @@ struct sm2_ep {
 	struct fid_ep *srx;
 	struct ofi_bufpool *xfer_ctx_pool;
 	int ep_idx;
+	int wake_fd;
+	bool wake_bound;
 };
 
 static inline struct fid_peer_srx *sm2_get_peer_srx(struct sm2_ep *ep)
@@ -283,6 +290,7 @@ int sm2_srx_context(struct fid_domain *domain, struct fi_rx_attr *attr,
 
 int sm2_endpoint(struct fid_domain *domain, struct fi_info *info,
 		 struct fid_ep **ep, void *context);
+void sm2_ep_wake_drain(struct sm2_ep *ep);
 int sm2_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		struct fid_cq **cq_fid, void *context);
 int sm2_cntr_open(struct fid_domain *domain, struct fi_cntr_attr *attr,
@@ -322,7 +330,7 @@ int sm2_unexp_start(struct fi_peer_rx_entry *rx_entry);
 
 static inline struct sm2_region *sm2_peer_region(struct sm2_ep *ep, int id)
 {
-	assert(id < SM2_MAX_UNIVERSE_SIZE);
+	assert(id < sm2_mmap_universe_size(ep->mmap));
 	return sm2_mmap_ep_region(ep->mmap, id);
 }
 
@@ -47,6 +47,7 @@ static int sm2_av_close(struct fid *fid)
 		return ret;
 
 	sm2_mmap_cleanup(&sm2_av->mmap);
+	free(sm2_av->reverse_lookup);
 	free(av);
 	return 0;
 }
@@ -142,7 +143,7 @@ static int sm2_av_remove(struct fid_av *av_fid, fi_addr_t *fi_addr,
 	ofi_genlock_lock(&util_av->lock);
 	for (i = 0; i < count; i++) {
 		gid = *((sm2_gid_t *) ofi_av_get_addr(util_av, fi_addr[i]));
-		if (gid > 0 && gid < SM2_MAX_UNIVERSE_SIZE)
+		if (gid > 0 && gid < sm2_mmap_universe_size(&sm2_av->mmap))
 			sm2_av->reverse_lookup[gid] = FI_ADDR_NOTAVAIL;
 
 		ret = ofi_av_remove_addr(util_av, fi_addr[i]);
@@ -175,7 +176,7 @@ static int sm2_av_lookup(struct fid_av *av, fi_addr_t fi_addr, void *addr,
 	gid = *((sm2_gid_t *) ofi_av_get_addr(util_av, fi_addr));
 	ofi_genlock_unlock(&util_av->lock);
 
-	if (gid >= SM2_MAX_UNIVERSE_SIZE) {
+	if (gid >= sm2_mmap_universe_size(&sm2_av->mmap)) {
 		FI_WARN(&sm2_prov, FI_LOG_EP_DATA,
 			"Looking up fi_addr %" PRIu64
 			" which does not exist in map\n",
@@ -229,7 +230,7 @@ int sm2_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	struct util_domain *util_domain;
 	struct util_av_attr util_attr;
 	struct sm2_av *sm2_av;
-	int ret, i;
+	int ret, i, universe_size;
 
 	if (!attr) {
 		FI_INFO(&sm2_prov, FI_LOG_AV, "invalid attr\n");
@@ -253,12 +254,6 @@ int sm2_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	util_attr.addrlen = sizeof(sm2_gid_t);
 	util_attr.context_len = 0;
 	util_attr.flags = 0;
-	if (attr->count > SM2_MAX_UNIVERSE_SIZE) {
-		FI_INFO(&sm2_prov, FI_LOG_AV, "count %d exceeds max peers\n",
-			(int) attr->count);
-		free(sm2_av);
-		return -FI_ENOSYS;
-	}
 
 	ret = ofi_av_init(util_domain, attr, &util_attr, &sm2_av->util_av,
 			  context);
@@ -269,15 +264,32 @@ int sm2_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 	if (ret)
 		goto out;
 
+	universe_size = sm2_mmap_universe_size(&sm2_av->mmap);
+	if (attr->count > universe_size) {
+		FI_INFO(&sm2_prov, FI_LOG_AV, "count %d exceeds max peers\n",
+			(int) attr->count);
+		ret = -FI_ENOSYS;
+		goto unmap;
+	}
+
+	sm2_av->reverse_lookup = calloc(universe_size,
+					sizeof(*sm2_av->reverse_lookup));
+	if (!sm2_av->reverse_lookup) {
+		ret = -FI_ENOMEM;
+		goto unmap;
+	}
+
 	*av = &sm2_av->util_av.av_fid;
 	(*av)->fid.ops = &sm2_av_fi_ops;
 	(*av)->ops = &sm2_av_ops;
 
 	/* Initialize all addresses to FI_ADDR_NOTAVAIL */
-	for (i = 0; i < SM2_MAX_UNIVERSE_SIZE; i++)
+	for (i = 0; i < universe_size; i++)
 		sm2_av->reverse_lookup[i] = FI_ADDR_NOTAVAIL;
 
 	return 0;
+unmap:
+	sm2_mmap_cleanup(&sm2_av->mmap);
 out:
 	(void) ofi_av_close(&sm2_av->util_av);
 	free(sm2_av);
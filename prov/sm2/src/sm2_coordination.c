@@ -43,7 +43,6 @@
 
 #define NEXT_MULTIPLE_OF(x, mod) x % mod ? ((x / mod) + 1) * mod : x
 #define ZOMBIE_ALLOCATION_NAME	 "ZOMBIE"
-#define SM2_COORDINATION_DIR	 "/dev/shm"
 #define SM2_COORDINATION_FILE	 SM2_COORDINATION_DIR "/fi_sm2_mmaps"
 #define SM2_STARTUP_MAX_TRIES	 1000
 
@@ -234,9 +233,10 @@ ssize_t sm2_file_open_or_create(struct sm2_mmap *map_shared)
 
 	header->file_version = SM2_VERSION;
 	header->ep_region_size = sm2_calculate_size_offsets(NULL, NULL);
+	header->universe_size = (int) sm2_env.universe_size;
 	header->ep_allocation_offset = sizeof(*header);
 	header->ep_regions_offset = header->ep_allocation_offset +
-				    (SM2_MAX_UNIVERSE_SIZE * sizeof(*entries));
+				    (header->universe_size * sizeof(*entries));
 	header->ep_regions_offset =
 		NEXT_MULTIPLE_OF(header->ep_regions_offset, page_size);
 
@@ -250,7 +250,7 @@ ssize_t sm2_file_open_or_create(struct sm2_mmap *map_shared)
 
 	header = (struct sm2_coord_file_header *) map_ours.base;
 	entries = sm2_mmap_entries(&map_ours);
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++)
+	for (item = 0; item < header->universe_size; item++)
 		entries[item].pid = 0;
 
 	/* Make sure the header is written before we link the file,
@@ -319,7 +319,7 @@ ssize_t sm2_file_open_or_create(struct sm2_mmap *map_shared)
 	 */
 	header = (struct sm2_coord_file_header *) map_shared->base;
 	max_file_size = header->ep_regions_offset +
-			header->ep_region_size * SM2_MAX_UNIVERSE_SIZE;
+			header->ep_region_size * header->universe_size;
 	err = sm2_mmap_remap(map_shared, max_file_size);
 
 	/* File we created either became the shared file, or got unlinked */
@@ -422,7 +422,7 @@ retry_lookup:
 	}
 
 	/* fine, we could not find the entry, so now look for an empty slot */
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
+	for (item = 0; item < sm2_mmap_universe_size(map); item++) {
 		peer_pid = entries[item].pid;
 		if (peer_pid == 0)
 			goto found;
@@ -451,7 +451,7 @@ retry_lookup:
 	FI_WARN(&sm2_prov, FI_LOG_AV,
 		"No available entries were found in the coordination file, all "
 		"%d were used\n",
-		SM2_MAX_UNIVERSE_SIZE);
+		sm2_mmap_universe_size(map));
 	return -FI_EAVAIL;
 
 found:
@@ -486,7 +486,7 @@ int sm2_entry_lookup(const char *name, struct sm2_mmap *map)
 
 	entries = sm2_mmap_entries(map);
 	/* TODO Optimize this lookup*/
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
+	for (item = 0; item < sm2_mmap_universe_size(map); item++) {
 		if (0 == strncmp(name, entries[item].ep_name, OFI_NAME_MAX)) {
 			FI_DBG(&sm2_prov, FI_LOG_AV,
 			       "Found existing %s in slot %d\n", name, item);
@@ -592,7 +592,7 @@ static void sm2_file_attempt_shrink(struct sm2_mmap *map)
 	struct sm2_ep_allocation_entry *entries = sm2_mmap_entries(map);
 	int item;
 
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
+	for (item = 0; item < header->universe_size; item++) {
 		if (entries[item].pid != 0 &&
 		    pid_lives(abs(entries[item].pid))) {
 			FI_INFO(&sm2_prov, FI_LOG_AV,
@@ -602,6 +602,6 @@ static void sm2_file_attempt_shrink(struct sm2_mmap *map)
 		}
 	}
 
-	memset(entries, 0, sizeof(*entries) * SM2_MAX_UNIVERSE_SIZE);
+	memset(entries, 0, sizeof(*entries) * header->universe_size);
 	sm2_mmap_shrink_to_size(map, header->ep_regions_offset);
 }
@@ -48,8 +48,14 @@
 
 #include <rdma/providers/fi_prov.h>
 
+#define SM2_COORDINATION_DIR "/dev/shm"
+
 #define SM2_XFER_ENTRY_SIZE   4096
-#define SM2_MAX_UNIVERSE_SIZE 256
+/* The universe size is fixed by the process that creates the coordination
+ * file.  The maximum bounds the upfront size of the file.
+ */
+#define SM2_DEFAULT_UNIVERSE_SIZE 256
+#define SM2_MAX_UNIVERSE_SIZE	  4096
 /* TODO: Tune max GDRCopy size for SM2 */
 #define SM2_MAX_GDRCOPY_SIZE 3072
 /* TODO: Make the number of XFER ENTRY's configurable */
@@ -74,6 +80,7 @@ struct sm2_coord_file_header {
 	pthread_mutex_t write_lock;
 	/* TODO enforce that all procs in the file use this */
 	int64_t ep_region_size;
+	int universe_size;
 
 	ptrdiff_t ep_allocation_offset; /* struct sm2_ep_allocation_entry */
 	ptrdiff_t ep_regions_offset; /* struct ep_region */
@@ -92,6 +99,9 @@ struct sm2_region {
 	/* offsets from start of sm2_region */
 	ptrdiff_t recv_queue_offset;
 	ptrdiff_t freestack_offset;
+
+	/* set by an idle owner blocked on its wake socket, see sm2_signal() */
+	ofi_atomic32_t sleeping;
 };
 
 size_t sm2_calculate_size_offsets(ptrdiff_t *rq_offset, ptrdiff_t *fs_offset);
@@ -100,6 +110,10 @@ int sm2_create(const struct fi_provider *prov, const struct sm2_attr *attr,
 
 ssize_t sm2_mmap_cleanup(struct sm2_mmap *map);
 
+socklen_t sm2_wake_addr(struct sm2_mmap *map, sm2_gid_t gid,
+			struct sockaddr_un *addr);
+void sm2_wake(struct sm2_mmap *map, sm2_gid_t gid);
+
 ssize_t sm2_entry_allocate(const char *name, struct sm2_mmap *map,
 			   sm2_gid_t *gid, bool self);
 void sm2_entry_free(struct sm2_mmap *map, sm2_gid_t gid);
@@ -116,6 +130,12 @@ sm2_mmap_entries(struct sm2_mmap *map)
 	return (struct sm2_ep_allocation_entry *) alloc_offset;
 }
 
+static inline int sm2_mmap_universe_size(struct sm2_mmap *map)
+{
+	struct sm2_coord_file_header *header = (void *) map->base;
+	return header->universe_size;
+}
+
 static inline struct sm2_region *sm2_mmap_ep_region(struct sm2_mmap *map,
 						    sm2_gid_t gid)
 {
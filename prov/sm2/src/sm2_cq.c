@@ -48,6 +48,7 @@ int sm2_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		/* fall through */
 	case FI_WAIT_NONE:
 	case FI_WAIT_YIELD:
+	case FI_WAIT_FD:
 		break;
 	default:
 		FI_INFO(&sm2_prov, FI_LOG_CQ, "CQ wait not yet supported\n");
@@ -167,7 +167,7 @@ ssize_t sm2_verify_peer(struct sm2_ep *ep, fi_addr_t fi_addr, sm2_gid_t *gid)
 	struct sm2_ep_allocation_entry *entries;
 
 	*gid = *((sm2_gid_t *) ofi_av_get_addr(ep->util_ep.av, fi_addr));
-	assert(*gid < SM2_MAX_UNIVERSE_SIZE);
+	assert(*gid < sm2_mmap_universe_size(ep->mmap));
 
 	sm2_av = container_of(ep->util_ep.av, struct sm2_av, util_av);
 	if (sm2_av->reverse_lookup[*gid] == FI_ADDR_NOTAVAIL)
@@ -305,6 +305,208 @@ static ssize_t sm2_do_ipc(struct sm2_ep *ep, struct sm2_region *peer_smr,
 	return FI_SUCCESS;
 }
 
+static ssize_t sm2_ep_wake_flush(struct sm2_ep *ep)
+{
+	ssize_t ret, cnt = 0;
+	char buf[64];
+
+	while ((ret = recv(ep->wake_fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+		cnt += ret;
+
+	return cnt;
+}
+
+/*
+ * Called from progress while the sleeping flag is set.  The flag is only
+ * cleared once a peer has actually woken us, since progress also runs from
+ * inside the wait itself before it blocks.
+ */
+void sm2_ep_wake_drain(struct sm2_ep *ep)
+{
+	if (!sm2_ep_wake_flush(ep))
+		return;
+
+	ofi_atomic_store_explicit32(&ep->self_region->sleeping, 0,
+				    memory_order_relaxed);
+}
+
+/*
+ * Every transfer, including returned xfer entries, arrives through the
+ * fifo, so an endpoint may sleep whenever its fifo is empty.
+ */
+static int sm2_ep_trywait(void *arg)
+{
+	struct sm2_ep *ep;
+
+	ep = container_of(arg, struct sm2_ep, util_ep.ep_fid.fid);
+
+	sm2_ep_progress(&ep->util_ep);
+
+	if (ep->wake_fd < 0 || !ep->self_region)
+		return FI_SUCCESS;
+
+	/* Anything left on the socket predates the flag and would let the
+	 * progress call made by the poll below clear it */
+	sm2_ep_wake_flush(ep);
+	ofi_atomic_store_explicit32(&ep->self_region->sleeping, 1,
+				    memory_order_relaxed);
+	ofi_mb();
+	if (!sm2_fifo_empty(sm2_recv_queue(ep->self_region))) {
+		ofi_atomic_store_explicit32(&ep->self_region->sleeping, 0,
+					    memory_order_relaxed);
+		return -FI_EAGAIN;
+	}
+
+	return FI_SUCCESS;
+}
+
+/* The socket is bound to its gid specific name once the ep is enabled */
+static int sm2_ep_wake_open(struct sm2_ep *ep, struct util_wait *wait)
+{
+	if (ep->wake_fd >= 0 || (wait->wait_obj != FI_WAIT_FD &&
+				 wait->wait_obj != FI_WAIT_POLLFD))
+		return FI_SUCCESS;
+
+	if (ep->self_region) {
+		FI_WARN(&sm2_prov, FI_LOG_EP_CTRL,
+			"fd wait objects must be bound before enabling ep\n");
+		return -FI_EOPBADSTATE;
+	}
+
+	ep->wake_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (ep->wake_fd < 0) {
+		FI_WARN(&sm2_prov, FI_LOG_EP_CTRL,
+			"unable to create wake socket: %s\n", strerror(errno));
+		return -ofi_syserr();
+	}
+
+	return FI_SUCCESS;
+}
+
+/* A socket left with our name can only belong to a dead process with our pid */
+static int sm2_ep_wake_bind(struct sm2_ep *ep)
+{
+	struct sockaddr_un addr;
+	socklen_t len;
+
+	len = sm2_wake_addr(ep->mmap, ep->gid, &addr);
+	(void) unlink(addr.sun_path);
+	if (bind(ep->wake_fd, (struct sockaddr *) &addr, len)) {
+		FI_WARN(&sm2_prov, FI_LOG_EP_CTRL,
+			"unable to bind wake socket %s: %s\n", addr.sun_path,
+			strerror(errno));
+		return -ofi_syserr();
+	}
+
+	ep->wake_bound = true;
+	return FI_SUCCESS;
+}
+
+static void sm2_ep_wake_close(struct sm2_ep *ep)
+{
+	struct sockaddr_un addr;
+
+	if (ep->wake_bound) {
+		(void) sm2_wake_addr(ep->mmap, ep->gid, &addr);
+		unlink(addr.sun_path);
+	}
+
+	if (ep->wake_fd >= 0)
+		close(ep->wake_fd);
+}
+
+/* Each wait object gets the ep added once, however many times it is bound */
+static bool sm2_ep_has_wait(struct sm2_ep *ep, struct util_wait *wait)
+{
+	int i;
+
+	if ((ep->util_ep.tx_cq && ep->util_ep.tx_cq->wait == wait) ||
+	    (ep->util_ep.rx_cq && ep->util_ep.rx_cq->wait == wait))
+		return true;
+
+	for (i = 0; i < CNTR_CNT; i++) {
+		if (ep->util_ep.cntrs[i] && ep->util_ep.cntrs[i]->wait == wait)
+			return true;
+	}
+	return false;
+}
+
+static void sm2_ep_del_waits(struct sm2_ep *ep)
+{
+	struct util_wait *waits[CNTR_CNT + 2];
+	int i, j, cnt = 0;
+
+	if (ep->util_ep.tx_cq)
+		waits[cnt++] = ep->util_ep.tx_cq->wait;
+	if (ep->util_ep.rx_cq)
+		waits[cnt++] = ep->util_ep.rx_cq->wait;
+	for (i = 0; i < CNTR_CNT; i++) {
+		if (ep->util_ep.cntrs[i])
+			waits[cnt++] = ep->util_ep.cntrs[i]->wait;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (!waits[i])
+			continue;
+		for (j = 0; j < i && waits[j] != waits[i]; j++)
+			;
+		if (j == i)
+			(void) ofi_wait_del_fid(waits[i],
+						&ep->util_ep.ep_fid.fid);
+	}
+}
+
+static int sm2_ep_add_wait(struct sm2_ep *ep, struct util_wait *wait)
+{
+	int ret;
+
+	ret = sm2_ep_wake_open(ep, wait);
+	if (ret)
+		return ret;
+
+	return ofi_wait_add_fid(wait, &ep->util_ep.ep_fid.fid, POLLIN,
+				sm2_ep_trywait);
+}
+
+static int sm2_ep_bind_cq(struct sm2_ep *ep, struct util_cq *cq, uint64_t flags)
+{
+	bool added;
+	int ret;
+
+	added = cq->wait && sm2_ep_has_wait(ep, cq->wait);
+	if (cq->wait && !added) {
+		ret = sm2_ep_add_wait(ep, cq->wait);
+		if (ret)
+			return ret;
+	}
+
+	ret = ofi_ep_bind_cq(&ep->util_ep, cq, flags);
+	if (ret && cq->wait && !added)
+		(void) ofi_wait_del_fid(cq->wait, &ep->util_ep.ep_fid.fid);
+
+	return ret;
+}
+
+static int sm2_ep_bind_cntr(struct sm2_ep *ep, struct util_cntr *cntr,
+			    uint64_t flags)
+{
+	bool added;
+	int ret;
+
+	added = cntr->wait && sm2_ep_has_wait(ep, cntr->wait);
+	if (cntr->wait && !added) {
+		ret = sm2_ep_add_wait(ep, cntr->wait);
+		if (ret)
+			return ret;
+	}
+
+	ret = ofi_ep_bind_cntr(&ep->util_ep, cntr, flags);
+	if (ret && cntr->wait && !added)
+		(void) ofi_wait_del_fid(cntr->wait, &ep->util_ep.ep_fid.fid);
+
+	return ret;
+}
+
 static void cleanup_shm_resources(struct sm2_ep *ep)
 {
 	struct sm2_xfer_entry *xfer_entry;
@@ -356,7 +558,9 @@ static int sm2_ep_close(struct fid *fid)
 	if (ep->srx && ep->util_ep.ep_fid.msg != &sm2_no_recv_msg_ops)
 		(void) util_srx_close(&ep->srx->fid);
 
+	sm2_ep_del_waits(ep);
 	ofi_endpoint_close(&ep->util_ep);
+	sm2_ep_wake_close(ep);
 
 	/* Set our PID to 0 in the regions map if our free queue entry stack is
 	 * full This will allow other entries re-use us or shrink file.
@@ -377,54 +581,6 @@ static int sm2_ep_close(struct fid *fid)
 	return 0;
 }
 
-static int sm2_ep_trywait(void *arg)
-{
-	struct sm2_ep *ep;
-
-	ep = container_of(arg, struct sm2_ep, util_ep.ep_fid.fid);
-
-	sm2_ep_progress(&ep->util_ep);
-
-	return FI_SUCCESS;
-}
-
-static int sm2_ep_bind_cq(struct sm2_ep *ep, struct util_cq *cq, uint64_t flags)
-{
-	int ret;
-
-	ret = ofi_ep_bind_cq(&ep->util_ep, cq, flags);
-	if (ret)
-		return ret;
-
-	if (cq->wait) {
-		ret = ofi_wait_add_fid(cq->wait, &ep->util_ep.ep_fid.fid, 0,
-				       sm2_ep_trywait);
-		if (ret)
-			return ret;
-	}
-
-	return ret;
-}
-
-static int sm2_ep_bind_cntr(struct sm2_ep *ep, struct util_cntr *cntr,
-			    uint64_t flags)
-{
-	int ret;
-
-	ret = ofi_ep_bind_cntr(&ep->util_ep, cntr, flags);
-	if (ret)
-		return ret;
-
-	if (cntr->wait) {
-		ret = ofi_wait_add_fid(cntr->wait, &ep->util_ep.ep_fid.fid, 0,
-				       sm2_ep_trywait);
-		if (ret)
-			return ret;
-	}
-
-	return FI_SUCCESS;
-}
-
 static int sm2_ep_bind(struct fid *ep_fid, struct fid *bfid, uint64_t flags)
 {
 	struct sm2_ep *ep;
@@ -515,7 +671,7 @@ static int sm2_ep_ctrl(struct fid *fid, int command, void *arg)
 	struct sm2_ep *ep;
 	struct sm2_av *av;
 	struct fid_peer_srx *srx;
-	int ret;
+	int ret = 0;
 	sm2_gid_t self_gid;
 
 	ep = container_of(fid, struct sm2_ep, util_ep.ep_fid.fid);
@@ -540,6 +696,12 @@ static int sm2_ep_ctrl(struct fid *fid, int command, void *arg)
 		if (ret)
 			return ret;
 
+		if (ep->wake_fd >= 0) {
+			ret = sm2_ep_wake_bind(ep);
+			if (ret)
+				return ret;
+		}
+
 		if (!ep->srx) {
 			domain = container_of(ep->util_ep.domain,
 					      struct sm2_domain,
@@ -569,6 +731,16 @@ static int sm2_ep_ctrl(struct fid *fid, int command, void *arg)
 			ep->util_ep.ep_fid.tagged = &sm2_no_recv_tag_ops;
 		}
 
+		break;
+	case FI_GETWAITOBJ:
+		if (ep->wake_fd < 0)
+			return -FI_ENODATA;
+		*(enum fi_wait_obj *) arg = FI_WAIT_FD;
+		break;
+	case FI_GETWAIT:
+		if (ep->wake_fd < 0)
+			return -FI_ENODATA;
+		*(int *) arg = ep->wake_fd;
 		break;
 	default:
 		return -FI_ENOSYS;
@@ -645,6 +817,7 @@ int sm2_endpoint(struct fid_domain *domain, struct fi_info *info,
 		goto close;
 	}
 
+	ep->wake_fd = -1;
 	ep->util_ep.ep_fid.fid.ops = &sm2_ep_fi_ops;
 	ep->util_ep.ep_fid.ops = &sm2_ep_ops;
 	ep->util_ep.ep_fid.cm = &sm2_cm_ops;
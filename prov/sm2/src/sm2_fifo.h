@@ -135,6 +135,7 @@
 
 #include "sm2.h"
 #include "sm2_atom.h"
+#include <ofi_mb.h>
 #include <stdint.h>
 
 #define SM2_FIFO_FREE (-3)
@@ -161,6 +162,21 @@ static inline void sm2_fifo_init(struct sm2_fifo *fifo)
 	fifo->tail = SM2_FIFO_FREE;
 }
 
+/* Same protocol as smr_signal() in the shm provider, after an enqueue */
+static inline void sm2_signal(struct sm2_mmap *map, sm2_gid_t gid,
+			      struct sm2_region *region)
+{
+	ofi_mb();
+	if (ofi_atomic_load_explicit32(&region->sleeping, memory_order_relaxed))
+		sm2_wake(map, gid);
+}
+
+/* Empty once every enqueue has linked itself in, see sm2_fifo_write() */
+static inline bool sm2_fifo_empty(struct sm2_fifo *fifo)
+{
+	return fifo->head == SM2_FIFO_FREE && fifo->tail == SM2_FIFO_FREE;
+}
+
 /* Write, Enqueue */
 static inline void sm2_fifo_write(struct sm2_ep *ep, sm2_gid_t peer_gid,
 				  struct sm2_xfer_entry *xfer_entry)
@@ -191,6 +207,7 @@ static inline void sm2_fifo_write(struct sm2_ep *ep, sm2_gid_t peer_gid,
 	}
 
 	atomic_wmb();
+	sm2_signal(ep->mmap, peer_gid, peer_region);
 }
 
 /* Read, Dequeue */
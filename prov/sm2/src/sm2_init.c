@@ -38,6 +38,41 @@
 #include <ofi_hmem.h>
 #include <ofi_prov.h>
 
+/* unbound datagram socket used to wake sleeping peers, see sm2_signal() */
+static int sm2_wake_sock = -1;
+
+/*
+ * Wake sockets are bound next to the coordination file, so every peer that
+ * can map it can reach them whatever network namespace it runs in.  The
+ * owner's pid keeps a recycled gid from being woken by stale peers.
+ */
+socklen_t sm2_wake_addr(struct sm2_mmap *map, sm2_gid_t gid,
+			struct sockaddr_un *addr)
+{
+	int len;
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	len = snprintf(addr->sun_path, sizeof(addr->sun_path),
+		       SM2_COORDINATION_DIR "/fi_sm2_wake_%d_%u",
+		       sm2_mmap_entries(map)[gid].pid, gid);
+
+	return (socklen_t) (offsetof(struct sockaddr_un, sun_path) + len + 1);
+}
+
+void sm2_wake(struct sm2_mmap *map, sm2_gid_t gid)
+{
+	struct sockaddr_un addr;
+	socklen_t len;
+	char byte = 0;
+
+	assert(sm2_wake_sock >= 0);
+	/* A full socket buffer already means the owner has a wakeup pending */
+	len = sm2_wake_addr(map, gid, &addr);
+	(void) sendto(sm2_wake_sock, &byte, sizeof(byte), MSG_DONTWAIT,
+		      (struct sockaddr *) &addr, len);
+}
+
 size_t sm2_calculate_size_offsets(ptrdiff_t *rq_offset, ptrdiff_t *fs_offset)
 {
 	size_t total_size;
@@ -69,6 +104,19 @@ int sm2_create(const struct fi_provider *prov, const struct sm2_attr *attr,
 	FI_INFO(prov, FI_LOG_EP_CTRL, "Claiming an entry for (%s)\n",
 		attr->name);
 	sm2_file_lock(sm2_mmap);
+
+	/* Without it this process could never wake a sleeping peer */
+	if (sm2_wake_sock < 0) {
+		sm2_wake_sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (sm2_wake_sock < 0) {
+			FI_WARN(prov, FI_LOG_EP_CTRL,
+				"unable to create wake socket: %s\n",
+				strerror(errno));
+			ret = -ofi_syserr();
+			goto remove;
+		}
+	}
+
 	ret = sm2_entry_allocate(attr->name, sm2_mmap, gid, true);
 
 	if (ret) {
@@ -93,6 +141,7 @@ int sm2_create(const struct fi_provider *prov, const struct sm2_attr *attr,
 	smr->flags = attr->flags;
 	smr->recv_queue_offset = recv_queue_offset;
 	smr->freestack_offset = freestack_offset;
+	ofi_atomic_initialize32(&smr->sleeping, 0);
 
 	sm2_fifo_init(sm2_recv_queue(smr));
 	smr_freestack_init(sm2_freestack(smr), SM2_NUM_XFER_ENTRY_PER_PEER,
@@ -233,7 +282,27 @@ static int sm2_getinfo(uint32_t version, const char *node, const char *service,
 
 static void sm2_fini(void)
 {
-	/* no-op */
+	if (sm2_wake_sock >= 0) {
+		close(sm2_wake_sock);
+		sm2_wake_sock = -1;
+	}
+}
+
+struct sm2_env sm2_env = {
+	.universe_size = SM2_DEFAULT_UNIVERSE_SIZE,
+};
+
+static void sm2_init_env(void)
+{
+	fi_param_get_size_t(&sm2_prov, "universe_size",
+			    &sm2_env.universe_size);
+	if (!sm2_env.universe_size ||
+	    sm2_env.universe_size > SM2_MAX_UNIVERSE_SIZE) {
+		FI_WARN(&sm2_prov, FI_LOG_CORE,
+			"Invalid universe_size %zu, using %d\n",
+			sm2_env.universe_size, SM2_DEFAULT_UNIVERSE_SIZE);
+		sm2_env.universe_size = SM2_DEFAULT_UNIVERSE_SIZE;
+	}
 }
 
 struct fi_provider sm2_prov = {
@@ -253,5 +322,11 @@ struct util_prov sm2_util_prov = {
 
 SM2_INI
 {
+	fi_param_define(&sm2_prov, "universe_size", FI_PARAM_SIZE_T,
+			"Number of endpoints the coordination file is sized "
+			"for.  Only used by the process that creates the file "
+			"(default: 256, max: 4096)");
+
+	sm2_init_env();
 	return &sm2_prov;
 }
@@ -808,6 +808,11 @@ void sm2_ep_progress(struct util_ep *util_ep)
 	struct sm2_ep *ep;
 
 	ep = container_of(util_ep, struct sm2_ep, util_ep);
+	if (ep->wake_fd >= 0 && ep->self_region &&
+	    ofi_atomic_load_explicit32(&ep->self_region->sleeping,
+				       memory_order_relaxed))
+		sm2_ep_wake_drain(ep);
+
 	ofi_genlock_lock(&ep->util_ep.lock);
 	sm2_progress_recv(ep);
 	ofi_genlock_unlock(&ep->util_ep.lock);
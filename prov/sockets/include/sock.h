@@ -87,6 +87,8 @@
 
 #define SOCK_PE_POLL_TIMEOUT (100000)
 #define SOCK_PE_MAX_ENTRIES (128)
+/* pe_entry_id on the wire is 16 bits and names the PE and its table slot */
+#define SOCK_PE_MAX_CNT (UINT16_MAX / SOCK_PE_MAX_ENTRIES + 1)
 #define SOCK_PE_WAITTIME (10)
 
 #define SOCK_EQ_DEF_SZ (1<<8)
@@ -195,11 +197,15 @@ struct sock_conn {
 struct sock_conn_map {
 	struct sock_conn *table;
 	ofi_epoll_t epoll_set;
-	struct ofi_epollfds_event *epoll_events;
-	int epoll_size;
 	int used;
 	int size;
 	ofi_mutex_t lock;
+
+	/* PEs that poll the connections of this map */
+	struct sock_pe **pe_list;
+	int pe_cnt;
+	/* serializes claims of conn->tx_pe_entry/rx_pe_entry across PEs */
+	ofi_spin_t claim_lock;
 };
 
 struct sock_conn_listener {
@@ -233,6 +239,10 @@ struct sock_domain {
 	enum fi_progress	progress_mode;
 	struct ofi_mr_map	mr_map;
 	struct sock_pe		*pe;
+	struct sock_pe		**pe_pool;
+	size_t			pe_cnt;
+	ofi_atomic32_t		pe_next;
+	ofi_mutex_t		atomic_lock;
 	struct dlist_entry	dom_list_entry;
 	struct fi_domain_attr	attr;
 	struct sock_conn_listener conn_listener;
@@ -643,6 +653,7 @@ struct sock_rx_ctx {
 	struct sock_av *av;
 	struct sock_eq *eq;
  	struct sock_domain *domain;
+	struct sock_pe *pe;
 
 	struct dlist_entry pe_entry;
 	struct dlist_entry cq_entry;
@@ -684,6 +695,7 @@ struct sock_tx_ctx {
 	struct sock_av *av;
 	struct sock_eq *eq;
  	struct sock_domain *domain;
+	struct sock_pe *pe;
 
 	struct dlist_entry pe_entry;
 	struct dlist_entry cq_entry;
@@ -842,6 +854,7 @@ struct sock_pe_entry {
 
 struct sock_pe {
 	struct sock_domain *domain;
+	int id;
 	int num_free_entries;
 	struct sock_pe_entry pe_table[SOCK_PE_MAX_ENTRIES];
 	ofi_mutex_t lock;
@@ -864,6 +877,8 @@ struct sock_pe {
 	volatile int do_progress;
 	struct sock_pe_entry *pe_atomic;
 	ofi_epoll_t epoll_set;
+	struct ofi_epollfds_event *conn_events;
+	int conn_events_size;
 };
 
 typedef ssize_t (*sock_cq_report_fn) (struct sock_cq *cq, fi_addr_t addr,
@@ -1007,6 +1022,7 @@ int sock_dom_check_list(struct sock_domain *domain);
 void sock_dom_remove_from_list(struct sock_domain *domain);
 struct sock_domain *sock_dom_list_head(void);
 int sock_dom_check_manual_progress(struct sock_fabric *fabric);
+struct sock_pe *sock_dom_select_pe(struct sock_domain *domain);
 int sock_query_atomic(struct fid_domain *domain,
 		      enum fi_datatype datatype, enum fi_op op,
 		      struct fi_atomic_attr *attr, uint64_t flags);
@@ -1135,6 +1151,7 @@ void sock_conn_release_entry(struct sock_conn_map *map, struct sock_conn *conn);
 void sock_set_sockopts(int sock, int sock_opts);
 int fd_set_nonblock(int fd);
 int sock_conn_map_init(struct sock_ep *ep, int init_size);
+void sock_conn_map_add_pe(struct sock_ep_attr *ep_attr, struct sock_pe *pe);
 
 struct sock_pe *sock_pe_init(struct sock_domain *domain);
 void sock_pe_add_tx_ctx(struct sock_pe *pe, struct sock_tx_ctx *ctx);
@@ -1143,8 +1160,8 @@ void sock_pe_signal(struct sock_pe *pe);
 void sock_pe_poll_add(struct sock_pe *pe, int fd);
 void sock_pe_poll_del(struct sock_pe *pe, int fd);
 
-int sock_pe_progress_ep_rx(struct sock_pe *pe, struct sock_ep_attr *ep_attr);
-int sock_pe_progress_ep_tx(struct sock_pe *pe, struct sock_ep_attr *ep_attr);
+int sock_pe_progress_ep_rx(struct sock_ep_attr *ep_attr);
+int sock_pe_progress_ep_tx(struct sock_ep_attr *ep_attr);
 int sock_pe_progress_rx_ctx(struct sock_pe *pe, struct sock_rx_ctx *rx_ctx);
 int sock_pe_progress_tx_ctx(struct sock_pe *pe, struct sock_tx_ctx *tx_ctx);
 void sock_pe_remove_tx_ctx(struct sock_tx_ctx *tx_ctx);
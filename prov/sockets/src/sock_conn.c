@@ -102,8 +102,8 @@ int sock_conn_map_init(struct sock_ep *ep, int init_size)
 	if (!map->table)
 		return -FI_ENOMEM;
 
-	map->epoll_events = calloc(init_size, sizeof(*map->epoll_events));
-	if (!map->epoll_events)
+	map->pe_list = calloc(ep->attr->domain->pe_cnt, sizeof(*map->pe_list));
+	if (!map->pe_list)
 		goto err1;
 
 	ret = ofi_epoll_create(&map->epoll_set);
@@ -115,13 +115,14 @@ int sock_conn_map_init(struct sock_ep *ep, int init_size)
 	}
 
 	ofi_mutex_init(&map->lock);
+	ofi_spin_init(&map->claim_lock);
 	map->used = 0;
 	map->size = init_size;
-	map->epoll_size = init_size;
+	map->pe_cnt = 0;
 	return 0;
 
 err2:
-	free(map->epoll_events);
+	free(map->pe_list);
 err1:
 	free(map->table);
 	return -FI_ENOMEM;
@@ -143,28 +144,69 @@ static int sock_conn_map_increase(struct sock_conn_map *map, int new_size)
 	return 0;
 }
 
+/*
+ * Every PE that progresses a context of the endpoint polls its connections,
+ * so that data for that context wakes the right progress thread.
+ */
+void sock_conn_map_add_pe(struct sock_ep_attr *ep_attr, struct sock_pe *pe)
+{
+	int i;
+	struct sock_conn_map *cmap = &ep_attr->cmap;
+
+	ofi_mutex_lock(&cmap->lock);
+	for (i = 0; i < cmap->pe_cnt; i++) {
+		if (cmap->pe_list[i] == pe)
+			goto out;
+	}
+
+	assert((size_t) cmap->pe_cnt < ep_attr->domain->pe_cnt);
+	cmap->pe_list[cmap->pe_cnt++] = pe;
+	for (i = 0; i < cmap->used; i++) {
+		if (cmap->table[i].sock_fd != -1)
+			sock_pe_poll_add(pe, cmap->table[i].sock_fd);
+	}
+out:
+	ofi_mutex_unlock(&cmap->lock);
+}
+
+static void sock_conn_map_poll_del(struct sock_conn_map *cmap, int fd)
+{
+	int i;
+
+	for (i = 0; i < cmap->pe_cnt; i++)
+		sock_pe_poll_del(cmap->pe_list[i], fd);
+}
+
+static void sock_conn_map_signal(struct sock_conn_map *cmap)
+{
+	int i;
+
+	for (i = 0; i < cmap->pe_cnt; i++)
+		sock_pe_signal(cmap->pe_list[i]);
+}
+
 void sock_conn_map_destroy(struct sock_ep_attr *ep_attr)
 {
 	int i;
 	struct sock_conn_map *cmap = &ep_attr->cmap;
 	for (i = 0; i < cmap->used; i++) {
-		if (cmap->table[i].sock_fd != -1) {
-			sock_pe_poll_del(ep_attr->domain->pe, cmap->table[i].sock_fd);
+		if (cmap->table[i].sock_fd != -1)
 			sock_conn_release_entry(cmap, &cmap->table[i]);
-		}
 	}
 	free(cmap->table);
 	cmap->table = NULL;
-	free(cmap->epoll_events);
-	cmap->epoll_events = NULL;
-	cmap->epoll_size = 0;
 	cmap->used = cmap->size = 0;
+	free(cmap->pe_list);
+	cmap->pe_list = NULL;
+	cmap->pe_cnt = 0;
 	ofi_epoll_close(cmap->epoll_set);
+	ofi_spin_destroy(&cmap->claim_lock);
 	ofi_mutex_destroy(&cmap->lock);
 }
 
 void sock_conn_release_entry(struct sock_conn_map *map, struct sock_conn *conn)
 {
+	sock_conn_map_poll_del(map, conn->sock_fd);
 	ofi_epoll_del(map->epoll_set, conn->sock_fd);
 	ofi_close_socket(conn->sock_fd);
 
@@ -188,7 +230,7 @@ static struct sock_conn *sock_conn_map_insert(struct sock_ep_attr *ep_attr,
 				union ofi_sock_ip *addr, int conn_fd,
 				int addr_published)
 {
-	int index;
+	int index, i;
 	struct sock_conn_map *map = &ep_attr->cmap;
 
 	if (map->size == map->used) {
@@ -217,7 +259,8 @@ static struct sock_conn *sock_conn_map_insert(struct sock_ep_attr *ep_attr,
 		SOCK_LOG_ERROR("failed to add to epoll set: %d\n", conn_fd);
 
 	map->table[index].address_published = addr_published;
-	sock_pe_poll_add(ep_attr->domain->pe, conn_fd);
+	for (i = 0; i < map->pe_cnt; i++)
+		sock_pe_poll_add(map->pe_list[i], conn_fd);
 	return &map->table[index];
 }
 
@@ -389,8 +432,8 @@ static void *sock_conn_listener_thread(void *arg)
 			ep_attr = container_of(conn_handle, struct sock_ep_attr, conn_handle);
 			ofi_mutex_lock(&ep_attr->cmap.lock);
 			sock_conn_map_insert(ep_attr, &remote, conn_fd, 1);
+			sock_conn_map_signal(&ep_attr->cmap);
 			ofi_mutex_unlock(&ep_attr->cmap.lock);
-			sock_pe_signal(ep_attr->domain->pe);
 		}
 skip:
 		ofi_mutex_unlock(&conn_listener->signal_lock);
@@ -47,6 +47,64 @@
 extern struct fi_ops_mr sock_dom_mr_ops;
 
 
+static void sock_dom_pe_pool_finalize(struct sock_domain *dom)
+{
+	size_t i;
+
+	for (i = 0; i < dom->pe_cnt; i++)
+		sock_pe_finalize(dom->pe_pool[i]);
+	free(dom->pe_pool);
+	dom->pe_pool = NULL;
+	dom->pe = NULL;
+	dom->pe_cnt = 0;
+}
+
+static int sock_dom_pe_pool_init(struct sock_domain *dom)
+{
+	size_t cnt;
+
+	/* Without a progress thread there is nothing to spread */
+	cnt = (dom->progress_mode == FI_PROGRESS_AUTO && sock_pe_cnt > 1) ?
+	      MIN(sock_pe_cnt, SOCK_PE_MAX_CNT) : 1;
+
+	dom->pe_pool = calloc(cnt, sizeof(*dom->pe_pool));
+	if (!dom->pe_pool)
+		return -FI_ENOMEM;
+
+	for (dom->pe_cnt = 0; dom->pe_cnt < cnt; dom->pe_cnt++) {
+		dom->pe_pool[dom->pe_cnt] = sock_pe_init(dom);
+		if (!dom->pe_pool[dom->pe_cnt])
+			goto err;
+		dom->pe_pool[dom->pe_cnt]->id = (int) dom->pe_cnt;
+	}
+
+	ofi_atomic_initialize32(&dom->pe_next, 0);
+	dom->pe = dom->pe_pool[0];
+	return 0;
+err:
+	sock_dom_pe_pool_finalize(dom);
+	return -FI_ENOMEM;
+}
+
+/*
+ * Contexts are assigned to progress engines round-robin: the tx/rx pair of
+ * a regular endpoint, each context of a scalable endpoint, and each shared
+ * context get their own pick. Contexts of one endpoint may therefore be
+ * progressed by different PEs over the endpoint's shared connections; see
+ * sock_pe_claim_conn() and sock_pe_owns_response() for how the byte streams
+ * and responses are kept apart.
+ */
+struct sock_pe *sock_dom_select_pe(struct sock_domain *domain)
+{
+	uint32_t idx;
+
+	if (domain->pe_cnt <= 1)
+		return domain->pe;
+
+	idx = (uint32_t) ofi_atomic_inc32(&domain->pe_next);
+	return domain->pe_pool[idx % domain->pe_cnt];
+}
+
 static int sock_dom_close(struct fid *fid)
 {
 	struct sock_domain *dom;
@@ -57,7 +115,8 @@ static int sock_dom_close(struct fid *fid)
 	sock_conn_stop_listener_thread(&dom->conn_listener);
 	sock_ep_cm_stop_thread(&dom->cm_head);
 
-	sock_pe_finalize(dom->pe);
+	sock_dom_pe_pool_finalize(dom);
+	ofi_mutex_destroy(&dom->atomic_lock);
 	ofi_mutex_destroy(&dom->lock);
 	ofi_mr_map_close(&dom->mr_map);
 	sock_dom_remove_from_list(dom);
@@ -161,6 +220,7 @@ int sock_domain(struct fid_fabric *fabric, struct fi_info *info,
 		return -FI_ENOMEM;
 
 	ofi_mutex_init(&sock_domain->lock);
+	ofi_mutex_init(&sock_domain->atomic_lock);
 	ofi_atomic_initialize32(&sock_domain->ref, 0);
 
 	sock_domain->info = *info;
@@ -177,8 +237,7 @@ int sock_domain(struct fid_fabric *fabric, struct fi_info *info,
 	else
 		sock_domain->progress_mode = info->domain_attr->data_progress;
 
-	sock_domain->pe = sock_pe_init(sock_domain);
-	if (!sock_domain->pe) {
+	if (sock_dom_pe_pool_init(sock_domain)) {
 		SOCK_LOG_ERROR("Failed to init PE\n");
 		goto err1;
 	}
@@ -207,8 +266,9 @@ int sock_domain(struct fid_fabric *fabric, struct fi_info *info,
 err3:
 	sock_conn_stop_listener_thread(&sock_domain->conn_listener);
 err2:
-	sock_pe_finalize(sock_domain->pe);
+	sock_dom_pe_pool_finalize(sock_domain);
 err1:
+	ofi_mutex_destroy(&sock_domain->atomic_lock);
 	ofi_mutex_destroy(&sock_domain->lock);
 	free(sock_domain);
 	return -FI_EINVAL;
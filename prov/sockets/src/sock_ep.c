@@ -263,7 +263,8 @@ static int sock_ctx_enable(struct fid_ep *ep)
 	switch (ep->fid.fclass) {
 	case FI_CLASS_RX_CTX:
 		rx_ctx = container_of(ep, struct sock_rx_ctx, ctx.fid);
-		sock_pe_add_rx_ctx(rx_ctx->domain->pe, rx_ctx);
+		sock_conn_map_add_pe(rx_ctx->ep_attr, rx_ctx->pe);
+		sock_pe_add_rx_ctx(rx_ctx->pe, rx_ctx);
 
 		if (!rx_ctx->ep_attr->conn_handle.do_listen &&
 		    sock_conn_listen(rx_ctx->ep_attr)) {
@@ -274,7 +275,8 @@ static int sock_ctx_enable(struct fid_ep *ep)
 
 	case FI_CLASS_TX_CTX:
 		tx_ctx = container_of(ep, struct sock_tx_ctx, fid.ctx.fid);
-		sock_pe_add_tx_ctx(tx_ctx->domain->pe, tx_ctx);
+		sock_conn_map_add_pe(tx_ctx->ep_attr, tx_ctx->pe);
+		sock_pe_add_tx_ctx(tx_ctx->pe, tx_ctx);
 
 		if (!tx_ctx->ep_attr->conn_handle.do_listen &&
 		    sock_conn_listen(tx_ctx->ep_attr)) {
@@ -621,6 +623,10 @@ static int sock_ep_close(struct fid *fid)
 {
 	struct sock_conn_req_handle *handle;
 	struct sock_ep *sock_ep;
+	struct sock_tx_ctx *tx_ctx;
+	struct sock_rx_ctx *rx_ctx;
+	struct sock_domain *dom;
+	size_t i;
 
 	switch (fid->fclass) {
 	case FI_CLASS_EP:
@@ -664,19 +670,26 @@ static int sock_ep_close(struct fid *fid)
 		ofi_mutex_unlock(&sock_ep->attr->av->list_lock);
 	}
 
-	pthread_mutex_lock(&sock_ep->attr->domain->pe->list_lock);
+	/* The shared context's PE walks its ep_list under that PE's lock */
 	if (sock_ep->attr->tx_shared) {
+		tx_ctx = sock_ep->attr->tx_ctx->stx_ctx ?
+			 sock_ep->attr->tx_ctx->stx_ctx : sock_ep->attr->tx_ctx;
+		ofi_mutex_lock(&tx_ctx->pe->lock);
 		ofi_mutex_lock(&sock_ep->attr->tx_ctx->lock);
 		dlist_remove(&sock_ep->attr->tx_ctx_entry);
 		ofi_mutex_unlock(&sock_ep->attr->tx_ctx->lock);
+		ofi_mutex_unlock(&tx_ctx->pe->lock);
 	}
 
 	if (sock_ep->attr->rx_shared) {
+		rx_ctx = sock_ep->attr->rx_ctx->srx_ctx ?
+			 sock_ep->attr->rx_ctx->srx_ctx : sock_ep->attr->rx_ctx;
+		ofi_mutex_lock(&rx_ctx->pe->lock);
 		ofi_mutex_lock(&sock_ep->attr->rx_ctx->lock);
 		dlist_remove(&sock_ep->attr->rx_ctx_entry);
 		ofi_mutex_unlock(&sock_ep->attr->rx_ctx->lock);
+		ofi_mutex_unlock(&rx_ctx->pe->lock);
 	}
-	pthread_mutex_unlock(&sock_ep->attr->domain->pe->list_lock);
 
 	if (sock_ep->attr->conn_handle.do_listen) {
 		ofi_mutex_lock(&sock_ep->attr->domain->conn_listener.signal_lock);
@@ -725,10 +738,14 @@ static int sock_ep_close(struct fid *fid)
 	if (sock_ep->attr->dest_addr)
 		free(sock_ep->attr->dest_addr);
 
-	ofi_mutex_lock(&sock_ep->attr->domain->pe->lock);
+	/* Connections may be in use by any PE; take them in pool order */
+	dom = sock_ep->attr->domain;
+	for (i = 0; i < dom->pe_cnt; i++)
+		ofi_mutex_lock(&dom->pe_pool[i]->lock);
 	ofi_idm_reset(&sock_ep->attr->av_idm, NULL);
 	sock_conn_map_destroy(sock_ep->attr);
-	ofi_mutex_unlock(&sock_ep->attr->domain->pe->lock);
+	for (i = dom->pe_cnt; i > 0; i--)
+		ofi_mutex_unlock(&dom->pe_pool[i - 1]->lock);
 
 	ofi_atomic_dec32(&sock_ep->attr->domain->ref);
 	ofi_mutex_destroy(&sock_ep->attr->lock);
@@ -988,11 +1005,15 @@ int sock_ep_enable(struct fid_ep *ep)
 			tx_ctx->enabled = 1;
 			if (tx_ctx->use_shared) {
 				if (tx_ctx->stx_ctx) {
-					sock_pe_add_tx_ctx(tx_ctx->domain->pe, tx_ctx->stx_ctx);
+					sock_conn_map_add_pe(sock_ep->attr,
+							     tx_ctx->stx_ctx->pe);
+					sock_pe_add_tx_ctx(tx_ctx->stx_ctx->pe,
+							   tx_ctx->stx_ctx);
 					tx_ctx->stx_ctx->enabled = 1;
 				}
 			} else {
-				sock_pe_add_tx_ctx(tx_ctx->domain->pe, tx_ctx);
+				sock_conn_map_add_pe(sock_ep->attr, tx_ctx->pe);
+				sock_pe_add_tx_ctx(tx_ctx->pe, tx_ctx);
 			}
 		}
 	}
@@ -1003,11 +1024,15 @@ int sock_ep_enable(struct fid_ep *ep)
 			rx_ctx->enabled = 1;
 			if (rx_ctx->use_shared) {
 				if (rx_ctx->srx_ctx) {
-					sock_pe_add_rx_ctx(rx_ctx->domain->pe, rx_ctx->srx_ctx);
+					sock_conn_map_add_pe(sock_ep->attr,
+							     rx_ctx->srx_ctx->pe);
+					sock_pe_add_rx_ctx(rx_ctx->srx_ctx->pe,
+							   rx_ctx->srx_ctx);
 					rx_ctx->srx_ctx->enabled = 1;
 				}
 			} else {
-				sock_pe_add_rx_ctx(rx_ctx->domain->pe, rx_ctx);
+				sock_conn_map_add_pe(sock_ep->attr, rx_ctx->pe);
+				sock_pe_add_rx_ctx(rx_ctx->pe, rx_ctx);
 			}
 		}
 	}
@@ -1140,8 +1165,11 @@ static int sock_ep_tx_ctx(struct fid_ep *ep, int index, struct fi_tx_attr *attr,
 	tx_ctx->tx_id = (uint16_t) index;
 	tx_ctx->ep_attr = sock_ep->attr;
 	tx_ctx->domain = sock_ep->attr->domain;
-	if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx)
+	tx_ctx->pe = sock_dom_select_pe(sock_ep->attr->domain);
+	if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx) {
 		tx_ctx->rx_ctrl_ctx->domain = sock_ep->attr->domain;
+		tx_ctx->rx_ctrl_ctx->pe = tx_ctx->pe;
+	}
 	tx_ctx->av = sock_ep->attr->av;
 	dlist_insert_tail(&sock_ep->attr->tx_ctx_entry, &tx_ctx->ep_list);
 
@@ -1186,6 +1214,7 @@ static int sock_ep_rx_ctx(struct fid_ep *ep, int index, struct fi_rx_attr *attr,
 	rx_ctx->rx_id = (uint16_t) index;
 	rx_ctx->ep_attr = sock_ep->attr;
 	rx_ctx->domain = sock_ep->attr->domain;
+	rx_ctx->pe = sock_dom_select_pe(sock_ep->attr->domain);
 	rx_ctx->av = sock_ep->attr->av;
 	dlist_insert_tail(&sock_ep->attr->rx_ctx_entry, &rx_ctx->ep_list);
 
@@ -1249,8 +1278,11 @@ int sock_stx_ctx(struct fid_domain *domain,
 		return -FI_ENOMEM;
 
 	tx_ctx->domain = dom;
-	if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx)
+	tx_ctx->pe = sock_dom_select_pe(dom);
+	if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx) {
 		tx_ctx->rx_ctrl_ctx->domain = dom;
+		tx_ctx->rx_ctrl_ctx->pe = tx_ctx->pe;
+	}
 
 	tx_ctx->fid.stx.fid.ops = &sock_ctx_ops;
 	tx_ctx->fid.stx.ops = &sock_ep_ops;
@@ -1292,6 +1324,7 @@ int sock_srx_ctx(struct fid_domain *domain,
 		return -FI_ENOMEM;
 
 	rx_ctx->domain = dom;
+	rx_ctx->pe = sock_dom_select_pe(dom);
 	rx_ctx->ctx.fid.fclass = FI_CLASS_SRX_CTX;
 
 	rx_ctx->ctx.fid.ops = &sock_ctx_ops;
@@ -1586,6 +1619,7 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 	struct sock_tx_ctx *tx_ctx;
 	struct sock_rx_ctx *rx_ctx;
 	struct sock_domain *sock_dom;
+	struct sock_pe *pe;
 
 	assert(info);
 	sock_dom = container_of(domain, struct sock_domain, dom_fid);
@@ -1710,6 +1744,9 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 	}
 
 	if (sock_ep->attr->fclass != FI_CLASS_SEP) {
+		/* the default tx/rx pair shares one PE */
+		pe = sock_dom_select_pe(sock_dom);
+
 		/* default tx ctx */
 		tx_ctx = sock_tx_ctx_alloc(&sock_ep->tx_attr, context,
 					   sock_ep->attr->tx_shared);
@@ -1719,8 +1756,11 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 		}
 		tx_ctx->ep_attr = sock_ep->attr;
 		tx_ctx->domain = sock_dom;
-		if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx)
+		tx_ctx->pe = pe;
+		if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx) {
 			tx_ctx->rx_ctrl_ctx->domain = sock_dom;
+			tx_ctx->rx_ctrl_ctx->pe = pe;
+		}
 		tx_ctx->tx_id = 0;
 		dlist_insert_tail(&sock_ep->attr->tx_ctx_entry, &tx_ctx->ep_list);
 		sock_ep->attr->tx_array[0] = tx_ctx;
@@ -1735,6 +1775,7 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 		}
 		rx_ctx->ep_attr = sock_ep->attr;
 		rx_ctx->domain = sock_dom;
+		rx_ctx->pe = pe;
 		rx_ctx->rx_id = 0;
 		dlist_insert_tail(&sock_ep->attr->rx_ctx_entry, &rx_ctx->ep_list);
 		sock_ep->attr->rx_array[0] = rx_ctx;
@@ -1773,7 +1814,6 @@ void sock_ep_remove_conn(struct sock_ep_attr *attr, struct sock_conn *conn)
 {
 	if (attr->cmap.used <= 0 || conn->sock_fd == -1)
 		return;
-	sock_pe_poll_del(attr->domain->pe, conn->sock_fd);
 	sock_conn_release_entry(&attr->cmap, conn);
 }
 
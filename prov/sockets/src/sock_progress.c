@@ -65,6 +65,9 @@
 #define SOCK_LOG_ERROR(...) _SOCK_LOG_ERROR(FI_LOG_EP_DATA, __VA_ARGS__)
 
 #define PE_INDEX(_pe, _e) (_e - &_pe->pe_table[0])
+/* pe_entry_id carried in requests and echoed back in responses */
+#define SOCK_PE_ENTRY_ID(_pe, _e) \
+	((uint16_t) ((_pe)->id * SOCK_PE_MAX_ENTRIES + PE_INDEX(_pe, _e)))
 #define SOCK_GET_RX_ID(_addr, _bits) (((_bits) == 0) ? 0 : \
 		(((uint64_t)_addr) >> (64 - _bits)))
 
@@ -87,6 +90,50 @@ static inline int sock_pe_is_data_msg(int msg_id)
 	}
 }
 
+static inline int sock_pe_is_response_msg(int msg_id)
+{
+	return !sock_pe_is_data_msg(msg_id) && msg_id != SOCK_OP_CONN_MSG;
+}
+
+/*
+ * Contexts of one endpoint may be progressed by different PEs, all of which
+ * share the endpoint's connections. A PE entry owns one direction of a
+ * connection's byte stream from the first byte of its frame to the last.
+ */
+static int sock_pe_claim_conn(struct sock_conn *conn,
+			      struct sock_pe_entry **owner,
+			      struct sock_pe_entry *pe_entry)
+{
+	int ret;
+
+	if (*owner == pe_entry)
+		return 1;
+
+	ofi_spin_lock(&conn->ep_attr->cmap.claim_lock);
+	ret = (*owner == NULL);
+	if (ret)
+		*owner = pe_entry;
+	ofi_spin_unlock(&conn->ep_attr->cmap.claim_lock);
+	return ret;
+}
+
+static void sock_pe_release_conn(struct sock_conn *conn,
+				 struct sock_pe_entry **owner,
+				 struct sock_pe_entry *pe_entry)
+{
+	ofi_spin_lock(&conn->ep_attr->cmap.claim_lock);
+	if (*owner == pe_entry)
+		*owner = NULL;
+	ofi_spin_unlock(&conn->ep_attr->cmap.claim_lock);
+}
+
+static struct sock_pe_entry *
+sock_pe_response_entry(struct sock_pe *pe, struct sock_msg_response *response)
+{
+	assert(response->pe_entry_id / SOCK_PE_MAX_ENTRIES == pe->id);
+	return &pe->pe_table[response->pe_entry_id % SOCK_PE_MAX_ENTRIES];
+}
+
 static inline ssize_t sock_pe_send_field(struct sock_pe_entry *pe_entry,
 					 void *field, size_t field_len,
 					 size_t start_offset)
@@ -140,7 +187,8 @@ static inline void sock_pe_discard_field(struct sock_pe_entry *pe_entry)
 
 	pe_entry->rem -= ret;
 	if (pe_entry->rem == 0)
-		pe_entry->conn->rx_pe_entry = NULL;
+		sock_pe_release_conn(pe_entry->conn,
+				     &pe_entry->conn->rx_pe_entry, pe_entry);
 
  out:
 	if (pe_entry->done_len == pe_entry->total_len && !pe_entry->rem) {
@@ -156,10 +204,10 @@ static void sock_pe_release_entry(struct sock_pe *pe,
 		ofi_rbempty(&pe_entry->comm_buf));
 	dlist_remove(&pe_entry->ctx_entry);
 
-	if (pe_entry->conn->tx_pe_entry == pe_entry)
-		pe_entry->conn->tx_pe_entry = NULL;
-	if (pe_entry->conn->rx_pe_entry == pe_entry)
-		pe_entry->conn->rx_pe_entry = NULL;
+	sock_pe_release_conn(pe_entry->conn, &pe_entry->conn->tx_pe_entry,
+			     pe_entry);
+	sock_pe_release_conn(pe_entry->conn, &pe_entry->conn->rx_pe_entry,
+			     pe_entry);
 
 	if (pe_entry->type == SOCK_PE_RX && pe_entry->pe.rx.atomic_cmp) {
 		ofi_buf_free(pe_entry->pe.rx.atomic_cmp);
@@ -470,17 +518,12 @@ static void sock_pe_progress_pending_ack(struct sock_pe *pe,
 	if (!conn || pe_entry->rem)
 		return;
 
-	if (conn->tx_pe_entry != NULL && conn->tx_pe_entry != pe_entry) {
+	if (!sock_pe_claim_conn(conn, &conn->tx_pe_entry, pe_entry)) {
 		SOCK_LOG_DBG("Cannot progress %p as conn %p is being used by %p\n",
 			      pe_entry, conn, conn->tx_pe_entry);
 		return;
 	}
 
-	if (conn->tx_pe_entry == NULL) {
-		SOCK_LOG_DBG("Connection %p grabbed by %p\n", conn, pe_entry);
-		conn->tx_pe_entry = pe_entry;
-	}
-
 	if (sock_pe_send_field(pe_entry, &pe_entry->response,
 			       sizeof(pe_entry->response), 0))
 		return;
@@ -519,7 +562,7 @@ static void sock_pe_progress_pending_ack(struct sock_pe *pe,
 			return;
 		pe_entry->is_complete = 1;
 		pe_entry->pe.rx.pending_send = 0;
-		pe_entry->conn->tx_pe_entry = NULL;
+		sock_pe_release_conn(conn, &conn->tx_pe_entry, pe_entry);
 	}
 }
 
@@ -545,7 +588,8 @@ static void sock_pe_send_response(struct sock_pe *pe,
 	pe_entry->done_len = 0;
 	pe_entry->pe.rx.pending_send = 1;
 	if (pe_entry->rem == 0)
-		pe_entry->conn->rx_pe_entry = NULL;
+		sock_pe_release_conn(pe_entry->conn,
+				     &pe_entry->conn->rx_pe_entry, pe_entry);
 	pe_entry->total_len = sizeof(*response) + data_len;
 
 	sock_pe_progress_pending_ack(pe, pe_entry);
@@ -580,8 +624,7 @@ static int sock_pe_handle_ack(struct sock_pe *pe,
 		return 0;
 
 	response = &pe_entry->response;
-	assert(response->pe_entry_id <= SOCK_PE_MAX_ENTRIES);
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
+	waiting_entry = sock_pe_response_entry(pe, response);
 	SOCK_LOG_DBG("Received ack for PE entry %p (index: %d)\n",
 		      waiting_entry, response->pe_entry_id);
 
@@ -602,8 +645,7 @@ static int sock_pe_handle_error(struct sock_pe *pe,
 		return 0;
 
 	response = &pe_entry->response;
-	assert(response->pe_entry_id <= SOCK_PE_MAX_ENTRIES);
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
+	waiting_entry = sock_pe_response_entry(pe, response);
 	SOCK_LOG_ERROR("Received error for PE entry %p (index: %d)\n",
 		      waiting_entry, response->pe_entry_id);
 
@@ -638,12 +680,10 @@ static int sock_pe_handle_read_complete(struct sock_pe *pe,
 		return 0;
 
 	response = &pe_entry->response;
-	assert(response->pe_entry_id <= SOCK_PE_MAX_ENTRIES);
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
+	waiting_entry = sock_pe_response_entry(pe, response);
 	SOCK_LOG_DBG("Received read complete for PE entry %p (index: %d)\n",
 		      waiting_entry, response->pe_entry_id);
 
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
 	assert(waiting_entry->type == SOCK_PE_TX);
 
 	len = sizeof(struct sock_msg_response);
@@ -672,8 +712,7 @@ static int sock_pe_handle_write_complete(struct sock_pe *pe,
 		return 0;
 
 	response = &pe_entry->response;
-	assert(response->pe_entry_id <= SOCK_PE_MAX_ENTRIES);
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
+	waiting_entry = sock_pe_response_entry(pe, response);
 	SOCK_LOG_DBG("Received ack for PE entry %p (index: %d)\n",
 		      waiting_entry, response->pe_entry_id);
 
@@ -696,12 +735,10 @@ static int sock_pe_handle_atomic_complete(struct sock_pe *pe,
 		return 0;
 
 	response = &pe_entry->response;
-	assert(response->pe_entry_id <= SOCK_PE_MAX_ENTRIES);
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
+	waiting_entry = sock_pe_response_entry(pe, response);
 	SOCK_LOG_DBG("Received atomic complete for PE entry %p (index: %d)\n",
 		      waiting_entry, response->pe_entry_id);
 
-	waiting_entry = &pe->pe_table[response->pe_entry_id];
 	assert(waiting_entry->type == SOCK_PE_TX);
 
 	len = sizeof(struct sock_msg_response);
@@ -980,7 +1017,10 @@ static int sock_pe_process_rx_atomic(struct sock_pe *pe,
 		pe->pe_atomic = pe_entry;
 	}
 
+	/* Contexts targeting the same memory may be on different PEs */
 	offset = 0;
+	if (rx_ctx->domain->pe_cnt > 1)
+		ofi_mutex_lock(&rx_ctx->domain->atomic_lock);
 	for (i = 0; i < pe_entry->pe.rx.rx_op.dest_iov_len; i++) {
 		sock_pe_do_atomic(pe_entry->pe.rx.atomic_cmp + offset,
 			(char *) (uintptr_t) pe_entry->pe.rx.rx_iov[i].ioc.addr,
@@ -991,6 +1031,8 @@ static int sock_pe_process_rx_atomic(struct sock_pe *pe,
 			pe_entry->pe.rx.rx_op.atomic.res_iov_len);
 		offset += datatype_sz * pe_entry->pe.rx.rx_iov[i].ioc.count;
 	}
+	if (rx_ctx->domain->pe_cnt > 1)
+		ofi_mutex_unlock(&rx_ctx->domain->atomic_lock);
 
 	pe_entry->buf = pe_entry->pe.rx.rx_iov[0].iov.addr;
 	pe_entry->data_len = offset;
@@ -1586,6 +1628,24 @@ out:
 	return ret;
 }
 
+/* Responses must be read by the PE whose pe_table holds the request */
+static int sock_pe_owns_response(struct sock_pe *pe,
+				 struct sock_pe_entry *pe_entry)
+{
+	struct sock_msg_response response;
+	ssize_t len;
+
+	if (pe->domain->pe_cnt == 1)
+		return 1;
+
+	len = offsetof(struct sock_msg_response, pe_entry_id) +
+	      sizeof(response.pe_entry_id);
+	if (sock_comm_peek(pe_entry->conn, &response, len) != len)
+		return 0;
+
+	return ntohs(response.pe_entry_id) / SOCK_PE_MAX_ENTRIES == pe->id;
+}
+
 static int sock_pe_peek_hdr(struct sock_pe *pe,
 			     struct sock_pe_entry *pe_entry)
 {
@@ -1593,13 +1653,9 @@ static int sock_pe_peek_hdr(struct sock_pe *pe,
 	struct sock_msg_hdr *msg_hdr;
 	struct sock_conn *conn = pe_entry->conn;
 
-	if (conn->rx_pe_entry != NULL && conn->rx_pe_entry != pe_entry)
+	if (!sock_pe_claim_conn(conn, &conn->rx_pe_entry, pe_entry))
 		return -1;
 
-	if (conn->rx_pe_entry == NULL) {
-		conn->rx_pe_entry = pe_entry;
-	}
-
 	len = sizeof(struct sock_msg_hdr);
 	msg_hdr = &pe_entry->msg_hdr;
 	if (sock_comm_peek(pe_entry->conn, (void *) msg_hdr, len) != len)
@@ -1621,12 +1677,9 @@ static int sock_pe_read_hdr(struct sock_pe *pe, struct sock_rx_ctx *rx_ctx,
 	struct sock_msg_hdr *msg_hdr;
 	struct sock_conn *conn = pe_entry->conn;
 
-	if (conn->rx_pe_entry != NULL && conn->rx_pe_entry != pe_entry)
+	if (!sock_pe_claim_conn(conn, &conn->rx_pe_entry, pe_entry))
 		return 0;
 
-	if (conn->rx_pe_entry == NULL)
-		conn->rx_pe_entry = pe_entry;
-
 	msg_hdr = &pe_entry->msg_hdr;
 	if (sock_pe_peek_hdr(pe, pe_entry))
 		return -1;
@@ -1638,6 +1691,10 @@ static int sock_pe_read_hdr(struct sock_pe *pe, struct sock_rx_ctx *rx_ctx,
 	    msg_hdr->rx_id != rx_ctx->rx_id)
 		return -1;
 
+	if (sock_pe_is_response_msg(msg_hdr->op_type) &&
+	    !sock_pe_owns_response(pe, pe_entry))
+		return -1;
+
 	if (sock_pe_recv_field(pe_entry, (void *) msg_hdr,
 			       sizeof(struct sock_msg_hdr), 0)) {
 		SOCK_LOG_ERROR("Failed to recv header\n");
@@ -1735,7 +1792,7 @@ static int sock_pe_progress_tx_atomic(struct sock_pe *pe,
 
 	if (pe_entry->done_len == pe_entry->total_len) {
 		pe_entry->pe.tx.send_done = 1;
-		pe_entry->conn->tx_pe_entry = NULL;
+		sock_pe_release_conn(conn, &conn->tx_pe_entry, pe_entry);
 		SOCK_LOG_DBG("Send complete\n");
 	}
 
@@ -1803,7 +1860,7 @@ static int sock_pe_progress_tx_write(struct sock_pe *pe,
 
 	if (pe_entry->done_len == pe_entry->total_len) {
 		pe_entry->pe.tx.send_done = 1;
-		pe_entry->conn->tx_pe_entry = NULL;
+		sock_pe_release_conn(conn, &conn->tx_pe_entry, pe_entry);
 		SOCK_LOG_DBG("Send complete\n");
 	}
 	pe_entry->flags |= (FI_RMA | FI_WRITE);
@@ -1843,7 +1900,7 @@ static int sock_pe_progress_tx_read(struct sock_pe *pe,
 
 	if (pe_entry->done_len == pe_entry->total_len) {
 		pe_entry->pe.tx.send_done = 1;
-		pe_entry->conn->tx_pe_entry = NULL;
+		sock_pe_release_conn(conn, &conn->tx_pe_entry, pe_entry);
 		SOCK_LOG_DBG("Send complete\n");
 	}
 	pe_entry->flags |= (FI_RMA | FI_READ);
@@ -1905,7 +1962,7 @@ static int sock_pe_progress_tx_send(struct sock_pe *pe,
 	pe_entry->msg_hdr.flags = pe_entry->flags;
 	if (pe_entry->done_len == pe_entry->total_len) {
 		pe_entry->pe.tx.send_done = 1;
-		pe_entry->conn->tx_pe_entry = NULL;
+		sock_pe_release_conn(conn, &conn->tx_pe_entry, pe_entry);
 		SOCK_LOG_DBG("Send complete\n");
 
 		if (pe_entry->flags & FI_INJECT_COMPLETE) {
@@ -1939,7 +1996,7 @@ static int sock_pe_progress_tx_conn_msg(struct sock_pe *pe,
 
 	if (pe_entry->done_len == pe_entry->total_len) {
 		pe_entry->pe.tx.send_done = 1;
-		pe_entry->conn->tx_pe_entry = NULL;
+		sock_pe_release_conn(conn, &conn->tx_pe_entry, pe_entry);
 		SOCK_LOG_DBG("Send complete\n");
 		pe_entry->is_complete = 1;
 	}
@@ -1973,17 +2030,12 @@ static int sock_pe_progress_tx_entry(struct sock_pe *pe,
 	if (pe_entry->pe.tx.send_done)
 		goto out;
 
-	if (conn->tx_pe_entry != NULL && conn->tx_pe_entry != pe_entry) {
+	if (!sock_pe_claim_conn(conn, &conn->tx_pe_entry, pe_entry)) {
 		SOCK_LOG_DBG("Cannot progress %p as conn %p is being used by %p\n",
 			      pe_entry, conn, conn->tx_pe_entry);
 		goto out;
 	}
 
-	if (conn->tx_pe_entry == NULL) {
-		SOCK_LOG_DBG("Connection %p grabbed by %p\n", conn, pe_entry);
-		conn->tx_pe_entry = pe_entry;
-	}
-
 	if ((pe_entry->flags & FI_FENCE) &&
 	    (tx_ctx->pe_entry_list.next != &pe_entry->ctx_entry)) {
 		SOCK_LOG_DBG("Waiting for FI_FENCE\n");
@@ -2143,7 +2195,7 @@ static int sock_pe_new_tx_entry(struct sock_pe *pe, struct sock_tx_ctx *tx_ctx)
 	msg_hdr = &pe_entry->msg_hdr;
 	msg_hdr->msg_len = sizeof(*msg_hdr);
 
-	msg_hdr->pe_entry_id = (uint16_t) PE_INDEX(pe, pe_entry);
+	msg_hdr->pe_entry_id = SOCK_PE_ENTRY_ID(pe, pe_entry);
 	SOCK_LOG_DBG("New TX on PE entry %p (%d)\n",
 		      pe_entry, msg_hdr->pe_entry_id);
 
@@ -2362,16 +2414,16 @@ out:
 
 void sock_pe_remove_tx_ctx(struct sock_tx_ctx *tx_ctx)
 {
-	pthread_mutex_lock(&tx_ctx->domain->pe->list_lock);
+	pthread_mutex_lock(&tx_ctx->pe->list_lock);
 	dlist_remove(&tx_ctx->pe_entry);
-	pthread_mutex_unlock(&tx_ctx->domain->pe->list_lock);
+	pthread_mutex_unlock(&tx_ctx->pe->list_lock);
 }
 
 void sock_pe_remove_rx_ctx(struct sock_rx_ctx *rx_ctx)
 {
-	pthread_mutex_lock(&rx_ctx->domain->pe->list_lock);
+	pthread_mutex_lock(&rx_ctx->pe->list_lock);
 	dlist_remove(&rx_ctx->pe_entry);
-	pthread_mutex_unlock(&rx_ctx->domain->pe->list_lock);
+	pthread_mutex_unlock(&rx_ctx->pe->list_lock);
 }
 
 static int sock_pe_progress_rx_ep(struct sock_pe *pe,
@@ -2387,20 +2439,21 @@ static int sock_pe_progress_rx_ep(struct sock_pe *pe,
 	if (!map->used)
 		return 0;
 
-	if (map->epoll_size < map->used) {
+	/* Several PEs may poll this map, each into its own event array */
+	if (pe->conn_events_size < map->used) {
 		int new_size = map->used * 2;
 		struct ofi_epollfds_event *events;
 
-		events = realloc(map->epoll_events,
-				 sizeof(*map->epoll_events) * new_size);
+		events = realloc(pe->conn_events,
+				 sizeof(*pe->conn_events) * new_size);
 		if (events) {
-			map->epoll_events = events;
-			map->epoll_size = new_size;
+			pe->conn_events = events;
+			pe->conn_events_size = new_size;
 		}
 	}
 
-	num_fds = ofi_epoll_wait(map->epoll_set, map->epoll_events,
-	                        MIN(map->used, map->epoll_size), 0);
+	num_fds = ofi_epoll_wait(map->epoll_set, pe->conn_events,
+	                        MIN(map->used, pe->conn_events_size), 0);
 	if (num_fds < 0 || num_fds == 0) {
 		if (num_fds < 0)
 			SOCK_LOG_ERROR("epoll failed: %d\n", num_fds);
@@ -2409,7 +2462,7 @@ static int sock_pe_progress_rx_ep(struct sock_pe *pe,
 
 	ofi_mutex_lock(&map->lock);
 	for (i = 0; i < num_fds; i++) {
-		conn = OFI_EPOLL_EVT_DATA(map->epoll_events[i]);
+		conn = OFI_EPOLL_EVT_DATA(pe->conn_events[i]);
 		if (!conn)
 			SOCK_LOG_ERROR("ofi_idm_lookup failed\n");
 
@@ -2468,7 +2521,7 @@ out:
 	return ret;
 }
 
-int sock_pe_progress_ep_rx(struct sock_pe *pe, struct sock_ep_attr *ep_attr)
+int sock_pe_progress_ep_rx(struct sock_ep_attr *ep_attr)
 {
 	struct sock_rx_ctx *rx_ctx;
 	int ret, i;
@@ -2478,14 +2531,14 @@ int sock_pe_progress_ep_rx(struct sock_pe *pe, struct sock_ep_attr *ep_attr)
 		if (!rx_ctx)
 			continue;
 
-		ret = sock_pe_progress_rx_ctx(pe, rx_ctx);
+		ret = sock_pe_progress_rx_ctx(rx_ctx->pe, rx_ctx);
 		if (ret < 0)
 			return ret;
 	}
 	return 0;
 }
 
-int sock_pe_progress_ep_tx(struct sock_pe *pe, struct sock_ep_attr *ep_attr)
+int sock_pe_progress_ep_tx(struct sock_ep_attr *ep_attr)
 {
 	struct sock_tx_ctx *tx_ctx;
 	int ret, i;
@@ -2495,7 +2548,7 @@ int sock_pe_progress_ep_tx(struct sock_pe *pe, struct sock_ep_attr *ep_attr)
 		if (!tx_ctx)
 			continue;
 
-		ret = sock_pe_progress_tx_ctx(pe, tx_ctx);
+		ret = sock_pe_progress_tx_ctx(tx_ctx->pe, tx_ctx);
 		if (ret < 0)
 			return ret;
 	}
@@ -2745,36 +2798,43 @@ struct sock_pe *sock_pe_init(struct sock_domain *domain)
 		goto err2;
 	}
 
+	pe->conn_events = calloc(sock_cm_def_map_sz, sizeof(*pe->conn_events));
+	if (!pe->conn_events)
+		goto err3;
+	pe->conn_events_size = sock_cm_def_map_sz;
+
 	if (ofi_epoll_create(&pe->epoll_set) < 0) {
                 SOCK_LOG_ERROR("failed to create epoll set\n");
-                goto err3;
+                goto err4;
 	}
 
 	if (domain->progress_mode == FI_PROGRESS_AUTO) {
 		if (socketpair(AF_UNIX, SOCK_STREAM, 0, pe->signal_fds) < 0)
-			goto err4;
+			goto err5;
 
 		if (fd_set_nonblock(pe->signal_fds[SOCK_SIGNAL_RD_FD]) ||
 		    ofi_epoll_add(pe->epoll_set,
 				 pe->signal_fds[SOCK_SIGNAL_RD_FD],
 				 OFI_EPOLL_IN, NULL))
-			goto err5;
+			goto err6;
 
 		pe->do_progress = 1;
 		if (pthread_create(&pe->progress_thread, NULL,
 				   sock_pe_progress_thread, (void *)pe)) {
 			SOCK_LOG_ERROR("Couldn't create progress thread\n");
-			goto err5;
+			goto err6;
 		}
 	}
 	SOCK_LOG_DBG("PE init: OK\n");
 	return pe;
 
-err5:
+err6:
 	ofi_close_socket(pe->signal_fds[0]);
 	ofi_close_socket(pe->signal_fds[1]);
-err4:
+err5:
 	ofi_epoll_close(pe->epoll_set);
+err4:
+	free(pe->conn_events);
 err3:
 	ofi_bufpool_destroy(pe->atomic_rx_pool);
 err2:
@@ -2822,6 +2882,7 @@ void sock_pe_finalize(struct sock_pe *pe)
 	ofi_mutex_destroy(&pe->signal_lock);
 	pthread_mutex_destroy(&pe->list_lock);
 	ofi_epoll_close(pe->epoll_set);
+	free(pe->conn_events);
 	free(pe);
 	SOCK_LOG_DBG("Progress engine finalize: OK\n");
 }
@@ -96,6 +96,7 @@ typedef void  xnet_profile_t;
 #define XNET_DEF_BUF_SIZE	16384
 #define XNET_MAX_EVENTS		128
 #define XNET_MIN_MULTI_RECV	16384
+#define XNET_URING_FIXED_BUFS	1024
 #define XNET_PORT_MAX_RANGE	(USHRT_MAX)
 
 extern struct fi_provider	xnet_prov;
@@ -112,6 +113,7 @@ extern int xnet_prefetch_rbuf_size;
 extern size_t xnet_default_tx_size;
 extern size_t xnet_default_rx_size;
 extern size_t xnet_zerocopy_size;
+extern size_t xnet_coalesce_size;
 extern int xnet_trace_msg;
 extern int xnet_disable_autoprog;
 extern int xnet_io_uring;
@@ -120,6 +122,8 @@ extern size_t xnet_max_saved_size;
 extern size_t xnet_max_inject;
 extern size_t xnet_buf_size;
 extern int xnet_firewall_addr;
+extern size_t xnet_progress_shards;
+extern char *xnet_progress_affinity;
 
 struct xnet_xfer_entry;
 struct xnet_ep;
@@ -256,6 +260,7 @@ struct xnet_ep {
 	struct xnet_saved_msg	*saved_msg;
 	int			rx_avail;
 	struct xnet_srx		*srx;
+	struct xnet_progress	*progress;
 
 	enum xnet_state		state;
 	struct util_peer_addr	*peer;
@@ -303,6 +308,8 @@ struct xnet_rdm {
 
 	struct xnet_pep		*pep;
 	struct xnet_srx		*srx;
+	/* All connections of an rdm ep share its progress instance */
+	struct xnet_progress	*progress;
 
 	struct index_map	conn_idx_map;
 	struct xnet_conn	*rx_loopback;
@@ -312,11 +319,15 @@ struct xnet_rdm {
 };
 
 int xnet_rdm_ep(struct fid_domain *domain, struct fi_info *info,
-		struct fid_ep **ep_fid, void *context);
+		struct xnet_progress *progress, struct fid_ep **ep_fid,
+		void *context);
 ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t dest_addr,
 		      struct xnet_conn **conn);
 struct xnet_ep *xnet_get_rx_ep(struct xnet_rdm *rdm, fi_addr_t addr);
 void xnet_freeall_conns(struct xnet_rdm *rdm);
+int xnet_rdm_warmup(struct fid_ep *ep_fid, const fi_addr_t *addr,
+		    size_t count, size_t max_inflight, int timeout,
+		    void *context);
 
 struct xnet_uring {
 	struct fid fid;
@@ -366,7 +377,11 @@ struct xnet_progress {
 	struct fd_signal	signal;
 
 	struct slist		event_list;
+	/* Pending connection warm-ups of rdm eps on this instance */
+	struct dlist_entry	warmup_list;
 	struct ofi_bufpool	*xfer_pool;
+	/* xfer_pool size at which ep close next tries to shrink it */
+	size_t			xfer_shrink_cnt;
 
 	struct xnet_uring	tx_uring;
 	struct xnet_uring	rx_uring;
@@ -379,6 +394,8 @@ struct xnet_progress {
 
 	bool			auto_progress;
 	pthread_t		thread;
+	/* CPU set the progress thread is bound to, may be NULL */
+	char			*affinity;
 };
 
 int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info);
@@ -407,6 +424,7 @@ int xnet_uring_cancel(struct xnet_progress *progress,
 int xnet_uring_pollin_add(struct xnet_progress *progress,
 			  int fd, bool multishot,
 			  struct ofi_sockctx *pollin_ctx);
+int xnet_uring_start_ep(struct xnet_ep *ep);
 
 static inline int xnet_progress_locked(struct xnet_progress *progress)
 {
@@ -437,6 +455,7 @@ static inline void xnet_signal_progress(struct xnet_progress *progress)
 #define XNET_COPY_RECV		BIT(9)
 #define XNET_CLAIM_RECV		BIT(10)
 #define XNET_NEED_CTS		BIT(11)
+#define XNET_MORE		BIT(12)
 #define XNET_MULTI_RECV		FI_MULTI_RECV /* BIT(16) */
 
 struct xnet_mrecv {
@@ -504,27 +523,46 @@ struct xnet_domain {
 	 struct fi_info		*subdomain_info;
 	 struct ofi_genlock	subdomain_list_lock;
 	 struct dlist_entry	subdomain_list;
+
+	/* Sharded progress (FI_TCP_PROGRESS_SHARDS) spreads the endpoints
+	 * of a domain across several progress instances, each with its
+	 * own poll set, lock, and progress thread.  An rdm ep, together
+	 * with all of its connections, is assigned to a single shard, as
+	 * is a msg ep.  Endpoints that use a shared receive context
+	 * remain on the domain progress instance with the srx.  All
+	 * shards report completions to the same CQs and counters, which
+	 * are protected by their own locks in this mode.
+	 */
+	struct xnet_progress	*shards;
+	size_t			shard_cnt;
+	ofi_atomic32_t		next_shard;
 };
 
+struct xnet_progress *xnet_domain_select_progress(struct xnet_domain *domain,
+						  struct fi_info *info);
+void xnet_progress_domain(struct xnet_domain *domain);
+int xnet_wait_add_domain(struct util_wait *wait, struct xnet_domain *domain,
+			 ofi_wait_try_func wait_try, void *arg, void *context);
+void xnet_wait_del_domain(struct util_wait *wait, struct xnet_domain *domain);
+
+static inline bool xnet_domain_sharded(struct xnet_domain *domain)
+{
+	return domain->shard_cnt > 0;
+}
+
 static inline struct xnet_progress *xnet_ep2_progress(struct xnet_ep *ep)
 {
-	struct xnet_domain *domain;
-	domain = container_of(ep->util_ep.domain, struct xnet_domain,
-			      util_domain);
-	return &domain->progress;
+	return ep->progress;
 }
 
 static inline struct xnet_progress *xnet_rdm2_progress(struct xnet_rdm *rdm)
 {
-	struct xnet_domain *domain;
-	domain = container_of(rdm->util_ep.domain, struct xnet_domain,
-			      util_domain);
-	return &domain->progress;
+	return rdm->progress;
 }
 
 static inline struct xnet_progress *xnet_srx2_progress(struct xnet_srx *srx)
 {
-	return &srx->domain->progress;
+	return srx->rdm ? xnet_rdm2_progress(srx->rdm) : &srx->domain->progress;
 }
 
 struct xnet_cq {
@@ -539,6 +577,18 @@ static inline struct xnet_progress *xnet_cq2_progress(struct xnet_cq *cq)
 	return &domain->progress;
 }
 
+/* Sharded domains protect the CQ with its own lock, since completions
+ * may be written by any of the progress instances.
+ */
+static inline struct ofi_genlock *xnet_cq2_lock(struct xnet_cq *cq)
+{
+	struct xnet_domain *domain;
+	domain = container_of(cq->util_cq.domain, struct xnet_domain,
+			      util_domain);
+	return xnet_domain_sharded(domain) ? &cq->util_cq.cq_lock :
+					     domain->progress.active_lock;
+}
+
 /* xnet_cntr maps directly to util_cntr */
 
 static inline struct xnet_progress *xnet_cntr2_progress(struct util_cntr *cntr)
@@ -581,7 +631,8 @@ int xnet_setup_socket(SOCKET sock, struct fi_info *info);
 void xnet_set_zerocopy(SOCKET sock);
 
 int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
-		  struct fid_ep **ep_fid, void *context);
+		  struct xnet_progress *progress, struct fid_ep **ep_fid,
+		  void *context);
 void xnet_ep_disable(struct xnet_ep *ep, int cm_err, void* err_data,
 		     size_t err_data_size);
 
@@ -601,6 +652,8 @@ int xnet_mplex_av_open(struct fid_domain *domain_fid, struct fi_av_attr *attr,
 int xnet_domain_multiplexed(struct fid_domain *domain_fid);
 int xnet_domain_open(struct fid_fabric *fabric, struct fi_info *info,
 		     struct fid_domain **domain, void *context);
+int xnet_subdomain_open(struct xnet_domain *domain,
+			struct fid_domain **subdomain);
 int xnet_av_open(struct fid_domain *domain_fid, struct fi_av_attr *attr,
 		 struct fid_av **fid_av, void *context);
 int xnet_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
@@ -637,6 +690,8 @@ xnet_set_ack_flags(struct xnet_xfer_entry *xfer, uint64_t flags)
 		xfer->hdr.base_hdr.flags |= XNET_DELIVERY_COMPLETE;
 		xfer->ctrl_flags |= XNET_NEED_ACK;
 	}
+	if (flags & FI_MORE)
+		xfer->ctrl_flags |= XNET_MORE;
 }
 
 static inline void
@@ -770,6 +825,8 @@ void xnet_recv_saved(struct xnet_rdm *rdm,
 		     struct xnet_xfer_entry *rx_entry);
 void xnet_complete_saved(struct xnet_xfer_entry *saved_entry,
 			 void *msg_data);
+void xnet_complete_copy_recv(struct xnet_progress *progress,
+			     struct xnet_xfer_entry *saved_entry, int err);
 
 static inline uint64_t xnet_msg_len(union xnet_hdrs *hdr)
 {
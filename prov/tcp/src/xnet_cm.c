@@ -231,8 +231,7 @@ void xnet_uring_req_done(struct xnet_ep *ep, int res)
 	}
 
 	ep->pollflags = POLLIN;
-	ret = xnet_uring_pollin_add(xnet_ep2_progress(ep), ep->bsock.sock,
-				    false, &ep->bsock.pollin_sockctx);
+	ret = xnet_uring_start_ep(ep);
 	if (ret)
 		goto disable;
 
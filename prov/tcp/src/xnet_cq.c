@@ -66,13 +66,56 @@ xnet_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 	return ret;
 }
 
+/* io_uring task work queued for the reading thread interrupts the wait
+ * on the CQ.  Wait again for the remainder of the timeout.
+ */
+static ssize_t
+xnet_cq_sreadfrom(struct fid_cq *cq_fid, void *buf, size_t count,
+		  fi_addr_t *src_addr, const void *cond, int timeout)
+{
+	uint64_t endtime;
+	ssize_t ret;
+
+	endtime = ofi_timeout_time(timeout);
+	while (1) {
+		ret = ofi_cq_sreadfrom(cq_fid, buf, count, src_addr, cond,
+				       timeout);
+		if (ret != -FI_EINTR || !xnet_io_uring)
+			return ret;
+
+		if (ofi_adjust_timeout(endtime, &timeout))
+			return -FI_EAGAIN;
+	}
+}
+
+static ssize_t
+xnet_cq_sread(struct fid_cq *cq_fid, void *buf, size_t count,
+	      const void *cond, int timeout)
+{
+	return xnet_cq_sreadfrom(cq_fid, buf, count, NULL, cond, timeout);
+}
+
 static struct fi_ops_cq xnet_cq_ops = {
 	.size = sizeof(struct fi_ops_cq),
 	.read = ofi_cq_read,
 	.readfrom = xnet_cq_readfrom,
 	.readerr = xnet_cq_readerr,
-	.sread = ofi_cq_sread,
-	.sreadfrom = ofi_cq_sreadfrom,
+	.sread = xnet_cq_sread,
+	.sreadfrom = xnet_cq_sreadfrom,
+	.signal = ofi_cq_signal,
+	.strerror = ofi_cq_strerror,
+};
+
+/* Sharded domains: the CQ lock serializes access to the CQ, and each
+ * progress instance is locked separately while it is driven.
+ */
+static struct fi_ops_cq xnet_shard_cq_ops = {
+	.size = sizeof(struct fi_ops_cq),
+	.read = ofi_cq_read,
+	.readfrom = ofi_cq_readfrom,
+	.readerr = ofi_cq_readerr,
+	.sread = xnet_cq_sread,
+	.sreadfrom = xnet_cq_sreadfrom,
 	.signal = ofi_cq_signal,
 	.strerror = ofi_cq_strerror,
 };
@@ -84,6 +127,12 @@ static void xnet_cq_progress(struct util_cq *util_cq)
 	xnet_run_progress(xnet_cq2_progress(cq), false);
 }
 
+static void xnet_shard_cq_progress(struct util_cq *util_cq)
+{
+	xnet_progress_domain(container_of(util_cq->domain, struct xnet_domain,
+					  util_domain));
+}
+
 static int xnet_cq_close(struct fid *fid)
 {
 	int ret;
@@ -141,12 +190,7 @@ void xnet_report_success(struct xnet_xfer_entry *xfer_entry)
 
 	assert(xfer_entry->cq);
 	cq = &xfer_entry->cq->util_cq;
-	if (xfer_entry->ctrl_flags & XNET_COPY_RECV) {
-		xfer_entry->ctrl_flags &= ~XNET_COPY_RECV;
-		/* TODO: io_uring support, see comment in xnet_recv_saved() */
-		xnet_complete_saved(xfer_entry, &xfer_entry->msg_data);
-		return;
-	}
+	assert(!(xfer_entry->ctrl_flags & XNET_COPY_RECV));
 
 	flags = xfer_entry->cq_flags & ~FI_COMPLETION;
 	if (flags & FI_RECV) {
@@ -274,8 +318,10 @@ static int xnet_cq_wait_try_func(void *arg)
 int xnet_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		 struct fid_cq **cq_fid, void *context)
 {
+	struct xnet_domain *xnet_domain;
 	struct xnet_cq *cq;
 	struct fi_cq_attr cq_attr;
+	bool sharded;
 	int ret;
 
 	cq = calloc(1, sizeof(*cq));
@@ -291,23 +337,42 @@ int xnet_cq_open(struct fid_domain *domain, struct fi_cq_attr *attr,
 		attr = &cq_attr;
 	}
 
+	xnet_domain = container_of(domain, struct xnet_domain,
+				   util_domain.domain_fid);
+	sharded = xnet_domain_sharded(xnet_domain);
 	ret = ofi_cq_init(&xnet_prov, domain, attr, &cq->util_cq,
-			  &xnet_cq_progress, context);
+			  sharded ? &xnet_shard_cq_progress : &xnet_cq_progress,
+			  context);
 	if (ret)
 		goto free_cq;
 
+	if (sharded) {
+		ofi_genlock_destroy(&cq->util_cq.cq_lock);
+		ret = ofi_genlock_init(&cq->util_cq.cq_lock, OFI_LOCK_MUTEX);
+		if (ret)
+			goto cleanup;
+	}
+
+	/* Shard progress threads write while the application reads without
+	 * holding their locks.  Otherwise readers take the progress lock
+	 * that writers already hold, and the ring would only add overhead.
+	 */
+	ret = ofi_cq_init_ring(&cq->util_cq, sharded ? UTIL_CQ_RING_MPSC :
+						      UTIL_CQ_RING_NONE);
+	if (ret)
+		goto cleanup;
+
 	if (cq->util_cq.wait && ofi_have_epoll) {
-		ret = ofi_wait_add_fd(cq->util_cq.wait,
-			       ofi_dynpoll_get_fd(&xnet_cq2_progress(cq)->epoll_fd),
-			       POLLIN, xnet_cq_wait_try_func, cq,
-			       &cq->util_cq.cq_fid);
+		ret = xnet_wait_add_domain(cq->util_cq.wait, xnet_domain,
+					   xnet_cq_wait_try_func, cq,
+					   &cq->util_cq.cq_fid);
 		if (ret)
 			goto cleanup;
 	}
 
 	*cq_fid = &cq->util_cq.cq_fid;
 	(*cq_fid)->fid.ops = &xnet_cq_fi_ops;
-	(*cq_fid)->ops = &xnet_cq_ops;
+	(*cq_fid)->ops = sharded ? &xnet_shard_cq_ops : &xnet_cq_ops;
 	return 0;
 
 cleanup:
@@ -323,6 +388,12 @@ static void xnet_cntr_progress(struct util_cntr *cntr)
 	xnet_progress(xnet_cntr2_progress(cntr), false);
 }
 
+static void xnet_shard_cntr_progress(struct util_cntr *cntr)
+{
+	xnet_progress_domain(container_of(cntr->domain, struct xnet_domain,
+					  util_domain));
+}
+
 void xnet_cntr_incerr(struct xnet_xfer_entry *xfer_entry)
 {
 	if (!xfer_entry->cntr ||
@@ -462,6 +533,7 @@ int xnet_cntr_open(struct fid_domain *fid_domain, struct fi_cntr_attr *attr,
 	if (attr->wait_obj == FI_WAIT_UNSPEC) {
 		cntr_attr = *attr;
 		if (domain->progress.auto_progress ||
+		    xnet_domain_sharded(domain) ||
 		    domain->util_domain.threading != FI_THREAD_DOMAIN) {
 			cntr_attr.wait_obj = FI_WAIT_FD;
 		} else {
@@ -472,19 +544,22 @@ int xnet_cntr_open(struct fid_domain *fid_domain, struct fi_cntr_attr *attr,
 	}
 
 	ret = ofi_cntr_init(&xnet_prov, fid_domain, attr, cntr,
-			    &xnet_cntr_progress, context);
+			    xnet_domain_sharded(domain) ?
+			    &xnet_shard_cntr_progress : &xnet_cntr_progress,
+			    context);
 	if (ret)
 		goto free;
 
+	/* xnet_cntr_ops wait on the domain progress instance only */
 	if (attr->wait_obj == FI_WAIT_NONE) {
-		cntr->cntr_fid.ops = &xnet_cntr_ops;
+		if (!xnet_domain_sharded(domain))
+			cntr->cntr_fid.ops = &xnet_cntr_ops;
 	} else {
 		progress = xnet_cntr2_progress(cntr);
 		if (attr->wait_obj == FI_WAIT_FD && ofi_have_epoll) {
-			ret = ofi_wait_add_fd(cntr->wait,
-					ofi_dynpoll_get_fd(&progress->epoll_fd),
-					POLLIN, xnet_cntr_wait_try_func, NULL,
-					&cntr->cntr_fid);
+			ret = xnet_wait_add_domain(cntr->wait, domain,
+						   xnet_cntr_wait_try_func,
+						   NULL, &cntr->cntr_fid);
 		} else {
 			ret = xnet_start_progress(progress);
 		}
@@ -255,10 +255,14 @@ static int xnet_open_ep(struct fid_domain *domain_fid, struct fi_info *info,
 		return -FI_EINVAL;
 
 	if (info->ep_attr->type == FI_EP_MSG)
-		return xnet_endpoint(domain_fid, info, ep_fid, context);
+		return xnet_endpoint(domain_fid, info,
+				     xnet_domain_select_progress(domain, info),
+				     ep_fid, context);
 
 	if (info->ep_attr->type == FI_EP_RDM)
-		return xnet_rdm_ep(domain_fid, info, ep_fid, context);
+		return xnet_rdm_ep(domain_fid, info,
+				   xnet_domain_select_progress(domain, info),
+				   ep_fid, context);
 
 	return -FI_EINVAL;
 }
@@ -276,6 +280,95 @@ xnet_query_atomic(struct fid_domain *domain, enum fi_datatype datatype,
 	return -FI_EOPNOTSUPP;
 }
 
+struct xnet_progress *xnet_domain_select_progress(struct xnet_domain *domain,
+						  struct fi_info *info)
+{
+	uint32_t index;
+
+	/* Sharding is per endpoint: an rdm ep brings its pep and every
+	 * connection to the same instance, since its srx and CM state are
+	 * serialized there.  Receives posted to a shared receive context
+	 * may be matched by any endpoint using it, so those endpoints stay
+	 * with the srx.
+	 */
+	if (!xnet_domain_sharded(domain) ||
+	    (info->ep_attr && info->ep_attr->rx_ctx_cnt == FI_SHARED_CONTEXT))
+		return &domain->progress;
+
+	index = (uint32_t) ofi_atomic_inc32(&domain->next_shard);
+	return &domain->shards[index % domain->shard_cnt];
+}
+
+static void xnet_close_shards(struct xnet_domain *domain, size_t cnt)
+{
+	while (cnt--)
+		xnet_close_progress(&domain->shards[cnt]);
+	free(domain->shards);
+	domain->shards = NULL;
+	domain->shard_cnt = 0;
+}
+
+/* FI_TCP_PROGRESS_AFFINITY is a comma separated list of cpu sets in the
+ * format accepted by ofi_set_thread_affinity() (e.g. 0,2,4-7:2).  The
+ * n-th entry is assigned to the n-th shard, wrapping around as needed.
+ */
+static char *xnet_shard_affinity(size_t index)
+{
+	const char *entry, *end;
+	size_t cnt = 0;
+
+	if (!xnet_progress_affinity || !*xnet_progress_affinity)
+		return NULL;
+
+	for (entry = xnet_progress_affinity; entry; ) {
+		cnt++;
+		entry = strchr(entry, ',');
+		if (entry)
+			entry++;
+	}
+
+	entry = xnet_progress_affinity;
+	for (index %= cnt; index; index--)
+		entry = strchr(entry, ',') + 1;
+
+	end = strchr(entry, ',');
+	return end ? strndup(entry, end - entry) : strdup(entry);
+}
+
+static int xnet_open_shards(struct xnet_domain *domain, struct fi_info *info,
+			    size_t cnt)
+{
+	size_t i;
+	int ret;
+
+	domain->shards = calloc(cnt, sizeof(*domain->shards));
+	if (!domain->shards)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < cnt; i++) {
+		ret = xnet_init_progress(&domain->shards[i], info);
+		if (ret)
+			goto err;
+
+		domain->shards[i].affinity = xnet_shard_affinity(i);
+		ret = xnet_start_progress(&domain->shards[i]);
+		if (ret) {
+			xnet_close_progress(&domain->shards[i]);
+			goto err;
+		}
+	}
+
+	domain->shard_cnt = cnt;
+	ofi_atomic_initialize32(&domain->next_shard, 0);
+	FI_INFO(&xnet_prov, FI_LOG_DOMAIN,
+		"using %zu progress shards\n", domain->shard_cnt);
+	return 0;
+
+err:
+	xnet_close_shards(domain, i);
+	return ret;
+}
+
 static int xnet_domain_close(fid_t fid)
 {
 	struct xnet_domain *domain;
@@ -289,6 +382,7 @@ static int xnet_domain_close(fid_t fid)
 	if (ret)
 		return ret;
 
+	xnet_close_shards(domain, domain->shard_cnt);
 	xnet_close_progress(&domain->progress);
 	free(domain);
 	return FI_SUCCESS;
@@ -426,26 +520,22 @@ static struct fi_ops_mr xnet_domain_fi_ops_mr = {
 	.regattr = xnet_mr_regattr,
 };
 
-int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
-		     struct fid_domain **domain_fid, void *context)
+static int xnet_open_domain(struct fid_fabric *fabric_fid, struct fi_info *info,
+			    size_t shard_cnt, struct fid_domain **domain_fid,
+			    void *context)
 {
 	struct xnet_domain *domain;
 	int ret;
 
-	ret = ofi_prov_check_info(&xnet_util_prov, fabric_fid->api_version, info);
-	if (ret)
-		return ret;
-
-	if (info->ep_attr->type == FI_EP_RDM &&
-	    info->domain_attr->threading == FI_THREAD_COMPLETION)
-		return xnet_domain_mplex_open(fabric_fid, info, domain_fid, context);
-
 	domain = calloc(1, sizeof(*domain));
 	if (!domain)
 		return -FI_ENOMEM;
 
+	/* With sharding, the mr map is accessed from multiple progress
+	 * instances, so the domain lock must be real.
+	 */
 	ret = ofi_domain_init(fabric_fid, info, &domain->util_domain, context,
-			      OFI_LOCK_NONE);
+			      shard_cnt ? OFI_LOCK_MUTEX : OFI_LOCK_NONE);
 	if (ret)
 		goto free;
 
@@ -453,6 +543,12 @@ int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
 	if (ret)
 		goto close;
 
+	if (shard_cnt) {
+		ret = xnet_open_shards(domain, info, shard_cnt);
+		if (ret)
+			goto close_progress;
+	}
+
 	domain->ep_type = info->ep_attr->type;
 	domain->util_domain.domain_fid.fid.ops = &xnet_domain_fi_ops;
 	domain->util_domain.domain_fid.ops = &xnet_domain_ops;
@@ -461,9 +557,36 @@ int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
 
 	return FI_SUCCESS;
 
+close_progress:
+	xnet_close_progress(&domain->progress);
 close:
 	(void) ofi_domain_close(&domain->util_domain);
 free:
 	free(domain);
 	return ret;
 }
+
+/* Subdomains already provide a progress instance per rdm ep. */
+int xnet_subdomain_open(struct xnet_domain *domain,
+			struct fid_domain **subdomain)
+{
+	return xnet_open_domain(&domain->util_domain.fabric->fabric_fid,
+				domain->subdomain_info, 0, subdomain, NULL);
+}
+
+int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
+		     struct fid_domain **domain_fid, void *context)
+{
+	int ret;
+
+	ret = ofi_prov_check_info(&xnet_util_prov, fabric_fid->api_version, info);
+	if (ret)
+		return ret;
+
+	if (info->ep_attr->type == FI_EP_RDM &&
+	    info->domain_attr->threading == FI_THREAD_COMPLETION)
+		return xnet_domain_mplex_open(fabric_fid, info, domain_fid, context);
+
+	return xnet_open_domain(fabric_fid, info, xnet_progress_shards,
+				domain_fid, context);
+}
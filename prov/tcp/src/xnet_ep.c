@@ -266,8 +266,7 @@ static int xnet_monitor_ep(struct xnet_progress *progress, struct xnet_ep *ep)
 {
 	if (xnet_io_uring) {
 		assert(!(ep->pollflags & POLLOUT));
-		return xnet_uring_pollin_add(progress, ep->bsock.sock,
-					     false, &ep->bsock.pollin_sockctx);
+		return xnet_uring_start_ep(ep);
 	}
 
 	return xnet_monitor_sock(progress, ep->bsock.sock, ep->pollflags,
@@ -471,6 +470,22 @@ static void xnet_ep_flush_all_queues(struct xnet_ep *ep)
 	if (ret)
 		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Failed to cancel POLLIN uring\n");
 
+	ret = xnet_uring_cancel(progress, &progress->rx_uring,
+				&ep->bsock.mshot_sockctx,
+				&ep->util_ep.ep_fid);
+	if (ret)
+		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Failed to cancel multishot uring\n");
+
+	/* Wait for a cancel issued by the bsock to complete */
+	ret = xnet_uring_cancel(progress, &progress->rx_uring,
+				&ep->bsock.cancel_sockctx,
+				&ep->util_ep.ep_fid);
+	if (ret)
+		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Failed to wait for uring cancel\n");
+
+	if (xnet_io_uring)
+		ofi_bsock_dereg_fixed(&ep->bsock);
+
 	if (ep->cur_tx.entry) {
 		ep->hdr_bswap(ep, &ep->cur_tx.entry->hdr.base_hdr);
 		if (ep->cur_tx.entry->ctrl_flags & XNET_NEED_CTS) {
@@ -491,8 +506,14 @@ static void xnet_ep_flush_all_queues(struct xnet_ep *ep)
 	xnet_flush_byte_idx(progress, &ep->rts_queue);
 	xnet_flush_byte_idx(progress, &ep->cts_queue);
 
-	/* Saved messages are on the saved_msg queue and flushed by the srx */
+	/* Saved messages are on the saved_msg queue and flushed by the srx,
+	 * unless already matched to a receive waiting on the copy.
+	 */
 	if (ep->cur_rx.entry &&
+	    (ep->cur_rx.entry->ctrl_flags & XNET_COPY_RECV)) {
+		xnet_complete_copy_recv(progress, ep->cur_rx.entry,
+					-FI_ECANCELED);
+	} else if (ep->cur_rx.entry &&
 	    !(ep->cur_rx.entry->ctrl_flags & XNET_SAVED_XFER)) {
 		xnet_report_error(ep->cur_rx.entry, FI_ECANCELED);
 		xnet_free_xfer(xnet_ep2_progress(ep), ep->cur_rx.entry);
@@ -678,11 +699,20 @@ static int xnet_ep_close(struct fid *fid)
 		xnet_halt_sock(progress, ep->bsock.sock);
 	ofi_close_socket(ep->bsock.sock);
 	xnet_ep_flush_all_queues(ep);
+	/* Return regions grown for this endpoint's traffic.  Shrinking
+	 * walks the pool, so only try once it has grown since the last try.
+	 */
+	if (progress->xfer_pool->entry_cnt > progress->xfer_shrink_cnt) {
+		ofi_bufpool_shrink(progress->xfer_pool);
+		progress->xfer_shrink_cnt = progress->xfer_pool->entry_cnt;
+	}
 	ofi_genlock_unlock(&progress->ep_lock);
 
 	if (ep->bsock.tx_sockctx.uring_sqe_inuse ||
 	    ep->bsock.rx_sockctx.uring_sqe_inuse ||
-	    ep->bsock.pollin_sockctx.uring_sqe_inuse)
+	    ep->bsock.pollin_sockctx.uring_sqe_inuse ||
+	    ep->bsock.mshot_sockctx.uring_sqe_inuse ||
+	    ep->bsock.cancel_sockctx.uring_sqe_inuse)
 		return -FI_EBUSY;
 
 	free(ep->cm_msg);
@@ -731,6 +761,9 @@ static int xnet_ep_bind(struct fid *fid, struct fid *bfid, uint64_t flags)
 	case FI_CLASS_SRX_CTX:
 		srx = container_of(bfid, struct xnet_srx, rx_fid.fid);
 		ep->srx = srx;
+		/* Matching requires that the ep is progressed with its srx */
+		ep->progress = xnet_srx2_progress(srx);
+		ep->bsock.sockapi = &ep->progress->sockapi;
 		if (!ep->profile)
 			ep->profile = srx->profile;
 		return FI_SUCCESS;
@@ -803,7 +836,8 @@ static struct fi_ops_ep xnet_ep_ops = {
 };
 
 int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
-		  struct fid_ep **ep_fid, void *context)
+		  struct xnet_progress *progress, struct fid_ep **ep_fid,
+		  void *context)
 {
 	struct xnet_ep *ep;
 	struct xnet_pep *pep;
@@ -820,6 +854,7 @@ int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
 		goto err1;
 
 	assert(info->ep_attr->type == FI_EP_MSG);
+	ep->progress = progress;
 	ofi_bsock_init(&ep->bsock, &xnet_ep2_progress(ep)->sockapi,
 		       xnet_staging_sbuf_size, xnet_prefetch_rbuf_size,
 		       &ep->util_ep.ep_fid);
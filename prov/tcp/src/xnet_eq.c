@@ -111,11 +111,30 @@ static int xnet_eq_close(struct fid *fid)
 	return 0;
 }
 
+/* See xnet_cq_sreadfrom() */
+static ssize_t
+xnet_eq_sread(struct fid_eq *eq_fid, uint32_t *event, void *buf,
+	      size_t len, int timeout, uint64_t flags)
+{
+	uint64_t endtime;
+	ssize_t ret;
+
+	endtime = ofi_timeout_time(timeout);
+	while (1) {
+		ret = ofi_eq_sread(eq_fid, event, buf, len, timeout, flags);
+		if (ret != -FI_EINTR || !xnet_io_uring)
+			return ret;
+
+		if (ofi_adjust_timeout(endtime, &timeout))
+			return -FI_EAGAIN;
+	}
+}
+
 static struct fi_ops_eq xnet_eq_ops = {
 	.size = sizeof(struct fi_ops_eq),
 	.read = xnet_eq_read,
 	.readerr = ofi_eq_readerr,
-	.sread = ofi_eq_sread,
+	.sread = xnet_eq_sread,
 	.write = ofi_eq_write,
 	.strerror = ofi_eq_strerror,
 };
@@ -141,10 +160,8 @@ static void xnet_eq_del_domain(struct xnet_eq *eq, struct xnet_domain *domain)
 	fid_list_remove(&eq->domain_list, NULL,
 			&domain->util_domain.domain_fid.fid);
 
-	if (eq->util_eq.wait && ofi_have_epoll) {
-		(void) ofi_wait_del_fd(eq->util_eq.wait,
-				ofi_dynpoll_get_fd(&domain->progress.epoll_fd));
-	}
+	if (eq->util_eq.wait && ofi_have_epoll)
+		xnet_wait_del_domain(eq->util_eq.wait, domain);
 	ofi_mutex_unlock(&eq->domain_lock);
 }
 
@@ -176,9 +193,8 @@ int xnet_add_domain_progress(struct xnet_eq *eq, struct xnet_domain *domain)
 		goto unlock;
 
 	if (eq->util_eq.wait && ofi_have_epoll) {
-		ret = ofi_wait_add_fd(eq->util_eq.wait,
-				ofi_dynpoll_get_fd(&domain->progress.epoll_fd),
-				POLLIN, xnet_eq_wait_try_func, NULL, domain);
+		ret = xnet_wait_add_domain(eq->util_eq.wait, domain,
+					   xnet_eq_wait_try_func, NULL, domain);
 	}
 unlock:
 	ofi_mutex_unlock(&eq->domain_lock);
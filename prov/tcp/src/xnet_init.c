@@ -64,6 +64,7 @@ int xnet_prefetch_rbuf_size = 9000;
 size_t xnet_default_tx_size = 256;
 size_t xnet_default_rx_size = 256;
 size_t xnet_zerocopy_size = SIZE_MAX;
+size_t xnet_coalesce_size;
 int xnet_trace_msg;
 int xnet_disable_autoprog;
 int xnet_io_uring;
@@ -72,6 +73,8 @@ size_t xnet_max_inject = XNET_DEF_INJECT;
 size_t xnet_buf_size = XNET_DEF_BUF_SIZE;
 size_t xnet_max_saved_size = SIZE_MAX;
 int xnet_firewall_addr = 0;
+size_t xnet_progress_shards;
+char *xnet_progress_affinity;
 
 
 static void xnet_init_env(void)
@@ -174,6 +177,13 @@ static void xnet_init_env(void)
 	fi_param_get_int(&xnet_prov, "prefetch_rbuf_size",
 			 &xnet_prefetch_rbuf_size);
 	fi_param_get_size_t(&xnet_prov, "zerocopy_size", &xnet_zerocopy_size);
+	fi_param_define(&xnet_prov, "coalesce_size", FI_PARAM_SIZE_T,
+			"number of bytes of small send data that may be "
+			"buffered in the staging buffer and completed before "
+			"being written to the socket, bounded by "
+			"staging_sbuf_size, set to 0 to disable "
+			"(default: %zu)", xnet_coalesce_size);
+	fi_param_get_size_t(&xnet_prov, "coalesce_size", &xnet_coalesce_size);
 
 	fi_param_define(&xnet_prov, "trace_msg", FI_PARAM_BOOL,
 			"Capture and display transport message information "
@@ -190,6 +200,21 @@ static void xnet_init_env(void)
 
 	fi_param_define(&xnet_prov, "firewall_addr", FI_PARAM_BOOL, "if this node is behind firewall");
 	fi_param_get_bool(&xnet_prov, "firewall_addr", &xnet_firewall_addr);
+
+	fi_param_define(&xnet_prov, "progress_shards", FI_PARAM_SIZE_T,
+			"Number of progress instances, each with its own "
+			"progress thread, that the endpoints of a domain are "
+			"spread across.  0 disables sharding (default: %zu)",
+			xnet_progress_shards);
+	fi_param_get_size_t(&xnet_prov, "progress_shards",
+			    &xnet_progress_shards);
+	fi_param_define(&xnet_prov, "progress_affinity", FI_PARAM_STRING,
+			"Comma separated list of cpu sets used to bind the "
+			"progress shard threads, one entry per shard.  Each "
+			"entry may be a cpu or a range a-b[:stride] "
+			"(default: none)");
+	fi_param_get_str(&xnet_prov, "progress_affinity",
+			 &xnet_progress_affinity);
 }
 
 static void xnet_fini(void)
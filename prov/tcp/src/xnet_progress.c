@@ -55,6 +55,9 @@ static struct ofi_sockapi xnet_sockapi_uring =
 	.sendv = ofi_sockapi_sendv_uring,
 	.recv = ofi_sockapi_recv_uring,
 	.recvv = ofi_sockapi_recvv_uring,
+	.send_fixed = ofi_sockapi_send_fixed_uring,
+	.recv_fixed = ofi_sockapi_recv_fixed_uring,
+	.recv_multishot = ofi_sockapi_recv_multishot_uring,
 };
 
 static struct ofi_sockapi xnet_sockapi_socket =
@@ -277,26 +280,18 @@ void xnet_complete_saved(struct xnet_xfer_entry *saved_entry, void *msg_data)
 	xnet_free_xfer(progress, saved_entry);
 }
 
-void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
-		     struct xnet_xfer_entry *rx_entry)
+/* Hand the saved message its receive buffer and completion info */
+static void xnet_claim_saved(struct xnet_xfer_entry *saved_entry,
+			     struct xnet_xfer_entry *rx_entry,
+			     void **buf2free, void **msg_data)
 {
-	struct xnet_progress *progress;
-	size_t msg_len, done_len, copy_len;
-	struct xnet_ep *ep;
-	void *buf2free, *msg_data;
-
-	progress = xnet_rdm2_progress(rdm);
-	assert(xnet_progress_locked(progress));
-	FI_DBG(&xnet_prov, FI_LOG_EP_DATA, "recv matched saved msg "
-	       "tag 0x%zx src %zu\n", saved_entry->tag, saved_entry->src_addr);
-
 	if (saved_entry->ctrl_flags & XNET_FREE_BUF) {
-		buf2free = saved_entry->user_buf;
-		msg_data = saved_entry->user_buf;
+		*buf2free = saved_entry->user_buf;
+		*msg_data = saved_entry->user_buf;
 		saved_entry->ctrl_flags &= ~(XNET_SAVED_XFER | XNET_FREE_BUF);
 	} else {
-		buf2free = NULL;
-		msg_data = &saved_entry->msg_data;
+		*buf2free = NULL;
+		*msg_data = &saved_entry->msg_data;
 		saved_entry->ctrl_flags &= ~XNET_SAVED_XFER;
 	}
 	saved_entry->context = rx_entry->context;
@@ -310,6 +305,65 @@ void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
 			rx_entry->iov_cnt * sizeof(rx_entry->iov[0]));
 		saved_entry->iov_cnt = rx_entry->iov_cnt;
 	}
+}
+
+/* The saved message matched while an io_uring recv into its buffer was
+ * posted.  That recv has now completed, along with the rest of the message,
+ * so the data can be copied to the matched receive.
+ */
+void xnet_complete_copy_recv(struct xnet_progress *progress,
+			     struct xnet_xfer_entry *saved_entry, int err)
+{
+	struct xnet_xfer_entry *rx_entry;
+	void *buf2free, *msg_data;
+
+	assert(xnet_progress_locked(progress));
+	assert(saved_entry->ctrl_flags & XNET_COPY_RECV);
+	rx_entry = saved_entry->resp_entry;
+	saved_entry->resp_entry = NULL;
+	saved_entry->saving_ep = NULL;
+	saved_entry->ctrl_flags &= ~XNET_COPY_RECV;
+	xnet_claim_saved(saved_entry, rx_entry, &buf2free, &msg_data);
+
+	if (!err) {
+		xnet_complete_saved(saved_entry, msg_data);
+	} else {
+		xnet_cntr_incerr(saved_entry);
+		xnet_report_error(saved_entry, -err);
+		xnet_free_xfer(progress, saved_entry);
+	}
+	free(buf2free);
+	xnet_free_xfer(progress, rx_entry);
+}
+
+void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
+		     struct xnet_xfer_entry *rx_entry)
+{
+	struct xnet_progress *progress;
+	size_t msg_len, done_len, copy_len;
+	struct xnet_ep *ep;
+	void *buf2free, *msg_data;
+
+	progress = xnet_rdm2_progress(rdm);
+	assert(xnet_progress_locked(progress));
+	FI_DBG(&xnet_prov, FI_LOG_EP_DATA, "recv matched saved msg "
+	       "tag 0x%zx src %zu\n", saved_entry->tag, saved_entry->src_addr);
+
+	ep = saved_entry->saving_ep;
+	if (ep && saved_entry->hdr.base_hdr.op != xnet_op_tag_rts &&
+	    ep->bsock.rx_sockctx.uring_sqe_inuse && !ep->bsock.async_prefetch) {
+		/* An io_uring recv is writing into the saved buffer.  Wait
+		 * for the message to complete before copying it out.
+		 */
+		FI_DBG(&xnet_prov, FI_LOG_EP_DATA, "saved msg has io_uring "
+		       "recv posted, copy deferred\n");
+		assert(saved_entry == ep->cur_rx.entry);
+		saved_entry->resp_entry = rx_entry;
+		saved_entry->ctrl_flags |= XNET_COPY_RECV;
+		return;
+	}
+
+	xnet_claim_saved(saved_entry, rx_entry, &buf2free, &msg_data);
 
 	if (saved_entry->hdr.base_hdr.op == xnet_op_tag_rts) {
 		ep = saved_entry->saving_ep;
@@ -325,13 +379,6 @@ void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
 	} else if (!saved_entry->saving_ep) {
 		xnet_complete_saved(saved_entry, msg_data);
 		free(buf2free);
-	/* TODO: io_uring support
-	} else if (async recv posted using io_uring) {
-	 * If we have an async recv posted to the io_uring, we need to
-	 * wait for that to complete before we can copy the data into
-	 * the user's buffer.  We cannot free buf2free in this case.
-		saved_entry->ctrl_flags |= XNET_COPY_RECV;
-	*/
 	} else {
 		ep = saved_entry->saving_ep;
 		saved_entry->saving_ep = NULL;
@@ -378,6 +425,15 @@ int xnet_uring_pollin_add(struct xnet_progress *progress, int fd,
 	return 0;
 }
 
+/* Registers the bsock staging buffers and starts monitoring the socket */
+int xnet_uring_start_ep(struct xnet_ep *ep)
+{
+	assert(xnet_io_uring);
+	ofi_bsock_reg_fixed(&ep->bsock);
+	return xnet_uring_pollin_add(xnet_ep2_progress(ep), ep->bsock.sock,
+				     false, &ep->bsock.pollin_sockctx);
+}
+
 static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 {
 	struct xnet_progress *progress;
@@ -386,7 +442,10 @@ static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 	progress = xnet_ep2_progress(ep);
 	assert(xnet_progress_locked(progress));
 	if (set) {
-		if (ep->pollflags & pollflag)
+		/* With io_uring, the flag can outlive the SQE that was to
+		 * report the event, so re-check below that one is armed.
+		 */
+		if ((ep->pollflags & pollflag) && !xnet_io_uring)
 			return 0;
 
 		ep->pollflags |= pollflag;
@@ -411,7 +470,8 @@ static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 		}
 
 		if ((ep->pollflags & POLLIN) &&
-			ep->bsock.rx_sockctx.uring_sqe_inuse) {
+		    (ep->bsock.rx_sockctx.uring_sqe_inuse ||
+		     ep->bsock.mshot_sockctx.uring_sqe_inuse)) {
 			/* A RX SQE is in use and will wake us up */
 			ep->pollflags &= ~POLLIN;
 			assert((ep->pollflags & (POLLIN | POLLOUT)) == 0);
@@ -1103,7 +1163,9 @@ static void xnet_complete_rx(struct xnet_ep *ep, ssize_t ret)
 			goto cq_error;
 	}
 
-	if (!(rx_entry->ctrl_flags & XNET_SAVED_XFER)) {
+	if (rx_entry->ctrl_flags & XNET_COPY_RECV) {
+		xnet_complete_copy_recv(xnet_ep2_progress(ep), rx_entry, 0);
+	} else if (!(rx_entry->ctrl_flags & XNET_SAVED_XFER)) {
 		xnet_report_success(rx_entry);
 		xnet_free_xfer(xnet_ep2_progress(ep), rx_entry);
 	} else {
@@ -1115,9 +1177,14 @@ static void xnet_complete_rx(struct xnet_ep *ep, ssize_t ret)
 cq_error:
 	FI_WARN(&xnet_prov, FI_LOG_EP_DATA,
 		"msg recv failed ret = %zd (%s)\n", ret, fi_strerror((int)-ret));
-	xnet_cntr_incerr(rx_entry);
-	xnet_report_error(rx_entry, (int) -ret);
-	xnet_free_xfer(xnet_ep2_progress(ep), rx_entry);
+	if (rx_entry->ctrl_flags & XNET_COPY_RECV) {
+		xnet_complete_copy_recv(xnet_ep2_progress(ep), rx_entry,
+					(int) ret);
+	} else {
+		xnet_cntr_incerr(rx_entry);
+		xnet_report_error(rx_entry, (int) -ret);
+		xnet_free_xfer(xnet_ep2_progress(ep), rx_entry);
+	}
 	xnet_reset_rx(ep);
 	xnet_ep_disable(ep, 0, NULL, 0);
 }
@@ -1209,11 +1276,13 @@ static void xnet_uring_rx_done(struct xnet_ep *ep, int res)
 	int ret;
 
 	if (ep->bsock.async_prefetch) {
-		if (res > 0)
+		if (res > 0) {
 			ofi_bsock_prefetch_done(&ep->bsock, res);
-		else {
+		} else {
 			ep->bsock.async_prefetch = false;
-			goto disable_ep;
+			/* Nothing was read; xnet_progress_rx re-issues it */
+			if (res != -ECANCELED)
+				goto disable_ep;
 		}
 	} else if (res <= 0 && !OFI_SOCK_TRY_SND_RCV_AGAIN(-res)) {
 		if (ep->cur_rx.entry)
@@ -1244,6 +1313,32 @@ disable_ep:
 	xnet_ep_disable(ep, 0, NULL, 0);
 }
 
+static void xnet_uring_mshot_done(struct xnet_ep *ep, int res, uint32_t flags)
+{
+	struct ofi_sockapi_uring *uring = &ep->bsock.sockapi->rx_uring;
+	int ret;
+
+	if (ep->state != XNET_CONNECTED) {
+		/* Data that raced with a disconnect is dropped */
+		if (flags & IORING_CQE_F_BUFFER)
+			ofi_uring_pbuf_recycle(uring,
+				(uint16_t) (flags >> IORING_CQE_BUFFER_SHIFT));
+		return;
+	}
+
+	if (res == -EINVAL && !(flags & IORING_CQE_F_MORE)) {
+		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "multishot recv not "
+			"supported, falling back to single shot recv\n");
+	}
+
+	ret = ofi_bsock_mshot_done(&ep->bsock, res, flags);
+	if (ret) {
+		xnet_ep_disable(ep, 0, NULL, 0);
+		return;
+	}
+	xnet_progress_rx(ep);
+}
+
 static void xnet_uring_connect_done(struct xnet_ep *ep, int res)
 {
 	struct xnet_progress *progress;
@@ -1278,8 +1373,13 @@ disable:
 }
 
 static void xnet_uring_run_ep(struct xnet_ep *ep, struct ofi_sockctx *sockctx,
-			      int res)
+			      int res, uint32_t flags)
 {
+	if (sockctx == &ep->bsock.mshot_sockctx) {
+		xnet_uring_mshot_done(ep, res, flags);
+		return;
+	}
+
 	switch (ep->state) {
 	case XNET_CONNECTED:
 		if (sockctx == &ep->bsock.tx_sockctx) {
@@ -1334,15 +1434,17 @@ static void xnet_progress_cqe(struct xnet_progress *progress,
 	sockctx = (struct ofi_sockctx *) cqe->user_data;
 	assert(sockctx);
 	assert(sockctx->uring_sqe_inuse);
-	if (!(cqe ->flags & IORING_CQE_F_MORE))
+	/* Multishot requests hold their credit until the final CQE */
+	if (!(cqe->flags & IORING_CQE_F_MORE)) {
 		sockctx->uring_sqe_inuse = false;
-	uring->sockapi->credits++;
+		uring->sockapi->credits++;
+	}
 
 	fid = sockctx->context;
 	switch (fid->fclass) {
 	case FI_CLASS_EP:
 		ep = container_of(fid, struct xnet_ep, util_ep.ep_fid.fid);
-		xnet_uring_run_ep(ep, sockctx, cqe->res);
+		xnet_uring_run_ep(ep, sockctx, cqe->res, cqe->flags);
 		break;
 	case FI_CLASS_CONNREQ:
 		conn = container_of(fid, struct xnet_conn_handle, fid);
@@ -1416,27 +1518,72 @@ int xnet_uring_cancel(struct xnet_progress *progress,
 	return 0;
 }
 
+/* With coalescing enabled, small sends posted while the socket is idle
+ * are copied into the staging buffer and completed immediately.  The
+ * buffered data goes out ahead of the next send that cannot be coalesced,
+ * once the coalesce size is reached, or on the next progress pass, which
+ * we request by arming POLLOUT.  Messages keep their normal headers, so the
+ * peer sees the same byte stream, just in fewer segments.
+ */
+static bool xnet_coalesce_tx(struct xnet_ep *ep,
+			     struct xnet_xfer_entry *tx_entry)
+{
+	size_t len;
+
+	if (!xnet_coalesce_size || xnet_io_uring ||
+	    (tx_entry->ctrl_flags & (XNET_NEED_ACK | XNET_NEED_CTS |
+				     XNET_NEED_RESP | XNET_INTERNAL_XFER)) ||
+	    (tx_entry->hdr.base_hdr.op != xnet_op_msg &&
+	     tx_entry->hdr.base_hdr.op != xnet_op_tag))
+		return false;
+
+	len = tx_entry->hdr.base_hdr.size;
+	if (len + ofi_bsock_tosend(&ep->bsock) > xnet_coalesce_size ||
+	    len >= ofi_byteq_writeable(&ep->bsock.sq))
+		return false;
+
+	OFI_DBG_SET(tx_entry->hdr.base_hdr.id, ep->tx_id++);
+	ep->hdr_bswap(ep, &tx_entry->hdr.base_hdr);
+	ofi_byteq_writev(&ep->bsock.sq, tx_entry->iov, tx_entry->iov_cnt);
+	xnet_report_success(tx_entry);
+	xnet_free_xfer(xnet_ep2_progress(ep), tx_entry);
+
+	if (ofi_bsock_tosend(&ep->bsock) >= xnet_coalesce_size)
+		xnet_progress_tx(ep);
+	else if (xnet_update_pollflag(ep, POLLOUT, true))
+		xnet_ep_disable(ep, 0, NULL, 0);
+	return true;
+}
+
 void xnet_tx_queue_insert(struct xnet_ep *ep,
 			  struct xnet_xfer_entry *tx_entry)
 {
 	struct xnet_progress *progress;
+	bool more;
 
 	progress = xnet_ep2_progress(ep);
 	assert(xnet_progress_locked(progress));
 
-	if (!ep->cur_tx.entry) {
+	/* With FI_MORE, SQEs are left for the next call without FI_MORE,
+	 * or progress, to submit along with those of other endpoints.
+	 */
+	more = tx_entry->ctrl_flags & XNET_MORE;
+	if (!ep->cur_tx.entry && xnet_coalesce_tx(ep, tx_entry)) {
+		/* buffered and completed */
+	} else if (!ep->cur_tx.entry) {
 		ep->cur_tx.entry = tx_entry;
 		ep->cur_tx.data_left = tx_entry->hdr.base_hdr.size;
 		OFI_DBG_SET(tx_entry->hdr.base_hdr.id, ep->tx_id++);
 		ep->hdr_bswap(ep, &tx_entry->hdr.base_hdr);
 		xnet_progress_tx(ep);
-		if (xnet_io_uring)
-			xnet_submit_uring(&progress->tx_uring);
 	} else if (tx_entry->ctrl_flags & XNET_INTERNAL_XFER) {
 		slist_insert_tail(&tx_entry->entry, &ep->priority_queue);
 	} else {
 		slist_insert_tail(&tx_entry->entry, &ep->tx_queue);
 	}
+
+	if (xnet_io_uring && !more)
+		xnet_submit_uring(&progress->tx_uring);
 }
 
 static int (*xnet_start_op[xnet_op_max])(struct xnet_ep *ep) = {
@@ -1541,9 +1688,10 @@ void xnet_progress_unexp(struct xnet_progress *progress,
 		assert(xnet_has_unexp(ep));
 		assert(ep->state == XNET_CONNECTED);
 		xnet_progress_rx(ep);
-		if (xnet_io_uring)
-			xnet_submit_uring(&progress->rx_uring);
 	}
+
+	if (xnet_io_uring)
+		xnet_submit_uring(&progress->rx_uring);
 }
 
 void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
@@ -1571,6 +1719,51 @@ void xnet_progress(struct xnet_progress *progress, bool clear_signal)
 	ofi_genlock_unlock(progress->active_lock);
 }
 
+/* Shards with a running progress thread are driven by that thread. */
+void xnet_progress_domain(struct xnet_domain *domain)
+{
+	size_t i;
+
+	xnet_progress(&domain->progress, false);
+	for (i = 0; i < domain->shard_cnt; i++) {
+		if (!domain->shards[i].auto_progress)
+			xnet_progress(&domain->shards[i], false);
+	}
+}
+
+int xnet_wait_add_domain(struct util_wait *wait, struct xnet_domain *domain,
+			 ofi_wait_try_func wait_try, void *arg, void *context)
+{
+	size_t i;
+	int ret;
+
+	ret = ofi_wait_add_fd(wait, ofi_dynpoll_get_fd(&domain->progress.epoll_fd),
+			      POLLIN, wait_try, arg, context);
+	for (i = 0; !ret && i < domain->shard_cnt; i++) {
+		if (domain->shards[i].auto_progress)
+			continue;
+
+		ret = ofi_wait_add_fd(wait,
+				ofi_dynpoll_get_fd(&domain->shards[i].epoll_fd),
+				POLLIN, wait_try, arg, context);
+	}
+	return ret;
+}
+
+void xnet_wait_del_domain(struct util_wait *wait, struct xnet_domain *domain)
+{
+	size_t i;
+
+	(void) ofi_wait_del_fd(wait,
+			       ofi_dynpoll_get_fd(&domain->progress.epoll_fd));
+	for (i = 0; i < domain->shard_cnt; i++) {
+		if (!domain->shards[i].auto_progress) {
+			(void) ofi_wait_del_fd(wait,
+				ofi_dynpoll_get_fd(&domain->shards[i].epoll_fd));
+		}
+	}
+}
+
 void xnet_progress_all(struct xnet_eq *eq)
 {
 	struct xnet_domain *domain;
@@ -1582,7 +1775,7 @@ void xnet_progress_all(struct xnet_eq *eq)
 		entry = container_of(item, struct fid_list_entry, entry);
 		domain = container_of(entry->fid, struct xnet_domain,
 				      util_domain.domain_fid.fid);
-		xnet_progress(&domain->progress, false);
+		xnet_progress_domain(domain);
 	}
 	ofi_mutex_unlock(&eq->domain_lock);
 
@@ -1626,12 +1819,12 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 		case FI_CLASS_CQ:
 			cq = container_of(fid[i], struct xnet_cq,
 					  util_cq.cq_fid.fid);
-			ofi_genlock_lock(xnet_cq2_progress(cq)->active_lock);
-			if (ofi_cirque_isempty(cq->util_cq.cirq))
+			ofi_genlock_lock(xnet_cq2_lock(cq));
+			if (ofi_cq_isempty(&cq->util_cq))
 				xnet_reset_wait(cq->util_cq.wait);
 			else
 				ret = -FI_EAGAIN;
-			ofi_genlock_unlock(xnet_cq2_progress(cq)->active_lock);
+			ofi_genlock_unlock(xnet_cq2_lock(cq));
 			break;
 		case FI_CLASS_EQ:
 			eq = container_of(fid[i], struct xnet_eq,
@@ -1680,6 +1873,7 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 {
 	struct ofi_epollfds_event event;
+	int ret;
 
 	/* We cannot enter blocking if io_uring has entries
 	 * that need submission. */
@@ -1687,7 +1881,10 @@ int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 		assert(ofi_uring_sq_ready(&progress->tx_uring.ring) == 0);
 		assert(ofi_uring_sq_ready(&progress->rx_uring.ring) == 0);
 	}
-	return ofi_dynpoll_wait(&progress->epoll_fd, &event, 1, timeout);
+	ret = ofi_dynpoll_wait(&progress->epoll_fd, &event, 1, timeout);
+
+	/* io_uring task work for this thread interrupts the wait */
+	return (ret == -FI_EINTR && xnet_io_uring) ? 0 : ret;
 }
 
 static void *xnet_auto_progress(void *arg)
@@ -1696,6 +1893,12 @@ static void *xnet_auto_progress(void *arg)
 	int nfds;
 
 	FI_INFO(&xnet_prov, FI_LOG_DOMAIN, "progress thread starting\n");
+	if (progress->affinity && ofi_set_thread_affinity(progress->affinity)) {
+		FI_WARN(&xnet_prov, FI_LOG_DOMAIN,
+			"unable to set progress thread affinity to %s\n",
+			progress->affinity);
+	}
+
 	ofi_genlock_lock(progress->active_lock);
 	while (progress->auto_progress) {
 		ofi_genlock_unlock(progress->active_lock);
@@ -1850,6 +2053,54 @@ static void xnet_destroy_uring(struct xnet_uring *uring,
 	}
 }
 
+/* Provided buffers and registered buffers are optimizations.  If the
+ * kernel or liburing lacks support, io_uring runs without them.
+ */
+static void xnet_init_uring_bufs(struct xnet_progress *progress)
+{
+	unsigned int cnt;
+	int ret;
+
+	/* Every provided buffer can post a CQE in addition to those
+	 * accounted for by the credits, so limit the buffer count to the
+	 * SQ size to stay within the CQ, which is twice the SQ size.
+	 */
+	cnt = OFI_URING_PBUF_CNT;
+	while (cnt > progress->sockapi.rx_uring.credits)
+		cnt >>= 1;
+
+	if (cnt && xnet_prefetch_rbuf_size > 0) {
+		ret = ofi_uring_pbuf_init(&progress->sockapi.rx_uring, cnt,
+					  xnet_prefetch_rbuf_size);
+		if (ret) {
+			FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+				"io_uring multishot recv unavailable: %s\n",
+				fi_strerror(-ret));
+		}
+	}
+
+	ret = ofi_uring_fixed_init(&progress->sockapi.tx_uring,
+				   XNET_URING_FIXED_BUFS);
+	if (!ret) {
+		ret = ofi_uring_fixed_init(&progress->sockapi.rx_uring,
+					   XNET_URING_FIXED_BUFS);
+		if (ret)
+			ofi_uring_fixed_cleanup(&progress->sockapi.tx_uring);
+	}
+	if (ret) {
+		FI_INFO(&xnet_prov, FI_LOG_EP_CTRL,
+			"io_uring registered buffers unavailable: %s\n",
+			fi_strerror(-ret));
+	}
+}
+
+static void xnet_cleanup_uring_bufs(struct xnet_progress *progress)
+{
+	ofi_uring_pbuf_cleanup(&progress->sockapi.rx_uring);
+	ofi_uring_fixed_cleanup(&progress->sockapi.rx_uring);
+	ofi_uring_fixed_cleanup(&progress->sockapi.tx_uring);
+}
+
 int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 {
 	int ret;
@@ -1860,6 +2111,7 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 	dlist_init(&progress->unexp_tag_list);
 	dlist_init(&progress->saved_tag_list);
 	slist_init(&progress->event_list);
+	dlist_init(&progress->warmup_list);
 
 	ret = fd_signal_init(&progress->signal);
 	if (ret)
@@ -1877,9 +2129,10 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 
 	ret = ofi_bufpool_create(&progress->xfer_pool,
 			sizeof(struct xnet_xfer_entry) + xnet_buf_size,
-			16, 0, 1024, 0);
+			16, 0, 1024, OFI_BUFPOOL_NUMA_LOCAL);
 	if (ret)
 		goto err3;
+	progress->xfer_shrink_cnt = progress->xfer_pool->attr.chunk_cnt;
 
 	ret = ofi_dynpoll_add(&progress->epoll_fd, progress->signal.fd[FI_READ_FD],
 			      POLLIN, &progress->fid);
@@ -1908,6 +2161,8 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 				      &progress->epoll_fd);
 		if (ret)
 			goto err7;
+
+		xnet_init_uring_bufs(progress);
 	} else {
 		progress->sockapi = xnet_sockapi_socket;
 	}
@@ -1940,6 +2195,7 @@ void xnet_close_progress(struct xnet_progress *progress)
 	xnet_stop_progress(progress);
 	if (xnet_io_uring) {
 		free(progress->cqes);
+		xnet_cleanup_uring_bufs(progress);
 		xnet_destroy_uring(&progress->rx_uring, &progress->epoll_fd);
 		xnet_destroy_uring(&progress->tx_uring, &progress->epoll_fd);
 	}
@@ -1948,4 +2204,6 @@ void xnet_close_progress(struct xnet_progress *progress)
 	ofi_genlock_destroy(&progress->ep_lock);
 	ofi_genlock_destroy(&progress->rdm_lock);
 	fd_signal_free(&progress->signal);
+	free(progress->affinity);
+	progress->affinity = NULL;
 }
@@ -866,9 +866,7 @@ int xnet_rdm_resolve_domains(struct xnet_rdm *rdm)
 	ofi_genlock_lock(&domain->util_domain.lock);
 	subdomain = xnet_find_subdomain(rdm);
 	if (!subdomain) {
-		ret = fi_domain(&domain->util_domain.fabric->fabric_fid,
-				domain->subdomain_info,
-				&subdomain_fid, NULL);
+		ret = xnet_subdomain_open(domain, &subdomain_fid);
 		if (ret)
 			goto out;
 
@@ -897,6 +895,7 @@ int xnet_rdm_resolve_domains(struct xnet_rdm *rdm)
 	ofi_atomic_dec32(&rdm->util_ep.domain->ref);
 	ofi_atomic_inc32(&subdomain->util_domain.ref);
 	rdm->util_ep.domain = &subdomain->util_domain;
+	rdm->progress = &subdomain->progress;
 
 	ofi_atomic_dec32(&rdm->srx->domain->util_domain.ref);
 	ofi_atomic_inc32(&subdomain->util_domain.ref);
@@ -1016,12 +1015,28 @@ static int xnet_rdm_close(struct fid *fid)
 	return 0;
 }
 
+static struct fi_ops_conn_warmup xnet_rdm_warmup_ops = {
+	.size = sizeof(struct fi_ops_conn_warmup),
+	.warmup = xnet_rdm_warmup,
+};
+
+static int xnet_rdm_fi_ops_open(struct fid *fid, const char *name,
+				uint64_t flags, void **ops, void *context)
+{
+	if (!strcmp(name, FI_CONN_WARMUP_OPS)) {
+		*ops = &xnet_rdm_warmup_ops;
+		return 0;
+	}
+
+	return xnet_rdm_ops_open(fid, name, flags, ops, context);
+}
+
 static struct fi_ops xnet_rdm_fid_ops = {
 	.size = sizeof(struct fi_ops),
 	.close = xnet_rdm_close,
 	.bind = ofi_ep_fid_bind,
 	.control = xnet_rdm_ctrl,
-	.ops_open = xnet_rdm_ops_open,
+	.ops_open = xnet_rdm_fi_ops_open,
 };
 
 static int xnet_init_rdm(struct xnet_rdm *rdm, struct fi_info *info)
@@ -1082,7 +1097,8 @@ err1:
 }
 
 int xnet_rdm_ep(struct fid_domain *domain, struct fi_info *info,
-		struct fid_ep **ep_fid, void *context)
+		struct xnet_progress *progress, struct fid_ep **ep_fid,
+		void *context)
 {
 	struct xnet_rdm *rdm;
 	int ret;
@@ -1097,6 +1113,7 @@ int xnet_rdm_ep(struct fid_domain *domain, struct fi_info *info,
 		goto err1;
 
 	assert(info->ep_attr->type == FI_EP_RDM);
+	rdm->progress = progress;
 	ret = xnet_init_rdm(rdm, info);
 	if (ret)
 		goto err2;
@@ -188,7 +188,7 @@ static int xnet_open_conn(struct xnet_conn *conn, struct fi_info *info)
 
 	assert(xnet_progress_locked(xnet_rdm2_progress(conn->rdm)));
 	ret = xnet_endpoint(&conn->rdm->util_ep.domain->domain_fid, info,
-			    &ep_fid, conn);
+			    xnet_rdm2_progress(conn->rdm), &ep_fid, conn);
 	if (ret) {
 		XNET_WARN_ERR(FI_LOG_EP_CTRL, "fi_endpoint", ret);
 		return ret;
@@ -275,6 +275,8 @@ static void xnet_free_conn(struct xnet_conn *conn)
 
 void xnet_freeall_conns(struct xnet_rdm *rdm)
 {
+	struct util_conn_warmup *warmup;
+	struct dlist_entry *tmp;
 	struct xnet_conn *conn;
 	struct rxm_av *av;
 	int i, cnt;
@@ -285,6 +287,15 @@ void xnet_freeall_conns(struct xnet_rdm *rdm)
 	av = container_of(rdm->util_ep.av, struct rxm_av, util_av);
 	assert(xnet_progress_locked(xnet_rdm2_progress(rdm)));
 
+	dlist_foreach_container_safe(&xnet_rdm2_progress(rdm)->warmup_list,
+				     struct util_conn_warmup, warmup, entry,
+				     tmp) {
+		if (warmup->ep != &rdm->util_ep)
+			continue;
+		dlist_remove(&warmup->entry);
+		ofi_conn_warmup_free(warmup);
+	}
+
 	/* We can't have more connections than the current number of
 	 * possible peers.
 	 */
@@ -353,12 +364,9 @@ static struct xnet_conn *xnet_add_conn(struct xnet_rdm *rdm,
 	return conn;
 }
 
-/* The returned conn is only valid if the function returns success.
- * This is called from data transfer ops, which return ssize_t, so
- * we return that rather than int.
- */
-ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t addr,
-		      struct xnet_conn **conn)
+/* Starts connecting if needed, but does not drive progress. */
+static ssize_t xnet_start_conn(struct xnet_rdm *rdm, fi_addr_t addr,
+			       struct xnet_conn **conn)
 {
 	struct util_peer_addr **peer;
 	ssize_t ret;
@@ -383,17 +391,77 @@ ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t addr,
 			return ret;
 	}
 
-	if ((*conn)->ep->state != XNET_CONNECTED) {
+	return (*conn)->ep->state == XNET_CONNECTED ? 0 : -FI_EAGAIN;
+}
+
+/* The returned conn is only valid if the function returns success.
+ * This is called from data transfer ops, which return ssize_t, so
+ * we return that rather than int.
+ */
+ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t addr,
+		      struct xnet_conn **conn)
+{
+	ssize_t ret;
+
+	ret = xnet_start_conn(rdm, addr, conn);
+	if (ret == -FI_EAGAIN) {
 		/* Force progress for apps that simply retry sending without
 		 * trying to drive progress in between.
 		 */
 		xnet_run_progress(xnet_rdm2_progress(rdm), false);
-		return -FI_EAGAIN;
 	}
 
+	return ret;
+}
+
+static ssize_t xnet_warmup_conn(struct util_ep *util_ep, fi_addr_t addr)
+{
+	struct xnet_conn *conn;
+
+	return xnet_start_conn(container_of(util_ep, struct xnet_rdm, util_ep),
+			       addr, &conn);
+}
+
+int xnet_rdm_warmup(struct fid_ep *ep_fid, const fi_addr_t *addr,
+		    size_t count, size_t max_inflight, int timeout,
+		    void *context)
+{
+	struct util_conn_warmup *warmup;
+	struct xnet_progress *progress;
+	struct xnet_rdm *rdm;
+	int ret;
+
+	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
+	ret = ofi_conn_warmup_init(&rdm->util_ep, xnet_warmup_conn, addr, count,
+				   max_inflight, timeout, context, &warmup);
+	if (ret)
+		return ret;
+
+	progress = xnet_rdm2_progress(rdm);
+	ofi_genlock_lock(&progress->rdm_lock);
+	if (ofi_conn_warmup_progress(warmup))
+		ofi_conn_warmup_free(warmup);
+	else
+		dlist_insert_tail(&warmup->entry, &progress->warmup_list);
+	ofi_genlock_unlock(&progress->rdm_lock);
 	return 0;
 }
 
+static void xnet_progress_warmup(struct xnet_progress *progress)
+{
+	struct util_conn_warmup *warmup;
+	struct dlist_entry *tmp;
+
+	dlist_foreach_container_safe(&progress->warmup_list,
+				     struct util_conn_warmup, warmup, entry,
+				     tmp) {
+		if (ofi_conn_warmup_progress(warmup)) {
+			dlist_remove(&warmup->entry);
+			ofi_conn_warmup_free(warmup);
+		}
+	}
+}
+
 struct xnet_ep *xnet_get_rx_ep(struct xnet_rdm *rdm, fi_addr_t addr)
 {
 	struct util_peer_addr **peer;
@@ -611,4 +679,7 @@ void xnet_handle_event_list(struct xnet_progress *progress)
 		}
 		free(event);
 	};
+
+	if (!dlist_empty(&progress->warmup_list))
+		xnet_progress_warmup(progress);
 }
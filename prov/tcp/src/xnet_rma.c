@@ -135,6 +135,8 @@ xnet_rma_readmsg(struct fid_ep *ep_fid, const struct fi_msg_rma *msg,
 	}
 	xnet_rma_read_send_entry_fill(send_entry, recv_entry, ep, msg);
 	xnet_rma_read_recv_entry_fill(recv_entry, ep, msg, flags);
+	if (flags & FI_MORE)
+		send_entry->ctrl_flags |= XNET_MORE;
 
 	slist_insert_tail(&recv_entry->entry, &ep->rma_read_queue);
 	xnet_tx_queue_insert(ep, send_entry);
@@ -65,10 +65,21 @@ xnet_alloc_srx_xfer(struct xnet_srx *srx)
 	return xfer;
 }
 
+/* The unexpected list is shared by every endpoint on the progress
+ * instance, including those of other rdm endpoints and their srx.
+ */
+static int xnet_match_unexp_srx(struct dlist_entry *item, const void *arg)
+{
+	struct xnet_ep *ep;
+	ep = container_of(item, struct xnet_ep, unexp_entry);
+	return ep->srx == arg;
+}
+
 static void
 xnet_srx_msg(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry)
 {
 	struct xnet_progress *progress;
+	struct dlist_entry *item;
 	struct xnet_ep *ep;
 
 	progress = xnet_srx2_progress(srx);
@@ -80,9 +91,13 @@ xnet_srx_msg(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry)
 		if (recv_entry->ctrl_flags & FI_MULTI_RECV) {
 			xnet_progress_unexp(progress, &progress->unexp_msg_list);
 		} else {
-			ep = container_of(progress->unexp_msg_list.next,
-					  struct xnet_ep, unexp_entry);
-			xnet_progress_rx(ep);
+			item = dlist_find_first_match(&progress->unexp_msg_list,
+						      xnet_match_unexp_srx, srx);
+			if (item) {
+				ep = container_of(item, struct xnet_ep,
+						  unexp_entry);
+				xnet_progress_rx(ep);
+			}
 		}
 	}
 }
@@ -79,6 +79,8 @@ int udpx_eq_open(struct fid_fabric *fabric, struct fi_eq_attr *attr,
 
 #define UDPX_FLAG_MULTI_RECV	1
 #define UDPX_IOV_LIMIT		4
+#define UDPX_RX_BATCH		32
+#define UDPX_TX_BATCH		32
 
 struct udpx_ep_entry {
 	void			*context;
@@ -90,6 +92,25 @@ struct udpx_ep_entry {
 
 OFI_DECLARE_CIRQUE(struct udpx_ep_entry, udpx_rx_cirq);
 
+/* Send deferred by FI_MORE until it can be batched with later sends */
+struct udpx_tx_entry {
+	void			*context;
+	struct iovec		iov[UDPX_IOV_LIMIT];
+	size_t			iov_count;
+	union ofi_sock_ip	addr;
+	socklen_t		addrlen;
+};
+
+/* Batched socket calls and the messages they carried, logged on ep close */
+struct udpx_stats {
+	uint64_t		rx_batches;
+	uint64_t		rx_msgs;
+	uint64_t		rx_max_batch;
+	uint64_t		tx_batches;
+	uint64_t		tx_msgs;
+	uint64_t		tx_max_batch;
+};
+
 struct udpx_ep;
 typedef void (*udpx_rx_comp_func)(struct udpx_ep *ep, void *context, size_t len,
 				  void *addr);
@@ -100,6 +121,9 @@ struct udpx_ep {
 	udpx_rx_comp_func	rx_comp;
 	udpx_tx_comp_func	tx_comp;
 	struct udpx_rx_cirq	*rxq;    /* protected by rx_cq lock */
+	struct udpx_tx_entry	txq[UDPX_TX_BATCH]; /* protected by tx_cq lock */
+	size_t			txq_cnt;
+	struct udpx_stats	stats;
 	SOCKET			sock;
 	int			is_bound;
 	ofi_atomic32_t		ref;
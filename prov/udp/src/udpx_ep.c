@@ -272,39 +272,213 @@ static void udpx_rx_src_comp_signal(struct udpx_ep *ep, void *context,
 	ep->util_ep.rx_cq->wait->signal(ep->util_ep.rx_cq->wait);
 }
 
-static void udpx_ep_progress(struct util_ep *util_ep)
+static inline void
+udpx_stats_batch(uint64_t *batches, uint64_t *msgs, uint64_t *max_batch,
+		 size_t cnt)
 {
-	struct udpx_ep *ep;
-	struct udpx_ep_entry *entry;
-	struct msghdr hdr;
-	struct sockaddr_in6 addr;
-	ssize_t ret;
+	(*batches)++;
+	*msgs += cnt;
+	if (cnt > *max_batch)
+		*max_batch = cnt;
+}
 
-	ep = container_of(util_ep, struct udpx_ep, util_ep);
-	hdr.msg_name = &addr;
-	hdr.msg_namelen = sizeof(addr);
-	hdr.msg_control = NULL;
-	hdr.msg_controllen = 0;
-	hdr.msg_flags = 0;
+static inline struct udpx_ep_entry *
+udpx_rxq_entry(struct udpx_ep *ep, size_t index)
+{
+	return &ep->rxq->buf[(ep->rxq->rcnt + index) & ep->rxq->size_mask];
+}
+
+/*
+ * Receive as many datagrams as there are posted buffers and free CQ
+ * entries, up to UDPX_RX_BATCH per call into the kernel.
+ */
+static void udpx_progress_rx(struct udpx_ep *ep)
+{
+	struct ofi_mmsghdr msgs[UDPX_RX_BATCH];
+	union ofi_sock_ip addr[UDPX_RX_BATCH];
+	struct udpx_ep_entry *entry;
+	size_t cnt, i;
+	int ret;
 
 	ofi_genlock_lock(&ep->util_ep.rx_cq->cq_lock);
-	if (ofi_cirque_isempty(ep->rxq) ||
-	    ofi_cirque_isfull(ep->util_ep.rx_cq->cirq))
-		goto out;
+	do {
+		cnt = MIN(ofi_cirque_usedcnt(ep->rxq),
+			  ofi_cirque_freecnt(ep->util_ep.rx_cq->cirq));
+		cnt = MIN(cnt, UDPX_RX_BATCH);
+		if (!cnt)
+			break;
+
+		for (i = 0; i < cnt; i++) {
+			entry = udpx_rxq_entry(ep, i);
+			msgs[i].msg_hdr.msg_name = &addr[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(addr[i]);
+			msgs[i].msg_hdr.msg_iov = entry->iov;
+			msgs[i].msg_hdr.msg_iovlen = entry->iov_count;
+			msgs[i].msg_hdr.msg_control = NULL;
+			msgs[i].msg_hdr.msg_controllen = 0;
+			msgs[i].msg_hdr.msg_flags = 0;
+		}
 
-	entry = ofi_cirque_head(ep->rxq);
-	hdr.msg_iov = entry->iov;
-	hdr.msg_iovlen = entry->iov_count;
+		ret = ofi_recvmmsg_udp(ep->sock, msgs, (unsigned int) cnt, 0);
+		if (ret <= 0)
+			break;
 
-	ret = ofi_recvmsg_udp(ep->sock, &hdr, 0);
-	if (ret >= 0) {
-		ep->rx_comp(ep, entry->context, ret, &addr);
-		ofi_cirque_discard(ep->rxq);
-	}
-out:
+		udpx_stats_batch(&ep->stats.rx_batches, &ep->stats.rx_msgs,
+				 &ep->stats.rx_max_batch, ret);
+		for (i = 0; i < (size_t) ret; i++) {
+			entry = ofi_cirque_head(ep->rxq);
+			ep->rx_comp(ep, entry->context, msgs[i].msg_len, &addr[i]);
+			ofi_cirque_discard(ep->rxq);
+		}
+	} while ((size_t) ret == cnt);
 	ofi_genlock_unlock(&ep->util_ep.rx_cq->cq_lock);
 }
 
+/* Caller must hold the tx_cq lock */
+static void udpx_tx_error(struct udpx_ep *ep, void *context, int err)
+{
+	struct fi_cq_err_entry err_entry = {0};
+	int ret;
+
+	err_entry.op_context = context;
+	err_entry.flags = FI_SEND;
+	err_entry.err = err;
+	err_entry.prov_errno = err;
+	ret = ofi_cq_insert_error(ep->util_ep.tx_cq, &err_entry);
+	if (ret) {
+		FI_WARN(&udpx_prov, FI_LOG_EP_DATA,
+			"unable to report send error %d\n", err);
+		return;
+	}
+
+	if (ep->util_ep.tx_cq->wait)
+		ep->util_ep.tx_cq->wait->signal(ep->util_ep.tx_cq->wait);
+}
+
+/*
+ * Hand queued sends to the kernel in as few calls as possible.  Sends
+ * that the socket cannot accept yet remain queued and are retried by
+ * progress.  Caller must hold the tx_cq lock.
+ */
+static void udpx_flush_txq(struct udpx_ep *ep)
+{
+	struct ofi_mmsghdr msgs[UDPX_TX_BATCH];
+	struct udpx_tx_entry *entry;
+	size_t cnt, i;
+	int ret, err;
+
+	while (ep->txq_cnt) {
+		cnt = MIN(ep->txq_cnt,
+			  ofi_cirque_freecnt(ep->util_ep.tx_cq->cirq));
+		if (!cnt)
+			return;
+
+		for (i = 0; i < cnt; i++) {
+			entry = &ep->txq[i];
+			msgs[i].msg_hdr.msg_name = &entry->addr;
+			msgs[i].msg_hdr.msg_namelen = entry->addrlen;
+			msgs[i].msg_hdr.msg_iov = entry->iov;
+			msgs[i].msg_hdr.msg_iovlen = entry->iov_count;
+			msgs[i].msg_hdr.msg_control = NULL;
+			msgs[i].msg_hdr.msg_controllen = 0;
+			msgs[i].msg_hdr.msg_flags = 0;
+		}
+
+		ret = ofi_sendmmsg_udp(ep->sock, msgs, (unsigned int) cnt, 0);
+		if (ret < 0) {
+			err = ofi_sockerr();
+			if (OFI_SOCK_TRY_SND_RCV_AGAIN(err))
+				return;
+
+			/* drop the send that failed and retry the rest */
+			udpx_tx_error(ep, ep->txq[0].context, err);
+			ret = 1;
+		} else {
+			udpx_stats_batch(&ep->stats.tx_batches,
+					 &ep->stats.tx_msgs,
+					 &ep->stats.tx_max_batch, ret);
+			for (i = 0; i < (size_t) ret; i++)
+				ep->tx_comp(ep, ep->txq[i].context);
+		}
+
+		ep->txq_cnt -= ret;
+		if (ep->txq_cnt) {
+			memmove(&ep->txq[0], &ep->txq[ret],
+				ep->txq_cnt * sizeof(ep->txq[0]));
+		}
+	}
+}
+
+/*
+ * Complete the sends still queued when the endpoint closes with
+ * FI_ECANCELED, so none of them is lost silently.  Caller must hold the
+ * tx_cq lock.
+ */
+static void udpx_cancel_txq(struct udpx_ep *ep)
+{
+	size_t i;
+
+	for (i = 0; i < ep->txq_cnt; i++)
+		udpx_tx_error(ep, ep->txq[i].context, FI_ECANCELED);
+	ep->txq_cnt = 0;
+}
+
+/*
+ * Make room for one more send, counting the CQ entries reserved by sends
+ * that are already queued.  Caller must hold the tx_cq lock.
+ */
+static ssize_t udpx_tx_reserve(struct udpx_ep *ep)
+{
+	if (ep->txq_cnt == UDPX_TX_BATCH)
+		udpx_flush_txq(ep);
+
+	if (ep->txq_cnt == UDPX_TX_BATCH ||
+	    ofi_cirque_freecnt(ep->util_ep.tx_cq->cirq) <= ep->txq_cnt)
+		return -FI_EAGAIN;
+
+	return 0;
+}
+
+/*
+ * Sends posted with FI_MORE are queued, and go out together with the
+ * next send posted without it.  Caller must hold the tx_cq lock.
+ */
+static ssize_t udpx_queue_tx(struct udpx_ep *ep, const struct iovec *iov,
+			     size_t count, const void *addr, size_t addrlen,
+			     void *context, uint64_t flags)
+{
+	struct udpx_tx_entry *entry;
+
+	if (count > UDPX_IOV_LIMIT || addrlen > sizeof(entry->addr))
+		return -FI_EINVAL;
+
+	entry = &ep->txq[ep->txq_cnt++];
+	entry->context = context;
+	memcpy(entry->iov, iov, count * sizeof(*iov));
+	entry->iov_count = count;
+	memcpy(&entry->addr, addr, addrlen);
+	entry->addrlen = (socklen_t) addrlen;
+
+	if (!(flags & FI_MORE))
+		udpx_flush_txq(ep);
+	return 0;
+}
+
+static void udpx_ep_progress(struct util_ep *util_ep)
+{
+	struct udpx_ep *ep;
+
+	ep = container_of(util_ep, struct udpx_ep, util_ep);
+	if (ep->util_ep.rx_cq)
+		udpx_progress_rx(ep);
+
+	if (ep->util_ep.tx_cq) {
+		ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+		udpx_flush_txq(ep);
+		ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+	}
+}
+
 static ssize_t udpx_recvmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 			    uint64_t flags)
 {
@@ -391,19 +565,29 @@ udpx_dest_addrlen(struct udpx_ep *ep, fi_addr_t addr, uint64_t flags)
 }
 
 static ssize_t udpx_sendto(struct udpx_ep *ep, const void *buf, size_t len,
-			   const void *addr, size_t addrlen, void *context)
+			   const void *addr, size_t addrlen, void *context,
+			   uint64_t flags)
 {
+	struct iovec iov;
 	ssize_t ret;
 
 	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
-	if (ofi_cirque_isfull(ep->util_ep.tx_cq->cirq)) {
-		ret = -FI_EAGAIN;
+	ret = udpx_tx_reserve(ep);
+	if (ret)
+		goto out;
+
+	if (ep->txq_cnt || (flags & FI_MORE)) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = udpx_queue_tx(ep, &iov, 1, addr, addrlen, context, flags);
 		goto out;
 	}
 
 	ret = ofi_sendto_socket(ep->sock, buf, len, 0,
 				addr, (socklen_t)addrlen);
 	if (ret == (ssize_t)len) {
+		udpx_stats_batch(&ep->stats.tx_batches, &ep->stats.tx_msgs,
+				 &ep->stats.tx_max_batch, 1);
 		ep->tx_comp(ep, context);
 		ret = 0;
 	} else {
@@ -421,7 +605,8 @@ static ssize_t udpx_send(struct fid_ep *ep_fid, const void *buf, size_t len,
 
 	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid.fid);
 	return udpx_sendto(ep, buf, len, ofi_ip_av_get_addr(ep->util_ep.av, (int)dest_addr),
-			   ep->util_ep.av->addrlen, context);
+			   ep->util_ep.av->addrlen, context,
+			   ep->util_ep.tx_op_flags);
 }
 
 static ssize_t udpx_send_mc(struct fid_ep *ep_fid, const void *buf, size_t len,
@@ -432,7 +617,7 @@ static ssize_t udpx_send_mc(struct fid_ep *ep_fid, const void *buf, size_t len,
 	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid.fid);
 	return udpx_sendto(ep, buf, len, (const void *) (uintptr_t) dest_addr,
 			   ofi_sizeofaddr((const void *) (uintptr_t) dest_addr),
-			   context);
+			   context, ep->util_ep.tx_op_flags);
 }
 
 static ssize_t udpx_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
@@ -452,13 +637,21 @@ static ssize_t udpx_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 	hdr.msg_flags = 0;
 
 	ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
-	if (ofi_cirque_isfull(ep->util_ep.tx_cq->cirq)) {
-		ret = -FI_EAGAIN;
+	ret = udpx_tx_reserve(ep);
+	if (ret)
+		goto out;
+
+	if (ep->txq_cnt || (flags & FI_MORE)) {
+		ret = udpx_queue_tx(ep, msg->msg_iov, msg->iov_count,
+				    hdr.msg_name, hdr.msg_namelen,
+				    msg->context, flags);
 		goto out;
 	}
 
 	ret = ofi_sendmsg_udp(ep->sock, &hdr, 0);
 	if (ret >= 0) {
+		udpx_stats_batch(&ep->stats.tx_batches, &ep->stats.tx_msgs,
+				 &ep->stats.tx_max_batch, 1);
 		ep->tx_comp(ep, msg->context);
 		ret = 0;
 	} else {
@@ -473,6 +666,7 @@ static ssize_t udpx_sendv(struct fid_ep *ep_fid, const struct iovec *iov,
 			  void **desc, size_t count, fi_addr_t dest_addr,
 			  void *context)
 {
+	struct udpx_ep *ep;
 	struct fi_msg msg;
 
 	msg.msg_iov = iov;
@@ -480,13 +674,15 @@ static ssize_t udpx_sendv(struct fid_ep *ep_fid, const struct iovec *iov,
 	msg.addr = dest_addr;
 	msg.context = context;
 
-	return udpx_sendmsg(ep_fid, &msg, 0);
+	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid.fid);
+	return udpx_sendmsg(ep_fid, &msg, ep->util_ep.tx_op_flags);
 }
 
 static ssize_t udpx_sendv_mc(struct fid_ep *ep_fid, const struct iovec *iov,
 			     void **desc, size_t count, fi_addr_t dest_addr,
 			     void *context)
 {
+	struct udpx_ep *ep;
 	struct fi_msg msg;
 
 	msg.msg_iov = iov;
@@ -494,7 +690,9 @@ static ssize_t udpx_sendv_mc(struct fid_ep *ep_fid, const struct iovec *iov,
 	msg.addr = dest_addr;
 	msg.context = context;
 
-	return udpx_sendmsg(ep_fid, &msg, FI_MULTICAST);
+	ep = container_of(ep_fid, struct udpx_ep, util_ep.ep_fid.fid);
+	return udpx_sendmsg(ep_fid, &msg,
+			    ep->util_ep.tx_op_flags | FI_MULTICAST);
 }
 
 static ssize_t udpx_inject(struct fid_ep *ep_fid, const void *buf, size_t len,
@@ -560,6 +758,23 @@ static int udpx_ep_close(struct fid *fid)
 		return -FI_EBUSY;
 	}
 
+	if (ep->util_ep.tx_cq) {
+		ofi_genlock_lock(&ep->util_ep.tx_cq->cq_lock);
+		udpx_flush_txq(ep);
+		udpx_cancel_txq(ep);
+		ofi_genlock_unlock(&ep->util_ep.tx_cq->cq_lock);
+		fid_list_remove2(&ep->util_ep.tx_cq->ep_list,
+				 &ep->util_ep.tx_cq->ep_list_lock,
+				 &ep->util_ep.ep_fid.fid);
+	}
+
+	FI_INFO(&udpx_prov, FI_LOG_EP_CTRL, "rx: %" PRIu64 " msgs in %"
+		PRIu64 " batches (max %" PRIu64 "), tx: %" PRIu64 " msgs in %"
+		PRIu64 " batches (max %" PRIu64 ")\n",
+		ep->stats.rx_msgs, ep->stats.rx_batches,
+		ep->stats.rx_max_batch, ep->stats.tx_msgs,
+		ep->stats.tx_batches, ep->stats.tx_max_batch);
+
 	if (ep->util_ep.rx_cq) {
 		if (ep->util_ep.rx_cq->wait) {
 			wait = container_of(ep->util_ep.rx_cq->wait,
@@ -593,6 +808,13 @@ static int udpx_ep_bind_cq(struct udpx_ep *ep, struct util_cq *cq,
 		ofi_atomic_inc32(&cq->ref);
 		ep->tx_comp = cq->wait ? udpx_tx_comp_signal :
 					 udpx_tx_comp;
+
+		/* progress retries sends left queued by a full socket */
+		ret = fid_list_insert2(&cq->ep_list,
+				      &cq->ep_list_lock,
+				      &ep->util_ep.ep_fid.fid);
+		if (ret)
+			return ret;
 	}
 
 	if (flags & FI_RECV) {
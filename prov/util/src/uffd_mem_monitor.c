@@ -86,6 +86,41 @@ static void ofi_uffd_unsubscribe(struct ofi_mem_monitor *monitor,
 				 const void *addr, size_t len,
 				 union ofi_mr_hmem_info *hmem_info);
 
+/* Events read from the userfault fd at once */
+#define OFI_UFFD_MSG_BATCH 32
+
+static void ofi_uffd_handle_event(struct uffd_msg *msg)
+{
+	FI_DBG(&core_prov, FI_LOG_MR, "Received UFFD event %d\n", msg->event);
+
+	switch (msg->event) {
+	case UFFD_EVENT_REMOVE:
+		ofi_uffd_unsubscribe(&uffd.monitor,
+			(void *) (uintptr_t) msg->arg.remove.start,
+			(size_t) (msg->arg.remove.end -
+				  msg->arg.remove.start), NULL);
+		/* fall through */
+	case UFFD_EVENT_UNMAP:
+		ofi_monitor_notify(&uffd.monitor,
+			(void *) (uintptr_t) msg->arg.remove.start,
+			(size_t) (msg->arg.remove.end -
+				  msg->arg.remove.start));
+		break;
+	case UFFD_EVENT_REMAP:
+		ofi_monitor_notify(&uffd.monitor,
+			(void *) (uintptr_t) msg->arg.remap.from,
+			(size_t) msg->arg.remap.len);
+		break;
+	case UFFD_EVENT_PAGEFAULT:
+		ofi_uffd_pagefault_handler(msg);
+		break;
+	default:
+		FI_WARN(&core_prov, FI_LOG_MR,
+			"Unhandled uffd event %d\n", msg->event);
+		break;
+	}
+}
+
 /* The userfault fd monitor requires for events that could
  * trigger it to be handled outside of the monitor functions
  * itself. When a fault occurs on a monitored region, the
@@ -97,9 +132,10 @@ static void ofi_uffd_unsubscribe(struct ofi_mem_monitor *monitor,
  */
 static void *ofi_uffd_handler(void *arg)
 {
-	struct uffd_msg msg;
+	struct uffd_msg msg[OFI_UFFD_MSG_BATCH];
 	struct pollfd fds[2];
-	int ret;
+	ssize_t len;
+	int ret, i;
 
 	fds[0].fd     = uffd.fd;
 	fds[0].events = POLLIN;
@@ -114,10 +150,14 @@ static void *ofi_uffd_handler(void *arg)
 		if (ret < 0 || fds[1].revents)
 			break;
 
+		/* Drain all pending events under one lock acquisition, so
+		 * that a burst of unmaps does not bounce the monitor lock
+		 * between this thread and the registering threads.
+		 */
 		pthread_rwlock_rdlock(&mm_list_rwlock);
 		pthread_mutex_lock(&mm_lock);
-		ret = read(uffd.fd, &msg, sizeof(msg));
-		if (ret != sizeof(msg)) {
+		len = read(uffd.fd, msg, sizeof(msg));
+		if (len < (ssize_t) sizeof(*msg)) {
 			pthread_mutex_unlock(&mm_lock);
 			pthread_rwlock_unlock(&mm_list_rwlock);
 			if (errno != EAGAIN && errno != EINTR)
@@ -125,34 +165,9 @@ static void *ofi_uffd_handler(void *arg)
 			continue;
 		}
 
-		FI_DBG(&core_prov, FI_LOG_MR, "Received UFFD event %d\n", msg.event);
-
-		switch (msg.event) {
-		case UFFD_EVENT_REMOVE:
-			ofi_uffd_unsubscribe(&uffd.monitor,
-				(void *) (uintptr_t) msg.arg.remove.start,
-				(size_t) (msg.arg.remove.end -
-					  msg.arg.remove.start), NULL);
-			/* fall through */
-		case UFFD_EVENT_UNMAP:
-			ofi_monitor_notify(&uffd.monitor,
-				(void *) (uintptr_t) msg.arg.remove.start,
-				(size_t) (msg.arg.remove.end -
-					  msg.arg.remove.start));
-			break;
-		case UFFD_EVENT_REMAP:
-			ofi_monitor_notify(&uffd.monitor,
-				(void *) (uintptr_t) msg.arg.remap.from,
-				(size_t) msg.arg.remap.len);
-			break;
-		case UFFD_EVENT_PAGEFAULT:
-			ofi_uffd_pagefault_handler(&msg);
-			break;
-		default:
-			FI_WARN(&core_prov, FI_LOG_MR,
-				"Unhandled uffd event %d\n", msg.event);
-			break;
-		}
+		for (i = 0; i < len / (ssize_t) sizeof(*msg); i++)
+			ofi_uffd_handle_event(&msg[i]);
+
 		pthread_mutex_unlock(&mm_lock);
 		pthread_rwlock_unlock(&mm_list_rwlock);
 	}
@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ofi_atomic.h"
+
+/*
+ * Non-atomic reduction handlers.
+ *
+ * The ofi_atomic_* handlers update each element with an atomic instruction
+ * or a compare-exchange loop, since the target may be accessed concurrently.
+ * Buffers private to the caller don't need that, so the reduce tables use
+ * plain loops for the arithmetic and bitwise operations on integer and
+ * floating point types, and vector kernels where those are faster.  Every
+ * other op/datatype combination falls back to the matching atomic handler.
+ *
+ * The kernels are written with the GCC/clang vector extensions: 16 byte
+ * vectors map onto SSE2 on x86_64 and NEON on aarch64, the baseline of both.
+ * On x86_64, AVX2 and AVX-512 builds of the same kernels are selected at
+ * runtime when the CPU supports them.
+ */
+
+void (*ofi_reduce_write_handlers[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+	(void *dst, const void *src, size_t cnt);
+void (*ofi_reduce_readwrite_handlers[OFI_READWRITE_OP_CNT][OFI_DATATYPE_CNT])
+	(void *dst, const void *src, void *res, size_t cnt);
+
+#define OFI_SOP_MIN(d, s)	if ((d) > (s)) (d) = (s)
+#define OFI_SOP_MAX(d, s)	if ((d) < (s)) (d) = (s)
+#define OFI_SOP_SUM(d, s)	(d) += (s)
+#define OFI_SOP_PROD(d, s)	(d) *= (s)
+#define OFI_SOP_BOR(d, s)	(d) |= (s)
+#define OFI_SOP_BAND(d, s)	(d) &= (s)
+#define OFI_SOP_BXOR(d, s)	(d) ^= (s)
+
+/*
+ * SCALAR_WRITE and SCALAR_READWRITE: the same operations one element at a
+ * time, without atomics.
+ */
+#define OFI_DEF_REDUCE_SCALAR_WRITE_FUNC(isa, width, op, type, mtype)	\
+	static void ofi_reduce_write_##op##_##type##_##isa		\
+		(void *dst, const void *src, size_t cnt)		\
+	{								\
+		type *d = (dst);					\
+		const type *s = (src);					\
+		size_t i;						\
+									\
+		for (i = 0; i < cnt; i++)				\
+			OFI_SOP_##op(d[i], s[i]);			\
+	}
+
+#define OFI_DEF_REDUCE_SCALAR_READWRITE_FUNC(isa, width, op, type, mtype) \
+	static void ofi_reduce_readwrite_##op##_##type##_##isa		\
+		(void *dst, const void *src, void *res, size_t cnt)	\
+	{								\
+		type *d = (dst);					\
+		const type *s = (src);					\
+		type *r = (res);					\
+		size_t i;						\
+									\
+		for (i = 0; i < cnt; i++) {				\
+			r[i] = d[i];					\
+			OFI_SOP_##op(d[i], s[i]);			\
+		}							\
+	}
+
+#define OFI_DEF_REDUCE_SMALL_FUNCS(kind, isa, width, op)		\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, int8_t, int8_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, uint8_t, int8_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, int16_t, int16_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, uint16_t, int16_t)
+
+#define OFI_DEF_REDUCE_INT_FUNCS(kind, isa, width, op)			\
+	OFI_DEF_REDUCE_SMALL_FUNCS(kind, isa, width, op)		\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, int32_t, int32_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, uint32_t, int32_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, int64_t, int64_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, uint64_t, int64_t)
+
+#define OFI_DEF_REDUCE_ALL_FUNCS(kind, isa, width, op)			\
+	OFI_DEF_REDUCE_INT_FUNCS(kind, isa, width, op)			\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, float, int32_t)	\
+	OFI_DEF_REDUCE_##kind##_FUNC(isa, width, op, double, int64_t)
+
+#define OFI_REDUCE_SMALL_NAMES(kind, isa, op)				\
+	[FI_INT8] = ofi_reduce_##kind##_##op##_int8_t_##isa,		\
+	[FI_UINT8] = ofi_reduce_##kind##_##op##_uint8_t_##isa,		\
+	[FI_INT16] = ofi_reduce_##kind##_##op##_int16_t_##isa,		\
+	[FI_UINT16] = ofi_reduce_##kind##_##op##_uint16_t_##isa,
+
+#define OFI_REDUCE_INT_NAMES(kind, isa, op)				\
+	OFI_REDUCE_SMALL_NAMES(kind, isa, op)				\
+	[FI_INT32] = ofi_reduce_##kind##_##op##_int32_t_##isa,		\
+	[FI_UINT32] = ofi_reduce_##kind##_##op##_uint32_t_##isa,	\
+	[FI_INT64] = ofi_reduce_##kind##_##op##_int64_t_##isa,		\
+	[FI_UINT64] = ofi_reduce_##kind##_##op##_uint64_t_##isa,
+
+#define OFI_REDUCE_ALL_NAMES(kind, isa, op)				\
+	OFI_REDUCE_INT_NAMES(kind, isa, op)				\
+	[FI_FLOAT] = ofi_reduce_##kind##_##op##_float_##isa,		\
+	[FI_DOUBLE] = ofi_reduce_##kind##_##op##_double_##isa,
+
+/*
+ * minmax names the datatypes given MIN and MAX kernels: ALL, INT or SMALL
+ * (8 and 16 bit integers).  Table entries left out keep the scalar loops.
+ */
+#define OFI_DEF_REDUCE_KIND(kind, isa, width, minmax)			\
+	OFI_DEF_REDUCE_##minmax##_FUNCS(kind, isa, width, MIN)		\
+	OFI_DEF_REDUCE_##minmax##_FUNCS(kind, isa, width, MAX)		\
+	OFI_DEF_REDUCE_ALL_FUNCS(kind, isa, width, SUM)			\
+	OFI_DEF_REDUCE_ALL_FUNCS(kind, isa, width, PROD)		\
+	OFI_DEF_REDUCE_INT_FUNCS(kind, isa, width, BOR)			\
+	OFI_DEF_REDUCE_INT_FUNCS(kind, isa, width, BAND)		\
+	OFI_DEF_REDUCE_INT_FUNCS(kind, isa, width, BXOR)
+
+#define OFI_REDUCE_KIND_NAMES(kind, isa, minmax)			\
+	[FI_MIN] = { OFI_REDUCE_##minmax##_NAMES(kind, isa, MIN) },	\
+	[FI_MAX] = { OFI_REDUCE_##minmax##_NAMES(kind, isa, MAX) },	\
+	[FI_SUM] = { OFI_REDUCE_ALL_NAMES(kind, isa, SUM) },		\
+	[FI_PROD] = { OFI_REDUCE_ALL_NAMES(kind, isa, PROD) },		\
+	[FI_BOR] = { OFI_REDUCE_INT_NAMES(kind, isa, BOR) },		\
+	[FI_BAND] = { OFI_REDUCE_INT_NAMES(kind, isa, BAND) },		\
+	[FI_BXOR] = { OFI_REDUCE_INT_NAMES(kind, isa, BXOR) },
+
+#define OFI_DEF_REDUCE_TABLES(isa, minmax)				\
+	static void (*ofi_reduce_write_##isa[OFI_WRITE_OP_CNT]		\
+					    [OFI_DATATYPE_CNT])		\
+		(void *dst, const void *src, size_t cnt) = {		\
+		OFI_REDUCE_KIND_NAMES(write, isa, minmax)		\
+	};								\
+									\
+	static void (*ofi_reduce_readwrite_##isa[OFI_READWRITE_OP_CNT]	\
+						[OFI_DATATYPE_CNT])	\
+		(void *dst, const void *src, void *res, size_t cnt) = {	\
+		OFI_REDUCE_KIND_NAMES(readwrite, isa, minmax)		\
+	};
+
+OFI_DEF_REDUCE_KIND(SCALAR_WRITE, scalar, 0, ALL)
+OFI_DEF_REDUCE_KIND(SCALAR_READWRITE, scalar, 0, ALL)
+OFI_DEF_REDUCE_TABLES(scalar, ALL)
+
+const char *ofi_reduce_simd_isa = "scalar";
+
+static void ofi_reduce_install(
+	void (*write[OFI_WRITE_OP_CNT][OFI_DATATYPE_CNT])
+		(void *dst, const void *src, size_t cnt),
+	void (*readwrite[OFI_READWRITE_OP_CNT][OFI_DATATYPE_CNT])
+		(void *dst, const void *src, void *res, size_t cnt))
+{
+	int op, datatype;
+
+	for (op = 0; op < OFI_WRITE_OP_CNT; op++) {
+		for (datatype = 0; datatype < OFI_DATATYPE_CNT; datatype++) {
+			if (write[op][datatype])
+				ofi_reduce_write_handlers[op][datatype] =
+					write[op][datatype];
+			if (readwrite[op][datatype])
+				ofi_reduce_readwrite_handlers[op][datatype] =
+					readwrite[op][datatype];
+		}
+	}
+}
+
+static void ofi_reduce_install_scalar(void)
+{
+	memcpy(ofi_reduce_write_handlers, ofi_atomic_write_handlers,
+	       sizeof(ofi_reduce_write_handlers));
+	memcpy(ofi_reduce_readwrite_handlers, ofi_atomic_readwrite_handlers,
+	       sizeof(ofi_reduce_readwrite_handlers));
+	ofi_reduce_install(ofi_reduce_write_scalar, ofi_reduce_readwrite_scalar);
+	ofi_reduce_simd_isa = "scalar";
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define HAVE_OFI_REDUCE_SIMD 1
+#endif
+
+#if HAVE_OFI_REDUCE_SIMD
+
+#define OFI_DEF_VEC_TYPES(width)					\
+	typedef int8_t ofi_v##width##_int8_t				\
+		__attribute__((vector_size(width)));			\
+	typedef uint8_t ofi_v##width##_uint8_t				\
+		__attribute__((vector_size(width)));			\
+	typedef int16_t ofi_v##width##_int16_t				\
+		__attribute__((vector_size(width)));			\
+	typedef uint16_t ofi_v##width##_uint16_t			\
+		__attribute__((vector_size(width)));			\
+	typedef int32_t ofi_v##width##_int32_t				\
+		__attribute__((vector_size(width)));			\
+	typedef uint32_t ofi_v##width##_uint32_t			\
+		__attribute__((vector_size(width)));			\
+	typedef int64_t ofi_v##width##_int64_t				\
+		__attribute__((vector_size(width)));			\
+	typedef uint64_t ofi_v##width##_uint64_t			\
+		__attribute__((vector_size(width)));			\
+	typedef float ofi_v##width##_float				\
+		__attribute__((vector_size(width)));			\
+	typedef double ofi_v##width##_double				\
+		__attribute__((vector_size(width)));
+
+/*
+ * Vector ops take the integer mask type matching the element size.  MIN and
+ * MAX select with a compare mask and keep the scalar semantics of only
+ * replacing dst when the comparison holds, which also leaves a NaN in dst.
+ */
+#define OFI_VOP_MIN(mtype, d, s)					\
+	do {								\
+		mtype m = (mtype) ((d) > (s));				\
+		(d) = (__typeof__(d)) (((mtype) (d) & ~m) |		\
+				       ((mtype) (s) & m));		\
+	} while (0)
+#define OFI_VOP_MAX(mtype, d, s)					\
+	do {								\
+		mtype m = (mtype) ((d) < (s));				\
+		(d) = (__typeof__(d)) (((mtype) (d) & ~m) |		\
+				       ((mtype) (s) & m));		\
+	} while (0)
+#define OFI_VOP_SUM(mtype, d, s)	(d) += (s)
+#define OFI_VOP_PROD(mtype, d, s)	(d) *= (s)
+#define OFI_VOP_BOR(mtype, d, s)	(d) |= (s)
+#define OFI_VOP_BAND(mtype, d, s)	(d) &= (s)
+#define OFI_VOP_BXOR(mtype, d, s)	(d) ^= (s)
+
+#define OFI_SIMD_TARGET_v128
+#define OFI_SIMD_TARGET_avx2	__attribute__((__target__("avx2")))
+#define OFI_SIMD_TARGET_avx512	\
+	__attribute__((__target__("avx512f,avx512bw,avx512dq")))
+
+/*
+ * WRITE: d[i] = d[i] op s[i]
+ */
+#define OFI_DEF_REDUCE_WRITE_FUNC(isa, width, op, type, mtype)		\
+	static void OFI_SIMD_TARGET_##isa				\
+	ofi_reduce_write_##op##_##type##_##isa				\
+		(void *dst, const void *src, size_t cnt)		\
+	{								\
+		ofi_v##width##_##type vd, vs;				\
+		type *d = (dst);					\
+		const type *s = (src);					\
+		size_t i = 0;						\
+									\
+		for (; i + width / sizeof(type) <= cnt;			\
+		     i += width / sizeof(type)) {			\
+			memcpy(&vd, &d[i], width);			\
+			memcpy(&vs, &s[i], width);			\
+			OFI_VOP_##op(ofi_v##width##_##mtype, vd, vs);	\
+			memcpy(&d[i], &vd, width);			\
+		}							\
+		for (; i < cnt; i++)					\
+			OFI_SOP_##op(d[i], s[i]);			\
+	}
+
+/*
+ * READWRITE: r[i] = d[i]; d[i] = d[i] op s[i]
+ */
+#define OFI_DEF_REDUCE_READWRITE_FUNC(isa, width, op, type, mtype)	\
+	static void OFI_SIMD_TARGET_##isa				\
+	ofi_reduce_readwrite_##op##_##type##_##isa			\
+		(void *dst, const void *src, void *res, size_t cnt)	\
+	{								\
+		ofi_v##width##_##type vd, vs;				\
+		type *d = (dst);					\
+		const type *s = (src);					\
+		type *r = (res);					\
+		size_t i = 0;						\
+									\
+		for (; i + width / sizeof(type) <= cnt;			\
+		     i += width / sizeof(type)) {			\
+			memcpy(&vd, &d[i], width);			\
+			memcpy(&vs, &s[i], width);			\
+			memcpy(&r[i], &vd, width);			\
+			OFI_VOP_##op(ofi_v##width##_##mtype, vd, vs);	\
+			memcpy(&d[i], &vd, width);			\
+		}							\
+		for (; i < cnt; i++) {					\
+			r[i] = d[i];					\
+			OFI_SOP_##op(d[i], s[i]);			\
+		}							\
+	}
+
+#define OFI_DEF_REDUCE_ISA(isa, width, minmax)				\
+	OFI_DEF_REDUCE_KIND(WRITE, isa, width, minmax)			\
+	OFI_DEF_REDUCE_KIND(READWRITE, isa, width, minmax)		\
+	OFI_DEF_REDUCE_TABLES(isa, minmax)
+
+/*
+ * SSE2 has no 32 and 64 bit min/max.  The compare and select emulating them
+ * is slower than a scalar loop in unoptimized builds, so v128 only handles
+ * MIN and MAX on 8 and 16 bit integers.
+ */
+OFI_DEF_VEC_TYPES(16)
+OFI_DEF_REDUCE_ISA(v128, 16, SMALL)
+
+#if defined(__x86_64__)
+OFI_DEF_VEC_TYPES(32)
+OFI_DEF_REDUCE_ISA(avx2, 32, ALL)
+
+OFI_DEF_VEC_TYPES(64)
+OFI_DEF_REDUCE_ISA(avx512, 64, ALL)
+#endif
+
+/*
+ * Install the kernels for the named instruction set, or the best one the
+ * CPU supports for "auto".  If the set is not available in this build or on
+ * this CPU, the tables are left pointing at the scalar loops.
+ */
+int ofi_reduce_select(const char *isa)
+{
+	ofi_reduce_install_scalar();
+	if (!strcasecmp(isa, "scalar"))
+		return 0;
+
+#if defined(__x86_64__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") &&
+	    __builtin_cpu_supports("avx512bw") &&
+	    __builtin_cpu_supports("avx512dq") &&
+	    (!strcasecmp(isa, "auto") || !strcasecmp(isa, "avx512"))) {
+		ofi_reduce_install(ofi_reduce_write_avx512,
+				   ofi_reduce_readwrite_avx512);
+		ofi_reduce_simd_isa = "avx512";
+		return 0;
+	}
+
+	if (__builtin_cpu_supports("avx2") &&
+	    (!strcasecmp(isa, "auto") || !strcasecmp(isa, "avx2"))) {
+		ofi_reduce_install(ofi_reduce_write_avx2,
+				   ofi_reduce_readwrite_avx2);
+		ofi_reduce_simd_isa = "avx2";
+		return 0;
+	}
+#endif
+
+	if (strcasecmp(isa, "auto") && strcasecmp(isa, "v128"))
+		return -FI_EINVAL;
+
+	ofi_reduce_install(ofi_reduce_write_v128, ofi_reduce_readwrite_v128);
+	ofi_reduce_simd_isa = "v128";
+	return 0;
+}
+
+#else /* HAVE_OFI_REDUCE_SIMD */
+
+int ofi_reduce_select(const char *isa)
+{
+	ofi_reduce_install_scalar();
+	return strcasecmp(isa, "auto") && strcasecmp(isa, "scalar") ?
+	       -FI_EINVAL : 0;
+}
+
+#endif /* HAVE_OFI_REDUCE_SIMD */
@@ -273,13 +273,79 @@ int ofi_verify_av_insert(struct util_av *av, uint64_t flags, void *context)
 	return 0;
 }
 
+/*
+ * Compact AVs skip the reverse lookup hash on insert.  It is built from the
+ * valid entries the first time an address needs to be mapped back to its
+ * fi_addr, after which the AV behaves like any other.  Duplicate addresses
+ * inserted before then keep their own fi_addr but are left out of the hash.
+ */
+static void util_av_build_hash(struct util_av *av)
+{
+	struct util_av_entry *entry, *dup;
+	size_t i, cnt;
+
+	av->flags &= ~OFI_AV_LAZY_HASH;
+	cnt = av->av_entry_pool->region_cnt * av->av_entry_pool->attr.chunk_cnt;
+	for (i = 0; i < cnt; i++) {
+		if (!ofi_bufpool_ibuf_is_valid(av->av_entry_pool, i))
+			continue;
+
+		entry = ofi_bufpool_get_ibuf(av->av_entry_pool, i);
+		HASH_FIND(hh, av->hash, entry->data, av->addrlen, dup);
+		if (dup)
+			entry->hh.tbl = NULL;
+		else
+			HASH_ADD(hh, av->hash, data, av->addrlen, entry);
+	}
+	FI_INFO(av->prov, FI_LOG_AV, "built AV hash, %u entries\n",
+		HASH_COUNT(av->hash));
+}
+
+static struct util_av_entry *
+util_av_alloc_entry(struct util_av *av, const void *addr, unsigned hashv)
+{
+	struct util_av_entry *entry;
+
+	entry = ofi_ibuf_alloc(av->av_entry_pool);
+	if (!entry)
+		return NULL;
+
+	memcpy(entry->data, addr, av->addrlen);
+	ofi_atomic_initialize32(&entry->use_cnt, 1);
+	if (av->flags & OFI_AV_LAZY_HASH)
+		entry->hh.tbl = NULL;
+	else
+		HASH_ADD_KEYPTR_BYHASHVALUE(hh, av->hash, entry->data,
+					    av->addrlen, hashv, entry);
+	return entry;
+}
+
+/* Grow the bucket array once for count new entries rather than doubling
+ * it repeatedly while a large address vector is inserted.
+ */
+static void util_av_hash_reserve(struct util_av *av, size_t count)
+{
+	UT_hash_table *tbl;
+	size_t want;
+	int oomed = 0;
+
+	if (!av->hash)
+		return;
+
+	tbl = av->hash->hh.tbl;
+	want = (tbl->num_items + count) / HASH_BKT_CAPACITY_THRESH;
+	while (tbl->num_buckets < want && !tbl->noexpand && !oomed)
+		HASH_EXPAND_BUCKETS(&av->hash->hh, tbl, oomed);
+}
+
 int ofi_av_insert_addr_at(struct util_av *av, const void *addr, fi_addr_t fi_addr)
 {
 	struct util_av_entry *entry = NULL;
 
 	assert(ofi_genlock_held(&av->lock));
 	ofi_av_straddr_log(av, FI_LOG_INFO, "inserting addr", addr);
-	HASH_FIND(hh, av->hash, addr, av->addrlen, entry);
+	if (!(av->flags & OFI_AV_LAZY_HASH))
+		HASH_FIND(hh, av->hash, addr, av->addrlen, entry);
 	if (entry) {
 		if (fi_addr == ofi_buf_index(entry))
 			return FI_SUCCESS;
@@ -294,7 +360,10 @@ int ofi_av_insert_addr_at(struct util_av *av, const void *addr, fi_addr_t fi_add
 
 	memcpy(entry->data, addr, av->addrlen);
 	ofi_atomic_initialize32(&entry->use_cnt, 1);
-	HASH_ADD(hh, av->hash, data, av->addrlen, entry);
+	if (av->flags & OFI_AV_LAZY_HASH)
+		entry->hh.tbl = NULL;
+	else
+		HASH_ADD(hh, av->hash, data, av->addrlen, entry);
 	FI_INFO(av->prov, FI_LOG_AV, "fi_addr: %" PRIu64 "\n",
 		ofi_buf_index(entry));
 	return 0;
@@ -303,10 +372,15 @@ int ofi_av_insert_addr_at(struct util_av *av, const void *addr, fi_addr_t fi_add
 int ofi_av_insert_addr(struct util_av *av, const void *addr, fi_addr_t *fi_addr)
 {
 	struct util_av_entry *entry = NULL;
+	unsigned hashv = 0;
 
 	assert(ofi_genlock_held(&av->lock));
 	ofi_av_straddr_log(av, FI_LOG_INFO, "inserting addr", addr);
-	HASH_FIND(hh, av->hash, addr, av->addrlen, entry);
+	if (!(av->flags & OFI_AV_LAZY_HASH)) {
+		HASH_VALUE(addr, av->addrlen, hashv);
+		HASH_FIND_BYHASHVALUE(hh, av->hash, addr, av->addrlen,
+				      hashv, entry);
+	}
 	if (entry) {
 		if (fi_addr)
 			*fi_addr = ofi_buf_index(entry);
@@ -314,7 +388,7 @@ int ofi_av_insert_addr(struct util_av *av, const void *addr, fi_addr_t *fi_addr)
 			ofi_av_straddr_log(av, FI_LOG_WARN, "addr already in AV", addr);
 		}
 	} else {
-		entry = ofi_ibuf_alloc(av->av_entry_pool);
+		entry = util_av_alloc_entry(av, addr, hashv);
 		if (!entry) {
 			if (fi_addr)
 				*fi_addr = FI_ADDR_NOTAVAIL;
@@ -323,9 +397,6 @@ int ofi_av_insert_addr(struct util_av *av, const void *addr, fi_addr_t *fi_addr)
 
 		if (fi_addr)
 			*fi_addr = ofi_buf_index(entry);
-		memcpy(entry->data, addr, av->addrlen);
-		ofi_atomic_initialize32(&entry->use_cnt, 1);
-		HASH_ADD(hh, av->hash, data, av->addrlen, entry);
 		FI_INFO(av->prov, FI_LOG_AV, "fi_addr: %" PRIu64 "\n",
 			ofi_buf_index(entry));
 	}
@@ -344,7 +415,8 @@ int ofi_av_remove_addr(struct util_av *av, fi_addr_t fi_addr)
 	if (ofi_atomic_dec32(&av_entry->use_cnt))
 		return FI_SUCCESS;
 
-	HASH_DELETE(hh, av->hash, av_entry);
+	if (av_entry->hh.tbl)
+		HASH_DELETE(hh, av->hash, av_entry);
 	FI_DBG(av->prov, FI_LOG_AV, "av_remove fi_addr: %" PRIu64 "\n", fi_addr);
 	ofi_ibuf_free(av_entry);
 	return 0;
@@ -354,6 +426,9 @@ fi_addr_t ofi_av_lookup_fi_addr_unsafe(struct util_av *av, const void *addr)
 {
 	struct util_av_entry *entry = NULL;
 
+	if (av->flags & OFI_AV_LAZY_HASH)
+		util_av_build_hash(av);
+
 	HASH_FIND(hh, av->hash, addr, av->addrlen, entry);
 	return entry ? ofi_buf_index(entry) : FI_ADDR_NOTAVAIL;
 }
@@ -472,6 +547,8 @@ static int util_av_init(struct util_av *av, const struct fi_av_attr *attr,
 	av->addrlen = util_attr->addrlen;
 	av->context_offset = offset + av->addrlen;
 	av->flags = util_attr->flags | attr->flags;
+	if (ofi_av_compact && attr->type == FI_AV_TABLE)
+		av->flags |= OFI_AV_LAZY_HASH;
 	av->hash = NULL;
 
 	pool_attr.chunk_cnt = orig_size;
@@ -591,10 +668,9 @@ static int ip_av_insert_addr(struct util_av *av, const void *addr,
 {
 	int ret;
 
+	assert(ofi_genlock_held(&av->lock));
 	if (ofi_valid_dest_ipaddr(addr)) {
-		ofi_genlock_lock(&av->lock);
 		ret = ofi_av_insert_addr(av, addr, fi_addr);
-		ofi_genlock_unlock(&av->lock);
 	} else {
 		ret = -FI_EADDRNOTAVAIL;
 		if (fi_addr)
@@ -638,6 +714,10 @@ int ofi_ip_av_insertv(struct util_av *av, const void *addr, size_t addrlen,
 		memset(sync_err, 0, sizeof(*sync_err) * count);
 	}
 
+	ofi_genlock_lock(&av->lock);
+	if (!(av->flags & OFI_AV_LAZY_HASH))
+		util_av_hash_reserve(av, count);
+
 	for (i = 0; i < count; i++) {
 		ret = ip_av_insert_addr(av, (const char *) addr + i * addrlen,
 					fi_addr ? &fi_addr[i] : NULL, context);
@@ -645,7 +725,12 @@ int ofi_ip_av_insertv(struct util_av *av, const void *addr, size_t addrlen,
 			success_cnt++;
 		else if (sync_err)
 			sync_err[i] = -ret;
+
+		/* the table exists once the first entry is in */
+		if (!i && count > 1 && !(av->flags & OFI_AV_LAZY_HASH))
+			util_av_hash_reserve(av, count - 1);
 	}
+	ofi_genlock_unlock(&av->lock);
 
 done:
 	FI_DBG(av->prov, FI_LOG_AV, "%d addresses successful\n", success_cnt);
@@ -42,22 +42,28 @@
 #ifdef HAVE_FABRIC_PROFILE
 #include <ofi_profile.h>
 static inline void
-ofi_bufpool_track_mem(size_t size)
+ofi_bufpool_track_mem(int64_t size)
 {
-	ofi_prof_inc_sys_var(FI_VAR_OFI_MEM, (int64_t)size);
+	ofi_prof_inc_sys_var(FI_VAR_OFI_MEM, size);
 };
 #else
 static inline void
-ofi_bufpool_track_mem(size_t size)
+ofi_bufpool_track_mem(int64_t size)
 {
 	OFI_UNUSED(size);
 };
 #endif
 
 enum {
-	OFI_BUFPOOL_REGION_CHUNK_CNT = 16
+	OFI_BUFPOOL_REGION_CHUNK_CNT = 16,
+	OFI_BUFPOOL_MAG_CNT = 16,
+	OFI_BUFPOOL_MAG_DEPTH = 32,
 };
 
+static pthread_mutex_t ofi_bufpool_thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int ofi_bufpool_thread_cnt;
+static OFI_THREAD_LOCAL int ofi_bufpool_thread_idx = -1;
+
 
 static int ofi_bufpool_region_alloc(struct ofi_bufpool_region *buf_region)
 {
@@ -167,6 +173,15 @@ int ofi_bufpool_grow(struct ofi_bufpool *pool)
 
 	mem_allocated += buf_region->pool->alloc_size;
 
+	/* Must precede the first touch of the pages */
+	if ((pool->attr.flags & OFI_BUFPOOL_NUMA_LOCAL) &&
+	    (buf_region->flags & (OFI_BUFPOOL_HUGEPAGES | OFI_BUFPOOL_NONSHARED))) {
+		ret = ofi_mbind_local(buf_region->alloc_region, pool->alloc_size);
+		if (ret)
+			FI_DBG(&core_prov, FI_LOG_CORE, "mbind failed: %s\n",
+			       fi_strerror(-ret));
+	}
+
 	if (!(pool->attr.flags & OFI_BUFPOOL_NO_ZERO))
 		memset(buf_region->alloc_region, 0, pool->alloc_size);
 	buf_region->mem_region = buf_region->alloc_region + pool->entry_size;
@@ -238,11 +253,235 @@ err1:
 	return ret;
 }
 
+static bool ofi_bufpool_region_idle(struct ofi_bufpool *pool,
+				    struct ofi_bufpool_region *buf_region)
+{
+	struct ofi_bufpool_hdr *buf_hdr;
+	struct dlist_entry *item;
+	struct slist_entry *entry;
+	size_t free_cnt = 0;
+
+	if (pool->attr.flags & OFI_BUFPOOL_INDEXED) {
+		dlist_foreach(&buf_region->free_list, item)
+			free_cnt++;
+	} else {
+		for (entry = pool->free_list.entries.head; entry;
+		     entry = entry->next) {
+			buf_hdr = container_of(entry, struct ofi_bufpool_hdr,
+					       entry.slist);
+			if (buf_hdr->region == buf_region)
+				free_cnt++;
+		}
+	}
+	return free_cnt == pool->attr.chunk_cnt;
+}
+
+static void ofi_bufpool_region_unlink(struct ofi_bufpool *pool,
+				      struct ofi_bufpool_region *buf_region)
+{
+	struct ofi_bufpool_hdr *buf_hdr;
+	struct slist_entry *entry, *prev = NULL;
+
+	if (pool->attr.flags & OFI_BUFPOOL_INDEXED) {
+		dlist_remove(&buf_region->entry);
+		return;
+	}
+
+	entry = pool->free_list.entries.head;
+	while (entry) {
+		buf_hdr = container_of(entry, struct ofi_bufpool_hdr,
+				       entry.slist);
+		if (buf_hdr->region != buf_region) {
+			prev = entry;
+			entry = entry->next;
+			continue;
+		}
+		slist_remove(&pool->free_list.entries, entry, prev);
+		entry = prev ? prev->next : pool->free_list.entries.head;
+	}
+}
+
+static void ofi_bufpool_mag_flush(struct ofi_bufpool *pool,
+				  struct ofi_bufpool_mag *mag, size_t cnt)
+{
+	size_t i;
+
+	ofi_spin_lock(&pool->lock);
+	for (i = 0; i < cnt; i++)
+		slist_insert_head(&mag->bufs[i]->entry.slist,
+				  &pool->free_list.entries);
+	ofi_spin_unlock(&pool->lock);
+
+	mag->cnt -= cnt;
+	memmove(mag->bufs, &mag->bufs[cnt], mag->cnt * sizeof(*mag->bufs));
+}
+
+/*
+ * Release the trailing regions of the pool that have no buffers in use.
+ * Only trailing regions are released so that buffer indices, which are
+ * derived from the region position, remain valid.  Returns the number of
+ * regions released.
+ */
+size_t ofi_bufpool_shrink(struct ofi_bufpool *pool)
+{
+	struct ofi_bufpool_region *buf_region;
+	size_t i, cnt = 0;
+
+	if (pool->attr.flags & OFI_BUFPOOL_THREAD_CACHE) {
+		for (i = 0; i < OFI_BUFPOOL_MAG_CNT; i++) {
+			ofi_spin_lock(&pool->mags[i].lock);
+			ofi_bufpool_mag_flush(pool, &pool->mags[i],
+					      pool->mags[i].cnt);
+			ofi_spin_unlock(&pool->mags[i].lock);
+		}
+		ofi_spin_lock(&pool->lock);
+	}
+
+	while (pool->region_cnt) {
+		buf_region = pool->region_table[pool->region_cnt - 1];
+		if (!ofi_bufpool_region_idle(pool, buf_region))
+			break;
+
+		ofi_bufpool_region_unlink(pool, buf_region);
+		if (pool->attr.free_fn)
+			pool->attr.free_fn(buf_region);
+
+		ofi_bufpool_region_free(buf_region);
+		free(buf_region);
+
+		pool->region_table[--pool->region_cnt] = NULL;
+		pool->entry_cnt -= pool->attr.chunk_cnt;
+		ofi_bufpool_track_mem(-(int64_t) pool->alloc_size);
+		cnt++;
+	}
+
+	if (pool->attr.flags & OFI_BUFPOOL_THREAD_CACHE)
+		ofi_spin_unlock(&pool->lock);
+
+	FI_DBG(&core_prov, FI_LOG_CORE, "%s pool %p released %zu regions\n",
+	       __func__, pool, cnt);
+	return cnt;
+}
+
+static struct ofi_bufpool_mag *ofi_bufpool_thread_mag(struct ofi_bufpool *pool)
+{
+	if (OFI_UNLIKELY(ofi_bufpool_thread_idx < 0)) {
+		pthread_mutex_lock(&ofi_bufpool_thread_lock);
+		ofi_bufpool_thread_idx = (int) (ofi_bufpool_thread_cnt++ %
+						OFI_BUFPOOL_MAG_CNT);
+		pthread_mutex_unlock(&ofi_bufpool_thread_lock);
+	}
+	return &pool->mags[ofi_bufpool_thread_idx];
+}
+
+static void ofi_bufpool_mag_refill(struct ofi_bufpool *pool,
+				   struct ofi_bufpool_mag *mag)
+{
+	struct ofi_bufpool_hdr *buf_hdr;
+	size_t cnt = pool->attr.cache_depth / 2;
+
+	ofi_spin_lock(&pool->lock);
+	while (mag->cnt < cnt) {
+		if (ofi_bufpool_empty(pool) && ofi_bufpool_grow(pool))
+			break;
+
+		slist_remove_head_container(&pool->free_list.entries,
+					    struct ofi_bufpool_hdr, buf_hdr,
+					    entry.slist);
+		mag->bufs[mag->cnt++] = buf_hdr;
+	}
+	ofi_spin_unlock(&pool->lock);
+}
+
+void *ofi_buf_alloc_cached(struct ofi_bufpool *pool)
+{
+	struct ofi_bufpool_hdr *buf_hdr;
+	struct ofi_bufpool_mag *mag;
+
+	mag = ofi_bufpool_thread_mag(pool);
+	ofi_spin_lock(&mag->lock);
+	if (!mag->cnt) {
+		ofi_bufpool_mag_refill(pool, mag);
+		if (!mag->cnt) {
+			ofi_spin_unlock(&mag->lock);
+			return NULL;
+		}
+	}
+	buf_hdr = mag->bufs[--mag->cnt];
+	ofi_spin_unlock(&mag->lock);
+
+	assert(ofi_atomic_inc32(&buf_hdr->region->use_cnt));
+	assert(!ofi_buf_is_valid(ofi_buf_data(buf_hdr)));
+
+	buf_hdr->entry.slist.next = &buf_hdr->entry.slist;
+	return ofi_buf_data(buf_hdr);
+}
+
+void ofi_buf_free_cached(struct ofi_bufpool *pool, void *buf)
+{
+	struct ofi_bufpool_hdr *buf_hdr = ofi_buf_hdr(buf);
+	struct ofi_bufpool_mag *mag;
+
+	mag = ofi_bufpool_thread_mag(pool);
+	ofi_spin_lock(&mag->lock);
+	/* keep the most recently freed, cache hot, buffers */
+	if (mag->cnt == pool->attr.cache_depth)
+		ofi_bufpool_mag_flush(pool, mag, pool->attr.cache_depth / 2);
+
+	buf_hdr->entry.slist.next = NULL;
+	mag->bufs[mag->cnt++] = buf_hdr;
+	ofi_spin_unlock(&mag->lock);
+}
+
+static int ofi_bufpool_cache_init(struct ofi_bufpool *pool)
+{
+	struct ofi_bufpool_hdr **bufs;
+	int i;
+
+	if (!pool->attr.cache_depth)
+		pool->attr.cache_depth = OFI_BUFPOOL_MAG_DEPTH;
+	pool->attr.cache_depth = MAX(pool->attr.cache_depth, 2);
+
+	pool->mags = calloc(OFI_BUFPOOL_MAG_CNT, sizeof(*pool->mags));
+	if (!pool->mags)
+		return -FI_ENOMEM;
+
+	bufs = calloc(OFI_BUFPOOL_MAG_CNT * pool->attr.cache_depth,
+		      sizeof(*bufs));
+	if (!bufs) {
+		free(pool->mags);
+		return -FI_ENOMEM;
+	}
+
+	ofi_spin_init(&pool->lock);
+	for (i = 0; i < OFI_BUFPOOL_MAG_CNT; i++) {
+		ofi_spin_init(&pool->mags[i].lock);
+		pool->mags[i].bufs = bufs + i * pool->attr.cache_depth;
+	}
+	return 0;
+}
+
+static void ofi_bufpool_cache_cleanup(struct ofi_bufpool *pool)
+{
+	int i;
+
+	for (i = 0; i < OFI_BUFPOOL_MAG_CNT; i++)
+		ofi_spin_destroy(&pool->mags[i].lock);
+	ofi_spin_destroy(&pool->lock);
+	free(pool->mags[0].bufs);
+	free(pool->mags);
+}
+
 int ofi_bufpool_create_attr(struct ofi_bufpool_attr *attr,
 			      struct ofi_bufpool **buf_pool)
 {
 	struct ofi_bufpool *pool;
 	size_t entry_sz;
+	int ret;
+
+	if ((attr->flags & OFI_BUFPOOL_THREAD_CACHE) &&
+	    (attr->flags & OFI_BUFPOOL_INDEXED))
+		return -FI_EINVAL;
 
 	pool = calloc(1, sizeof(**buf_pool));
 	if (!pool)
@@ -250,6 +489,14 @@ int ofi_bufpool_create_attr(struct ofi_bufpool_attr *attr,
 
 	pool->attr = *attr;
 
+	if (pool->attr.flags & OFI_BUFPOOL_THREAD_CACHE) {
+		ret = ofi_bufpool_cache_init(pool);
+		if (ret) {
+			free(pool);
+			return ret;
+		}
+	}
+
 	entry_sz = (attr->size + sizeof(struct ofi_bufpool_hdr));
 	OFI_DBG_ADD(entry_sz, sizeof(struct ofi_bufpool_ftr));
 	if (!attr->alignment)
@@ -269,6 +516,15 @@ int ofi_bufpool_create_attr(struct ofi_bufpool_attr *attr,
 	pool->alloc_size = (pool->attr.chunk_cnt + 1) * pool->entry_size;
 	pool->region_size = pool->alloc_size - pool->entry_size;
 
+	/* Node placement is applied to page aligned, mmapped regions.
+	 * Mapping a region smaller than a page rounds it up to a whole
+	 * page, so such pools stay on the heap without a node binding.
+	 */
+	if ((pool->attr.flags & OFI_BUFPOOL_NUMA_LOCAL) &&
+	    !(pool->attr.flags & OFI_BUFPOOL_HUGEPAGES) &&
+	    pool->alloc_size >= page_sizes[OFI_PAGE_SIZE])
+		pool->attr.flags |= OFI_BUFPOOL_NONSHARED;
+
 	FI_DBG(&core_prov, FI_LOG_CORE,
 		"%s alloc_size %zu region_size %zu align_entry %zu "
 		"entry_size %zu chunk_cnt %ld pool %p  (%p)\n",
@@ -295,6 +551,8 @@ void ofi_bufpool_destroy(struct ofi_bufpool *pool)
 		ofi_bufpool_region_free(buf_region);
 		free(buf_region);
 	}
+	if (pool->attr.flags & OFI_BUFPOOL_THREAD_CACHE)
+		ofi_bufpool_cache_cleanup(pool);
 	free(pool->region_table);
 	free(pool);
 }
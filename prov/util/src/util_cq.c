@@ -42,16 +42,44 @@
 /* While the CQ is full, we continue to add new entries to the auxiliary
  * queue.
  */
-static void util_cq_insert_aux(struct util_cq *cq,
+static int util_cq_insert_aux(struct util_cq *cq,
 			      struct util_cq_aux_entry *entry)
 {
+	struct util_cq_aux_entry *tail_entry;
+	struct fi_cq_tagged_entry *tail;
+
 	assert(ofi_genlock_held(&cq->cq_lock));
-	if (!ofi_cirque_isfull(cq->cirq))
+	if (!ofi_cirque_isfull(cq->cirq)) {
 		ofi_cirque_commit(cq->cirq);
+	} else if (!(ofi_cirque_tail(cq->cirq)->flags & UTIL_FLAG_AUX)) {
+		/* Providers that write the cirq directly can fill every
+		 * slot.  Move the completion in the last one to the
+		 * auxiliary queue before the slot is marked.
+		 */
+		tail_entry = calloc(1, sizeof(*tail_entry));
+		if (!tail_entry)
+			return -FI_ENOMEM;
+
+		tail = ofi_cirque_tail(cq->cirq);
+		tail_entry->comp.op_context = tail->op_context;
+		tail_entry->comp.flags = tail->flags;
+		tail_entry->comp.len = tail->len;
+		tail_entry->comp.buf = tail->buf;
+		tail_entry->comp.data = tail->data;
+		tail_entry->comp.tag = tail->tag;
+		tail_entry->src = cq->src ? cq->src[ofi_cirque_tindex(cq->cirq)] :
+					    FI_ADDR_NOTAVAIL;
+		tail_entry->cq_slot = tail;
+		slist_insert_tail(&tail_entry->list_entry, &cq->aux_queue);
+	}
 
 	entry->cq_slot = ofi_cirque_tail(cq->cirq);
 	entry->cq_slot->flags = UTIL_FLAG_AUX;
 	slist_insert_tail(&entry->list_entry, &cq->aux_queue);
+	if (cq->ring)
+		ofi_atomic_store_explicit32(&cq->ring_spill, 1,
+					    memory_order_relaxed);
+	return 0;
 }
 
 int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
@@ -59,6 +87,7 @@ int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 			  fi_addr_t src)
 {
 	struct util_cq_aux_entry *entry;
+	int ret;
 
 	assert(ofi_genlock_held(&cq->cq_lock));
 	FI_DBG(cq->domain->prov, FI_LOG_CQ, "writing to CQ overflow list\n");
@@ -77,15 +106,18 @@ int ofi_cq_write_overflow(struct util_cq *cq, void *context, uint64_t flags,
 	entry->comp.err = 0;
 	entry->src = src;
 
-	util_cq_insert_aux(cq, entry);
-	return 0;
+	ret = util_cq_insert_aux(cq, entry);
+	if (ret)
+		free(entry);
+	return ret;
 }
 
-static int util_cq_insert_error(struct util_cq *cq,
-				const struct fi_cq_err_entry *err_entry)
+int ofi_cq_insert_error(struct util_cq *cq,
+			const struct fi_cq_err_entry *err_entry)
 {
 	struct util_cq_aux_entry *entry;
 	void *err_data;
+	int ret;
 
 	assert(ofi_genlock_held(&cq->cq_lock));
 	assert(err_entry->err);
@@ -106,8 +138,13 @@ static int util_cq_insert_error(struct util_cq *cq,
 		entry->comp.err_data = err_data;
 	}
 
-	util_cq_insert_aux(cq, entry);
-	return 0;
+	ret = util_cq_insert_aux(cq, entry);
+	if (ret) {
+		if (err_entry->err_data_size)
+			free(entry->comp.err_data);
+		free(entry);
+	}
+	return ret;
 }
 
 int ofi_cq_write_error(struct util_cq *cq,
@@ -116,7 +153,7 @@ int ofi_cq_write_error(struct util_cq *cq,
 	int ret;
 
 	ofi_genlock_lock(&cq->cq_lock);
-	ret = util_cq_insert_error(cq, err_entry);
+	ret = ofi_cq_insert_error(cq, err_entry);
 	ofi_genlock_unlock(&cq->cq_lock);
 
 	if (cq->wait)
@@ -296,7 +333,9 @@ ssize_t ofi_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 		cq->err_data = NULL;
 	}
 
-	if (ofi_cirque_isempty(cq->cirq) ||
+	/* Completions still in the ring precede the error */
+	if ((cq->ring && !util_cq_ring_isempty(cq->ring)) ||
+	    ofi_cirque_isempty(cq->cirq) ||
 	    !(ofi_cirque_head(cq->cirq)->flags & UTIL_FLAG_AUX)) {
 		ret = -FI_EAGAIN;
 		goto unlock;
@@ -342,6 +381,7 @@ ssize_t ofi_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 		if (aux_entry->cq_slot != ofi_cirque_head(cq->cirq))
 			ofi_cirque_discard(cq->cirq);
 	}
+	util_cq_ring_check_spill(cq);
 
 	ret = 1;
 unlock:
@@ -423,6 +463,7 @@ static void util_peer_cq_cleanup(struct util_cq *cq)
 		free(err);
 	}
 
+	free(cq->ring);
 	util_comp_cirq_free(cq->cirq);
 	free(cq->src);
 	fi_close(&cq->peer_cq->fid);
@@ -536,7 +577,12 @@ static ssize_t util_peer_cq_write(struct fid_peer_cq *cq, void *context,
 	struct util_cq *util_cq = cq->fid.context;
 	int ret;
 
-	util_cq = cq->fid.context;
+	if (util_cq->ring && !ofi_cq_ring_write(util_cq, context, flags, len,
+						buf, data, tag,
+						FI_ADDR_NOTAVAIL)) {
+		ret = 0;
+		goto signal;
+	}
 
 	ofi_genlock_lock(&util_cq->cq_lock);
 	if (ofi_cirque_freecnt(util_cq->cirq) > 1) {
@@ -549,6 +595,7 @@ static ssize_t util_peer_cq_write(struct fid_peer_cq *cq, void *context,
 	}
 	ofi_genlock_unlock(&util_cq->cq_lock);
 
+signal:
 	if (util_cq->wait)
 		util_cq->wait->signal(util_cq->wait);
 
@@ -562,6 +609,12 @@ static ssize_t util_peer_cq_write_src(struct fid_peer_cq *cq, void *context,
 	struct util_cq *util_cq = cq->fid.context;
 	int ret;
 
+	if (util_cq->ring && !ofi_cq_ring_write(util_cq, context, flags, len,
+						buf, data, tag, src)) {
+		ret = 0;
+		goto signal;
+	}
+
 	ofi_genlock_lock(&util_cq->cq_lock);
 	if (ofi_cirque_freecnt(util_cq->cirq) > 1) {
 		ofi_cq_write_src_entry(util_cq, context, flags, len, buf, data,
@@ -573,6 +626,7 @@ static ssize_t util_peer_cq_write_src(struct fid_peer_cq *cq, void *context,
 	}
 	ofi_genlock_unlock(&util_cq->cq_lock);
 
+signal:
 	if (util_cq->wait)
 		util_cq->wait->signal(util_cq->wait);
 
@@ -586,7 +640,7 @@ static ssize_t util_peer_cq_writeerr(struct fid_peer_cq *cq,
 	int ret;
 
 	ofi_genlock_lock(&util_cq->cq_lock);
-	ret = util_cq_insert_error(util_cq, err_entry);
+	ret = ofi_cq_insert_error(util_cq, err_entry);
 	ofi_genlock_unlock(&util_cq->cq_lock);
 
 	if (util_cq->wait)
@@ -644,6 +698,48 @@ static struct fi_ops util_peer_cq_fi_ops = {
 	.ops_open = fi_no_ops_open,
 };
 
+int ofi_cq_init_ring(struct util_cq *cq, enum util_cq_ring_type type)
+{
+	struct util_cq_ring *ring = NULL;
+	int64_t i;
+
+	assert(!cq->ring || util_cq_ring_isempty(cq->ring));
+	if (type != UTIL_CQ_RING_NONE) {
+		ring = calloc(1, sizeof(*ring) + sizeof(ring->entry[0]) *
+			      cq->cirq->size);
+		if (!ring)
+			return -FI_ENOMEM;
+
+		ring->type = type;
+		ring->size = cq->cirq->size;
+		ring->size_mask = cq->cirq->size_mask;
+		ofi_atomic_initialize64(&ring->reserve, 0);
+		ofi_atomic_initialize64(&ring->tail, 0);
+		ofi_atomic_initialize64(&ring->head, 0);
+		for (i = 0; i < ring->size; i++)
+			ring->entry[i].src = FI_ADDR_NOTAVAIL;
+	}
+
+	free(cq->ring);
+	cq->ring = ring;
+	ofi_atomic_initialize32(&cq->ring_spill, 0);
+	return 0;
+}
+
+/* A CQ written by a progress thread while the application reads it would
+ * bounce cq_lock between them on every completion.  Let writers go through
+ * the lock-free ring instead.  Any thread may write, so default to MPSC;
+ * providers that serialize all writes can switch to SPSC.
+ */
+static enum util_cq_ring_type util_cq_ring_type(struct util_cq *cq)
+{
+	if (cq->cq_lock.lock_type == OFI_LOCK_NOOP ||
+	    cq->domain->data_progress != FI_PROGRESS_AUTO)
+		return UTIL_CQ_RING_NONE;
+
+	return UTIL_CQ_RING_MPSC;
+}
+
 static int util_init_peer_cq(struct util_cq *cq, struct fi_cq_attr *attr)
 {
 	int ret;
@@ -692,6 +788,13 @@ static int util_init_peer_cq(struct util_cq *cq, struct fi_cq_attr *attr)
 		cq->peer_cq->owner_ops = &util_peer_cq_owner_ops;
 	}
 
+	ret = ofi_cq_init_ring(cq, util_cq_ring_type(cq));
+	if (ret) {
+		util_comp_cirq_free(cq->cirq);
+		free(cq->src);
+		goto free;
+	}
+
 	cq->peer_cq->fid.fclass = FI_CLASS_PEER_CQ;
 	cq->peer_cq->fid.context = cq;
 	cq->peer_cq->fid.ops = &util_peer_cq_fi_ops;
@@ -725,6 +828,8 @@ int ofi_cq_init(const struct fi_provider *prov, struct fid_domain *domain,
 	cq->domain = container_of(domain, struct util_domain, domain_fid);
 	ofi_atomic_initialize32(&cq->ref, 0);
 	ofi_atomic_initialize32(&cq->wakeup, 0);
+	ofi_atomic_initialize32(&cq->ring_spill, 0);
+	cq->ring = NULL;
 	dlist_init(&cq->ep_list);
 
 	if (cq->domain->threading == FI_THREAD_COMPLETION ||
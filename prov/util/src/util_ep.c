@@ -316,3 +316,121 @@ int ofi_endpoint_close(struct util_ep *util_ep)
 	ofi_genlock_destroy(&util_ep->lock);
 	return 0;
 }
+
+int ofi_conn_warmup_init(struct util_ep *ep, ofi_conn_warmup_func connect,
+			 const fi_addr_t *addr, size_t count,
+			 size_t max_inflight, int timeout, void *context,
+			 struct util_conn_warmup **warmup)
+{
+	struct util_conn_warmup *wu;
+	size_t i, slot_cnt;
+
+	if (!ep->eq)
+		return -FI_ENOEQ;
+
+	if (!ep->av || !addr || !count)
+		return -FI_EINVAL;
+
+	slot_cnt = max_inflight ? MIN(max_inflight, count) : count;
+	wu = calloc(1, sizeof(*wu) + sizeof(*wu->slot) * slot_cnt);
+	if (!wu)
+		return -FI_ENOMEM;
+
+	wu->addr = mem_dup(addr, sizeof(*addr) * count);
+	if (!wu->addr) {
+		free(wu);
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < slot_cnt; i++)
+		wu->slot[i].addr = FI_ADDR_NOTAVAIL;
+
+	dlist_init(&wu->entry);
+	wu->ep = ep;
+	wu->connect = connect;
+	wu->context = context;
+	wu->timeout = timeout;
+	wu->count = count;
+	wu->slot_cnt = slot_cnt;
+	*warmup = wu;
+	return 0;
+}
+
+void ofi_conn_warmup_free(struct util_conn_warmup *warmup)
+{
+	free(warmup->addr);
+	free(warmup);
+}
+
+static void ofi_conn_warmup_complete(struct util_conn_warmup *warmup)
+{
+	struct fi_eq_err_entry err_entry = {0};
+	struct fi_eq_entry entry = {0};
+	ssize_t ret;
+
+	if (warmup->err) {
+		err_entry.fid = &warmup->ep->ep_fid.fid;
+		err_entry.context = warmup->context;
+		err_entry.data = warmup->connected;
+		err_entry.err = -warmup->err;
+		ret = ofi_eq_write(&warmup->ep->eq->eq_fid, FI_NOTIFY,
+				   &err_entry, sizeof(err_entry),
+				   UTIL_FLAG_ERROR);
+	} else {
+		entry.fid = &warmup->ep->ep_fid.fid;
+		entry.context = warmup->context;
+		entry.data = warmup->connected;
+		ret = ofi_eq_write(&warmup->ep->eq->eq_fid, FI_NOTIFY,
+				   &entry, sizeof(entry), 0);
+	}
+
+	if (ret < 0)
+		FI_WARN(warmup->ep->domain->prov, FI_LOG_EP_CTRL,
+			"unable to report connection warm-up: %s\n",
+			fi_strerror((int) -ret));
+}
+
+bool ofi_conn_warmup_progress(struct util_conn_warmup *warmup)
+{
+	struct util_conn_warmup_slot *slot;
+	size_t i;
+	ssize_t ret;
+
+	for (i = 0; i < warmup->slot_cnt; i++) {
+		slot = &warmup->slot[i];
+		while (slot->addr != FI_ADDR_NOTAVAIL ||
+		       warmup->next < warmup->count) {
+			if (slot->addr == FI_ADDR_NOTAVAIL) {
+				slot->addr = warmup->addr[warmup->next++];
+				slot->endtime = ofi_timeout_time(warmup->timeout);
+			}
+
+			ret = warmup->connect(warmup->ep, slot->addr);
+			if (ret == -FI_EAGAIN) {
+				if (warmup->timeout < 0 ||
+				    ofi_gettime_ms() < slot->endtime)
+					break;
+				ret = -FI_ETIMEDOUT;
+			}
+
+			if (ret) {
+				FI_INFO(warmup->ep->domain->prov,
+					FI_LOG_EP_CTRL,
+					"warm-up of fi_addr %" PRIu64
+					" failed: %s\n", slot->addr,
+					fi_strerror((int) -ret));
+				warmup->err = (int) ret;
+			} else {
+				warmup->connected++;
+			}
+			warmup->done++;
+			slot->addr = FI_ADDR_NOTAVAIL;
+		}
+	}
+
+	if (warmup->done < warmup->count)
+		return false;
+
+	ofi_conn_warmup_complete(warmup);
+	return true;
+}
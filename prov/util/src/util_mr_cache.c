@@ -51,6 +51,91 @@ struct ofi_mr_cache_params cache_params = {
 	.ze_monitor_enabled = true,
 };
 
+/* Idle regions evicted at once when the cache is full, so a full cache
+ * does not go through the monitor lock on every registration.
+ */
+#define OFI_MR_CACHE_EVICT_BATCH 16
+
+/* Last entry found by this thread.  It is only used while the generation
+ * of its cache is unchanged, which guarantees it has not left the tree.
+ * Generations start from a per-cache epoch in the upper 32 bits so that a
+ * new cache allocated at the address of a closed one never matches stale
+ * entries.  Caches set up outside of ofi_mr_cache_init() have no epoch and
+ * always go through the tree.
+ *
+ * Where the compiler provides atomics, a hit on this entry takes no lock;
+ * see util_mr_hit_lockless().  Such hits are added to the cache statistics
+ * the next time this thread holds tree_lock of the same cache.
+ */
+static OFI_THREAD_LOCAL struct {
+	struct ofi_mr_cache	*cache;
+	struct ofi_mr_entry	*entry;
+	uint64_t		gen;
+	size_t			hit_cnt;
+} mr_last_hit;
+
+static uint64_t mr_cache_epoch;
+
+/* Use counts are changed with compare-and-swap, since lockless hits take
+ * references without tree_lock.  Entries that are free, being freed or
+ * not yet fully created have a count of OFI_MR_ENTRY_FREED, which lockless
+ * hits never move from.  Idle entries stay on the LRU list when taken by
+ * a lockless hit; whoever next handles them under tree_lock skips or
+ * relinks them.
+ */
+#define OFI_MR_ENTRY_FREED	(-1)
+
+#ifdef HAVE_BUILTIN_ATOMICS
+#define OFI_MR_LOCKLESS_HIT 1
+#define util_mr_load_cnt(entry) \
+	ofi_atomic_load_explicit(32, &(entry)->use_cnt, memory_order_acquire)
+#define util_mr_cas_cnt(entry, cnt, new_cnt) \
+	ofi_atomic_cas_bool(32, &(entry)->use_cnt, cnt, new_cnt)
+#define util_mr_set_cnt(entry, cnt) \
+	ofi_atomic_store_explicit(32, &(entry)->use_cnt, cnt, memory_order_release)
+#define util_mr_load_gen(cache) \
+	ofi_atomic_load_explicit(64, &(cache)->gen, memory_order_acquire)
+#define util_mr_inc_gen(cache) ofi_atomic_add_and_fetch(64, &(cache)->gen, 1)
+#else
+#define OFI_MR_LOCKLESS_HIT 0
+#define util_mr_load_cnt(entry) ((entry)->use_cnt)
+#define util_mr_cas_cnt(entry, cnt, new_cnt) \
+	((entry)->use_cnt == (cnt) ? ((entry)->use_cnt = (new_cnt), true) : false)
+#define util_mr_set_cnt(entry, cnt) ((entry)->use_cnt = (cnt))
+#define util_mr_load_gen(cache) ((cache)->gen)
+#define util_mr_inc_gen(cache) ((cache)->gen++)
+#endif
+
+static bool util_mr_entry_get(struct ofi_mr_entry *entry)
+{
+	int cnt;
+
+	do {
+		cnt = util_mr_load_cnt(entry);
+		if (cnt == OFI_MR_ENTRY_FREED)
+			return false;
+	} while (!util_mr_cas_cnt(entry, cnt, cnt + 1));
+	return true;
+}
+
+/* Returns the remaining count */
+static int util_mr_entry_put(struct ofi_mr_entry *entry)
+{
+	int cnt;
+
+	do {
+		cnt = util_mr_load_cnt(entry);
+		assert(cnt > 0);
+	} while (!util_mr_cas_cnt(entry, cnt, cnt - 1));
+	return cnt - 1;
+}
+
+/* Marks the entry for freeing if cnt references remain */
+static bool util_mr_entry_claim(struct ofi_mr_entry *entry, int cnt)
+{
+	return util_mr_cas_cnt(entry, cnt, OFI_MR_ENTRY_FREED);
+}
+
 static int util_mr_find_within(struct ofi_rbmap *map, void *key, void *data)
 {
 	struct ofi_mr_entry *entry = data;
@@ -94,6 +179,8 @@ static struct ofi_mr_entry *util_mr_entry_alloc(struct ofi_mr_cache *cache)
 	pthread_mutex_lock(&cache->lock);
 	entry = ofi_buf_alloc(cache->entry_pool);
 	pthread_mutex_unlock(&cache->lock);
+	if (entry)
+		util_mr_set_cnt(entry, OFI_MR_ENTRY_FREED);
 	return entry;
 }
 
@@ -130,6 +217,7 @@ static void util_mr_uncache_entry_storage(struct ofi_mr_cache *cache,
 
 	ofi_rbmap_delete(&cache->tree, entry->node);
 	entry->node = NULL;
+	util_mr_inc_gen(cache);
 
 	/* Some memory monitors have a subscription context per MR. These
 	 * memory monitors require ofi_monitor_unsubscribe() to be called.
@@ -146,8 +234,8 @@ static void util_mr_uncache_entry(struct ofi_mr_cache *cache,
 {
 	util_mr_uncache_entry_storage(cache, entry);
 
-	if (entry->use_cnt == 0) {
-		dlist_remove(&entry->list_entry);
+	dlist_remove_init(&entry->list_entry);
+	if (util_mr_entry_claim(entry, 0)) {
 		dlist_insert_tail(&entry->list_entry, &cache->dead_region_list);
 	} else {
 		cache->uncached_cnt++;
@@ -183,19 +271,61 @@ static struct ofi_mr_entry *ofi_mr_rbt_overlap(struct ofi_rbmap *tree,
 	return node->data;
 }
 
+static struct ofi_mr_entry *util_mr_last_hit(struct ofi_mr_cache *cache,
+					     const struct ofi_mr_info *info,
+					     uint64_t gen)
+{
+	struct ofi_mr_entry *entry = mr_last_hit.entry;
+	struct ofi_mem_monitor *monitor = cache->monitors[info->iface];
+
+	if (mr_last_hit.cache != cache || mr_last_hit.gen != gen ||
+	    entry->info.peer_id != info->peer_id ||
+	    !ofi_iov_within(&info->iov, &entry->info.iov) ||
+	    !monitor->valid(monitor, info, entry))
+		return NULL;
+
+	return entry;
+}
+
+/* Caller must hold tree_lock */
+static void util_mr_add_hits(struct ofi_mr_cache *cache)
+{
+	if (mr_last_hit.cache != cache)
+		return;
+
+	cache->search_cnt += mr_last_hit.hit_cnt;
+	cache->hit_cnt += mr_last_hit.hit_cnt;
+	mr_last_hit.hit_cnt = 0;
+}
+
+static void util_mr_set_last_hit(struct ofi_mr_cache *cache,
+				 struct ofi_mr_entry *entry)
+{
+	if (!(cache->gen >> 32))
+		return;
+
+	if (mr_last_hit.cache != cache)
+		mr_last_hit.hit_cnt = 0;
+	mr_last_hit.cache = cache;
+	mr_last_hit.entry = entry;
+	mr_last_hit.gen = cache->gen;
+}
+
 /* Caller must hold ofi_mem_monitor lock as well as unsubscribe from the region */
 void ofi_mr_cache_notify(struct ofi_mr_cache *cache, const void *addr, size_t len)
 {
 	struct ofi_mr_entry *entry;
 	struct iovec iov;
 
-	cache->notify_cnt++;
 	iov.iov_base = (void *) addr;
 	iov.iov_len = len;
 
+	pthread_mutex_lock(&cache->tree_lock);
+	cache->notify_cnt++;
 	for (entry = ofi_mr_rbt_overlap(&cache->tree, &iov); entry;
 	     entry = ofi_mr_rbt_overlap(&cache->tree, &iov))
 		util_mr_uncache_entry(cache, entry);
+	pthread_mutex_unlock(&cache->tree_lock);
 }
 
 /* Function to remove dead regions and prune MR cache size.
@@ -205,11 +335,13 @@ bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
 {
 	struct dlist_entry free_list;
 	struct ofi_mr_entry *entry;
+	size_t evict_cnt = 0;
 	bool entries_freed;
 
 	dlist_init(&free_list);
 
 	pthread_mutex_lock(&mm_lock);
+	pthread_mutex_lock(&cache->tree_lock);
 
 	dlist_splice_tail(&free_list, &cache->dead_region_list);
 
@@ -217,12 +349,18 @@ bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
 		dlist_pop_front(&cache->lru_list, struct ofi_mr_entry,
 				entry, list_entry);
 		dlist_init(&entry->list_entry);
+		/* Taken by a lockless hit since it went idle */
+		if (!util_mr_entry_claim(entry, 0))
+			continue;
+
 		util_mr_uncache_entry_storage(cache, entry);
 		dlist_insert_tail(&entry->list_entry, &free_list);
 
-		flush_lru = ofi_mr_cache_full(cache);
+		flush_lru = ofi_mr_cache_full(cache) ||
+			    ++evict_cnt < OFI_MR_CACHE_EVICT_BATCH;
 	}
 
+	pthread_mutex_unlock(&cache->tree_lock);
 	pthread_mutex_unlock(&mm_lock);
 
 	entries_freed = !dlist_empty(&free_list);
@@ -238,25 +376,36 @@ bool ofi_mr_cache_flush(struct ofi_mr_cache *cache, bool flush_lru)
 	return entries_freed;
 }
 
-void ofi_mr_cache_delete(struct ofi_mr_cache *cache, struct ofi_mr_entry *entry)
+/* Drops a reference with tree_lock held.  The lock is released on return. */
+static void util_mr_entry_release(struct ofi_mr_cache *cache,
+				  struct ofi_mr_entry *entry)
 {
-	FI_DBG(cache->prov, FI_LOG_MR, "delete %p (len: %zu)\n",
-	       entry->info.iov.iov_base, entry->info.iov.iov_len);
-
-	pthread_mutex_lock(&mm_lock);
-	cache->delete_cnt++;
-
-	if (--entry->use_cnt == 0) {
-		if (!entry->node) {
+	if (!entry->node) {
+		if (util_mr_entry_claim(entry, 1)) {
 			cache->uncached_cnt--;
 			cache->uncached_size -= entry->info.iov.iov_len;
-			pthread_mutex_unlock(&mm_lock);
+			pthread_mutex_unlock(&cache->tree_lock);
 			util_mr_free_entry(cache, entry);
 			return;
 		}
+		(void) util_mr_entry_put(entry);
+	} else if (!util_mr_entry_put(entry)) {
+		/* A lockless hit may have left it on the list */
+		dlist_remove(&entry->list_entry);
 		dlist_insert_tail(&entry->list_entry, &cache->lru_list);
 	}
-	pthread_mutex_unlock(&mm_lock);
+	pthread_mutex_unlock(&cache->tree_lock);
+}
+
+void ofi_mr_cache_delete(struct ofi_mr_cache *cache, struct ofi_mr_entry *entry)
+{
+	FI_DBG(cache->prov, FI_LOG_MR, "delete %p (len: %zu)\n",
+	       entry->info.iov.iov_base, entry->info.iov.iov_len);
+
+	pthread_mutex_lock(&cache->tree_lock);
+	util_mr_add_hits(cache);
+	cache->delete_cnt++;
+	util_mr_entry_release(cache, entry);
 }
 
 /*
@@ -288,7 +437,7 @@ util_mr_cache_create(struct ofi_mr_cache *cache, struct ofi_mr_info *info,
 
 	(*entry)->node = NULL;
 	(*entry)->info = *info;
-	(*entry)->use_cnt = 1;
+	dlist_init(&(*entry)->list_entry);
 
 	ret = cache->add_region(cache, *entry);
 	if (ret)
@@ -301,6 +450,7 @@ util_mr_cache_create(struct ofi_mr_cache *cache, struct ofi_mr_info *info,
 	*info = (*entry)->info;
 
 	pthread_mutex_lock(&mm_lock);
+	pthread_mutex_lock(&cache->tree_lock);
 	cur = ofi_mr_rbt_find(&cache->tree, info);
 	if (cur) {
 		ret = -FI_EAGAIN;
@@ -326,18 +476,52 @@ util_mr_cache_create(struct ofi_mr_cache *cache, struct ofi_mr_info *info,
 			util_mr_uncache_entry_storage(cache, *entry);
 			cache->uncached_cnt++;
 			cache->uncached_size += (*entry)->info.iov.iov_len;
+		} else {
+			util_mr_set_last_hit(cache, *entry);
 		}
 	}
+	util_mr_set_cnt(*entry, 1);
+	pthread_mutex_unlock(&cache->tree_lock);
 	pthread_mutex_unlock(&mm_lock);
 	return 0;
 
 unlock:
+	pthread_mutex_unlock(&cache->tree_lock);
 	pthread_mutex_unlock(&mm_lock);
 free:
 	util_mr_free_entry(cache, *entry);
 	return ret;
 }
 
+/* Take a reference on the last entry found by this thread without
+ * tree_lock.  The generation is read again once the reference is held.
+ * If it moved, the entry may have left the tree and its storage may hold
+ * another entry of this cache, so the reference is dropped and the search
+ * goes through the tree.  Entry storage is only released when the cache is
+ * destroyed, so reading a stale entry is safe.
+ */
+static struct ofi_mr_entry *
+util_mr_hit_lockless(struct ofi_mr_cache *cache, const struct ofi_mr_info *info)
+{
+	struct ofi_mr_entry *entry;
+	uint64_t gen;
+
+	if (!OFI_MR_LOCKLESS_HIT)
+		return NULL;
+
+	gen = util_mr_load_gen(cache);
+	entry = util_mr_last_hit(cache, info, gen);
+	if (!entry || !util_mr_entry_get(entry))
+		return NULL;
+
+	if (util_mr_load_gen(cache) != gen) {
+		pthread_mutex_lock(&cache->tree_lock);
+		util_mr_entry_release(cache, entry);
+		return NULL;
+	}
+	return entry;
+}
+
 int ofi_mr_cache_search(struct ofi_mr_cache *cache, struct ofi_mr_info *info,
 			struct ofi_mr_entry **entry)
 {
@@ -356,29 +540,45 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, struct ofi_mr_info *info,
 	FI_DBG(cache->prov, FI_LOG_MR, "search %p (len: %zu)\n",
 	       info->iov.iov_base, info->iov.iov_len);
 
+	*entry = util_mr_hit_lockless(cache, info);
+	if (*entry) {
+		mr_last_hit.hit_cnt++;
+		return 0;
+	}
+
 	do {
-		pthread_mutex_lock(&mm_lock);
+		pthread_mutex_lock(&cache->tree_lock);
+		util_mr_add_hits(cache);
 		flush_lru = ofi_mr_cache_full(cache);
 		if (flush_lru || !dlist_empty(&cache->dead_region_list)) {
-			pthread_mutex_unlock(&mm_lock);
+			pthread_mutex_unlock(&cache->tree_lock);
 			ofi_mr_cache_flush(cache, flush_lru);
-			pthread_mutex_lock(&mm_lock);
+			pthread_mutex_lock(&cache->tree_lock);
 		}
 
 		cache->search_cnt++;
-		*entry = ofi_mr_rbt_find(&cache->tree, info);
+		*entry = util_mr_last_hit(cache, info, cache->gen);
+		if (*entry)
+			goto hit;
 
+		*entry = ofi_mr_rbt_find(&cache->tree, info);
 		if (*entry &&
 		    ofi_iov_within(&info->iov, &(*entry)->info.iov) &&
 		    monitor->valid(monitor, info, *entry))
 			goto hit;
+		pthread_mutex_unlock(&cache->tree_lock);
 
-		/* Purge regions that overlap with new region */
-		while (*entry) {
-			util_mr_uncache_entry(cache, *entry);
-			*entry = ofi_mr_rbt_find(&cache->tree, info);
+		/* Purge regions that overlap with new region.  Unsubscribing
+		 * requires the monitor lock, which is taken first.
+		 */
+		if (*entry) {
+			pthread_mutex_lock(&mm_lock);
+			pthread_mutex_lock(&cache->tree_lock);
+			while ((*entry = ofi_mr_rbt_find(&cache->tree, info)))
+				util_mr_uncache_entry(cache, *entry);
+			pthread_mutex_unlock(&cache->tree_lock);
+			pthread_mutex_unlock(&mm_lock);
 		}
-		pthread_mutex_unlock(&mm_lock);
 
 		ret = util_mr_cache_create(cache, info, entry);
 		if (ret && ret != -FI_EAGAIN) {
@@ -391,9 +591,10 @@ int ofi_mr_cache_search(struct ofi_mr_cache *cache, struct ofi_mr_info *info,
 
 hit:
 	cache->hit_cnt++;
-	if ((*entry)->use_cnt++ == 0)
-		dlist_remove_init(&(*entry)->list_entry);
-	pthread_mutex_unlock(&mm_lock);
+	(void) util_mr_entry_get(*entry);
+	dlist_remove_init(&(*entry)->list_entry);
+	util_mr_set_last_hit(cache, *entry);
+	pthread_mutex_unlock(&cache->tree_lock);
 	return 0;
 }
 
@@ -410,11 +611,14 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 	       attr->mr_iov->iov_base, attr->mr_iov->iov_len);
 
 	pthread_mutex_lock(&mm_lock);
+	pthread_mutex_lock(&cache->tree_lock);
 
 	if (!dlist_empty(&cache->dead_region_list)) {
+		pthread_mutex_unlock(&cache->tree_lock);
 		pthread_mutex_unlock(&mm_lock);
 		ofi_mr_cache_flush(cache, false);
 		pthread_mutex_lock(&mm_lock);
+		pthread_mutex_lock(&cache->tree_lock);
 	}
 
 	cache->search_cnt++;
@@ -431,8 +635,8 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 	if (ofi_iov_within(attr->mr_iov, &entry->info.iov) &&
 	    monitor->valid(monitor, entry->info.iov.iov_base, entry)) {
 		cache->hit_cnt++;
-		if ((entry)->use_cnt++ == 0)
-			dlist_remove_init(&(entry)->list_entry);
+		(void) util_mr_entry_get(entry);
+		dlist_remove_init(&entry->list_entry);
 	} else {
 		while (entry) {
 			util_mr_uncache_entry(cache, entry);
@@ -441,6 +645,7 @@ struct ofi_mr_entry *ofi_mr_cache_find(struct ofi_mr_cache *cache,
 	}
 
 unlock:
+	pthread_mutex_unlock(&cache->tree_lock);
 	pthread_mutex_unlock(&mm_lock);
 	return entry;
 }
@@ -458,27 +663,28 @@ int ofi_mr_cache_reg(struct ofi_mr_cache *cache, const struct fi_mr_attr *attr,
 	if (!*entry)
 		return -FI_ENOMEM;
 
-	pthread_mutex_lock(&mm_lock);
+	pthread_mutex_lock(&cache->tree_lock);
 	cache->uncached_cnt++;
 	cache->uncached_size += attr->mr_iov->iov_len;
-	pthread_mutex_unlock(&mm_lock);
+	pthread_mutex_unlock(&cache->tree_lock);
 
 	ofi_mr_info_get_iov_from_mr_attr(&(*entry)->info, attr, flags);
-	(*entry)->use_cnt = 1;
 	(*entry)->node = NULL;
+	dlist_init(&(*entry)->list_entry);
 
 	ret = cache->add_region(cache, *entry);
 	if (ret)
 		goto buf_free;
 
+	util_mr_set_cnt(*entry, 1);
 	return 0;
 
 buf_free:
 	util_mr_entry_free(cache, *entry);
-	pthread_mutex_lock(&mm_lock);
+	pthread_mutex_lock(&cache->tree_lock);
 	cache->uncached_cnt--;
 	cache->uncached_size -= attr->mr_iov->iov_len;
-	pthread_mutex_unlock(&mm_lock);
+	pthread_mutex_unlock(&cache->tree_lock);
 	return ret;
 }
 
@@ -488,6 +694,7 @@ void ofi_mr_cache_cleanup(struct ofi_mr_cache *cache)
 	if (!cache->prov)
 		return;
 
+	util_mr_add_hits(cache);
 	FI_INFO(cache->prov, FI_LOG_MR, "MR cache stats: "
 		"searches %zu, deletes %zu, hits %zu notify %zu\n",
 		cache->search_cnt, cache->delete_cnt, cache->hit_cnt,
@@ -496,6 +703,7 @@ void ofi_mr_cache_cleanup(struct ofi_mr_cache *cache)
 	while (ofi_mr_cache_flush(cache, true))
 		;
 
+	pthread_mutex_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	ofi_monitors_del_cache(cache);
 	ofi_rbmap_cleanup(&cache->tree);
@@ -520,6 +728,10 @@ int ofi_mr_cache_init(struct util_domain *domain,
 		return -FI_ENOSPC;
 
 	pthread_mutex_init(&cache->lock, NULL);
+	pthread_mutex_init(&cache->tree_lock, NULL);
+	pthread_mutex_lock(&mm_lock);
+	cache->gen = ++mr_cache_epoch << 32;
+	pthread_mutex_unlock(&mm_lock);
 	dlist_init(&cache->lru_list);
 	dlist_init(&cache->dead_region_list);
 	cache->cached_cnt = 0;
@@ -561,6 +773,7 @@ destroy:
 		ofi_atomic_dec32(&cache->domain->ref);
 		cache->domain = NULL;
 	}
+	pthread_mutex_destroy(&cache->tree_lock);
 	pthread_mutex_destroy(&cache->lock);
 	cache->prov = NULL;
 	return ret;
@@ -53,6 +53,137 @@ static inline void **util_srx_desc(struct util_srx_ctx *srx,
 			(sizeof(struct iovec) * srx->iov_limit));
 }
 
+#define UTIL_TAG_HASH_INIT_SIZE 64
+
+static int util_tag_hash_init(struct util_tag_hash *hash, bool by_src)
+{
+	size_t i;
+
+	hash->buckets = calloc(UTIL_TAG_HASH_INIT_SIZE,
+			       sizeof(*hash->buckets));
+	if (!hash->buckets)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < UTIL_TAG_HASH_INIT_SIZE; i++)
+		dlist_init(&hash->buckets[i]);
+
+	hash->size = UTIL_TAG_HASH_INIT_SIZE;
+	hash->cnt = 0;
+	hash->by_src = by_src;
+	return FI_SUCCESS;
+}
+
+static inline struct dlist_entry *
+util_tag_bucket(struct util_tag_hash *hash, struct dlist_entry *buckets,
+		size_t size, fi_addr_t addr, uint64_t tag)
+{
+	uint64_t key = tag;
+
+	if (hash->by_src)
+		key ^= (uint64_t) addr * 0x9e3779b97f4a7c15ULL;
+
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return &buckets[key & (size - 1)];
+}
+
+/* Rehashing walks each old bucket front to back, so entries with the same
+ * key keep their relative (seq_no) order in the new bucket.
+ */
+static void util_tag_hash_grow(struct util_tag_hash *hash)
+{
+	struct dlist_entry *buckets, *bucket;
+	struct util_rx_entry *rx_entry;
+	size_t i, size = hash->size << 1;
+
+	buckets = calloc(size, sizeof(*buckets));
+	if (!buckets)
+		return;
+
+	for (i = 0; i < size; i++)
+		dlist_init(&buckets[i]);
+
+	for (i = 0; i < hash->size; i++) {
+		while (!dlist_empty(&hash->buckets[i])) {
+			dlist_pop_front(&hash->buckets[i], struct util_rx_entry,
+					rx_entry, h_entry);
+			bucket = util_tag_bucket(hash, buckets, size,
+						 rx_entry->peer_entry.addr,
+						 rx_entry->peer_entry.tag);
+			dlist_insert_tail(&rx_entry->h_entry, bucket);
+		}
+	}
+
+	free(hash->buckets);
+	hash->buckets = buckets;
+	hash->size = size;
+}
+
+static void util_tag_hash_insert(struct util_tag_hash *hash,
+				 struct util_rx_entry *rx_entry)
+{
+	struct dlist_entry *bucket;
+
+	if (hash->cnt >= hash->size)
+		util_tag_hash_grow(hash);
+
+	bucket = util_tag_bucket(hash, hash->buckets, hash->size,
+				 rx_entry->peer_entry.addr,
+				 rx_entry->peer_entry.tag);
+	dlist_insert_tail(&rx_entry->h_entry, bucket);
+	hash->cnt++;
+}
+
+static inline void util_tag_hash_remove(struct util_tag_hash *hash,
+					struct util_rx_entry *rx_entry)
+{
+	assert(hash->cnt);
+	dlist_remove_init(&rx_entry->h_entry);
+	hash->cnt--;
+}
+
+/* Posted receives must come from the exact source being looked up (which
+ * may be FI_ADDR_UNSPEC), while unexpected messages match any source when
+ * the receive is not directed.
+ */
+static struct util_rx_entry *util_tag_hash_find(struct util_tag_hash *hash,
+						fi_addr_t addr, uint64_t tag)
+{
+	struct dlist_entry *bucket;
+	struct util_rx_entry *rx_entry;
+
+	if (!hash->cnt)
+		return NULL;
+
+	bucket = util_tag_bucket(hash, hash->buckets, hash->size, addr, tag);
+	dlist_foreach_container(bucket, struct util_rx_entry, rx_entry,
+				h_entry) {
+		if (rx_entry->peer_entry.tag != tag)
+			continue;
+
+		if (rx_entry->peer_entry.addr == addr ||
+		    (!hash->by_src && addr == FI_ADDR_UNSPEC))
+			return rx_entry;
+	}
+	return NULL;
+}
+
+static void util_tag_hash_cleanup(struct util_tag_hash *hash)
+{
+	struct util_rx_entry *rx_entry;
+	size_t i;
+
+	for (i = 0; i < hash->size; i++) {
+		while (!dlist_empty(&hash->buckets[i])) {
+			dlist_pop_front(&hash->buckets[i], struct util_rx_entry,
+					rx_entry, h_entry);
+			ofi_buf_free(rx_entry);
+		}
+	}
+	free(hash->buckets);
+}
+
 static void util_init_rx_entry(struct util_rx_entry *entry,
 			       const struct iovec *iov, void **desc,
 			       size_t count, fi_addr_t addr, void *context,
@@ -249,39 +380,60 @@ static int util_get_msg(struct fid_peer_srx *srx,
 	return FI_SUCCESS;
 }
 
-static int util_match_tag(struct fid_peer_srx *srx,
-			  struct fi_peer_match_attr *attr,
-			  struct fi_peer_rx_entry **rx_entry)
+/* Exact tags are looked up in the hash, wildcard receives are walked in
+ * post order only until an older candidate has been found.  The receive
+ * with the lowest seq_no wins and is removed from its queue.
+ */
+static struct util_rx_entry *util_match_posted_tag(struct util_srx_ctx *srx,
+						   fi_addr_t addr, uint64_t tag)
 {
-	struct util_srx_ctx *srx_ctx;
-	struct util_rx_entry *util_entry;
-	struct slist_entry *item, *prev;
-	int ret = FI_SUCCESS;
+	struct util_rx_entry *util_entry, *match;
+	struct slist *queues[2], *match_queue = NULL;
+	struct slist_entry *item, *prev, *match_item = NULL, *match_prev = NULL;
+	int i, queue_cnt = 1;
 
-	srx_ctx = srx->ep_fid.fid.context;
-	slist_foreach(&srx_ctx->tag_queue, item, prev) {
-		util_entry = container_of(item, struct util_rx_entry, s_entry);
-		assert(util_entry->status == RX_ENTRY_POSTED);
-		if (ofi_match_tag(util_entry->peer_entry.tag,
-				  util_entry->ignore, attr->tag)) {
-			util_entry->status = RX_ENTRY_MATCHED;
-			util_entry->peer_entry.srx = srx;
-			srx_ctx->update_func(srx_ctx, util_entry);
-			slist_remove(&srx_ctx->tag_queue, item, prev);
-			goto out;
+	match = util_tag_hash_find(&srx->tag_hash, FI_ADDR_UNSPEC, tag);
+
+	queues[0] = &srx->tag_queue;
+	if (srx->dir_recv && addr != FI_ADDR_UNSPEC) {
+		util_entry = util_tag_hash_find(&srx->tag_hash, addr, tag);
+		if (util_entry && (!match || util_entry->seq_no < match->seq_no))
+			match = util_entry;
+
+		queues[queue_cnt++] = ofi_array_at(&srx->src_trecv_queues, addr);
+	}
+
+	for (i = 0; i < queue_cnt; i++) {
+		if (!queues[i])
+			continue;
+
+		slist_foreach(queues[i], item, prev) {
+			util_entry = container_of(item, struct util_rx_entry,
+						  s_entry);
+			assert(util_entry->status == RX_ENTRY_POSTED);
+			if (match && util_entry->seq_no > match->seq_no)
+				break;
+
+			if (ofi_match_tag(util_entry->peer_entry.tag,
+					  util_entry->ignore, tag)) {
+				match = util_entry;
+				match_queue = queues[i];
+				match_item = item;
+				match_prev = prev;
+				break;
+			}
 		}
 	}
 
-	util_entry = util_init_unexp(srx_ctx, attr, FI_TAGGED | FI_RECV);
-	if (!util_entry)
-		return -FI_ENOMEM;
-	ret = -FI_ENOENT;
-	util_entry->peer_entry.srx = srx;
-out:
-	util_entry->peer_entry.msg_size = MIN(util_entry->peer_entry.msg_size,
-					      attr->msg_size);
-	*rx_entry = &util_entry->peer_entry;
-	return ret;
+	if (!match)
+		return NULL;
+
+	if (match_queue)
+		slist_remove(match_queue, match_item, match_prev);
+	else
+		util_tag_hash_remove(&srx->tag_hash, match);
+
+	return match;
 }
 
 static int util_get_tag(struct fid_peer_srx *srx,
@@ -289,50 +441,29 @@ static int util_get_tag(struct fid_peer_srx *srx,
 			struct fi_peer_rx_entry **rx_entry)
 {
 	struct util_srx_ctx *srx_ctx;
-	struct slist *queue;
-	struct slist_entry *any_item, *any_prev;
-	struct slist_entry *item, *prev;
-	struct util_rx_entry *util_entry, *any_entry;
+	struct util_rx_entry *util_entry;
 	int ret = FI_SUCCESS;
 
 	srx_ctx = srx->ep_fid.fid.context;
 	assert(ofi_genlock_held(srx_ctx->lock));
 
-	queue = attr->addr == FI_ADDR_UNSPEC ? NULL:
-		ofi_array_at(&srx_ctx->src_trecv_queues, attr->addr);
-
-	if (!queue || slist_empty(queue))
-		return util_match_tag(srx, attr, rx_entry);
-
-	slist_foreach(queue, item, prev) {
-		util_entry = container_of(item, struct util_rx_entry, s_entry);
-		if (ofi_match_tag(util_entry->peer_entry.tag,
-				  util_entry->ignore, attr->tag))
-			goto check_any;
+	util_entry = util_match_posted_tag(srx_ctx, attr->addr, attr->tag);
+	if (util_entry) {
+		util_entry->status = RX_ENTRY_MATCHED;
+		util_entry->peer_entry.srx = srx;
+		srx_ctx->update_func(srx_ctx, util_entry);
+	} else {
+		util_entry = util_init_unexp(srx_ctx, attr,
+					     FI_TAGGED | FI_RECV);
+		if (!util_entry)
+			return -FI_ENOMEM;
+		ret = -FI_ENOENT;
+		util_entry->peer_entry.srx = srx;
 	}
-	return util_match_tag(srx, attr, rx_entry);
-
-check_any:
-	slist_foreach(&srx_ctx->tag_queue, any_item, any_prev) {
-		any_entry = container_of(any_item, struct util_rx_entry,
-					 peer_entry);
-		if (any_entry->seq_no > util_entry->seq_no)
-			break;
 
-		if (ofi_match_tag(any_entry->peer_entry.tag, any_entry->ignore,
-				  attr->tag)) {
-			queue = &srx_ctx->tag_queue;
-			util_entry = any_entry;
-			item = any_item;
-			prev = any_prev;
-			break;
-		}
-	}
-	util_entry->status = RX_ENTRY_MATCHED;
-	util_entry->peer_entry.srx = srx;
-	srx_ctx->update_func(srx_ctx, util_entry);
+	util_entry->peer_entry.msg_size = MIN(util_entry->peer_entry.msg_size,
+					      attr->msg_size);
 	*rx_entry = &util_entry->peer_entry;
-	slist_remove(queue, item, prev);
 	return ret;
 }
 
@@ -353,7 +484,8 @@ static int util_queue_msg(struct fi_peer_rx_entry *rx_entry)
 		unexp_peer = ofi_array_at(&srx_ctx->src_unexp_peers,
 					  rx_entry->addr);
 		assert(unexp_peer);
-		slist_insert_tail(&util_entry->s_entry, &unexp_peer->msg_queue);
+		dlist_insert_tail(&util_entry->d_entry,
+				  &unexp_peer->msg_queue);
 		if (!unexp_peer->cnt++)
 			dlist_insert_tail(&unexp_peer->entry,
 					  &srx_ctx->unexp_peers);
@@ -378,12 +510,13 @@ static int util_queue_tag(struct fi_peer_rx_entry *rx_entry)
 		unexp_peer = ofi_array_at(&srx_ctx->src_unexp_peers,
 					  rx_entry->addr);
 		assert(unexp_peer);
-		slist_insert_tail(&util_entry->s_entry, &unexp_peer->tag_queue);
+		dlist_insert_tail(&util_entry->d_entry,
+				  &unexp_peer->tag_queue);
 		if (!unexp_peer->cnt++)
 			dlist_insert_tail(&unexp_peer->entry,
 					  &srx_ctx->unexp_peers);
-
 	}
+	util_tag_hash_insert(&srx_ctx->unexp_tag_hash, util_entry);
 	return FI_SUCCESS;
 }
 
@@ -391,8 +524,6 @@ static void util_free_entry(struct fi_peer_rx_entry *entry)
 {
 	struct util_srx_ctx *srx;
 	struct util_unexp_peer *unexp_peer;
-	struct slist *queue;
-	struct slist_entry *item, *prev;
 	struct util_rx_entry *util_entry, *owner_entry;
 
 	srx = (struct util_srx_ctx *) entry->srx->ep_fid.fid.context;
@@ -415,26 +546,18 @@ static void util_free_entry(struct fi_peer_rx_entry *entry)
 	}
 
 	if (util_entry->status == RX_ENTRY_UNEXP) {
-		if (util_entry->peer_entry.addr == FI_ADDR_UNSPEC) {
-			dlist_remove(&util_entry->d_entry);
-		} else {
+		dlist_remove(&util_entry->d_entry);
+		if (util_entry->peer_entry.addr != FI_ADDR_UNSPEC) {
 			unexp_peer = ofi_array_at(&srx->src_unexp_peers,
 						  util_entry->peer_entry.addr);
-			queue = util_entry->peer_entry.flags & FI_TAGGED ?
-					&unexp_peer->tag_queue :
-					&unexp_peer->msg_queue;
-
-			slist_foreach(queue, item, prev) {
-				if ((struct util_rx_entry *) item == util_entry)
-					slist_remove(queue, item, prev);
-			}
-
 			if (!--unexp_peer->cnt) {
-				assert(slist_empty(&unexp_peer->msg_queue) &&
-				       slist_empty(&unexp_peer->tag_queue));
+				assert(dlist_empty(&unexp_peer->msg_queue) &&
+				       dlist_empty(&unexp_peer->tag_queue));
 				dlist_remove(&unexp_peer->entry);
 			}
 		}
+		if (util_entry->peer_entry.flags & FI_TAGGED)
+			util_tag_hash_remove(&srx->unexp_tag_hash, util_entry);
 	}
 
 	ofi_buf_free(util_entry);
@@ -462,7 +585,7 @@ static void util_foreach_unspec(struct fid_peer_srx *srx,
 		unexp_peer = ofi_array_at(&srx_ctx->src_unexp_peers,
 					  rx_entry->peer_entry.addr);
 		assert(unexp_peer);
-		slist_insert_tail(&rx_entry->s_entry, &unexp_peer->msg_queue);
+		dlist_insert_tail(&rx_entry->d_entry, &unexp_peer->msg_queue);
 		if (!unexp_peer->cnt++)
 			dlist_insert_tail(&unexp_peer->entry,
 					  &srx_ctx->unexp_peers);
@@ -479,7 +602,7 @@ static void util_foreach_unspec(struct fid_peer_srx *srx,
 		unexp_peer = ofi_array_at(&srx_ctx->src_unexp_peers,
 					  rx_entry->peer_entry.addr);
 		assert(unexp_peer);
-		slist_insert_tail(&rx_entry->s_entry, &unexp_peer->tag_queue);
+		dlist_insert_tail(&rx_entry->d_entry, &unexp_peer->tag_queue);
 		if (!unexp_peer->cnt++)
 			dlist_insert_tail(&unexp_peer->entry,
 					  &srx_ctx->unexp_peers);
@@ -501,12 +624,13 @@ static struct util_rx_entry *util_search_peer_msg(struct util_unexp_peer *peer)
 	struct util_rx_entry *rx_entry;
 
 	assert(peer);
-	if (slist_empty(&peer->msg_queue))
+	if (dlist_empty(&peer->msg_queue))
 		return NULL;
 
-	rx_entry = (struct util_rx_entry *) slist_remove_head(&peer->msg_queue);
+	dlist_pop_front(&peer->msg_queue, struct util_rx_entry, rx_entry,
+			d_entry);
 	if (!--peer->cnt) {
-		assert(slist_empty(&peer->msg_queue));
+		assert(dlist_empty(&peer->tag_queue));
 		dlist_remove(&peer->entry);
 	}
 	return rx_entry;
@@ -612,29 +736,35 @@ out:
 	return ret;
 }
 
+static void util_remove_unexp_tag(struct util_srx_ctx *srx,
+				  struct util_rx_entry *rx_entry)
+{
+	struct util_unexp_peer *unexp_peer;
+
+	dlist_remove(&rx_entry->d_entry);
+	if (rx_entry->peer_entry.addr != FI_ADDR_UNSPEC) {
+		unexp_peer = ofi_array_at(&srx->src_unexp_peers,
+					  rx_entry->peer_entry.addr);
+		assert(unexp_peer);
+		if (!--unexp_peer->cnt) {
+			assert(dlist_empty(&unexp_peer->msg_queue) &&
+			       dlist_empty(&unexp_peer->tag_queue));
+			dlist_remove(&unexp_peer->entry);
+		}
+	}
+	util_tag_hash_remove(&srx->unexp_tag_hash, rx_entry);
+}
+
 static struct util_rx_entry *util_search_peer_tag(struct util_unexp_peer *peer,
-				uint64_t tag, uint64_t ignore, bool remove)
+				uint64_t tag, uint64_t ignore)
 {
 	struct util_rx_entry *rx_entry;
-	struct slist_entry *item, *prev;
 
 	assert(peer);
-	if (slist_empty(&peer->tag_queue))
-		return NULL;
-
-	slist_foreach(&peer->tag_queue, item, prev) {
-		rx_entry = (struct util_rx_entry *) item;
-		if (!ofi_match_tag(tag, ignore, rx_entry->peer_entry.tag))
-			continue;
-
-		if (remove) {
-			slist_remove(&peer->tag_queue, item, prev);
-			if (!--peer->cnt) {
-				assert(slist_empty(&peer->tag_queue));
-				dlist_remove(&peer->entry);
-			}
-		}
-		return rx_entry;
+	dlist_foreach_container(&peer->tag_queue, struct util_rx_entry,
+				rx_entry, d_entry) {
+		if (ofi_match_tag(tag, ignore, rx_entry->peer_entry.tag))
+			return rx_entry;
 	}
 	return NULL;
 }
@@ -642,35 +772,37 @@ static struct util_rx_entry *util_search_peer_tag(struct util_unexp_peer *peer,
 static struct util_rx_entry *util_search_unexp_tag(struct util_srx_ctx *srx,
 		fi_addr_t addr, uint64_t tag, uint64_t ignore, bool remove)
 {
-	struct util_rx_entry *rx_entry;
+	struct util_rx_entry *rx_entry = NULL;
 	struct util_unexp_peer *unexp_peer;
 
-	if (addr == FI_ADDR_UNSPEC) {
-		dlist_foreach_container(&srx->unspec_unexp_tag_queue,
-					struct util_rx_entry, rx_entry,
-					d_entry) {
-			if (!ofi_match_tag(tag, ignore,
-			    rx_entry->peer_entry.tag))
-				continue;
-
-			if (remove)
-				dlist_remove(&rx_entry->d_entry);
+	if (!ignore) {
+		rx_entry = util_tag_hash_find(&srx->unexp_tag_hash, addr, tag);
+		goto out;
+	}
 
-			return rx_entry;
-		}
+	if (addr != FI_ADDR_UNSPEC) {
+		rx_entry = util_search_peer_tag(ofi_array_at(
+				&srx->src_unexp_peers, addr), tag, ignore);
+		goto out;
+	}
 
-		dlist_foreach_container(&srx->unexp_peers,
-				struct util_unexp_peer, unexp_peer, entry) {
-			rx_entry = util_search_peer_tag(unexp_peer, tag,
-							ignore, remove);
-			if (rx_entry)
-				return rx_entry;
-		}
-		return NULL;
+	dlist_foreach_container(&srx->unspec_unexp_tag_queue,
+				struct util_rx_entry, rx_entry, d_entry) {
+		if (ofi_match_tag(tag, ignore, rx_entry->peer_entry.tag))
+			goto out;
 	}
 
-	return util_search_peer_tag(ofi_array_at(&srx->src_unexp_peers, addr),
-				    tag, ignore, remove);
+	rx_entry = NULL;
+	dlist_foreach_container(&srx->unexp_peers, struct util_unexp_peer,
+				unexp_peer, entry) {
+		rx_entry = util_search_peer_tag(unexp_peer, tag, ignore);
+		if (rx_entry)
+			break;
+	}
+out:
+	if (rx_entry && remove)
+		util_remove_unexp_tag(srx, rx_entry);
+	return rx_entry;
 }
 
 static ssize_t util_srx_peek(struct util_srx_ctx *srx, const struct iovec *iov,
@@ -752,17 +884,24 @@ ssize_t util_srx_generic_trecv(struct fid_ep *ep_fid, const struct iovec *iov,
 	} else {
 		rx_entry = util_search_unexp_tag(srx, addr, tag, ignore, true);
 		if (!rx_entry) {
-			queue = addr == FI_ADDR_UNSPEC ? &srx->tag_queue:
-				ofi_array_at(&srx->src_trecv_queues, addr);
-			assert(queue);
 			rx_entry = util_get_recv_entry(srx, iov, desc,
 						iov_count, addr, context, tag,
 						ignore,
 						flags | FI_TAGGED | FI_RECV);
-			if (!rx_entry)
+			if (!rx_entry) {
 				ret = -FI_ENOMEM;
-			else
-				slist_insert_tail(&rx_entry->s_entry, queue);
+				goto out;
+			}
+
+			if (!ignore) {
+				util_tag_hash_insert(&srx->tag_hash, rx_entry);
+				goto out;
+			}
+
+			queue = addr == FI_ADDR_UNSPEC ? &srx->tag_queue:
+				ofi_array_at(&srx->src_trecv_queues, addr);
+			assert(queue);
+			slist_insert_tail(&rx_entry->s_entry, queue);
 			goto out;
 		}
 	}
@@ -1005,6 +1144,7 @@ int util_srx_close(struct fid *fid)
 		ofi_buf_free(container_of(entry, struct util_rx_entry,
 					  s_entry));
 	}
+	util_tag_hash_cleanup(&srx->tag_hash);
 
 	while (!dlist_empty(&srx->unspec_unexp_msg_queue)) {
 		dlist_pop_front(&srx->unspec_unexp_msg_queue,
@@ -1025,19 +1165,19 @@ int util_srx_close(struct fid *fid)
 	while (!dlist_empty(&srx->unexp_peers)) {
 		dlist_pop_front(&srx->unexp_peers, struct util_unexp_peer,
 				unexp_peer, entry);
-		while (!slist_empty(&unexp_peer->msg_queue)) {
-			rx_entry = container_of(slist_remove_head(
-				&unexp_peer->msg_queue), struct util_rx_entry,
-				s_entry);
+		while (!dlist_empty(&unexp_peer->msg_queue)) {
+			dlist_pop_front(&unexp_peer->msg_queue,
+					struct util_rx_entry, rx_entry,
+					d_entry);
 			rx_entry->peer_entry.srx->peer_ops->discard_msg(
 							&rx_entry->peer_entry);
 			ofi_buf_free(rx_entry);
 			unexp_peer->cnt--;
 		}
-		while (!slist_empty(&unexp_peer->tag_queue)) {
-			rx_entry = container_of(slist_remove_head(
-				&unexp_peer->tag_queue), struct util_rx_entry,
-				s_entry);
+		while (!dlist_empty(&unexp_peer->tag_queue)) {
+			dlist_pop_front(&unexp_peer->tag_queue,
+					struct util_rx_entry, rx_entry,
+					d_entry);
 			rx_entry->peer_entry.srx->peer_ops->discard_tag(
 							&rx_entry->peer_entry);
 			ofi_buf_free(rx_entry);
@@ -1047,6 +1187,8 @@ int util_srx_close(struct fid *fid)
 	}
 
 	ofi_array_destroy(&srx->src_unexp_peers);
+	/* unexpected tagged entries were freed from their queues above */
+	free(srx->unexp_tag_hash.buckets);
 
 	ofi_atomic_dec32(&srx->cq->ref);
 	ofi_bufpool_destroy(srx->rx_pool);
@@ -1090,6 +1232,27 @@ static int util_cancel_recv(struct util_srx_ctx *srx, struct slist *queue,
 	return -FI_ENOENT;
 }
 
+static int util_cancel_hash(struct util_srx_ctx *srx, void *context)
+{
+	struct util_rx_entry *rx_entry;
+	size_t i;
+
+	assert(ofi_genlock_held(srx->lock));
+	for (i = 0; i < srx->tag_hash.size; i++) {
+		dlist_foreach_container(&srx->tag_hash.buckets[i],
+					struct util_rx_entry, rx_entry,
+					h_entry) {
+			if (rx_entry->peer_entry.context != context)
+				continue;
+
+			util_tag_hash_remove(&srx->tag_hash, rx_entry);
+			util_cancel_entry(srx, FI_TAGGED | FI_RECV, rx_entry);
+			return FI_SUCCESS;
+		}
+	}
+	return -FI_ENOENT;
+}
+
 static int util_cancel_src(struct ofi_dyn_arr *arr, void *list, void *context)
 {
 	struct util_srx_ctx *srx;
@@ -1117,6 +1280,10 @@ static ssize_t util_srx_cancel(fid_t ep_fid, void *context)
 	if (ret != -FI_ENOENT)
 		goto out;
 
+	ret = util_cancel_hash(srx, context);
+	if (ret != -FI_ENOENT)
+		goto out;
+
 	ret = util_cancel_recv(srx, &srx->msg_queue, FI_MSG | FI_RECV, context);
 	if (ret != -FI_ENOENT)
 		goto out;
@@ -1192,8 +1359,8 @@ static void util_srx_init_unexp_peer(struct ofi_dyn_arr *arr, void *item)
 {
 	struct util_unexp_peer *unexp_peer = item;
 
-	slist_init(&unexp_peer->msg_queue);
-	slist_init(&unexp_peer->tag_queue);
+	dlist_init(&unexp_peer->msg_queue);
+	dlist_init(&unexp_peer->tag_queue);
 	unexp_peer->cnt = 0;
 }
 
@@ -1210,6 +1377,14 @@ int util_ep_srx_context(struct util_domain *domain, size_t rx_size,
 	if (!srx)
 		return -FI_ENOMEM;
 
+	ret = util_tag_hash_init(&srx->tag_hash, true);
+	if (ret)
+		goto free_srx;
+
+	ret = util_tag_hash_init(&srx->unexp_tag_hash, false);
+	if (ret)
+		goto free_hash;
+
 	ofi_array_init(&srx->src_unexp_peers, sizeof(struct util_unexp_peer),
 		       util_srx_init_unexp_peer);
 	dlist_init(&srx->unspec_unexp_msg_queue);
@@ -1234,11 +1409,10 @@ int util_ep_srx_context(struct util_domain *domain, size_t rx_size,
 	pool_attr.free_fn = NULL;
 	pool_attr.init_fn = util_rx_entry_init;
 	pool_attr.context = srx;
+	pool_attr.flags = OFI_BUFPOOL_NUMA_LOCAL;
 	ret = ofi_bufpool_create_attr(&pool_attr, &srx->rx_pool);
-	if (ret) {
-		free(srx);
-		return ret;
-	}
+	if (ret)
+		goto free_unexp_hash;
 
 	srx->min_multi_recv_size = default_min_multi_recv;
 	srx->iov_limit = iov_limit;
@@ -1260,4 +1434,12 @@ int util_ep_srx_context(struct util_domain *domain, size_t rx_size,
 
 	domain->srx = &srx->peer_srx;
 	return FI_SUCCESS;
+
+free_unexp_hash:
+	free(srx->unexp_tag_hash.buckets);
+free_hash:
+	free(srx->tag_hash.buckets);
+free_srx:
+	free(srx);
+	return ret;
 }
@@ -88,7 +88,9 @@ struct ofi_common_locks common_locks = {
 int ofi_fork_unsafe;
 size_t ofi_universe_size = 1024;
 int ofi_av_remove_cleanup;
+int ofi_av_compact;
 char *ofi_offload_coll_prov_name = NULL;
+char *ofi_getinfo_cache_dir;
 
 
 void ofi_params_init(void)
@@ -96,8 +98,10 @@ void ofi_params_init(void)
 	fi_param_get_bool(NULL, "fork_unsafe", &ofi_fork_unsafe);
 	fi_param_get_size_t(NULL, "universe_size", &ofi_universe_size);
 	fi_param_get_bool(NULL, "av_remove_cleanup", &ofi_av_remove_cleanup);
+	fi_param_get_bool(NULL, "av_compact", &ofi_av_compact);
 	fi_param_get_str(NULL, "offload_coll_provider",
 			 &ofi_offload_coll_prov_name);
+	fi_param_get_str(NULL, "getinfo_cache_dir", &ofi_getinfo_cache_dir);
 }
 
 int ofi_genlock_init(struct ofi_genlock *lock,
@@ -1165,9 +1169,17 @@ int ofi_bsock_flush(struct ofi_bsock *bsock)
 
 	avail = ofi_byteq_readable(&bsock->sq);
 	assert(avail);
-	ret = bsock->sockapi->send(bsock->sockapi, bsock->sock,
-				   &bsock->sq.data[bsock->sq.head],
-				   avail, MSG_NOSIGNAL, &bsock->tx_sockctx);
+	if (bsock->sq_fixed >= 0) {
+		ret = bsock->sockapi->send_fixed(bsock->sockapi, bsock->sock,
+						 &bsock->sq.data[bsock->sq.head],
+						 avail, bsock->sq_fixed,
+						 &bsock->tx_sockctx);
+	} else {
+		ret = bsock->sockapi->send(bsock->sockapi, bsock->sock,
+					   &bsock->sq.data[bsock->sq.head],
+					   avail, MSG_NOSIGNAL,
+					   &bsock->tx_sockctx);
+	}
 	if (ret < 0)
 		return ret;
 
@@ -1306,8 +1318,99 @@ int ofi_bsock_sendv(struct ofi_bsock *bsock, const struct iovec *iov,
 	return 0;
 }
 
+/* Copy data received into provided buffers, releasing emptied buffers */
+static size_t ofi_bsock_pbuf_read(struct ofi_bsock *bsock,
+				  const struct iovec *iov, size_t cnt,
+				  size_t offset)
+{
+	struct ofi_sockapi_uring *uring = &bsock->sockapi->rx_uring;
+	struct ofi_bsock_pbuf *pbuf;
+	size_t bytes, total = 0;
+
+	while (bsock->pbuf_cnt) {
+		pbuf = &bsock->pbufs[bsock->pbuf_head];
+		bytes = ofi_copy_iov_buf(iov, cnt, offset + total,
+					 uring->pbuf_data +
+					 pbuf->bid * uring->pbuf_size + pbuf->off,
+					 pbuf->len, OFI_COPY_BUF_TO_IOV);
+		total += bytes;
+		bsock->pbuf_bytes -= bytes;
+		pbuf->off += (uint32_t) bytes;
+		pbuf->len -= (uint32_t) bytes;
+		if (pbuf->len)
+			break;
+
+		ofi_uring_pbuf_recycle(uring, pbuf->bid);
+		bsock->pbuf_head = (bsock->pbuf_head + 1) % OFI_URING_PBUF_CNT;
+		bsock->pbuf_cnt--;
+	}
+	return total;
+}
+
+void ofi_bsock_pbuf_release(struct ofi_bsock *bsock)
+{
+	struct ofi_bsock_pbuf *pbuf;
+
+	while (bsock->pbuf_cnt) {
+		pbuf = &bsock->pbufs[bsock->pbuf_head];
+		ofi_uring_pbuf_recycle(&bsock->sockapi->rx_uring, pbuf->bid);
+		bsock->pbuf_head = (bsock->pbuf_head + 1) % OFI_URING_PBUF_CNT;
+		bsock->pbuf_cnt--;
+	}
+	bsock->pbuf_bytes = 0;
+}
+
+/* Small receives are served by a multishot receive into provided buffers,
+ * which stays armed across calls.  Receives large enough to bypass rq are
+ * placed directly into the user's buffer, so the multishot receive is
+ * canceled for them.  Returns -FI_ENOSYS if the caller should issue a
+ * regular receive.
+ */
+static ssize_t ofi_bsock_mshot(struct ofi_bsock *bsock, size_t len)
+{
+	struct ofi_sockapi *sockapi = bsock->sockapi;
+
+	if (bsock->mshot_sockctx.uring_sqe_inuse) {
+		if (len >= (bsock->rq.size >> 1) &&
+		    !bsock->cancel_sockctx.uring_sqe_inuse) {
+			/* If the cancel can't be queued, we retry on the
+			 * next completion of the multishot receive.
+			 */
+			(void) ofi_sockctx_uring_cancel(&sockapi->rx_uring,
+							&bsock->mshot_sockctx,
+							&bsock->cancel_sockctx);
+		}
+		return -OFI_EINPROGRESS_URING;
+	}
+
+	/* A pending cancel would match a re-armed receive */
+	if (!sockapi->rx_uring.mshot || bsock->mshot_nobufs ||
+	    bsock->rx_sockctx.uring_sqe_inuse ||
+	    bsock->cancel_sockctx.uring_sqe_inuse ||
+	    len >= (bsock->rq.size >> 1))
+		return -FI_ENOSYS;
+
+	return sockapi->recv_multishot(sockapi, bsock->sock,
+				       &bsock->mshot_sockctx);
+}
+
+static ssize_t ofi_bsock_prefetch(struct ofi_bsock *bsock, size_t avail)
+{
+	if (bsock->rq_fixed >= 0) {
+		return bsock->sockapi->recv_fixed(bsock->sockapi, bsock->sock,
+						  &bsock->rq.data[bsock->rq.tail],
+						  avail, bsock->rq_fixed,
+						  &bsock->rx_sockctx);
+	}
+
+	return bsock->sockapi->recv(bsock->sockapi, bsock->sock,
+				    &bsock->rq.data[bsock->rq.tail],
+				    avail, MSG_NOSIGNAL, &bsock->rx_sockctx);
+}
+
 int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 {
+	struct iovec iov;
 	size_t bytes, avail = 0;
 	ssize_t ret;
 
@@ -1321,13 +1424,29 @@ int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 		*len -= bytes;
 	}
 
+	if (bsock->pbuf_cnt) {
+		iov.iov_base = buf;
+		iov.iov_len = *len;
+		ret = ofi_bsock_pbuf_read(bsock, &iov, 1, 0);
+		bytes += ret;
+		if ((size_t) ret == *len) {
+			*len = bytes;
+			return 0;
+		}
+
+		buf = (char *) buf + ret;
+		*len -= ret;
+	}
+
 	assert(!ofi_bsock_readable(bsock));
+	ret = ofi_bsock_mshot(bsock, *len);
+	if (ret != -FI_ENOSYS)
+		goto out;
+
 	if (*len < (bsock->rq.size >> 1)) {
 		avail = ofi_byteq_writeable(&bsock->rq);
 		assert(avail);
-		ret = bsock->sockapi->recv(bsock->sockapi, bsock->sock,
-					   &bsock->rq.data[bsock->rq.tail],
-					   avail, MSG_NOSIGNAL, &bsock->rx_sockctx);
+		ret = ofi_bsock_prefetch(bsock, avail);
 		if (ret <= 0)
 			goto out;
 
@@ -1380,13 +1499,26 @@ int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov, size_t cnt,
 		bytes = 0;
 	}
 
+	if (bsock->pbuf_cnt) {
+		ret = ofi_bsock_pbuf_read(bsock, iov, cnt, bytes);
+		bytes += ret;
+		if ((size_t) ret == *len) {
+			*len = bytes;
+			return 0;
+		}
+
+		*len -= ret;
+	}
+
 	assert(!ofi_bsock_readable(bsock));
+	ret = ofi_bsock_mshot(bsock, *len);
+	if (ret != -FI_ENOSYS)
+		goto out;
+
 	if (*len < (bsock->rq.size >> 1)) {
 		avail = ofi_byteq_writeable(&bsock->rq);
 		assert(avail);
-		ret = bsock->sockapi->recv(bsock->sockapi, bsock->sock,
-					   &bsock->rq.data[bsock->rq.tail],
-					   avail, MSG_NOSIGNAL, &bsock->rx_sockctx);
+		ret = ofi_bsock_prefetch(bsock, avail);
 		if (ret <= 0)
 			goto out;
 
@@ -1432,6 +1564,85 @@ void ofi_bsock_prefetch_done(struct ofi_bsock *bsock, size_t len)
 	ofi_byteq_add(&bsock->rq, len);
 	assert(ofi_bsock_readable(bsock));
 	bsock->async_prefetch = false;
+	bsock->mshot_nobufs = false;
+}
+
+/* Handle a completion of the multishot receive.  A terminal completion
+ * that leaves the socket usable returns 0; the next receive re-arms it or
+ * falls back to regular receives.
+ */
+int ofi_bsock_mshot_done(struct ofi_bsock *bsock, int res, uint32_t flags)
+{
+	struct ofi_sockapi_uring *uring = &bsock->sockapi->rx_uring;
+	struct ofi_bsock_pbuf *pbuf;
+	uint16_t bid;
+
+	if (flags & IORING_CQE_F_BUFFER) {
+		bid = (uint16_t) (flags >> IORING_CQE_BUFFER_SHIFT);
+		if (res > 0) {
+			assert(bsock->pbuf_cnt < OFI_URING_PBUF_CNT);
+			pbuf = &bsock->pbufs[(bsock->pbuf_head +
+					      bsock->pbuf_cnt) %
+					     OFI_URING_PBUF_CNT];
+			pbuf->bid = bid;
+			pbuf->off = 0;
+			pbuf->len = (uint32_t) res;
+			bsock->pbuf_cnt++;
+			bsock->pbuf_bytes += res;
+		} else {
+			ofi_uring_pbuf_recycle(uring, bid);
+		}
+	}
+
+	if (res > 0 || (flags & IORING_CQE_F_MORE))
+		return 0;
+
+	switch (res) {
+	case 0:
+		return -FI_ENOTCONN;
+	case -ECANCELED:
+		return 0;
+	case -ENOBUFS:
+		/* Use rq until buffers are returned to the ring */
+		bsock->mshot_nobufs = true;
+		return 0;
+	case -EINVAL:
+		/* Multishot receive is not supported by the kernel */
+		uring->mshot = false;
+		return 0;
+	default:
+		return res;
+	}
+}
+
+void ofi_bsock_reg_fixed(struct ofi_bsock *bsock)
+{
+	int ret;
+
+	if (bsock->sq_fixed < 0) {
+		ret = ofi_uring_fixed_add(&bsock->sockapi->tx_uring,
+					  bsock->sq.data, sizeof(bsock->sq.data));
+		bsock->sq_fixed = ret < 0 ? -1 : ret;
+	}
+
+	if (bsock->rq_fixed < 0) {
+		ret = ofi_uring_fixed_add(&bsock->sockapi->rx_uring,
+					  bsock->rq.data, sizeof(bsock->rq.data));
+		bsock->rq_fixed = ret < 0 ? -1 : ret;
+	}
+}
+
+void ofi_bsock_dereg_fixed(struct ofi_bsock *bsock)
+{
+	if (bsock->sq_fixed >= 0) {
+		ofi_uring_fixed_del(&bsock->sockapi->tx_uring, bsock->sq_fixed);
+		bsock->sq_fixed = -1;
+	}
+
+	if (bsock->rq_fixed >= 0) {
+		ofi_uring_fixed_del(&bsock->sockapi->rx_uring, bsock->rq_fixed);
+		bsock->rq_fixed = -1;
+	}
 }
 
 #ifdef MSG_ZEROCOPY
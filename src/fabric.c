@@ -51,6 +51,7 @@
 #include "ofi_perf.h"
 #include "ofi_hmem.h"
 #include "ofi_mr.h"
+#include "ofi_atomic.h"
 #include <ofi_shm_p2p.h>
 #include <rdma/fi_ext.h>
 
@@ -64,6 +65,7 @@ struct ofi_prov {
 	char			*prov_name;
 	struct fi_provider	*provider;
 	void			*dlhandle;
+	char			*dl_lib;	/* not opened yet */
 	bool			hidden;
 	bool			preferred;
 };
@@ -133,6 +135,7 @@ static void ofi_cleanup_prov(struct fi_provider *provider, void *dlhandle)
 static void ofi_free_prov(struct ofi_prov *prov)
 {
 	ofi_cleanup_prov(prov->provider, prov->dlhandle);
+	free(prov->dl_lib);
 	free(prov->prov_name);
 	free(prov);
 }
@@ -424,6 +427,36 @@ static struct ofi_prov *ofi_getprov(const char *prov_name, size_t len)
 	return NULL;
 }
 
+static void ofi_load_deferred_prov(struct ofi_prov *prov);
+
+/* Open the deferred library of every provider called name, or of all */
+static void ofi_load_deferred_provs(const char *name, size_t len)
+{
+	struct ofi_prov *prov;
+
+	for (prov = prov_head; prov; prov = prov->next) {
+		if (prov->dl_lib &&
+		    (!name || ((strlen(prov->prov_name) == len) &&
+			       !strncasecmp(prov->prov_name, name, len))))
+			ofi_load_deferred_prov(prov);
+	}
+}
+
+/* Same for every provider named in a layered "core;util" name */
+static void ofi_load_deferred_layers(const char *names)
+{
+	const char *end;
+
+	for (;;) {
+		end = strchr(names, OFI_NAME_DELIM);
+		ofi_load_deferred_provs(names, end ? end - names :
+						     strlen(names));
+		if (!end)
+			break;
+		names = end + 1;
+	}
+}
+
 static struct fi_provider *ofi_get_hook(const char *name)
 {
 	struct ofi_prov *prov;
@@ -431,13 +464,16 @@ static struct fi_provider *ofi_get_hook(const char *name)
 	char *try_name = NULL;
 	int ret;
 
+	ofi_load_deferred_provs(name, strlen(name));
 	prov = ofi_getprov(name, strlen(name));
 	if (!prov) {
 		ret = asprintf(&try_name, "ofi_hook_%s", name);
-		if (ret > 0)
+		if (ret > 0) {
+			ofi_load_deferred_provs(try_name, ret);
 			prov = ofi_getprov(try_name, ret);
-		else
+		} else {
 			try_name = NULL;
+		}
 	}
 
 	if (prov) {
@@ -663,6 +699,7 @@ static void ofi_reg_dl_prov(const char *lib, bool lib_known_to_exist)
 {
 	void *dlhandle;
 	struct fi_provider* (*inif)(void);
+	struct fi_provider *provider;
 
 	FI_DBG(&core_prov, FI_LOG_CORE, "opening provider lib %s\n", lib);
 
@@ -683,14 +720,63 @@ static void ofi_reg_dl_prov(const char *lib, bool lib_known_to_exist)
 		FI_WARN(&core_prov, FI_LOG_CORE, "dlsym: %s\n", dlerror());
 		dlclose(dlhandle);
 	} else {
-		ofi_register_provider((inif)(), dlhandle);
+		provider = inif();
+		if (provider && provider->name)
+			ofi_prov_cache_update(lib, provider->name);
+		ofi_register_provider(provider, dlhandle);
 	}
 }
 
+/*
+ * A library that is known to register prov_name is only opened when the
+ * provider is needed.  Libraries that compete with another one of the same
+ * name are opened right away, so that the usual ordering rules apply.
+ */
+static bool ofi_defer_dl_prov(const char *lib, const char *prov_name)
+{
+	struct ofi_prov *prov;
+
+	if (prov_order == OFI_PROV_ORDER_REGISTER)
+		return false;
+
+	prov = ofi_getprov(prov_name, strlen(prov_name));
+	if (prov && (prov->provider || prov->dl_lib))
+		return false;
+
+	if (!prov) {
+		prov = ofi_alloc_prov(prov_name);
+		if (!prov)
+			return false;
+		ofi_insert_prov(prov);
+	}
+
+	prov->dl_lib = strdup(lib);
+	if (!prov->dl_lib)
+		return false;
+
+	FI_DBG(&core_prov, FI_LOG_CORE, "deferring provider lib %s (%s)\n",
+	       lib, prov_name);
+	return true;
+}
+
+static void ofi_load_deferred_prov(struct ofi_prov *prov)
+{
+	char *lib;
+
+	pthread_mutex_lock(&common_locks.ini_lock);
+	lib = prov->dl_lib;
+	prov->dl_lib = NULL;
+	if (lib)
+		ofi_reg_dl_prov(lib, true);
+	pthread_mutex_unlock(&common_locks.ini_lock);
+	free(lib);
+}
+
 static void ofi_ini_dir(const char *dir)
 {
 	int n;
 	char *lib;
+	const char *prov_name;
 	struct dirent **liblist = NULL;
 
 	n = scandir(dir, &liblist, lib_filter, alphasort);
@@ -703,7 +789,10 @@ static void ofi_ini_dir(const char *dir)
 			       "asprintf failed to allocate memory\n");
 			goto libdl_done;
 		}
-		ofi_reg_dl_prov(lib, true);
+
+		prov_name = ofi_prov_cache_lookup(lib);
+		if (!prov_name || !ofi_defer_dl_prov(lib, prov_name))
+			ofi_reg_dl_prov(lib, true);
 
 		free(liblist[n]);
 		free(lib);
@@ -860,6 +949,10 @@ static void ofi_load_dl_prov(void)
 {
 }
 
+static void ofi_load_deferred_prov(struct ofi_prov *prov)
+{
+}
+
 #endif
 
 static char **hooks;
@@ -914,6 +1007,27 @@ static void ofi_hook_init(void)
 	hooks = ofi_split_and_alloc(param_val, ";", &hook_cnt);
 }
 
+static void ofi_reduce_init(void)
+{
+	char *param_val = NULL;
+
+	fi_param_define(NULL, "reduce_simd", FI_PARAM_STRING,
+			"Vector instruction set used by local reductions: "
+			"auto, scalar, v128, avx2 or avx512 (default: auto)");
+	fi_param_get_str(NULL, "reduce_simd", &param_val);
+
+	if (param_val && ofi_reduce_select(param_val)) {
+		FI_WARN(&core_prov, FI_LOG_CORE,
+			"unsupported FI_REDUCE_SIMD value %s\n", param_val);
+		param_val = NULL;
+	}
+	if (!param_val)
+		(void) ofi_reduce_select("auto");
+
+	FI_INFO(&core_prov, FI_LOG_CORE, "local reductions use %s kernels\n",
+		ofi_reduce_simd_isa);
+}
+
 static void ofi_hook_fini(void)
 {
 	if (hooks)
@@ -937,6 +1051,7 @@ void fi_ini(void)
 	ofi_mem_init();
 	ofi_pmem_init();
 	ofi_perf_init();
+	ofi_reduce_init();
 	ofi_hook_init();
 	ofi_hmem_init();
 	ofi_monitors_init();
@@ -969,13 +1084,32 @@ void fi_ini(void)
 			"address is removed from the local AV.  "
 			"(default: false)");
 
+	fi_param_define(NULL, "av_compact", FI_PARAM_BOOL,
+			"When true, FI_AV_TABLE address vectors built on the "
+			"common AV code skip the address to fi_addr hash on "
+			"insert and build it the first time a provider needs "
+			"a reverse lookup.  This speeds up inserting large "
+			"AVs, but duplicate addresses inserted before the "
+			"first lookup are given separate fi_addr's.  "
+			"(default: false)");
+
 	fi_param_define(NULL, "offload_coll_provider", FI_PARAM_STRING,
 			"The name of a colective offload provider (default: \
 			empty - no provider)");
 
+	fi_param_define(NULL, "getinfo_cache_dir", FI_PARAM_STRING,
+			"Existing directory where the list of provider "
+			"libraries and fi_getinfo results are cached across "
+			"runs.  Unchanged provider libraries are only opened "
+			"when needed, and repeated fi_getinfo calls with the "
+			"same arguments, environment and network interfaces "
+			"are answered from the cache (default: none)");
+
 	ofi_params_init();
 
+	ofi_getinfo_cache_init();
 	ofi_load_dl_prov();
+	ofi_prov_cache_flush();
 
 	ofi_register_provider(PSM3_INIT, NULL);
 	ofi_register_provider(PSM2_INIT, NULL);
@@ -1031,6 +1165,7 @@ FI_DESTRUCTOR(fi_fini(void))
 	}
 
 	ofi_free_filter(&prov_filter);
+	ofi_getinfo_cache_fini();
 	ofi_shm_p2p_cleanup();
 	ofi_monitors_cleanup();
 	ofi_hmem_cleanup();
@@ -1174,6 +1309,8 @@ static int ofi_getprovinfo(struct fi_info **info)
 	struct fi_info *tail, *cur;
 	int ret = -FI_ENODATA;
 
+	ofi_load_deferred_provs(NULL, 0);
+
 	*info = tail = NULL;
 	for (prov = prov_head; prov; prov = prov->next) {
 		if (!prov->provider)
@@ -1314,16 +1451,119 @@ static int ofi_layering_ok(const struct fi_provider *provider,
 	return !strcasecmp(provider->name, prov_name);
 }
 
+/*
+ * A deferred core provider is not opened if its name alone shows that
+ * fi_getinfo() would skip it.  Utility, offload and lnx providers may layer
+ * over any core provider, so they are always opened.
+ */
+static bool ofi_deferred_prov_excluded(struct ofi_prov *prov, char **prov_vec,
+				       size_t count, uint64_t flags)
+{
+	size_t i;
+
+	if (ofi_has_util_prefix(prov->prov_name) ||
+	    ofi_has_offload_prefix(prov->prov_name) ||
+	    ofi_is_lnx(prov->prov_name))
+		return false;
+
+	if (!(flags & OFI_GETINFO_HIDDEN) &&
+	    ofi_apply_prov_init_filter(&prov_filter, prov->prov_name))
+		return true;
+
+	/* Excluded ("^") names are at the end of the list */
+	for (i = 0; i < count && prov_vec[i][0] != '^'; i++) {
+		if (!strcasecmp(prov_vec[i], prov->prov_name))
+			return false;
+	}
+	return i > 0;
+}
+
+/* Returns -FI_ENODATA if the provider was skipped */
+static int ofi_getinfo_prov(struct ofi_prov *prov, uint32_t version,
+			    const char *node, const char *service,
+			    uint64_t flags, const struct fi_info *hints,
+			    char **prov_vec, size_t count,
+			    struct fi_info **info)
+{
+	struct fi_info *cur;
+	enum fi_log_level level;
+	int ret;
+
+	*info = NULL;
+	if (!prov->provider) {
+		if (ofi_deferred_prov_excluded(prov, prov_vec, count, flags))
+			return -FI_ENODATA;
+
+		ofi_load_deferred_prov(prov);
+		if (!prov->provider)
+			return -FI_ENODATA;
+	}
+
+	if (!prov->provider->getinfo)
+		return -FI_ENODATA;
+
+	if (prov->hidden && !(flags & OFI_GETINFO_HIDDEN))
+		return -FI_ENODATA;
+
+	if ((ofi_prov_ctx(prov->provider)->type == OFI_PROV_OFFLOAD) &&
+	    !(flags & OFI_OFFLOAD_PROV_ONLY))
+		return -FI_ENODATA;
+
+	if (!ofi_layering_ok(prov->provider, prov_vec, count, flags))
+		return -FI_ENODATA;
+
+	if (FI_VERSION_LT(prov->provider->fi_version, version)) {
+		FI_WARN(&core_prov, FI_LOG_CORE,
+			"Provider %s fi_version %d.%d < requested %d.%d\n",
+			prov->provider->name,
+			FI_MAJOR(prov->provider->fi_version),
+			FI_MINOR(prov->provider->fi_version),
+			FI_MAJOR(version), FI_MINOR(version));
+		return -FI_ENODATA;
+	}
+
+	ret = prov->provider->getinfo(version, node, service, flags,
+				      hints, info);
+	if (ret) {
+		level = ((hints && hints->fabric_attr &&
+			  hints->fabric_attr->prov_name &&
+			  !strcmp(hints->fabric_attr->prov_name, prov->provider->name)) ?
+			 FI_LOG_WARN : FI_LOG_INFO);
+
+		FI_LOG(&core_prov, level, FI_LOG_CORE,
+		       "fi_getinfo: provider %s returned -%d (%s)\n",
+		       prov->provider->name, -ret, fi_strerror(-ret));
+		*info = NULL;
+		return ret;
+	}
+
+	if (!*info) {
+		FI_WARN(&core_prov, FI_LOG_CORE,
+			"fi_getinfo: provider %s output empty list\n",
+			prov->provider->name);
+		return 0;
+	}
+
+	FI_DBG(&core_prov, FI_LOG_CORE, "fi_getinfo: provider %s "
+	       "returned success\n", prov->provider->name);
+
+	for (cur = *info; cur; cur = cur->next) {
+		ofi_set_prov_attr(cur->fabric_attr, prov->provider);
+		cur->fabric_attr->api_version = version;
+	}
+	return 0;
+}
+
 __attribute__((visibility ("default"),EXTERNALLY_VISIBLE))
 int DEFAULT_SYMVER_PRE(fi_getinfo)(uint32_t version, const char *node,
 		const char *service, uint64_t flags,
 		const struct fi_info *hints, struct fi_info **info)
 {
+	struct ofi_getinfo_cache *cache;
 	struct ofi_prov *prov;
 	struct fi_info *tail, *cur;
 	char **prov_vec = NULL;
 	size_t count = 0;
-	enum fi_log_level level;
 	int ret;
 
 	fi_ini();
@@ -1347,68 +1587,32 @@ int DEFAULT_SYMVER_PRE(fi_getinfo)(uint32_t version, const char *node,
 		       hints->fabric_attr->prov_name);
 	}
 
+	cache = ofi_getinfo_cache_open(version, node, service, flags, hints);
+
 	*info = tail = NULL;
 	for (prov = prov_head; prov; prov = prov->next) {
-		if (!prov->provider || !prov->provider->getinfo)
-			continue;
-
-		if (prov->hidden && !(flags & OFI_GETINFO_HIDDEN))
-			continue;
-
-		if ((ofi_prov_ctx(prov->provider)->type == OFI_PROV_OFFLOAD) &&
-		    !(flags & OFI_OFFLOAD_PROV_ONLY))
-			continue;
-
-		if (!ofi_layering_ok(prov->provider, prov_vec, count, flags))
+		if (!prov->provider && !prov->dl_lib)
 			continue;
 
-		if (FI_VERSION_LT(prov->provider->fi_version, version)) {
-			FI_WARN(&core_prov, FI_LOG_CORE,
-				"Provider %s fi_version %d.%d < requested %d.%d\n",
-				prov->provider->name,
-				FI_MAJOR(prov->provider->fi_version),
-				FI_MINOR(prov->provider->fi_version),
-				FI_MAJOR(version), FI_MINOR(version));
-			continue;
+		if (ofi_getinfo_cache_get(cache, prov->prov_name, &cur)) {
+			ret = ofi_getinfo_prov(prov, version, node, service,
+					       flags, hints, prov_vec, count,
+					       &cur);
+			ofi_getinfo_cache_put(cache, prov->prov_name, cur, ret);
 		}
 
-		cur = NULL;
-		ret = prov->provider->getinfo(version, node, service, flags,
-					      hints, &cur);
-		if (ret) {
-			level = ((hints && hints->fabric_attr &&
-				  hints->fabric_attr->prov_name &&
-				  !strcmp(hints->fabric_attr->prov_name, prov->provider->name)) ?
-				 FI_LOG_WARN : FI_LOG_INFO);
-
-			FI_LOG(&core_prov, level, FI_LOG_CORE,
-			       "fi_getinfo: provider %s returned -%d (%s)\n",
-			       prov->provider->name, -ret, fi_strerror(-ret));
+		if (!cur)
 			continue;
-		}
-
-		if (!cur) {
-			FI_WARN(&core_prov, FI_LOG_CORE,
-				"fi_getinfo: provider %s output empty list\n",
-				prov->provider->name);
-			continue;
-		}
-
-		FI_DBG(&core_prov, FI_LOG_CORE, "fi_getinfo: provider %s "
-		       "returned success\n", prov->provider->name);
 
 		if (!*info)
 			*info = cur;
 		else
 			tail->next = cur;
 
-		for (tail = cur; tail->next; tail = tail->next) {
-			ofi_set_prov_attr(tail->fabric_attr, prov->provider);
-			tail->fabric_attr->api_version = version;
-		}
-		ofi_set_prov_attr(tail->fabric_attr, prov->provider);
-		tail->fabric_attr->api_version = version;
+		for (tail = cur; tail->next; tail = tail->next)
+			;
 	}
+	ofi_getinfo_cache_close(cache);
 	ofi_free_string_array(prov_vec);
 
 	if (*info && !(flags & (OFI_CORE_PROV_ONLY | OFI_GETINFO_INTERNAL |
@@ -1577,6 +1781,7 @@ int DEFAULT_SYMVER_PRE(fi_fabric)(struct fi_fabric_attr *attr,
 	if (!top_name)
 		return -FI_EINVAL;
 
+	ofi_load_deferred_layers(attr->prov_name);
 	prov = ofi_getprov(top_name, strlen(top_name));
 	if (!prov || !prov->provider || !prov->provider->fabric)
 		return -FI_ENODEV;
@@ -0,0 +1,1069 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_LIBDL
+#include <dlfcn.h>
+#endif
+
+#include <rdma/fi_errno.h>
+#include "ofi.h"
+#include "ofi_mem.h"
+#include "ofi_util.h"
+#include "ofi_net.h"
+#include "fasthash.h"
+
+/*
+ * Persistent fi_getinfo cache
+ *
+ * When FI_GETINFO_CACHE_DIR is set, two kinds of files are kept there.
+ *
+ * "providers" maps every DL provider library found by the directory scan
+ * to the name of the provider that it registers, along with the mtime,
+ * size and inode of the library.  fi_ini() only records the name of an
+ * unchanged library and leaves the dlopen() until the provider is needed.
+ *
+ * "getinfo-<hash>" holds the outcome of one fi_getinfo() call: a record per
+ * provider, in the order in which fi_getinfo() walks them.  The file name is
+ * a hash of a text key made of everything that can change the answer: the
+ * library and provider library versions, the boot id, the FI_* environment,
+ * the network interfaces and the call arguments.  The full key is stored in
+ * the file and compared on lookup; it holds a hash of each variable's value
+ * rather than the value, which may be a credential.  A provider whose answer
+ * cannot be reused by another process, e.g. an address that embeds the
+ * process id or an authorization key, is stored as uncached and is always
+ * asked again.
+ *
+ * Files are created readable by their owner only.  Files owned by another
+ * user, or writable by group or others, are ignored, so that nobody else
+ * sharing the directory can supply fi_getinfo() results.
+ */
+
+#define OFI_GIC_MAGIC		0x4349474f	/* "OGIC" */
+#define OFI_GIC_FORMAT		2
+#define OFI_GIC_NULL		UINT64_MAX
+#define OFI_GIC_HINTS_LEN	16384
+
+enum {
+	OFI_GIC_REC_NONE,	/* skipped or no matching info */
+	OFI_GIC_REC_INFO,
+	OFI_GIC_REC_UNCACHED,
+};
+
+struct ofi_gic_buf {
+	char		*data;
+	size_t		len;
+	size_t		size;
+	size_t		pos;
+	int		err;
+};
+
+struct ofi_getinfo_cache {
+	char			*path;
+	char			*key;
+	struct ofi_gic_buf	buf;
+	bool			hit;
+	bool			stale;
+};
+
+struct ofi_gic_lib {
+	char		*path;
+	char		*prov_name;
+	int64_t		mtime;
+	uint64_t	size;
+	uint64_t	ino;
+	bool		seen;
+};
+
+static struct ofi_gic_lib *gic_libs;
+static size_t gic_lib_cnt;
+static bool gic_libs_dirty;
+static uint64_t gic_lib_hash;
+
+static int ofi_gic_reserve(struct ofi_gic_buf *buf, size_t len)
+{
+	size_t size;
+	char *data;
+
+	if (buf->err)
+		return buf->err;
+
+	if (buf->len + len <= buf->size)
+		return 0;
+
+	size = MAX(MAX(buf->size * 2, buf->len + len), 4096);
+	data = realloc(buf->data, size);
+	if (!data) {
+		buf->err = -FI_ENOMEM;
+		return buf->err;
+	}
+
+	buf->data = data;
+	buf->size = size;
+	return 0;
+}
+
+static void ofi_gic_put(struct ofi_gic_buf *buf, const void *data, size_t len)
+{
+	if (ofi_gic_reserve(buf, len))
+		return;
+
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+static void ofi_gic_printf(struct ofi_gic_buf *buf, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	if (len < 0) {
+		buf->err = -FI_EINVAL;
+		return;
+	}
+
+	if (ofi_gic_reserve(buf, len + 1))
+		return;
+
+	va_start(ap, fmt);
+	vsnprintf(buf->data + buf->len, len + 1, fmt, ap);
+	va_end(ap);
+	buf->len += len;
+}
+
+static void ofi_gic_put_u32(struct ofi_gic_buf *buf, uint32_t val)
+{
+	ofi_gic_put(buf, &val, sizeof val);
+}
+
+/* Blobs are a 64-bit length followed by the data.  NULL has no data. */
+static void ofi_gic_put_blob(struct ofi_gic_buf *buf, const void *data,
+			     size_t len)
+{
+	uint64_t hdr = data ? len : OFI_GIC_NULL;
+
+	ofi_gic_put(buf, &hdr, sizeof hdr);
+	if (data)
+		ofi_gic_put(buf, data, len);
+}
+
+static void ofi_gic_put_str(struct ofi_gic_buf *buf, const char *str)
+{
+	ofi_gic_put_blob(buf, str, str ? strlen(str) + 1 : 0);
+}
+
+static int ofi_gic_get_u32(struct ofi_gic_buf *buf, uint32_t *val)
+{
+	if (buf->len - buf->pos < sizeof *val)
+		return -FI_EINVAL;
+
+	memcpy(val, buf->data + buf->pos, sizeof *val);
+	buf->pos += sizeof *val;
+	return 0;
+}
+
+/* Returns a reference into the buffer, or NULL for a NULL blob */
+static int ofi_gic_get_ref(struct ofi_gic_buf *buf, const void **data,
+			   size_t *len)
+{
+	uint64_t hdr;
+
+	if (buf->len - buf->pos < sizeof hdr)
+		return -FI_EINVAL;
+
+	memcpy(&hdr, buf->data + buf->pos, sizeof hdr);
+	buf->pos += sizeof hdr;
+	if (hdr == OFI_GIC_NULL) {
+		*data = NULL;
+		*len = 0;
+		return 0;
+	}
+
+	if (hdr > buf->len - buf->pos)
+		return -FI_EINVAL;
+
+	*data = buf->data + buf->pos;
+	*len = hdr;
+	buf->pos += hdr;
+	return 0;
+}
+
+static int ofi_gic_get_blob(struct ofi_gic_buf *buf, void **data, size_t *len)
+{
+	const void *ref;
+	int ret;
+
+	ret = ofi_gic_get_ref(buf, &ref, len);
+	if (ret || !ref) {
+		*data = NULL;
+		return ret;
+	}
+
+	*data = mem_dup(ref, *len);
+	return *data ? 0 : -FI_ENOMEM;
+}
+
+static int ofi_gic_get_str(struct ofi_gic_buf *buf, char **str)
+{
+	const void *ref;
+	size_t len;
+	int ret;
+
+	*str = NULL;
+	ret = ofi_gic_get_ref(buf, &ref, &len);
+	if (ret || !ref)
+		return ret;
+
+	if (!len || ((const char *) ref)[len - 1])
+		return -FI_EINVAL;
+
+	*str = strdup(ref);
+	return *str ? 0 : -FI_ENOMEM;
+}
+
+/* The caller must reset any pointers held by the copied structure */
+static int ofi_gic_get_struct(struct ofi_gic_buf *buf, void *data, size_t size)
+{
+	const void *ref;
+	size_t len;
+	int ret;
+
+	ret = ofi_gic_get_ref(buf, &ref, &len);
+	if (ret)
+		return ret;
+
+	if (!ref || len != size)
+		return -FI_EINVAL;
+
+	memcpy(data, ref, size);
+	return 0;
+}
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+static void ofi_gic_write(const char *path, const void *data, size_t len)
+{
+	char *tmp;
+	FILE *f;
+	int fd, ret;
+
+	if (asprintf(&tmp, "%s.%d", path, getpid()) < 0)
+		return;
+
+	fd = open(tmp, O_CREAT | O_EXCL | O_WRONLY | O_BINARY, 0600);
+	if (fd < 0)
+		goto out;
+
+	f = fdopen(fd, "wb");
+	if (!f) {
+		close(fd);
+		unlink(tmp);
+		goto out;
+	}
+
+	ret = fwrite(data, 1, len, f) != len;
+	ret |= fclose(f);
+	if (ret || rename(tmp, path)) {
+		FI_DBG(&core_prov, FI_LOG_CORE,
+		       "unable to write getinfo cache %s\n", path);
+		unlink(tmp);
+	}
+out:
+	free(tmp);
+}
+
+/* Opens a file that only the current user can have written */
+static FILE *ofi_gic_open(const char *path, const char *mode,
+			  struct stat *st)
+{
+	FILE *f;
+
+	f = fopen(path, mode);
+	if (!f)
+		return NULL;
+
+	if (fstat(fileno(f), st) || !S_ISREG(st->st_mode))
+		goto err;
+#ifndef _WIN32
+	if (st->st_uid != geteuid() || (st->st_mode & (S_IWGRP | S_IWOTH))) {
+		FI_INFO(&core_prov, FI_LOG_CORE,
+			"ignoring getinfo cache %s not owned by this user "
+			"or writable by others\n", path);
+		goto err;
+	}
+#endif
+	return f;
+err:
+	fclose(f);
+	return NULL;
+}
+
+static int ofi_gic_read(const char *path, struct ofi_gic_buf *buf)
+{
+	struct stat st;
+	FILE *f;
+	int ret = -FI_ENODATA;
+
+	f = ofi_gic_open(path, "rb", &st);
+	if (!f)
+		return ret;
+
+	if (!st.st_size)
+		goto out;
+
+	buf->data = malloc(st.st_size);
+	if (!buf->data)
+		goto out;
+
+	buf->size = st.st_size;
+	buf->len = fread(buf->data, 1, st.st_size, f);
+	if (buf->len == buf->size)
+		ret = 0;
+out:
+	fclose(f);
+	return ret;
+}
+
+static uint64_t ofi_gic_lib_hash(const char *path, const struct stat *st)
+{
+	uint64_t val[3] = { st->st_mtime, st->st_size, st->st_ino };
+
+	return fasthash64(val, sizeof val, fasthash64(path, strlen(path), 0));
+}
+
+static struct ofi_gic_lib *ofi_gic_find_lib(const char *path)
+{
+	size_t i;
+
+	for (i = 0; i < gic_lib_cnt; i++) {
+		if (!strcmp(gic_libs[i].path, path))
+			return &gic_libs[i];
+	}
+	return NULL;
+}
+
+static struct ofi_gic_lib *ofi_gic_add_lib(const char *path)
+{
+	struct ofi_gic_lib *libs, *lib;
+
+	libs = realloc(gic_libs, (gic_lib_cnt + 1) * sizeof(*gic_libs));
+	if (!libs)
+		return NULL;
+
+	gic_libs = libs;
+	lib = &gic_libs[gic_lib_cnt];
+	memset(lib, 0, sizeof(*lib));
+	lib->path = strdup(path);
+	if (!lib->path)
+		return NULL;
+
+	gic_lib_cnt++;
+	return lib;
+}
+
+static void ofi_gic_load_libs(void)
+{
+	struct ofi_gic_lib *lib;
+	char *path, *line, name[64];
+	int64_t mtime;
+	uint64_t size, ino;
+	size_t len;
+	struct stat st;
+	FILE *f;
+	int n;
+
+	if (asprintf(&path, "%s/providers", ofi_getinfo_cache_dir) < 0)
+		return;
+
+	f = ofi_gic_open(path, "r", &st);
+	free(path);
+	if (!f)
+		return;
+
+	line = malloc(PATH_MAX + 128);
+	if (!line)
+		goto out;
+
+	while (fgets(line, PATH_MAX + 128, f)) {
+		if (sscanf(line, "%" SCNd64 " %" SCNu64 " %" SCNu64 " %63s %n",
+			   &mtime, &size, &ino, name, &n) < 4)
+			continue;
+
+		len = strlen(line + n);
+		if (len && line[n + len - 1] == '\n')
+			line[n + len - 1] = '\0';
+		if (!line[n] || ofi_gic_find_lib(line + n))
+			continue;
+
+		lib = ofi_gic_add_lib(line + n);
+		if (!lib)
+			break;
+
+		lib->prov_name = strdup(name);
+		lib->mtime = mtime;
+		lib->size = size;
+		lib->ino = ino;
+	}
+	free(line);
+out:
+	fclose(f);
+}
+
+void ofi_getinfo_cache_init(void)
+{
+#ifdef HAVE_LIBDL
+	Dl_info dl_info;
+	struct stat st;
+#endif
+
+	if (!ofi_getinfo_cache_dir || !*ofi_getinfo_cache_dir)
+		return;
+
+#ifdef HAVE_LIBDL
+	/* Development builds do not bump the version on every rebuild */
+	if (dladdr((void *) ofi_getinfo_cache_init, &dl_info) &&
+	    dl_info.dli_fname && !stat(dl_info.dli_fname, &st))
+		gic_lib_hash = ofi_gic_lib_hash(dl_info.dli_fname, &st);
+#endif
+
+	ofi_gic_load_libs();
+}
+
+void ofi_getinfo_cache_fini(void)
+{
+	size_t i;
+
+	for (i = 0; i < gic_lib_cnt; i++) {
+		free(gic_libs[i].path);
+		free(gic_libs[i].prov_name);
+	}
+	free(gic_libs);
+	gic_libs = NULL;
+	gic_lib_cnt = 0;
+	gic_libs_dirty = false;
+	gic_lib_hash = 0;
+}
+
+/*
+ * Returns the name of the provider registered by lib if the library is
+ * unchanged since it was last opened.  Every library passed in becomes part
+ * of the key of the fi_getinfo results.
+ */
+const char *ofi_prov_cache_lookup(const char *lib)
+{
+	struct ofi_gic_lib *entry;
+	struct stat st;
+
+	if (!ofi_getinfo_cache_dir || !*ofi_getinfo_cache_dir ||
+	    stat(lib, &st))
+		return NULL;
+
+	gic_lib_hash += ofi_gic_lib_hash(lib, &st);
+
+	entry = ofi_gic_find_lib(lib);
+	if (!entry || !entry->prov_name || entry->mtime != st.st_mtime ||
+	    entry->size != st.st_size || entry->ino != st.st_ino)
+		return NULL;
+
+	entry->seen = true;
+	return entry->prov_name;
+}
+
+void ofi_prov_cache_update(const char *lib, const char *prov_name)
+{
+	struct ofi_gic_lib *entry;
+	struct stat st;
+
+	if (!ofi_getinfo_cache_dir || !*ofi_getinfo_cache_dir ||
+	    stat(lib, &st))
+		return;
+
+	entry = ofi_gic_find_lib(lib);
+	if (!entry) {
+		entry = ofi_gic_add_lib(lib);
+		if (!entry)
+			return;
+	}
+
+	entry->seen = true;
+	if (entry->prov_name && !strcmp(entry->prov_name, prov_name) &&
+	    entry->mtime == st.st_mtime && entry->size == st.st_size &&
+	    entry->ino == st.st_ino)
+		return;
+
+	free(entry->prov_name);
+	entry->prov_name = strdup(prov_name);
+	entry->mtime = st.st_mtime;
+	entry->size = st.st_size;
+	entry->ino = st.st_ino;
+	gic_libs_dirty = true;
+}
+
+/* Rewrite the provider list if the directory scan found any change */
+void ofi_prov_cache_flush(void)
+{
+	struct ofi_gic_buf buf = { 0 };
+	char *path;
+	size_t i;
+
+	if (!ofi_getinfo_cache_dir || !*ofi_getinfo_cache_dir)
+		return;
+
+	for (i = 0; i < gic_lib_cnt; i++) {
+		if (!gic_libs[i].seen || !gic_libs[i].prov_name)
+			gic_libs_dirty = true;
+	}
+
+	if (!gic_libs_dirty)
+		return;
+
+	for (i = 0; i < gic_lib_cnt; i++) {
+		if (!gic_libs[i].seen || !gic_libs[i].prov_name)
+			continue;
+
+		ofi_gic_printf(&buf, "%" PRId64 " %" PRIu64 " %" PRIu64
+			       " %s %s\n", gic_libs[i].mtime, gic_libs[i].size,
+			       gic_libs[i].ino, gic_libs[i].prov_name,
+			       gic_libs[i].path);
+	}
+
+	if (!buf.err &&
+	    asprintf(&path, "%s/providers", ofi_getinfo_cache_dir) >= 0) {
+		ofi_gic_write(path, buf.data, buf.len);
+		free(path);
+		gic_libs_dirty = false;
+	}
+	free(buf.data);
+}
+
+static void ofi_gic_key_boot(struct ofi_gic_buf *key)
+{
+	char boot_id[64] = "";
+	FILE *f;
+
+	f = fopen("/proc/sys/kernel/random/boot_id", "r");
+	if (f) {
+		if (!fgets(boot_id, sizeof boot_id, f))
+			boot_id[0] = '\0';
+		fclose(f);
+	}
+
+	ofi_gic_printf(key, "boot %s\n", boot_id);
+}
+
+static int ofi_gic_env_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+/*
+ * Logging settings are the only FI_* variables that cannot change results.
+ * Values are hashed so that credentials passed through the environment do
+ * not end up in the cache.
+ */
+static void ofi_gic_key_env(struct ofi_gic_buf *key)
+{
+	char **vars, *val;
+	size_t i, len, cnt = 0;
+
+	for (i = 0; environ[i]; i++)
+		;
+
+	vars = calloc(i + 1, sizeof(*vars));
+	if (!vars) {
+		key->err = -FI_ENOMEM;
+		return;
+	}
+
+	for (i = 0; environ[i]; i++) {
+		if (!strncmp(environ[i], "FI_", 3) &&
+		    strncmp(environ[i], "FI_LOG_", 7))
+			vars[cnt++] = environ[i];
+	}
+	qsort(vars, cnt, sizeof(*vars), ofi_gic_env_cmp);
+
+	for (i = 0; i < cnt; i++) {
+		val = strchr(vars[i], '=');
+		len = val ? (size_t) (val - vars[i]) : strlen(vars[i]);
+		ofi_gic_printf(key, "env %.*s %016" PRIx64 "\n", (int) len,
+			       vars[i], val ? fasthash64(val + 1,
+							 strlen(val + 1), 0) :
+			       OFI_GIC_NULL);
+	}
+	free(vars);
+
+	/* Providers found through the dynamic linker search path */
+	val = getenv("LD_LIBRARY_PATH");
+	ofi_gic_printf(key, "ld_library_path %s\n", val ? val : "");
+}
+
+static void ofi_gic_key_ifaddrs(struct ofi_gic_buf *key)
+{
+	struct ifaddrs *ifaddrs, *ifa;
+	char str[OFI_ADDRSTRLEN];
+	size_t len;
+
+	if (ofi_getifaddrs(&ifaddrs)) {
+		key->err = -FI_ENODATA;
+		return;
+	}
+
+	for (ifa = ifaddrs; ifa; ifa = ifa->ifa_next) {
+		ofi_gic_printf(key, "if %s 0x%x", ifa->ifa_name,
+			       ifa->ifa_flags);
+		if (ifa->ifa_addr && (ifa->ifa_addr->sa_family == AF_INET ||
+				      ifa->ifa_addr->sa_family == AF_INET6)) {
+			len = sizeof str;
+			ofi_gic_printf(key, " %s", ofi_straddr(str, &len,
+					FI_SOCKADDR, ifa->ifa_addr));
+		}
+		ofi_gic_printf(key, "\n");
+	}
+
+	freeifaddrs(ifaddrs);
+}
+
+static char *ofi_gic_key(uint32_t version, const char *node,
+			 const char *service, uint64_t flags,
+			 const struct fi_info *hints)
+{
+	struct ofi_gic_buf key = { 0 };
+	char *str;
+
+	ofi_gic_printf(&key, "libfabric %s format %d ptr %zu libs %016"
+		       PRIx64 "\n", PACKAGE_VERSION, OFI_GIC_FORMAT,
+		       sizeof(void *), gic_lib_hash);
+	ofi_gic_key_boot(&key);
+	ofi_gic_printf(&key, "api %u.%u flags 0x%" PRIx64 "\n",
+		       FI_MAJOR(version), FI_MINOR(version), flags);
+	ofi_gic_printf(&key, "node %d %s\nservice %d %s\n", node != NULL,
+		       node ? node : "", service != NULL,
+		       service ? service : "");
+
+	if (hints) {
+		str = calloc(1, OFI_GIC_HINTS_LEN);
+		if (!str) {
+			key.err = -FI_ENOMEM;
+			goto out;
+		}
+
+		fi_tostr_r(str, OFI_GIC_HINTS_LEN, hints, FI_TYPE_INFO);
+		if (strlen(str) >= OFI_GIC_HINTS_LEN - 1)
+			key.err = -FI_ETOOSMALL;
+		ofi_gic_printf(&key, "hints\n%s", str);
+		free(str);
+	}
+
+	ofi_gic_key_env(&key);
+	ofi_gic_key_ifaddrs(&key);
+	ofi_gic_put(&key, "", 1);
+out:
+	if (key.err) {
+		free(key.data);
+		return NULL;
+	}
+	return key.data;
+}
+
+/*
+ * Active objects and provider private data cannot be rebuilt from a file,
+ * string addresses may name the process that asked (e.g. shm), and
+ * authorization keys must not be written to disk.
+ */
+static bool ofi_gic_cacheable(const struct fi_info *info)
+{
+	for (; info; info = info->next) {
+		if (info->handle || !info->tx_attr || !info->rx_attr ||
+		    !info->ep_attr || !info->domain_attr ||
+		    !info->fabric_attr || info->domain_attr->domain ||
+		    info->fabric_attr->fabric)
+			return false;
+
+		if (info->addr_format == FI_ADDR_STR && info->src_addr)
+			return false;
+
+		if (info->ep_attr->auth_key_size ||
+		    info->domain_attr->auth_key_size)
+			return false;
+
+		if (info->nic && (info->nic->fid.ops != &default_nic_ops ||
+				  info->nic->prov_attr ||
+				  !info->nic->device_attr ||
+				  !info->nic->bus_attr ||
+				  !info->nic->link_attr))
+			return false;
+	}
+	return true;
+}
+
+static void ofi_gic_put_info(struct ofi_gic_buf *buf,
+			     const struct fi_info *info)
+{
+	struct fi_device_attr *dev;
+	struct fi_link_attr *link;
+
+	ofi_gic_put_blob(buf, info, sizeof(*info));
+	ofi_gic_put_blob(buf, info->src_addr, info->src_addrlen);
+	ofi_gic_put_blob(buf, info->dest_addr, info->dest_addrlen);
+	ofi_gic_put_blob(buf, info->tx_attr, sizeof(*info->tx_attr));
+	ofi_gic_put_blob(buf, info->rx_attr, sizeof(*info->rx_attr));
+	ofi_gic_put_blob(buf, info->ep_attr, sizeof(*info->ep_attr));
+	ofi_gic_put_blob(buf, info->domain_attr, sizeof(*info->domain_attr));
+	ofi_gic_put_str(buf, info->domain_attr->name);
+	ofi_gic_put_blob(buf, info->fabric_attr, sizeof(*info->fabric_attr));
+	ofi_gic_put_str(buf, info->fabric_attr->name);
+	ofi_gic_put_str(buf, info->fabric_attr->prov_name);
+
+	ofi_gic_put_u32(buf, info->nic != NULL);
+	if (!info->nic)
+		return;
+
+	dev = info->nic->device_attr;
+	ofi_gic_put_str(buf, dev->name);
+	ofi_gic_put_str(buf, dev->device_id);
+	ofi_gic_put_str(buf, dev->device_version);
+	ofi_gic_put_str(buf, dev->vendor_id);
+	ofi_gic_put_str(buf, dev->driver);
+	ofi_gic_put_str(buf, dev->firmware);
+	ofi_gic_put_blob(buf, info->nic->bus_attr, sizeof(*info->nic->bus_attr));
+	link = info->nic->link_attr;
+	ofi_gic_put_blob(buf, link, sizeof(*link));
+	ofi_gic_put_str(buf, link->address);
+	ofi_gic_put_str(buf, link->network_type);
+}
+
+static int ofi_gic_get_nic(struct ofi_gic_buf *buf, struct fid_nic **nic)
+{
+	struct fi_device_attr *dev;
+	struct fi_link_attr *link;
+	int ret;
+
+	*nic = ofi_nic_dup(NULL);
+	if (!*nic)
+		return -FI_ENOMEM;
+
+	dev = (*nic)->device_attr;
+	ret = ofi_gic_get_str(buf, &dev->name);
+	if (!ret)
+		ret = ofi_gic_get_str(buf, &dev->device_id);
+	if (!ret)
+		ret = ofi_gic_get_str(buf, &dev->device_version);
+	if (!ret)
+		ret = ofi_gic_get_str(buf, &dev->vendor_id);
+	if (!ret)
+		ret = ofi_gic_get_str(buf, &dev->driver);
+	if (!ret)
+		ret = ofi_gic_get_str(buf, &dev->firmware);
+	if (!ret)
+		ret = ofi_gic_get_struct(buf, (*nic)->bus_attr,
+					 sizeof(*(*nic)->bus_attr));
+	if (ret)
+		return ret;
+
+	link = (*nic)->link_attr;
+	ret = ofi_gic_get_struct(buf, link, sizeof(*link));
+	if (ret)
+		return ret;
+
+	link->address = NULL;
+	link->network_type = NULL;
+	ret = ofi_gic_get_str(buf, &link->address);
+	if (!ret)
+		ret = ofi_gic_get_str(buf, &link->network_type);
+	return ret;
+}
+
+static int ofi_gic_get_info(struct ofi_gic_buf *buf, struct fi_info **info)
+{
+	struct fi_info *cur, tmp;
+	uint32_t has_nic;
+	int ret;
+
+	cur = ofi_allocinfo_internal();
+	if (!cur)
+		return -FI_ENOMEM;
+
+	ret = ofi_gic_get_struct(buf, &tmp, sizeof(tmp));
+	if (ret)
+		goto err;
+
+	cur->caps = tmp.caps;
+	cur->mode = tmp.mode;
+	cur->addr_format = tmp.addr_format;
+
+	ret = ofi_gic_get_blob(buf, &cur->src_addr, &cur->src_addrlen);
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_blob(buf, &cur->dest_addr, &cur->dest_addrlen);
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_struct(buf, cur->tx_attr, sizeof(*cur->tx_attr));
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_struct(buf, cur->rx_attr, sizeof(*cur->rx_attr));
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_struct(buf, cur->ep_attr, sizeof(*cur->ep_attr));
+	if (ret)
+		goto err;
+
+	cur->ep_attr->auth_key = NULL;
+	cur->ep_attr->auth_key_size = 0;
+
+	ret = ofi_gic_get_struct(buf, cur->domain_attr,
+				 sizeof(*cur->domain_attr));
+	if (ret)
+		goto err;
+
+	cur->domain_attr->domain = NULL;
+	cur->domain_attr->name = NULL;
+	cur->domain_attr->auth_key = NULL;
+	cur->domain_attr->auth_key_size = 0;
+	ret = ofi_gic_get_str(buf, &cur->domain_attr->name);
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_struct(buf, cur->fabric_attr,
+				 sizeof(*cur->fabric_attr));
+	if (ret)
+		goto err;
+
+	cur->fabric_attr->fabric = NULL;
+	cur->fabric_attr->name = NULL;
+	cur->fabric_attr->prov_name = NULL;
+	ret = ofi_gic_get_str(buf, &cur->fabric_attr->name);
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_str(buf, &cur->fabric_attr->prov_name);
+	if (ret)
+		goto err;
+
+	ret = ofi_gic_get_u32(buf, &has_nic);
+	if (ret)
+		goto err;
+
+	if (has_nic) {
+		ret = ofi_gic_get_nic(buf, &cur->nic);
+		if (ret)
+			goto err;
+	}
+
+	*info = cur;
+	return 0;
+err:
+	fi_freeinfo(cur);
+	return ret;
+}
+
+struct ofi_getinfo_cache *
+ofi_getinfo_cache_open(uint32_t version, const char *node,
+		       const char *service, uint64_t flags,
+		       const struct fi_info *hints)
+{
+	struct ofi_getinfo_cache *cache;
+	const void *key;
+	uint32_t magic, format;
+	size_t len;
+
+	if (!ofi_getinfo_cache_dir || !*ofi_getinfo_cache_dir)
+		return NULL;
+
+	/* Calls made by providers are answered as part of the outer call */
+	if (flags & (OFI_GETINFO_INTERNAL | OFI_CORE_PROV_ONLY |
+		     OFI_GETINFO_HIDDEN | OFI_OFFLOAD_PROV_ONLY))
+		return NULL;
+
+	if (hints && (hints->handle || hints->nic ||
+		      (hints->domain_attr && hints->domain_attr->domain) ||
+		      (hints->fabric_attr && hints->fabric_attr->fabric)))
+		return NULL;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	cache->key = ofi_gic_key(version, node, service, flags, hints);
+	if (!cache->key)
+		goto err;
+
+	if (asprintf(&cache->path, "%s/getinfo-%016" PRIx64,
+		     ofi_getinfo_cache_dir,
+		     fasthash64(cache->key, strlen(cache->key), 0)) < 0) {
+		cache->path = NULL;
+		goto err;
+	}
+
+	if (!ofi_gic_read(cache->path, &cache->buf) &&
+	    !ofi_gic_get_u32(&cache->buf, &magic) &&
+	    !ofi_gic_get_u32(&cache->buf, &format) &&
+	    !ofi_gic_get_ref(&cache->buf, &key, &len) &&
+	    magic == OFI_GIC_MAGIC && format == OFI_GIC_FORMAT && key &&
+	    len == strlen(cache->key) + 1 && !memcmp(key, cache->key, len)) {
+		FI_INFO(&core_prov, FI_LOG_CORE,
+			"using getinfo cache %s\n", cache->path);
+		cache->hit = true;
+		return cache;
+	}
+
+	free(cache->buf.data);
+	memset(&cache->buf, 0, sizeof(cache->buf));
+	ofi_gic_put_u32(&cache->buf, OFI_GIC_MAGIC);
+	ofi_gic_put_u32(&cache->buf, OFI_GIC_FORMAT);
+	ofi_gic_put_str(&cache->buf, cache->key);
+	return cache;
+
+err:
+	free(cache->key);
+	free(cache);
+	return NULL;
+}
+
+/*
+ * Returns the cached answer of the next provider, which may be an empty
+ * list, or -FI_EAGAIN if the provider must be asked.
+ */
+int ofi_getinfo_cache_get(struct ofi_getinfo_cache *cache,
+			  const char *prov_name, struct fi_info **info)
+{
+	struct fi_info *head = NULL, *tail = NULL, *cur;
+	const void *name;
+	uint32_t type, cnt;
+	size_t len;
+	int ret;
+
+	if (!cache || !cache->hit || cache->stale)
+		return -FI_EAGAIN;
+
+	if (ofi_gic_get_ref(&cache->buf, &name, &len) || !name ||
+	    len != strlen(prov_name) + 1 || memcmp(name, prov_name, len) ||
+	    ofi_gic_get_u32(&cache->buf, &type) ||
+	    ofi_gic_get_u32(&cache->buf, &cnt))
+		goto stale;
+
+	switch (type) {
+	case OFI_GIC_REC_NONE:
+		*info = NULL;
+		return 0;
+	case OFI_GIC_REC_INFO:
+		while (cnt--) {
+			ret = ofi_gic_get_info(&cache->buf, &cur);
+			if (ret) {
+				fi_freeinfo(head);
+				goto stale;
+			}
+
+			if (tail)
+				tail->next = cur;
+			else
+				head = cur;
+			tail = cur;
+		}
+		*info = head;
+		return 0;
+	case OFI_GIC_REC_UNCACHED:
+		return -FI_EAGAIN;
+	default:
+		break;
+	}
+
+stale:
+	FI_INFO(&core_prov, FI_LOG_CORE,
+		"getinfo cache %s is out of date\n", cache->path);
+	cache->stale = true;
+	return -FI_EAGAIN;
+}
+
+/* Records the answer of a provider that was asked; ret is its return code */
+void ofi_getinfo_cache_put(struct ofi_getinfo_cache *cache,
+			   const char *prov_name, const struct fi_info *info,
+			   int ret)
+{
+	const struct fi_info *cur;
+	uint32_t cnt = 0;
+
+	if (!cache || cache->hit)
+		return;
+
+	ofi_gic_put_str(&cache->buf, prov_name);
+	if (!ret && info && ofi_gic_cacheable(info)) {
+		for (cur = info; cur; cur = cur->next)
+			cnt++;
+
+		ofi_gic_put_u32(&cache->buf, OFI_GIC_REC_INFO);
+		ofi_gic_put_u32(&cache->buf, cnt);
+		for (cur = info; cur; cur = cur->next)
+			ofi_gic_put_info(&cache->buf, cur);
+	} else if ((!ret && !info) || ret == -FI_ENODATA) {
+		ofi_gic_put_u32(&cache->buf, OFI_GIC_REC_NONE);
+		ofi_gic_put_u32(&cache->buf, 0);
+	} else {
+		ofi_gic_put_u32(&cache->buf, OFI_GIC_REC_UNCACHED);
+		ofi_gic_put_u32(&cache->buf, 0);
+	}
+}
+
+void ofi_getinfo_cache_close(struct ofi_getinfo_cache *cache)
+{
+	if (!cache)
+		return;
+
+	if (cache->hit) {
+		if (cache->stale || cache->buf.pos != cache->buf.len)
+			unlink(cache->path);
+	} else if (!cache->buf.err) {
+		ofi_gic_write(cache->path, cache->buf.data, cache->buf.len);
+	}
+
+	free(cache->buf.data);
+	free(cache->path);
+	free(cache->key);
+	free(cache);
+}
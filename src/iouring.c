@@ -175,6 +175,88 @@ ssize_t ofi_sockapi_recvv_uring(struct ofi_sockapi *sockapi, SOCKET sock,
 	return -OFI_EINPROGRESS_URING;
 }
 
+ssize_t ofi_sockapi_send_fixed_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     const void *buf, size_t len, int buf_index,
+				     struct ofi_sockctx *ctx)
+{
+	struct io_uring_sqe *sqe;
+	struct ofi_sockapi_uring *uring;
+
+	uring = &sockapi->tx_uring;
+	if (ctx->uring_sqe_inuse || uring->credits == 0)
+		return -FI_EAGAIN;
+
+	sqe = io_uring_get_sqe(uring->io_uring);
+	if (!sqe)
+		return -FI_EOVERFLOW;
+
+	io_uring_prep_write_fixed(sqe, sock, buf, len, 0, buf_index);
+	io_uring_sqe_set_data(sqe, ctx);
+	ctx->uring_sqe_inuse = true;
+	uring->credits--;
+	return -OFI_EINPROGRESS_URING;
+}
+
+ssize_t ofi_sockapi_recv_fixed_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     void *buf, size_t len, int buf_index,
+				     struct ofi_sockctx *ctx)
+{
+	struct io_uring_sqe *sqe;
+	struct ofi_sockapi_uring *uring;
+
+	uring = &sockapi->rx_uring;
+	if (ctx->uring_sqe_inuse || uring->credits == 0)
+		return -FI_EAGAIN;
+
+	sqe = io_uring_get_sqe(uring->io_uring);
+	if (!sqe)
+		return -FI_EOVERFLOW;
+
+	io_uring_prep_read_fixed(sqe, sock, buf, len, 0, buf_index);
+	io_uring_sqe_set_data(sqe, ctx);
+	ctx->uring_sqe_inuse = true;
+	uring->credits--;
+	return -OFI_EINPROGRESS_URING;
+}
+
+#ifdef HAVE_LIBURING_PBUF
+/* The receive stays armed, and a CQE carrying IORING_CQE_F_MORE is posted
+ * for every provided buffer filled, until the socket is drained of buffers,
+ * the peer disconnects or the request is canceled.
+ */
+int ofi_sockapi_recv_multishot_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     struct ofi_sockctx *ctx)
+{
+	struct io_uring_sqe *sqe;
+	struct ofi_sockapi_uring *uring;
+
+	uring = &sockapi->rx_uring;
+	if (!uring->mshot)
+		return -FI_ENOSYS;
+
+	if (ctx->uring_sqe_inuse || uring->credits == 0)
+		return -FI_EAGAIN;
+
+	sqe = io_uring_get_sqe(uring->io_uring);
+	if (!sqe)
+		return -FI_EOVERFLOW;
+
+	io_uring_prep_recv_multishot(sqe, sock, NULL, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = OFI_URING_PBUF_GROUP;
+	io_uring_sqe_set_data(sqe, ctx);
+	ctx->uring_sqe_inuse = true;
+	uring->credits--;
+	return -OFI_EINPROGRESS_URING;
+}
+#else
+int ofi_sockapi_recv_multishot_uring(struct ofi_sockapi *sockapi, SOCKET sock,
+				     struct ofi_sockctx *ctx)
+{
+	return -FI_ENOSYS;
+}
+#endif
+
 int ofi_sockctx_uring_cancel(struct ofi_sockapi_uring *uring,
 			     struct ofi_sockctx *canceled_ctx,
 			     struct ofi_sockctx *ctx)
@@ -252,3 +334,161 @@ int ofi_uring_destroy(ofi_io_uring_t *io_uring)
 	return 0;
 }
 
+
+#ifdef HAVE_LIBURING_PBUF
+/* cnt must be a power of 2 no larger than OFI_URING_PBUF_CNT */
+int ofi_uring_pbuf_init(struct ofi_sockapi_uring *uring, unsigned int cnt,
+			size_t size)
+{
+	struct io_uring_buf_ring *br;
+	unsigned int i;
+	int ret;
+
+	assert(cnt && cnt <= OFI_URING_PBUF_CNT && !(cnt & (cnt - 1)));
+	assert(size && size <= UINT32_MAX);
+	uring->pbuf_data = malloc(cnt * size);
+	if (!uring->pbuf_data)
+		return -FI_ENOMEM;
+
+	br = io_uring_setup_buf_ring(uring->io_uring, cnt, OFI_URING_PBUF_GROUP,
+				     0, &ret);
+	if (!br) {
+		free(uring->pbuf_data);
+		uring->pbuf_data = NULL;
+		return ret;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		io_uring_buf_ring_add(br, uring->pbuf_data + i * size,
+				      (unsigned int) size, (unsigned short) i,
+				      io_uring_buf_ring_mask(cnt), (int) i);
+	}
+	io_uring_buf_ring_advance(br, (int) cnt);
+
+	uring->pbuf_ring = br;
+	uring->pbuf_size = size;
+	uring->pbuf_cnt = cnt;
+	uring->mshot = true;
+	return 0;
+}
+
+void ofi_uring_pbuf_cleanup(struct ofi_sockapi_uring *uring)
+{
+	if (!uring->pbuf_ring)
+		return;
+
+	(void) io_uring_free_buf_ring(uring->io_uring, uring->pbuf_ring,
+				      uring->pbuf_cnt, OFI_URING_PBUF_GROUP);
+	free(uring->pbuf_data);
+	uring->pbuf_ring = NULL;
+	uring->pbuf_data = NULL;
+	uring->pbuf_cnt = 0;
+	uring->mshot = false;
+}
+
+/* Return a buffer consumed by a multishot receive to the kernel */
+void ofi_uring_pbuf_recycle(struct ofi_sockapi_uring *uring, uint16_t bid)
+{
+	assert(uring->pbuf_ring && bid < uring->pbuf_cnt);
+	io_uring_buf_ring_add(uring->pbuf_ring,
+			      uring->pbuf_data + bid * uring->pbuf_size,
+			      (unsigned int) uring->pbuf_size, bid,
+			      io_uring_buf_ring_mask(uring->pbuf_cnt), 0);
+	io_uring_buf_ring_advance(uring->pbuf_ring, 1);
+}
+
+/* Buffers are registered into the sparse table as sockets connect */
+int ofi_uring_fixed_init(struct ofi_sockapi_uring *uring, unsigned int cnt)
+{
+	unsigned int i;
+	int ret;
+
+	ret = io_uring_register_buffers_sparse(uring->io_uring, cnt);
+	if (ret)
+		return ret;
+
+	uring->fixed_free = malloc(cnt * sizeof(*uring->fixed_free));
+	if (!uring->fixed_free) {
+		(void) io_uring_unregister_buffers(uring->io_uring);
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < cnt; i++)
+		uring->fixed_free[i] = cnt - i - 1;
+	uring->fixed_free_cnt = cnt;
+	return 0;
+}
+
+void ofi_uring_fixed_cleanup(struct ofi_sockapi_uring *uring)
+{
+	if (!uring->fixed_free)
+		return;
+
+	(void) io_uring_unregister_buffers(uring->io_uring);
+	free(uring->fixed_free);
+	uring->fixed_free = NULL;
+	uring->fixed_free_cnt = 0;
+}
+
+int ofi_uring_fixed_add(struct ofi_sockapi_uring *uring, void *buf, size_t len)
+{
+	struct iovec iov;
+	int index, ret;
+
+	if (!uring->fixed_free_cnt)
+		return -FI_ENOSPC;
+
+	index = uring->fixed_free[--uring->fixed_free_cnt];
+	iov.iov_base = buf;
+	iov.iov_len = len;
+	ret = io_uring_register_buffers_update_tag(uring->io_uring, index,
+						   &iov, NULL, 1);
+	if (ret < 0) {
+		uring->fixed_free[uring->fixed_free_cnt++] = index;
+		return ret;
+	}
+	return index;
+}
+
+void ofi_uring_fixed_del(struct ofi_sockapi_uring *uring, int index)
+{
+	struct iovec iov = {0};
+
+	assert(uring->fixed_free && index >= 0);
+	(void) io_uring_register_buffers_update_tag(uring->io_uring, index,
+						    &iov, NULL, 1);
+	uring->fixed_free[uring->fixed_free_cnt++] = index;
+}
+#else
+int ofi_uring_pbuf_init(struct ofi_sockapi_uring *uring, unsigned int cnt,
+			size_t size)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_uring_pbuf_cleanup(struct ofi_sockapi_uring *uring)
+{
+}
+
+void ofi_uring_pbuf_recycle(struct ofi_sockapi_uring *uring, uint16_t bid)
+{
+}
+
+int ofi_uring_fixed_init(struct ofi_sockapi_uring *uring, unsigned int cnt)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_uring_fixed_cleanup(struct ofi_sockapi_uring *uring)
+{
+}
+
+int ofi_uring_fixed_add(struct ofi_sockapi_uring *uring, void *buf, size_t len)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_uring_fixed_del(struct ofi_sockapi_uring *uring, int index)
+{
+}
+#endif
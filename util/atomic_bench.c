@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under the BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Standalone benchmark for the local reduction kernels.  Each op/datatype
+ * pair is timed with the atomic write handlers, the scalar reduce loops and
+ * the reduce handlers of every instruction set supported by the CPU.  Vector
+ * speedups are relative to the scalar loops, and all results are checked
+ * against the atomic handlers.
+ */
+
+#include <config.h>
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rdma/fi_errno.h>
+#include "ofi_atomic.h"
+
+static const struct {
+	enum fi_op op;
+	const char *name;
+} bench_ops[] = {
+	{ FI_SUM, "sum" },
+	{ FI_PROD, "prod" },
+	{ FI_MIN, "min" },
+	{ FI_MAX, "max" },
+	{ FI_BOR, "bor" },
+	{ FI_BAND, "band" },
+	{ FI_BXOR, "bxor" },
+};
+
+static const struct {
+	enum fi_datatype datatype;
+	const char *name;
+} bench_types[] = {
+	{ FI_INT8, "int8" },
+	{ FI_UINT16, "uint16" },
+	{ FI_INT32, "int32" },
+	{ FI_UINT64, "uint64" },
+	{ FI_FLOAT, "float" },
+	{ FI_DOUBLE, "double" },
+};
+
+static const char *bench_isas[] = { "v128", "avx2", "avx512" };
+
+static uint64_t bench_gettime_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void bench_fill(void *buf, enum fi_datatype datatype, size_t cnt,
+		       unsigned int seed)
+{
+	size_t i;
+
+	for (i = 0; i < cnt; i++) {
+		seed = seed * 1103515245 + 12345;
+		switch (datatype) {
+		case FI_FLOAT:
+			((float *) buf)[i] = (float) (seed >> 16) / 8192 + 0.5f;
+			break;
+		case FI_DOUBLE:
+			((double *) buf)[i] = (double) (seed >> 16) / 8192 + 0.5;
+			break;
+		default:
+			memset((char *) buf + i * ofi_datatype_size(datatype),
+			       (seed >> 16) | 1, ofi_datatype_size(datatype));
+			break;
+		}
+	}
+}
+
+/* Average time of one pass over cnt elements, in nsec */
+static double bench_run(void (*handler)(void *dst, const void *src, size_t cnt),
+			void *dst, const void *src, size_t cnt, int iters)
+{
+	uint64_t start;
+	int i;
+
+	handler(dst, src, cnt);
+	start = bench_gettime_ns();
+	for (i = 0; i < iters; i++)
+		handler(dst, src, cnt);
+
+	return (double) (bench_gettime_ns() - start) / iters;
+}
+
+static void usage(const char *argv0)
+{
+	printf("Usage: %s [-c count] [-i iterations]\n", argv0);
+	printf("\n");
+	printf("Compares the atomic write handlers and the scalar reduce\n");
+	printf("loops against the vectorized reduce handlers for count\n");
+	printf("elements (default 4096).\n");
+}
+
+int main(int argc, char *argv[])
+{
+	void (*handler)(void *dst, const void *src, size_t cnt);
+	void *src, *dst, *ref;
+	size_t cnt = 4096, size;
+	int iters = 1000, ret = EXIT_SUCCESS;
+	double atomic, base, ns;
+	int c, o, t, i;
+
+	while ((c = getopt(argc, argv, "c:i:h")) != -1) {
+		switch (c) {
+		case 'c':
+			cnt = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			iters = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	size = cnt * sizeof(double);
+	src = malloc(size);
+	dst = malloc(size);
+	ref = malloc(size);
+	if (!src || !dst || !ref) {
+		fprintf(stderr, "%s\n", fi_strerror(FI_ENOMEM));
+		return EXIT_FAILURE;
+	}
+
+	printf("%-6s %-8s %12s %12s", "op", "type", "atomic(ns)", "scalar(ns)");
+	for (i = 0; i < (int) (sizeof(bench_isas) / sizeof(*bench_isas)); i++)
+		printf(" %12s", bench_isas[i]);
+	printf("\n");
+
+	for (o = 0; o < (int) (sizeof(bench_ops) / sizeof(*bench_ops)); o++) {
+		for (t = 0; t < (int) (sizeof(bench_types) /
+				       sizeof(*bench_types)); t++) {
+			if (bench_ops[o].op >= FI_BOR &&
+			    bench_ops[o].op <= FI_BXOR &&
+			    (bench_types[t].datatype == FI_FLOAT ||
+			     bench_types[t].datatype == FI_DOUBLE))
+				continue;
+
+			size = cnt * ofi_datatype_size(bench_types[t].datatype);
+			bench_fill(src, bench_types[t].datatype, cnt, 1);
+			bench_fill(ref, bench_types[t].datatype, cnt, 2);
+			handler = ofi_atomic_write_handlers[bench_ops[o].op]
+					[bench_types[t].datatype];
+			atomic = bench_run(handler, ref, src, cnt, iters);
+
+			(void) ofi_reduce_select("scalar");
+			bench_fill(dst, bench_types[t].datatype, cnt, 2);
+			handler = ofi_reduce_write_handlers[bench_ops[o].op]
+					[bench_types[t].datatype];
+			base = bench_run(handler, dst, src, cnt, iters);
+
+			printf("%-6s %-8s %12.1f", bench_ops[o].name,
+			       bench_types[t].name, atomic);
+			if (memcmp(dst, ref, size)) {
+				printf(" %12s", "MISMATCH");
+				ret = EXIT_FAILURE;
+			} else {
+				printf(" %12.1f", base);
+			}
+
+			for (i = 0; i < (int) (sizeof(bench_isas) /
+					       sizeof(*bench_isas)); i++) {
+				if (ofi_reduce_select(bench_isas[i]) ||
+				    strcmp(ofi_reduce_simd_isa, bench_isas[i])) {
+					printf(" %12s", "-");
+					continue;
+				}
+
+				bench_fill(dst, bench_types[t].datatype, cnt, 2);
+				handler = ofi_reduce_write_handlers
+						[bench_ops[o].op]
+						[bench_types[t].datatype];
+				ns = bench_run(handler, dst, src, cnt, iters);
+				if (memcmp(dst, ref, size)) {
+					printf(" %12s", "MISMATCH");
+					ret = EXIT_FAILURE;
+					continue;
+				}
+				printf(" %6.1f (%3.1fx)", ns, base / ns);
+			}
+			printf("\n");
+		}
+	}
+
+	free(src);
+	free(dst);
+	free(ref);
+	return ret;
+}
@@ -0,0 +1,594 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under the BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Checks for the optional buffer pool features: per-thread magazines
+ * (OFI_BUFPOOL_THREAD_CACHE), node local regions (OFI_BUFPOOL_NUMA_LOCAL)
+ * and ofi_bufpool_shrink().  Each check runs for every combination of
+ * the two flags.  With -b, alloc/free pairs are timed instead, with pool
+ * calls serialized by a mutex the way providers call them under their
+ * endpoint lock.
+ */
+
+#include <config.h>
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rdma/fi_errno.h>
+#include "ofi_atom.h"
+#include "ofi_mem.h"
+
+#define TEST_BUF_SIZE	256
+#define TEST_CHUNK_CNT	64
+#define TEST_BURST	40
+
+struct test_buf {
+	ofi_atomic32_t	in_use;
+	uint64_t	stamp;
+};
+
+struct test_thread {
+	pthread_t		thread;
+	struct ofi_bufpool	*pool;
+	pthread_mutex_t		*lock;
+	int			id;
+	int			iters;
+	int			burst;
+	int			err;
+	uint64_t		nsec;
+};
+
+static const int test_flags[] = {
+	0,
+	OFI_BUFPOOL_THREAD_CACHE,
+	OFI_BUFPOOL_NUMA_LOCAL,
+	OFI_BUFPOOL_THREAD_CACHE | OFI_BUFPOOL_NUMA_LOCAL,
+};
+
+/* Buffers handed from one thread to be freed by another */
+static pthread_mutex_t test_xchg_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct test_buf *test_xchg[TEST_BURST];
+
+static uint64_t test_gettime_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static const char *test_flags_str(int flags)
+{
+	switch (flags) {
+	case OFI_BUFPOOL_THREAD_CACHE:
+		return "thread_cache";
+	case OFI_BUFPOOL_NUMA_LOCAL:
+		return "numa_local";
+	case OFI_BUFPOOL_THREAD_CACHE | OFI_BUFPOOL_NUMA_LOCAL:
+		return "thread_cache|numa_local";
+	default:
+		return "none";
+	}
+}
+
+static void test_buf_init(struct ofi_bufpool_region *region, void *buf)
+{
+	struct test_buf *test_buf = buf;
+
+	ofi_atomic_initialize32(&test_buf->in_use, 0);
+	test_buf->stamp = 0;
+}
+
+static int test_pool_create(struct ofi_bufpool **pool, int flags)
+{
+	struct ofi_bufpool_attr attr = {
+		.size		= TEST_BUF_SIZE,
+		.alignment	= 16,
+		.chunk_cnt	= TEST_CHUNK_CNT,
+		.flags		= flags,
+		.init_fn	= test_buf_init,
+	};
+
+	return ofi_bufpool_create_attr(&attr, pool);
+}
+
+static struct test_buf *test_alloc(struct test_thread *t)
+{
+	struct test_buf *buf;
+
+	if (t->lock)
+		pthread_mutex_lock(t->lock);
+	buf = ofi_buf_alloc(t->pool);
+	if (t->lock)
+		pthread_mutex_unlock(t->lock);
+	return buf;
+}
+
+static void test_free(struct test_thread *t, struct test_buf *buf)
+{
+	if (t->lock)
+		pthread_mutex_lock(t->lock);
+	ofi_buf_free(buf);
+	if (t->lock)
+		pthread_mutex_unlock(t->lock);
+}
+
+/* Claim a buffer, failing if another thread holds it */
+static int test_claim(struct test_thread *t, struct test_buf *buf)
+{
+	uint64_t stamp = ((uint64_t) t->id << 32) | (uintptr_t) buf;
+
+	if (ofi_atomic_inc32(&buf->in_use) != 1) {
+		fprintf(stderr, "buffer %p handed out twice\n", (void *) buf);
+		return -FI_EOTHER;
+	}
+	buf->stamp = stamp;
+	return 0;
+}
+
+static int test_release(struct test_thread *t, struct test_buf *buf)
+{
+	uint64_t stamp = ((uint64_t) t->id << 32) | (uintptr_t) buf;
+
+	if (buf->stamp != stamp) {
+		fprintf(stderr, "buffer %p overwritten while in use\n",
+			(void *) buf);
+		return -FI_EOTHER;
+	}
+	buf->stamp = 0;
+	ofi_atomic_dec32(&buf->in_use);
+	return 0;
+}
+
+static void *test_thread_run(void *arg)
+{
+	struct test_thread *t = arg;
+	struct test_buf *bufs[TEST_BURST], *xchg;
+	unsigned int seed = (unsigned int) t->id + 1;
+	int i, j, cnt, slot;
+
+	for (i = 0; i < t->iters && !t->err; i++) {
+		seed = seed * 1103515245 + 12345;
+		cnt = 1 + (int) ((seed >> 16) % TEST_BURST);
+		for (j = 0; j < cnt; j++) {
+			bufs[j] = test_alloc(t);
+			if (!bufs[j]) {
+				t->err = -FI_ENOMEM;
+				break;
+			}
+			t->err = test_claim(t, bufs[j]);
+			if (t->err)
+				break;
+		}
+		if (t->err) {
+			/* leak the failed burst, the check has failed */
+			break;
+		}
+
+		for (j = 0; j < cnt; j++) {
+			if (test_release(t, bufs[j]))
+				t->err = -FI_EOTHER;
+		}
+
+		/* swap one buffer with the exchange so that buffers are
+		 * also freed by threads other than the one that allocated
+		 * them, as completions are by provider progress */
+		slot = (int) ((seed >> 8) % TEST_BURST);
+		pthread_mutex_lock(&test_xchg_lock);
+		xchg = test_xchg[slot];
+		test_xchg[slot] = bufs[--cnt];
+		pthread_mutex_unlock(&test_xchg_lock);
+		if (xchg)
+			test_free(t, xchg);
+
+		/* free in reverse order of allocation */
+		for (j = cnt - 1; j >= 0; j--)
+			test_free(t, bufs[j]);
+	}
+	return NULL;
+}
+
+static int test_threads(struct ofi_bufpool *pool, pthread_mutex_t *lock,
+			int thread_cnt, int iters)
+{
+	struct test_thread *threads;
+	int i, ret = 0;
+
+	threads = calloc(thread_cnt, sizeof(*threads));
+	if (!threads)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < thread_cnt; i++) {
+		threads[i].pool = pool;
+		threads[i].lock = lock;
+		threads[i].id = i + 1;
+		threads[i].iters = iters;
+		ret = -pthread_create(&threads[i].thread, NULL,
+				      test_thread_run, &threads[i]);
+		if (ret) {
+			thread_cnt = i;
+			break;
+		}
+	}
+
+	for (i = 0; i < thread_cnt; i++) {
+		pthread_join(threads[i].thread, NULL);
+		if (threads[i].err)
+			ret = threads[i].err;
+	}
+
+	for (i = 0; i < TEST_BURST; i++) {
+		if (test_xchg[i])
+			ofi_buf_free(test_xchg[i]);
+		test_xchg[i] = NULL;
+	}
+	free(threads);
+	return ret;
+}
+
+/* Concurrent alloc and free, serialized by the pool alone when cached */
+static int check_threads(int flags)
+{
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct ofi_bufpool *pool;
+	int ret;
+
+	ret = test_pool_create(&pool, flags);
+	if (ret)
+		return ret;
+
+	ret = test_threads(pool, (flags & OFI_BUFPOOL_THREAD_CACHE) ?
+			   NULL : &lock, 8, 20000);
+	ofi_bufpool_destroy(pool);
+	return ret;
+}
+
+/* Buffer indices stay valid and map back to their buffer */
+static int check_index(int flags)
+{
+	struct ofi_bufpool *pool;
+	void *bufs[3 * TEST_CHUNK_CNT];
+	int i, cnt = 0, ret;
+
+	ret = test_pool_create(&pool, flags);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < 3 * TEST_CHUNK_CNT; i++) {
+		bufs[i] = ofi_buf_alloc(pool);
+		if (!bufs[i]) {
+			ret = -FI_ENOMEM;
+			break;
+		}
+		cnt++;
+		if (ofi_bufpool_get_ibuf(pool, ofi_buf_index(bufs[i])) !=
+		    bufs[i]) {
+			fprintf(stderr, "index %zu does not map to %p\n",
+				ofi_buf_index(bufs[i]), bufs[i]);
+			ret = -FI_EOTHER;
+			break;
+		}
+	}
+
+	for (i = 0; i < cnt; i++)
+		ofi_buf_free(bufs[i]);
+	ofi_bufpool_destroy(pool);
+	return ret;
+}
+
+/* Only trailing regions without buffers in use are released */
+static int check_shrink(int flags)
+{
+	struct ofi_bufpool *pool;
+	void *bufs[3 * TEST_CHUNK_CNT], *first, *last;
+	size_t released;
+	int i, ret;
+
+	ret = test_pool_create(&pool, flags);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < 3 * TEST_CHUNK_CNT; i++) {
+		bufs[i] = ofi_buf_alloc(pool);
+		if (!bufs[i]) {
+			ret = -FI_ENOMEM;
+			goto out;
+		}
+	}
+
+	first = bufs[0];
+	last = bufs[3 * TEST_CHUNK_CNT - 1];
+	if (ofi_buf_region(first)->index != 0 ||
+	    ofi_buf_region(last)->index != 2) {
+		fprintf(stderr, "unexpected regions %zu and %zu\n",
+			ofi_buf_region(first)->index,
+			ofi_buf_region(last)->index);
+		ret = -FI_EOTHER;
+		goto out;
+	}
+
+	/* buffers of the first and the last region are busy */
+	for (i = 1; i < 3 * TEST_CHUNK_CNT - 1; i++)
+		ofi_buf_free(bufs[i]);
+	released = ofi_bufpool_shrink(pool);
+	if (released || pool->region_cnt != 3) {
+		fprintf(stderr, "released %zu regions with the last one busy\n",
+			released);
+		ret = -FI_EOTHER;
+		goto out;
+	}
+
+	/* only the first region is busy */
+	ofi_buf_free(last);
+	released = ofi_bufpool_shrink(pool);
+	if (released != 2 || pool->region_cnt != 1) {
+		fprintf(stderr, "released %zu regions, %zu left, expected 2 "
+			"and 1\n", released, pool->region_cnt);
+		ret = -FI_EOTHER;
+	}
+	ofi_buf_free(first);
+	if (ret)
+		goto out;
+
+	released = ofi_bufpool_shrink(pool);
+	if (released != 1 || pool->region_cnt || pool->entry_cnt) {
+		fprintf(stderr, "released %zu regions of an idle pool, "
+			"%zu left\n", released, pool->region_cnt);
+		ret = -FI_EOTHER;
+		goto out;
+	}
+
+	/* the pool grows again after shrinking */
+	bufs[0] = ofi_buf_alloc(pool);
+	if (!bufs[0]) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+	ofi_buf_free(bufs[0]);
+out:
+	ofi_bufpool_destroy(pool);
+	return ret;
+}
+
+/*
+ * Node local regions are mmapped, so start on a page boundary.  Regions
+ * smaller than a page are left on the heap.
+ */
+static int check_numa(int flags)
+{
+	struct ofi_bufpool_attr attr = {
+		.size		= 16,
+		.alignment	= 16,
+		.chunk_cnt	= 4,
+		.flags		= flags,
+	};
+	struct ofi_bufpool *pool;
+	void *buf;
+	int ret;
+
+	if (!(flags & OFI_BUFPOOL_NUMA_LOCAL))
+		return 0;
+
+	ret = test_pool_create(&pool, flags);
+	if (ret)
+		return ret;
+
+	buf = ofi_buf_alloc(pool);
+	if (!buf) {
+		ret = -FI_ENOMEM;
+	} else {
+		if ((uintptr_t) ofi_buf_region(buf)->alloc_region %
+		    ofi_get_page_size()) {
+			fprintf(stderr, "node local region is not page "
+				"aligned\n");
+			ret = -FI_EOTHER;
+		}
+		ofi_buf_free(buf);
+	}
+	ofi_bufpool_destroy(pool);
+	if (ret)
+		return ret;
+
+	ret = ofi_bufpool_create_attr(&attr, &pool);
+	if (ret)
+		return ret;
+
+	buf = ofi_buf_alloc(pool);
+	if (!buf) {
+		ret = -FI_ENOMEM;
+	} else {
+		if (ofi_buf_region(buf)->flags & OFI_BUFPOOL_NONSHARED) {
+			fprintf(stderr, "sub-page region was mmapped\n");
+			ret = -FI_EOTHER;
+		}
+		ofi_buf_free(buf);
+	}
+	ofi_bufpool_destroy(pool);
+	return ret;
+}
+
+static int run_checks(void)
+{
+	static const struct {
+		int (*func)(int flags);
+		const char *name;
+	} checks[] = {
+		{ check_index, "index" },
+		{ check_shrink, "shrink" },
+		{ check_numa, "numa" },
+		{ check_threads, "threads" },
+	};
+	int c, f, ret, failed = 0;
+
+	for (f = 0; f < (int) (sizeof(test_flags) / sizeof(*test_flags)); f++) {
+		for (c = 0; c < (int) (sizeof(checks) / sizeof(*checks)); c++) {
+			ret = checks[c].func(test_flags[f]);
+			printf("%-8s %-24s %s\n", checks[c].name,
+			       test_flags_str(test_flags[f]),
+			       ret ? fi_strerror(-ret) : "pass");
+			if (ret)
+				failed++;
+		}
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void *bench_thread(void *arg)
+{
+	struct test_thread *t = arg;
+	void *bufs[TEST_BURST];
+	uint64_t start;
+	int i, j;
+
+	start = test_gettime_ns();
+	for (i = 0; i < t->iters; i++) {
+		for (j = 0; j < t->burst; j++)
+			bufs[j] = test_alloc(t);
+		for (j = t->burst - 1; j >= 0; j--)
+			test_free(t, bufs[j]);
+	}
+	t->nsec = test_gettime_ns() - start;
+	return NULL;
+}
+
+/* Average time of one alloc/free pair over all threads, in nsec */
+static double bench_run(int flags, bool locked, int thread_cnt, int iters,
+			int burst)
+{
+	pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+	struct test_thread *threads;
+	struct ofi_bufpool *pool;
+	uint64_t nsec = 0;
+	int i;
+
+	if (test_pool_create(&pool, flags))
+		return -1;
+
+	threads = calloc(thread_cnt, sizeof(*threads));
+	if (!threads) {
+		ofi_bufpool_destroy(pool);
+		return -1;
+	}
+
+	for (i = 0; i < thread_cnt; i++) {
+		threads[i].pool = pool;
+		threads[i].lock = locked ? &lock : NULL;
+		threads[i].iters = iters;
+		threads[i].burst = burst;
+		pthread_create(&threads[i].thread, NULL, bench_thread,
+			       &threads[i]);
+	}
+	for (i = 0; i < thread_cnt; i++) {
+		pthread_join(threads[i].thread, NULL);
+		nsec += threads[i].nsec;
+	}
+
+	free(threads);
+	ofi_bufpool_destroy(pool);
+	return (double) nsec / ((double) thread_cnt * iters * burst);
+}
+
+static void run_bench(int thread_cnt, int iters, int burst)
+{
+	int f, t;
+
+	printf("%-24s %-8s %8s %12s\n", "flags", "lock", "threads",
+	       "alloc+free(ns)");
+	for (f = 0; f < (int) (sizeof(test_flags) / sizeof(*test_flags)); f++) {
+		for (t = 1; t <= thread_cnt; t *= 2) {
+			printf("%-24s %-8s %8d %12.1f\n",
+			       test_flags_str(test_flags[f]), "mutex", t,
+			       bench_run(test_flags[f], true, t, iters, burst));
+			if (!(test_flags[f] & OFI_BUFPOOL_THREAD_CACHE))
+				continue;
+			printf("%-24s %-8s %8d %12.1f\n",
+			       test_flags_str(test_flags[f]), "none", t,
+			       bench_run(test_flags[f], false, t, iters,
+					 burst));
+		}
+	}
+}
+
+static void usage(const char *argv0)
+{
+	printf("Usage: %s [-b] [-t threads] [-i iterations] [-n burst]\n",
+	       argv0);
+	printf("\n");
+	printf("Checks the optional buffer pool features.  With -b, times\n");
+	printf("alloc/free of bursts of buffers (default 16) from 1 up to\n");
+	printf("threads (default 4) threads, with pool calls under a mutex\n");
+	printf("and, for cached pools, without one.\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int thread_cnt = 4, iters = 100000, burst = 16;
+	bool bench = false;
+	int c;
+
+	while ((c = getopt(argc, argv, "bt:i:n:h")) != -1) {
+		switch (c) {
+		case 'b':
+			bench = true;
+			break;
+		case 't':
+			thread_cnt = atoi(optarg);
+			break;
+		case 'i':
+			iters = atoi(optarg);
+			break;
+		case 'n':
+			burst = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return c == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (thread_cnt < 1 || iters < 1 || burst < 1 || burst > TEST_BURST) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	ofi_mem_init();
+	if (bench) {
+		run_bench(thread_cnt, iters, burst);
+		c = EXIT_SUCCESS;
+	} else {
+		c = run_checks();
+	}
+	ofi_mem_fini();
+	return c;
+}
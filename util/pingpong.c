@@ -84,6 +84,11 @@ enum {
 	PP_OPT_VERIFY_DATA = 1 << 3,
 };
 
+enum {
+	PP_LONG_OPT_LAT_STATS = 256,
+	PP_LONG_OPT_LAT_HIST,
+};
+
 struct pp_opts {
 	uint16_t src_port;
 	uint16_t dst_port;
@@ -93,6 +98,8 @@ struct pp_opts {
 	int transfer_size;
 	int sizes_enabled;
 	int options;
+	int lat_stats;
+	char *lat_hist;
 };
 
 #define PP_SIZE_MAX_POWER_TWO 22
@@ -104,6 +111,7 @@ struct pp_opts {
 #define PP_CTRL_BUF_LEN 64
 #define PP_MR_KEY 0xC0DE
 #define PP_MAX_ADDRLEN 1024
+#define PP_LAT_HIST_BITS 5
 
 #define INTEG_SEED 7
 #define PP_ENABLE_ALL (~0)
@@ -191,6 +199,10 @@ struct ct_pingpong {
 	int timeout_sec;
 	uint64_t start, end;
 
+	uint64_t *lat_samples, lat_last;
+	FILE *lat_hist_file;
+	int lat_hist_json;
+
 	struct fi_av_attr av_attr;
 	struct fi_eq_attr eq_attr;
 	struct fi_cq_attr cq_attr;
@@ -222,6 +234,14 @@ static uint64_t pp_gettime_us(void)
 	return now.tv_sec * 1000000 + now.tv_usec;
 }
 
+static uint64_t pp_gettime_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
 static long parse_ulong(char *str, long max)
 {
 	long ret;
@@ -858,6 +878,18 @@ static inline void pp_stop(struct ct_pingpong *ct)
 	PP_DEBUG("Stopped test chrono\n");
 }
 
+static inline void pp_lat_sample(struct ct_pingpong *ct, int i)
+{
+	uint64_t now;
+
+	if (!ct->lat_samples)
+		return;
+
+	now = pp_gettime_ns();
+	ct->lat_samples[i] = now - ct->lat_last;
+	ct->lat_last = now;
+}
+
 static inline int pp_check_opts(struct ct_pingpong *ct, uint64_t flags)
 {
 	return (ct->opts.options & flags) == flags;
@@ -1106,6 +1138,118 @@ static void show_perf(char *name, int tsize, int sent, int acked,
 	       bytes / (1.0 * elapsed), usec_per_xfer, 1.0 / usec_per_xfer);
 }
 
+static int pp_lat_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of the sorted samples, in usec per transfer */
+static double pp_lat_pct(struct ct_pingpong *ct, int cnt, double pct)
+{
+	double pos = pct * cnt / 100.0;
+	int rank = (int) pos;
+
+	if (rank < pos)
+		rank++;
+	rank = MIN(MAX(rank, 1), cnt);
+	return ct->lat_samples[rank - 1] / 2000.0;
+}
+
+/* Upper bound of the log-linear histogram bucket holding ns */
+static uint64_t pp_lat_bucket(uint64_t ns)
+{
+	int shift = 0;
+
+	while ((ns >> shift) >= (1ULL << PP_LAT_HIST_BITS))
+		shift++;
+
+	return (((ns >> shift) + 1) << shift) - 1;
+}
+
+static int pp_lat_hist_write(struct ct_pingpong *ct, int cnt)
+{
+	static int first = 1;
+	FILE *f = ct->lat_hist_file;
+	uint64_t bucket;
+	size_t len;
+	int i, n, ret;
+
+	if (!f) {
+		f = ct->lat_hist_file = fopen(ct->opts.lat_hist, "w");
+		if (!f) {
+			ret = -errno;
+			PP_PRINTERR("fopen", ret);
+			return ret;
+		}
+
+		len = strlen(ct->opts.lat_hist);
+		ct->lat_hist_json = len > 5 &&
+			!strcmp(ct->opts.lat_hist + len - 5, ".json");
+		fprintf(f, ct->lat_hist_json ? "{" :
+			"bytes,usec,count,percentile\n");
+	}
+
+	if (ct->lat_hist_json) {
+		fprintf(f, "%s\n  \"%d\": {\"bytes\": %d, \"iters\": %d, "
+			"\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+			"\"p99\": %.3f, \"p99.9\": %.3f, \"max\": %.3f, "
+			"\"histogram\": [", first ? "" : ",",
+			ct->opts.transfer_size, ct->opts.transfer_size, cnt,
+			pp_lat_pct(ct, cnt, 0), pp_lat_pct(ct, cnt, 50),
+			pp_lat_pct(ct, cnt, 90), pp_lat_pct(ct, cnt, 99),
+			pp_lat_pct(ct, cnt, 99.9), pp_lat_pct(ct, cnt, 100));
+	}
+	first = 0;
+
+	for (i = 0; i < cnt; i += n) {
+		bucket = pp_lat_bucket(ct->lat_samples[i]);
+		for (n = 1; i + n < cnt && ct->lat_samples[i + n] <= bucket; n++)
+			;
+
+		if (ct->lat_hist_json)
+			fprintf(f, "%s\n    {\"usec\": %.3f, \"count\": %d, "
+				"\"percentile\": %.4f}", i ? "," : "",
+				bucket / 2000.0, n, 100.0 * (i + n) / cnt);
+		else
+			fprintf(f, "%d,%.3f,%d,%.4f\n", ct->opts.transfer_size,
+				bucket / 2000.0, n, 100.0 * (i + n) / cnt);
+	}
+
+	if (ct->lat_hist_json)
+		fprintf(f, "]}");
+	fflush(f);
+	return 0;
+}
+
+/* Report the per transfer latency distribution of the last run */
+static int pp_show_lat(struct ct_pingpong *ct)
+{
+	static int header = 1;
+	char str[PP_STR_LEN];
+	int cnt = ct->opts.iterations;
+
+	if (!ct->lat_samples || !cnt)
+		return 0;
+
+	qsort(ct->lat_samples, cnt, sizeof(*ct->lat_samples), pp_lat_cmp);
+
+	if (header) {
+		printf("%-8s%10s%10s%10s%10s%10s%10s\n", "bytes", "min(us)",
+		       "p50", "p90", "p99", "p99.9", "max");
+		header = 0;
+	}
+
+	printf("%-8s%10.2f%10.2f%10.2f%10.2f%10.2f%10.2f\n",
+	       size_str(str, ct->opts.transfer_size),
+	       pp_lat_pct(ct, cnt, 0), pp_lat_pct(ct, cnt, 50),
+	       pp_lat_pct(ct, cnt, 90), pp_lat_pct(ct, cnt, 99),
+	       pp_lat_pct(ct, cnt, 99.9), pp_lat_pct(ct, cnt, 100));
+
+	return ct->opts.lat_hist ? pp_lat_hist_write(ct, cnt) : 0;
+}
+
 /*******************************************************************************
  *                                      Data Messaging
  ******************************************************************************/
@@ -1888,6 +2032,15 @@ static void pp_free_res(struct ct_pingpong *ct)
 
 	free(ct->rem_name);
 	free(ct->local_name);
+	free(ct->lat_samples);
+	ct->lat_samples = NULL;
+
+	if (ct->lat_hist_file) {
+		if (ct->lat_hist_json)
+			fprintf(ct->lat_hist_file, "\n}\n");
+		fclose(ct->lat_hist_file);
+		ct->lat_hist_file = NULL;
+	}
 
 	if (ct->buf) {
 		ofi_freealign(ct->buf);
@@ -2020,6 +2173,12 @@ static void pp_pingpong_usage(struct ct_pingpong *ct, char *name, char *desc)
 	fprintf(stderr, " %-20s %s\n", "-m <transmit mode>",
 		"transmit mode type: msg|tagged (msg)");
 
+	fprintf(stderr, " %-20s %s\n", "--lat-stats",
+		"report min/p50/p90/p99/p99.9/max latency per size");
+	fprintf(stderr, " %-20s %s\n", "--lat-hist <file>",
+		"also write a latency histogram as CSV, or JSON if <file> "
+		"ends in .json");
+
 	fprintf(stderr, " %-20s %s\n", "-h", "display this help output");
 	fprintf(stderr, " %-20s %s\n", "-v", "enable debugging output");
 	fprintf(stderr, " %-20s %s\n", "-6", "use IPv6 address");
@@ -2119,6 +2278,14 @@ static void pp_parse_opts(struct ct_pingpong *ct, int op, char *optarg)
 		pp_ipv6 = 1;
 		break;
 
+	/* Latency histogram */
+	case PP_LONG_OPT_LAT_HIST:
+		ct->opts.lat_hist = optarg;
+		/* fall through */
+	case PP_LONG_OPT_LAT_STATS:
+		ct->opts.lat_stats = 1;
+		break;
+
 	default:
 		/* let getopt handle unknown opts*/
 		break;
@@ -2137,7 +2304,15 @@ static int pingpong(struct ct_pingpong *ct)
 	if (ret)
 		return ret;
 
+	if (ct->opts.lat_stats && ct->opts.iterations && !ct->lat_samples) {
+		ct->lat_samples = calloc(ct->opts.iterations,
+					 sizeof(*ct->lat_samples));
+		if (!ct->lat_samples)
+			return -FI_ENOMEM;
+	}
+
 	pp_start(ct);
+	ct->lat_last = pp_gettime_ns();
 	if (ct->opts.dst_addr) {
 		for (i = 0; i < ct->opts.iterations; i++) {
 
@@ -2153,6 +2328,8 @@ static int pingpong(struct ct_pingpong *ct)
 			ret = pp_rx(ct, ct->ep, ct->opts.transfer_size);
 			if (ret)
 				return ret;
+
+			pp_lat_sample(ct, i);
 		}
 	} else {
 		for (i = 0; i < ct->opts.iterations; i++) {
@@ -2169,6 +2346,8 @@ static int pingpong(struct ct_pingpong *ct)
 				ret = pp_tx(ct, ct->ep, ct->opts.transfer_size);
 			if (ret)
 				return ret;
+
+			pp_lat_sample(ct, i);
 		}
 	}
 	pp_stop(ct);
@@ -2181,7 +2360,7 @@ static int pingpong(struct ct_pingpong *ct)
 	show_perf(NULL, ct->opts.transfer_size, ct->opts.iterations,
 		  ct->cnt_ack_msg, ct->start, ct->end, 2);
 
-	return 0;
+	return pp_show_lat(ct);
 }
 
 static int run_suite_pingpong(struct ct_pingpong *ct)
@@ -2312,6 +2491,11 @@ out:
 int main(int argc, char **argv)
 {
 	int op, ret = EXIT_SUCCESS;
+	struct option long_opts[] = {
+		{"lat-stats", no_argument, NULL, PP_LONG_OPT_LAT_STATS},
+		{"lat-hist", required_argument, NULL, PP_LONG_OPT_LAT_HIST},
+		{0, 0, 0, 0}
+	};
 	struct ct_pingpong ct = {
 		.timeout_sec = -1,
 		.ctrl_connfd = -1,
@@ -2333,7 +2517,8 @@ int main(int argc, char **argv)
 
 	ofi_osd_init();
 
-	while ((op = getopt(argc, argv, "hvd:p:f:e:I:S:s:B:P:cm:6")) != -1) {
+	while ((op = getopt_long(argc, argv, "hvd:p:f:e:I:S:s:B:P:cm:6",
+				 long_opts, NULL)) != -1) {
 		switch (op) {
 		default:
 			pp_parse_opts(&ct, op, optarg);
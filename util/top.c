@@ -0,0 +1,508 @@
+/*
+ * Copyright (c) 2026 Intel Corporation. All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <config.h>
+
+#include <unistd.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <signal.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <dirent.h>
+#include <prov/hook/monitor/include/hook_monitor.h>
+
+#define TOP_SNAPSHOT_RETRY	100
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int signal)
+{
+	running = 0;
+}
+
+struct top_opts {
+	char target_path[PATH_MAX];
+	unsigned long delay_msec;
+	long iterations;
+	pid_t pid;
+	bool batch;
+};
+
+struct top_file {
+	char path[PATH_MAX];
+	pid_t pid;
+	struct monitor_prof_mapped_data *share;
+	struct monitor_prof_mapped_data cur;
+	struct monitor_prof_mapped_data prev;
+	bool have_cur;
+	bool have_prev;
+	bool seen;
+	struct top_file *next;
+};
+
+struct top_ctx {
+	struct top_opts opts;
+	struct top_file *files;
+};
+
+/*******************************************************************************
+ *                         Shared table access
+ ******************************************************************************/
+
+/* Copy a consistent version of the profile table, see hook_monitor.h */
+static int top_snapshot(struct top_file *file,
+			struct monitor_prof_mapped_data *snap)
+{
+	uint32_t seq;
+	int i;
+
+	for (i = 0; i < TOP_SNAPSHOT_RETRY; i++) {
+		seq = file->share->seq;
+		if (seq & 1)
+			continue;
+		memcpy(snap, file->share, sizeof(*snap));
+		if (file->share->seq == seq)
+			return 0;
+	}
+	return -EAGAIN;
+}
+
+static void top_update_file(struct top_file *file)
+{
+	struct monitor_prof_mapped_data snap;
+
+	if (top_snapshot(file, &snap))
+		return;
+
+	if (!file->have_cur) {
+		file->cur = snap;
+		file->have_cur = true;
+	} else if (snap.timestamp_ms != file->cur.timestamp_ms) {
+		file->prev = file->cur;
+		file->cur = snap;
+		file->have_prev = true;
+	}
+}
+
+/*******************************************************************************
+ *                         File Management Functions
+ ******************************************************************************/
+
+static int top_map_file(struct top_file *file)
+{
+	struct stat st;
+	int fd;
+
+	fd = open(file->path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	if (fstat(fd, &st) || st.st_size < sizeof(*file->share)) {
+		close(fd);
+		return -EINVAL;
+	}
+
+	file->share = mmap(0, sizeof(*file->share), PROT_READ, MAP_SHARED,
+			   fd, 0);
+	close(fd);
+	if (file->share == MAP_FAILED) {
+		file->share = NULL;
+		return -EINVAL;
+	}
+
+	if (file->share->version != MON_PROF_VERSION) {
+		fprintf(stderr, "Skipping %s, unsupported version %u\n",
+			file->path, file->share->version);
+		munmap(file->share, sizeof(*file->share));
+		file->share = NULL;
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static void top_free_file(struct top_file *file)
+{
+	if (file->share)
+		munmap(file->share, sizeof(*file->share));
+	free(file);
+}
+
+static struct top_file *top_find_file(struct top_ctx *ct, const char *path)
+{
+	struct top_file *file;
+
+	for (file = ct->files; file; file = file->next) {
+		if (!strncmp(file->path, path, PATH_MAX))
+			return file;
+	}
+	return NULL;
+}
+
+/* name format: <ppid>_<pid>_<sequential id>_<job id>_<provider name> */
+static pid_t top_file_pid(const char *name)
+{
+	unsigned int ppid, pid;
+
+	if (sscanf(name, "%u_%u_", &ppid, &pid) != 2)
+		return 0;
+	return (pid_t) pid;
+}
+
+static int top_scan(struct top_ctx *ct)
+{
+	struct top_file *file, **prev;
+	struct dirent *dir_entry;
+	char path[PATH_MAX];
+	DIR *dr;
+
+	dr = opendir(ct->opts.target_path);
+	if (!dr) {
+		fprintf(stderr, "Could not open directory %s: %s\n",
+			ct->opts.target_path, strerror(errno));
+		return -errno;
+	}
+
+	for (file = ct->files; file; file = file->next)
+		file->seen = false;
+
+	while ((dir_entry = readdir(dr)) != NULL) {
+		if (dir_entry->d_type != DT_REG)
+			continue;
+		if (snprintf(path, PATH_MAX, "%s/%s", ct->opts.target_path,
+			     dir_entry->d_name) >= PATH_MAX)
+			continue;
+
+		file = top_find_file(ct, path);
+		if (file) {
+			file->seen = true;
+			continue;
+		}
+
+		file = calloc(1, sizeof(*file));
+		if (!file) {
+			closedir(dr);
+			return -ENOMEM;
+		}
+		snprintf(file->path, PATH_MAX, "%s", path);
+		file->pid = top_file_pid(dir_entry->d_name);
+		if ((ct->opts.pid && file->pid != ct->opts.pid) ||
+		    top_map_file(file)) {
+			/* keep it in the list so it is not retried */
+			file->share = NULL;
+		}
+		file->seen = true;
+		file->next = ct->files;
+		ct->files = file;
+	}
+	closedir(dr);
+
+	/* drop files which have been removed */
+	prev = &ct->files;
+	while ((file = *prev) != NULL) {
+		if (file->seen) {
+			prev = &file->next;
+			continue;
+		}
+		*prev = file->next;
+		top_free_file(file);
+	}
+	return 0;
+}
+
+static void top_cleanup(struct top_ctx *ct)
+{
+	struct top_file *file;
+
+	while ((file = ct->files) != NULL) {
+		ct->files = file->next;
+		top_free_file(file);
+	}
+}
+
+/*******************************************************************************
+ *                         Output Functions
+ ******************************************************************************/
+
+static const struct monitor_prof_ep *
+top_prev_ep(struct top_file *file, int idx)
+{
+	const struct monitor_prof_ep *cur = &file->cur.ep[idx];
+	const struct monitor_prof_ep *prev = &file->prev.ep[idx];
+
+	if (!file->have_prev || !prev->in_use || prev->ep_id != cur->ep_id)
+		return NULL;
+	return prev;
+}
+
+static void top_print_entry(const char *label, const char *name,
+			    uint64_t value, const uint64_t *prev, double secs)
+{
+	if (prev && secs > 0)
+		printf("  %-14s %-30s %16" PRIu64 " %14.1f\n", label, name,
+		       value, ((double) value - (double) *prev) / secs);
+	else
+		printf("  %-14s %-30s %16" PRIu64 " %14s\n", label, name,
+		       value, "-");
+}
+
+static void top_print_file(struct top_ctx *ct, struct top_file *file,
+			   uint64_t now_ms)
+{
+	const struct monitor_prof_mapped_data *cur = &file->cur;
+	const struct monitor_prof_ep *ep, *prev;
+	char label[32];
+	double secs = 0;
+	uint32_t i;
+	int idx;
+
+	if (file->have_prev)
+		secs = (cur->timestamp_ms - file->prev.timestamp_ms) / 1000.0;
+
+	printf("pid %d  prov %s  %s", file->pid, cur->prov_name,
+	       cur->fin ? "(exited)" : "");
+	if (!cur->fin && cur->timestamp_ms)
+		printf("(sampled %" PRIu64 " ms ago)",
+		       now_ms > cur->timestamp_ms ? now_ms - cur->timestamp_ms : 0);
+	printf("\n");
+
+	for (idx = 0; idx < MON_PROF_EP_MAX; idx++) {
+		ep = &cur->ep[idx];
+		if (!ep->in_use)
+			continue;
+
+		prev = top_prev_ep(file, idx);
+		snprintf(label, sizeof(label), "dom %u ep %u", ep->domain_id,
+			 ep->ep_id);
+		for (i = 0; i < ep->var_count && i < MON_PROF_VAR_MAX; i++)
+			top_print_entry(label, ep->vars[i].name,
+					ep->vars[i].value,
+					prev ? &prev->vars[i].value : NULL,
+					secs);
+		for (i = 0; i < ep->event_count && i < MON_PROF_EVENT_MAX; i++)
+			top_print_entry(label, ep->events[i].name,
+					ep->events[i].value,
+					prev ? &prev->events[i].value : NULL,
+					secs);
+	}
+	printf("\n");
+}
+
+static void top_print(struct top_ctx *ct)
+{
+	struct top_file *file;
+	struct timespec ts;
+	uint64_t now_ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now_ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+	if (!ct->opts.batch)
+		printf("\033[H\033[2J");
+
+	printf("fi_top - %s\n\n", ct->opts.target_path);
+	printf("  %-14s %-30s %16s %14s\n", "ENDPOINT", "NAME", "VALUE",
+	       "DELTA/s");
+	for (file = ct->files; file; file = file->next) {
+		if (!file->share || !file->have_cur)
+			continue;
+		if (!file->cur.fin && file->pid && kill(file->pid, 0) &&
+		    errno == ESRCH)
+			continue;
+		top_print_file(ct, file, now_ms);
+	}
+	fflush(stdout);
+}
+
+/*******************************************************************************
+ *                         Main Run Loop
+ ******************************************************************************/
+
+static int top_run(struct top_ctx *ct)
+{
+	struct top_file *file;
+	int ret;
+
+	ret = top_scan(ct);
+	if (ret)
+		return ret;
+
+	for (file = ct->files; file; file = file->next) {
+		if (file->share)
+			top_update_file(file);
+	}
+	top_print(ct);
+	return 0;
+}
+
+/*******************************************************************************
+ *                         CLI: Usage and Options parsing
+ ******************************************************************************/
+
+static void top_usage(char *name)
+{
+	fprintf(stderr, "Live view of provider profile data exported by the "
+			"ofi_hook_monitor provider\n\n");
+
+	fprintf(stderr, "Usage:\n");
+	fprintf(stderr, "  %s [OPTIONS] [<dir>]\t"
+			"show profile data of all processes exporting to <dir>\n",
+		name);
+	fprintf(stderr, "\t\t\t\t(default: %s/<uid>/<hostname>/%s)\n",
+		MON_BASEPATH_DEFAULT, MON_PROF_DIR);
+
+	fprintf(stderr, "\nOptions:\n");
+	fprintf(stderr, " %-20s %s\n", "-d <msec>",
+		"delay between updates in milliseconds (default: 1000)");
+	fprintf(stderr, " %-20s %s\n", "-n <count>",
+		"exit after <count> updates");
+	fprintf(stderr, " %-20s %s\n", "-p <pid>",
+		"only show process <pid>");
+	fprintf(stderr, " %-20s %s\n", "-b",
+		"batch mode, do not clear the screen between updates");
+}
+
+static int top_parse_ulong(const char *arg, unsigned long *out)
+{
+	char *endptr;
+
+	errno = 0;
+	*out = strtoul(arg, &endptr, 0);
+	if (errno == ERANGE || *endptr != '\0' || arg == endptr)
+		return -EINVAL;
+	return 0;
+}
+
+static int top_parse_opts(struct top_ctx *ct, int op, char *current_optarg)
+{
+	unsigned long out;
+
+	switch (op) {
+	case 'd':
+		if (top_parse_ulong(current_optarg, &out)) {
+			fprintf(stderr, "Invalid delay '%s'\n", current_optarg);
+			return -EINVAL;
+		}
+		ct->opts.delay_msec = out;
+		break;
+	case 'n':
+		if (top_parse_ulong(current_optarg, &out) || !out) {
+			fprintf(stderr, "Invalid count '%s'\n", current_optarg);
+			return -EINVAL;
+		}
+		ct->opts.iterations = (long) out;
+		break;
+	case 'p':
+		if (top_parse_ulong(current_optarg, &out)) {
+			fprintf(stderr, "Invalid pid '%s'\n", current_optarg);
+			return -EINVAL;
+		}
+		ct->opts.pid = (pid_t) out;
+		break;
+	case 'b':
+		ct->opts.batch = true;
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
+static int top_default_path(struct top_ctx *ct)
+{
+	char hostname[PATH_MAX];
+
+	if (gethostname(hostname, sizeof(hostname)) != 0) {
+		fprintf(stderr, "Failed to call gethostname (%s)!\n",
+			strerror(errno));
+		return -errno;
+	}
+	if (snprintf(ct->opts.target_path, PATH_MAX, "%s/%u/%s/%s",
+		     MON_BASEPATH_DEFAULT, getuid(), hostname,
+		     MON_PROF_DIR) >= PATH_MAX)
+		return -EOVERFLOW;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+	struct top_ctx ct = {};
+
+	ct.opts.delay_msec = 1000;
+	ct.opts.iterations = -1;
+
+	while ((op = getopt(argc, argv, "hd:n:p:b")) != -1) {
+		switch (op) {
+		default:
+			ret = top_parse_opts(&ct, op, optarg);
+			if (ret != 0) {
+				top_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case '?':
+		case 'h':
+			top_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc) {
+		snprintf(ct.opts.target_path, PATH_MAX, "%s", argv[optind]);
+	} else if (top_default_path(&ct)) {
+		fprintf(stderr, "Could not format default path\n");
+		return EXIT_FAILURE;
+	}
+
+	if (!ct.opts.batch && !isatty(STDOUT_FILENO))
+		ct.opts.batch = true;
+
+	signal(SIGINT, signal_handler);
+
+	do {
+		ret = top_run(&ct);
+		if (ret || !--ct.opts.iterations)
+			break;
+		usleep(ct.opts.delay_msec * 1000);
+	} while (running);
+
+	top_cleanup(&ct);
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}